@@ -0,0 +1,73 @@
+#include "SponzaScene.h"
+
+#include "Engine/Application/Time.h"
+
+#include <cstring>
+
+/*
+	Bakes the irradiance probes of the Game scene without a window or the renderer, so it also runs on machines without a GPU.
+	Writes the same file App would, which App then loads as long as the scene & settings still match.
+
+	Baker							Bakes if the probe file is missing or stale, from the working directory
+	Baker <gameDirectory>			Same, with the resources in gameDirectory (Game/)
+	Baker --force					Bakes even if the probe file is up to date
+
+	Returns 0 if the probe file is up to date afterwards.
+*/
+
+using namespace Okay;
+
+int main(int argc, char** argv)
+{
+	bool force = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--force") == 0)
+		{
+			force = true;
+		}
+		else
+		{
+			std::error_code error;
+			std::filesystem::current_path(argv[i], error);
+
+			if (error)
+			{
+				printf("Can't open %s\n", argv[i]);
+				return 1;
+			}
+		}
+	}
+
+	Scene scene;
+	ResourceManager resourceManager;
+	createSponzaScene(scene, resourceManager);
+
+	BakeScene bakeScene;
+	createBakeScene(scene, resourceManager, bakeScene);
+
+	IrradianceBakeSettings settings = getSponzaBakeSettings();
+	uint64_t sourceKey = getBakeSourceKey(bakeScene, settings);
+
+	IrradianceVolume volume;
+	if (!force && readIrradianceVolume(SPONZA_PROBES_PATH, sourceKey, volume))
+	{
+		printf("%s is up to date\n", SPONZA_PROBES_PATH.string().c_str());
+		return 0;
+	}
+
+	printf("Baking %u triangles & %u lights to %s\n", (uint32_t)bakeScene.trianglePositions.size() / 3, (uint32_t)bakeScene.lights.size(), SPONZA_PROBES_PATH.string().c_str());
+
+	Timer bakeTimer;
+	bakeIrradianceVolume(bakeScene, settings, volume);
+	printf("Baked %u probes in %.1fs\n", (uint32_t)volume.probes.size(), bakeTimer.measure());
+
+	if (!writeIrradianceVolume(SPONZA_PROBES_PATH, volume))
+	{
+		printf("Failed to write %s\n", SPONZA_PROBES_PATH.string().c_str());
+		return 1;
+	}
+
+	return 0;
+}
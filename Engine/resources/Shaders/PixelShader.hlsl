@@ -1,11 +1,15 @@
 
 #include "Utilities/ShadowSampleOffsets.hlsli"
+#include "Utilities/VirtualTexturing.hlsli"
 
 #define UINT_MAX (~0u)
 #define INVALID_UINT32 UINT_MAX
 
 #define MAX_SHADOW_MAPS 32
 #define MAX_POINT_SHADOW_CUBES 8
+#define MAX_SHADOW_CASCADES 4
+
+#define MAX_GPU_VIRTUAL_TEXTURES 32
 
 #define NUM_SHADOW_SAMPLES 64
 #define NUM_EARLY_SHADOW_SAMPLES 4
@@ -17,7 +21,7 @@ struct InputData
     float3 worldPosition : WORLD_POS;
     float2 uv : UV;
     float3x3 tbnMatrix : TBN_MATRIX;
-    uint instanceID : SV_InstanceID;
+    nointerpolation uint objectIdx : OBJECT_IDX;
 };
 
 struct ObjectData
@@ -40,12 +44,16 @@ struct PointLight
 
 struct DirectionalLight
 {
-    float4x4 viewProjMatrix;
-    uint shadowMapIdx;
+    float4x4 cascadeViewProjMatrices[MAX_SHADOW_CASCADES];
+    uint cascadeShadowMapIndices[MAX_SHADOW_CASCADES];
+    float4 cascadeSplitFars;
+    uint numCascades;
 
     float3 direction;
     float3 colour;
     float intensity;
+
+    float4 cascadeUVScales;
 };
 
 struct SpotLight
@@ -60,6 +68,13 @@ struct SpotLight
     float intensity;
     float2 attenuation;
     float cosineSpreadAngle;
+
+    float shadowMapUVScale;
+};
+
+struct IrradianceProbe
+{
+    float3 ambientCube[6]; // +X, -X, +Y, -Y, +Z, -Z
 };
 
 
@@ -73,6 +88,12 @@ cbuffer RenderDataCBuffer : register(b0, space0)
     uint numDirectionalLights;
     uint numSpotLights;
     float farPlane;
+    
+    float3 probeGridMin;
+    float probeSpacing;
+    uint3 probeGridSize;
+    uint virtualFeedbackWidth; // Entries per row
+    uint2 virtualFeedbackOffset; // Pixel of every block that writes its feedback this frame
 }
 
 
@@ -81,18 +102,26 @@ StructuredBuffer<ObjectData> objectDatas : register(t1, space0);
 StructuredBuffer<PointLight> pointLights : register(t3, space0);
 StructuredBuffer<DirectionalLight> directionalLights : register(t4, space0);
 StructuredBuffer<SpotLight> spotLights: register(t5, space0);
+StructuredBuffer<IrradianceProbe> irradianceProbes : register(t8, space0);
+StructuredBuffer<float> textureMinLODs : register(t10, space0); // Most detailed resident mip per texture, see TextureStreaming.h. Only read with TEXTURE_STREAMING (tiled resources tier 2)
+StructuredBuffer<VirtualTextureData> virtualTextures : register(t13, space0); // Per texture
+
+RWStructuredBuffer<uint> virtualFeedback : register(u0, space0); // Page wanted per block of pixels, INVALID_UINT32 if none
 
 
 // Textures
 Texture2D<unorm float4> textures[256] : register(t2, space1);
 Texture2D<unorm float> shadowMaps[MAX_SHADOW_MAPS] : register(t6, space2);
 TextureCube<unorm float> shadowMapCubes[MAX_POINT_SHADOW_CUBES] : register(t7, space3);
+Texture2D<unorm float4> virtualPageCache : register(t11, space4);
+Texture2D<uint> indirectionTextures[MAX_GPU_VIRTUAL_TEXTURES] : register(t12, space5);
 
 
 // Samplers
 SamplerState pointSampler : register(s0, space0);
 SamplerState anisotropicSampler : register(s1, space0);
 SamplerState linearSampler : register(s2, space0);
+SamplerState bilinearSampler : register(s3, space0);
 
 
 // --- Functions
@@ -107,18 +136,53 @@ float randomFloat(float3 seed, uint i)
 float3 sampleNormalMap(uint normalMapIdx, float2 uv, float3x3 tbnMatrix)
 {
     // should use point sampler..?
-    float3 normal = textures[normalMapIdx].Sample(pointSampler, uv).rgb;
-    normal = normal * 2.f - float3(1.f, 1.f, 1.f);
+    // BC5, only X & Y are stored
+#ifdef TEXTURE_STREAMING
+    float2 normalXY = textures[normalMapIdx].Sample(pointSampler, uv, int2(0, 0), textureMinLODs[normalMapIdx]).rg * 2.f - float2(1.f, 1.f);
+#else
+    float2 normalXY = textures[normalMapIdx].Sample(pointSampler, uv).rg * 2.f - float2(1.f, 1.f);
+#endif
+    float3 normal = float3(normalXY, sqrt(saturate(1.f - dot(normalXY, normalXY))));
 
     normal.y *= -1.f; // Flipping is correct for sponza, but isn't for many other normal maps
 
     return normalize(mul(normal, tbnMatrix));
 }
 
-float sampleShadowMap(Texture2D<unorm float> shadowMap, uint offsetIdx, float2 shadowMapTexelSize, float4 worldLightNDC, float3 worldNormal, float3 worldToLight)
+// Samples the closest resident page, the derivatives are of the unwrapped uv
+float3 sampleVirtualTexture(VirtualTextureData virtualTexture, float2 uv, float2 uvDdx, float2 uvDdy, uint2 pixelPos)
 {
+    float2 wrappedUV = frac(uv);
+    uint mip = min((uint)getVirtualMip(uvDdx, uvDdy, virtualTexture.size), virtualTexture.numMips - 1);
+
+    if (all(pixelPos % VIRTUAL_FEEDBACK_SCALE == virtualFeedbackOffset))
+    {
+        uint2 feedbackPos = pixelPos / VIRTUAL_FEEDBACK_SCALE;
+        virtualFeedback[feedbackPos.y * virtualFeedbackWidth + feedbackPos.x] = packVirtualPage(virtualTexture.virtualIdx, mip, getVirtualPage(wrappedUV, virtualTexture.size, mip));
+    }
+
+    uint entry = indirectionTextures[virtualTexture.virtualIdx].Load(int3(getVirtualPage(wrappedUV, virtualTexture.size, mip), mip));
+    uint2 slot = uint2(entry & 0xFFF, (entry >> 12) & 0xFFF);
+    uint residentMip = entry >> 24;
+
+    // Position inside the page of the resident mip, the border covers the bilinear footprint at the page edges
+    float2 mipTexel = wrappedUV * getVirtualMipSize(virtualTexture.size, residentMip);
+    float2 pageTexel = mipTexel - float2(getVirtualPage(wrappedUV, virtualTexture.size, residentMip) * VIRTUAL_PAGE_SIZE);
+
+    float2 cacheSize;
+    virtualPageCache.GetDimensions(cacheSize.x, cacheSize.y);
+
+    float2 cacheUV = (float2(slot * VIRTUAL_PAGE_STRIDE + VIRTUAL_PAGE_BORDER) + pageTexel) / cacheSize;
+    return virtualPageCache.SampleLevel(bilinearSampler, cacheUV, 0.f).rgb;
+}
+
+float sampleShadowMap(Texture2D<unorm float> shadowMap, uint offsetIdx, float2 shadowMapTexelSize, float2 maxUV, float4 worldLightNDC, float3 worldNormal, float3 worldToLight)
+{
+    // Stay inside the rendered region, the rest of the texture can contain anything
     float2 uvOffset = SHADOW_OFFSETS[offsetIdx].xy * shadowMapTexelSize;
-    float shadowMapDepth = shadowMap.SampleLevel(linearSampler, worldLightNDC.xy + uvOffset, 0.f).r;
+    float2 uv = clamp(worldLightNDC.xy + uvOffset, shadowMapTexelSize * 0.5f, maxUV);
+
+    float shadowMapDepth = shadowMap.SampleLevel(linearSampler, uv, 0.f).r;
             
     float bias = 0.000001f * tan(acos(max(dot(worldNormal, worldToLight), 0.f)));
     bias = clamp(bias, 0, 0.00001f);
@@ -126,18 +190,18 @@ float sampleShadowMap(Texture2D<unorm float> shadowMap, uint offsetIdx, float2 s
     return shadowMapDepth > worldLightNDC.z - bias ? 1.f : 0.f;
 }
 
-float getShadowValue(uint shadowMapIdx, float4x4 lightViewProjMatrix, float3 worldNormal, float3 worldToLight, float3 worldPosition)
+float getShadowValue(uint shadowMapIdx, float4x4 lightViewProjMatrix, float uvScale, float3 worldNormal, float3 worldToLight, float3 worldPosition)
 {
-    if (shadowMapIdx == INVALID_UINT32)
+    if (shadowMapIdx == INVALID_UINT32) // No shadow map assigned, the light isn't blocked
     {
-        return 0.f;
+        return 1.f;
     }
 
 
     float4 worldLightNDC = mul(float4(worldPosition, 1.f), lightViewProjMatrix);
 
     worldLightNDC.xyz /= worldLightNDC.w;
-    worldLightNDC.xy = float2(worldLightNDC.x * 0.5f + 0.5f, worldLightNDC.y * -0.5f + 0.5f);
+    worldLightNDC.xy = float2(worldLightNDC.x * 0.5f + 0.5f, worldLightNDC.y * -0.5f + 0.5f) * uvScale;
     
     Texture2D<unorm float> shadowMap = shadowMaps[shadowMapIdx];
     
@@ -145,13 +209,15 @@ float getShadowValue(uint shadowMapIdx, float4x4 lightViewProjMatrix, float3 wor
     float numberOfLevels; //?
     shadowMap.GetDimensions(0, shadowMapTexelSize.x, shadowMapTexelSize.y, numberOfLevels);
     shadowMapTexelSize = 1.f / shadowMapTexelSize;
+
+    float2 maxUV = uvScale - shadowMapTexelSize * 0.5f;
     
     float shadowValue = 0;
     uint i = 0;
 
     for (i = 0; i < NUM_EARLY_SHADOW_SAMPLES; i++)
     {
-        shadowValue += sampleShadowMap(shadowMap, i, shadowMapTexelSize, worldLightNDC, worldNormal, worldToLight);
+        shadowValue += sampleShadowMap(shadowMap, i, shadowMapTexelSize, maxUV, worldLightNDC, worldNormal, worldToLight);
     }
 
     // If all early samples are either 1 or 0, early out
@@ -163,17 +229,31 @@ float getShadowValue(uint shadowMapIdx, float4x4 lightViewProjMatrix, float3 wor
 
     for (i = NUM_EARLY_SHADOW_SAMPLES; i < NUM_SHADOW_SAMPLES; i++)
     {
-        shadowValue += sampleShadowMap(shadowMap, i, shadowMapTexelSize, worldLightNDC, worldNormal, worldToLight);
+        shadowValue += sampleShadowMap(shadowMap, i, shadowMapTexelSize, maxUV, worldLightNDC, worldNormal, worldToLight);
     }
 
     return shadowValue * (1.f / NUM_SHADOW_SAMPLES);
 }
 
+float getShadowValueCascaded(DirectionalLight dirLight, float viewDepth, float3 worldNormal, float3 worldPosition)
+{
+    // First cascade that reaches far enough, beyond the last one nothing is shadowed
+    for (uint i = 0; i < dirLight.numCascades; i++)
+    {
+        if (viewDepth < dirLight.cascadeSplitFars[i])
+        {
+            return getShadowValue(dirLight.cascadeShadowMapIndices[i], dirLight.cascadeViewProjMatrices[i], dirLight.cascadeUVScales[i], worldNormal, dirLight.direction, worldPosition);
+        }
+    }
+
+    return 1.f;
+}
+
 float getShadowValueCube(uint shadowMapIdx, float3 lightVec, float distToLight, float farPlane)
 {
-    if (shadowMapIdx == INVALID_UINT32)
+    if (shadowMapIdx == INVALID_UINT32) // No shadow map assigned, the light isn't blocked
     {
-        return 0.f;
+        return 1.f;
     }
 
     float shadowMapDepth = shadowMapCubes[shadowMapIdx].SampleLevel(linearSampler, lightVec, 0.f).r;
@@ -182,22 +262,75 @@ float getShadowValueCube(uint shadowMapIdx, float3 lightVec, float distToLight,
     return shadowMapDepth > distToLight ? 1.f : 0.f;
 }
 
+float3 sampleAmbientCube(uint probeIdx, float3 normal)
+{
+    float3 normalSquared = normal * normal;
+    IrradianceProbe probe = irradianceProbes[probeIdx];
+
+    return normalSquared.x * probe.ambientCube[normal.x >= 0.f ? 0 : 1] +
+        normalSquared.y * probe.ambientCube[normal.y >= 0.f ? 2 : 3] +
+        normalSquared.z * probe.ambientCube[normal.z >= 0.f ? 4 : 5];
+}
+
+// Trilinear blend of the 8 closest baked probes, positions outside the grid use the edge probes
+float3 getAmbientLight(float3 worldPosition, float3 worldNormal)
+{
+    float3 gridPos = clamp((worldPosition - probeGridMin) / probeSpacing, 0.f, float3(probeGridSize - 1));
+    uint3 baseCoord = min(uint3(gridPos), max(probeGridSize, 2) - 2);
+    float3 weights = saturate(gridPos - float3(baseCoord));
+
+    float3 ambientLight = float3(0.f, 0.f, 0.f);
+    for (uint i = 0; i < 8; i++)
+    {
+        uint3 offset = uint3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+        uint3 probeCoord = min(baseCoord + offset, probeGridSize - 1);
+        
+        float3 axisWeights = offset ? weights : 1.f - weights;
+        uint probeIdx = probeCoord.x + probeGridSize.x * (probeCoord.y + probeGridSize.y * probeCoord.z);
+        
+        ambientLight += axisWeights.x * axisWeights.y * axisWeights.z * sampleAmbientCube(probeIdx, worldNormal);
+    }
+    
+    return ambientLight;
+}
+
+// The feedback writes would otherwise move the depth test after the shader
+[earlydepthstencil]
 float4 main(InputData input) : SV_TARGET
 {
-    uint normalMapTextureIdx = objectDatas[input.instanceID].normalMapIdx;
+    uint normalMapTextureIdx = objectDatas[input.objectIdx].normalMapIdx;
     float3 worldNormal = sampleNormalMap(normalMapTextureIdx, input.uv, input.tbnMatrix);
     float3 vertexNormal = normalize(input.tbnMatrix[2].xyz);
     
-    uint diffuseTextureIdx = objectDatas[input.instanceID].diffuseTextureIdx;
-    float3 materialDiffuse = textures[diffuseTextureIdx].Sample(anisotropicSampler, input.uv).rgb;
+    uint diffuseTextureIdx = objectDatas[input.objectIdx].diffuseTextureIdx;
+    VirtualTextureData virtualDiffuse = virtualTextures[diffuseTextureIdx];
+
+    // Taken outside the branch, both sides sample with them
+    float2 uvDdx = ddx(input.uv);
+    float2 uvDdy = ddy(input.uv);
+
+    float3 materialDiffuse;
+    if (virtualDiffuse.virtualIdx != INVALID_UINT32)
+    {
+        materialDiffuse = sampleVirtualTexture(virtualDiffuse, input.uv, uvDdx, uvDdy, uint2(input.svPosition.xy));
+    }
+    else
+    {
+#ifdef TEXTURE_STREAMING
+        materialDiffuse = textures[diffuseTextureIdx].SampleGrad(anisotropicSampler, input.uv, uvDdx, uvDdy, int2(0, 0), textureMinLODs[diffuseTextureIdx]).rgb;
+#else
+        materialDiffuse = textures[diffuseTextureIdx].SampleGrad(anisotropicSampler, input.uv, uvDdx, uvDdy).rgb;
+#endif
+    }
 
     
-    float3 ambientLight = float3(0.2f, 0.2, 0.2f);
+    float3 ambientLight = getAmbientLight(input.worldPosition, worldNormal);
     float3 diffuseLight = float3(0.f, 0.f, 0.f);
     float3 specularLight = float3(0.f, 0.f, 0.f);
     float specularExpontent = 50.f; // temp
     
     float3 worldToCamera = normalize(cameraPos - input.worldPosition);
+    float viewDepth = dot(input.worldPosition - cameraPos, cameraDir);
     
     uint i = 0;
     for (i = 0; i < numPointLights; i++)
@@ -229,7 +362,7 @@ float4 main(InputData input) : SV_TARGET
     {
         DirectionalLight dirLight = directionalLights[i];
         
-        float shadowValue = getShadowValue(dirLight.shadowMapIdx, dirLight.viewProjMatrix, worldNormal, dirLight.direction, input.worldPosition);
+        float shadowValue = getShadowValueCascaded(dirLight, viewDepth, worldNormal, input.worldPosition);
 
 
         float dotty = max(dot(dirLight.direction, worldNormal), 0.f);
@@ -259,7 +392,7 @@ float4 main(InputData input) : SV_TARGET
             continue; // Change to float value which we multiple by?
         }
 
-        float shadowValue = getShadowValue(spotLight.shadowMapIdx, spotLight.viewProjMatrix, worldNormal, worldToLight, input.worldPosition);
+        float shadowValue = getShadowValue(spotLight.shadowMapIdx, spotLight.viewProjMatrix, spotLight.shadowMapUVScale, worldNormal, worldToLight, input.worldPosition);
         
         
         float dotty = max(dot(worldToLight, worldNormal), 0.f);
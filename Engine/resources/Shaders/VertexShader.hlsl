@@ -1,21 +1,13 @@
+#include "Utilities/VertexDecoding.hlsli"
 
 // Structs
-struct InputVertex
-{
-	float3 position;
-	float3 normal;
-	float2 uv;
-	float3 tangent;
-	float3 biTangent;
-};
-
 struct OutputVertex
 {
 	float4 svPosition : SV_POSITION;
 	float3 worldPosition : WORLD_POS;
     float2 uv : UV;
     float3x3 tbnMatrix : TBN_MATRIX;
-    uint instanceID : SV_InstanceID;
+    nointerpolation uint objectIdx : OBJECT_IDX;
 };
 
 struct ObjectData
@@ -40,7 +32,7 @@ cbuffer RenderDataCBuffer : register(b0, space0)
 
 
 // Structured Buffers
-StructuredBuffer<InputVertex> verticies : register(t0, space0);
+StructuredBuffer<PackedVertex> verticies : register(t0, space0); // Every mesh, see DrawData::baseVertex
 StructuredBuffer<ObjectData> objectDatas : register(t1, space0);
 
 
@@ -50,20 +42,28 @@ OutputVertex main(uint vertexId : SV_VERTEXID, uint instanceID : SV_INSTANCEID)
 {
 	OutputVertex output;
 
-    InputVertex inputVertex = verticies[vertexId];
-    float4x4 worldMatrix = objectDatas[instanceID].objectMatrix;
+    DrawData drawData = drawDatas[drawIdx];
+    uint objectIdx = drawData.firstObject + instanceID;
+
+    PackedVertex inputVertex = verticies[drawData.baseVertex + vertexId];
+    float4x4 worldMatrix = objectDatas[objectIdx].objectMatrix;
 	
-    output.worldPosition = mul(float4(inputVertex.position, 1.f), worldMatrix).xyz;
+    float3 position = decodePosition(inputVertex.positionXY, inputVertex.positionZFlags, drawData);
+    float3 normal = decodeOctahedral(inputVertex.normal);
+    float3 tangent = decodeOctahedral(inputVertex.tangent);
+    float3 biTangent = cross(normal, tangent) * ((inputVertex.positionZFlags >> 16) & PACKED_VERTEX_FLAG_FLIP_BITANGENT ? -1.f : 1.f);
+    
+    output.worldPosition = mul(float4(position, 1.f), worldMatrix).xyz;
 	output.svPosition = mul(float4(output.worldPosition, 1.f), viewProjMatrix);
 	
-    output.uv = inputVertex.uv;
+    output.uv = decodeUV(inputVertex.uv);
 
-    float3 worldNormal = normalize(mul(float4(inputVertex.normal, 0.f), worldMatrix)).xyz;
-    float3 worldTangent = normalize(mul(float4(inputVertex.tangent, 0.f), worldMatrix)).xyz;
-    float3 worldBiTangent = normalize(mul(float4(inputVertex.biTangent, 0.f), worldMatrix)).xyz;
+    float3 worldNormal = normalize(mul(float4(normal, 0.f), worldMatrix)).xyz;
+    float3 worldTangent = normalize(mul(float4(tangent, 0.f), worldMatrix)).xyz;
+    float3 worldBiTangent = normalize(mul(float4(biTangent, 0.f), worldMatrix)).xyz;
     output.tbnMatrix = float3x3(worldTangent, worldBiTangent, worldNormal);
 	
-    output.instanceID = instanceID;
+    output.objectIdx = objectIdx;
 
 	return output;
 }
@@ -11,6 +11,7 @@ cbuffer matrices : register(b0, space0)
     float4x4 viewProjMatrices[6];
     float3 lightPos;
     float farPlane;
+    uint faceMask; // Faces rendered this frame, the rest keep their content
 }
 
 [maxvertexcount(18)]
@@ -18,6 +19,11 @@ void main(triangle float3 input[3] : WORLD_POS, inout TriangleStream<OutputVerte
 {
 	for (uint i = 0; i < 6; i++)
 	{
+        if (!(faceMask & (1u << i)))
+        {
+            continue;
+        }
+
         for (uint k = 0; k < 3; k++)
         {
             OutputVertex element;
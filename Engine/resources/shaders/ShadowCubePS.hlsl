@@ -11,6 +11,7 @@ cbuffer matrices : register(b0, space0)
     float4x4 viewProjMatrices[6];
     float3 lightPos;
     float farPlane;
+    uint faceMask; // Faces rendered this frame, the rest keep their content
 }
 
 float main(InputData input) : SV_Depth
@@ -1,14 +1,6 @@
+#include "Utilities/VertexDecoding.hlsli"
 
 // Structs
-struct InputVertex
-{
-    float3 position;
-    float3 normal;
-    float2 uv;
-    float3 tangent;
-    float3 biTangent;
-};
-
 struct ObjectData
 {
     float4x4 objectMatrix;
@@ -30,7 +22,7 @@ cbuffer RenderDataCBuffer : register(b0, space0)
 
 
 // Structured Buffers
-StructuredBuffer<InputVertex> verticies : register(t0, space0);
+StructuredBuffer<PackedPosition> positions : register(t0, space0); // Position only stream of every mesh, see DXMeshBuffers::positionsGVA
 StructuredBuffer<ObjectData> objectDatas : register(t1, space0);
 
 
@@ -38,9 +30,11 @@ StructuredBuffer<ObjectData> objectDatas : register(t1, space0);
 
 float3 main(uint vertexId : SV_VERTEXID, uint instanceID : SV_INSTANCEID) : WORLD_POS
 {
-    InputVertex inputVertex = verticies[vertexId];
-    float4x4 worldMatrix = objectDatas[instanceID].objectMatrix;
+    DrawData drawData = drawDatas[drawIdx];
+    PackedPosition position = positions[drawData.baseVertex + vertexId];
+
+    float4x4 worldMatrix = objectDatas[drawData.firstObject + instanceID].objectMatrix;
 	
-    float3 worldPosition = mul(float4(inputVertex.position, 1.f), worldMatrix).xyz;
+    float3 worldPosition = mul(float4(decodePosition(position.x, position.y, drawData), 1.f), worldMatrix).xyz;
     return worldPosition;
 }
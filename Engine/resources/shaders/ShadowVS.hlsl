@@ -1,14 +1,6 @@
+#include "Utilities/VertexDecoding.hlsli"
 
 // Structs
-struct InputVertex
-{
-    float3 position;
-    float3 normal;
-    float2 uv;
-    float3 tangent;
-    float3 biTangent;
-};
-
 struct OutputVertex
 {
     float4 svPosition : SV_POSITION;
@@ -31,7 +23,7 @@ cbuffer RenderDataCBuffer : register(b0, space0)
 
 
 // Structured Buffers
-StructuredBuffer<InputVertex> verticies : register(t0, space0);
+StructuredBuffer<PackedPosition> positions : register(t0, space0); // Position only stream of every mesh, see DXMeshBuffers::positionsGVA
 StructuredBuffer<ObjectData> objectDatas : register(t1, space0);
 
 
@@ -41,10 +33,12 @@ OutputVertex main(uint vertexId : SV_VERTEXID, uint instanceID : SV_INSTANCEID)
 {
     OutputVertex output;
     
-    InputVertex inputVertex = verticies[vertexId];
-    float4x4 worldMatrix = objectDatas[instanceID].objectMatrix;
+    DrawData drawData = drawDatas[drawIdx];
+    PackedPosition position = positions[drawData.baseVertex + vertexId];
+
+    float4x4 worldMatrix = objectDatas[drawData.firstObject + instanceID].objectMatrix;
 	
-    output.worldPosition = mul(float4(inputVertex.position, 1.f), worldMatrix).xyz;
+    output.worldPosition = mul(float4(decodePosition(position.x, position.y, drawData), 1.f), worldMatrix).xyz;
     output.svPosition = mul(float4(output.worldPosition, 1.f), viewProjMatrix);
 
     return output;
@@ -0,0 +1,55 @@
+
+// Decoding of the packed vertex formats, see VertexQuantization.h
+
+#define PACKED_VERTEX_FLAG_FLIP_BITANGENT 1
+
+struct PackedVertex
+{
+    uint positionXY;
+    uint positionZFlags; // Flags in the upper 16 bits
+    uint normal;
+    uint tangent;
+    uint uv;
+};
+
+// Position only stream of the depth passes, 3x unorm16 + padding
+typedef uint2 PackedPosition;
+
+// Per draw data (IndirectDrawData), every mesh is in the same vertex buffer
+struct DrawData
+{
+    float3 positionMin; // VertexQuantization
+    float3 positionScale;
+    uint baseVertex; // SV_VertexID doesn't include BaseVertexLocation
+    uint firstObject; // Same for SV_InstanceID & StartInstanceLocation
+};
+
+// Root constant, written by the indirect commands (IndirectDrawCommand)
+cbuffer DrawCBuffer : register(b1, space0)
+{
+    uint drawIdx;
+}
+
+StructuredBuffer<DrawData> drawDatas : register(t9, space0);
+
+float3 decodePosition(uint positionXY, uint positionZ, DrawData drawData)
+{
+    float3 quantized = float3(positionXY & 0xFFFF, positionXY >> 16, positionZ & 0xFFFF);
+    return drawData.positionMin + quantized * drawData.positionScale;
+}
+
+float3 decodeOctahedral(uint encoded)
+{
+    float2 octahedral = max(float2(asint(uint2(encoded << 16, encoded)) >> 16) / 32767.f, -1.f);
+
+    float3 direction = float3(octahedral, 1.f - abs(octahedral.x) - abs(octahedral.y));
+    float fold = max(-direction.z, 0.f);
+    direction.xy += direction.xy >= 0.f ? -fold : fold;
+
+    return normalize(direction);
+}
+
+float2 decodeUV(uint uv)
+{
+    return float2(f16tof32(uv), f16tof32(uv >> 16));
+}
@@ -0,0 +1,46 @@
+
+// Virtual texture lookups, see VirtualTexturing.h
+
+#define VIRTUAL_PAGE_SIZE 128
+#define VIRTUAL_PAGE_BORDER 4
+#define VIRTUAL_PAGE_STRIDE (VIRTUAL_PAGE_SIZE + 2 * VIRTUAL_PAGE_BORDER)
+
+#define VIRTUAL_FEEDBACK_SCALE 8
+
+// Per texture (GPUVirtualTexture), virtualIdx is INVALID_UINT32 for textures that aren't virtual
+struct VirtualTextureData
+{
+    uint virtualIdx;
+    uint2 size;
+    uint numMips;
+};
+
+// Same as packVirtualPage
+uint packVirtualPage(uint textureIdx, uint mip, uint2 page)
+{
+    return textureIdx | (mip << 10) | (page.x << 14) | (page.y << 23);
+}
+
+// Least detailed mip the texel derivatives allow, before clamping to the mips of the texture
+float getVirtualMip(float2 uvDdx, float2 uvDdy, uint2 size)
+{
+    float2 texelDdx = uvDdx * float2(size);
+    float2 texelDdy = uvDdy * float2(size);
+
+    return 0.5f * log2(max(max(dot(texelDdx, texelDdx), dot(texelDdy, texelDdy)), 1.f));
+}
+
+// Size of the mip in texels, per side
+float2 getVirtualMipSize(uint2 size, uint mip)
+{
+    return float2(max(size >> mip, 1));
+}
+
+// Page the wrapped uv lands in
+uint2 getVirtualPage(float2 wrappedUV, uint2 size, uint mip)
+{
+    uint2 mipSize = max(size >> mip, 1);
+    uint2 numPages = (mipSize + VIRTUAL_PAGE_SIZE - 1) / VIRTUAL_PAGE_SIZE;
+
+    return min(uint2(wrappedUV * float2(mipSize) / VIRTUAL_PAGE_SIZE), numPages - 1);
+}
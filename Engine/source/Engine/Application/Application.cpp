@@ -1,6 +1,7 @@
 #include "Application.h"
 
 #include "ImguiHelper.h"
+#include "Engine/Scene/SceneLoader.h"
 
 namespace Okay
 {
@@ -13,6 +14,9 @@ namespace Okay
 
 		m_window.initiate(windowTitle, windowWidth, windowHeight);
 		m_renderer.initialize(m_window);
+
+		// Before the app loads anything, it can still pick another quality in its constructor
+		m_resourceManager.setTextureQuality(selectTextureQuality(m_renderer.getVideoMemorySize()));
 	}
 
 	Application::~Application()
@@ -43,21 +47,32 @@ namespace Okay
 		}
 	}
 
-	void Application::createEntitesFromFile(FilePath path, float scale)
+	void Application::createEntitesFromFile(FilePath path, float scale, const MeshMergeSettings* pMergeSettings)
+	{
+		createEntitiesFromFile(m_scene, m_resourceManager, path, scale, pMergeSettings);
+	}
+
+	void Application::loadOrBakeIrradianceVolume(FilePath probesPath, const IrradianceBakeSettings& settings)
 	{
-		std::vector<LoadedObject> objects;
-		m_resourceManager.loadObjects(path, objects, scale);
+		// Always collected, the probe file is only used if it was baked from the same scene & settings
+		BakeScene bakeScene;
+		createBakeScene(m_scene, m_resourceManager, bakeScene);
 
-		for (LoadedObject& objectData : objects)
+		IrradianceVolume volume;
+		if (!readIrradianceVolume(probesPath, getBakeSourceKey(bakeScene, settings), volume))
 		{
-			Entity entity = m_scene.createEntity();
-			
-			entity.getComponent<Transform>().setFromMatrix(objectData.transformMatrix);
-
-			MeshRenderer& meshRenderer = entity.addComponent<MeshRenderer>();
-			meshRenderer.meshID = objectData.meshID;
-			meshRenderer.diffuseTextureID = objectData.diffuseTextureID;
-			meshRenderer.normalMapID = objectData.normalMapID;
+			printf("Baking irradiance probes to %s\n", probesPath.string().c_str());
+
+			Timer bakeTimer;
+			bakeIrradianceVolume(bakeScene, settings, volume);
+			printf("Baked %u probes in %.1fs\n", (uint32_t)volume.probes.size(), bakeTimer.measure());
+
+			if (!writeIrradianceVolume(probesPath, volume))
+			{
+				printf("Failed to write %s\n", probesPath.string().c_str());
+			}
 		}
+
+		m_renderer.setIrradianceVolume(volume);
 	}
 }
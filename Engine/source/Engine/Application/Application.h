@@ -22,7 +22,11 @@ namespace Okay
 		// onStart, onEnd
 		virtual void onUpdate(TimeStep dt) = 0;
 
-		void createEntitesFromFile(FilePath path, float scale);
+		void createEntitesFromFile(FilePath path, float scale, const MeshMergeSettings* pMergeSettings = nullptr);
+
+		// Loads the probes from probesPath, bakes & writes them there if the file is missing or was baked from another scene or settings.
+		// Needs the CPU mesh data, so call before run(). Baker bakes them without the renderer
+		void loadOrBakeIrradianceVolume(FilePath probesPath, const IrradianceBakeSettings& settings);
 
 	protected:
 		Scene m_scene;
@@ -0,0 +1,333 @@
+#include "BVH.h"
+
+#include <algorithm>
+
+namespace Okay
+{
+	struct SAHBin
+	{
+		glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+		glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+		uint32_t numTriangles = 0;
+	};
+
+	static float getSurfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.f));
+		return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	static float intersectAABB(glm::vec3 origin, glm::vec3 invDirection, float maxDistance, glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		glm::vec3 t0 = (boundsMin - origin) * invDirection;
+		glm::vec3 t1 = (boundsMax - origin) * invDirection;
+
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+
+		float entry = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.f));
+		float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+
+		return entry <= exit ? entry : FLT_MAX;
+	}
+
+	void BVH::build(const std::vector<glm::vec3>& trianglePositions)
+	{
+		OKAY_ASSERT(trianglePositions.size() % 3 == 0);
+
+		uint32_t numTriangles = (uint32_t)trianglePositions.size() / 3;
+
+		m_nodes.clear();
+		m_triangles.resize(numTriangles);
+		m_triangleIndices.resize(numTriangles);
+
+		std::vector<glm::vec3> centroids(numTriangles);
+
+		for (uint32_t i = 0; i < numTriangles; i++)
+		{
+			glm::vec3 v0 = trianglePositions[i * 3ull];
+			glm::vec3 v1 = trianglePositions[i * 3ull + 1];
+			glm::vec3 v2 = trianglePositions[i * 3ull + 2];
+
+			Triangle& triangle = m_triangles[i];
+			triangle.v0 = v0;
+			triangle.edge1 = v1 - v0;
+			triangle.edge2 = v2 - v0;
+
+			glm::vec3 normal = glm::cross(triangle.edge1, triangle.edge2);
+			float normalLength = glm::length(normal);
+			triangle.normal = normalLength > 0.f ? normal / normalLength : glm::vec3(0.f, 1.f, 0.f);
+
+			centroids[i] = (v0 + v1 + v2) / 3.f;
+			m_triangleIndices[i] = i;
+		}
+
+		if (!numTriangles)
+		{
+			return;
+		}
+
+		m_nodes.reserve(numTriangles * 2ull);
+
+		Node& root = m_nodes.emplace_back();
+		root.firstChildOrTriangle = 0;
+		root.numTriangles = numTriangles;
+		updateNodeBounds(root);
+
+		subdivide(0, centroids);
+	}
+
+	bool BVH::intersect(glm::vec3 origin, glm::vec3 direction, float maxDistance, BVHHit* pOutHit) const
+	{
+		return traverse<false>(origin, direction, maxDistance, pOutHit);
+	}
+
+	bool BVH::occluded(glm::vec3 origin, glm::vec3 direction, float maxDistance) const
+	{
+		return traverse<true>(origin, direction, maxDistance, nullptr);
+	}
+
+	void BVH::subdivide(uint32_t nodeIdx, std::vector<glm::vec3>& centroids)
+	{
+		// Copied since m_nodes grows below
+		Node node = m_nodes[nodeIdx];
+
+		if (node.numTriangles <= MAX_LEAF_TRIANGLES)
+		{
+			return;
+		}
+
+		glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+		glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+		for (uint32_t i = 0; i < node.numTriangles; i++)
+		{
+			glm::vec3 centroid = centroids[m_triangleIndices[node.firstChildOrTriangle + i]];
+			centroidMin = glm::min(centroidMin, centroid);
+			centroidMax = glm::max(centroidMax, centroid);
+		}
+
+		float bestCost = FLT_MAX;
+		uint32_t bestAxis = INVALID_UINT32;
+		float bestSplit = 0.f;
+
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			float extent = centroidMax[axis] - centroidMin[axis];
+			if (extent <= 0.f)
+			{
+				continue;
+			}
+
+			SAHBin bins[NUM_SAH_BINS] = {};
+			float binScale = NUM_SAH_BINS / extent;
+
+			for (uint32_t i = 0; i < node.numTriangles; i++)
+			{
+				uint32_t triangleIdx = m_triangleIndices[node.firstChildOrTriangle + i];
+				const Triangle& triangle = m_triangles[triangleIdx];
+
+				uint32_t binIdx = glm::min((uint32_t)((centroids[triangleIdx][axis] - centroidMin[axis]) * binScale), NUM_SAH_BINS - 1);
+
+				SAHBin& bin = bins[binIdx];
+				bin.numTriangles++;
+				bin.boundsMin = glm::min(bin.boundsMin, glm::min(triangle.v0, glm::min(triangle.v0 + triangle.edge1, triangle.v0 + triangle.edge2)));
+				bin.boundsMax = glm::max(bin.boundsMax, glm::max(triangle.v0, glm::max(triangle.v0 + triangle.edge1, triangle.v0 + triangle.edge2)));
+			}
+
+			// Sweep from both sides to get the cost of splitting after every bin
+			float leftAreas[NUM_SAH_BINS - 1] = {};
+			uint32_t leftCounts[NUM_SAH_BINS - 1] = {};
+
+			SAHBin leftBin;
+			for (uint32_t i = 0; i < NUM_SAH_BINS - 1; i++)
+			{
+				leftBin.numTriangles += bins[i].numTriangles;
+				leftBin.boundsMin = glm::min(leftBin.boundsMin, bins[i].boundsMin);
+				leftBin.boundsMax = glm::max(leftBin.boundsMax, bins[i].boundsMax);
+
+				leftCounts[i] = leftBin.numTriangles;
+				leftAreas[i] = getSurfaceArea(leftBin.boundsMin, leftBin.boundsMax);
+			}
+
+			SAHBin rightBin;
+			for (uint32_t i = NUM_SAH_BINS - 1; i > 0; i--)
+			{
+				rightBin.numTriangles += bins[i].numTriangles;
+				rightBin.boundsMin = glm::min(rightBin.boundsMin, bins[i].boundsMin);
+				rightBin.boundsMax = glm::max(rightBin.boundsMax, bins[i].boundsMax);
+
+				if (!leftCounts[i - 1] || !rightBin.numTriangles)
+				{
+					continue;
+				}
+
+				float cost = leftCounts[i - 1] * leftAreas[i - 1] + rightBin.numTriangles * getSurfaceArea(rightBin.boundsMin, rightBin.boundsMax);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = centroidMin[axis] + i / binScale;
+				}
+			}
+		}
+
+		float leafCost = node.numTriangles * getSurfaceArea(node.boundsMin, node.boundsMax);
+		if (bestAxis == INVALID_UINT32 || bestCost >= leafCost)
+		{
+			return;
+		}
+
+		uint32_t* pFirst = m_triangleIndices.data() + node.firstChildOrTriangle;
+		uint32_t* pMiddle = std::partition(pFirst, pFirst + node.numTriangles, [&](uint32_t triangleIdx)
+		{
+			return centroids[triangleIdx][bestAxis] < bestSplit;
+		});
+
+		uint32_t numLeft = (uint32_t)(pMiddle - pFirst);
+		if (numLeft == 0 || numLeft == node.numTriangles)
+		{
+			return;
+		}
+
+		uint32_t leftIdx = (uint32_t)m_nodes.size();
+
+		Node& left = m_nodes.emplace_back();
+		left.firstChildOrTriangle = node.firstChildOrTriangle;
+		left.numTriangles = numLeft;
+		updateNodeBounds(left);
+
+		Node& right = m_nodes.emplace_back();
+		right.firstChildOrTriangle = node.firstChildOrTriangle + numLeft;
+		right.numTriangles = node.numTriangles - numLeft;
+		updateNodeBounds(right);
+
+		m_nodes[nodeIdx].firstChildOrTriangle = leftIdx;
+		m_nodes[nodeIdx].numTriangles = 0;
+
+		subdivide(leftIdx, centroids);
+		subdivide(leftIdx + 1, centroids);
+	}
+
+	void BVH::updateNodeBounds(Node& node) const
+	{
+		node.boundsMin = glm::vec3(FLT_MAX);
+		node.boundsMax = glm::vec3(-FLT_MAX);
+
+		for (uint32_t i = 0; i < node.numTriangles; i++)
+		{
+			const Triangle& triangle = m_triangles[m_triangleIndices[node.firstChildOrTriangle + i]];
+
+			node.boundsMin = glm::min(node.boundsMin, glm::min(triangle.v0, glm::min(triangle.v0 + triangle.edge1, triangle.v0 + triangle.edge2)));
+			node.boundsMax = glm::max(node.boundsMax, glm::max(triangle.v0, glm::max(triangle.v0 + triangle.edge1, triangle.v0 + triangle.edge2)));
+		}
+	}
+
+	template<bool AnyHit>
+	bool BVH::traverse(glm::vec3 origin, glm::vec3 direction, float maxDistance, BVHHit* pOutHit) const
+	{
+		if (m_nodes.empty())
+		{
+			return false;
+		}
+
+		// Divisions by zero give infinities, which the slab test handles
+		glm::vec3 invDirection = 1.f / direction;
+
+		BVHHit closestHit;
+		closestHit.distance = maxDistance;
+
+		uint32_t nodeStack[64] = {};
+		uint32_t stackSize = 0;
+		nodeStack[stackSize++] = 0;
+
+		while (stackSize)
+		{
+			const Node& node = m_nodes[nodeStack[--stackSize]];
+
+			if (intersectAABB(origin, invDirection, closestHit.distance, node.boundsMin, node.boundsMax) == FLT_MAX)
+			{
+				continue;
+			}
+
+			if (node.numTriangles)
+			{
+				for (uint32_t i = 0; i < node.numTriangles; i++)
+				{
+					uint32_t triangleIdx = m_triangleIndices[node.firstChildOrTriangle + i];
+					const Triangle& triangle = m_triangles[triangleIdx];
+
+					// Moller-Trumbore, both sides
+					glm::vec3 pVec = glm::cross(direction, triangle.edge2);
+					float determinant = glm::dot(triangle.edge1, pVec);
+					if (glm::abs(determinant) < 1e-12f)
+					{
+						continue;
+					}
+
+					float invDeterminant = 1.f / determinant;
+					glm::vec3 tVec = origin - triangle.v0;
+
+					float u = glm::dot(tVec, pVec) * invDeterminant;
+					if (u < 0.f || u > 1.f)
+					{
+						continue;
+					}
+
+					glm::vec3 qVec = glm::cross(tVec, triangle.edge1);
+					float v = glm::dot(direction, qVec) * invDeterminant;
+					if (v < 0.f || u + v > 1.f)
+					{
+						continue;
+					}
+
+					float distance = glm::dot(triangle.edge2, qVec) * invDeterminant;
+					if (distance < 0.f || distance >= closestHit.distance)
+					{
+						continue;
+					}
+
+					if constexpr (AnyHit)
+					{
+						return true;
+					}
+
+					closestHit.distance = distance;
+					closestHit.triangleIdx = triangleIdx;
+				}
+
+				continue;
+			}
+
+			// Visit the closer child first so the far one is more likely to be culled by closestHit
+			uint32_t nearIdx = node.firstChildOrTriangle;
+			uint32_t farIdx = node.firstChildOrTriangle + 1;
+
+			float nearDistance = intersectAABB(origin, invDirection, closestHit.distance, m_nodes[nearIdx].boundsMin, m_nodes[nearIdx].boundsMax);
+			float farDistance = intersectAABB(origin, invDirection, closestHit.distance, m_nodes[farIdx].boundsMin, m_nodes[farIdx].boundsMax);
+
+			if (nearDistance > farDistance)
+			{
+				std::swap(nearIdx, farIdx);
+				std::swap(nearDistance, farDistance);
+			}
+
+			OKAY_ASSERT(stackSize + 2 <= 64);
+
+			if (farDistance != FLT_MAX)
+			{
+				nodeStack[stackSize++] = farIdx;
+			}
+			if (nearDistance != FLT_MAX)
+			{
+				nodeStack[stackSize++] = nearIdx;
+			}
+		}
+
+		if (pOutHit && closestHit.triangleIdx != INVALID_UINT32)
+		{
+			*pOutHit = closestHit;
+		}
+
+		return closestHit.triangleIdx != INVALID_UINT32;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+#include <cfloat>
+
+/*
+	Bounding volume hierarchy over world space triangles, built with binned SAH.
+	Only used by the offline bakers, so it's plain C++ without any D3D12.
+*/
+
+namespace Okay
+{
+	struct BVHHit
+	{
+		float distance = FLT_MAX;
+		uint32_t triangleIdx = INVALID_UINT32;
+	};
+
+	class BVH
+	{
+	public:
+		static const uint32_t MAX_LEAF_TRIANGLES = 4;
+		static const uint32_t NUM_SAH_BINS = 12;
+
+	public:
+		BVH() = default;
+		~BVH() = default;
+
+		// 3 positions per triangle
+		void build(const std::vector<glm::vec3>& trianglePositions);
+
+		// Closest hit in [0, maxDistance], returns false on a miss
+		bool intersect(glm::vec3 origin, glm::vec3 direction, float maxDistance, BVHHit* pOutHit) const;
+
+		// Any hit in [0, maxDistance], for shadow rays
+		bool occluded(glm::vec3 origin, glm::vec3 direction, float maxDistance) const;
+
+		inline glm::vec3 getTriangleNormal(uint32_t triangleIdx) const { return m_triangles[triangleIdx].normal; }
+		inline uint32_t getNumTriangles() const { return (uint32_t)m_triangles.size(); }
+		inline uint32_t getNumNodes() const { return (uint32_t)m_nodes.size(); }
+
+	private:
+		struct Node
+		{
+			glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+			uint32_t firstChildOrTriangle = 0; // Left child for inner nodes (right child is +1), first triangle for leaves
+			glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+			uint32_t numTriangles = 0; // 0 for inner nodes
+		};
+
+		struct Triangle
+		{
+			glm::vec3 v0 = glm::vec3(0.f);
+			glm::vec3 edge1 = glm::vec3(0.f);
+			glm::vec3 edge2 = glm::vec3(0.f);
+			glm::vec3 normal = glm::vec3(0.f);
+		};
+
+		void subdivide(uint32_t nodeIdx, std::vector<glm::vec3>& centroids);
+		void updateNodeBounds(Node& node) const;
+
+		template<bool AnyHit>
+		bool traverse(glm::vec3 origin, glm::vec3 direction, float maxDistance, BVHHit* pOutHit) const;
+
+	private:
+		std::vector<Node> m_nodes;
+		std::vector<Triangle> m_triangles;
+		std::vector<uint32_t> m_triangleIndices;
+	};
+}
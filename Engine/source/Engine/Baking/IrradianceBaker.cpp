@@ -0,0 +1,565 @@
+#include "IrradianceBaker.h"
+#include "BVH.h"
+#include "Engine/Scene/Scene.h"
+#include "Engine/Resources/ResourceManager.h"
+#include "Engine/Misc/Hash.h"
+
+#include <atomic>
+#include <thread>
+#include <cstring>
+
+namespace Okay
+{
+	static const glm::vec3 AMBIENT_CUBE_AXES[6] =
+	{
+		glm::vec3(1.f, 0.f, 0.f),
+		glm::vec3(-1.f, 0.f, 0.f),
+		glm::vec3(0.f, 1.f, 0.f),
+		glm::vec3(0.f, -1.f, 0.f),
+		glm::vec3(0.f, 0.f, 1.f),
+		glm::vec3(0.f, 0.f, -1.f),
+	};
+
+	// Probes where more of the rays than this hit back faces are inside geometry, their value is taken from the neighbours
+	static const float MAX_BACKFACE_RATIO = 0.25f;
+
+	static const uint32_t PROBE_FILE_MAGIC = 0x56504B4F; // "OKPV"
+	static const uint32_t PROBE_FILE_VERSION = 2;
+
+	struct ProbeFileHeader
+	{
+		uint32_t magic = PROBE_FILE_MAGIC;
+		uint32_t version = PROBE_FILE_VERSION;
+		uint64_t sourceKey = 0;
+
+		glm::vec3 gridMin = glm::vec3(0.f);
+		float probeSpacing = 0.f;
+		glm::uvec3 gridSize = glm::uvec3(0);
+		uint32_t numProbes = 0;
+	};
+
+	// splitmix64, small & good enough for sampling. Seeded per probe so the result doesn't depend on the threads
+	class BakeRandom
+	{
+	public:
+		BakeRandom(uint64_t seed, uint64_t stream)
+			:m_state(seed ^ (stream * 0x9E3779B97F4A7C15ull))
+		{
+			next();
+		}
+
+		inline uint64_t next()
+		{
+			uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		inline float nextFloat()
+		{
+			return (next() >> 40) * (1.f / 16777216.f); // [0, 1)
+		}
+
+	private:
+		uint64_t m_state = 0;
+	};
+
+	struct BakeContext
+	{
+		const BakeScene* pBakeScene = nullptr;
+		const IrradianceBakeSettings* pSettings = nullptr;
+		BVH bvh;
+
+		float rayOffset = 0.f;
+	};
+
+	static glm::vec3 sampleSphere(BakeRandom& random)
+	{
+		float z = 1.f - 2.f * random.nextFloat();
+		float r = glm::sqrt(glm::max(1.f - z * z, 0.f));
+		float phi = glm::two_pi<float>() * random.nextFloat();
+
+		return glm::vec3(r * glm::cos(phi), r * glm::sin(phi), z);
+	}
+
+	static glm::vec3 sampleCosineHemisphere(glm::vec3 normal, BakeRandom& random)
+	{
+		float r = glm::sqrt(random.nextFloat());
+		float phi = glm::two_pi<float>() * random.nextFloat();
+
+		glm::vec3 tangent = glm::abs(normal.y) < 0.99f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f);
+		tangent = glm::normalize(glm::cross(tangent, normal));
+		glm::vec3 biTangent = glm::cross(normal, tangent);
+
+		float x = r * glm::cos(phi);
+		float y = r * glm::sin(phi);
+		float z = glm::sqrt(glm::max(1.f - x * x - y * y, 0.f));
+
+		return glm::normalize(tangent * x + biTangent * y + normal * z);
+	}
+
+	// Light arriving at position from the light, same falloff as PixelShader.hlsl. Returns false if the light doesn't reach it
+	static bool getIncomingLight(const BakeContext& context, const BakeLight& light, glm::vec3 position, glm::vec3* pOutToLight, glm::vec3* pOutLight)
+	{
+		glm::vec3 toLight = glm::vec3(0.f);
+		float distance = FLT_MAX;
+		float attenuation = 1.f;
+
+		switch (light.type)
+		{
+		case OKAY_BAKE_LIGHT_POINT:
+			toLight = light.position - position;
+			distance = glm::length(toLight);
+			toLight /= distance;
+			attenuation = 1.f / (1.f + light.attenuation.x + light.attenuation.y * distance * distance);
+			break;
+
+		case OKAY_BAKE_LIGHT_SPOT:
+			toLight = light.position - position;
+			distance = glm::length(toLight);
+			toLight /= distance;
+
+			if (glm::dot(-toLight, light.direction) < light.spreadCosAngle)
+			{
+				return false;
+			}
+
+			attenuation = 1.f / (1.f + light.attenuation.x * distance + light.attenuation.y * distance * distance);
+			break;
+
+		case OKAY_BAKE_LIGHT_DIRECTIONAL:
+			toLight = light.direction;
+			break;
+		}
+
+		if (context.bvh.occluded(position + toLight * context.rayOffset, toLight, distance - context.rayOffset * 2.f))
+		{
+			return false;
+		}
+
+		*pOutToLight = toLight;
+		*pOutLight = light.colour * light.intensity * attenuation;
+
+		return true;
+	}
+
+	// Light leaving the first surface along the ray towards origin, the shaders don't divide by pi so neither does this
+	static glm::vec3 traceRadiance(const BakeContext& context, glm::vec3 origin, glm::vec3 direction, uint32_t bounce, BakeRandom& random, bool* pOutBackface)
+	{
+		const IrradianceBakeSettings& settings = *context.pSettings;
+
+		BVHHit hit;
+		if (!context.bvh.intersect(origin, direction, FLT_MAX, &hit))
+		{
+			return settings.skyColour;
+		}
+
+		// Everything is treated as two sided, the probes use back faces to detect being inside geometry
+		glm::vec3 normal = context.bvh.getTriangleNormal(hit.triangleIdx);
+		if (glm::dot(normal, direction) > 0.f)
+		{
+			normal = -normal;
+
+			if (pOutBackface)
+			{
+				*pOutBackface = true;
+			}
+		}
+
+		glm::vec3 hitPosition = origin + direction * hit.distance + normal * context.rayOffset;
+
+		glm::vec3 irradiance = glm::vec3(0.f);
+		for (const BakeLight& light : context.pBakeScene->lights)
+		{
+			glm::vec3 toLight, incomingLight;
+			if (getIncomingLight(context, light, hitPosition, &toLight, &incomingLight))
+			{
+				irradiance += incomingLight * glm::max(glm::dot(toLight, normal), 0.f);
+			}
+		}
+
+		// With cosine weighted directions the estimate of the indirect light is just the traced radiance
+		if (bounce < settings.numBounces)
+		{
+			irradiance += traceRadiance(context, hitPosition, sampleCosineHemisphere(normal, random), bounce + 1, random, nullptr);
+		}
+
+		return settings.albedo * irradiance;
+	}
+
+	static bool bakeProbe(const BakeContext& context, glm::vec3 position, uint64_t probeIdx, IrradianceProbe& outProbe)
+	{
+		const IrradianceBakeSettings& settings = *context.pSettings;
+
+		BakeRandom random(settings.seed, probeIdx);
+
+		outProbe = IrradianceProbe();
+		uint32_t numBackfaces = 0;
+
+		for (uint32_t i = 0; i < settings.numSamples; i++)
+		{
+			glm::vec3 direction = sampleSphere(random);
+
+			bool backface = false;
+			glm::vec3 radiance = traceRadiance(context, position, direction, 1, random, &backface);
+			numBackfaces += backface;
+
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				outProbe.ambientCube[face] += radiance * glm::max(glm::dot(direction, AMBIENT_CUBE_AXES[face]), 0.f);
+			}
+		}
+
+		// Uniform sphere samples: (1 / pi) * integral(L * cos) ~= 4 / N * sum(L * cos)
+		for (glm::vec3& faceValue : outProbe.ambientCube)
+		{
+			faceValue *= 4.f / (float)glm::max(settings.numSamples, 1u);
+		}
+
+		// Direct light of the lights that don't exist at runtime
+		for (const BakeLight& light : context.pBakeScene->lights)
+		{
+			glm::vec3 toLight, incomingLight;
+			if (light.bakedOnly && getIncomingLight(context, light, position, &toLight, &incomingLight))
+			{
+				for (uint32_t face = 0; face < 6; face++)
+				{
+					outProbe.ambientCube[face] += incomingLight * glm::max(glm::dot(toLight, AMBIENT_CUBE_AXES[face]), 0.f);
+				}
+			}
+		}
+
+		return numBackfaces <= settings.numSamples * MAX_BACKFACE_RATIO;
+	}
+
+	// Invalid probes take the average of their valid neighbours, repeated until every probe connected to a valid one has a value
+	static void fillInvalidProbes(IrradianceVolume& volume, std::vector<uint8_t>& validProbes)
+	{
+		const glm::ivec3 gridSize = glm::ivec3(volume.gridSize);
+		const glm::ivec3 NEIGHBOUR_OFFSETS[6] =
+		{
+			glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0),
+			glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0),
+			glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1),
+		};
+
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+			std::vector<uint8_t> nextValidProbes = validProbes;
+
+			for (int z = 0; z < gridSize.z; z++)
+			{
+				for (int y = 0; y < gridSize.y; y++)
+				{
+					for (int x = 0; x < gridSize.x; x++)
+					{
+						uint32_t probeIdx = x + gridSize.x * (y + gridSize.y * z);
+						if (validProbes[probeIdx])
+						{
+							continue;
+						}
+
+						IrradianceProbe average;
+						uint32_t numValidNeighbours = 0;
+
+						for (const glm::ivec3& offset : NEIGHBOUR_OFFSETS)
+						{
+							glm::ivec3 neighbour = glm::ivec3(x, y, z) + offset;
+							if (glm::any(glm::lessThan(neighbour, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(neighbour, gridSize)))
+							{
+								continue;
+							}
+
+							uint32_t neighbourIdx = neighbour.x + gridSize.x * (neighbour.y + gridSize.y * neighbour.z);
+							if (!validProbes[neighbourIdx])
+							{
+								continue;
+							}
+
+							for (uint32_t face = 0; face < 6; face++)
+							{
+								average.ambientCube[face] += volume.probes[neighbourIdx].ambientCube[face];
+							}
+							numValidNeighbours++;
+						}
+
+						if (!numValidNeighbours)
+						{
+							continue;
+						}
+
+						for (uint32_t face = 0; face < 6; face++)
+						{
+							volume.probes[probeIdx].ambientCube[face] = average.ambientCube[face] / (float)numValidNeighbours;
+						}
+
+						nextValidProbes[probeIdx] = true;
+						changed = true;
+					}
+				}
+			}
+
+			validProbes.swap(nextValidProbes);
+		}
+	}
+
+	static bool isBakeLight(const entt::registry& registry, entt::entity entity)
+	{
+		return registry.any_of<StaticLight, BakedLight>(entity);
+	}
+
+	void createBakeScene(const Scene& scene, const ResourceManager& resourceManager, BakeScene& outBakeScene)
+	{
+		const entt::registry& registry = scene.getRegistry();
+
+		outBakeScene.trianglePositions.clear();
+		outBakeScene.lights.clear();
+
+		auto meshView = registry.view<MeshRenderer, Transform>();
+		for (entt::entity entity : meshView)
+		{
+			auto [meshRenderer, transform] = meshView[entity];
+
+			const MeshData& meshData = resourceManager.getAsset<Mesh>(meshRenderer.meshID).getMeshData();
+			OKAY_ASSERT(!meshData.verticies.empty()); // CPU data already unloaded?
+
+			glm::mat4 worldMatrix = transform.getMatrix();
+			for (uint32_t index : meshData.indicies)
+			{
+				outBakeScene.trianglePositions.emplace_back(worldMatrix * glm::vec4(meshData.verticies[index].position, 1.f));
+			}
+		}
+
+		auto pointLightView = registry.view<PointLight, Transform>();
+		for (entt::entity entity : pointLightView)
+		{
+			if (!isBakeLight(registry, entity))
+			{
+				continue;
+			}
+
+			auto [pointLight, transform] = pointLightView[entity];
+
+			BakeLight& light = outBakeScene.lights.emplace_back();
+			light.type = OKAY_BAKE_LIGHT_POINT;
+			light.position = transform.position;
+			light.colour = pointLight.colour;
+			light.intensity = pointLight.intensity;
+			light.attenuation = pointLight.attenuation;
+			light.bakedOnly = registry.all_of<BakedLight>(entity);
+		}
+
+		auto spotLightView = registry.view<SpotLight, Transform>();
+		for (entt::entity entity : spotLightView)
+		{
+			if (!isBakeLight(registry, entity))
+			{
+				continue;
+			}
+
+			auto [spotLight, transform] = spotLightView[entity];
+
+			BakeLight& light = outBakeScene.lights.emplace_back();
+			light.type = OKAY_BAKE_LIGHT_SPOT;
+			light.position = transform.position;
+			light.direction = transform.forwardVec();
+			light.colour = spotLight.colour;
+			light.intensity = spotLight.intensity;
+			light.attenuation = spotLight.attenuation;
+			light.spreadCosAngle = glm::cos(glm::radians(spotLight.spreadAngle * 0.5f));
+			light.bakedOnly = registry.all_of<BakedLight>(entity);
+		}
+
+		auto dirLightView = registry.view<DirectionalLight, Transform>();
+		for (entt::entity entity : dirLightView)
+		{
+			if (!isBakeLight(registry, entity))
+			{
+				continue;
+			}
+
+			auto [directionalLight, transform] = dirLightView[entity];
+
+			BakeLight& light = outBakeScene.lights.emplace_back();
+			light.type = OKAY_BAKE_LIGHT_DIRECTIONAL;
+			light.direction = -transform.forwardVec();
+			light.colour = directionalLight.colour;
+			light.intensity = directionalLight.intensity;
+			light.bakedOnly = registry.all_of<BakedLight>(entity);
+		}
+	}
+
+	uint64_t getBakeSourceKey(const BakeScene& bakeScene, const IrradianceBakeSettings& settings)
+	{
+		Hasher hasher;
+		hasher.addValue(PROBE_FILE_VERSION);
+
+		// Field by field, the structs have padding
+		hasher.addValue(settings.probeSpacing);
+		hasher.addValue(settings.maxProbesPerAxis);
+		hasher.addValue(settings.numSamples);
+		hasher.addValue(settings.numBounces);
+		hasher.addValue(settings.albedo);
+		hasher.addValue(settings.skyColour);
+		hasher.addValue(settings.seed);
+
+		hasher.addValue((uint32_t)bakeScene.lights.size());
+		for (const BakeLight& light : bakeScene.lights)
+		{
+			hasher.addValue(light.type);
+			hasher.addValue(light.position);
+			hasher.addValue(light.direction);
+			hasher.addValue(light.colour);
+			hasher.addValue(light.intensity);
+			hasher.addValue(light.attenuation);
+			hasher.addValue(light.spreadCosAngle);
+			hasher.addValue(light.bakedOnly);
+		}
+
+		// The triangles go through the faster ContentHasher
+		hasher.addValue((uint32_t)bakeScene.trianglePositions.size());
+		hasher.addValue(ContentHasher::hash(bakeScene.trianglePositions.data(), sizeof(glm::vec3) * bakeScene.trianglePositions.size()));
+
+		return hasher.get();
+	}
+
+	void bakeIrradianceVolume(const BakeScene& bakeScene, const IrradianceBakeSettings& settings, IrradianceVolume& outVolume)
+	{
+		outVolume.sourceKey = getBakeSourceKey(bakeScene, settings);
+
+		if (bakeScene.trianglePositions.empty())
+		{
+			createConstantIrradianceVolume(settings.skyColour, outVolume);
+			return;
+		}
+
+		BakeContext context;
+		context.pBakeScene = &bakeScene;
+		context.pSettings = &settings;
+		context.bvh.build(bakeScene.trianglePositions);
+
+		glm::vec3 sceneMin = glm::vec3(FLT_MAX);
+		glm::vec3 sceneMax = glm::vec3(-FLT_MAX);
+		for (const glm::vec3& position : bakeScene.trianglePositions)
+		{
+			sceneMin = glm::min(sceneMin, position);
+			sceneMax = glm::max(sceneMax, position);
+		}
+
+		glm::vec3 sceneExtent = sceneMax - sceneMin;
+		context.rayOffset = glm::length(sceneExtent) * 1e-5f;
+
+		// Grow the spacing if the grid would get too big
+		uint32_t maxProbesPerAxis = glm::max(settings.maxProbesPerAxis, 2u);
+		float maxExtent = glm::max(sceneExtent.x, glm::max(sceneExtent.y, sceneExtent.z));
+
+		outVolume.gridMin = sceneMin;
+		outVolume.probeSpacing = glm::max(settings.probeSpacing, maxExtent / (float)(maxProbesPerAxis - 1));
+		outVolume.gridSize = glm::min(glm::uvec3(glm::ceil(sceneExtent / outVolume.probeSpacing)) + 1u, glm::uvec3(maxProbesPerAxis));
+
+		uint32_t numProbes = outVolume.gridSize.x * outVolume.gridSize.y * outVolume.gridSize.z;
+		outVolume.probes.assign(numProbes, IrradianceProbe());
+
+		std::vector<uint8_t> validProbes(numProbes, false);
+
+		std::atomic<uint32_t> nextProbeIdx = 0;
+		auto bakeProbes = [&]()
+		{
+			uint32_t probeIdx = 0;
+			while ((probeIdx = nextProbeIdx++) < numProbes)
+			{
+				glm::uvec3 gridCoord;
+				gridCoord.x = probeIdx % outVolume.gridSize.x;
+				gridCoord.y = (probeIdx / outVolume.gridSize.x) % outVolume.gridSize.y;
+				gridCoord.z = probeIdx / (outVolume.gridSize.x * outVolume.gridSize.y);
+
+				glm::vec3 position = outVolume.gridMin + glm::vec3(gridCoord) * outVolume.probeSpacing;
+				validProbes[probeIdx] = bakeProbe(context, position, probeIdx, outVolume.probes[probeIdx]);
+			}
+		};
+
+		uint32_t numThreads = settings.numThreads ? settings.numThreads : glm::max(std::thread::hardware_concurrency(), 1u);
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads - 1);
+		for (uint32_t i = 0; i < numThreads - 1; i++)
+		{
+			threads.emplace_back(bakeProbes);
+		}
+
+		bakeProbes();
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		fillInvalidProbes(outVolume, validProbes);
+	}
+
+	void createConstantIrradianceVolume(glm::vec3 ambientColour, IrradianceVolume& outVolume)
+	{
+		outVolume.gridMin = glm::vec3(0.f);
+		outVolume.probeSpacing = 1.f;
+		outVolume.gridSize = glm::uvec3(1);
+
+		outVolume.probes.resize(1);
+		for (glm::vec3& faceValue : outVolume.probes[0].ambientCube)
+		{
+			faceValue = ambientColour;
+		}
+	}
+
+	bool writeIrradianceVolume(const FilePath& path, const IrradianceVolume& volume)
+	{
+		std::ofstream writer(path, std::ios::binary);
+		if (!writer)
+		{
+			return false;
+		}
+
+		ProbeFileHeader header;
+		header.sourceKey = volume.sourceKey;
+		header.gridMin = volume.gridMin;
+		header.probeSpacing = volume.probeSpacing;
+		header.gridSize = volume.gridSize;
+		header.numProbes = (uint32_t)volume.probes.size();
+
+		writer.write((const char*)&header, sizeof(ProbeFileHeader));
+		writer.write((const char*)volume.probes.data(), sizeof(IrradianceProbe) * volume.probes.size());
+
+		return (bool)writer;
+	}
+
+	bool readIrradianceVolume(const FilePath& path, uint64_t sourceKey, IrradianceVolume& outVolume)
+	{
+		std::string fileData;
+		if (!readBinary(path, fileData) || fileData.size() < sizeof(ProbeFileHeader))
+		{
+			return false;
+		}
+
+		ProbeFileHeader header;
+		memcpy(&header, fileData.data(), sizeof(ProbeFileHeader));
+
+		if (header.magic != PROBE_FILE_MAGIC || header.version != PROBE_FILE_VERSION || header.sourceKey != sourceKey ||
+			header.numProbes != header.gridSize.x * header.gridSize.y * header.gridSize.z ||
+			fileData.size() != sizeof(ProbeFileHeader) + sizeof(IrradianceProbe) * header.numProbes)
+		{
+			return false;
+		}
+
+		outVolume.gridMin = header.gridMin;
+		outVolume.probeSpacing = header.probeSpacing;
+		outVolume.gridSize = header.gridSize;
+		outVolume.sourceKey = header.sourceKey;
+
+		outVolume.probes.resize(header.numProbes);
+		memcpy(outVolume.probes.data(), fileData.data() + sizeof(ProbeFileHeader), sizeof(IrradianceProbe) * header.numProbes);
+
+		return true;
+	}
+}
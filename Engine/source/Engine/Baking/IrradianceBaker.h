@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+/*
+	Irradiance probe baker:
+	Path traces the static scene from a grid of probes on all CPU cores and stores the incoming light of every probe
+	as an ambient cube (one colour per axis direction, see getAmbientLight in PixelShader.hlsl).
+
+	Only lights with a StaticLight or BakedLight component are baked. A moving light (like one on the camera) would have its
+	bounce frozen where it was at bake time, while it's still shaded live wherever it goes.
+	Static lights contribute bounced light. Lights with a BakedLight component also contribute their direct light
+	to the probes and are skipped at runtime, so fill lights can be dropped from the per pixel loops entirely.
+
+	The result only depends on the scene, the settings & the seed. Every probe has its own random sequence derived from its index,
+	so the number of threads and the order probes are picked up in don't matter.
+	The probe file stores a key of all of them (getBakeSourceKey), so a bake of an older scene or other settings is never reused.
+
+	Headless, only needs the CPU side of the scene & meshes.
+*/
+
+namespace Okay
+{
+	class Scene;
+	class ResourceManager;
+
+	enum BakeLightType : uint32_t
+	{
+		OKAY_BAKE_LIGHT_POINT = 0,
+		OKAY_BAKE_LIGHT_SPOT = 1,
+		OKAY_BAKE_LIGHT_DIRECTIONAL = 2,
+	};
+
+	struct BakeLight
+	{
+		BakeLightType type = OKAY_BAKE_LIGHT_POINT;
+
+		glm::vec3 position = glm::vec3(0.f);
+		glm::vec3 direction = glm::vec3(0.f, 0.f, 1.f); // Spot: where the light points, directional: towards the light
+
+		glm::vec3 colour = glm::vec3(1.f);
+		float intensity = 1.f;
+		glm::vec2 attenuation = glm::vec2(0.f, 1.f);
+		float spreadCosAngle = 0.f;
+
+		bool bakedOnly = false; // Direct light is baked into the probes too
+	};
+
+	struct BakeScene
+	{
+		std::vector<glm::vec3> trianglePositions; // World space, 3 per triangle
+		std::vector<BakeLight> lights;
+	};
+
+	struct IrradianceBakeSettings
+	{
+		float probeSpacing = 150.f;
+		uint32_t maxProbesPerAxis = 64;
+
+		uint32_t numSamples = 256; // Rays per probe
+		uint32_t numBounces = 2;
+
+		float albedo = 0.5f; // Textures aren't sampled, every surface gets the same albedo
+		glm::vec3 skyColour = glm::vec3(0.05f);
+
+		uint64_t seed = 1;
+		uint32_t numThreads = 0; // 0 = all cores
+	};
+
+	// Ambient cube, +X, -X, +Y, -Y, +Z, -Z. Same layout as IrradianceProbe in PixelShader.hlsl
+	struct IrradianceProbe
+	{
+		glm::vec3 ambientCube[6] = {};
+	};
+
+	struct IrradianceVolume
+	{
+		glm::vec3 gridMin = glm::vec3(0.f);
+		float probeSpacing = 1.f;
+		glm::uvec3 gridSize = glm::uvec3(0);
+
+		std::vector<IrradianceProbe> probes; // x fastest, then y, then z
+
+		uint64_t sourceKey = 0; // getBakeSourceKey of what it was baked from
+	};
+
+	// Collects the triangles of every MeshRenderer & the static & baked lights, needs to be called before the CPU mesh data is unloaded
+	void createBakeScene(const Scene& scene, const ResourceManager& resourceManager, BakeScene& outBakeScene);
+
+	// Hash of the triangles, the lights & every setting that changes the result (numThreads doesn't)
+	uint64_t getBakeSourceKey(const BakeScene& bakeScene, const IrradianceBakeSettings& settings);
+
+	void bakeIrradianceVolume(const BakeScene& bakeScene, const IrradianceBakeSettings& settings, IrradianceVolume& outVolume);
+
+	// Single probe with a constant ambient colour, used when there's no bake
+	void createConstantIrradianceVolume(glm::vec3 ambientColour, IrradianceVolume& outVolume);
+
+	bool writeIrradianceVolume(const FilePath& path, const IrradianceVolume& volume);
+	// Fails if the file is missing, broken or was baked from anything but sourceKey
+	bool readIrradianceVolume(const FilePath& path, uint64_t sourceKey, IrradianceVolume& outVolume);
+}
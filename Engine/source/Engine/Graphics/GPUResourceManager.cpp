@@ -64,9 +64,9 @@ namespace Okay
 
 		if (pData)
 		{
-			updateTexture(resource.pDXResource, (uint8_t*)pData, *pUploadContext);
+			updateTexture(resource.pDXResource, (const uint8_t*)pData, *pUploadContext);
 
-			if (textureDesc.flags & OKAY_TEXTURE_FLAG_SHADER_READ && mipLevels == 1)
+			if (textureDesc.flags & OKAY_TEXTURE_FLAG_SHADER_READ)
 			{
 				pUploadContext->transitionResource(resource.pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 			}
@@ -200,174 +200,6 @@ namespace Okay
 		return desc;
 	}
 
-	void GPUResourceManager::generateMipMaps(ID3D12CommandQueue* pCommandQueue)
-	{
-		/*
-			In DirectX 12 we need to generate the content of the mipMaps manually.
-
-			To do this, we create an intermediate UAV texture that is the max size of all textures.
-			For each texture we then copy it's content to the intermediate, loop through the mip maps and down sample using a CS.
-			After all mipmaps have been proccessed, we copy the contents of the intermediate to the original texture.
-
-			Essentially:
-
-			* Create intermediate UAV texture based on maxTextureDims & largestMipDepth
-
-			For each texture:
-				* Copy contents into intermediate
-				* Bind SRV to mip0 of intermediate
-				
-				For each mip (starting at mip1):
-					* Create UAV to the mip
-					* Dispatch CS that will sample mip i - 1 & write to the UAV
-				
-				* Copy intermediate to original texture
-			
-			Note:
-			The reason that i - 1 is used as the index for both the SRV & UAV is because we want to sample the parent mip,
-			and the descriptor table starts at mip1. Meaning in the CS that uavMips[0] refers to mip1.
-		*/
-
-
-		uint16_t totalMipMaps = 0;
-		uint16_t largetMipDepth = 0;
-		glm::uvec2 largestTextureDims = glm::uvec2(0, 0);
-		for (Resource& resource : m_resources)
-		{
-			D3D12_RESOURCE_DESC textureDesc = resource.pDXResource->GetDesc();
-
-			if (textureDesc.MipLevels == 1)
-			{
-				continue;
-			}
-
-			largestTextureDims = glm::max(largestTextureDims, glm::uvec2(textureDesc.Width, textureDesc.Height));
-			largetMipDepth = glm::max(largetMipDepth, textureDesc.MipLevels);
-
-			totalMipMaps += textureDesc.MipLevels;
-		}
-
-		if (!totalMipMaps)
-		{
-			return;
-		}
-
-
-		D3D12_RESOURCE_DESC intermediateTextureDesc = m_resources[0].pDXResource->GetDesc();
-		intermediateTextureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		intermediateTextureDesc.Alignment = RESOURCE_PLACEMENT_ALIGNMENT;
-		intermediateTextureDesc.Width = largestTextureDims.x;
-		intermediateTextureDesc.Height = largestTextureDims.y;
-		intermediateTextureDesc.DepthOrArraySize = 1;
-		intermediateTextureDesc.MipLevels = largetMipDepth;
-		intermediateTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		intermediateTextureDesc.SampleDesc.Count = 1;
-		intermediateTextureDesc.SampleDesc.Quality = 0;
-		intermediateTextureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-		intermediateTextureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-		D3D12_HEAP_PROPERTIES intermediateHeapProperties{};
-		intermediateHeapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
-		intermediateHeapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		intermediateHeapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		intermediateHeapProperties.CreationNodeMask = 0;
-		intermediateHeapProperties.VisibleNodeMask = 0;
-
-		ID3D12Resource* pDXIntermediateTexture = nullptr;
-		DX_CHECK(m_pDevice->CreateCommittedResource(&intermediateHeapProperties, D3D12_HEAP_FLAG_NONE, &intermediateTextureDesc, D3D12_RESOURCE_STATE_COPY_SOURCE, nullptr, IID_PPV_ARGS(&pDXIntermediateTexture)));
-
-
-		CommandContext computeContext;
-		computeContext.initialize(m_pDevice, pCommandQueue);
-		ID3D12GraphicsCommandList* pGraphicsComputeList = computeContext.getCommandList();
-
-		RingBuffer ringBuffer;
-		ringBuffer.initialize(m_pDevice, RESOURCE_PLACEMENT_ALIGNMENT * 2);
-		ringBuffer.map();
-
-		ID3D12RootSignature* pMipMapRootSignature = createMipMapRootSignature();
-		ID3D12PipelineState* pMipMapPSO = createMipMapPSO(pMipMapRootSignature);
-
-		pGraphicsComputeList->SetComputeRootSignature(pMipMapRootSignature);
-		pGraphicsComputeList->SetPipelineState(pMipMapPSO);
-
-
-		DescriptorHeapHandle descHeapHandle = m_pDescriptorHeapStore->createDescriptorHeap(totalMipMaps, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true);
-		ID3D12DescriptorHeap* pDescriptorHeap = m_pDescriptorHeapStore->getDXDescriptorHeap(descHeapHandle);
-
-		pGraphicsComputeList->SetDescriptorHeaps(1, &pDescriptorHeap);
-
-		for (Resource& resource : m_resources)
-		{
-			D3D12_RESOURCE_DESC textureDesc = resource.pDXResource->GetDesc();
-
-			if (textureDesc.MipLevels == 1)
-			{
-				continue;
-			}
-
-
-			computeContext.transitionResource(resource.pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE);
-			computeContext.transitionResource(pDXIntermediateTexture, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
-
-			copyDifferentTextures(pGraphicsComputeList, pDXIntermediateTexture, resource.pDXResource, (uint32_t)textureDesc.Width, textureDesc.Height);
-
-			computeContext.transitionResource(pDXIntermediateTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-
-			DescriptorDesc textureSRVDesc = {};
-			textureSRVDesc.type = OKAY_DESCRIPTOR_TYPE_SRV;
-			textureSRVDesc.pDXResource = pDXIntermediateTexture;
-
-			Descriptor srvDescriptor = m_pDescriptorHeapStore->allocateDescriptors(descHeapHandle, OKAY_DESCRIPTOR_APPEND, &textureSRVDesc, 1);
-			pGraphicsComputeList->SetComputeRootDescriptorTable(0, srvDescriptor.gpuHandle);
-
-
-			for (uint32_t i = 1; i < textureDesc.MipLevels; i++)
-			{
-				DescriptorDesc currentMipUAVDesc = {};
-				currentMipUAVDesc.type = OKAY_DESCRIPTOR_TYPE_UAV;
-				currentMipUAVDesc.pDXResource = pDXIntermediateTexture;
-
-				currentMipUAVDesc.nullDesc = false;
-				currentMipUAVDesc.uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-				currentMipUAVDesc.uavDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-				currentMipUAVDesc.uavDesc.Texture2D.MipSlice = i;
-				currentMipUAVDesc.uavDesc.Texture2D.PlaneSlice = 0;
-
-				m_pDescriptorHeapStore->allocateDescriptors(descHeapHandle, OKAY_DESCRIPTOR_APPEND, &currentMipUAVDesc, 1);
-				computeContext.transitionSubresource(pDXIntermediateTexture, i, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
-
-				float uavIdxAndSrvMip = (float)i - 1;
-				D3D12_GPU_VIRTUAL_ADDRESS cbAddress = ringBuffer.allocateMapped(&uavIdxAndSrvMip, sizeof(float));
-				pGraphicsComputeList->SetComputeRootConstantBufferView(1, cbAddress);
-
-
-				uint32_t mipWidth = (uint32_t)textureDesc.Width / (uint32_t)glm::pow(2, i);
-				uint32_t mipHeight = textureDesc.Height / (uint32_t)glm::pow(2, i);
-				pGraphicsComputeList->Dispatch(mipWidth / 16 + 1, mipHeight / 16 + 1, 1);
-
-				computeContext.transitionSubresource(pDXIntermediateTexture, i, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-			}
-
-			computeContext.transitionResource(pDXIntermediateTexture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
-			computeContext.transitionResource(resource.pDXResource, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
-
-			copyDifferentTextures(pGraphicsComputeList, resource.pDXResource, pDXIntermediateTexture, (uint32_t)textureDesc.Width, textureDesc.Height);
-
-			computeContext.transitionResource(resource.pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-		}
-
-		computeContext.flush();
-		computeContext.shutdown();
-		ringBuffer.shutdown();
-		
-		D3D12_RELEASE(pDXIntermediateTexture);
-		D3D12_RELEASE(pMipMapRootSignature);
-		D3D12_RELEASE(pMipMapPSO);
-	}
-
 	void GPUResourceManager::updateBufferUpload(RingBuffer& ringBuffer, CommandContext& uploadContext, ID3D12Resource* pDXResource, uint64_t resourceOffset, uint64_t byteSize, const void* pData)
 	{
 		uint64_t ringBufferOffset = ringBuffer.getOffset();
@@ -390,114 +222,84 @@ namespace Okay
 		pDXResource->Unmap(0, nullptr);
 	}
 
-	void GPUResourceManager::updateTexture(ID3D12Resource* pDXResource, uint8_t* pData, CommandContext& uploadContext)
+	void GPUResourceManager::uploadTextureMips(ID3D12Resource* pDXResource, uint32_t firstMip, uint32_t numMips, const uint8_t* pData, RingBuffer& uploadBuffer, CommandContext& uploadContext)
 	{
+		// pData holds the mips tightly packed after each other (TextureMipChain), they're all copied from one upload buffer allocation
 		D3D12_RESOURCE_DESC textureDesc = pDXResource->GetDesc();
-		textureDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footPrint = {};
-		uint64_t rowSizeInBytes = 0;
-		m_pDevice->GetCopyableFootprints(&textureDesc, 0, 1, 0, &footPrint, nullptr, &rowSizeInBytes, nullptr);
+		OKAY_ASSERT(numMips <= D3D12_REQ_MIP_LEVELS);
+		OKAY_ASSERT(firstMip + numMips <= textureDesc.MipLevels);
 
+		uploadBuffer.alignOffset(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		uint64_t baseOffset = uploadBuffer.getOffset();
 
-		D3D12_RESOURCE_ALLOCATION_INFO resourceAllocationInfo = m_pDevice->GetResourceAllocationInfo(0, 1, &textureDesc);
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footPrints[D3D12_REQ_MIP_LEVELS] = {};
+		uint32_t numRows[D3D12_REQ_MIP_LEVELS] = {};
+		uint64_t rowSizesInBytes[D3D12_REQ_MIP_LEVELS] = {};
+		uint64_t uploadSize = 0;
+		m_pDevice->GetCopyableFootprints(&textureDesc, firstMip, numMips, baseOffset, footPrints, numRows, rowSizesInBytes, &uploadSize);
 
-		RingBuffer textureUploadBuffer;
-		textureUploadBuffer.initialize(m_pDevice, resourceAllocationInfo.SizeInBytes);
-
-		uint8_t* pMappedData = textureUploadBuffer.map();
+		// The footprint offsets include baseOffset
+		uint8_t* pMappedData = uploadBuffer.getMappedPtr() - baseOffset;
 
-		for (uint32_t i = 0; i < textureDesc.Height; i++)
+		for (uint32_t i = 0; i < numMips; i++)
 		{
-			memcpy(pMappedData + i * footPrint.Footprint.RowPitch, pData + i * rowSizeInBytes, rowSizeInBytes);
-		}
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footPrint = footPrints[i];
+			uint64_t rowSizeInBytes = rowSizesInBytes[i];
 
-		textureUploadBuffer.unmap();
+			for (uint32_t row = 0; row < numRows[i]; row++)
+			{
+				memcpy(pMappedData + footPrint.Offset + row * footPrint.Footprint.RowPitch, pData + row * rowSizeInBytes, rowSizeInBytes);
+			}
 
+			pData += rowSizeInBytes * numRows[i];
+		}
 
-		D3D12_TEXTURE_COPY_LOCATION copyDst{};
-		copyDst.pResource = pDXResource;
-		copyDst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-		copyDst.SubresourceIndex = 0;
+		uploadBuffer.offsetMappedPtr(uploadSize);
 
-		D3D12_TEXTURE_COPY_LOCATION copySrc{};
-		copySrc.pResource = textureUploadBuffer.getDXResource();
-		copySrc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-		copySrc.PlacedFootprint = footPrint;
-		copySrc.PlacedFootprint.Offset = 0;
 
 		ID3D12GraphicsCommandList* pCommandList = uploadContext.getCommandList();
-		pCommandList->CopyTextureRegion(&copyDst, 0, 0, 0, &copySrc, nullptr);
 
-		uploadContext.flush();
-		textureUploadBuffer.shutdown();
-	}
+		for (uint32_t i = 0; i < numMips; i++)
+		{
+			D3D12_TEXTURE_COPY_LOCATION copyDst{};
+			copyDst.pResource = pDXResource;
+			copyDst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			copyDst.SubresourceIndex = firstMip + i;
 
-	void GPUResourceManager::validateResourceHandle(ResourceHandle handle)
-	{
-		OKAY_ASSERT(handle < (ResourceHandle)m_resources.size());
+			D3D12_TEXTURE_COPY_LOCATION copySrc{};
+			copySrc.pResource = uploadBuffer.getDXResource();
+			copySrc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			copySrc.PlacedFootprint = footPrints[i];
+
+			pCommandList->CopyTextureRegion(&copyDst, 0, 0, 0, &copySrc, nullptr);
+		}
 	}
 
-	ID3D12RootSignature* GPUResourceManager::createMipMapRootSignature()
+	uint64_t GPUResourceManager::getTextureUploadSize(const D3D12_RESOURCE_DESC& textureDesc, uint32_t firstMip, uint32_t numMips) const
 	{
-		D3D12_DESCRIPTOR_RANGE descriptorRanges[2] = {};
-		descriptorRanges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
-		descriptorRanges[0].NumDescriptors = 16;
-		descriptorRanges[0].OffsetInDescriptorsFromTableStart = 1;
-		descriptorRanges[0].BaseShaderRegister = 0;
-		descriptorRanges[0].RegisterSpace = 0;
-
-		descriptorRanges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-		descriptorRanges[1].NumDescriptors = 1;
-		descriptorRanges[1].OffsetInDescriptorsFromTableStart = 0;
-		descriptorRanges[1].BaseShaderRegister = 0;
-		descriptorRanges[1].RegisterSpace = 0;
-
-
-		D3D12_ROOT_PARAMETER rootParams[2] = {};
-		rootParams[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-		rootParams[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-		rootParams[0].DescriptorTable.NumDescriptorRanges = _countof(descriptorRanges);
-		rootParams[0].DescriptorTable.pDescriptorRanges = descriptorRanges;
-
-		rootParams[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-		rootParams[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-		rootParams[1].Descriptor.ShaderRegister = 0;
-		rootParams[1].Descriptor.RegisterSpace = 0;
-
-
-		D3D12_STATIC_SAMPLER_DESC defaultSampler = createDefaultStaticPointSamplerDesc();
-		defaultSampler.Filter = D3D12_FILTER_ANISOTROPIC;
-		defaultSampler.MaxAnisotropy = D3D12_MAX_MAXANISOTROPY;
-		defaultSampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-		D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
-		rootDesc.NumParameters = _countof(rootParams);
-		rootDesc.pParameters = rootParams;
-		rootDesc.NumStaticSamplers = 1;
-		rootDesc.pStaticSamplers = &defaultSampler;
-		rootDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
-
-		return createRootSignature(m_pDevice, rootDesc);
+		uint64_t uploadSize = 0;
+		m_pDevice->GetCopyableFootprints(&textureDesc, firstMip, numMips, 0, nullptr, nullptr, nullptr, &uploadSize);
+
+		return alignAddress64(uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 	}
 
-	ID3D12PipelineState* GPUResourceManager::createMipMapPSO(ID3D12RootSignature* pRootSignature)
+	void GPUResourceManager::updateTexture(ID3D12Resource* pDXResource, const uint8_t* pData, CommandContext& uploadContext)
 	{
-		ID3DBlob* pShaderBlob = nullptr;
+		D3D12_RESOURCE_DESC textureDesc = pDXResource->GetDesc();
 
-		D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc = {};
-		computeDesc.pRootSignature = pRootSignature;
-		computeDesc.CS = compileShader(SHADER_PATH / "MipMapGenerationCS.hlsl", "cs_5_1", &pShaderBlob);
-		computeDesc.NodeMask = 0;
-		computeDesc.CachedPSO.pCachedBlob = nullptr;
-		computeDesc.CachedPSO.CachedBlobSizeInBytes = 0;
-		computeDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+		RingBuffer textureUploadBuffer;
+		textureUploadBuffer.initialize(m_pDevice, getTextureUploadSize(textureDesc, 0, textureDesc.MipLevels));
+		textureUploadBuffer.map();
 
-		ID3D12PipelineState* pMipMapPSO = nullptr;
-		DX_CHECK(m_pDevice->CreateComputePipelineState(&computeDesc, IID_PPV_ARGS(&pMipMapPSO)));
+		uploadTextureMips(pDXResource, 0, textureDesc.MipLevels, pData, textureUploadBuffer, uploadContext);
 
-		D3D12_RELEASE(pShaderBlob);
+		uploadContext.flush();
+		textureUploadBuffer.shutdown();
+	}
 
-		return pMipMapPSO;
+	void GPUResourceManager::validateResourceHandle(ResourceHandle handle)
+	{
+		OKAY_ASSERT(handle < (ResourceHandle)m_resources.size());
 	}
 }
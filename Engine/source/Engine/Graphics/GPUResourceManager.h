@@ -48,8 +48,16 @@ namespace Okay
 		void initialize(ID3D12Device* pDevice, DescriptorHeapStore& descriptorHeapStore);
 		void shutdown();
 
+		// pData has every mip level of the texture tightly packed, see TextureMipChain
 		Allocation createTexture(const TextureDescription& textureDesc, const void* pData, CommandContext* pUploadContext);
 
+		// Records copies of [firstMip, firstMip + numMips) from pData (tightly packed) through uploadBuffer, doesn't wait for them.
+		// The mips have to be in the COPY_DEST state
+		void uploadTextureMips(ID3D12Resource* pDXResource, uint32_t firstMip, uint32_t numMips, const uint8_t* pData, RingBuffer& uploadBuffer, CommandContext& uploadContext);
+
+		// Space uploadTextureMips needs in the upload buffer, including the alignment
+		uint64_t getTextureUploadSize(const D3D12_RESOURCE_DESC& textureDesc, uint32_t firstMip, uint32_t numMips) const;
+
 		Resource createResource(D3D12_HEAP_TYPE heapType, uint64_t size);
 		Allocation allocateInto(Resource resource, uint64_t offset, uint64_t elementSize, uint32_t numElements, const void* pData, RingBuffer* pUploadBuffer, CommandContext* pUploadContext);
 
@@ -60,18 +68,13 @@ namespace Okay
 
 		DescriptorDesc createDescriptorDesc(const Allocation& allocation, DescriptorType type, bool nullDesc);
 
-		void generateMipMaps(ID3D12CommandQueue* pCommandQueue);
-
 	private:
 		void updateBufferUpload(RingBuffer& ringBuffer, CommandContext& commandContext, ID3D12Resource* pDXResource, uint64_t resourceOffset, uint64_t byteSize, const void* pData);
 		void updateBufferDirect(ID3D12Resource* pDXResource, uint64_t resourceOffset, uint64_t byteSize, const void* pData);
-		void updateTexture(ID3D12Resource* pDXResource, uint8_t* pData, CommandContext& uploadContext);
+		void updateTexture(ID3D12Resource* pDXResource, const uint8_t* pData, CommandContext& uploadContext);
 
 		void validateResourceHandle(ResourceHandle handle);
 
-		ID3D12RootSignature* createMipMapRootSignature();
-		ID3D12PipelineState* createMipMapPSO(ID3D12RootSignature* pRootSignature);
-
 	private:
 		ID3D12Device* m_pDevice = nullptr;
 
@@ -0,0 +1,61 @@
+#include "IndirectDrawBuilder.h"
+
+namespace Okay
+{
+	void IndirectDrawBuilder::reset()
+	{
+		m_draws.clear();
+		m_drawDatas.clear();
+	}
+
+	uint32_t IndirectDrawBuilder::addDraw(const IndirectDrawDesc& drawDesc)
+	{
+		OKAY_ASSERT(drawDesc.indexPool < OKAY_INDEX_POOL_COUNT);
+
+		IndirectDrawData& drawData = m_drawDatas.emplace_back();
+		drawData.quantization = drawDesc.quantization;
+		drawData.baseVertex = drawDesc.baseVertex;
+		drawData.firstObject = drawDesc.firstObject;
+
+		m_draws.emplace_back(drawDesc);
+
+		return (uint32_t)m_draws.size() - 1;
+	}
+
+	void IndirectDrawBuilder::buildCommands(IndirectCommandList& outCommandList) const
+	{
+		outCommandList.clear();
+
+		for (uint32_t i = 0; i < (uint32_t)m_draws.size(); i++)
+		{
+			addCommand(i, outCommandList);
+		}
+	}
+
+	void IndirectDrawBuilder::buildCommands(const uint32_t* pDrawIndicies, uint32_t numDraws, IndirectCommandList& outCommandList) const
+	{
+		outCommandList.clear();
+
+		for (uint32_t i = 0; i < numDraws; i++)
+		{
+			addCommand(pDrawIndicies[i], outCommandList);
+		}
+	}
+
+	void IndirectDrawBuilder::addCommand(uint32_t drawIdx, IndirectCommandList& outCommandList) const
+	{
+		OKAY_ASSERT(drawIdx < (uint32_t)m_draws.size());
+
+		const IndirectDrawDesc& drawDesc = m_draws[drawIdx];
+		if (!drawDesc.numIndicies || !drawDesc.numInstances)
+		{
+			return;
+		}
+
+		IndirectDrawCommand& command = outCommandList.commands[drawDesc.indexPool].emplace_back();
+		command.drawIdx = drawIdx;
+		command.numIndicies = drawDesc.numIndicies;
+		command.numInstances = drawDesc.numInstances;
+		command.firstIndex = drawDesc.firstIndex;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Resources/VertexQuantization.h"
+
+#include <vector>
+
+/*
+	Indirect draws:
+	Every mesh lives in the same vertex & index buffers (see DXMesh), so a whole pass is drawn with one ExecuteIndirect
+	per index format instead of binding buffers and root constants for every mesh.
+
+	Each draw gets an IndirectDrawData which the vertex shaders find with the draw index, a root constant written by the
+	command itself. It holds what used to be bound per mesh: the base vertex (SV_VertexID doesn't include BaseVertexLocation),
+	the first object (same for SV_InstanceID & StartInstanceLocation) and the dequantization.
+
+	The draws are added once per frame, one per draw group, passes then build commands for all of them or a subset (shadow casters).
+*/
+
+namespace Okay
+{
+	// The index buffers are split by format, a pool is drawn with one ExecuteIndirect
+	enum IndexPool : uint32_t
+	{
+		OKAY_INDEX_POOL_16 = 0,
+		OKAY_INDEX_POOL_32 = 1,
+		OKAY_INDEX_POOL_COUNT = 2,
+	};
+
+	// Layout of the command signature: the draw index root constant followed by D3D12_DRAW_INDEXED_ARGUMENTS
+	struct IndirectDrawCommand
+	{
+		uint32_t drawIdx = 0;
+
+		uint32_t numIndicies = 0;
+		uint32_t numInstances = 0;
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0; // Always 0, see IndirectDrawData
+		uint32_t firstInstance = 0; // Same
+	};
+
+	// Per draw data, matches DrawData in VertexDecoding.hlsli
+	struct IndirectDrawData
+	{
+		VertexQuantization quantization;
+		uint32_t baseVertex = 0;
+		uint32_t firstObject = 0;
+	};
+
+	static_assert(sizeof(IndirectDrawCommand) == 24, "IndirectDrawCommand must match the command signature");
+	static_assert(sizeof(IndirectDrawData) == 32, "IndirectDrawData must match the layout in VertexDecoding.hlsli");
+
+	struct IndirectDrawDesc
+	{
+		IndexPool indexPool = OKAY_INDEX_POOL_32;
+		uint32_t firstIndex = 0; // Into the pool
+		uint32_t numIndicies = 0;
+		uint32_t baseVertex = 0;
+
+		uint32_t firstObject = 0;
+		uint32_t numInstances = 0;
+
+		VertexQuantization quantization;
+	};
+
+	struct IndirectCommandList
+	{
+		std::vector<IndirectDrawCommand> commands[OKAY_INDEX_POOL_COUNT];
+
+		inline void clear()
+		{
+			for (std::vector<IndirectDrawCommand>& poolCommands : commands)
+			{
+				poolCommands.clear();
+			}
+		}
+
+		inline uint32_t getNumCommands() const
+		{
+			return (uint32_t)(commands[OKAY_INDEX_POOL_16].size() + commands[OKAY_INDEX_POOL_32].size());
+		}
+	};
+
+	class IndirectDrawBuilder
+	{
+	public:
+		IndirectDrawBuilder() = default;
+		~IndirectDrawBuilder() = default;
+
+		void reset();
+
+		// Returns the draw index, draws keep the order they're added in
+		uint32_t addDraw(const IndirectDrawDesc& drawDesc);
+
+		// Draws without indicies or instances don't get a command
+		void buildCommands(IndirectCommandList& outCommandList) const;
+		void buildCommands(const uint32_t* pDrawIndicies, uint32_t numDraws, IndirectCommandList& outCommandList) const;
+
+		inline const std::vector<IndirectDrawData>& getDrawDatas() const { return m_drawDatas; }
+		inline uint32_t getNumDraws() const { return (uint32_t)m_drawDatas.size(); }
+
+	private:
+		void addCommand(uint32_t drawIdx, IndirectCommandList& outCommandList) const;
+
+	private:
+		std::vector<IndirectDrawDesc> m_draws;
+		std::vector<IndirectDrawData> m_drawDatas;
+	};
+}
@@ -1,421 +1,766 @@
 #include "LightHandler.h"
+#include "Engine/Misc/Hash.h"
 
 namespace Okay
 {
-	struct GPUShadowMapCubeData
+	static void fillShadowMapBarrier(D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* pDXResource, D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter)
 	{
-		glm::mat4 matrices[6] = {};
-		glm::vec3 lightPos = glm::vec3(0.f);
-		float farPlane = 0.f;
-	};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Transition.pResource = pDXResource;
+		barrier.Transition.StateBefore = stateBefore;
+		barrier.Transition.StateAfter = stateAfter;
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	}
 
-	struct GPUPointLight
+	// arraySize is 6 for cubes
+	static D3D12_RESOURCE_DESC createShadowMapDesc(uint32_t resolution, uint16_t arraySize)
 	{
-		uint32_t shadowMapIdx = INVALID_UINT32;
-		float farPlane = 0.f;
-
-		glm::vec3 position = glm::vec3(0.f);
-
-		glm::vec3 colour = glm::vec3(1.f);
-		float intensity = 1.f;
-		glm::vec2 attenuation = glm::vec2(0.f, 1.f);
-	};
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		desc.Alignment = 0;
+		desc.Width = resolution;
+		desc.Height = resolution;
+		desc.DepthOrArraySize = arraySize;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_R32_TYPELESS;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+		return desc;
+	}
 
-	struct GPUDirectionalLight
+	static ID3D12Resource* createCommittedShadowMap(ID3D12Device* pDevice, uint32_t resolution)
 	{
-		glm::mat4 viewProjMatrix = glm::mat4(1.f);
-		uint32_t shadowMapIdx = INVALID_UINT32;
+		D3D12_HEAP_PROPERTIES heapProperties = {};
+		heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		heapProperties.CreationNodeMask = 0;
+		heapProperties.VisibleNodeMask = 0;
 
-		glm::vec3 direction = glm::vec3(0.f);
-
-		glm::vec3 colour = glm::vec3(1.f);
-		float intensity = 1.f;
-	};
+		D3D12_RESOURCE_DESC desc = createShadowMapDesc(resolution, 1);
 
-	struct GPUSpotLight
-	{
-		glm::mat4 viewProjMatrix = glm::mat4(1.f);
-		uint32_t shadowMapIdx = INVALID_UINT32;
+		D3D12_CLEAR_VALUE clearValue = {};
+		clearValue.Format = DXGI_FORMAT_D32_FLOAT;
+		clearValue.DepthStencil.Depth = 1.f;
+		clearValue.DepthStencil.Stencil = 0;
 
-		glm::vec3 position = glm::vec3(0.f);
-		glm::vec3 direction = glm::vec3(0.f);
+		ID3D12Resource* pDXResource = nullptr;
+		DX_CHECK(pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, &clearValue, IID_PPV_ARGS(&pDXResource)));
 
-		glm::vec3 colour = glm::vec3(1.f);
-		float intensity = 1.f;
+		return pDXResource;
+	}
 
-		glm::vec2 attenuation = glm::vec2(0.f, 1.f);
-		float spreadCosAngle = 90.f;
+	struct GPUShadowMapCubeData
+	{
+		glm::mat4 matrices[6] = {};
+		glm::vec3 lightPos = glm::vec3(0.f);
+		float farPlane = 0.f;
+		uint32_t faceMask = 0;
 	};
 
-	void LightHandler::initiate(ID3D12Device* pDevice, uint32_t maxFramesInFlight, GPUResourceManager& gpuResourceManager, const std::vector<DXMesh>& dxMeshes, DescriptorHeapStore& descHeapStore)
+	// size_hint isn't exact for views with excluded components
+	template<typename ViewT>
+	static uint32_t countViewEntities(const ViewT& view)
+	{
+		return (uint32_t)std::distance(view.begin(), view.end());
+	}
+
+	void LightHandler::initiate(ID3D12Device* pDevice, uint32_t maxFramesInFlight, GPUResourceManager& gpuResourceManager, const std::vector<DXMesh>& dxMeshes, const DXMeshBuffers& dxMeshBuffers, DescriptorHeapStore& descHeapStore, DescriptorHeapHandle shadowMapsDHH)
 	{
 		m_pDevice = pDevice;
 		m_pGpuResourceManager = &gpuResourceManager;
 		m_pDxMeshes = &dxMeshes;
+		m_pDxMeshBuffers = &dxMeshBuffers;
 		m_pDescriptorHeapStore = &descHeapStore;
+		m_shadowMapsDHH = shadowMapsDHH;
 
-		m_shadowMapsDHH = descHeapStore.createDescriptorHeap(maxFramesInFlight * (MAX_SHADOW_MAPS + MAX_POINT_SHADOW_CUBES), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, false);
+		m_pools.shadowMaps.resize(MAX_SHADOW_MAPS);
+		m_pools.shadowMapAllocator.initialize(MAX_SHADOW_MAPS, maxFramesInFlight);
+		m_pools.shadowMapCubePool.list.reserve(MAX_POINT_SHADOW_CUBES);
 
-		m_maxFramesInFlight = maxFramesInFlight;
-		m_currentFrame = maxFramesInFlight - 1;
-		m_frames.resize(maxFramesInFlight);
-		for (uint32_t i = 0; i < (uint32_t)m_frames.size(); i++)
-		{
-			FrameResources& frame = m_frames[i];
+		m_shadowBudgetSettings.maxShadowMaps = MAX_SHADOW_MAPS;
+		m_shadowBudgetSettings.maxShadowCubes = MAX_POINT_SHADOW_CUBES;
+		m_shadowBudgetSettings.maxTexels = SHADOW_TEXEL_BUDGET;
 
-			frame.shadowMapPool.list.reserve(MAX_SHADOW_MAPS);
-			frame.shadowMapCubePool.list.reserve(MAX_POINT_SHADOW_CUBES);
+		m_shadowCubeSchedulerSettings.maxFacesPerFrame = SHADOW_CUBE_FACES_PER_FRAME;
+		m_shadowCubeSchedulerSettings.fullRateDistance = SHADOW_CUBE_FULL_RATE_DISTANCE;
+		m_shadowCubeSchedulerSettings.slicedRateDistance = SHADOW_CUBE_SLICED_RATE_DISTANCE;
+		m_shadowCubeSchedulerSettings.updateInterval = SHADOW_CUBE_UPDATE_INTERVAL;
 
-			frame.shadowMapDescriptorsOffset = i * (MAX_SHADOW_MAPS + MAX_POINT_SHADOW_CUBES);
+		m_shadowQualityPreset = getShadowQualityPreset(DEFAULT_SHADOW_QUALITY);
+
+		// The full pools at their largest resolution, once & once per frame in flight like before they were shared
+		std::vector<D3D12_RESOURCE_DESC> poolDescs;
+		for (uint32_t i = 0; i < maxFramesInFlight; i++)
+		{
+			poolDescs.insert(poolDescs.end(), MAX_SHADOW_MAPS, createShadowMapDesc(MAX_SHADOW_MAP_RESOLUTION, 1));
+			poolDescs.insert(poolDescs.end(), MAX_POINT_SHADOW_CUBES, createShadowMapDesc(SHADOW_CUBE_RESOLUTION, 6));
 		}
 
-		m_srvIncrementSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		m_memoryReport.fullPoolsBytes = getAllocationSize(pDevice, poolDescs.data(), MAX_SHADOW_MAPS + MAX_POINT_SHADOW_CUBES);
+		m_memoryReport.perFrameFullPoolsBytes = getAllocationSize(pDevice, poolDescs.data(), (uint32_t)poolDescs.size());
 
 		createRenderPasses();
 	}
 
 	void LightHandler::shutdown()
 	{
+		for (ShadowMap& shadowMap : m_pools.shadowMaps)
+		{
+			D3D12_RELEASE(shadowMap.textureAllocation.pDXResource);
+		}
+
 		m_shadowPass.shutdown();
 		m_shadowPassPointLights.shutdown();
 	}
 	
 	D3D12_GPU_VIRTUAL_ADDRESS LightHandler::writePointLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, uint32_t* pOutNumPointLights)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
-
-		D3D12_GPU_VIRTUAL_ADDRESS gpuPointLightsGVA = ringBuffer.getCurrentGPUAddress();
-
-		static const glm::vec3 CUBE_MAP_DIRECTIONS[6] =
-		{
-			glm::vec3(-1.f, 0.f, 0.f),
-			glm::vec3(1.f, 0.f, 0.f),
+		Timer timer;
 
-			glm::vec3(0.f, -1.f, 0.f),
-			glm::vec3(0.f, 1.f, 0.f),
+		auto pointLightView = scene.getRegistry().view<PointLight, Transform>(entt::exclude<BakedLight>);
+		*pOutNumPointLights = countViewEntities(pointLightView);
 
-			glm::vec3(0.f, 0.f, -1.f),
-			glm::vec3(0.f, 0.f, 1.f),
-		};
-
-		auto pointLightView = scene.getRegistry().view<PointLight, Transform>();
-		*pOutNumPointLights = (uint32_t)pointLightView.size_hint();
+		m_pointLightCache.beginFrame(*pOutNumPointLights);
 
+		uint32_t lightIdx = 0;
 		for (entt::entity entity : pointLightView)
 		{
-			GPUPointLight* pGpuPointLight = (GPUPointLight*)ringBuffer.getMappedPtr();
-			ringBuffer.offsetMappedPtr(sizeof(GPUPointLight));
-
 			auto [pointLight, transform] = pointLightView[entity];
 
-			pGpuPointLight->colour = pointLight.colour;
-			pGpuPointLight->intensity = pointLight.intensity;
-			pGpuPointLight->attenuation = pointLight.attenuation;
-
-			pGpuPointLight->position = transform.position;
+			bool castsShadow = pointLight.shadowSource && m_shadowBudget.isGranted((uint64_t)entity);
+			PointLightInputs inputs = createPointLightInputs((uint32_t)entity, pointLight, transform, castsShadow);
 
-			if (!pointLight.shadowSource)
+			uint32_t recordIdx = lightIdx++;
+			if (m_pointLightCache.update(recordIdx, inputs))
 			{
-				pGpuPointLight->shadowMapIdx = INVALID_UINT32;
-				continue;
+				generatePointLightRecord(inputs, (float)POINT_LIGHT_RANGE, m_pointLightCache.getRecord(recordIdx), m_pointLightCache.getShadowData(recordIdx));
 			}
+		}
+
+		// Copy all records at once, the shadow map indices are patched afterwards since they can change without the light changing
+		D3D12_GPU_VIRTUAL_ADDRESS gpuPointLightsGVA = ringBuffer.getCurrentGPUAddress();
+		GPUPointLight* pGpuPointLights = (GPUPointLight*)ringBuffer.getMappedPtr();
 
-			pGpuPointLight->farPlane = 3000.f;
+		memcpy(pGpuPointLights, m_pointLightCache.getRecords(), sizeof(GPUPointLight) * m_pointLightCache.getNumRecords());
+		ringBuffer.offsetMappedPtr(sizeof(GPUPointLight) * m_pointLightCache.getNumRecords());
 
-			glm::mat4 projMatrix = glm::perspectiveFovLH_ZO(glm::half_pi<float>(), (float)SHADOW_MAPS_WIDTH, (float)SHADOW_MAPS_HEIGHT, 1.f, pGpuPointLight->farPlane);
-			glm::mat4 viewProjMatrices[6] = {};
-			for (uint32_t i = 0; i < 6; i++)
+		for (uint32_t i = 0; i < m_pointLightCache.getNumRecords(); i++)
+		{
+			const PointLightShadowData& shadowData = m_pointLightCache.getShadowData(i);
+			if (!shadowData.castsShadow)
 			{
-				glm::vec3 upVector = glm::vec3(0.f, 1.f, 0.f);
-				if (i == 2)
-				{
-					upVector = glm::vec3(0.f, 0.f, -1.f);
-				}
-				else if (i == 3)
-				{
-					upVector = glm::vec3(0.f, 0.f, 1.f);
-				}
+				continue;
+			}
 
+			GPUPointLight& gpuPointLight = pGpuPointLights[i];
+			trySetShadowMapData(commandContext, true, SHADOW_CUBE_RESOLUTION, shadowData.viewProjMatrices, gpuPointLight.position, gpuPointLight.farPlane, &gpuPointLight.shadowMapIdx, nullptr);
 
-				viewProjMatrices[i] = glm::transpose(projMatrix * glm::lookAt(transform.position, transform.position + CUBE_MAP_DIRECTIONS[i], upVector));
+			if (gpuPointLight.shadowMapIdx != INVALID_UINT32)
+			{
+				addShadowCubeRequest(m_pointLightCache.getInputs(i).entity, gpuPointLight.shadowMapIdx);
 			}
-
-			trySetShadowMapData(commandContext, frame.shadowMapCubePool, true, viewProjMatrices, transform.position, &pGpuPointLight->shadowMapIdx);
 		}
 
+		m_lightUpdateStats.numLights += m_pointLightCache.getNumRecords();
+		m_lightUpdateStats.numLightsRegenerated += m_pointLightCache.getNumRegenerated();
+		m_lightUpdateStats.updateTimeMs += timer.measure() * 1000.f;
+
 		ringBuffer.alignOffset();
 		return gpuPointLightsGVA;
 	}
 	
-	D3D12_GPU_VIRTUAL_ADDRESS LightHandler::writeDirLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, uint32_t* pOutNumDirLights)
+	D3D12_GPU_VIRTUAL_ADDRESS LightHandler::writeDirLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, float aspectRatio, uint32_t* pOutNumDirLights)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
+		Timer timer;
 
-		D3D12_GPU_VIRTUAL_ADDRESS gpuDirLightsGVA = ringBuffer.getCurrentGPUAddress();
+		auto dirLightView = scene.getRegistry().view<DirectionalLight, Transform>(entt::exclude<BakedLight>);
+		*pOutNumDirLights = countViewEntities(dirLightView);
+
+		const Entity camEntity = scene.getActiveCamera();
+		const Transform& camTransform = camEntity.getComponent<Transform>();
+		const Camera& cameraComp = camEntity.getComponent<Camera>();
 
-		auto dirLightView = scene.getRegistry().view<DirectionalLight, Transform>();
-		*pOutNumDirLights = (uint32_t)dirLightView.size_hint();
+		CascadeCamera cascadeCamera;
+		cascadeCamera.position = camTransform.position;
+		cascadeCamera.forward = camTransform.forwardVec();
+		cascadeCamera.fovY = glm::radians(cameraComp.fov);
+		cascadeCamera.aspectRatio = aspectRatio;
+		cascadeCamera.nearZ = cameraComp.nearZ;
+		cascadeCamera.farZ = glm::min(cameraComp.farZ, (float)DIR_LIGHT_SHADOW_DISTANCE);
 
-		const Transform& camTransform = scene.getActiveCamera().getComponent<Transform>();
+		// Same for all directional lights
+		float cascadeSplitFars[MAX_SHADOW_CASCADES] = {};
+		computeCascadeSplits(cascadeCamera.nearZ, cascadeCamera.farZ, DIR_LIGHT_NUM_CASCADES, DIR_LIGHT_CASCADE_SPLIT_LAMBDA, cascadeSplitFars);
 
+		m_dirLightCache.beginFrame(*pOutNumDirLights);
+
+		uint32_t lightIdx = 0;
 		for (entt::entity entity : dirLightView)
 		{
-			GPUDirectionalLight* pGpuDirLight = (GPUDirectionalLight*)ringBuffer.getMappedPtr();
-			ringBuffer.offsetMappedPtr(sizeof(GPUDirectionalLight));
-
 			auto [directionalLight, transform] = dirLightView[entity];
 
+			bool castsShadow = m_shadowBudget.isGranted((uint64_t)entity);
 
-			pGpuDirLight->colour = directionalLight.colour;
-			pGpuDirLight->intensity = directionalLight.intensity;
-
-			pGpuDirLight->direction = -transform.forwardVec();
-
-			float halfShadowWorldWidth = DIR_LIGHT_SHADOW_WORLD_WIDTH * 0.5f;
-			float halfShadowWorldHeight = DIR_LIGHT_SHADOW_WORLD_HEIGHT * 0.5f;
+			uint32_t resolution = castsShadow ? getShadowResolution((uint64_t)entity) : 0;
+			DirLightInputs inputs = createDirLightInputs((uint32_t)entity, directionalLight, transform, castsShadow, resolution, cascadeCamera, m_sceneBoundsMin, m_sceneBoundsMax);
 
-			// Snapping doesn't work ;_;
-
-			float texelWorldWidth = DIR_LIGHT_SHADOW_WORLD_WIDTH / (float)SHADOW_MAPS_WIDTH;
-			float texelWorldHeight = DIR_LIGHT_SHADOW_WORLD_HEIGHT / (float)SHADOW_MAPS_HEIGHT;
+			uint32_t recordIdx = lightIdx++;
+			if (m_dirLightCache.update(recordIdx, inputs))
+			{
+				generateDirLightRecord(inputs, DIR_LIGHT_NUM_CASCADES, cascadeSplitFars, m_dirLightCache.getRecord(recordIdx), m_dirLightCache.getShadowData(recordIdx));
+			}
+		}
 
-			glm::vec3 lightFocus = {};
-			lightFocus.x = float(glm::floor(camTransform.position.x / texelWorldWidth) * texelWorldWidth);
-			lightFocus.y = float(glm::floor(camTransform.position.y / texelWorldHeight) * texelWorldHeight);
-			lightFocus.z = float(glm::floor(camTransform.position.z / texelWorldWidth) * texelWorldWidth);
+		D3D12_GPU_VIRTUAL_ADDRESS gpuDirLightsGVA = ringBuffer.getCurrentGPUAddress();
+		GPUDirectionalLight* pGpuDirLights = (GPUDirectionalLight*)ringBuffer.getMappedPtr();
 
-			glm::vec3 lightOrigin = {};
-			lightOrigin.x = float(glm::floor((lightFocus.x + pGpuDirLight->direction.x * (float)DIR_LIGHT_RANGE * 0.5f) / texelWorldWidth) * texelWorldWidth);
-			lightOrigin.y = float(glm::floor((lightFocus.y + pGpuDirLight->direction.y * (float)DIR_LIGHT_RANGE * 0.5f) / texelWorldHeight) * texelWorldHeight);
-			lightOrigin.z = float(glm::floor((lightFocus.z + pGpuDirLight->direction.z * (float)DIR_LIGHT_RANGE * 0.5f) / texelWorldWidth) * texelWorldWidth);
+		memcpy(pGpuDirLights, m_dirLightCache.getRecords(), sizeof(GPUDirectionalLight) * m_dirLightCache.getNumRecords());
+		ringBuffer.offsetMappedPtr(sizeof(GPUDirectionalLight) * m_dirLightCache.getNumRecords());
 
-			pGpuDirLight->viewProjMatrix = glm::transpose(
-				glm::orthoLH_ZO(-halfShadowWorldWidth, halfShadowWorldWidth, -halfShadowWorldHeight, halfShadowWorldHeight, 1.f, (float)DIR_LIGHT_RANGE) *
-				glm::lookAtLH(lightOrigin, lightFocus, glm::vec3(0.f, 1.f, 0.f)));
+		for (uint32_t i = 0; i < m_dirLightCache.getNumRecords(); i++)
+		{
+			if (!m_dirLightCache.getShadowData(i).castsShadow)
+			{
+				continue;
+			}
 
-			// light pos not used for directional lights
-			trySetShadowMapData(commandContext, frame.shadowMapPool, false, &pGpuDirLight->viewProjMatrix, glm::vec3(0.f), &pGpuDirLight->shadowMapIdx);
+			GPUDirectionalLight& gpuDirLight = pGpuDirLights[i];
+			uint32_t resolution = m_dirLightCache.getInputs(i).resolution;
 
-			/*
-				Shadow map improvement techniques
-				https://learn.microsoft.com/en-us/windows/win32/dxtecharts/common-techniques-to-improve-shadow-depth-maps
+			for (uint32_t j = 0; j < gpuDirLight.numCascades; j++)
+			{
+				// light pos not used for directional lights
+				trySetShadowMapData(commandContext, false, resolution, &gpuDirLight.cascadeViewProjMatrices[j], glm::vec3(0.f), gpuDirLight.cascadeSplitFars[j], &gpuDirLight.cascadeShadowMapIndices[j], &gpuDirLight.cascadeUVScales[j]);
+			}
+		}
 
-				Frustum Culling (extracting frustum planes)
-				https://learnopengl.com/Guest-Articles/2021/Scene/Frustum-Culling
+		m_lightUpdateStats.numLights += m_dirLightCache.getNumRecords();
+		m_lightUpdateStats.numLightsRegenerated += m_dirLightCache.getNumRegenerated();
+		m_lightUpdateStats.updateTimeMs += timer.measure() * 1000.f;
 
-				// EXtracting frustum planes from matrix
-				https://www.reddit.com/r/gamedev/comments/xj47t/does_glm_support_frustum_plane_extraction/
-			*/
-		}
-		
 		ringBuffer.alignOffset();
 		return gpuDirLightsGVA;
 	}
 	
 	D3D12_GPU_VIRTUAL_ADDRESS LightHandler::writeSpotLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, uint32_t* pOutNumSpotLights)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
+		Timer timer;
 
-		D3D12_GPU_VIRTUAL_ADDRESS gpuSpotLightsGVA = ringBuffer.getCurrentGPUAddress();
+		auto spotLightView = scene.getRegistry().view<SpotLight, Transform>(entt::exclude<BakedLight>);
+		*pOutNumSpotLights = countViewEntities(spotLightView);
 
-		auto spotLightView = scene.getRegistry().view<SpotLight, Transform>();
-		*pOutNumSpotLights = (uint32_t)spotLightView.size_hint();
+		m_spotLightCache.beginFrame(*pOutNumSpotLights);
 
+		uint32_t lightIdx = 0;
 		for (entt::entity entity : spotLightView)
 		{
-			GPUSpotLight* pGpuSpotLight = (GPUSpotLight*)ringBuffer.getMappedPtr();
-			ringBuffer.offsetMappedPtr(sizeof(GPUSpotLight));
-
 			auto [spotLight, transform] = spotLightView[entity];
 
-			pGpuSpotLight->colour = spotLight.colour;
-			pGpuSpotLight->intensity = spotLight.intensity;
-			pGpuSpotLight->attenuation = spotLight.attenuation;
-			pGpuSpotLight->spreadCosAngle = glm::cos(glm::radians(spotLight.spreadAngle * 0.5f));
+			bool castsShadow = m_shadowBudget.isGranted((uint64_t)entity);
 
-			pGpuSpotLight->position = transform.position;
-			pGpuSpotLight->direction = transform.forwardVec();
+			uint32_t resolution = castsShadow ? getShadowResolution((uint64_t)entity) : 0;
+			SpotLightInputs inputs = createSpotLightInputs((uint32_t)entity, spotLight, transform, castsShadow, resolution);
+
+			uint32_t recordIdx = lightIdx++;
+			if (m_spotLightCache.update(recordIdx, inputs))
+			{
+				generateSpotLightRecord(inputs, (float)SPOT_LIGHT_RANGE, m_spotLightCache.getRecord(recordIdx), m_spotLightCache.getShadowData(recordIdx));
+			}
+		}
+
+		D3D12_GPU_VIRTUAL_ADDRESS gpuSpotLightsGVA = ringBuffer.getCurrentGPUAddress();
+		GPUSpotLight* pGpuSpotLights = (GPUSpotLight*)ringBuffer.getMappedPtr();
+
+		memcpy(pGpuSpotLights, m_spotLightCache.getRecords(), sizeof(GPUSpotLight) * m_spotLightCache.getNumRecords());
+		ringBuffer.offsetMappedPtr(sizeof(GPUSpotLight) * m_spotLightCache.getNumRecords());
+
+		for (uint32_t i = 0; i < m_spotLightCache.getNumRecords(); i++)
+		{
+			if (!m_spotLightCache.getShadowData(i).castsShadow)
+			{
+				continue;
+			}
 
-			pGpuSpotLight->viewProjMatrix = glm::transpose(
-				glm::perspectiveFovLH_ZO(glm::radians(spotLight.spreadAngle), (float)SHADOW_MAPS_WIDTH, (float)SHADOW_MAPS_HEIGHT, 1.f, 3000.f) *
-				transform.getViewMatrix());
+			GPUSpotLight& gpuSpotLight = pGpuSpotLights[i];
 
 			// light pos not used for spot lights
-			trySetShadowMapData(commandContext, frame.shadowMapPool, false, &pGpuSpotLight->viewProjMatrix, glm::vec3(0.f), &pGpuSpotLight->shadowMapIdx);
+			trySetShadowMapData(commandContext, false, m_spotLightCache.getInputs(i).resolution, &gpuSpotLight.viewProjMatrix, glm::vec3(0.f), (float)SPOT_LIGHT_RANGE, &gpuSpotLight.shadowMapIdx, &gpuSpotLight.shadowMapUVScale);
 		}
 
+		m_lightUpdateStats.numLights += m_spotLightCache.getNumRecords();
+		m_lightUpdateStats.numLightsRegenerated += m_spotLightCache.getNumRegenerated();
+		m_lightUpdateStats.updateTimeMs += timer.measure() * 1000.f;
+
 		ringBuffer.alignOffset();
 		return gpuSpotLightsGVA;
 	}
 	
-	void LightHandler::preDepthMapRender(CommandContext& commandContext)
+	uint32_t LightHandler::preDepthMapRender(CommandContext& commandContext)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
-
 		ID3D12GraphicsCommandList* pCommandList = commandContext.getCommandList();
 
-		for (uint32_t i = 0; i < frame.shadowMapPool.numActive; i++)
+		// Only the shadow maps whose cache key changed are transitioned, cleared & rendered, the rest keep their content
+		uint32_t numBarriers = 0;
+		for (uint32_t i = 0; i < (uint32_t)m_pools.shadowMaps.size(); i++)
 		{
-			frame.shadowMapBarriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-			frame.shadowMapBarriers[i].Transition.pResource = frame.shadowMapPool[i].textureAllocation.pDXResource;
-			frame.shadowMapBarriers[i].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-			frame.shadowMapBarriers[i].Transition.StateAfter = D3D12_RESOURCE_STATE_DEPTH_WRITE;
-			frame.shadowMapBarriers[i].Transition.Subresource = 0;
-			frame.shadowMapBarriers[i].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			if (m_pools.shadowMapAllocator.isActive(i) && m_pools.shadowMaps[i].needsRender)
+			{
+				fillShadowMapBarrier(m_pools.shadowMapBarriers[numBarriers++], m_pools.shadowMaps[i].textureAllocation.pDXResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+			}
 		}
-		for (uint32_t i = 0; i < frame.shadowMapCubePool.numActive; i++)
+		for (uint32_t i = 0; i < m_pools.shadowMapCubePool.numActive; i++)
 		{
-			uint32_t barrierIdx = i + frame.shadowMapPool.numActive;
-			frame.shadowMapBarriers[barrierIdx].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-			frame.shadowMapBarriers[barrierIdx].Transition.pResource = frame.shadowMapCubePool[i].textureAllocation.pDXResource;
-			frame.shadowMapBarriers[barrierIdx].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-			frame.shadowMapBarriers[barrierIdx].Transition.StateAfter = D3D12_RESOURCE_STATE_DEPTH_WRITE;
-			frame.shadowMapBarriers[barrierIdx].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-			frame.shadowMapBarriers[barrierIdx].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			if (m_pools.shadowMapCubePool[i].needsRender)
+			{
+				fillShadowMapBarrier(m_pools.shadowMapBarriers[numBarriers++], m_pools.shadowMapCubePool[i].textureAllocation.pDXResource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+			}
 		}
 
-		pCommandList->ResourceBarrier(frame.shadowMapPool.numActive + frame.shadowMapCubePool.numActive, frame.shadowMapBarriers);
+		if (!numBarriers)
+		{
+			return 0;
+		}
+
+		pCommandList->ResourceBarrier(numBarriers, m_pools.shadowMapBarriers);
 
-		for (uint32_t i = 0; i < frame.shadowMapPool.numActive; i++)
+		for (uint32_t i = 0; i < (uint32_t)m_pools.shadowMaps.size(); i++)
 		{
-			pCommandList->ClearDepthStencilView(frame.shadowMapPool[i].dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+			const ShadowMap& shadowMap = m_pools.shadowMaps[i];
+			if (m_pools.shadowMapAllocator.isActive(i) && shadowMap.needsRender)
+			{
+				// Only the rendered region is ever sampled
+				D3D12_RECT clearRect = createRect(shadowMap.resolution, shadowMap.resolution);
+				pCommandList->ClearDepthStencilView(shadowMap.dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 1, &clearRect);
+			}
 		}
-		for (uint32_t i = 0; i < frame.shadowMapCubePool.numActive; i++)
+		for (uint32_t i = 0; i < m_pools.shadowMapCubePool.numActive; i++)
 		{
-			pCommandList->ClearDepthStencilView(frame.shadowMapCubePool[i].dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+			const ShadowMap& shadowMapCube = m_pools.shadowMapCubePool[i];
+			if (!shadowMapCube.needsRender)
+			{
+				continue;
+			}
+
+			// Faces that aren't scheduled keep their content
+			uint32_t faceMask = m_shadowCubeScheduler.getFaceMask(i);
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				if (faceMask & (1 << face))
+				{
+					pCommandList->ClearDepthStencilView(shadowMapCube.faceDsvHandles[face], D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+				}
+			}
 		}
+
+		return numBarriers;
 	}
 
-	void LightHandler::drawDepthMap_Internal(CommandContext& commandContext, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups, const ShadowMap& shadowMap, uint32_t shadowBarrierIdx)
+	void LightHandler::drawDepthMap_Internal(CommandContext& commandContext, RingBuffer& ringBuffer, RenderPass& renderPass, const std::vector<uint32_t>& casterDrawGroups)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
+		// The draw indicies are the draw group indicies
+		m_depthDrawBuilder.buildCommands(casterDrawGroups.data(), (uint32_t)casterDrawGroups.size(), m_depthCommandList);
 
-		ID3D12GraphicsCommandList* pCommandList = commandContext.getCommandList();
+		m_shadowStats.numShadowDraws += m_depthCommandList.getNumCommands();
+		m_shadowStats.numShadowExecuteIndirects += renderPass.drawIndirect(commandContext.getCommandList(), ringBuffer, m_depthCommandList, m_pDxMeshBuffers->positionIndiciesViews);
+	}
+
+	void LightHandler::gatherShadowCasters(const Scene& scene, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups)
+	{
+		const entt::registry& registry = scene.getRegistry();
+
+		m_shadowCasters.clear();
+		m_sceneBoundsMin = glm::vec3(FLT_MAX);
+		m_sceneBoundsMax = glm::vec3(-FLT_MAX);
 
 		for (uint32_t i = 0; i < numActiveDrawGroups; i++)
 		{
 			const DrawGroup& drawGroup = drawGroups[i];
-
 			const DXMesh& dxMesh = (*m_pDxMeshes)[drawGroup.dxMeshId];
 
-			pCommandList->SetGraphicsRootShaderResourceView(1, dxMesh.gpuVerticiesGVA);
-			pCommandList->IASetIndexBuffer(&dxMesh.indiciesView);
+			for (entt::entity entity : drawGroup.entities)
+			{
+				ShadowCaster& caster = m_shadowCasters.emplace_back();
+				caster.meshID = drawGroup.dxMeshId;
+				caster.drawGroupIdx = i;
+				caster.lodIdx = SHADOW_CASTER_LOD;
+				caster.worldMatrix = registry.get<Transform>(entity).getMatrix();
+				caster.worldSphere = transformSphere(dxMesh.boundingSphere, caster.worldMatrix);
+
+				m_sceneBoundsMin = glm::min(m_sceneBoundsMin, glm::vec3(caster.worldSphere) - glm::vec3(caster.worldSphere.w));
+				m_sceneBoundsMax = glm::max(m_sceneBoundsMax, glm::vec3(caster.worldSphere) + glm::vec3(caster.worldSphere.w));
+			}
+		}
+
+		if (m_shadowCasters.empty())
+		{
+			m_sceneBoundsMin = glm::vec3(0.f);
+			m_sceneBoundsMax = glm::vec3(0.f);
+		}
+	}
+
+	void LightHandler::assignShadowBudget(const Scene& scene, float screenWidth, float screenHeight)
+	{
+		const entt::registry& registry = scene.getRegistry();
+
+		const Entity camEntity = scene.getActiveCamera();
+		const Transform& camTransform = camEntity.getComponent<Transform>();
+		const Camera& cameraComp = camEntity.getComponent<Camera>();
+
+		glm::mat4 camViewProjMatrix = cameraComp.getProjectionMatrix(screenWidth, screenHeight) * camTransform.getViewMatrix();
+		ShadowImportanceCamera importanceCamera = createShadowImportanceCamera(camTransform.position, camTransform.forwardVec(), glm::radians(cameraComp.fov), camViewProjMatrix);
+
+		const uint64_t shadowCubeTexels = (uint64_t)SHADOW_CUBE_RESOLUTION * SHADOW_CUBE_RESOLUTION * 6;
+
+		// Resolutions of lights that didn't request a shadow map this frame are dropped
+		std::swap(m_prevShadowResolutions, m_shadowResolutions);
+		m_shadowResolutions.clear();
+
+		auto selectResolution = [&](uint64_t lightKey, float projectedSize)
+		{
+			auto prevIt = m_prevShadowResolutions.find(lightKey);
+			uint32_t prevResolution = prevIt != m_prevShadowResolutions.end() ? prevIt->second : INVALID_UINT32;
+
+			uint32_t resolution = selectShadowMapResolution(projectedSize, m_shadowQualityPreset, prevResolution);
+			m_shadowResolutions[lightKey] = resolution;
+
+			return (uint64_t)resolution * resolution;
+		};
+
+		m_shadowBudget.beginFrame();
+		m_shadowCubePriorities.clear();
+
+		auto pointLightView = registry.view<PointLight, Transform>(entt::exclude<BakedLight>);
+		for (entt::entity entity : pointLightView)
+		{
+			auto [pointLight, transform] = pointLightView[entity];
+			if (!pointLight.shadowSource)
+			{
+				continue;
+			}
+
+			// Point lights use 1 / (1 + x + y * d^2), fold the constant x into the intensity
+			float intensity = pointLight.intensity / (1.f + pointLight.attenuation.x);
+			glm::vec2 attenuation = glm::vec2(0.f, pointLight.attenuation.y / (1.f + pointLight.attenuation.x));
+
+			float radius = computeLightInfluenceRadius(intensity, attenuation, SHADOW_MIN_LIGHT_CONTRIBUTION, (float)POINT_LIGHT_RANGE);
+			float importance = computeLocalLightImportance(importanceCamera, m_shadowBudgetSettings, transform.position, radius, intensity);
+
+			ShadowCubePriority& cubePriority = m_shadowCubePriorities[(uint64_t)entity];
+			cubePriority.importance = importance;
+			cubePriority.cameraDistance = glm::max(glm::length(transform.position - camTransform.position) - radius, 0.f);
+
+			m_shadowBudget.addRequest((uint64_t)entity, importance, 0, 1, shadowCubeTexels);
+		}
+
+		auto spotLightView = registry.view<SpotLight, Transform>(entt::exclude<BakedLight>);
+		for (entt::entity entity : spotLightView)
+		{
+			auto [spotLight, transform] = spotLightView[entity];
+
+			float radius = computeLightInfluenceRadius(spotLight.intensity, spotLight.attenuation, SHADOW_MIN_LIGHT_CONTRIBUTION, (float)SPOT_LIGHT_RANGE);
+			float importance = computeLocalLightImportance(importanceCamera, m_shadowBudgetSettings, transform.position, radius, spotLight.intensity);
+
+			float projectedSize = computeProjectedLightSize(importanceCamera, transform.position, radius, screenHeight);
+			uint64_t shadowMapTexels = selectResolution((uint64_t)entity, projectedSize);
+
+			m_shadowBudget.addRequest((uint64_t)entity, importance, 1, 0, shadowMapTexels);
+		}
+
+		auto dirLightView = registry.view<DirectionalLight>(entt::exclude<BakedLight>);
+		for (entt::entity entity : dirLightView)
+		{
+			const DirectionalLight& directionalLight = dirLightView.get<DirectionalLight>(entity);
+
+			float importance = computeDirectionalLightImportance(directionalLight.intensity);
 
-			pCommandList->SetGraphicsRootShaderResourceView(2, drawGroup.objectDatasVA);
+			// Every cascade covers roughly the whole screen
+			uint64_t shadowMapTexels = selectResolution((uint64_t)entity, screenHeight);
 
-			pCommandList->DrawIndexedInstanced(dxMesh.numIndicies, (uint32_t)drawGroup.entities.size(), 0, 0, 0);
+			m_shadowBudget.addRequest((uint64_t)entity, importance, DIR_LIGHT_NUM_CASCADES, 0, shadowMapTexels * DIR_LIGHT_NUM_CASCADES);
 		}
 
-		frame.shadowMapBarriers[shadowBarrierIdx].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		frame.shadowMapBarriers[shadowBarrierIdx].Transition.pResource = shadowMap.textureAllocation.pDXResource;
-		frame.shadowMapBarriers[shadowBarrierIdx].Transition.StateBefore = D3D12_RESOURCE_STATE_DEPTH_WRITE;
-		frame.shadowMapBarriers[shadowBarrierIdx].Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-		frame.shadowMapBarriers[shadowBarrierIdx].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-		frame.shadowMapBarriers[shadowBarrierIdx].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		m_shadowBudget.allocate(m_shadowBudgetSettings);
 	}
 
-	void LightHandler::drawDepthMaps(CommandContext& commandContext, RingBuffer& ringBuffer, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups)
+	void LightHandler::drawDepthMaps(CommandContext& commandContext, RingBuffer& ringBuffer, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups, D3D12_GPU_VIRTUAL_ADDRESS objectDatasGVA)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
+		m_shadowStats = {};
+		m_shadowStats.numShadowCubes = m_pools.shadowMapCubePool.numActive;
+
+		const ShadowBudget::Stats& budgetStats = m_shadowBudget.getStats();
+		m_shadowStats.numShadowLightsRequested = budgetStats.numRequests;
+		m_shadowStats.numShadowLightsGranted = budgetStats.numGranted;
+		m_shadowStats.numShadowTexelsGranted = budgetStats.numTexelsGranted;
+
+		for (uint32_t i = 0; i < (uint32_t)m_pools.shadowMaps.size(); i++)
+		{
+			if (!m_pools.shadowMapAllocator.isActive(i))
+			{
+				continue;
+			}
+
+			uint32_t resolution = m_pools.shadowMaps[i].resolution;
+
+			m_shadowStats.numShadowMaps++;
+			m_shadowStats.shadowMapResolutions.emplace_back(resolution);
+			m_shadowStats.numShadowTexels += (uint64_t)resolution * resolution;
+		}
+		m_shadowStats.numShadowTexels += (uint64_t)m_pools.shadowMapCubePool.numActive * SHADOW_CUBE_RESOLUTION * SHADOW_CUBE_RESOLUTION * 6;
+
+		m_shadowCubeScheduler.schedule(m_shadowCubeSchedulerSettings);
+		for (uint32_t i = 0; i < m_pools.shadowMapCubePool.numActive; i++)
+		{
+			m_pools.shadowMapCubePool[i].needsRender = m_shadowCubeScheduler.getFaceMask(i) != 0;
+		}
 
-		preDepthMapRender(commandContext);
+		const ShadowCubeScheduler::Stats& cubeSchedulerStats = m_shadowCubeScheduler.getStats();
+		m_shadowStats.numShadowCubeFullUpdates = cubeSchedulerStats.numFullUpdates;
+		m_shadowStats.numShadowCubeFacesRendered = cubeSchedulerStats.numFacesRendered;
+		m_shadowStats.numShadowCubeFacesDeferred = cubeSchedulerStats.numFacesDeferred;
+
+		uint32_t numBarriers = preDepthMapRender(commandContext);
+		if (!numBarriers)
+		{
+			return;
+		}
+
+		// Same as the main draws but with the position stream & the shadow LOD, the draw group's LOD follows the camera
+		m_depthDrawBuilder.reset();
+		for (uint32_t i = 0; i < numActiveDrawGroups; i++)
+		{
+			const DrawGroup& drawGroup = drawGroups[i];
+			const DXMesh& dxMesh = (*m_pDxMeshes)[drawGroup.dxMeshId];
+			const DXMeshLOD& dxLOD = dxMesh.lods[SHADOW_CASTER_LOD];
+
+			IndirectDrawDesc drawDesc;
+			drawDesc.indexPool = dxMesh.positionIndexPool;
+			drawDesc.firstIndex = dxMesh.firstPositionIndex + dxLOD.firstIndex;
+			drawDesc.numIndicies = dxLOD.numIndicies;
+			drawDesc.baseVertex = dxMesh.basePosition;
+			drawDesc.firstObject = drawGroup.firstObject;
+			drawDesc.numInstances = (uint32_t)drawGroup.entities.size();
+			drawDesc.quantization = dxMesh.quantization;
+
+			m_depthDrawBuilder.addDraw(drawDesc);
+		}
+
+		const std::vector<IndirectDrawData>& drawDatas = m_depthDrawBuilder.getDrawDatas();
+		D3D12_GPU_VIRTUAL_ADDRESS drawDatasGVA = ringBuffer.allocateMapped(drawDatas.data(), drawDatas.size() * sizeof(IndirectDrawData));
+
+		// Both passes share the root signature layout, the buffers are set once per pass
+		auto bindDepthPass = [&](RenderPass& renderPass)
+		{
+			ID3D12GraphicsCommandList* pCommandList = commandContext.getCommandList();
+
+			renderPass.bindBase(pCommandList);
+			pCommandList->SetGraphicsRootShaderResourceView(1, m_pDxMeshBuffers->positionsGVA);
+			pCommandList->SetGraphicsRootShaderResourceView(2, objectDatasGVA);
+			pCommandList->SetGraphicsRootShaderResourceView(4, drawDatasGVA);
+		};
 
 		ID3D12GraphicsCommandList* pCommandList = commandContext.getCommandList();
-		m_shadowPass.bindBase(pCommandList);
+		bindDepthPass(m_shadowPass);
 
-		for (uint32_t i = 0; i < frame.shadowMapPool.numActive; i++)
+		for (uint32_t i = 0; i < (uint32_t)m_pools.shadowMaps.size(); i++)
 		{
-			const ShadowMap& shadowMap = frame.shadowMapPool[i];
+			ShadowMap& shadowMap = m_pools.shadowMaps[i];
+			if (!m_pools.shadowMapAllocator.isActive(i) || !shadowMap.needsRender)
+			{
+				continue;
+			}
 
 			D3D12_GPU_VIRTUAL_ADDRESS lightCamBuffer = ringBuffer.allocateMapped(shadowMap.viewProjMatrices, sizeof(glm::mat4));
 			pCommandList->SetGraphicsRootConstantBufferView(0, lightCamBuffer);
 
+			m_shadowPass.updateViewport(createViewport((float)shadowMap.resolution, (float)shadowMap.resolution), createRect(shadowMap.resolution, shadowMap.resolution));
 			m_shadowPass.bindRTVs(pCommandList, 0, nullptr, &shadowMap.dsvHandle, 1);
-			drawDepthMap_Internal(commandContext, drawGroups, numActiveDrawGroups, shadowMap, i);
+			drawDepthMap_Internal(commandContext, ringBuffer, m_shadowPass, shadowMap.casterDrawGroups);
+
+			shadowMap.needsRender = false;
+			m_shadowStats.numShadowMapsRendered++;
 		}
 
 
-		m_shadowPassPointLights.bindBase(pCommandList);
+		bindDepthPass(m_shadowPassPointLights);
 
-		for (uint32_t i = 0; i < frame.shadowMapCubePool.numActive; i++)
+		for (uint32_t i = 0; i < m_pools.shadowMapCubePool.numActive; i++)
 		{
-			const ShadowMap& shadowMapCube = frame.shadowMapCubePool[i];
-
-			D3D12_GPU_VIRTUAL_ADDRESS lightCamBuffer = ringBuffer.getCurrentGPUAddress();
+			ShadowMap& shadowMapCube = m_pools.shadowMapCubePool[i];
+			if (!shadowMapCube.needsRender)
+			{
+				continue;
+			}
 
-			GPUShadowMapCubeData* pShadowMapData = (GPUShadowMapCubeData*)ringBuffer.getMappedPtr();
-			memcpy(pShadowMapData->matrices, shadowMapCube.viewProjMatrices, sizeof(glm::mat4) * 6);
-			pShadowMapData->lightPos = shadowMapCube.lightPos;
-			pShadowMapData->farPlane = 3000.f;
+			GPUShadowMapCubeData shadowMapData = {};
+			memcpy(shadowMapData.matrices, shadowMapCube.viewProjMatrices, sizeof(glm::mat4) * 6);
+			shadowMapData.lightPos = shadowMapCube.lightPos;
+			shadowMapData.farPlane = shadowMapCube.farPlane;
+			shadowMapData.faceMask = m_shadowCubeScheduler.getFaceMask(i);
 
+			D3D12_GPU_VIRTUAL_ADDRESS lightCamBuffer = ringBuffer.allocateMapped(&shadowMapData, sizeof(GPUShadowMapCubeData));
 			pCommandList->SetGraphicsRootConstantBufferView(0, lightCamBuffer);
 
 			m_shadowPassPointLights.bindRTVs(pCommandList, 0, nullptr, &shadowMapCube.dsvHandle, 6);
-			drawDepthMap_Internal(commandContext, drawGroups, numActiveDrawGroups, shadowMapCube, i + frame.shadowMapPool.numActive);
-		}
-
-		pCommandList->ResourceBarrier(frame.shadowMapPool.numActive + frame.shadowMapCubePool.numActive, frame.shadowMapBarriers);
-	}
+			drawDepthMap_Internal(commandContext, ringBuffer, m_shadowPassPointLights, shadowMapCube.casterDrawGroups);
 
-	D3D12_CPU_DESCRIPTOR_HANDLE LightHandler::getFrameShadowMapSRVCPUHandle()
-	{
-		FrameResources& frame = m_frames[m_currentFrame];
-		ID3D12DescriptorHeap* pDXDescriptorHeap = m_pDescriptorHeapStore->getDXDescriptorHeap(m_shadowMapsDHH);
+			shadowMapCube.needsRender = false;
+			m_shadowStats.numShadowCubesRendered++;
+		}
 
-		D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = pDXDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-		cpuHandle.ptr += (uint64_t)frame.shadowMapDescriptorsOffset * m_srvIncrementSize;
+		for (uint32_t i = 0; i < numBarriers; i++)
+		{
+			std::swap(m_pools.shadowMapBarriers[i].Transition.StateBefore, m_pools.shadowMapBarriers[i].Transition.StateAfter);
+		}
 
-		return cpuHandle;
+		pCommandList->ResourceBarrier(numBarriers, m_pools.shadowMapBarriers);
 	}
 
 	void LightHandler::newFrame()
 	{
-		m_currentFrame = (m_currentFrame + 1) % m_maxFramesInFlight;
+		m_pools.shadowMapAllocator.beginFrame();
+		m_pools.shadowMapCubePool.numActive = 0;
 
-		m_frames[m_currentFrame].shadowMapPool.numActive = 0;
-		m_frames[m_currentFrame].shadowMapCubePool.numActive = 0;
+		m_lightUpdateStats = LightUpdateStats();
+		m_shadowCubeScheduler.beginFrame();
 	}
 
-	void LightHandler::trySetShadowMapData(CommandContext& commandContext, ActiveVector<ShadowMap>& shadowMaps, bool isCubeMap, glm::mat4* pViewProjMatrices, glm::vec3 lightPos, uint32_t* pOutShadowMapIdx)
+	void LightHandler::trySetShadowMapData(CommandContext& commandContext, bool isCubeMap, uint32_t resolution, const glm::mat4* pViewProjMatrices, glm::vec3 lightPos, float farPlane, uint32_t* pOutShadowMapIdx, float* pOutUVScale)
 	{
-		if (shadowMaps.numActive >= shadowMaps.list.capacity())
-		{
-			*pOutShadowMapIdx = INVALID_UINT32;
-			return;
-		}
-
 		ShadowMap* pShadowMap = nullptr;
-		if (shadowMaps.numActive >= shadowMaps.list.size())
+
+		if (isCubeMap)
 		{
-			pShadowMap = &createShadowMap(commandContext, shadowMaps, isCubeMap, SHADOW_MAPS_WIDTH, SHADOW_MAPS_HEIGHT);
+			ActiveVector<ShadowMap>& shadowMapCubes = m_pools.shadowMapCubePool;
+			if (shadowMapCubes.numActive >= MAX_POINT_SHADOW_CUBES)
+			{
+				*pOutShadowMapIdx = INVALID_UINT32;
+				return;
+			}
+
+			if (shadowMapCubes.numActive >= shadowMapCubes.list.size())
+			{
+				createShadowMap(commandContext, shadowMapCubes.list.emplace_back(), shadowMapCubes.numActive, true, SHADOW_CUBE_RESOLUTION);
+			}
+
+			*pOutShadowMapIdx = shadowMapCubes.numActive++;
+			pShadowMap = &shadowMapCubes[*pOutShadowMapIdx];
 		}
 		else
 		{
-			pShadowMap = &shadowMaps.list[shadowMaps.numActive];
+			bool needsTexture = false;
+			*pOutShadowMapIdx = m_pools.shadowMapAllocator.allocate(resolution, &needsTexture);
+
+			if (*pOutShadowMapIdx == INVALID_UINT32)
+			{
+				return;
+			}
+
+			pShadowMap = &m_pools.shadowMaps[*pOutShadowMapIdx];
+			if (needsTexture)
+			{
+				createShadowMap(commandContext, *pShadowMap, *pOutShadowMapIdx, false, resolution);
+			}
+
+			*pOutUVScale = resolution / (float)pShadowMap->textureResolution;
+		}
+
+		OKAY_ASSERT(resolution <= pShadowMap->textureResolution);
+
+		uint32_t numMatrices = isCubeMap ? 6 : 1;
+
+		// The content of the region is useless at a different resolution
+		if (pShadowMap->resolution != resolution)
+		{
+			pShadowMap->resolution = resolution;
+			pShadowMap->needsRender = true;
 		}
 
 		pShadowMap->lightPos = lightPos;
-		memcpy(pShadowMap->viewProjMatrices, pViewProjMatrices, sizeof(pShadowMap->viewProjMatrices));
+		pShadowMap->farPlane = farPlane;
+		memcpy(pShadowMap->viewProjMatrices, pViewProjMatrices, sizeof(glm::mat4) * numMatrices);
 
-		*pOutShadowMapIdx = shadowMaps.numActive++;
+		// Shadow cubes are invalidated face by face, see addShadowCubeRequest
+		if (!isCubeMap)
+		{
+			uint64_t cacheKey = computeShadowMapKey(glm::transpose(pShadowMap->viewProjMatrices[0]), m_shadowCasters, &pShadowMap->casterDrawGroups);
+			pShadowMap->needsRender |= updateShadowCacheKey(pShadowMap->cacheKey, cacheKey);
+		}
 	}
 	
-	ShadowMap& LightHandler::createShadowMap(CommandContext& commandContext, ActiveVector<ShadowMap>& shadowMaps, bool isCubeMap, uint32_t width, uint32_t height)
+	void LightHandler::addShadowCubeRequest(uint32_t lightEntity, uint32_t shadowMapIdx)
 	{
-		FrameResources& frame = m_frames[m_currentFrame];
+		ShadowMap& shadowMapCube = m_pools.shadowMapCubePool[shadowMapIdx];
 
-		ShadowMap& shadowMap = shadowMaps.list.emplace_back();
+		ShadowCubeRequest request;
+		request.slot = shadowMapIdx;
 
-		TextureDescription shadowMapDesc = {};
-		shadowMapDesc.width = width;
-		shadowMapDesc.height = height;
-		shadowMapDesc.mipLevels = 1;
-		shadowMapDesc.arraySize = isCubeMap ? 6 : 1;
-		shadowMapDesc.format = DXGI_FORMAT_R32_TYPELESS;
-		shadowMapDesc.flags = OKAY_TEXTURE_FLAG_DEPTH | OKAY_TEXTURE_FLAG_SHADER_READ;
+		auto priorityIt = m_shadowCubePriorities.find((uint64_t)lightEntity);
+		if (priorityIt != m_shadowCubePriorities.end())
+		{
+			request.priority = priorityIt->second;
+		}
 
-		shadowMap.textureAllocation = m_pGpuResourceManager->createTexture(shadowMapDesc, nullptr, nullptr);
-		ID3D12Resource* pDXTexture = shadowMap.textureAllocation.pDXResource;
+		Hasher lightHasher;
+		lightHasher.addValue(lightEntity);
+		lightHasher.addValue(shadowMapCube.lightPos);
+		lightHasher.addValue(shadowMapCube.farPlane);
+		request.lightKey = lightHasher.get();
+
+		glm::mat4 viewProjMatrices[6] = {};
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			viewProjMatrices[i] = glm::transpose(shadowMapCube.viewProjMatrices[i]);
+		}
+
+		computeShadowCubeFaceKeys(viewProjMatrices, shadowMapCube.lightPos, shadowMapCube.farPlane, m_shadowCasters, request.faceKeys, &shadowMapCube.casterDrawGroups);
+
+		m_shadowCubeScheduler.addRequest(request);
+	}
+
+	void LightHandler::createShadowMap(CommandContext& commandContext, ShadowMap& shadowMap, uint32_t slotIdx, bool isCubeMap, uint32_t resolution)
+	{
+		ID3D12Resource* pDXTexture = nullptr;
+		if (isCubeMap)
+		{
+			TextureDescription shadowMapDesc = {};
+			shadowMapDesc.width = resolution;
+			shadowMapDesc.height = resolution;
+			shadowMapDesc.mipLevels = 1;
+			shadowMapDesc.arraySize = 6;
+			shadowMapDesc.format = DXGI_FORMAT_R32_TYPELESS;
+			shadowMapDesc.flags = OKAY_TEXTURE_FLAG_DEPTH | OKAY_TEXTURE_FLAG_SHADER_READ;
+
+			shadowMap.textureAllocation = m_pGpuResourceManager->createTexture(shadowMapDesc, nullptr, nullptr);
+			pDXTexture = shadowMap.textureAllocation.pDXResource;
+		}
+		else
+		{
+			// ShadowMapAllocator only hands out slots for new textures once no frame in flight can use the old one
+			if (shadowMap.textureAllocation.pDXResource)
+			{
+				m_memoryReport.allocatedBytes -= getAllocationSize(m_pDevice, shadowMap.textureAllocation.pDXResource);
+
+				D3D12_RELEASE(shadowMap.textureAllocation.pDXResource);
+			}
+
+			// 2D maps are committed since they're released when their slot changes resolution
+			pDXTexture = createCommittedShadowMap(m_pDevice, resolution);
+			shadowMap.textureAllocation = Allocation();
+			shadowMap.textureAllocation.pDXResource = pDXTexture;
+		}
+
+		shadowMap.textureResolution = resolution;
+
+		// Whatever was in the slot before is gone
+		shadowMap.resolution = INVALID_UINT32;
+		shadowMap.cacheKey = INVALID_UINT64;
+
+		m_memoryReport.allocatedBytes += getAllocationSize(m_pDevice, pDXTexture);
 
 		DescriptorDesc srvDesc = {};
 		srvDesc.type = OKAY_DESCRIPTOR_TYPE_SRV;
@@ -453,13 +798,49 @@ namespace Okay
 			dsvDesc.dsvDesc.Texture2D.MipSlice = 0;
 		}
 
-		uint32_t srvDescriptorOffset = frame.shadowMapDescriptorsOffset + (isCubeMap ? MAX_SHADOW_MAPS : 0);
-		shadowMap.srvHandle = m_pDescriptorHeapStore->allocateDescriptors(m_shadowMapsDHH, srvDescriptorOffset + (uint32_t)shadowMaps.list.size() - 1, &srvDesc, 1).gpuHandle;
+		uint32_t srvDescriptorOffset = isCubeMap ? MAX_SHADOW_MAPS : 0;
+		shadowMap.srvHandle = m_pDescriptorHeapStore->allocateDescriptors(m_shadowMapsDHH, srvDescriptorOffset + slotIdx, &srvDesc, 1).gpuHandle;
 
-		shadowMap.dsvHandle = m_pDescriptorHeapStore->allocateCommittedDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, &dsvDesc, 1).cpuHandle;
+		if (!isCubeMap)
+		{
+			// A recreated map keeps its DSV slot
+			if (shadowMap.dsvHandle.ptr)
+			{
+				m_pDevice->CreateDepthStencilView(pDXTexture, &dsvDesc.dsvDesc, shadowMap.dsvHandle);
+			}
+			else
+			{
+				shadowMap.dsvHandle = m_pDescriptorHeapStore->allocateCommittedDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, &dsvDesc, 1).cpuHandle;
+			}
+		}
+		else
+		{
+			// The whole cube for rendering, followed by one DSV per face so single faces can be cleared
+			DescriptorDesc cubeDsvDescs[7] = { dsvDesc, dsvDesc, dsvDesc, dsvDesc, dsvDesc, dsvDesc, dsvDesc };
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				cubeDsvDescs[i + 1].dsvDesc.Texture2DArray.FirstArraySlice = i;
+				cubeDsvDescs[i + 1].dsvDesc.Texture2DArray.ArraySize = 1;
+			}
+
+			shadowMap.dsvHandle = m_pDescriptorHeapStore->allocateCommittedDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, cubeDsvDescs, 7).cpuHandle;
+
+			uint32_t dsvIncrementSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				shadowMap.faceDsvHandles[i].ptr = shadowMap.dsvHandle.ptr + (i + 1) * (SIZE_T)dsvIncrementSize;
+			}
+		}
 
 		commandContext.transitionResource(pDXTexture, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-		return shadowMap;
+	}
+
+	uint32_t LightHandler::getShadowResolution(uint64_t lightKey) const
+	{
+		auto it = m_shadowResolutions.find(lightKey);
+		OKAY_ASSERT(it != m_shadowResolutions.end());
+
+		return it->second;
 	}
 
 	void LightHandler::createRenderPasses()
@@ -471,8 +852,10 @@ namespace Okay
 		std::vector<D3D12_ROOT_PARAMETER> rootParams;
 
 		rootParams.emplace_back(createRootParamCBV(D3D12_SHADER_VISIBILITY_ALL, 0, 0)); // Light Data
-		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_ALL, 0, 0)); // Verticies SRV
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_ALL, 0, 0)); // Positions of every mesh (DXMeshBuffers::positionsGVA)
 		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_ALL, 1, 0)); // Object datas (GPUObjcetData)
+		rootParams.emplace_back(createRootParamConstants(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0, 1)); // Draw index, written by the indirect commands
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 9, 0)); // Draw datas (IndirectDrawData)
 
 		D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
 		rootSignatureDesc.NumParameters = (uint32_t)rootParams.size();
@@ -484,9 +867,11 @@ namespace Okay
 		pipelineDesc.VS = compileShader(SHADER_PATH / "ShadowVS.hlsl", "vs_5_1", &shaderBlobs[nextBlobIdx++]);
 
 		m_shadowPass.initialize(m_pDevice, pipelineDesc, rootSignatureDesc);
+		m_shadowPass.createDrawCommandSignature(m_pDevice, 3);
 
-		D3D12_VIEWPORT shadowViewport = createViewport((float)SHADOW_MAPS_WIDTH, (float)SHADOW_MAPS_HEIGHT);
-		D3D12_RECT shadowScissorRect = createRect(SHADOW_MAPS_WIDTH, SHADOW_MAPS_HEIGHT);
+		// The 2D shadow pass gets its viewport per shadow map
+		D3D12_VIEWPORT shadowViewport = createViewport((float)SHADOW_CUBE_RESOLUTION, (float)SHADOW_CUBE_RESOLUTION);
+		D3D12_RECT shadowScissorRect = createRect(SHADOW_CUBE_RESOLUTION, SHADOW_CUBE_RESOLUTION);
 		m_shadowPass.updateProperties(shadowViewport, shadowScissorRect, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 		nextBlobIdx = 0;
@@ -503,6 +888,7 @@ namespace Okay
 		pipelineDesc.PS = compileShader(SHADER_PATH / "ShadowCubePS.hlsl", "ps_5_1", &shaderBlobs[nextBlobIdx++]);
 
 		m_shadowPassPointLights.initialize(m_pDevice, pipelineDesc, rootSignatureDesc);
+		m_shadowPassPointLights.createDrawCommandSignature(m_pDevice, 3);
 		m_shadowPassPointLights.updateProperties(shadowViewport, shadowScissorRect, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 		nextBlobIdx = 0;
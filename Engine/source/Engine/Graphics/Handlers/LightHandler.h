@@ -5,56 +5,139 @@
 #include "Engine/Graphics/RenderPass.h"
 #include "Engine/Misc/ActiveVector.h"
 #include "Engine/Scene/Scene.h"
+#include "ShadowCache.h"
+#include "ShadowCascades.h"
+#include "ShadowBudget.h"
+#include "ShadowMapAllocator.h"
+#include "ShadowCubeScheduler.h"
+#include "LightRecordCache.h"
+#include "LightRecords.h"
+#include "Engine/Application/Time.h"
+
+#include <unordered_map>
 
 namespace Okay
 {
 	class LightHandler
 	{
 	public:
-		static const uint32_t SHADOW_MAPS_WIDTH = 2048;
-		static const uint32_t SHADOW_MAPS_HEIGHT = 2048;
+		// 2D shadow maps pick their resolution per light (see ShadowBudget.h), point lights keep a fixed one
+		static const ShadowQuality DEFAULT_SHADOW_QUALITY = OKAY_SHADOW_QUALITY_MEDIUM;
+		static const uint32_t SHADOW_CUBE_RESOLUTION = 2048;
 
-		// TODO: Fix lightMaps for frameInFlight, create copies or take from pool? :spinthink:
 		static const uint32_t MAX_SHADOW_MAPS = 32;
 		static const uint32_t MAX_POINT_SHADOW_CUBES = 8;
 
-		static const uint32_t DIR_LIGHT_RANGE = 10000;
-		static const uint32_t DIR_LIGHT_SHADOW_WORLD_WIDTH = 4000;
-		static const uint32_t DIR_LIGHT_SHADOW_WORLD_HEIGHT = 4000;
+		static const uint32_t DIR_LIGHT_NUM_CASCADES = 3; // 1 - MAX_SHADOW_CASCADES
+		static const uint32_t DIR_LIGHT_SHADOW_DISTANCE = 4000; // View depth covered by the cascades
+		static constexpr float DIR_LIGHT_CASCADE_SPLIT_LAMBDA = 0.75f;
+
+		static const uint32_t POINT_LIGHT_RANGE = 3000;
+		static const uint32_t SPOT_LIGHT_RANGE = 3000;
+
+		// Total shadow map texels granted per frame, a cube counts all 6 faces
+		static const uint64_t SHADOW_TEXEL_BUDGET = 32ull * 2048 * 2048;
+		static constexpr float SHADOW_MIN_LIGHT_CONTRIBUTION = 0.01f; // Used to find the radius of local lights when scoring them
+
+		// Shadow cube faces rendered per frame, distant point lights update theirs at reduced rates (see ShadowCubeScheduler.h)
+		static const uint32_t SHADOW_CUBE_FACES_PER_FRAME = 24;
+		static constexpr float SHADOW_CUBE_FULL_RATE_DISTANCE = 500.f;
+		static constexpr float SHADOW_CUBE_SLICED_RATE_DISTANCE = 1500.f;
+		static const uint32_t SHADOW_CUBE_UPDATE_INTERVAL = 4;
 
-		struct FrameResources
+		struct ShadowStats
 		{
-			ActiveVector<ShadowMap> shadowMapPool;
-			ActiveVector<ShadowMap> shadowMapCubePool;
+			uint32_t numShadowMaps = 0;
+			uint32_t numShadowMapsRendered = 0;
+
+			uint32_t numShadowCubes = 0;
+			uint32_t numShadowCubesRendered = 0;
+			uint32_t numShadowCubeFullUpdates = 0;
+			uint32_t numShadowCubeFacesRendered = 0;
+			uint32_t numShadowCubeFacesDeferred = 0;
+
+			uint32_t numShadowLightsRequested = 0;
+			uint32_t numShadowLightsGranted = 0;
+			uint64_t numShadowTexelsGranted = 0;
+
+			std::vector<uint32_t> shadowMapResolutions;
+			uint64_t numShadowTexels = 0; // Rendered regions of all active shadow maps & cubes
 
-			uint32_t shadowMapDescriptorsOffset = INVALID_UINT32;
+			uint32_t numShadowDraws = 0;
+			uint32_t numShadowExecuteIndirects = 0;
+		};
+
+		/*
+			The shadow maps are shared by all frames in flight instead of having a pool per frame.
+			All frames are executed on the same direct queue, so the GPU finishes reading a shadow map in frame N
+			before frame N+1 transitions it to DEPTH_WRITE. The CPU side only touches the maps' metadata & descriptors,
+			and a 2D map only gets a new texture (and descriptors) once no frame in flight can reference it, see ShadowMapAllocator.h.
+		*/
+		struct ShadowMapPools
+		{
+			std::vector<ShadowMap> shadowMaps; // One per slot of shadowMapAllocator, created at the resolution of their first light
+			ShadowMapAllocator shadowMapAllocator;
+
+			ActiveVector<ShadowMap> shadowMapCubePool;
 
 			D3D12_RESOURCE_BARRIER shadowMapBarriers[MAX_SHADOW_MAPS + MAX_POINT_SHADOW_CUBES] = {};
 		};
 
+		struct ShadowMemoryReport
+		{
+			uint64_t allocatedBytes = 0; // Maps & cubes currently alive, as placed in their heaps
+
+			// MAX_SHADOW_MAPS maps at MAX_SHADOW_MAP_RESOLUTION & MAX_POINT_SHADOW_CUBES cubes, queried from the device at initiate
+			uint64_t fullPoolsBytes = 0;
+			uint64_t perFrameFullPoolsBytes = 0; // A set of pools per frame in flight
+		};
+
+		struct LightUpdateStats
+		{
+			uint32_t numLights = 0;
+			uint32_t numLightsRegenerated = 0;
+			float updateTimeMs = 0.f; // CPU time spent in the write*GPUData functions
+		};
+
 	public:
 		LightHandler() = default;
 		virtual ~LightHandler() = default;
 
-		void initiate(ID3D12Device* pDevice, uint32_t maxFramesInFlight, GPUResourceManager& gpuResourceManager, const std::vector<DXMesh>& dxMeshes, DescriptorHeapStore& descHeapStore);
+		// The shadow map SRVs are written to the first MAX_SHADOW_MAPS + MAX_POINT_SHADOW_CUBES slots of shadowMapsDHH
+		void initiate(ID3D12Device* pDevice, uint32_t maxFramesInFlight, GPUResourceManager& gpuResourceManager, const std::vector<DXMesh>& dxMeshes, const DXMeshBuffers& dxMeshBuffers, DescriptorHeapStore& descHeapStore, DescriptorHeapHandle shadowMapsDHH);
 		void shutdown();
 
 		void newFrame();
 
-		void drawDepthMaps(CommandContext& commandContext, RingBuffer& ringBuffer, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups);
-		D3D12_CPU_DESCRIPTOR_HANDLE getFrameShadowMapSRVCPUHandle();
+		// Needs to be called before writing the light data since the shadow map cache keys depend on the casters
+		void gatherShadowCasters(const Scene& scene, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups);
+
+		// Decides which lights get shadow maps this frame, needs to be called before writing the light data
+		void assignShadowBudget(const Scene& scene, float screenWidth, float screenHeight);
+
+		// objectDatasGVA holds the GPUObjectDatas of every draw group, see DrawGroup::firstObject
+		void drawDepthMaps(CommandContext& commandContext, RingBuffer& ringBuffer, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups, D3D12_GPU_VIRTUAL_ADDRESS objectDatasGVA);
 
 		D3D12_GPU_VIRTUAL_ADDRESS writePointLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, uint32_t* pOutNumPointLights);
-		D3D12_GPU_VIRTUAL_ADDRESS writeDirLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, uint32_t* pOutNumDirLights);
+		D3D12_GPU_VIRTUAL_ADDRESS writeDirLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, float aspectRatio, uint32_t* pOutNumDirLights);
 		D3D12_GPU_VIRTUAL_ADDRESS writeSpotLightGPUData(RingBuffer& ringBuffer, CommandContext& commandContext, const Scene& scene, uint32_t* pOutNumSpotLights);
 
+		inline const ShadowStats& getShadowStats() const { return m_shadowStats; }
+		inline const ShadowMemoryReport& getShadowMemoryReport() const { return m_memoryReport; }
+		inline const LightUpdateStats& getLightUpdateStats() const { return m_lightUpdateStats; }
 
 	private:
-		void preDepthMapRender(CommandContext& commandContext);
-		void drawDepthMap_Internal(CommandContext& commandContext, const std::vector<DrawGroup>& drawGroups, uint32_t numActiveDrawGroups, const ShadowMap& shadowMap, uint32_t shadowBarrierIdx);
+		uint32_t preDepthMapRender(CommandContext& commandContext);
+		void drawDepthMap_Internal(CommandContext& commandContext, RingBuffer& ringBuffer, RenderPass& renderPass, const std::vector<uint32_t>& casterDrawGroups);
+
+		// pOutUVScale receives the rendered region / texture size of 2D maps
+		void trySetShadowMapData(CommandContext& commandContext, bool isCubeMap, uint32_t resolution, const glm::mat4* pViewProjMatrices, glm::vec3 lightPos, float farPlane, uint32_t* pOutShadowMapIdx, float* pOutUVScale);
+
+		// slotIdx is the SRV slot, counted from the first 2D map or the first cube. 2D maps that already have a texture get it replaced
+		void createShadowMap(CommandContext& commandContext, ShadowMap& shadowMap, uint32_t slotIdx, bool isCubeMap, uint32_t resolution);
+		void addShadowCubeRequest(uint32_t lightEntity, uint32_t shadowMapIdx);
 
-		void trySetShadowMapData(CommandContext& commandContext, ActiveVector<ShadowMap>& shadowMaps, bool isCubeMap, glm::mat4* pViewProjMatrices, glm::vec3 lightPos, uint32_t* pOutShadowMapIdx);
-		ShadowMap& createShadowMap(CommandContext& commandContext, ActiveVector<ShadowMap>& shadowMaps, bool isCubeMap, uint32_t width, uint32_t height);
+		uint32_t getShadowResolution(uint64_t lightKey) const;
 
 		void createRenderPasses();
 
@@ -63,8 +146,7 @@ namespace Okay
 
 		GPUResourceManager* m_pGpuResourceManager = nullptr;
 		const std::vector<DXMesh>* m_pDxMeshes;
-
-		uint32_t m_srvIncrementSize = INVALID_UINT32;
+		const DXMeshBuffers* m_pDxMeshBuffers = nullptr;
 
 		DescriptorHeapStore* m_pDescriptorHeapStore = nullptr;
 		DescriptorHeapHandle m_shadowMapsDHH = INVALID_DHH;
@@ -73,9 +155,33 @@ namespace Okay
 		RenderPass m_shadowPass;
 		RenderPass m_shadowPassPointLights;
 
-		uint32_t m_maxFramesInFlight = INVALID_UINT32;
-		uint32_t m_currentFrame = INVALID_UINT32;
-		std::vector<FrameResources> m_frames;
+		// Depth draws of every draw group, every shadow map builds its commands from its casters
+		IndirectDrawBuilder m_depthDrawBuilder;
+		IndirectCommandList m_depthCommandList;
+
+		ShadowMapPools m_pools;
+		ShadowMemoryReport m_memoryReport;
+
+		ShadowBudget m_shadowBudget;
+		ShadowBudgetSettings m_shadowBudgetSettings;
+
+		ShadowCubeScheduler m_shadowCubeScheduler;
+		ShadowCubeSchedulerSettings m_shadowCubeSchedulerSettings;
+		std::unordered_map<uint64_t, ShadowCubePriority> m_shadowCubePriorities;
+
+		ShadowQualityPreset m_shadowQualityPreset;
+		std::unordered_map<uint64_t, uint32_t> m_shadowResolutions;
+		std::unordered_map<uint64_t, uint32_t> m_prevShadowResolutions;
+
+		std::vector<ShadowCaster> m_shadowCasters;
+		glm::vec3 m_sceneBoundsMin = glm::vec3(0.f);
+		glm::vec3 m_sceneBoundsMax = glm::vec3(0.f);
+		ShadowStats m_shadowStats;
+
+		LightRecordCache<PointLightInputs, GPUPointLight, PointLightShadowData> m_pointLightCache;
+		LightRecordCache<SpotLightInputs, GPUSpotLight, LightShadowData> m_spotLightCache;
+		LightRecordCache<DirLightInputs, GPUDirectionalLight, LightShadowData> m_dirLightCache;
+		LightUpdateStats m_lightUpdateStats;
 
 	};
 }
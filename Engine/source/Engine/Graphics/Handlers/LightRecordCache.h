@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+#include <type_traits>
+#include <cstring>
+
+/*
+	Change tracking for per-light GPU data:
+	The inputs of every light (its component, Transform & whatever else the GPU record depends on) are stored and compared
+	to the ones of the next frame. Only lights whose inputs changed get their record (and shadow data) regenerated,
+	the rest keep last frame's record. Since the records are contiguous they can be copied to the GPU in one go.
+
+	Lights are expected in the same order every frame (entt view iteration order), the entity should be part of the
+	inputs so a reordered or replaced light is detected as a change.
+
+	Inputs are compared with memcmp, so they must not contain padding, stick to 4 byte members.
+*/
+
+namespace Okay
+{
+	template<typename InputT, typename GPURecordT, typename ShadowDataT>
+	class LightRecordCache
+	{
+		static_assert(std::is_trivially_copyable_v<InputT>, "Light inputs are compared with memcmp");
+
+	public:
+		LightRecordCache() = default;
+		~LightRecordCache() = default;
+
+		void beginFrame(uint32_t numLights)
+		{
+			m_numRegenerated = 0;
+
+			if (numLights == (uint32_t)m_records.size())
+			{
+				return;
+			}
+
+			// A light was added or removed, easiest is to start over
+			m_inputs.resize(numLights);
+			m_records.resize(numLights);
+			m_shadowDatas.resize(numLights);
+			m_valid.assign(numLights, false);
+		}
+
+		// Returns true if the inputs changed since last frame, the record then needs to be regenerated
+		bool update(uint32_t idx, const InputT& inputs)
+		{
+			if (m_valid[idx] && memcmp(&m_inputs[idx], &inputs, sizeof(InputT)) == 0)
+			{
+				return false;
+			}
+
+			m_inputs[idx] = inputs;
+			m_valid[idx] = true;
+			m_numRegenerated++;
+
+			return true;
+		}
+
+		inline const InputT& getInputs(uint32_t idx) const { return m_inputs[idx]; }
+		inline GPURecordT& getRecord(uint32_t idx) { return m_records[idx]; }
+		inline ShadowDataT& getShadowData(uint32_t idx) { return m_shadowDatas[idx]; }
+
+		inline const GPURecordT* getRecords() const { return m_records.data(); }
+		inline uint32_t getNumRecords() const { return (uint32_t)m_records.size(); }
+
+		inline uint32_t getNumRegenerated() const { return m_numRegenerated; }
+
+	private:
+		std::vector<InputT> m_inputs;
+		std::vector<GPURecordT> m_records;
+		std::vector<ShadowDataT> m_shadowDatas;
+		std::vector<bool> m_valid;
+
+		uint32_t m_numRegenerated = 0;
+	};
+}
@@ -0,0 +1,186 @@
+#include "LightRecords.h"
+
+#include "glm/gtc/constants.hpp"
+
+namespace Okay
+{
+	static const glm::vec3 CUBE_MAP_DIRECTIONS[6] =
+	{
+		glm::vec3(-1.f, 0.f, 0.f),
+		glm::vec3(1.f, 0.f, 0.f),
+
+		glm::vec3(0.f, -1.f, 0.f),
+		glm::vec3(0.f, 1.f, 0.f),
+
+		glm::vec3(0.f, 0.f, -1.f),
+		glm::vec3(0.f, 0.f, 1.f),
+	};
+
+	// Only the position & rotation are part of the inputs, the scale doesn't change the directions
+	static Transform createLightTransform(glm::vec3 position, glm::vec3 rotation)
+	{
+		Transform transform;
+		transform.position = position;
+		transform.rotation = rotation;
+
+		return transform;
+	}
+
+	PointLightInputs createPointLightInputs(uint32_t entity, const PointLight& pointLight, const Transform& transform, bool castsShadow)
+	{
+		PointLightInputs inputs;
+		inputs.entity = entity;
+		inputs.colour = pointLight.colour;
+		inputs.intensity = pointLight.intensity;
+		inputs.attenuation = pointLight.attenuation;
+		inputs.position = transform.position;
+		inputs.castsShadow = castsShadow;
+
+		return inputs;
+	}
+
+	SpotLightInputs createSpotLightInputs(uint32_t entity, const SpotLight& spotLight, const Transform& transform, bool castsShadow, uint32_t resolution)
+	{
+		SpotLightInputs inputs;
+		inputs.entity = entity;
+		inputs.colour = spotLight.colour;
+		inputs.intensity = spotLight.intensity;
+		inputs.attenuation = spotLight.attenuation;
+		inputs.spreadAngle = spotLight.spreadAngle;
+		inputs.position = transform.position;
+		inputs.rotation = transform.rotation;
+		inputs.castsShadow = castsShadow;
+		inputs.resolution = castsShadow ? resolution : 0;
+
+		return inputs;
+	}
+
+	DirLightInputs createDirLightInputs(uint32_t entity, const DirectionalLight& directionalLight, const Transform& transform, bool castsShadow, uint32_t resolution,
+		const CascadeCamera& cascadeCamera, glm::vec3 sceneBoundsMin, glm::vec3 sceneBoundsMax)
+	{
+		DirLightInputs inputs;
+		inputs.entity = entity;
+		inputs.colour = directionalLight.colour;
+		inputs.intensity = directionalLight.intensity;
+		inputs.rotation = transform.rotation;
+		inputs.castsShadow = castsShadow;
+		inputs.resolution = castsShadow ? resolution : 0;
+		inputs.cameraPosition = cascadeCamera.position;
+		inputs.cameraForward = cascadeCamera.forward;
+		inputs.cameraFovY = cascadeCamera.fovY;
+		inputs.cameraAspectRatio = cascadeCamera.aspectRatio;
+		inputs.cameraNearZ = cascadeCamera.nearZ;
+		inputs.cameraFarZ = cascadeCamera.farZ;
+		inputs.sceneBoundsMin = sceneBoundsMin;
+		inputs.sceneBoundsMax = sceneBoundsMax;
+
+		return inputs;
+	}
+
+	void generatePointLightRecord(const PointLightInputs& inputs, float farPlane, GPUPointLight& outRecord, PointLightShadowData& outShadowData)
+	{
+		outRecord = GPUPointLight();
+		outShadowData = PointLightShadowData();
+
+		outRecord.colour = inputs.colour;
+		outRecord.intensity = inputs.intensity;
+		outRecord.attenuation = inputs.attenuation;
+
+		outRecord.position = inputs.position;
+		outRecord.shadowMapIdx = INVALID_UINT32;
+
+		outShadowData.castsShadow = inputs.castsShadow;
+		if (!outShadowData.castsShadow)
+		{
+			return;
+		}
+
+		outRecord.farPlane = farPlane;
+
+		glm::mat4 projMatrix = glm::perspectiveFovLH_ZO(glm::half_pi<float>(), 1.f, 1.f, 1.f, farPlane);
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			glm::vec3 upVector = glm::vec3(0.f, 1.f, 0.f);
+			if (i == 2)
+			{
+				upVector = glm::vec3(0.f, 0.f, -1.f);
+			}
+			else if (i == 3)
+			{
+				upVector = glm::vec3(0.f, 0.f, 1.f);
+			}
+
+			outShadowData.viewProjMatrices[i] = glm::transpose(projMatrix * glm::lookAt(inputs.position, inputs.position + CUBE_MAP_DIRECTIONS[i], upVector));
+		}
+	}
+
+	void generateSpotLightRecord(const SpotLightInputs& inputs, float range, GPUSpotLight& outRecord, LightShadowData& outShadowData)
+	{
+		Transform transform = createLightTransform(inputs.position, inputs.rotation);
+
+		outRecord = GPUSpotLight();
+		outShadowData.castsShadow = inputs.castsShadow;
+
+		outRecord.colour = inputs.colour;
+		outRecord.intensity = inputs.intensity;
+		outRecord.attenuation = inputs.attenuation;
+		outRecord.spreadCosAngle = glm::cos(glm::radians(inputs.spreadAngle * 0.5f));
+
+		outRecord.position = inputs.position;
+		outRecord.direction = transform.forwardVec();
+		outRecord.shadowMapIdx = INVALID_UINT32;
+
+		if (!inputs.castsShadow)
+		{
+			return;
+		}
+
+		outRecord.viewProjMatrix = glm::transpose(
+			glm::perspectiveFovLH_ZO(glm::radians(inputs.spreadAngle), 1.f, 1.f, 1.f, range) *
+			transform.getViewMatrix());
+	}
+
+	void generateDirLightRecord(const DirLightInputs& inputs, uint32_t numCascades, const float* pCascadeSplitFars, GPUDirectionalLight& outRecord, LightShadowData& outShadowData)
+	{
+		glm::vec3 lightForward = createLightTransform(glm::vec3(0.f), inputs.rotation).forwardVec();
+
+		outRecord = GPUDirectionalLight();
+		outShadowData.castsShadow = inputs.castsShadow;
+
+		outRecord.colour = inputs.colour;
+		outRecord.intensity = inputs.intensity;
+
+		outRecord.direction = -lightForward;
+		outRecord.numCascades = inputs.castsShadow ? numCascades : 0;
+
+		for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++)
+		{
+			outRecord.cascadeShadowMapIndices[i] = INVALID_UINT32;
+		}
+
+		if (!inputs.castsShadow)
+		{
+			return;
+		}
+
+		CascadeCamera cascadeCamera;
+		cascadeCamera.position = inputs.cameraPosition;
+		cascadeCamera.forward = inputs.cameraForward;
+		cascadeCamera.fovY = inputs.cameraFovY;
+		cascadeCamera.aspectRatio = inputs.cameraAspectRatio;
+		cascadeCamera.nearZ = inputs.cameraNearZ;
+		cascadeCamera.farZ = inputs.cameraFarZ;
+
+		float splitNear = cascadeCamera.nearZ;
+		for (uint32_t i = 0; i < numCascades; i++)
+		{
+			ShadowCascade cascade = computeShadowCascade(cascadeCamera, lightForward, splitNear, pCascadeSplitFars[i],
+				inputs.resolution, inputs.sceneBoundsMin, inputs.sceneBoundsMax);
+
+			outRecord.cascadeViewProjMatrices[i] = glm::transpose(cascade.viewProjMatrix);
+			outRecord.cascadeSplitFars[i] = cascade.splitFar;
+
+			splitNear = cascade.splitFar;
+		}
+	}
+}
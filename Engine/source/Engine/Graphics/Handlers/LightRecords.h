@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Scene/Components.h"
+#include "ShadowCascades.h"
+
+/*
+	The per-light GPU records & shadow matrices, and the inputs they're built from.
+	LightHandler fills the inputs from the components every frame and only regenerates the records whose inputs changed,
+	see LightRecordCache.h. Everything a record depends on is in its inputs, so regenerating only needs the inputs.
+*/
+
+namespace Okay
+{
+	struct GPUPointLight
+	{
+		uint32_t shadowMapIdx = INVALID_UINT32;
+		float farPlane = 0.f;
+
+		glm::vec3 position = glm::vec3(0.f);
+
+		glm::vec3 colour = glm::vec3(1.f);
+		float intensity = 1.f;
+		glm::vec2 attenuation = glm::vec2(0.f, 1.f);
+	};
+
+	struct GPUDirectionalLight
+	{
+		glm::mat4 cascadeViewProjMatrices[MAX_SHADOW_CASCADES] = {};
+		uint32_t cascadeShadowMapIndices[MAX_SHADOW_CASCADES] = { INVALID_UINT32, INVALID_UINT32, INVALID_UINT32, INVALID_UINT32 };
+		glm::vec4 cascadeSplitFars = glm::vec4(0.f); // View depth where each cascade ends
+		uint32_t numCascades = 0;
+
+		glm::vec3 direction = glm::vec3(0.f);
+
+		glm::vec3 colour = glm::vec3(1.f);
+		float intensity = 1.f;
+
+		glm::vec4 cascadeUVScales = glm::vec4(1.f); // Rendered region / texture size, the cascades can end up in different sized textures
+	};
+
+	struct GPUSpotLight
+	{
+		glm::mat4 viewProjMatrix = glm::mat4(1.f);
+		uint32_t shadowMapIdx = INVALID_UINT32;
+
+		glm::vec3 position = glm::vec3(0.f);
+		glm::vec3 direction = glm::vec3(0.f);
+
+		glm::vec3 colour = glm::vec3(1.f);
+		float intensity = 1.f;
+
+		glm::vec2 attenuation = glm::vec2(0.f, 1.f);
+		float spreadCosAngle = 90.f;
+
+		float shadowMapUVScale = 1.f;
+	};
+
+	// Everything the GPU records & shadow matrices are built from, see LightRecordCache.h
+	struct PointLightInputs
+	{
+		uint32_t entity = 0;
+		glm::vec3 colour = glm::vec3(0.f);
+		float intensity = 0.f;
+		glm::vec2 attenuation = glm::vec2(0.f);
+		glm::vec3 position = glm::vec3(0.f);
+		uint32_t castsShadow = 0;
+	};
+
+	struct SpotLightInputs
+	{
+		uint32_t entity = 0;
+		glm::vec3 colour = glm::vec3(0.f);
+		float intensity = 0.f;
+		glm::vec2 attenuation = glm::vec2(0.f);
+		float spreadAngle = 0.f;
+		glm::vec3 position = glm::vec3(0.f);
+		glm::vec3 rotation = glm::vec3(0.f);
+		uint32_t castsShadow = 0;
+		uint32_t resolution = 0;
+	};
+
+	struct DirLightInputs
+	{
+		uint32_t entity = 0;
+		glm::vec3 colour = glm::vec3(0.f);
+		float intensity = 0.f;
+		glm::vec3 rotation = glm::vec3(0.f);
+		uint32_t castsShadow = 0;
+		uint32_t resolution = 0;
+
+		// The cascades are fit to the camera & scene
+		glm::vec3 cameraPosition = glm::vec3(0.f);
+		glm::vec3 cameraForward = glm::vec3(0.f);
+		float cameraFovY = 0.f;
+		float cameraAspectRatio = 0.f;
+		float cameraNearZ = 0.f;
+		float cameraFarZ = 0.f;
+		glm::vec3 sceneBoundsMin = glm::vec3(0.f);
+		glm::vec3 sceneBoundsMax = glm::vec3(0.f);
+	};
+
+	struct PointLightShadowData
+	{
+		glm::mat4 viewProjMatrices[6] = {};
+		uint32_t castsShadow = 0;
+	};
+
+	// Spot & directional lights keep their matrices in the GPU record
+	struct LightShadowData
+	{
+		uint32_t castsShadow = 0;
+	};
+
+	PointLightInputs createPointLightInputs(uint32_t entity, const PointLight& pointLight, const Transform& transform, bool castsShadow);
+	SpotLightInputs createSpotLightInputs(uint32_t entity, const SpotLight& spotLight, const Transform& transform, bool castsShadow, uint32_t resolution);
+
+	// cascadeCamera & the scene bounds are the same for every directional light in a frame
+	DirLightInputs createDirLightInputs(uint32_t entity, const DirectionalLight& directionalLight, const Transform& transform, bool castsShadow, uint32_t resolution,
+		const CascadeCamera& cascadeCamera, glm::vec3 sceneBoundsMin, glm::vec3 sceneBoundsMax);
+
+	// The records only depend on the inputs, nothing is kept from the last time a record was generated.
+	// The shadow map indices are left INVALID_UINT32, they're assigned every frame after the records are copied.
+	// Shadow matrices are only built for lights that cast shadows, farPlane / range is the far plane of their projection
+	void generatePointLightRecord(const PointLightInputs& inputs, float farPlane, GPUPointLight& outRecord, PointLightShadowData& outShadowData);
+	void generateSpotLightRecord(const SpotLightInputs& inputs, float range, GPUSpotLight& outRecord, LightShadowData& outShadowData);
+
+	// pCascadeSplitFars from computeCascadeSplits with the camera in the inputs
+	void generateDirLightRecord(const DirLightInputs& inputs, uint32_t numCascades, const float* pCascadeSplitFars, GPUDirectionalLight& outRecord, LightShadowData& outShadowData);
+}
@@ -0,0 +1,206 @@
+#include "ShadowBudget.h"
+
+#include <algorithm>
+
+namespace Okay
+{
+	ShadowQualityPreset getShadowQualityPreset(ShadowQuality quality)
+	{
+		switch (quality)
+		{
+		case OKAY_SHADOW_QUALITY_LOW:
+			return ShadowQualityPreset{ 1024, 0.5f };
+
+		case OKAY_SHADOW_QUALITY_MEDIUM:
+			return ShadowQualityPreset{ 2048, 1.f };
+
+		case OKAY_SHADOW_QUALITY_HIGH:
+			return ShadowQualityPreset{ 4096, 1.5f };
+
+		case OKAY_SHADOW_QUALITY_ULTRA:
+			return ShadowQualityPreset{ 4096, 2.5f };
+		}
+
+		OKAY_ASSERT(false);
+		return ShadowQualityPreset();
+	}
+
+	uint32_t selectShadowMapResolution(float projectedSize, const ShadowQualityPreset& preset, uint32_t previousResolution)
+	{
+		// How far past a power of two the wanted size has to go before switching
+		static const float RESOLUTION_HYSTERESIS = 0.15f;
+
+		uint32_t maxResolution = glm::clamp(preset.maxResolution, MIN_SHADOW_MAP_RESOLUTION, MAX_SHADOW_MAP_RESOLUTION);
+		float wantedSize = projectedSize * preset.resolutionScale;
+
+		uint32_t resolution = MIN_SHADOW_MAP_RESOLUTION;
+		while (resolution < maxResolution && (float)resolution < wantedSize)
+		{
+			resolution *= 2;
+		}
+
+		if (previousResolution == INVALID_UINT32 || previousResolution == resolution)
+		{
+			return resolution;
+		}
+
+		bool keepPrevious = previousResolution > resolution ?
+			wantedSize > previousResolution * 0.5f * (1.f - RESOLUTION_HYSTERESIS) :
+			wantedSize < previousResolution * (1.f + RESOLUTION_HYSTERESIS);
+
+		// The preset might have changed since last time
+		return keepPrevious && previousResolution <= maxResolution ? previousResolution : resolution;
+	}
+
+	ShadowImportanceCamera createShadowImportanceCamera(glm::vec3 position, glm::vec3 forward, float fovY, const glm::mat4& viewProjMatrix)
+	{
+		ShadowImportanceCamera camera;
+		camera.position = position;
+		camera.forward = glm::normalize(forward);
+		camera.tanHalfFovY = glm::tan(fovY * 0.5f);
+		camera.frustum = extractFrustum(viewProjMatrix);
+
+		return camera;
+	}
+
+	float computeLightInfluenceRadius(float intensity, glm::vec2 attenuation, float minContribution, float maxRange)
+	{
+		// intensity / (1 + x * d + y * d^2) = minContribution  =>  y * d^2 + x * d + (1 - intensity / minContribution) = 0
+		float c = 1.f - intensity / minContribution;
+		if (c >= 0.f)
+		{
+			return 0.f; // Never bright enough
+		}
+
+		float a = attenuation.y;
+		float b = attenuation.x;
+
+		float radius = maxRange;
+		if (a > 0.f)
+		{
+			radius = (-b + glm::sqrt(b * b - 4.f * a * c)) / (2.f * a);
+		}
+		else if (b > 0.f)
+		{
+			radius = -c / b;
+		}
+
+		return glm::min(radius, maxRange);
+	}
+
+	float computeProjectedLightSize(const ShadowImportanceCamera& camera, glm::vec3 lightPosition, float lightRadius, float screenHeight)
+	{
+		float distance = glm::length(lightPosition - camera.position);
+		if (distance <= lightRadius)
+		{
+			return screenHeight;
+		}
+
+		float projectedRadius = lightRadius / (distance * camera.tanHalfFovY);
+		return glm::min(projectedRadius, 1.f) * screenHeight;
+	}
+
+	float computeLocalLightImportance(const ShadowImportanceCamera& camera, const ShadowBudgetSettings& settings, glm::vec3 lightPosition, float lightRadius, float intensity)
+	{
+		if (lightRadius <= 0.f || intensity <= 0.f)
+		{
+			return 0.f;
+		}
+
+		if (!sphereInFrustum(camera.frustum, lightPosition, lightRadius))
+		{
+			return 0.f;
+		}
+
+		glm::vec3 toLight = lightPosition - camera.position;
+		float distance = glm::length(toLight);
+
+		// Camera inside the light volume, it's everywhere on screen
+		if (distance <= lightRadius)
+		{
+			return intensity;
+		}
+
+		// Projected radius relative to half the screen height, squared to get an area
+		float projectedRadius = lightRadius / (distance * camera.tanHalfFovY);
+		float screenCoverage = glm::min(projectedRadius * projectedRadius, 1.f);
+
+		float distanceFactor = 1.f / (1.f + (distance - lightRadius) * settings.distanceFalloff);
+
+		// Lights in the center of the view matter more than ones in the corner
+		float facingFactor = 0.5f + 0.5f * glm::dot(camera.forward, toLight / distance);
+
+		return screenCoverage * intensity * distanceFactor * facingFactor;
+	}
+
+	float computeDirectionalLightImportance(float intensity)
+	{
+		return glm::max(intensity, 0.f);
+	}
+
+	void ShadowBudget::beginFrame()
+	{
+		m_requests.clear();
+	}
+
+	void ShadowBudget::addRequest(uint64_t lightKey, float importance, uint32_t numShadowMaps, uint32_t numShadowCubes, uint64_t numTexels)
+	{
+		Request& request = m_requests.emplace_back();
+		request.lightKey = lightKey;
+		request.importance = importance;
+		request.numShadowMaps = numShadowMaps;
+		request.numShadowCubes = numShadowCubes;
+		request.numTexels = numTexels;
+	}
+
+	void ShadowBudget::allocate(const ShadowBudgetSettings& settings)
+	{
+		std::swap(m_previouslyGranted, m_granted);
+		m_granted.clear();
+
+		m_stats = {};
+		m_stats.numRequests = (uint32_t)m_requests.size();
+
+		for (Request& request : m_requests)
+		{
+			if (m_previouslyGranted.contains(request.lightKey))
+			{
+				request.importance *= 1.f + settings.hysteresisBonus;
+			}
+		}
+
+		// Ties are broken by the key to not depend on the request order
+		std::sort(m_requests.begin(), m_requests.end(), [](const Request& a, const Request& b)
+		{
+			return a.importance != b.importance ? a.importance > b.importance : a.lightKey < b.lightKey;
+		});
+
+		for (const Request& request : m_requests)
+		{
+			if (request.importance <= 0.f)
+			{
+				break;
+			}
+
+			// Smaller requests further down might still fit, so keep going
+			if (m_stats.numShadowMapsGranted + request.numShadowMaps > settings.maxShadowMaps ||
+				m_stats.numShadowCubesGranted + request.numShadowCubes > settings.maxShadowCubes ||
+				m_stats.numTexelsGranted + request.numTexels > settings.maxTexels)
+			{
+				continue;
+			}
+
+			m_stats.numShadowMapsGranted += request.numShadowMaps;
+			m_stats.numShadowCubesGranted += request.numShadowCubes;
+			m_stats.numTexelsGranted += request.numTexels;
+			m_stats.numGranted++;
+
+			m_granted.insert(request.lightKey);
+		}
+	}
+
+	bool ShadowBudget::isGranted(uint64_t lightKey) const
+	{
+		return m_granted.contains(lightKey);
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Misc/Frustum.h"
+
+#include <vector>
+#include <unordered_set>
+
+/*
+	Shadow budget:
+	Every shadow casting light requests its shadow maps each frame together with an importance score.
+	Requests are granted from most to least important until the budget (maps, cubes & texels) runs out,
+	so which lights cast shadows depends on what's on screen instead of creation order.
+
+	Lights that were granted last frame get their importance boosted (hysteresis), so two lights with similar
+	scores don't swap shadows back and forth every frame.
+*/
+
+namespace Okay
+{
+	struct ShadowImportanceCamera
+	{
+		glm::vec3 position = glm::vec3(0.f);
+		glm::vec3 forward = glm::vec3(0.f, 0.f, 1.f);
+		float tanHalfFovY = 1.f;
+
+		Frustum frustum;
+	};
+
+	struct ShadowBudgetSettings
+	{
+		uint32_t maxShadowMaps = 0;
+		uint32_t maxShadowCubes = 0;
+		uint64_t maxTexels = 0; // Summed over all granted maps, cube faces count individually
+
+		float hysteresisBonus = 0.25f; // Importance multiplier is (1 + bonus) for lights granted last frame
+		float distanceFalloff = 0.001f;
+	};
+
+	enum ShadowQuality : uint32_t
+	{
+		OKAY_SHADOW_QUALITY_LOW = 0,
+		OKAY_SHADOW_QUALITY_MEDIUM = 1,
+		OKAY_SHADOW_QUALITY_HIGH = 2,
+		OKAY_SHADOW_QUALITY_ULTRA = 3,
+	};
+
+	struct ShadowQualityPreset
+	{
+		uint32_t maxResolution = 2048;
+		float resolutionScale = 1.f; // Shadow map texels per screen pixel covered by the light
+	};
+
+	constexpr uint32_t MIN_SHADOW_MAP_RESOLUTION = 256;
+	constexpr uint32_t MAX_SHADOW_MAP_RESOLUTION = 4096;
+
+	ShadowQualityPreset getShadowQualityPreset(ShadowQuality quality);
+
+	// Power of two resolution in [MIN_SHADOW_MAP_RESOLUTION, preset.maxResolution] for a light covering projectedSize pixels on screen.
+	// The previous resolution is kept until the new one is clearly bigger or smaller, so lights don't flip between two sizes
+	uint32_t selectShadowMapResolution(float projectedSize, const ShadowQualityPreset& preset, uint32_t previousResolution);
+
+	ShadowImportanceCamera createShadowImportanceCamera(glm::vec3 position, glm::vec3 forward, float fovY, const glm::mat4& viewProjMatrix);
+
+	// Distance where the light contribution falls below minContribution, for 1 / (1 + linear * d + quadratic * d^2) attenuation
+	float computeLightInfluenceRadius(float intensity, glm::vec2 attenuation, float minContribution, float maxRange);
+
+	// Diameter of the light volume on screen in pixels, screenHeight if the camera is inside it
+	float computeProjectedLightSize(const ShadowImportanceCamera& camera, glm::vec3 lightPosition, float lightRadius, float screenHeight);
+
+	// Screen coverage * intensity * distance falloff * camera facing, 0 if the light volume is outside the camera frustum
+	float computeLocalLightImportance(const ShadowImportanceCamera& camera, const ShadowBudgetSettings& settings, glm::vec3 lightPosition, float lightRadius, float intensity);
+
+	// Directional lights cover the whole screen, so only the intensity matters
+	float computeDirectionalLightImportance(float intensity);
+
+	class ShadowBudget
+	{
+	public:
+		struct Stats
+		{
+			uint32_t numRequests = 0;
+			uint32_t numGranted = 0;
+
+			uint32_t numShadowMapsGranted = 0;
+			uint32_t numShadowCubesGranted = 0;
+			uint64_t numTexelsGranted = 0;
+		};
+
+	public:
+		ShadowBudget() = default;
+		~ShadowBudget() = default;
+
+		void beginFrame();
+
+		// lightKey needs to be stable between frames for the hysteresis to work
+		void addRequest(uint64_t lightKey, float importance, uint32_t numShadowMaps, uint32_t numShadowCubes, uint64_t numTexels);
+
+		void allocate(const ShadowBudgetSettings& settings);
+
+		bool isGranted(uint64_t lightKey) const;
+
+		inline const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct Request
+		{
+			uint64_t lightKey = 0;
+			float importance = 0.f;
+
+			uint32_t numShadowMaps = 0;
+			uint32_t numShadowCubes = 0;
+			uint64_t numTexels = 0;
+		};
+
+		std::vector<Request> m_requests;
+
+		std::unordered_set<uint64_t> m_granted;
+		std::unordered_set<uint64_t> m_previouslyGranted;
+
+		Stats m_stats;
+	};
+}
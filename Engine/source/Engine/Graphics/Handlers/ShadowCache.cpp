@@ -0,0 +1,86 @@
+#include "ShadowCache.h"
+#include "Engine/Misc/Hash.h"
+
+namespace Okay
+{
+	static void addCasterDrawGroup(const ShadowCaster& caster, std::vector<uint32_t>* pOutDrawGroups)
+	{
+		// Casters are gathered draw group by draw group, so checking the last one is enough to keep them unique
+		if (pOutDrawGroups && (pOutDrawGroups->empty() || pOutDrawGroups->back() != caster.drawGroupIdx))
+		{
+			pOutDrawGroups->emplace_back(caster.drawGroupIdx);
+		}
+	}
+
+	static void hashCaster(Hasher& hasher, const ShadowCaster& caster, std::vector<uint32_t>* pOutDrawGroups)
+	{
+		hasher.addValue(caster.meshID);
+		hasher.addValue(caster.lodIdx);
+		hasher.addValue(caster.worldMatrix);
+
+		addCasterDrawGroup(caster, pOutDrawGroups);
+	}
+
+	uint64_t computeShadowMapKey(const glm::mat4& viewProjMatrix, const std::vector<ShadowCaster>& casters, std::vector<uint32_t>* pOutDrawGroups)
+	{
+		if (pOutDrawGroups)
+		{
+			pOutDrawGroups->clear();
+		}
+
+		Hasher hasher;
+		hasher.addValue(viewProjMatrix);
+
+		Frustum lightFrustum = extractFrustum(viewProjMatrix);
+
+		for (const ShadowCaster& caster : casters)
+		{
+			if (sphereInFrustum(lightFrustum, glm::vec3(caster.worldSphere), caster.worldSphere.w))
+			{
+				hashCaster(hasher, caster, pOutDrawGroups);
+			}
+		}
+
+		return hasher.get();
+	}
+
+	void computeShadowCubeFaceKeys(const glm::mat4* pViewProjMatrices, glm::vec3 lightPos, float farPlane, const std::vector<ShadowCaster>& casters, uint64_t* pOutFaceKeys, std::vector<uint32_t>* pOutDrawGroups)
+	{
+		if (pOutDrawGroups)
+		{
+			pOutDrawGroups->clear();
+		}
+
+		Hasher faceHashers[6];
+		Frustum faceFrustums[6];
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			faceHashers[i].addValue(pViewProjMatrices[i]);
+			faceFrustums[i] = extractFrustum(pViewProjMatrices[i]);
+		}
+
+		for (const ShadowCaster& caster : casters)
+		{
+			if (!sphereIntersectsSphere(lightPos, farPlane, glm::vec3(caster.worldSphere), caster.worldSphere.w))
+			{
+				continue;
+			}
+
+			addCasterDrawGroup(caster, pOutDrawGroups);
+
+			// A caster on the edge between faces affects both
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				if (sphereInFrustum(faceFrustums[i], glm::vec3(caster.worldSphere), caster.worldSphere.w))
+				{
+					hashCaster(faceHashers[i], caster, nullptr);
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			pOutFaceKeys[i] = faceHashers[i].get();
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Misc/Frustum.h"
+
+#include <vector>
+
+/*
+	Shadow map caching:
+	Every shadow map stores a key built from the light parameters (its view projection matrices, position & range)
+	and the state of every caster inside the light's volume (mesh, LOD & world matrix).
+	If the key of a shadow map is the same as the last time it was rendered, its content is still valid and it's skipped.
+
+	The main pass picks mesh LODs from the camera, so the depth passes can't reuse them, or every camera move that changes
+	a LOD would invalidate the shadows of lights that didn't change. Casters are drawn with SHADOW_CASTER_LOD instead.
+*/
+
+namespace Okay
+{
+	// Shadow maps are cached for many frames & seen up close, so they use the full mesh
+	static const uint32_t SHADOW_CASTER_LOD = 0;
+
+	struct ShadowCaster
+	{
+		uint32_t meshID = INVALID_UINT32;
+		uint32_t drawGroupIdx = INVALID_UINT32;
+		uint32_t lodIdx = SHADOW_CASTER_LOD; // What the depth passes draw, not the draw group's LOD
+
+		glm::mat4 worldMatrix = glm::mat4(1.f);
+		glm::vec4 worldSphere = glm::vec4(0.f); // xyz = center, w = radius
+	};
+
+	// Key for a 2D shadow map (directional & spot lights), only casters intersecting the light frustum contribute.
+	// pOutDrawGroups is optional and receives the unique draw groups of the contributing casters
+	uint64_t computeShadowMapKey(const glm::mat4& viewProjMatrix, const std::vector<ShadowCaster>& casters, std::vector<uint32_t>* pOutDrawGroups = nullptr);
+
+	// Keys for the 6 faces of a shadow cube (point lights), only casters intersecting the face frustum contribute to a face.
+	// The light itself isn't part of the keys, see ShadowCubeScheduler.h. pOutDrawGroups receives the draw groups of casters inside the light range
+	void computeShadowCubeFaceKeys(const glm::mat4* pViewProjMatrices, glm::vec3 lightPos, float farPlane, const std::vector<ShadowCaster>& casters, uint64_t* pOutFaceKeys, std::vector<uint32_t>* pOutDrawGroups = nullptr);
+
+	// Returns true if the shadow map needs to be re-rendered, and stores the new key
+	inline bool updateShadowCacheKey(uint64_t& storedKey, uint64_t newKey)
+	{
+		if (storedKey == newKey)
+		{
+			return false;
+		}
+
+		storedKey = newKey;
+		return true;
+	}
+}
@@ -0,0 +1,121 @@
+#include "ShadowCascades.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+namespace Okay
+{
+	void computeCascadeSplits(float nearZ, float farZ, uint32_t numCascades, float lambda, float* pOutSplitFars)
+	{
+		OKAY_ASSERT(numCascades > 0 && numCascades <= MAX_SHADOW_CASCADES);
+		OKAY_ASSERT(nearZ > 0.f && farZ > nearZ);
+
+		for (uint32_t i = 1; i <= numCascades; i++)
+		{
+			float fraction = (float)i / (float)numCascades;
+
+			float logSplit = nearZ * glm::pow(farZ / nearZ, fraction);
+			float uniformSplit = nearZ + (farZ - nearZ) * fraction;
+
+			pOutSplitFars[i - 1] = glm::mix(uniformSplit, logSplit, lambda);
+		}
+
+		// Avoid float error leaving a gap at the end
+		pOutSplitFars[numCascades - 1] = farZ;
+	}
+
+	glm::mat4 computeCascadeLightView(glm::vec3 lightForward)
+	{
+		lightForward = glm::normalize(lightForward);
+
+		glm::vec3 upVector = glm::abs(lightForward.y) > 0.99f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+
+		return glm::lookAtLH(glm::vec3(0.f), lightForward, upVector);
+	}
+
+	glm::vec4 computeFrustumSliceSphere(const CascadeCamera& camera, float splitNear, float splitFar)
+	{
+		/*
+			The slice is symmetric around the forward axis, so the center is on it at some depth c.
+			With k = the distance from the axis to a frustum corner per unit of depth, c is found by
+			setting the distances to a near corner and a far corner equal:
+
+			(c - n)^2 + (n * k)^2 = (f - c)^2 + (f * k)^2  =>  c = (f + n) * (1 + k^2) / 2
+
+			If c ends up beyond the far plane the far corners alone define the sphere.
+		*/
+
+		float tanHalfFovY = glm::tan(camera.fovY * 0.5f);
+		float tanHalfFovX = tanHalfFovY * camera.aspectRatio;
+		float kSqrd = tanHalfFovX * tanHalfFovX + tanHalfFovY * tanHalfFovY;
+
+		float centerDepth = (splitFar + splitNear) * (1.f + kSqrd) * 0.5f;
+		centerDepth = glm::min(centerDepth, splitFar);
+
+		float farDepthDiff = splitFar - centerDepth;
+		float radius = glm::sqrt(farDepthDiff * farDepthDiff + splitFar * splitFar * kSqrd);
+
+		glm::vec3 center = camera.position + glm::normalize(camera.forward) * centerDepth;
+
+		return glm::vec4(center, radius);
+	}
+
+	ShadowCascade computeShadowCascade(const CascadeCamera& camera, glm::vec3 lightForward, float splitNear, float splitFar,
+		uint32_t shadowMapResolution, glm::vec3 sceneBoundsMin, glm::vec3 sceneBoundsMax)
+	{
+		ShadowCascade cascade;
+		cascade.splitNear = splitNear;
+		cascade.splitFar = splitFar;
+
+		glm::vec4 sliceSphere = computeFrustumSliceSphere(camera, splitNear, splitFar);
+
+		// Round the radius up to get rid of float noise, it's then constant for a given split configuration
+		float radius = glm::ceil(sliceSphere.w * 16.f) / 16.f;
+
+		float texelWorldSize = (radius * 2.f) / (float)shadowMapResolution;
+
+		cascade.viewMatrix = computeCascadeLightView(lightForward);
+		glm::mat4 inverseLightView = glm::inverse(cascade.viewMatrix);
+
+		// Snap the center to whole texels in light space, since the light view never changes for a given direction
+		// and the ortho size is constant, the rasterized texels end up at the same world positions every frame
+		glm::vec3 lightSpaceCenter = glm::vec3(cascade.viewMatrix * glm::vec4(glm::vec3(sliceSphere), 1.f));
+		lightSpaceCenter.x = glm::floor(lightSpaceCenter.x / texelWorldSize) * texelWorldSize;
+		lightSpaceCenter.y = glm::floor(lightSpaceCenter.y / texelWorldSize) * texelWorldSize;
+
+		// Tighten the depth range to the scene, anything in front of sceneMinZ can't cast shadows
+		float sceneMinZ = FLT_MAX;
+		float sceneMaxZ = -FLT_MAX;
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			glm::vec3 corner = glm::vec3(
+				i & 1 ? sceneBoundsMax.x : sceneBoundsMin.x,
+				i & 2 ? sceneBoundsMax.y : sceneBoundsMin.y,
+				i & 4 ? sceneBoundsMax.z : sceneBoundsMin.z);
+
+			float lightSpaceZ = (cascade.viewMatrix * glm::vec4(corner, 1.f)).z;
+			sceneMinZ = glm::min(sceneMinZ, lightSpaceZ);
+			sceneMaxZ = glm::max(sceneMaxZ, lightSpaceZ);
+		}
+
+		float nearZ = sceneMinZ;
+		float farZ = glm::min(sceneMaxZ, lightSpaceCenter.z + radius);
+
+		if (farZ <= nearZ) // The slice doesn't overlap the scene, nothing to shadow but keep the matrix valid
+		{
+			nearZ = lightSpaceCenter.z - radius;
+			farZ = lightSpaceCenter.z + radius;
+		}
+
+		glm::mat4 projMatrix = glm::orthoLH_ZO(
+			lightSpaceCenter.x - radius, lightSpaceCenter.x + radius,
+			lightSpaceCenter.y - radius, lightSpaceCenter.y + radius,
+			nearZ, farZ);
+
+		cascade.viewProjMatrix = projMatrix * cascade.viewMatrix;
+		cascade.sphereCenter = glm::vec3(inverseLightView * glm::vec4(lightSpaceCenter, 1.f));
+		cascade.sphereRadius = radius;
+		cascade.texelWorldSize = texelWorldSize;
+
+		return cascade;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+/*
+	Cascaded shadow maps for directional lights.
+
+	The camera frustum (up to a max shadow distance) is split into slices using the "practical split scheme"
+	(a blend between logarithmic and uniform splits). Each slice is enclosed by a bounding sphere whose radius
+	only depends on the split distances, fov & aspect ratio. This keeps the world size of a shadow map texel constant
+	when the camera moves or rotates, which together with snapping the sphere center to whole texels in a fixed
+	light space removes shimmering.
+
+	https://learn.microsoft.com/en-us/windows/win32/dxtecharts/cascaded-shadow-maps
+	https://developer.nvidia.com/gpugems/gpugems3/part-ii-light-and-shadows/chapter-10-parallel-split-shadow-maps-programmable-gpus
+*/
+
+namespace Okay
+{
+	constexpr uint32_t MAX_SHADOW_CASCADES = 4;
+
+	struct CascadeCamera
+	{
+		glm::vec3 position = glm::vec3(0.f);
+		glm::vec3 forward = glm::vec3(0.f, 0.f, 1.f);
+
+		float fovY = glm::radians(90.f);
+		float aspectRatio = 1.f;
+		float nearZ = 1.f;
+		float farZ = 5000.f;
+	};
+
+	struct ShadowCascade
+	{
+		glm::mat4 viewProjMatrix = glm::mat4(1.f); // Not transposed
+		glm::mat4 viewMatrix = glm::mat4(1.f);
+
+		float splitNear = 0.f;
+		float splitFar = 0.f;
+
+		glm::vec3 sphereCenter = glm::vec3(0.f); // Snapped, world space
+		float sphereRadius = 0.f;
+
+		float texelWorldSize = 0.f;
+	};
+
+	// Writes the far view depth of each cascade to pOutSplitFars, the first cascade starts at nearZ.
+	// lambda = 0 gives uniform splits, lambda = 1 gives logarithmic splits
+	void computeCascadeSplits(float nearZ, float farZ, uint32_t numCascades, float lambda, float* pOutSplitFars);
+
+	// Light space with a fixed orientation (only depends on the light direction) that the cascades are snapped in
+	glm::mat4 computeCascadeLightView(glm::vec3 lightForward);
+
+	// Smallest sphere around the camera frustum slice [splitNear, splitFar], returned as xyz = center, w = radius
+	glm::vec4 computeFrustumSliceSphere(const CascadeCamera& camera, float splitNear, float splitFar);
+
+	// Fits an orthographic cascade around the camera frustum slice.
+	// The depth range is tightened to the scene bounds so that all casters between the light and the slice are included
+	ShadowCascade computeShadowCascade(const CascadeCamera& camera, glm::vec3 lightForward, float splitNear, float splitFar,
+		uint32_t shadowMapResolution, glm::vec3 sceneBoundsMin, glm::vec3 sceneBoundsMax);
+}
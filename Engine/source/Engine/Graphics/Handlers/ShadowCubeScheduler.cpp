@@ -0,0 +1,179 @@
+#include "ShadowCubeScheduler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Okay
+{
+	static const uint32_t ALL_CUBE_FACES = 0b111111;
+
+	ShadowCubeUpdateRate selectShadowCubeUpdateRate(float cameraDistance, const ShadowCubeSchedulerSettings& settings)
+	{
+		if (cameraDistance <= settings.fullRateDistance)
+		{
+			return OKAY_SHADOW_CUBE_UPDATE_FULL;
+		}
+
+		if (cameraDistance <= settings.slicedRateDistance)
+		{
+			return OKAY_SHADOW_CUBE_UPDATE_SLICED;
+		}
+
+		return OKAY_SHADOW_CUBE_UPDATE_INTERVAL;
+	}
+
+	void ShadowCubeScheduler::beginFrame()
+	{
+		m_requests.clear();
+		m_stats = {};
+
+		for (SlotState& slotState : m_slots)
+		{
+			slotState.faceMask = 0;
+		}
+
+		m_frameIdx++;
+	}
+
+	void ShadowCubeScheduler::addRequest(const ShadowCubeRequest& request)
+	{
+		OKAY_ASSERT(request.slot != INVALID_UINT32);
+
+		if (request.slot >= m_slots.size())
+		{
+			m_slots.resize(request.slot + 1);
+		}
+
+		m_requests.emplace_back(request);
+		m_stats.numRequests++;
+	}
+
+	void ShadowCubeScheduler::schedule(const ShadowCubeSchedulerSettings& settings)
+	{
+		auto needsFullUpdate = [&](const ShadowCubeRequest& request)
+		{
+			return m_slots[request.slot].lightKey != request.lightKey;
+		};
+
+		std::sort(m_requests.begin(), m_requests.end(), [&](const ShadowCubeRequest& a, const ShadowCubeRequest& b)
+		{
+			bool aFull = needsFullUpdate(a);
+			bool bFull = needsFullUpdate(b);
+
+			if (aFull != bFull)
+			{
+				return aFull;
+			}
+
+			// Cubes that got nothing last time go first, otherwise the most important cubes could take the whole budget every frame
+			uint64_t aServedFrame = m_slots[a.slot].lastServedFrame;
+			uint64_t bServedFrame = m_slots[b.slot].lastServedFrame;
+
+			if (aServedFrame != bServedFrame)
+			{
+				return aServedFrame < bServedFrame;
+			}
+
+			return a.priority.importance > b.priority.importance;
+		});
+
+		uint32_t facesLeft = settings.maxFacesPerFrame;
+
+		for (const ShadowCubeRequest& request : m_requests)
+		{
+			SlotState& slotState = m_slots[request.slot];
+
+			if (needsFullUpdate(request))
+			{
+				slotState.lightKey = request.lightKey;
+				memcpy(slotState.renderedFaceKeys, request.faceKeys, sizeof(request.faceKeys));
+				memcpy(slotState.requestedFaceKeys, request.faceKeys, sizeof(request.faceKeys));
+				slotState.faceMask = ALL_CUBE_FACES;
+				slotState.lastServedFrame = m_frameIdx;
+
+				facesLeft -= glm::min(facesLeft, 6u);
+
+				m_stats.numFullUpdates++;
+				m_stats.numFacesRendered += 6;
+				continue;
+			}
+
+			// Faces a caster changed this frame are rendered right away, only the ones that didn't fit in an earlier frame wait for the rate
+			uint32_t dirtyMask = 0;
+			uint32_t changedMask = 0;
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				if (slotState.renderedFaceKeys[i] == request.faceKeys[i])
+				{
+					continue;
+				}
+
+				dirtyMask |= 1 << i;
+				changedMask |= slotState.requestedFaceKeys[i] != request.faceKeys[i] ? 1 << i : 0;
+			}
+
+			memcpy(slotState.requestedFaceKeys, request.faceKeys, sizeof(request.faceKeys));
+
+			if (!dirtyMask)
+			{
+				slotState.lastServedFrame = m_frameIdx;
+				continue;
+			}
+
+			uint32_t maxDeferredFaces = 6;
+			switch (selectShadowCubeUpdateRate(request.priority.cameraDistance, settings))
+			{
+			case OKAY_SHADOW_CUBE_UPDATE_SLICED:
+				maxDeferredFaces = 1;
+				break;
+
+			case OKAY_SHADOW_CUBE_UPDATE_INTERVAL:
+				// Offset by the slot so the distant cubes don't all update on the same frame
+				maxDeferredFaces = (m_frameIdx + request.slot) % glm::max(settings.updateInterval, 1u) == 0 ? 6 : 0;
+				break;
+
+			default:
+				break;
+			}
+
+			// Continue where the last update stopped so every dirty face gets its turn
+			auto renderFaces = [&](uint32_t faceMask, uint32_t maxFaces)
+			{
+				uint32_t firstFace = slotState.nextFace;
+				for (uint32_t i = 0; i < 6 && maxFaces && facesLeft; i++)
+				{
+					uint32_t faceIdx = (firstFace + i) % 6;
+					if (!(faceMask & (1 << faceIdx)))
+					{
+						continue;
+					}
+
+					slotState.renderedFaceKeys[faceIdx] = request.faceKeys[faceIdx];
+					slotState.faceMask |= 1 << faceIdx;
+					slotState.nextFace = (faceIdx + 1) % 6;
+
+					facesLeft--;
+					maxFaces--;
+					m_stats.numFacesRendered++;
+					slotState.lastServedFrame = m_frameIdx;
+				}
+			};
+
+			renderFaces(changedMask, 6);
+			renderFaces(dirtyMask & ~changedMask, maxDeferredFaces);
+
+			uint32_t numDirtyFaces = 0;
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				numDirtyFaces += ((dirtyMask & ~slotState.faceMask) >> i) & 1;
+			}
+
+			m_stats.numFacesDeferred += numDirtyFaces;
+		}
+	}
+
+	uint32_t ShadowCubeScheduler::getFaceMask(uint32_t slot) const
+	{
+		return slot < m_slots.size() ? m_slots[slot].faceMask : 0;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+/*
+	Time-sliced shadow cube updates:
+	Every face of a shadow cube has its own cache key (the casters inside the face frustum, see ShadowCache.h),
+	a face is dirty when its key differs from the one it was last rendered with.
+	A face whose key changed this frame (a caster inside it moved, appeared or left) is rendered that frame, whatever the distance.
+	Changed faces that don't fit in maxFacesPerFrame stay dirty, and how fast those catch up depends on how far the light volume is from the camera:
+		- Full: every dirty face this frame
+		- Sliced: one dirty face per frame, round robin
+		- Interval: every dirty face, but only every updateInterval frames
+
+	The depths in a cube are relative to the light, so if the light itself changed (moved, new range or another light
+	took over the slot) none of the faces are usable anymore. Those cubes always get a full update and are scheduled first,
+	the rest are scheduled by importance until maxFacesPerFrame is reached. Faces that don't fit stay dirty for later frames,
+	and cubes that have waited the longest for a face are scheduled before the important ones so nothing starves.
+*/
+
+namespace Okay
+{
+	enum ShadowCubeUpdateRate : uint32_t
+	{
+		OKAY_SHADOW_CUBE_UPDATE_FULL = 0,
+		OKAY_SHADOW_CUBE_UPDATE_SLICED = 1,
+		OKAY_SHADOW_CUBE_UPDATE_INTERVAL = 2,
+	};
+
+	struct ShadowCubeSchedulerSettings
+	{
+		uint32_t maxFacesPerFrame = 24; // Full updates of changed lights can go over it
+
+		// Distance between the camera and the light volume
+		float fullRateDistance = 500.f;
+		float slicedRateDistance = 1500.f;
+
+		uint32_t updateInterval = 4;
+	};
+
+	struct ShadowCubePriority
+	{
+		float importance = 0.f;
+		float cameraDistance = 0.f;
+	};
+
+	struct ShadowCubeRequest
+	{
+		uint32_t slot = INVALID_UINT32; // Index of the cube in its pool, the scheduler tracks what every slot contains
+		ShadowCubePriority priority;
+
+		uint64_t lightKey = INVALID_UINT64; // Everything the depths are relative to (which light, position & range)
+		uint64_t faceKeys[6] = {};
+	};
+
+	ShadowCubeUpdateRate selectShadowCubeUpdateRate(float cameraDistance, const ShadowCubeSchedulerSettings& settings);
+
+	class ShadowCubeScheduler
+	{
+	public:
+		struct Stats
+		{
+			uint32_t numRequests = 0;
+			uint32_t numFullUpdates = 0;
+
+			uint32_t numFacesRendered = 0;
+			uint32_t numFacesDeferred = 0; // Dirty faces left for later frames
+		};
+
+	public:
+		ShadowCubeScheduler() = default;
+		~ShadowCubeScheduler() = default;
+
+		void beginFrame();
+
+		// One request per active cube per frame
+		void addRequest(const ShadowCubeRequest& request);
+
+		void schedule(const ShadowCubeSchedulerSettings& settings);
+
+		// Faces to render this frame, bit i = face i
+		uint32_t getFaceMask(uint32_t slot) const;
+
+		inline const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct SlotState
+		{
+			uint64_t lightKey = INVALID_UINT64;
+			uint64_t renderedFaceKeys[6] = {};
+			uint64_t requestedFaceKeys[6] = {}; // Last frame's request, faces that differ from it were changed by a caster this frame
+			uint32_t nextFace = 0;
+			uint64_t lastServedFrame = 0; // Last frame the cube was clean or got a face rendered
+
+			uint32_t faceMask = 0;
+		};
+
+		std::vector<SlotState> m_slots;
+		std::vector<ShadowCubeRequest> m_requests;
+
+		uint64_t m_frameIdx = 0;
+		Stats m_stats;
+	};
+}
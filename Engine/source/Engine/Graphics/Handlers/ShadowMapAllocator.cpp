@@ -0,0 +1,97 @@
+#include "ShadowMapAllocator.h"
+
+namespace Okay
+{
+	void ShadowMapAllocator::initialize(uint32_t maxSlots, uint32_t framesBeforeReuse)
+	{
+		m_slots.clear();
+		m_slots.resize(maxSlots);
+
+		m_framesBeforeReuse = framesBeforeReuse;
+		m_frameIdx = 0;
+	}
+
+	void ShadowMapAllocator::beginFrame()
+	{
+		m_frameIdx++;
+	}
+
+	uint32_t ShadowMapAllocator::allocate(uint32_t resolution, bool* pOutNeedsTexture)
+	{
+		*pOutNeedsTexture = false;
+
+		uint32_t emptySlotIdx = INVALID_UINT32;
+		uint32_t recreateSlotIdx = INVALID_UINT32;
+		uint32_t biggerSlotIdx = INVALID_UINT32;
+
+		for (uint32_t i = 0; i < (uint32_t)m_slots.size(); i++)
+		{
+			const Slot& slot = m_slots[i];
+			if (isActive(i))
+			{
+				continue;
+			}
+
+			if (slot.textureResolution == resolution)
+			{
+				m_slots[i].lastUsedFrame = m_frameIdx;
+				return i;
+			}
+
+			if (slot.textureResolution == 0)
+			{
+				emptySlotIdx = emptySlotIdx == INVALID_UINT32 ? i : emptySlotIdx;
+			}
+			else if (canRecreate(slot))
+			{
+				// The one unused for the longest is the least likely to be wanted back at its resolution
+				if (recreateSlotIdx == INVALID_UINT32 || slot.lastUsedFrame < m_slots[recreateSlotIdx].lastUsedFrame)
+				{
+					recreateSlotIdx = i;
+				}
+			}
+			else if (slot.textureResolution > resolution)
+			{
+				if (biggerSlotIdx == INVALID_UINT32 || slot.textureResolution < m_slots[biggerSlotIdx].textureResolution)
+				{
+					biggerSlotIdx = i;
+				}
+			}
+		}
+
+		uint32_t slotIdx = emptySlotIdx != INVALID_UINT32 ? emptySlotIdx : recreateSlotIdx;
+		if (slotIdx != INVALID_UINT32)
+		{
+			m_slots[slotIdx].textureResolution = resolution;
+			*pOutNeedsTexture = true;
+		}
+		else
+		{
+			slotIdx = biggerSlotIdx;
+		}
+
+		if (slotIdx != INVALID_UINT32)
+		{
+			m_slots[slotIdx].lastUsedFrame = m_frameIdx;
+		}
+
+		return slotIdx;
+	}
+
+	uint64_t ShadowMapAllocator::getNumTextureTexels() const
+	{
+		uint64_t numTexels = 0;
+		for (const Slot& slot : m_slots)
+		{
+			numTexels += (uint64_t)slot.textureResolution * slot.textureResolution;
+		}
+
+		return numTexels;
+	}
+
+	bool ShadowMapAllocator::canRecreate(const Slot& slot) const
+	{
+		// Frames in flight might still sample the old texture through the slot's descriptor
+		return slot.lastUsedFrame == INVALID_UINT64 || m_frameIdx - slot.lastUsedFrame >= m_framesBeforeReuse;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+/*
+	Shadow map slots:
+	Every slot owns a texture & the SRV at its index in the shadow map descriptor range. Textures are created at the
+	resolution that was asked for, so a 256x256 shadow map only costs 256x256 texels. Each frame the slots are handed out again:
+
+	1. A free slot whose texture has the asked for resolution
+	2. A slot without a texture, which gets one at that resolution
+	3. A free slot that no frame in flight can reference anymore, its texture is recreated at that resolution
+	4. The smallest free slot with a bigger texture, only the top left region is rendered & sampled
+*/
+
+namespace Okay
+{
+	class ShadowMapAllocator
+	{
+	public:
+		ShadowMapAllocator() = default;
+		~ShadowMapAllocator() = default;
+
+		// A slot can only get a new texture after framesBeforeReuse frames without being used
+		void initialize(uint32_t maxSlots, uint32_t framesBeforeReuse);
+
+		// Frees every slot
+		void beginFrame();
+
+		// Returns INVALID_UINT32 if nothing fits. If pOutNeedsTexture is true the caller has to (re)create the slot's texture,
+		// getTextureResolution then returns the new resolution
+		uint32_t allocate(uint32_t resolution, bool* pOutNeedsTexture);
+
+		inline uint32_t getNumSlots() const { return (uint32_t)m_slots.size(); }
+		inline bool isActive(uint32_t slotIdx) const { return m_slots[slotIdx].lastUsedFrame == m_frameIdx; }
+
+		// 0 if the slot doesn't have a texture yet
+		inline uint32_t getTextureResolution(uint32_t slotIdx) const { return m_slots[slotIdx].textureResolution; }
+
+		// Summed over every slot with a texture, active or not
+		uint64_t getNumTextureTexels() const;
+
+	private:
+		struct Slot
+		{
+			uint32_t textureResolution = 0;
+			uint64_t lastUsedFrame = INVALID_UINT64;
+		};
+
+		bool canRecreate(const Slot& slot) const;
+
+	private:
+		std::vector<Slot> m_slots;
+		uint32_t m_framesBeforeReuse = 0;
+		uint64_t m_frameIdx = 0;
+	};
+}
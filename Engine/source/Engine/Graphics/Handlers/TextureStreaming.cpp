@@ -0,0 +1,273 @@
+#include "TextureStreaming.h"
+
+#include <algorithm>
+
+namespace Okay
+{
+	float computeMeshUVDensity(const MeshData& meshData)
+	{
+		double worldArea = 0.0;
+		double uvArea = 0.0;
+
+		for (uint64_t i = 0; i + 2 < meshData.indicies.size(); i += 3)
+		{
+			const Vertex& v0 = meshData.verticies[meshData.indicies[i + 0]];
+			const Vertex& v1 = meshData.verticies[meshData.indicies[i + 1]];
+			const Vertex& v2 = meshData.verticies[meshData.indicies[i + 2]];
+
+			worldArea += 0.5 * glm::length(glm::cross(v1.position - v0.position, v2.position - v0.position));
+
+			glm::vec2 uvEdge0 = v1.uv - v0.uv;
+			glm::vec2 uvEdge1 = v2.uv - v0.uv;
+			uvArea += 0.5 * glm::abs(uvEdge0.x * uvEdge1.y - uvEdge0.y * uvEdge1.x);
+		}
+
+		return uvArea > 0.0 ? (float)glm::sqrt(worldArea / uvArea) : 0.f;
+	}
+
+	float computeRequiredTextureMip(uint32_t textureWidth, uint32_t textureHeight, float uvDensity, float objectScale, float distance, float projectionScale)
+	{
+		// Unknown mapping, needs everything
+		if (uvDensity <= 0.f)
+		{
+			return 0.f;
+		}
+
+		float texelsPerUV = (float)glm::max(textureWidth, textureHeight);
+		float pixelsPerUV = uvDensity * objectScale * projectionScale / glm::max(distance, 1e-4f);
+
+		return glm::max(glm::log2(texelsPerUV / pixelsPerUV), 0.f);
+	}
+
+	void TextureTilePool::initialize(uint32_t numTiles)
+	{
+		m_numTiles = numTiles;
+		m_freeTiles.resize(numTiles);
+
+		// Popped from the back, so the first tiles go out first
+		for (uint32_t i = 0; i < numTiles; i++)
+		{
+			m_freeTiles[i] = numTiles - 1 - i;
+		}
+	}
+
+	bool TextureTilePool::allocate(uint32_t numTiles, std::vector<uint32_t>& outTiles)
+	{
+		if (numTiles > (uint32_t)m_freeTiles.size())
+		{
+			return false;
+		}
+
+		outTiles.assign(m_freeTiles.end() - numTiles, m_freeTiles.end());
+		m_freeTiles.resize(m_freeTiles.size() - numTiles);
+
+		return true;
+	}
+
+	void TextureTilePool::free(const std::vector<uint32_t>& tiles)
+	{
+		m_freeTiles.insert(m_freeTiles.end(), tiles.begin(), tiles.end());
+		OKAY_ASSERT(m_freeTiles.size() <= m_numTiles);
+	}
+
+	uint32_t TextureStreamer::addTexture(const StreamedTextureDesc& desc)
+	{
+		OKAY_ASSERT(desc.mipTiles.size() == desc.mipUploadSizes.size());
+
+		StreamedTexture& texture = m_textures.emplace_back();
+		texture.mipTiles = desc.mipTiles;
+		texture.mipUploadSizes = desc.mipUploadSizes;
+		texture.residentMip = (uint32_t)desc.mipTiles.size();
+		texture.targetMip = texture.residentMip;
+
+		return (uint32_t)m_textures.size() - 1;
+	}
+
+	void TextureStreamer::beginFrame()
+	{
+		m_frameIdx++;
+
+		for (StreamedTexture& texture : m_textures)
+		{
+			texture.requestedMip = INVALID_UINT32;
+		}
+	}
+
+	void TextureStreamer::requestMip(uint32_t textureIdx, float mip)
+	{
+		StreamedTexture& texture = m_textures[textureIdx];
+
+		uint32_t mipIdx = (uint32_t)glm::clamp(glm::floor(mip), 0.f, (float)texture.mipTiles.size());
+		texture.requestedMip = glm::min(texture.requestedMip, mipIdx);
+		texture.lastRequestFrame = m_frameIdx;
+	}
+
+	void TextureStreamer::update(const TextureStreamingSettings& settings, uint32_t numFreeTiles)
+	{
+		m_mipChanges.clear();
+
+		m_stats = {};
+		m_stats.numTextures = (uint32_t)m_textures.size();
+
+		fitBudget(settings.budgetTiles);
+
+		// Evicted right away, the frames in flight that still sample them run before the unmapping on the queue
+		for (uint32_t i = 0; i < (uint32_t)m_textures.size(); i++)
+		{
+			StreamedTexture& texture = m_textures[i];
+
+			while (texture.residentMip < texture.targetMip)
+			{
+				m_mipChanges.push_back({ i, texture.residentMip, false });
+				texture.residentMip++;
+				m_stats.numMipsEvicted++;
+			}
+		}
+
+		streamIn(settings.maxUploadBytes, numFreeTiles);
+
+		for (const StreamedTexture& texture : m_textures)
+		{
+			m_stats.residentTiles += getTiles(texture, texture.residentMip);
+
+			if (texture.requestedMip != INVALID_UINT32)
+			{
+				m_stats.numRequested++;
+				m_stats.requestedTiles += getTiles(texture, texture.requestedMip);
+			}
+		}
+	}
+
+	uint64_t TextureStreamer::getTiles(const StreamedTexture& texture, uint32_t mip)
+	{
+		uint64_t numTiles = 0;
+		for (uint32_t i = mip; i < (uint32_t)texture.mipTiles.size(); i++)
+		{
+			numTiles += texture.mipTiles[i];
+		}
+
+		return numTiles;
+	}
+
+	void TextureStreamer::fitBudget(uint64_t budgetTiles)
+	{
+		// Requested textures want their requested mip but keep any extra detail they already have, the rest keep what they have
+		uint64_t totalTiles = 0;
+		for (StreamedTexture& texture : m_textures)
+		{
+			texture.targetMip = texture.requestedMip != INVALID_UINT32 ? glm::min(texture.requestedMip, texture.residentMip) : texture.residentMip;
+			totalTiles += getTiles(texture, texture.targetMip);
+		}
+
+		if (totalTiles <= budgetTiles)
+		{
+			return;
+		}
+
+		// Textures nobody asked for, least recently requested first
+		std::vector<uint32_t> unrequested;
+		for (uint32_t i = 0; i < (uint32_t)m_textures.size(); i++)
+		{
+			const StreamedTexture& texture = m_textures[i];
+			if (texture.requestedMip == INVALID_UINT32 && texture.targetMip < (uint32_t)texture.mipTiles.size())
+			{
+				unrequested.push_back(i);
+			}
+		}
+
+		std::stable_sort(unrequested.begin(), unrequested.end(), [&](uint32_t a, uint32_t b)
+		{
+			return m_textures[a].lastRequestFrame < m_textures[b].lastRequestFrame;
+		});
+
+		for (uint32_t i = 0; i < (uint32_t)unrequested.size() && totalTiles > budgetTiles; i++)
+		{
+			StreamedTexture& texture = m_textures[unrequested[i]];
+
+			totalTiles -= getTiles(texture, texture.targetMip);
+			texture.targetMip = (uint32_t)texture.mipTiles.size();
+		}
+
+		// Extra detail of requested textures
+		for (uint32_t i = 0; i < (uint32_t)m_textures.size() && totalTiles > budgetTiles; i++)
+		{
+			StreamedTexture& texture = m_textures[i];
+			if (texture.requestedMip != INVALID_UINT32 && texture.targetMip < texture.requestedMip)
+			{
+				totalTiles -= getTiles(texture, texture.targetMip) - getTiles(texture, texture.requestedMip);
+				texture.targetMip = texture.requestedMip;
+			}
+		}
+
+		// Every requested texture drops a mip until it fits, so they all lose detail evenly
+		while (totalTiles > budgetTiles)
+		{
+			m_stats.budgetBias++;
+
+			for (StreamedTexture& texture : m_textures)
+			{
+				uint32_t tailMip = (uint32_t)texture.mipTiles.size();
+				if (texture.requestedMip == INVALID_UINT32 || texture.targetMip >= tailMip)
+				{
+					continue;
+				}
+
+				uint32_t biasedMip = glm::min(texture.requestedMip + m_stats.budgetBias, tailMip);
+				totalTiles -= getTiles(texture, texture.targetMip) - getTiles(texture, biasedMip);
+				texture.targetMip = biasedMip;
+			}
+		}
+	}
+
+	void TextureStreamer::streamIn(uint64_t maxUploadBytes, uint32_t numFreeTiles)
+	{
+		// Textures missing the most mips go first, one mip each per pass so they all make progress
+		std::vector<uint32_t> loading;
+		for (uint32_t i = 0; i < (uint32_t)m_textures.size(); i++)
+		{
+			if (m_textures[i].targetMip < m_textures[i].residentMip)
+			{
+				loading.push_back(i);
+			}
+		}
+
+		std::stable_sort(loading.begin(), loading.end(), [&](uint32_t a, uint32_t b)
+		{
+			return m_textures[a].residentMip - m_textures[a].targetMip > m_textures[b].residentMip - m_textures[b].targetMip;
+		});
+
+		bool madeProgress = true;
+		while (madeProgress)
+		{
+			madeProgress = false;
+
+			for (uint32_t textureIdx : loading)
+			{
+				StreamedTexture& texture = m_textures[textureIdx];
+				if (texture.targetMip >= texture.residentMip)
+				{
+					continue;
+				}
+
+				uint32_t mip = texture.residentMip - 1;
+				uint32_t numTiles = texture.mipTiles[mip];
+				uint64_t uploadSize = texture.mipUploadSizes[mip];
+
+				// The first mip of the frame always goes, even if it's over the upload limit on its own
+				if (numTiles > numFreeTiles || (m_stats.numMipsLoaded && m_stats.uploadedBytes + uploadSize > maxUploadBytes))
+				{
+					continue;
+				}
+
+				m_mipChanges.push_back({ textureIdx, mip, true });
+				texture.residentMip = mip;
+
+				numFreeTiles -= numTiles;
+				m_stats.uploadedBytes += uploadSize;
+				m_stats.numMipsLoaded++;
+
+				madeProgress = true;
+			}
+		}
+	}
+}
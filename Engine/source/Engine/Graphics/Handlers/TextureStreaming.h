@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Resources/Mesh.h"
+
+#include <vector>
+
+/*
+	Texture streaming:
+	Streamed textures are reserved resources, only their packed mip tail is mapped & uploaded at startup.
+	The standard mips are mapped to 64KB tiles of a shared pool (TextureTilePool) & uploaded from the CPU copy when needed.
+
+	Every frame the visible instances request the most detailed mip they need (computeRequiredTextureMip), from the size of
+	their texture, the UV density of their mesh & their distance to the camera. TextureStreamer then picks the mips to keep
+	under the tile budget & streams towards them, a limited amount of bytes per frame. The shader clamps every texture
+	to its resident mip (texture min LOD), so mips that aren't loaded yet or are being evicted are never sampled.
+
+	Over the budget, textures that weren't requested are evicted first (least recently requested first), then the extra
+	detail requested textures kept from before, and last every requested texture drops mips together (budget bias).
+*/
+
+namespace Okay
+{
+	// World units per UV unit of the mesh (sqrt of world area / UV area over every triangle), 0 if the UVs have no area
+	float computeMeshUVDensity(const MeshData& meshData);
+
+	// Fractional mip where one texel covers about one pixel, 0 is the full size. uvDensity is computeMeshUVDensity
+	// & projectionScale is pixels per world unit at distance 1 (getLODProjectionScale in MeshSimplifier.h)
+	float computeRequiredTextureMip(uint32_t textureWidth, uint32_t textureHeight, float uvDensity, float objectScale, float distance, float projectionScale);
+
+	// Free list of the pool's tiles, tiles can be anywhere in the pool since they're mapped one by one
+	class TextureTilePool
+	{
+	public:
+		TextureTilePool() = default;
+		~TextureTilePool() = default;
+
+		void initialize(uint32_t numTiles);
+
+		// All or nothing, returns false if there aren't enough free tiles
+		bool allocate(uint32_t numTiles, std::vector<uint32_t>& outTiles);
+		void free(const std::vector<uint32_t>& tiles);
+
+		inline uint32_t getNumTiles() const { return m_numTiles; }
+		inline uint32_t getNumFreeTiles() const { return (uint32_t)m_freeTiles.size(); }
+
+	private:
+		uint32_t m_numTiles = 0;
+		std::vector<uint32_t> m_freeTiles;
+	};
+
+	struct TextureStreamingSettings
+	{
+		uint64_t budgetTiles = 0; // Standard mips only, the mip tails are always resident
+		uint64_t maxUploadBytes = 0; // Per frame, one mip is still streamed in if it's bigger on its own
+	};
+
+	struct StreamedTextureDesc
+	{
+		// Per standard mip, the mips after them are the always resident mip tail
+		std::vector<uint32_t> mipTiles;
+		std::vector<uint64_t> mipUploadSizes;
+	};
+
+	class TextureStreamer
+	{
+	public:
+		// One mip streamed in (isLoad) or evicted, mips are loaded from the tail up & evicted from the full size down
+		struct MipChange
+		{
+			uint32_t textureIdx = INVALID_UINT32;
+			uint32_t mip = INVALID_UINT32;
+			bool isLoad = false;
+		};
+
+		struct Stats
+		{
+			uint32_t numTextures = 0;
+			uint32_t numRequested = 0;
+
+			uint64_t residentTiles = 0;
+			uint64_t requestedTiles = 0; // If every requested texture had its requested mip
+			uint32_t budgetBias = 0; // Mips every requested texture was dropped by to fit the budget
+
+			uint32_t numMipsLoaded = 0;
+			uint32_t numMipsEvicted = 0;
+			uint64_t uploadedBytes = 0;
+		};
+
+	public:
+		TextureStreamer() = default;
+		~TextureStreamer() = default;
+
+		// Starts with only the mip tail resident, returns the texture index used by the other functions
+		uint32_t addTexture(const StreamedTextureDesc& desc);
+
+		void beginFrame();
+
+		// Keeps the most detailed mip requested this frame
+		void requestMip(uint32_t textureIdx, float mip);
+
+		// Picks the target mips & fills getMipChanges(). numFreeTiles are the pool tiles that can be mapped right now
+		void update(const TextureStreamingSettings& settings, uint32_t numFreeTiles);
+
+		inline const std::vector<MipChange>& getMipChanges() const { return m_mipChanges; }
+
+		// Most detailed resident mip, the number of standard mips if only the tail is
+		inline uint32_t getResidentMip(uint32_t textureIdx) const { return m_textures[textureIdx].residentMip; }
+		inline uint32_t getNumStandardMips(uint32_t textureIdx) const { return (uint32_t)m_textures[textureIdx].mipTiles.size(); }
+
+		inline const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct StreamedTexture
+		{
+			std::vector<uint32_t> mipTiles;
+			std::vector<uint64_t> mipUploadSizes;
+
+			uint32_t residentMip = 0;
+			uint32_t targetMip = 0;
+			uint32_t requestedMip = INVALID_UINT32; // INVALID_UINT32 if not requested this frame
+			uint64_t lastRequestFrame = 0;
+		};
+
+		// Tiles of the standard mips from mip down
+		static uint64_t getTiles(const StreamedTexture& texture, uint32_t mip);
+
+		void fitBudget(uint64_t budgetTiles);
+		void streamIn(uint64_t maxUploadBytes, uint32_t numFreeTiles);
+
+	private:
+		std::vector<StreamedTexture> m_textures;
+		std::vector<MipChange> m_mipChanges;
+
+		uint64_t m_frameIdx = 0;
+		Stats m_stats;
+	};
+}
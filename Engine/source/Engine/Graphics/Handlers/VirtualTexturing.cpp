@@ -0,0 +1,445 @@
+#include "VirtualTexturing.h"
+#include "Engine/Resources/TextureCompression.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Okay
+{
+	// Less detailed than any mip, replaced by the first page loaded above it (the least detailed one)
+	static const uint32_t NO_INDIRECTION_ENTRY = packIndirectionEntry(0, 0, 0xFF);
+
+	// Non negative modulo, page borders reach past both edges of the mip
+	static uint32_t wrapCoordinate(int64_t coordinate, uint32_t size)
+	{
+		int64_t wrapped = coordinate % (int64_t)size;
+		return (uint32_t)(wrapped < 0 ? wrapped + size : wrapped);
+	}
+
+	uint32_t getNumVirtualMips(uint32_t width, uint32_t height)
+	{
+		uint32_t numMips = 1;
+		while (getNumVirtualPages(width, numMips - 1) > 1 || getNumVirtualPages(height, numMips - 1) > 1)
+		{
+			numMips++;
+		}
+
+		return numMips;
+	}
+
+	void copyVirtualPage(const TextureMipChain& mipChain, uint32_t mip, uint32_t pageX, uint32_t pageY, uint8_t* pOutTexels)
+	{
+		const TextureMipLevel& level = mipChain.levels[mip];
+		const uint8_t* pLevelData = mipChain.data.data() + level.offset;
+
+		int64_t firstX = (int64_t)pageX * VIRTUAL_PAGE_SIZE - VIRTUAL_PAGE_BORDER;
+		int64_t firstY = (int64_t)pageY * VIRTUAL_PAGE_SIZE - VIRTUAL_PAGE_BORDER;
+
+		if (mipChain.format == OKAY_TEXTURE_FORMAT_RGBA8)
+		{
+			for (uint32_t y = 0; y < VIRTUAL_PAGE_STRIDE; y++)
+			{
+				const uint8_t* pSrcRow = pLevelData + (size_t)wrapCoordinate(firstY + y, level.height) * level.width * 4;
+				uint8_t* pDstRow = pOutTexels + (size_t)y * VIRTUAL_PAGE_STRIDE * 4;
+
+				// In runs up to the edge of the mip
+				for (uint32_t x = 0; x < VIRTUAL_PAGE_STRIDE;)
+				{
+					uint32_t srcX = wrapCoordinate(firstX + x, level.width);
+					uint32_t runLength = glm::min(VIRTUAL_PAGE_STRIDE - x, level.width - srcX);
+
+					memcpy(pDstRow + (size_t)x * 4, pSrcRow + (size_t)srcX * 4, (size_t)runLength * 4);
+					x += runLength;
+				}
+			}
+
+			return;
+		}
+
+		OKAY_ASSERT(isBlockCompressed(mipChain.format));
+
+		// The border is a whole block, so the page is gathered block by block & decoded at once
+		static const uint32_t PAGE_BLOCKS = VIRTUAL_PAGE_STRIDE / 4;
+
+		uint32_t blockSize = getTextureFormatBlockSize(mipChain.format);
+		uint32_t levelBlocksX = (level.width + 3) / 4;
+		uint32_t levelBlocksY = (level.height + 3) / 4;
+
+		std::vector<uint8_t> pageBlocks((size_t)PAGE_BLOCKS * PAGE_BLOCKS * blockSize);
+		for (uint32_t y = 0; y < PAGE_BLOCKS; y++)
+		{
+			const uint8_t* pSrcRow = pLevelData + (size_t)wrapCoordinate(firstY / 4 + y, levelBlocksY) * levelBlocksX * blockSize;
+			uint8_t* pDstRow = pageBlocks.data() + (size_t)y * PAGE_BLOCKS * blockSize;
+
+			for (uint32_t x = 0; x < PAGE_BLOCKS;)
+			{
+				uint32_t srcX = wrapCoordinate(firstX / 4 + x, levelBlocksX);
+				uint32_t runLength = glm::min(PAGE_BLOCKS - x, levelBlocksX - srcX);
+
+				memcpy(pDstRow + (size_t)x * blockSize, pSrcRow + (size_t)srcX * blockSize, (size_t)runLength * blockSize);
+				x += runLength;
+			}
+		}
+
+		decompressTextureLevel(pageBlocks.data(), VIRTUAL_PAGE_STRIDE, VIRTUAL_PAGE_STRIDE, mipChain.format, pOutTexels);
+	}
+
+	void VirtualPageCache::initialize(uint32_t numSlots)
+	{
+		m_slots.assign(numSlots, Slot());
+		m_pageSlots.clear();
+
+		m_lruFront = INVALID_UINT32;
+		m_lruBack = INVALID_UINT32;
+
+		// Free slots are evicted first, in order
+		for (uint32_t i = 0; i < numSlots; i++)
+		{
+			pushBack(i);
+		}
+	}
+
+	uint32_t VirtualPageCache::findPage(uint32_t pageID) const
+	{
+		auto iterator = m_pageSlots.find(pageID);
+		return iterator != m_pageSlots.end() ? iterator->second : INVALID_UINT32;
+	}
+
+	void VirtualPageCache::touch(uint32_t slot, uint64_t frameIdx)
+	{
+		Slot& cacheSlot = m_slots[slot];
+		cacheSlot.lastUsedFrame = frameIdx;
+
+		if (!cacheSlot.isLocked)
+		{
+			unlink(slot);
+			pushBack(slot);
+		}
+	}
+
+	uint32_t VirtualPageCache::allocate(uint32_t pageID, uint64_t frameIdx, bool isLocked, uint32_t* pOutEvictedPage)
+	{
+		OKAY_ASSERT(findPage(pageID) == INVALID_UINT32);
+
+		*pOutEvictedPage = INVALID_UINT32;
+
+		// Everything after the front was used at least as recently, so if the front is in use this frame the cache is full
+		uint32_t slot = m_lruFront;
+		if (slot == INVALID_UINT32 || (m_slots[slot].pageID != INVALID_UINT32 && m_slots[slot].lastUsedFrame >= frameIdx))
+		{
+			return INVALID_UINT32;
+		}
+
+		Slot& cacheSlot = m_slots[slot];
+		if (cacheSlot.pageID != INVALID_UINT32)
+		{
+			*pOutEvictedPage = cacheSlot.pageID;
+			m_pageSlots.erase(cacheSlot.pageID);
+		}
+
+		cacheSlot.pageID = pageID;
+		cacheSlot.lastUsedFrame = frameIdx;
+		m_pageSlots[pageID] = slot;
+
+		unlink(slot);
+		cacheSlot.isLocked = isLocked;
+
+		if (!isLocked)
+		{
+			pushBack(slot);
+		}
+
+		return slot;
+	}
+
+	void VirtualPageCache::unlink(uint32_t slot)
+	{
+		Slot& cacheSlot = m_slots[slot];
+
+		(cacheSlot.prev != INVALID_UINT32 ? m_slots[cacheSlot.prev].next : m_lruFront) = cacheSlot.next;
+		(cacheSlot.next != INVALID_UINT32 ? m_slots[cacheSlot.next].prev : m_lruBack) = cacheSlot.prev;
+
+		cacheSlot.prev = INVALID_UINT32;
+		cacheSlot.next = INVALID_UINT32;
+	}
+
+	void VirtualPageCache::pushBack(uint32_t slot)
+	{
+		Slot& cacheSlot = m_slots[slot];
+		cacheSlot.prev = m_lruBack;
+		cacheSlot.next = INVALID_UINT32;
+
+		(m_lruBack != INVALID_UINT32 ? m_slots[m_lruBack].next : m_lruFront) = slot;
+		m_lruBack = slot;
+	}
+
+	void VirtualTextureSystem::initialize(uint32_t numSlotsX, uint32_t numSlotsY)
+	{
+		OKAY_ASSERT(numSlotsX && numSlotsY && numSlotsX <= MAX_VIRTUAL_CACHE_SLOTS && numSlotsY <= MAX_VIRTUAL_CACHE_SLOTS);
+
+		m_numSlotsX = numSlotsX;
+		m_numSlotsY = numSlotsY;
+		m_cache.initialize(numSlotsX * numSlotsY);
+	}
+
+	uint32_t VirtualTextureSystem::addTexture(uint32_t width, uint32_t height)
+	{
+		OKAY_ASSERT(m_textures.size() < MAX_VIRTUAL_TEXTURES);
+		OKAY_ASSERT(getNumVirtualPages(width, 0) <= MAX_VIRTUAL_PAGES && getNumVirtualPages(height, 0) <= MAX_VIRTUAL_PAGES);
+
+		uint32_t textureIdx = (uint32_t)m_textures.size();
+		VirtualTexture& texture = m_textures.emplace_back();
+
+		uint32_t numMips = getNumVirtualMips(width, height);
+		OKAY_ASSERT(numMips <= MAX_VIRTUAL_MIPS);
+
+		texture.mips.resize(numMips);
+		for (uint32_t i = 0; i < numMips; i++)
+		{
+			IndirectionMip& mip = texture.mips[i];
+			mip.pagesX = getNumVirtualPages(width, i);
+			mip.pagesY = getNumVirtualPages(height, i);
+			mip.entries.resize((size_t)mip.pagesX * mip.pagesY, NO_INDIRECTION_ENTRY);
+		}
+
+		// Every entry falls back to the least detailed page
+		uint32_t rootPageID = packVirtualPage(textureIdx, numMips - 1, 0, 0);
+		uint32_t evictedPage = INVALID_UINT32;
+
+		uint32_t slot = m_cache.allocate(rootPageID, m_frameIdx, true, &evictedPage);
+		OKAY_ASSERT(slot != INVALID_UINT32 && evictedPage == INVALID_UINT32); // Too many textures for the cache
+
+		loadPage(rootPageID, slot);
+
+		m_stats.numTextures = (uint32_t)m_textures.size();
+		m_stats.numResidentPages = m_cache.getNumResidentPages();
+
+		return textureIdx;
+	}
+
+	void VirtualTextureSystem::beginFrame()
+	{
+		m_frameIdx++;
+
+		m_pageLoads.clear();
+		m_indirectionUpdates.clear();
+
+		for (VirtualTexture& texture : m_textures)
+		{
+			texture.dirtyMips = 0;
+		}
+	}
+
+	void VirtualTextureSystem::processFeedback(const uint32_t* pFeedback, uint64_t numEntries)
+	{
+		m_feedback.reserve(m_feedback.size() + numEntries);
+
+		for (uint64_t i = 0; i < numEntries; i++)
+		{
+			if (pFeedback[i] != INVALID_UINT32 && isValidPage(unpackVirtualPage(pFeedback[i])))
+			{
+				m_feedback.emplace_back(pFeedback[i]);
+			}
+		}
+	}
+
+	void VirtualTextureSystem::update(const VirtualTextureSettings& settings)
+	{
+		m_stats = {};
+		m_stats.numTextures = (uint32_t)m_textures.size();
+		m_stats.numFeedbackEntries = (uint32_t)m_feedback.size();
+
+		// Sorted so the same pages end up next to each other
+		std::sort(m_feedback.begin(), m_feedback.end());
+		m_missingPages.clear();
+
+		for (uint64_t i = 0; i < m_feedback.size();)
+		{
+			uint32_t pageID = m_feedback[i];
+			uint32_t numRequests = 0;
+
+			for (; i < m_feedback.size() && m_feedback[i] == pageID; i++)
+			{
+				numRequests++;
+			}
+
+			m_stats.numRequestedPages++;
+
+			// The missing pages up to the resident one that's sampled instead, which stays resident as long as it's the fallback
+			VirtualPage page = unpackVirtualPage(pageID);
+			uint32_t slot = m_cache.findPage(pageID);
+
+			while (slot == INVALID_UINT32)
+			{
+				m_missingPages[pageID] += numRequests;
+
+				bool hasParent = getParentPage(page, page);
+				OKAY_ASSERT(hasParent); // The least detailed mip is always resident
+
+				pageID = packVirtualPage(page.textureIdx, page.mip, page.pageX, page.pageY);
+				slot = m_cache.findPage(pageID);
+			}
+
+			m_cache.touch(slot, m_frameIdx);
+		}
+
+		m_feedback.clear();
+
+		// Less detailed first, so pages only get more detailed step by step, then the most requested
+		std::vector<std::pair<uint32_t, uint32_t>> missingPages(m_missingPages.begin(), m_missingPages.end());
+		std::sort(missingPages.begin(), missingPages.end(), [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b)
+		{
+			uint32_t mipA = unpackVirtualPage(a.first).mip;
+			uint32_t mipB = unpackVirtualPage(b.first).mip;
+
+			if (mipA != mipB)
+			{
+				return mipA > mipB;
+			}
+
+			return a.second != b.second ? a.second > b.second : a.first < b.first;
+		});
+
+		m_stats.numMissingPages = (uint32_t)missingPages.size();
+
+		for (const std::pair<uint32_t, uint32_t>& missingPage : missingPages)
+		{
+			if (m_stats.numPageLoads >= settings.maxPageLoads)
+			{
+				break;
+			}
+
+			uint32_t evictedPage = INVALID_UINT32;
+			uint32_t slot = m_cache.allocate(missingPage.first, m_frameIdx, false, &evictedPage);
+
+			// Every slot holds a page that's needed this frame
+			if (slot == INVALID_UINT32)
+			{
+				break;
+			}
+
+			if (evictedPage != INVALID_UINT32)
+			{
+				onPageEvicted(evictedPage);
+				m_stats.numPageEvictions++;
+			}
+
+			loadPage(missingPage.first, slot);
+			m_stats.numPageLoads++;
+		}
+
+		m_stats.numDeferredLoads = m_stats.numMissingPages - m_stats.numPageLoads;
+		m_stats.numResidentPages = m_cache.getNumResidentPages();
+	}
+
+	bool VirtualTextureSystem::isValidPage(const VirtualPage& page) const
+	{
+		if (page.textureIdx >= (uint32_t)m_textures.size())
+		{
+			return false;
+		}
+
+		const VirtualTexture& texture = m_textures[page.textureIdx];
+		if (page.mip >= (uint32_t)texture.mips.size())
+		{
+			return false;
+		}
+
+		return page.pageX < texture.mips[page.mip].pagesX && page.pageY < texture.mips[page.mip].pagesY;
+	}
+
+	bool VirtualTextureSystem::getParentPage(const VirtualPage& page, VirtualPage& outParent) const
+	{
+		if (page.mip + 1 >= (uint32_t)m_textures[page.textureIdx].mips.size())
+		{
+			return false;
+		}
+
+		outParent.textureIdx = page.textureIdx;
+		outParent.mip = page.mip + 1;
+		outParent.pageX = page.pageX / 2;
+		outParent.pageY = page.pageY / 2;
+
+		return true;
+	}
+
+	void VirtualTextureSystem::loadPage(uint32_t pageID, uint32_t slot)
+	{
+		m_pageLoads.push_back({ pageID, slot });
+
+		// Replaces every entry under the page that used a less detailed page
+		VirtualPage page = unpackVirtualPage(pageID);
+		glm::uvec2 slotPosition = getSlotPosition(slot);
+
+		fillIndirection(page, packIndirectionEntry(slotPosition.x, slotPosition.y, page.mip), page.mip, false);
+	}
+
+	void VirtualTextureSystem::onPageEvicted(uint32_t pageID)
+	{
+		// The entries that used the page go back to the closest resident page above it
+		VirtualPage page = unpackVirtualPage(pageID);
+		VirtualPage parent = page;
+
+		uint32_t parentSlot = INVALID_UINT32;
+		while (parentSlot == INVALID_UINT32)
+		{
+			bool hasParent = getParentPage(parent, parent);
+			OKAY_ASSERT(hasParent);
+
+			parentSlot = m_cache.findPage(packVirtualPage(parent.textureIdx, parent.mip, parent.pageX, parent.pageY));
+		}
+
+		glm::uvec2 slotPosition = getSlotPosition(parentSlot);
+		fillIndirection(page, packIndirectionEntry(slotPosition.x, slotPosition.y, parent.mip), page.mip, true);
+	}
+
+	void VirtualTextureSystem::fillIndirection(const VirtualPage& page, uint32_t entry, uint32_t replacedMip, bool exact)
+	{
+		VirtualTexture& texture = m_textures[page.textureIdx];
+
+		for (uint32_t mip = page.mip; mip != INVALID_UINT32; mip--)
+		{
+			IndirectionMip& indirectionMip = texture.mips[mip];
+			uint32_t scale = 1u << (page.mip - mip);
+
+			uint32_t firstX = page.pageX * scale;
+			uint32_t firstY = page.pageY * scale;
+			uint32_t endX = glm::min(firstX + scale, indirectionMip.pagesX);
+			uint32_t endY = glm::min(firstY + scale, indirectionMip.pagesY);
+
+			bool changed = false;
+			for (uint32_t y = firstY; y < endY; y++)
+			{
+				uint32_t* pRow = indirectionMip.entries.data() + (size_t)y * indirectionMip.pagesX;
+
+				for (uint32_t x = firstX; x < endX; x++)
+				{
+					// Entries pointing to a more detailed page than the replaced one have a resident page closer to them
+					uint32_t entryMip = getIndirectionEntryMip(pRow[x]);
+					if (exact ? entryMip == replacedMip : entryMip >= replacedMip)
+					{
+						pRow[x] = entry;
+						changed = true;
+					}
+				}
+			}
+
+			if (changed)
+			{
+				markDirty(page.textureIdx, mip);
+			}
+		}
+	}
+
+	void VirtualTextureSystem::markDirty(uint32_t textureIdx, uint32_t mip)
+	{
+		VirtualTexture& texture = m_textures[textureIdx];
+		if (texture.dirtyMips & (1u << mip))
+		{
+			return;
+		}
+
+		texture.dirtyMips |= 1u << mip;
+		m_indirectionUpdates.push_back({ textureIdx, mip });
+	}
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Resources/TextureMips.h"
+
+#include <vector>
+#include <unordered_map>
+
+/*
+	Virtual texturing:
+	For textures too big for mip streaming to be fine grained enough. Every mip of a virtual texture is split into pages of
+	VIRTUAL_PAGE_SIZE texels, only the pages something looks at are resident, each in a slot of one physical page cache texture.
+	Slots have a VIRTUAL_PAGE_BORDER texel border copied from the neighbouring pages (wrapping at the edges like the repeat
+	address mode), so bilinear filtering never reads the page next to it in the cache.
+
+	Every virtual texture has an indirection texture with one texel per page & one mip per virtual mip. A texel says which
+	slot its page is in, or the slot of the closest less detailed page that is, with the mip of that page (packIndirectionEntry).
+	The least detailed mip is a single page that is always resident, so every lookup lands somewhere.
+
+	The pixel shader writes the page it wanted into the feedback buffer (packVirtualPage, one pixel per block of the screen),
+	read back a few frames later. VirtualTextureSystem counts the requests, loads the missing pages (less detailed pages first
+	since they cover the more detailed ones, then the most requested), a number per frame, into free slots or the slots of
+	the least recently requested pages, & patches the indirection tables around the pages that changed.
+*/
+
+namespace Okay
+{
+	static const uint32_t VIRTUAL_PAGE_SIZE = 128; // Texels per side, without the border
+	static const uint32_t VIRTUAL_PAGE_BORDER = 4; // A BC block, so the pages of compressed textures can be copied block by block
+	static const uint32_t VIRTUAL_PAGE_STRIDE = VIRTUAL_PAGE_SIZE + 2 * VIRTUAL_PAGE_BORDER; // Slot size in the cache
+
+	// Limits of the feedback entries
+	static const uint32_t MAX_VIRTUAL_TEXTURES = 1023; // The last index is the empty entry
+	static const uint32_t MAX_VIRTUAL_MIPS = 16;
+	static const uint32_t MAX_VIRTUAL_PAGES = 512; // Per side in the full size, 64K texels
+
+	// Limit of the indirection entries, per side
+	static const uint32_t MAX_VIRTUAL_CACHE_SLOTS = 4096;
+
+	struct VirtualPage
+	{
+		uint32_t textureIdx = INVALID_UINT32;
+		uint32_t mip = INVALID_UINT32;
+		uint32_t pageX = INVALID_UINT32;
+		uint32_t pageY = INVALID_UINT32;
+	};
+
+	// Feedback entry & the page's ID in the cache. textureIdx:10 | mip:4 | pageX:9 | pageY:9, INVALID_UINT32 is an empty entry
+	inline uint32_t packVirtualPage(uint32_t textureIdx, uint32_t mip, uint32_t pageX, uint32_t pageY)
+	{
+		return textureIdx | (mip << 10) | (pageX << 14) | (pageY << 23);
+	}
+
+	inline VirtualPage unpackVirtualPage(uint32_t pageID)
+	{
+		VirtualPage page;
+		page.textureIdx = pageID & 0x3FF;
+		page.mip = (pageID >> 10) & 0xF;
+		page.pageX = (pageID >> 14) & 0x1FF;
+		page.pageY = pageID >> 23;
+
+		return page;
+	}
+
+	// Indirection texel, slotX:12 | slotY:12 | mip:8 where mip is the mip of the page in the slot
+	inline uint32_t packIndirectionEntry(uint32_t slotX, uint32_t slotY, uint32_t mip)
+	{
+		return slotX | (slotY << 12) | (mip << 24);
+	}
+
+	inline uint32_t getIndirectionEntryMip(uint32_t entry)
+	{
+		return entry >> 24;
+	}
+
+	// Pages along one side of a mip
+	inline uint32_t getNumVirtualPages(uint32_t size, uint32_t mip)
+	{
+		return (glm::max(size >> mip, 1u) + VIRTUAL_PAGE_SIZE - 1) / VIRTUAL_PAGE_SIZE;
+	}
+
+	// Mips down to the first one that fits in a single page
+	uint32_t getNumVirtualMips(uint32_t width, uint32_t height);
+
+	// Copies a page & its border out of a mip chain, wrapping around the edges of the mip. pOutTexels receives
+	// VIRTUAL_PAGE_STRIDE * VIRTUAL_PAGE_STRIDE RGBA8 texels, block compressed chains are decoded
+	void copyVirtualPage(const TextureMipChain& mipChain, uint32_t mip, uint32_t pageX, uint32_t pageY, uint8_t* pOutTexels);
+
+	// The cache's slots in least recently used order, locked slots are never evicted
+	class VirtualPageCache
+	{
+	public:
+		VirtualPageCache() = default;
+		~VirtualPageCache() = default;
+
+		void initialize(uint32_t numSlots);
+
+		// INVALID_UINT32 if the page isn't resident
+		uint32_t findPage(uint32_t pageID) const;
+
+		// Used this frame, moves the slot to the end of the eviction order
+		void touch(uint32_t slot, uint64_t frameIdx);
+
+		// Free slot or the slot of the least recently used page, INVALID_UINT32 if every evictable page was used in frameIdx.
+		// pOutEvictedPage receives the page that was in the slot or INVALID_UINT32
+		uint32_t allocate(uint32_t pageID, uint64_t frameIdx, bool isLocked, uint32_t* pOutEvictedPage);
+
+		inline uint32_t getNumSlots() const { return (uint32_t)m_slots.size(); }
+		inline uint32_t getNumResidentPages() const { return (uint32_t)m_pageSlots.size(); }
+		inline uint32_t getSlotPage(uint32_t slot) const { return m_slots[slot].pageID; }
+
+	private:
+		struct Slot
+		{
+			uint32_t pageID = INVALID_UINT32;
+			uint64_t lastUsedFrame = 0;
+			bool isLocked = false;
+
+			// Eviction order, locked slots aren't in it
+			uint32_t prev = INVALID_UINT32;
+			uint32_t next = INVALID_UINT32;
+		};
+
+		void unlink(uint32_t slot);
+		void pushBack(uint32_t slot);
+
+	private:
+		std::vector<Slot> m_slots;
+		std::unordered_map<uint32_t, uint32_t> m_pageSlots;
+
+		uint32_t m_lruFront = INVALID_UINT32; // Evicted first
+		uint32_t m_lruBack = INVALID_UINT32;
+	};
+
+	struct VirtualTextureSettings
+	{
+		uint32_t maxPageLoads = 32; // Per frame
+	};
+
+	class VirtualTextureSystem
+	{
+	public:
+		// Copy the page into the slot, the indirection tables already point to it
+		struct PageLoad
+		{
+			uint32_t pageID = INVALID_UINT32;
+			uint32_t slot = INVALID_UINT32;
+		};
+
+		// Indirection table mip that changed & has to be uploaded again
+		struct IndirectionUpdate
+		{
+			uint32_t textureIdx = INVALID_UINT32;
+			uint32_t mip = INVALID_UINT32;
+		};
+
+		struct Stats
+		{
+			uint32_t numTextures = 0;
+			uint32_t numFeedbackEntries = 0; // Non empty ones
+			uint32_t numRequestedPages = 0; // Unique
+			uint32_t numMissingPages = 0; // Requested or needed before a requested page, not resident
+			uint32_t numResidentPages = 0;
+
+			uint32_t numPageLoads = 0;
+			uint32_t numPageEvictions = 0;
+			uint32_t numDeferredLoads = 0; // Missing pages left for later frames
+		};
+
+	public:
+		VirtualTextureSystem() = default;
+		~VirtualTextureSystem() = default;
+
+		void initialize(uint32_t numSlotsX, uint32_t numSlotsY);
+
+		// The least detailed mip is loaded right away & never evicted. Returns the index used by the feedback & the other functions
+		uint32_t addTexture(uint32_t width, uint32_t height);
+
+		// Clears the page loads & indirection updates of the last frame
+		void beginFrame();
+
+		// One frame's feedback buffer, entries can repeat & be empty. Entries that don't match a page are ignored
+		void processFeedback(const uint32_t* pFeedback, uint64_t numEntries);
+
+		// Loads the most wanted missing pages & updates the indirection tables, consumes the processed feedback
+		void update(const VirtualTextureSettings& settings);
+
+		inline const std::vector<PageLoad>& getPageLoads() const { return m_pageLoads; }
+		inline const std::vector<IndirectionUpdate>& getIndirectionUpdates() const { return m_indirectionUpdates; }
+
+		// pagesX * pagesY entries, row by row
+		inline const std::vector<uint32_t>& getIndirectionMip(uint32_t textureIdx, uint32_t mip) const { return m_textures[textureIdx].mips[mip].entries; }
+
+		inline uint32_t getNumTextures() const { return (uint32_t)m_textures.size(); }
+		inline uint32_t getNumMips(uint32_t textureIdx) const { return (uint32_t)m_textures[textureIdx].mips.size(); }
+		inline glm::uvec2 getNumPages(uint32_t textureIdx, uint32_t mip) const { return glm::uvec2(m_textures[textureIdx].mips[mip].pagesX, m_textures[textureIdx].mips[mip].pagesY); }
+
+		inline glm::uvec2 getNumSlots() const { return glm::uvec2(m_numSlotsX, m_numSlotsY); }
+		inline glm::uvec2 getSlotPosition(uint32_t slot) const { return glm::uvec2(slot % m_numSlotsX, slot / m_numSlotsX); }
+
+		// Slot holding the page, INVALID_UINT32 if it isn't resident
+		inline uint32_t findPage(uint32_t pageID) const { return m_cache.findPage(pageID); }
+
+		inline const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct IndirectionMip
+		{
+			uint32_t pagesX = 0;
+			uint32_t pagesY = 0;
+			std::vector<uint32_t> entries;
+		};
+
+		struct VirtualTexture
+		{
+			std::vector<IndirectionMip> mips;
+			uint32_t dirtyMips = 0; // Bit per mip, already in m_indirectionUpdates
+		};
+
+		bool isValidPage(const VirtualPage& page) const;
+
+		// Less detailed page covering this one, false for the least detailed mip
+		bool getParentPage(const VirtualPage& page, VirtualPage& outParent) const;
+
+		void loadPage(uint32_t pageID, uint32_t slot);
+		void onPageEvicted(uint32_t pageID);
+
+		// Sets the entries of the page & of the more detailed pages under it to entry, if they point to a page of replacedMip
+		// (exact) or of replacedMip or less detailed (!exact)
+		void fillIndirection(const VirtualPage& page, uint32_t entry, uint32_t replacedMip, bool exact);
+		void markDirty(uint32_t textureIdx, uint32_t mip);
+
+	private:
+		std::vector<VirtualTexture> m_textures;
+		VirtualPageCache m_cache;
+
+		uint32_t m_numSlotsX = 0;
+		uint32_t m_numSlotsY = 0;
+
+		std::vector<uint32_t> m_feedback; // Since the last update
+		std::unordered_map<uint32_t, uint32_t> m_missingPages; // Page -> number of requests it's needed for
+
+		std::vector<PageLoad> m_pageLoads;
+		std::vector<IndirectionUpdate> m_indirectionUpdates;
+
+		uint64_t m_frameIdx = 0;
+		Stats m_stats;
+	};
+}
@@ -19,6 +19,7 @@ namespace Okay
 		D3D12_RELEASE(m_pCommandAllocator);
 		D3D12_RELEASE(m_pRootSignature);
 		D3D12_RELEASE(m_pPSO);
+		D3D12_RELEASE(m_pDrawCommandSignature);
 	}
 
 	void RenderPass::bind(ID3D12GraphicsCommandList* pDirectCommandList, uint32_t numRTVs, const D3D12_CPU_DESCRIPTOR_HANDLE* pRtvHandles, const D3D12_CPU_DESCRIPTOR_HANDLE* pDsvHandle, uint32_t numViewports)
@@ -28,14 +29,63 @@ namespace Okay
 	}
 
 	void RenderPass::updateProperties(D3D12_VIEWPORT viewport, D3D12_RECT scissorRect, D3D12_PRIMITIVE_TOPOLOGY topology)
+	{
+		updateViewport(viewport, scissorRect);
+		
+		//recordBundle(topology);
+	}
+
+	void RenderPass::updateViewport(D3D12_VIEWPORT viewport, D3D12_RECT scissorRect)
 	{
 		for (uint32_t i = 0; i < D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE; i++)
 		{
 			m_viewport[i] = viewport;
 			m_scissorRect[i] = scissorRect;
 		}
-		
-		//recordBundle(topology);
+	}
+
+	void RenderPass::createDrawCommandSignature(ID3D12Device* pDevice, uint32_t drawIdxRootParam)
+	{
+		D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+		arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+		arguments[0].Constant.RootParameterIndex = drawIdxRootParam;
+		arguments[0].Constant.DestOffsetIn32BitValues = 0;
+		arguments[0].Constant.Num32BitValuesToSet = 1;
+
+		arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+		D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+		signatureDesc.ByteStride = sizeof(IndirectDrawCommand);
+		signatureDesc.NumArgumentDescs = _countof(arguments);
+		signatureDesc.pArgumentDescs = arguments;
+
+		// The root signature is needed since the commands change a root argument
+		DX_CHECK(pDevice->CreateCommandSignature(&signatureDesc, m_pRootSignature, IID_PPV_ARGS(&m_pDrawCommandSignature)));
+	}
+
+	uint32_t RenderPass::drawIndirect(ID3D12GraphicsCommandList* pCommandList, RingBuffer& ringBuffer, const IndirectCommandList& commandList, const D3D12_INDEX_BUFFER_VIEW* pIndexViews)
+	{
+		OKAY_ASSERT(m_pDrawCommandSignature);
+
+		uint32_t numExecutes = 0;
+		for (uint32_t i = 0; i < OKAY_INDEX_POOL_COUNT; i++)
+		{
+			const std::vector<IndirectDrawCommand>& commands = commandList.commands[i];
+			if (commands.empty())
+			{
+				continue;
+			}
+
+			uint64_t argumentsOffset = ringBuffer.getOffset();
+			ringBuffer.allocateMapped(commands.data(), commands.size() * sizeof(IndirectDrawCommand));
+
+			pCommandList->IASetIndexBuffer(&pIndexViews[i]);
+			pCommandList->ExecuteIndirect(m_pDrawCommandSignature, (uint32_t)commands.size(), ringBuffer.getDXResource(), argumentsOffset, nullptr, 0);
+
+			numExecutes++;
+		}
+
+		return numExecutes;
 	}
 
 	void RenderPass::bindBase(ID3D12GraphicsCommandList* pDirectCommandList)
@@ -3,6 +3,7 @@
 #include "GPUResourceManager.h"
 #include "CommandContext.h"
 #include "DescriptorHeapStore.h"
+#include "RingBuffer.h"
 
 
 /*
@@ -36,6 +37,15 @@ namespace Okay
 
 		void updateProperties(D3D12_VIEWPORT viewport, D3D12_RECT scissorRect, D3D12_PRIMITIVE_TOPOLOGY topology);
 
+		// Used by the next bindRTVs, for passes that render to differently sized targets
+		void updateViewport(D3D12_VIEWPORT viewport, D3D12_RECT scissorRect);
+
+		// Command signature for drawIndirect, drawIdxRootParam must be a single 32 bit root constant (IndirectDrawCommand::drawIdx)
+		void createDrawCommandSignature(ID3D12Device* pDevice, uint32_t drawIdxRootParam);
+
+		// Writes the commands to the ring buffer and draws every index pool with one ExecuteIndirect, returns the number of ExecuteIndirect calls
+		uint32_t drawIndirect(ID3D12GraphicsCommandList* pCommandList, RingBuffer& ringBuffer, const IndirectCommandList& commandList, const D3D12_INDEX_BUFFER_VIEW* pIndexViews);
+
 	private:
 		void recordBundle(D3D12_PRIMITIVE_TOPOLOGY topology);
 		void createPSO(ID3D12Device* pDevice, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& pipelineDesc);
@@ -46,6 +56,7 @@ namespace Okay
 
 		ID3D12RootSignature* m_pRootSignature = nullptr;
 		ID3D12PipelineState* m_pPSO = nullptr;
+		ID3D12CommandSignature* m_pDrawCommandSignature = nullptr;
 
 		D3D12_VIEWPORT m_viewport[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
 		D3D12_RECT m_scissorRect[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
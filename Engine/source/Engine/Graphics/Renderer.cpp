@@ -1,5 +1,7 @@
 #include "Renderer.h"
 #include "Engine/Resources/ResourceManager.h"
+#include "Engine/Resources/MeshStreams.h"
+#include "Engine/Misc/Frustum.h"
 
 #include "Engine/Application/ImguiHelper.h"
 
@@ -18,8 +20,20 @@ namespace Okay
 		uint32_t numDirectionalLights = 0;
 		uint32_t numSpotLights = 0;
 		float farPlane = 0.f;;
+
+		float padding[2] = {}; // float3 can't cross a 16 byte boundary in HLSL
+		glm::vec3 probeGridMin = glm::vec3(0.f);
+		float probeSpacing = 1.f;
+		glm::uvec3 probeGridSize = glm::uvec3(0);
+		uint32_t virtualFeedbackWidth = 0;
+		glm::uvec2 virtualFeedbackOffset = glm::uvec2(0);
 	};
 
+	// After the shadow maps & the 256 textures in the material heap, the page cache then the indirection textures
+	static const uint32_t VIRTUAL_DESCRIPTORS_OFFSET = LightHandler::MAX_SHADOW_MAPS + LightHandler::MAX_POINT_SHADOW_CUBES + 256;
+
+	static const uint32_t VIRTUAL_PAGE_ROW_PITCH = alignAddress32(VIRTUAL_PAGE_STRIDE * 4, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
 	struct GPUObjectData
 	{
 		glm::mat4 objectMatrix = glm::mat4(1.f);
@@ -55,6 +69,9 @@ namespace Okay
 			frame.ringBuffer.initialize(m_pDevice, 1'000'000);
 			frame.ringBuffer.map();
 
+			frame.textureUploadBuffer.initialize(m_pDevice, TEXTURE_STREAMING_UPLOAD_SIZE);
+			frame.textureUploadBuffer.map();
+
 			frame.commandContext.initialize(m_pDevice, m_pCommandQueue);
 
 			if (i > 0)
@@ -70,18 +87,29 @@ namespace Okay
 
 		m_descriptorHeapStore.initialize(m_pDevice, 50);
 		m_gpuResourceManager.initialize(m_pDevice, m_descriptorHeapStore);
-		
-		m_lightHandler.initiate(m_pDevice, MAX_FRAMES_IN_FLIGHT, m_gpuResourceManager, m_dxMeshes, m_descriptorHeapStore);
-
-		fetchBackBuffersAndDSV();
-		createRenderPasses(); // need to be after fetching backBuffers cuz it needs the main viewport
 
 
-		// (Textures + Shadow maps)
+		// (Shadow maps + Textures + Virtual texturing)
 		// At this point we don't know the real number of textures, so just setting a high upper limit
-		uint32_t numTextures = 256 + LightHandler::MAX_SHADOW_MAPS + LightHandler::MAX_POINT_SHADOW_CUBES;
+		uint32_t numTextures = VIRTUAL_DESCRIPTORS_OFFSET + 1 + MAX_GPU_VIRTUAL_TEXTURES;
 		m_materialTexturesDHH = m_descriptorHeapStore.createDescriptorHeap(numTextures, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true);
 
+		// The shadow maps are shared by all frames, so their SRVs are written straight into the start of the material heap
+		m_lightHandler.initiate(m_pDevice, MAX_FRAMES_IN_FLIGHT, m_gpuResourceManager, m_dxMeshes, m_dxMeshBuffers, m_descriptorHeapStore, m_materialTexturesDHH);
+
+		// Without tier 2 every texture is fully resident like before, the pixel shader then samples without the min LOD clamp
+		D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+		DX_CHECK(m_pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+		m_streamTextures = STREAM_TEXTURES && options.TiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_2;
+
+		fetchBackBuffersAndDSV();
+		createRenderPasses(); // need to be after fetching backBuffers cuz it needs the main viewport
+
+		// Same ambient as before the probes, until the application sets a baked volume
+		IrradianceVolume defaultVolume;
+		createConstantIrradianceVolume(glm::vec3(0.2f), defaultVolume);
+		setIrradianceVolume(defaultVolume);
+
 
 		// In this version of Imgui, only 1 SRV is needed, it's stated that future versions will need more, but I don't see a reason to switch version atm :]
 		DescriptorHeapHandle imguiHeapHandle = m_descriptorHeapStore.createDescriptorHeap(1, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true);
@@ -92,7 +120,11 @@ namespace Okay
 
 	void Renderer::shutdown()
 	{
-		m_frames[m_currentBackBuffer].commandContext.wait();
+		// Wait for every frame, the shared shadow maps & depth buffer can't be released while any of them is in flight
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_frames[i].commandContext.wait();
+		}
 
 		imguiShutdown();
 
@@ -103,12 +135,21 @@ namespace Okay
 
 		m_mainRenderPass.shutdown();
 
+		for (StreamedTexture& streamedTexture : m_streamedTextures)
+		{
+			D3D12_RELEASE(streamedTexture.pDXResource);
+		}
+		D3D12_RELEASE(m_pTexturePool);
+		D3D12_RELEASE(m_pVirtualFeedback);
+
 		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 		{
 			D3D12_RELEASE(m_frames[i].backBuffer);
+			D3D12_RELEASE(m_frames[i].pVirtualFeedbackReadback);
 
 			m_frames[i].commandContext.shutdown();
 			m_frames[i].ringBuffer.shutdown();
+			m_frames[i].textureUploadBuffer.shutdown();
 		}
 
 		D3D12_RELEASE(m_pCommandQueue);
@@ -132,6 +173,7 @@ namespace Okay
 		updateBuffers(scene);
 
 		renderScene(scene, currentMainRtv);
+		drawStatsWindow();
 		postRender();
 	}
 
@@ -143,22 +185,114 @@ namespace Okay
 		m_frames[0].commandContext.execute();
 	}
 
+	void Renderer::setIrradianceVolume(const IrradianceVolume& volume)
+	{
+		OKAY_ASSERT(!volume.probes.empty());
+
+		uint64_t probesSize = sizeof(IrradianceProbe) * volume.probes.size();
+
+		RingBuffer probeUploadBuffer;
+		probeUploadBuffer.initialize(m_pDevice, alignAddress64(probesSize, BUFFER_DATA_ALIGNMENT));
+		probeUploadBuffer.map();
+
+		Resource probesR = m_gpuResourceManager.createResource(D3D12_HEAP_TYPE_DEFAULT, alignAddress64(probesSize, BUFFER_DATA_ALIGNMENT));
+		Allocation probesAlloc = m_gpuResourceManager.allocateInto(probesR, OKAY_RESOURCE_APPEND, sizeof(IrradianceProbe), (uint32_t)volume.probes.size(), volume.probes.data(), &probeUploadBuffer, &m_frames[0].commandContext);
+
+		m_frames[0].commandContext.flush();
+		probeUploadBuffer.shutdown();
+
+		m_irradianceProbesGVA = m_gpuResourceManager.getVirtualAddress(probesAlloc);
+		m_probeGridMin = volume.gridMin;
+		m_probeSpacing = volume.probeSpacing;
+		m_probeGridSize = volume.gridSize;
+	}
+
 	void Renderer::drawDrawGroups(ID3D12GraphicsCommandList* pCommandList)
 	{
-		const FrameResources& frame = m_frames[m_currentBackBuffer];
-		for (uint32_t i = 0; i < frame.drawGroups.numActive; i++)
+		FrameResources& frame = m_frames[m_currentBackBuffer];
+
+		// Set once for the whole pass, the draws only change the draw index root constant
+		pCommandList->SetGraphicsRootShaderResourceView(1, m_dxMeshBuffers.verticiesGVA);
+		pCommandList->SetGraphicsRootShaderResourceView(2, frame.objectDatasGVA);
+		pCommandList->SetGraphicsRootShaderResourceView(9, frame.drawDatasGVA);
+
+		frame.drawBuilder.buildCommands(m_mainCommandList);
+
+		m_numMainDraws = m_mainCommandList.getNumCommands();
+		m_numMainExecuteIndirects = m_mainRenderPass.drawIndirect(pCommandList, frame.ringBuffer, m_mainCommandList, m_dxMeshBuffers.indiciesViews);
+	}
+
+	void Renderer::drawStatsWindow()
+	{
+		if (!ImGui::Begin("Renderer Stats"))
 		{
-			const DrawGroup& drawGroup = frame.drawGroups[i];
+			ImGui::End();
+			return;
+		}
 
-			const DXMesh& dxMesh = m_dxMeshes[drawGroup.dxMeshId];
+		const LightHandler::ShadowStats& shadowStats = m_lightHandler.getShadowStats();
+		const LightHandler::ShadowMemoryReport& shadowMemory = m_lightHandler.getShadowMemoryReport();
+		const LightHandler::LightUpdateStats& lightStats = m_lightHandler.getLightUpdateStats();
+
+		ImGui::SeparatorText("Lights");
+		ImGui::Text("Lights regenerated: %u / %u", lightStats.numLightsRegenerated, lightStats.numLights);
+		ImGui::Text("Light update: %.3f ms", lightStats.updateTimeMs);
 
-			pCommandList->SetGraphicsRootShaderResourceView(1, dxMesh.gpuVerticiesGVA);
-			pCommandList->IASetIndexBuffer(&dxMesh.indiciesView);
+		ImGui::SeparatorText("Meshes");
+		for (uint32_t i = 0; i < MAX_MESH_LODS; i++)
+		{
+			ImGui::Text("LOD %u instances: %u", i, m_lodInstanceCounts[i]);
+		}
+		ImGui::Text("Main pass draws: %u in %u ExecuteIndirect", m_numMainDraws, m_numMainExecuteIndirects);
+
+		const TextureStreamer::Stats& streamingStats = m_textureStreamer.getStats();
+		static const double TILES_TO_MB = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES / (1024.0 * 1024.0);
+
+		ImGui::SeparatorText("Texture streaming");
+		ImGui::Text("Requested textures: %u / %u", streamingStats.numRequested, streamingStats.numTextures);
+		ImGui::Text("Resident mips: %.1f MB / %.1f MB", streamingStats.residentTiles * TILES_TO_MB, (m_textureTilePool.getNumTiles() - m_numTailTiles) * TILES_TO_MB);
+		ImGui::Text("Requested mips: %.1f MB (budget bias %u)", streamingStats.requestedTiles * TILES_TO_MB, streamingStats.budgetBias);
+		ImGui::Text("Mip tails: %.1f MB", m_numTailTiles * TILES_TO_MB);
+		ImGui::Text("Mips loaded: %u (%.1f MB), evicted: %u", streamingStats.numMipsLoaded, streamingStats.uploadedBytes / (1024.0 * 1024.0), streamingStats.numMipsEvicted);
+
+		if (!m_virtualTextures.empty())
+		{
+			const VirtualTextureSystem::Stats& virtualStats = m_virtualTextureSystem.getStats();
+
+			ImGui::SeparatorText("Virtual texturing");
+			ImGui::Text("Virtual textures: %u", virtualStats.numTextures);
+			ImGui::Text("Resident pages: %u / %u", virtualStats.numResidentPages, VIRTUAL_CACHE_SLOTS * VIRTUAL_CACHE_SLOTS);
+			ImGui::Text("Requested pages: %u from %u feedback entries", virtualStats.numRequestedPages, virtualStats.numFeedbackEntries);
+			ImGui::Text("Missing pages: %u (%u deferred)", virtualStats.numMissingPages, virtualStats.numDeferredLoads);
+			ImGui::Text("Pages loaded: %u, evicted: %u", virtualStats.numPageLoads, virtualStats.numPageEvictions);
+		}
 
-			pCommandList->SetGraphicsRootShaderResourceView(2, drawGroup.objectDatasVA);
+		ImGui::SeparatorText("Shadows");
+		ImGui::Text("Shadow maps rendered: %u / %u", shadowStats.numShadowMapsRendered, shadowStats.numShadowMaps);
+		ImGui::Text("Shadow cubes rendered: %u / %u", shadowStats.numShadowCubesRendered, shadowStats.numShadowCubes);
+		ImGui::Text("Shadow cube faces rendered: %u (%u full updates, %u deferred)", shadowStats.numShadowCubeFacesRendered, shadowStats.numShadowCubeFullUpdates, shadowStats.numShadowCubeFacesDeferred);
+		ImGui::Text("Shadow casting lights: %u / %u", shadowStats.numShadowLightsGranted, shadowStats.numShadowLightsRequested);
+		ImGui::Text("Shadow texels: %.1fM / %.1fM", shadowStats.numShadowTexelsGranted / 1000000.0, LightHandler::SHADOW_TEXEL_BUDGET / 1000000.0);
+		ImGui::Text("Rendered shadow texels: %.1fM", shadowStats.numShadowTexels / 1000000.0);
+		ImGui::Text("Shadow draws: %u in %u ExecuteIndirect", shadowStats.numShadowDraws, shadowStats.numShadowExecuteIndirects);
 
-			pCommandList->DrawIndexedInstanced(dxMesh.numIndicies, (uint32_t)drawGroup.entities.size(), 0, 0, 0);
+		for (uint32_t i = 0; i < (uint32_t)shadowStats.shadowMapResolutions.size(); i++)
+		{
+			ImGui::Text("Shadow map %u: %ux%u", i, shadowStats.shadowMapResolutions[i], shadowStats.shadowMapResolutions[i]);
 		}
+
+		// What's alive right now, then the full pools & depth buffer shared by all frames vs a set per frame in flight
+		static const double BYTES_TO_MB = 1.0 / (1024.0 * 1024.0);
+
+		ImGui::SeparatorText("Memory");
+		ImGui::Text("Shadow maps allocated: %.1f MB", shadowMemory.allocatedBytes * BYTES_TO_MB);
+		ImGui::Text("Depth buffer allocated: %.1f MB", m_depthBufferBytes * BYTES_TO_MB);
+		ImGui::Text("Full pools (%u maps, %u cubes) + depth, shared: %.1f MB", LightHandler::MAX_SHADOW_MAPS, LightHandler::MAX_POINT_SHADOW_CUBES,
+			(shadowMemory.fullPoolsBytes + m_depthBufferBytes) * BYTES_TO_MB);
+		ImGui::Text("Full pools + depth, per frame (%u frames): %.1f MB", (uint32_t)MAX_FRAMES_IN_FLIGHT,
+			(shadowMemory.perFrameFullPoolsBytes + m_perFrameDepthBuffersBytes) * BYTES_TO_MB);
+
+		ImGui::End();
 	}
 
 	void Renderer::updateBuffers(const Scene& scene)
@@ -170,9 +304,14 @@ namespace Okay
 		const Transform& camTransform = camEntity.getComponent<Transform>();
 		const Camera& cameraComp = camEntity.getComponent<Camera>();
 
-		
+		assignObjectDrawGroups(scene);
+		updateTextureStreaming();
+		updateVirtualTextures();
+		m_lightHandler.gatherShadowCasters(scene, frame.drawGroups.list, frame.drawGroups.numActive);
+		m_lightHandler.assignShadowBudget(scene, m_viewport.Width, m_viewport.Height);
+
 		frame.pointLightsGVA = m_lightHandler.writePointLightGPUData(frame.ringBuffer, frame.commandContext, scene, &mainRenderData.numPointLights);
-		frame.directionalLightsGVA = m_lightHandler.writeDirLightGPUData(frame.ringBuffer, frame.commandContext, scene, &mainRenderData.numDirectionalLights);
+		frame.directionalLightsGVA = m_lightHandler.writeDirLightGPUData(frame.ringBuffer, frame.commandContext, scene, m_viewport.Width / m_viewport.Height, &mainRenderData.numDirectionalLights);
 		frame.spotLightsGVA = m_lightHandler.writeSpotLightGPUData(frame.ringBuffer, frame.commandContext, scene, &mainRenderData.numSpotLights);
 
 
@@ -180,6 +319,15 @@ namespace Okay
 		mainRenderData.cameraDir = camTransform.forwardVec();
 		mainRenderData.viewProjMatrix = glm::transpose(cameraComp.getProjectionMatrix(m_viewport.Width, m_viewport.Height) * camTransform.getViewMatrix());
 
+		mainRenderData.probeGridMin = m_probeGridMin;
+		mainRenderData.probeSpacing = m_probeSpacing;
+		mainRenderData.probeGridSize = m_probeGridSize;
+
+		// A different pixel of every block each frame (37 is coprime with the 64 pixels), so small things still show up in the feedback
+		uint32_t feedbackPixel = (m_virtualFeedbackFrame++ * 37) % (VIRTUAL_FEEDBACK_SCALE * VIRTUAL_FEEDBACK_SCALE);
+		mainRenderData.virtualFeedbackWidth = m_virtualFeedbackWidth;
+		mainRenderData.virtualFeedbackOffset = glm::uvec2(feedbackPixel % VIRTUAL_FEEDBACK_SCALE, feedbackPixel / VIRTUAL_FEEDBACK_SCALE);
+
 		frame.renderDataGVA = frame.ringBuffer.allocateMapped(&mainRenderData, sizeof(GPURenderData));
 	}
 
@@ -198,7 +346,7 @@ namespace Okay
 
 		float testClearColor[4] = { 0.9f, 0.5f, 0.4f, 1.f };
 		pCommandList->ClearRenderTargetView(currentBackBufferRTV, testClearColor, 0, nullptr);
-		pCommandList->ClearDepthStencilView(frame.dsvCpuHandle, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+		pCommandList->ClearDepthStencilView(m_dsvCpuHandle, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
 	}
 
 	void Renderer::renderScene(const Scene& scene, D3D12_CPU_DESCRIPTOR_HANDLE currentMainRtv)
@@ -206,19 +354,11 @@ namespace Okay
 		FrameResources& frame = m_frames[m_currentBackBuffer];
 		ID3D12GraphicsCommandList* pCommandList = frame.commandContext.getCommandList();
 
-		assignObjectDrawGroups(scene);
-
-		m_lightHandler.drawDepthMaps(frame.commandContext, frame.ringBuffer, frame.drawGroups.list, frame.drawGroups.numActive);
+		m_lightHandler.drawDepthMaps(frame.commandContext, frame.ringBuffer, frame.drawGroups.list, frame.drawGroups.numActive, frame.objectDatasGVA);
 
-		m_mainRenderPass.bind(pCommandList, 1, &currentMainRtv, &frame.dsvCpuHandle, 1);
+		m_mainRenderPass.bind(pCommandList, 1, &currentMainRtv, &m_dsvCpuHandle, 1);
 
 		ID3D12DescriptorHeap* pMaterialDXDescHeap = m_descriptorHeapStore.getDXDescriptorHeap(m_materialTexturesDHH);
-		uint32_t numTotalShadowMaps = LightHandler::MAX_SHADOW_MAPS + LightHandler::MAX_POINT_SHADOW_CUBES;
-		D3D12_CPU_DESCRIPTOR_HANDLE shadowMapSRVsCopyDest = pMaterialDXDescHeap->GetCPUDescriptorHandleForHeapStart();
-		D3D12_CPU_DESCRIPTOR_HANDLE shadowMapSRVs = m_lightHandler.getFrameShadowMapSRVCPUHandle();
-
-		m_pDevice->CopyDescriptorsSimple(numTotalShadowMaps, shadowMapSRVsCopyDest, shadowMapSRVs, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
 
 		pCommandList->SetDescriptorHeaps(1, &pMaterialDXDescHeap);
 
@@ -227,8 +367,13 @@ namespace Okay
 		pCommandList->SetGraphicsRootShaderResourceView(4, frame.pointLightsGVA);
 		pCommandList->SetGraphicsRootShaderResourceView(5, frame.directionalLightsGVA);
 		pCommandList->SetGraphicsRootShaderResourceView(6, frame.spotLightsGVA);
+		pCommandList->SetGraphicsRootShaderResourceView(7, m_irradianceProbesGVA);
+		pCommandList->SetGraphicsRootShaderResourceView(10, frame.textureMinLODsGVA);
+		pCommandList->SetGraphicsRootShaderResourceView(11, frame.virtualTexturesGVA);
+		pCommandList->SetGraphicsRootUnorderedAccessView(12, m_pVirtualFeedback->GetGPUVirtualAddress());
 
 		drawDrawGroups(pCommandList);
+		copyVirtualFeedback();
 	}
 
 	void Renderer::postRender()
@@ -251,6 +396,7 @@ namespace Okay
 
 		frame.commandContext.signal();
 		frame.ringBuffer.jumpToStart();
+		frame.textureUploadBuffer.jumpToStart();
 	}
 
 	void Renderer::assignObjectDrawGroups(const Scene& scene)
@@ -259,20 +405,68 @@ namespace Okay
 
 		auto meshRendererView = scene.getRegistry().view<MeshRenderer, Transform>();
 
+		const Entity camEntity = scene.getActiveCamera();
+		const Transform& camTransform = camEntity.getComponent<Transform>();
+		const Camera& cameraComp = camEntity.getComponent<Camera>();
+
+		glm::vec3 cameraPos = camTransform.position;
+		float projectionScale = getLODProjectionScale(glm::radians(cameraComp.fov), m_viewport.Height);
+
+		// Only instances in view request texture mips
+		Frustum frustum = extractFrustum(cameraComp.getProjectionMatrix(m_viewport.Width, m_viewport.Height) * camTransform.getViewMatrix());
+		m_textureStreamer.beginFrame();
+
+		auto requestTextureMip = [&](uint32_t textureIdx, float uvDensity, float objectScale, float distance)
+		{
+			if (textureIdx >= (uint32_t)m_streamedTextures.size())
+			{
+				return;
+			}
+
+			const StreamedTexture& streamedTexture = m_streamedTextures[textureIdx];
+			m_textureStreamer.requestMip(textureIdx, computeRequiredTextureMip(streamedTexture.width, streamedTexture.height, uvDensity, objectScale, distance, projectionScale));
+		};
+
 		for (DrawGroup& drawGroup : frame.drawGroups.list)
 		{
 			drawGroup.entities.clear();
 		}
 
+		for (uint32_t& lodInstanceCount : m_lodInstanceCounts)
+		{
+			lodInstanceCount = 0;
+		}
+
 		frame.drawGroups.numActive = 0;
 		for (entt::entity entity : meshRendererView)
 		{
-			const MeshRenderer& meshRenderer = meshRendererView.get<MeshRenderer>(entity);
+			auto [meshRenderer, transform] = meshRendererView[entity];
+			const DXMesh& dxMesh = m_dxMeshes[meshRenderer.meshID];
+
+			// Distance to the bounding sphere so big meshes don't drop detail on the side facing the camera
+			float objectScale = glm::max(glm::max(glm::abs(transform.scale.x), glm::abs(transform.scale.y)), glm::abs(transform.scale.z));
+			glm::vec4 worldSphere = transformSphere(dxMesh.boundingSphere, transform.getMatrix());
+			float distance = glm::max(glm::length(glm::vec3(worldSphere) - cameraPos) - worldSphere.w, 0.f);
+
+			float lodErrors[MAX_MESH_LODS] = {};
+			for (uint32_t i = 0; i < dxMesh.numLODs; i++)
+			{
+				lodErrors[i] = dxMesh.lods[i].error;
+			}
+
+			uint32_t lodIdx = selectMeshLOD(lodErrors, dxMesh.numLODs, distance, objectScale, projectionScale, LOD_MAX_PIXEL_ERROR);
+			m_lodInstanceCounts[lodIdx]++;
+
+			if (sphereInFrustum(frustum, glm::vec3(worldSphere), worldSphere.w))
+			{
+				requestTextureMip(meshRenderer.diffuseTextureID, dxMesh.uvDensity, objectScale, distance);
+				requestTextureMip(meshRenderer.normalMapID, dxMesh.uvDensity, objectScale, distance);
+			}
 
 			uint32_t drawGroupIdx = INVALID_UINT32;
 			for (uint32_t i = 0; i < frame.drawGroups.numActive; i++)
 			{
-				if (frame.drawGroups[i].dxMeshId == meshRenderer.meshID)
+				if (frame.drawGroups[i].dxMeshId == meshRenderer.meshID && frame.drawGroups[i].lodIdx == lodIdx)
 				{
 					drawGroupIdx = i;
 					break;
@@ -288,14 +482,16 @@ namespace Okay
 
 				drawGroupIdx = frame.drawGroups.numActive ++;
 				frame.drawGroups[drawGroupIdx].dxMeshId = meshRenderer.meshID;
+				frame.drawGroups[drawGroupIdx].lodIdx = lodIdx;
 			}
 
 			frame.drawGroups[drawGroupIdx].entities.emplace_back(entity);
 		}
 
 
-		// Upload ObjectDatas
-		D3D12_GPU_VIRTUAL_ADDRESS drawGroupObjectDatasVA = frame.ringBuffer.getCurrentGPUAddress();
+		// Upload ObjectDatas, in draw group order
+		frame.objectDatasGVA = frame.ringBuffer.getCurrentGPUAddress();
+		uint32_t numObjects = 0;
 
 		for (uint32_t i = 0; i < frame.drawGroups.numActive; i++)
 		{
@@ -313,11 +509,145 @@ namespace Okay
 				frame.ringBuffer.offsetMappedPtr(sizeof(GPUObjectData));
 			}
 
-			drawGroup.objectDatasVA = drawGroupObjectDatasVA;
-			drawGroupObjectDatasVA += drawGroup.entities.size() * sizeof(GPUObjectData);
+			drawGroup.firstObject = numObjects;
+			numObjects += (uint32_t)drawGroup.entities.size();
 		}
 
 		frame.ringBuffer.alignOffset();
+
+
+		// One draw per draw group, the draw index is the draw group index
+		frame.drawBuilder.reset();
+
+		for (uint32_t i = 0; i < frame.drawGroups.numActive; i++)
+		{
+			const DrawGroup& drawGroup = frame.drawGroups[i];
+			const DXMesh& dxMesh = m_dxMeshes[drawGroup.dxMeshId];
+			const DXMeshLOD& dxLOD = dxMesh.lods[drawGroup.lodIdx];
+
+			IndirectDrawDesc drawDesc;
+			drawDesc.indexPool = dxMesh.indexPool;
+			drawDesc.firstIndex = dxMesh.firstIndex + dxLOD.firstIndex;
+			drawDesc.numIndicies = dxLOD.numIndicies;
+			drawDesc.baseVertex = dxMesh.baseVertex;
+			drawDesc.firstObject = drawGroup.firstObject;
+			drawDesc.numInstances = (uint32_t)drawGroup.entities.size();
+			drawDesc.quantization = dxMesh.quantization;
+
+			frame.drawBuilder.addDraw(drawDesc);
+		}
+
+		const std::vector<IndirectDrawData>& drawDatas = frame.drawBuilder.getDrawDatas();
+		frame.drawDatasGVA = frame.ringBuffer.allocateMapped(drawDatas.data(), drawDatas.size() * sizeof(IndirectDrawData));
+	}
+
+	void Renderer::updateTextureStreaming()
+	{
+		FrameResources& frame = m_frames[m_currentBackBuffer];
+
+		TextureStreamingSettings settings;
+		settings.budgetTiles = m_textureTilePool.getNumTiles() - m_numTailTiles;
+		settings.maxUploadBytes = TEXTURE_STREAMING_UPLOAD_SIZE;
+
+		m_textureStreamer.update(settings, m_textureTilePool.getNumFreeTiles());
+
+		// Frames already submitted may still sample evicted mips, but the unmapping runs on the queue after them
+		// & this frame's min LODs already skip them, so their tiles can be reused right away
+		for (const TextureStreamer::MipChange& change : m_textureStreamer.getMipChanges())
+		{
+			StreamedTexture& streamedTexture = m_streamedTextures[change.textureIdx];
+			std::vector<uint32_t>& tiles = streamedTexture.mipTiles[change.mip];
+
+			if (!change.isLoad)
+			{
+				updateTextureTileMappings(streamedTexture.pDXResource, change.mip, (uint32_t)tiles.size(), nullptr);
+				m_textureTilePool.free(tiles);
+				tiles.clear();
+				continue;
+			}
+
+			D3D12_SUBRESOURCE_TILING subresourceTiling = {};
+			uint32_t numSubresourceTilings = 1;
+			m_pDevice->GetResourceTiling(streamedTexture.pDXResource, nullptr, nullptr, nullptr, &numSubresourceTilings, change.mip, &subresourceTiling);
+
+			uint32_t numTiles = subresourceTiling.WidthInTiles * subresourceTiling.HeightInTiles * subresourceTiling.DepthInTiles;
+			bool allocated = m_textureTilePool.allocate(numTiles, tiles);
+			OKAY_ASSERT(allocated); // TextureStreamer only loads what fits in the free tiles
+
+			updateTextureTileMappings(streamedTexture.pDXResource, change.mip, numTiles, tiles.data());
+
+			const TextureMipChain& mipChain = streamedTexture.mipChain;
+			frame.commandContext.transitionSubresource(streamedTexture.pDXResource, change.mip, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+			m_gpuResourceManager.uploadTextureMips(streamedTexture.pDXResource, change.mip, 1, mipChain.data.data() + mipChain.levels[change.mip].offset, frame.textureUploadBuffer, frame.commandContext);
+			frame.commandContext.transitionSubresource(streamedTexture.pDXResource, change.mip, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		}
+
+		for (uint32_t i = 0; i < (uint32_t)m_streamedTextures.size(); i++)
+		{
+			m_textureMinLODs[i] = (float)m_textureStreamer.getResidentMip(i);
+		}
+
+		frame.textureMinLODsGVA = frame.ringBuffer.allocateMapped(m_textureMinLODs.data(), m_textureMinLODs.size() * sizeof(float));
+	}
+
+	void Renderer::updateVirtualTextures()
+	{
+		FrameResources& frame = m_frames[m_currentBackBuffer];
+
+		if (!m_virtualTextures.empty())
+		{
+			m_virtualTextureSystem.beginFrame();
+
+			// Buffers decay to common between command lists, the draws write to it & copyVirtualFeedback copies it after them
+			frame.commandContext.transitionResource(m_pVirtualFeedback, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+			// Written the last time this frame was rendered, which has been waited on
+			if (frame.hasVirtualFeedback)
+			{
+				uint64_t numEntries = (uint64_t)m_virtualFeedbackWidth * m_virtualFeedbackHeight;
+
+				D3D12_RANGE readRange = { 0, numEntries * sizeof(uint32_t) };
+				D3D12_RANGE writeRange = { 0, 0 };
+
+				uint32_t* pFeedback = nullptr;
+				DX_CHECK(frame.pVirtualFeedbackReadback->Map(0, &readRange, (void**)&pFeedback));
+				m_virtualTextureSystem.processFeedback(pFeedback, numEntries);
+				frame.pVirtualFeedbackReadback->Unmap(0, &writeRange);
+			}
+
+			VirtualTextureSettings settings;
+			settings.maxPageLoads = VIRTUAL_PAGE_LOADS;
+
+			m_virtualTextureSystem.update(settings);
+
+			// Before the draws in the same command list, so the frames still in flight are done with evicted slots by then
+			uploadVirtualTextureChanges(frame.commandContext, frame.textureUploadBuffer);
+		}
+
+		frame.virtualTexturesGVA = frame.ringBuffer.allocateMapped(m_gpuVirtualTextures.data(), m_gpuVirtualTextures.size() * sizeof(GPUVirtualTexture));
+	}
+
+	void Renderer::copyVirtualFeedback()
+	{
+		if (m_virtualTextures.empty())
+		{
+			return;
+		}
+
+		FrameResources& frame = m_frames[m_currentBackBuffer];
+		ID3D12GraphicsCommandList* pCommandList = frame.commandContext.getCommandList();
+
+		uint64_t feedbackSize = (uint64_t)m_virtualFeedbackWidth * m_virtualFeedbackHeight * sizeof(uint32_t);
+
+		// Read back what this frame wanted, then clear it for the next one
+		frame.commandContext.transitionResource(m_pVirtualFeedback, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		pCommandList->CopyBufferRegion(frame.pVirtualFeedbackReadback, 0, m_pVirtualFeedback, 0, feedbackSize);
+
+		frame.commandContext.transitionResource(m_pVirtualFeedback, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+		pCommandList->CopyBufferRegion(m_pVirtualFeedback, 0, m_virtualFeedbackClear.pDXResource, m_virtualFeedbackClear.resourceOffset, feedbackSize);
+
+		frame.commandContext.transitionResource(m_pVirtualFeedback, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		frame.hasVirtualFeedback = true;
 	}
 
 	void Renderer::createDevice(IDXGIFactory* pFactory)
@@ -342,6 +672,10 @@ namespace Okay
 
 		logAdapterInfo(pAdapter);
 
+		DXGI_ADAPTER_DESC adapterDesc = {};
+		DX_CHECK(pAdapter->GetDesc(&adapterDesc));
+		m_videoMemorySize = adapterDesc.DedicatedVideoMemory;
+
 		D3D12_RELEASE(pAdapter);
 	}
 
@@ -382,12 +716,6 @@ namespace Okay
 
 	void Renderer::fetchBackBuffersAndDSV()
 	{
-		TextureDescription depthTextureDesc = {};
-		depthTextureDesc.mipLevels = 1;
-		depthTextureDesc.arraySize = 1;
-		depthTextureDesc.format = DXGI_FORMAT_D32_FLOAT;
-		depthTextureDesc.flags = OKAY_TEXTURE_FLAG_DEPTH;
-
 		DescriptorDesc backBufferRTVs[MAX_FRAMES_IN_FLIGHT] = {};
 
 		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
@@ -398,22 +726,36 @@ namespace Okay
 
 			backBufferRTVs[i].type = OKAY_DESCRIPTOR_TYPE_RTV;
 			backBufferRTVs[i].pDXResource = frame.backBuffer;
+		}
 
 
-			// Create depth stencil texture & descriptor
-			D3D12_RESOURCE_DESC resourceDesc = frame.backBuffer->GetDesc();
+		// Create depth stencil texture & descriptor, shared by all frames
+		D3D12_RESOURCE_DESC resourceDesc = m_frames[0].backBuffer->GetDesc();
 
-			depthTextureDesc.width = (uint32_t)resourceDesc.Width;
-			depthTextureDesc.height = resourceDesc.Height;
+		TextureDescription depthTextureDesc = {};
+		depthTextureDesc.width = (uint32_t)resourceDesc.Width;
+		depthTextureDesc.height = resourceDesc.Height;
+		depthTextureDesc.mipLevels = 1;
+		depthTextureDesc.arraySize = 1;
+		depthTextureDesc.format = DXGI_FORMAT_D32_FLOAT;
+		depthTextureDesc.flags = OKAY_TEXTURE_FLAG_DEPTH;
 
-			Allocation dsAllocation = m_gpuResourceManager.createTexture(depthTextureDesc, nullptr, nullptr);
+		Allocation dsAllocation = m_gpuResourceManager.createTexture(depthTextureDesc, nullptr, nullptr);
 
-			DescriptorDesc dsvDesc = m_gpuResourceManager.createDescriptorDesc(dsAllocation, OKAY_DESCRIPTOR_TYPE_DSV, true);
-			frame.dsvCpuHandle = m_descriptorHeapStore.allocateCommittedDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, &dsvDesc, 1).cpuHandle;
+		DescriptorDesc dsvDesc = m_gpuResourceManager.createDescriptorDesc(dsAllocation, OKAY_DESCRIPTOR_TYPE_DSV, true);
+		m_dsvCpuHandle = m_descriptorHeapStore.allocateCommittedDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, &dsvDesc, 1).cpuHandle;
 
-			m_frames[0].commandContext.transitionResource(dsAllocation.pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+		m_frames[0].commandContext.transitionResource(dsAllocation.pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+		D3D12_RESOURCE_DESC depthBufferDescs[MAX_FRAMES_IN_FLIGHT];
+		for (D3D12_RESOURCE_DESC& depthBufferDesc : depthBufferDescs)
+		{
+			depthBufferDesc = dsAllocation.pDXResource->GetDesc();
 		}
 
+		m_depthBufferBytes = getAllocationSize(m_pDevice, dsAllocation.pDXResource);
+		m_perFrameDepthBuffersBytes = getAllocationSize(m_pDevice, depthBufferDescs, MAX_FRAMES_IN_FLIGHT);
+
 		m_rtvBackBufferCPUHandle = m_descriptorHeapStore.allocateCommittedDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, backBufferRTVs, MAX_FRAMES_IN_FLIGHT).cpuHandle;
 
 
@@ -426,7 +768,7 @@ namespace Okay
 
 	void Renderer::createRenderPasses()
 	{
-		D3D12_STATIC_SAMPLER_DESC samplers[3] = {};
+		D3D12_STATIC_SAMPLER_DESC samplers[4] = {};
 		samplers[0] = createDefaultStaticPointSamplerDesc();
 		samplers[0].ShaderRegister = 0;
 
@@ -439,6 +781,10 @@ namespace Okay
 		samplers[2].Filter = D3D12_FILTER_MIN_POINT_MAG_MIP_LINEAR;;
 		samplers[2].ShaderRegister = 2;
 
+		samplers[3] = samplers[0];
+		samplers[3].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+		samplers[3].ShaderRegister = 3;
+
 		std::vector<D3D12_ROOT_PARAMETER> rootParams = {};
 		rootParams.reserve(32);
 
@@ -449,22 +795,30 @@ namespace Okay
 		// Main Render Pass
 
 		rootParams.emplace_back(createRootParamCBV(D3D12_SHADER_VISIBILITY_ALL, 0, 0)); // Main Render Data (GPURenderData)
-		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_ALL, 0, 0)); // Verticies SRV
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_ALL, 0, 0)); // Verticies of every mesh (DXMeshBuffers)
 		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_ALL, 1, 0)); // Object datas (GPUObjcetData)
 
 		// At this point we don't know the real number of textures, so just setting a high upper limit
-		D3D12_DESCRIPTOR_RANGE textureDescriptorRanges[3] =
+		D3D12_DESCRIPTOR_RANGE textureDescriptorRanges[5] =
 		{
 			createRangeSRV(6, 2, LightHandler::MAX_SHADOW_MAPS, 0),
 			createRangeSRV(7, 3, LightHandler::MAX_POINT_SHADOW_CUBES, LightHandler::MAX_SHADOW_MAPS),
 			createRangeSRV(2, 1, 256, LightHandler::MAX_SHADOW_MAPS + LightHandler::MAX_POINT_SHADOW_CUBES),
+			createRangeSRV(11, 4, 1, VIRTUAL_DESCRIPTORS_OFFSET),
+			createRangeSRV(12, 5, MAX_GPU_VIRTUAL_TEXTURES, VIRTUAL_DESCRIPTORS_OFFSET + 1),
 		};
-		// Textures + Shadow maps
+		// Textures + Shadow maps + Virtual page cache & indirection textures
 		rootParams.emplace_back(createRootParamTable(D3D12_SHADER_VISIBILITY_PIXEL, textureDescriptorRanges, _countof(textureDescriptorRanges)));
 
 		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_PIXEL, 3, 0)); // Point lights
 		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_PIXEL, 4, 0)); // Directional lights
 		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_PIXEL, 5, 0)); // Spot lights
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_PIXEL, 8, 0)); // Irradiance probes
+		rootParams.emplace_back(createRootParamConstants(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0, 1)); // Draw index, written by the indirect commands
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 9, 0)); // Draw datas (IndirectDrawData)
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_PIXEL, 10, 0)); // Texture min LODs (texture streaming)
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_PIXEL, 13, 0)); // Virtual textures (GPUVirtualTexture)
+		rootParams.emplace_back(createRootParamUAV(D3D12_SHADER_VISIBILITY_PIXEL, 0, 0)); // Virtual texture feedback
 
 
 		D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
@@ -478,10 +832,12 @@ namespace Okay
 		pipelineDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
 
 		pipelineDesc.VS = compileShader(SHADER_PATH / "VertexShader.hlsl", "vs_5_1", &shaderBlobs[nextBlobIdx++]);
-		pipelineDesc.PS = compileShader(SHADER_PATH / "PixelShader.hlsl", "ps_5_1", &shaderBlobs[nextBlobIdx++]);
+		D3D_SHADER_MACRO streamingDefines[] = { { "TEXTURE_STREAMING", "1" }, { nullptr, nullptr } };
+		pipelineDesc.PS = compileShader(SHADER_PATH / "PixelShader.hlsl", "ps_5_1", &shaderBlobs[nextBlobIdx++], m_streamTextures ? streamingDefines : nullptr);
 
 		m_mainRenderPass.initialize(m_pDevice, pipelineDesc, rootSignatureDesc);
 		m_mainRenderPass.updateProperties(m_viewport, m_scissorRect, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		m_mainRenderPass.createDrawCommandSignature(m_pDevice, 8);
 
 		nextBlobIdx = 0;
 		for (ID3DBlob*& pBlob : shaderBlobs)
@@ -490,40 +846,157 @@ namespace Okay
 
 	void Renderer::preProcessMeshes(const std::vector<Mesh>& meshes)
 	{
-		uint64_t verticiesResourceSize = 0;
-		uint64_t indiciesResourceSize = 0;
+		// Every mesh is appended to the same streams, one index buffer per format
+		struct IndexPools
+		{
+			std::vector<uint16_t> indicies16;
+			std::vector<uint32_t> indicies32;
+
+			// 16 bit indicies when every index of the mesh fits, returns the first index in the pool
+			uint32_t append(const std::vector<uint32_t>& indicies, uint32_t numVerticies, IndexPool* pOutPool)
+			{
+				if (!canUse16BitIndicies(numVerticies))
+				{
+					*pOutPool = OKAY_INDEX_POOL_32;
+					indicies32.insert(indicies32.end(), indicies.begin(), indicies.end());
+					return (uint32_t)(indicies32.size() - indicies.size());
+				}
+
+				*pOutPool = OKAY_INDEX_POOL_16;
+				indicies16.insert(indicies16.end(), indicies.begin(), indicies.end());
+				return (uint32_t)(indicies16.size() - indicies.size());
+			}
+		};
+
+		std::vector<PackedVertex> verticies;
+		std::vector<PackedPosition> positions;
+		IndexPools indexPools;
+		IndexPools positionIndexPools;
+
+		m_dxMeshes.resize(meshes.size());
+
+		uint64_t meshletsResourceSize = 0;
+
+		for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+		{
+			const MeshData& meshData = meshes[i].getMeshData();
+			DXMesh& dxMesh = m_dxMeshes[i];
+
+			dxMesh.quantization = computeVertexQuantization(meshData.verticies);
+
+			std::vector<PackedVertex> meshVerticies;
+			encodeVerticies(meshData.verticies, dxMesh.quantization, meshVerticies);
+
+			dxMesh.baseVertex = (uint32_t)verticies.size();
+			verticies.insert(verticies.end(), meshVerticies.begin(), meshVerticies.end());
+
+			PositionStream positionStream;
+			createPositionStream(meshData, DEDUPLICATE_DEPTH_POSITIONS, positionStream);
+
+			dxMesh.basePosition = (uint32_t)positions.size();
+			for (const glm::vec3& position : positionStream.positions)
+			{
+				quantizePosition(position, dxMesh.quantization, positions.emplace_back().position);
+			}
+
+			// The full mesh followed by its LODs, every level is a range of the same indicies
+			std::vector<uint32_t> lodIndicies = meshData.indicies;
+			dxMesh.lods[0].numIndicies = (uint32_t)meshData.indicies.size();
+			dxMesh.numLODs = 1;
+
+			for (const MeshLOD& lod : meshes[i].getLODs())
+			{
+				OKAY_ASSERT(dxMesh.numLODs < MAX_MESH_LODS);
+
+				DXMeshLOD& dxLOD = dxMesh.lods[dxMesh.numLODs++];
+				dxLOD.firstIndex = (uint32_t)lodIndicies.size();
+				dxLOD.numIndicies = (uint32_t)lod.indicies.size();
+				dxLOD.error = lod.error;
 
-		for (const Mesh& mesh : meshes)
+				lodIndicies.insert(lodIndicies.end(), lod.indicies.begin(), lod.indicies.end());
+			}
+
+			dxMesh.firstIndex = indexPools.append(lodIndicies, (uint32_t)meshData.verticies.size(), &dxMesh.indexPool);
+
+			// Copied as is when no positions were merged, the depth passes always read the position index buffers
+			if (!positionStream.indicies.empty())
+			{
+				// Same numbering as createPositionStream
+				std::vector<uint32_t> vertexToPosition;
+				createPositionRemap(meshData.verticies, vertexToPosition);
+
+				for (uint32_t& index : lodIndicies)
+				{
+					index = vertexToPosition[index];
+				}
+			}
+
+			dxMesh.firstPositionIndex = positionIndexPools.append(lodIndicies, (uint32_t)positionStream.positions.size(), &dxMesh.positionIndexPool);
+
+			const MeshletData& meshletData = meshes[i].getMeshletData();
+			meshletsResourceSize += alignAddress64(meshletData.meshlets.size() * sizeof(Meshlet), BUFFER_DATA_ALIGNMENT);
+			meshletsResourceSize += alignAddress64(meshletData.vertexIndicies.size() * sizeof(uint32_t), BUFFER_DATA_ALIGNMENT);
+			meshletsResourceSize += alignAddress64(meshletData.triangles.size() * sizeof(uint32_t), BUFFER_DATA_ALIGNMENT);
+
+			dxMesh.boundingSphere = meshes[i].getBoundingSphere();
+			dxMesh.uvDensity = computeMeshUVDensity(meshes[i].getMeshData());
+		}
+
+		uint64_t verticiesResourceSize = alignAddress64(verticies.size() * sizeof(PackedVertex), BUFFER_DATA_ALIGNMENT);
+		uint64_t positionsResourceSize = alignAddress64(positions.size() * sizeof(PackedPosition), BUFFER_DATA_ALIGNMENT);
+
+		uint64_t indiciesResourceSize = 0;
+		for (const IndexPools* pPools : { &indexPools, &positionIndexPools })
 		{
-			const MeshData& meshData = mesh.getMeshData();
-			verticiesResourceSize += alignAddress64(meshData.verticies.size() * sizeof(Vertex), BUFFER_DATA_ALIGNMENT);
-			indiciesResourceSize += alignAddress64(meshData.indicies.size() * sizeof(uint32_t), BUFFER_DATA_ALIGNMENT);
+			indiciesResourceSize += alignAddress64(pPools->indicies16.size() * sizeof(uint16_t), BUFFER_DATA_ALIGNMENT);
+			indiciesResourceSize += alignAddress64(pPools->indicies32.size() * sizeof(uint32_t), BUFFER_DATA_ALIGNMENT);
 		}
 
 		RingBuffer meshDataUploadBuffer;
-		meshDataUploadBuffer.initialize(m_pDevice, 50'000'000);
+		meshDataUploadBuffer.initialize(m_pDevice, verticiesResourceSize + positionsResourceSize + indiciesResourceSize + meshletsResourceSize);
 		meshDataUploadBuffer.map();
 
 		Resource verticiesR = m_gpuResourceManager.createResource(D3D12_HEAP_TYPE_DEFAULT, verticiesResourceSize);
 		Resource indiciesR = m_gpuResourceManager.createResource(D3D12_HEAP_TYPE_DEFAULT, indiciesResourceSize);
+		Resource positionsR = m_gpuResourceManager.createResource(D3D12_HEAP_TYPE_DEFAULT, positionsResourceSize);
+		Resource meshletsR = m_gpuResourceManager.createResource(D3D12_HEAP_TYPE_DEFAULT, meshletsResourceSize);
 
-		m_dxMeshes.resize(meshes.size());
-
-		for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+		auto uploadIndexPools = [&](const IndexPools& pools, D3D12_INDEX_BUFFER_VIEW* pOutIndexViews)
 		{
-			const std::vector<Vertex>& verticies = meshes[i].getMeshData().verticies;
-			const std::vector<uint32_t>& indicies = meshes[i].getMeshData().indicies;
+			Allocation indicies16Alloc = m_gpuResourceManager.allocateInto(indiciesR, OKAY_RESOURCE_APPEND, sizeof(uint16_t), (uint32_t)pools.indicies16.size(), pools.indicies16.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+			Allocation indicies32Alloc = m_gpuResourceManager.allocateInto(indiciesR, OKAY_RESOURCE_APPEND, sizeof(uint32_t), (uint32_t)pools.indicies32.size(), pools.indicies32.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
 
-			Allocation verticiesAlloc = m_gpuResourceManager.allocateInto(verticiesR, OKAY_RESOURCE_APPEND, sizeof(Vertex), (uint32_t)verticies.size(), verticies.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
-			Allocation indiciesAlloc = m_gpuResourceManager.allocateInto(indiciesR, OKAY_RESOURCE_APPEND, sizeof(uint32_t), (uint32_t)indicies.size(), indicies.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+			pOutIndexViews[OKAY_INDEX_POOL_16].BufferLocation = m_gpuResourceManager.getVirtualAddress(indicies16Alloc);
+			pOutIndexViews[OKAY_INDEX_POOL_16].SizeInBytes = (uint32_t)(pools.indicies16.size() * sizeof(uint16_t));
+			pOutIndexViews[OKAY_INDEX_POOL_16].Format = DXGI_FORMAT_R16_UINT;
 
-			m_dxMeshes[i].gpuVerticiesGVA = m_gpuResourceManager.getVirtualAddress(verticiesAlloc);
+			pOutIndexViews[OKAY_INDEX_POOL_32].BufferLocation = m_gpuResourceManager.getVirtualAddress(indicies32Alloc);
+			pOutIndexViews[OKAY_INDEX_POOL_32].SizeInBytes = (uint32_t)(pools.indicies32.size() * sizeof(uint32_t));
+			pOutIndexViews[OKAY_INDEX_POOL_32].Format = DXGI_FORMAT_R32_UINT;
+		};
+
+		Allocation verticiesAlloc = m_gpuResourceManager.allocateInto(verticiesR, OKAY_RESOURCE_APPEND, sizeof(PackedVertex), (uint32_t)verticies.size(), verticies.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+		Allocation positionsAlloc = m_gpuResourceManager.allocateInto(positionsR, OKAY_RESOURCE_APPEND, sizeof(PackedPosition), (uint32_t)positions.size(), positions.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+
+		m_dxMeshBuffers.verticiesGVA = m_gpuResourceManager.getVirtualAddress(verticiesAlloc);
+		m_dxMeshBuffers.positionsGVA = m_gpuResourceManager.getVirtualAddress(positionsAlloc);
 
-			m_dxMeshes[i].indiciesView.BufferLocation = m_gpuResourceManager.getVirtualAddress(indiciesAlloc);
-			m_dxMeshes[i].indiciesView.SizeInBytes = (uint32_t)indiciesAlloc.elementSize * indiciesAlloc.numElements;
-			m_dxMeshes[i].indiciesView.Format = DXGI_FORMAT_R32_UINT;
+		uploadIndexPools(indexPools, m_dxMeshBuffers.indiciesViews);
+		uploadIndexPools(positionIndexPools, m_dxMeshBuffers.positionIndiciesViews);
+
+		for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+		{
+			DXMesh& dxMesh = m_dxMeshes[i];
+			const MeshletData& meshletData = meshes[i].getMeshletData();
 
-			m_dxMeshes[i].numIndicies = (uint32_t)indicies.size();
+			Allocation meshletsAlloc = m_gpuResourceManager.allocateInto(meshletsR, OKAY_RESOURCE_APPEND, sizeof(Meshlet), (uint32_t)meshletData.meshlets.size(), meshletData.meshlets.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+			Allocation meshletVerticiesAlloc = m_gpuResourceManager.allocateInto(meshletsR, OKAY_RESOURCE_APPEND, sizeof(uint32_t), (uint32_t)meshletData.vertexIndicies.size(), meshletData.vertexIndicies.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+			Allocation meshletTrianglesAlloc = m_gpuResourceManager.allocateInto(meshletsR, OKAY_RESOURCE_APPEND, sizeof(uint32_t), (uint32_t)meshletData.triangles.size(), meshletData.triangles.data(), &meshDataUploadBuffer, &m_frames[0].commandContext);
+
+			dxMesh.gpuMeshletsGVA = m_gpuResourceManager.getVirtualAddress(meshletsAlloc);
+			dxMesh.gpuMeshletVerticiesGVA = m_gpuResourceManager.getVirtualAddress(meshletVerticiesAlloc);
+			dxMesh.gpuMeshletTrianglesGVA = m_gpuResourceManager.getVirtualAddress(meshletTrianglesAlloc);
+			dxMesh.numMeshlets = (uint32_t)meshletData.meshlets.size();
 		}
 
 		m_frames[0].commandContext.transitionResource(indiciesR.pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
@@ -532,30 +1005,495 @@ namespace Okay
 		meshDataUploadBuffer.shutdown();
 	}
 
+	// For the buffers GPUResourceManager doesn't make, unordered access & readback
+	static ID3D12Resource* createCommittedBuffer(ID3D12Device* pDevice, D3D12_HEAP_TYPE heapType, uint64_t size, D3D12_RESOURCE_FLAGS flags)
+	{
+		D3D12_HEAP_PROPERTIES heapProperties = {};
+		heapProperties.Type = heapType;
+		heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		heapProperties.CreationNodeMask = 0;
+		heapProperties.VisibleNodeMask = 0;
+
+		D3D12_RESOURCE_DESC desc = {};
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		desc.Alignment = 0;
+		desc.Width = size;
+		desc.Height = 1;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_UNKNOWN;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		desc.Flags = flags;
+
+		// Readback heaps have to start as a copy destination, default heap buffers are promoted from common when used
+		D3D12_RESOURCE_STATES initialState = heapType == D3D12_HEAP_TYPE_READBACK ? D3D12_RESOURCE_STATE_COPY_DEST : D3D12_RESOURCE_STATE_COMMON;
+
+		ID3D12Resource* pDXResource = nullptr;
+		DX_CHECK(pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, initialState, nullptr, IID_PPV_ARGS(&pDXResource)));
+
+		return pDXResource;
+	}
+
+	static DXGI_FORMAT getDXGIFormat(TextureFormat format)
+	{
+		switch (format)
+		{
+		case OKAY_TEXTURE_FORMAT_BC1:
+			return DXGI_FORMAT_BC1_UNORM;
+
+		case OKAY_TEXTURE_FORMAT_BC3:
+			return DXGI_FORMAT_BC3_UNORM;
+
+		case OKAY_TEXTURE_FORMAT_BC4:
+			return DXGI_FORMAT_BC4_UNORM;
+
+		case OKAY_TEXTURE_FORMAT_BC5:
+			return DXGI_FORMAT_BC5_UNORM;
+
+		case OKAY_TEXTURE_FORMAT_R8:
+			return DXGI_FORMAT_R8_UNORM;
+
+		case OKAY_TEXTURE_FORMAT_RG8:
+			return DXGI_FORMAT_R8G8_UNORM;
+
+		default:
+			return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+
 	void Renderer::preProcessTextures(const std::vector<Texture>& textures)
 	{
 		TextureDescription textureDesc = {};
-		textureDesc.mipLevels = MAX_MIP_LEVELS;
 		textureDesc.arraySize = 1;
-		textureDesc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		textureDesc.flags = OKAY_TEXTURE_FLAG_SHADER_READ;
 
+		if (m_streamTextures)
+		{
+			D3D12_HEAP_DESC heapDesc = {};
+			heapDesc.SizeInBytes = TEXTURE_POOL_SIZE;
+			heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+			heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+			heapDesc.Flags = D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES;
+
+			DX_CHECK(m_pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_pTexturePool)));
+			m_textureTilePool.initialize((uint32_t)(TEXTURE_POOL_SIZE / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES));
+		}
+
+		// Mip tails are uploaded in batches through this one
+		RingBuffer tailUploadBuffer;
+		if (m_streamTextures)
+		{
+			tailUploadBuffer.initialize(m_pDevice, TEXTURE_STREAMING_UPLOAD_SIZE);
+			tailUploadBuffer.map();
+		}
+
+		m_streamedTextures.resize(textures.size());
+		m_textureMinLODs.resize(glm::max(textures.size(), (size_t)1), 0.f); // Bound even without textures
+		m_gpuVirtualTextures.resize(glm::max(textures.size(), (size_t)1));
+
+		uint64_t maxMipUploadSize = 0;
+
 		uint32_t numTotalShadowMaps = LightHandler::MAX_SHADOW_MAPS + LightHandler::MAX_POINT_SHADOW_CUBES;
 		for (uint32_t i = 0; i < (uint32_t)textures.size(); i++)
 		{
 			const Texture& texture = textures[i];
+			StreamedTexture& streamedTexture = m_streamedTextures[i];
 
 			textureDesc.width = texture.getWidth();
 			textureDesc.height = texture.getHeight();
+			textureDesc.mipLevels = (uint16_t)texture.getMipChain().getNumLevels(); // Generated at import
+			textureDesc.format = getDXGIFormat(texture.getFormat());
 
-			Allocation textureAlloc = m_gpuResourceManager.createTexture(textureDesc, texture.getTextureData(), &m_frames[0].commandContext);
+			streamedTexture.width = textureDesc.width;
+			streamedTexture.height = textureDesc.height;
 
-			DescriptorDesc desc = m_gpuResourceManager.createDescriptorDesc(textureAlloc, OKAY_DESCRIPTOR_TYPE_SRV, true);
+			// Textures that aren't streamed have no standard mips in the streamer, so their min LOD stays 0
+			StreamedTextureDesc streamingDesc;
+
+			DescriptorDesc desc;
+			if (VIRTUAL_TEXTURES && m_virtualTextures.size() < MAX_GPU_VIRTUAL_TEXTURES && canBeVirtualTexture(texture))
+			{
+				createVirtualTexture(texture, i);
+
+				// Only sampled through the page cache, the slot in textures[] is a null SRV
+				desc.type = OKAY_DESCRIPTOR_TYPE_SRV;
+				desc.nullDesc = false;
+				desc.srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+				desc.srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+				desc.srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+				desc.srvDesc.Texture2D.MipLevels = 1;
+			}
+			else if (m_streamTextures && createStreamedTexture(texture, textureDesc, tailUploadBuffer, &streamedTexture, &streamingDesc))
+			{
+				desc.type = OKAY_DESCRIPTOR_TYPE_SRV;
+				desc.pDXResource = streamedTexture.pDXResource;
+
+				for (uint64_t mipUploadSize : streamingDesc.mipUploadSizes)
+				{
+					maxMipUploadSize = glm::max(maxMipUploadSize, mipUploadSize);
+				}
+			}
+			else
+			{
+				Allocation textureAlloc = m_gpuResourceManager.createTexture(textureDesc, texture.getTextureData(), &m_frames[0].commandContext);
+				desc = m_gpuResourceManager.createDescriptorDesc(textureAlloc, OKAY_DESCRIPTOR_TYPE_SRV, true);
+			}
+
+			m_textureStreamer.addTexture(streamingDesc);
+
+			// Grayscale is swizzled to RRR1 so the shaders can treat it like any colour texture, RG formats already read as RG01
+			if (texture.getFormat() == OKAY_TEXTURE_FORMAT_BC4 || texture.getFormat() == OKAY_TEXTURE_FORMAT_R8)
+			{
+				desc.nullDesc = false;
+				desc.srvDesc.Format = textureDesc.format;
+				desc.srvDesc.Shader4ComponentMapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0, 0, 0, D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1);
+				desc.srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+				desc.srvDesc.Texture2D.MipLevels = textureDesc.mipLevels;
+				desc.srvDesc.Texture2D.MostDetailedMip = 0;
+				desc.srvDesc.Texture2D.PlaneSlice = 0;
+				desc.srvDesc.Texture2D.ResourceMinLODClamp = 0.f;
+			}
 			m_descriptorHeapStore.allocateDescriptors(m_materialTexturesDHH, numTotalShadowMaps + i, &desc, 1);
 		}
 
+		// The root pages & the indirection tables pointing to them
+		if (!m_virtualTextures.empty())
+		{
+			uploadVirtualTextureChanges(m_frames[0].commandContext, m_frames[0].textureUploadBuffer);
+		}
+
 		m_frames[0].commandContext.flush();
-		m_gpuResourceManager.generateMipMaps(m_pCommandQueue);
+		m_frames[0].textureUploadBuffer.jumpToStart();
+
+		if (m_streamTextures)
+		{
+			tailUploadBuffer.shutdown();
+		}
+
+		createVirtualFeedback(!m_virtualTextures.empty());
+
+		// A single mip can go over the per frame upload size, TextureStreamer then streams it in on its own.
+		// Virtual texture pages go through the same buffer after the mips
+		uint64_t textureUploadSize = glm::max(maxMipUploadSize, TEXTURE_STREAMING_UPLOAD_SIZE) + getVirtualTextureUploadSize();
+		if (textureUploadSize > TEXTURE_STREAMING_UPLOAD_SIZE)
+		{
+			for (FrameResources& frame : m_frames)
+			{
+				frame.textureUploadBuffer.resize(textureUploadSize);
+			}
+		}
+	}
+
+	bool Renderer::createStreamedTexture(const Texture& texture, const TextureDescription& textureDesc, RingBuffer& uploadBuffer,
+		StreamedTexture* pOutStreamedTexture, StreamedTextureDesc* pOutStreamingDesc)
+	{
+		D3D12_RESOURCE_DESC resourceDesc = {};
+		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		resourceDesc.Alignment = 0;
+		resourceDesc.Width = textureDesc.width;
+		resourceDesc.Height = textureDesc.height;
+		resourceDesc.DepthOrArraySize = textureDesc.arraySize;
+		resourceDesc.MipLevels = textureDesc.mipLevels;
+		resourceDesc.Format = textureDesc.format;
+		resourceDesc.SampleDesc.Count = 1;
+		resourceDesc.SampleDesc.Quality = 0;
+		resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+		resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		ID3D12Resource* pDXResource = nullptr;
+		DX_CHECK(m_pDevice->CreateReservedResource(&resourceDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pDXResource)));
+
+		D3D12_PACKED_MIP_INFO packedMipInfo = {};
+		D3D12_SUBRESOURCE_TILING subresourceTilings[D3D12_REQ_MIP_LEVELS] = {};
+		uint32_t numSubresourceTilings = textureDesc.mipLevels;
+		m_pDevice->GetResourceTiling(pDXResource, nullptr, &packedMipInfo, nullptr, &numSubresourceTilings, 0, subresourceTilings);
+
+		uint32_t numStandardMips = packedMipInfo.NumStandardMips;
+		uint32_t numPackedMips = packedMipInfo.NumPackedMips;
+
+		// Small textures are only a mip tail, nothing to stream
+		if (numStandardMips == 0 || !m_textureTilePool.allocate(packedMipInfo.NumTilesForPackedMips, pOutStreamedTexture->tailTiles))
+		{
+			D3D12_RELEASE(pDXResource);
+			return false;
+		}
+
+		pOutStreamedTexture->pDXResource = pDXResource;
+		pOutStreamedTexture->mipTiles.resize(numStandardMips);
+		pOutStreamedTexture->mipChain = texture.getMipChain();
+		m_numTailTiles += packedMipInfo.NumTilesForPackedMips;
+
+		for (uint32_t i = 0; i < numStandardMips; i++)
+		{
+			const D3D12_SUBRESOURCE_TILING& tiling = subresourceTilings[i];
+
+			pOutStreamingDesc->mipTiles.emplace_back(tiling.WidthInTiles * tiling.HeightInTiles * tiling.DepthInTiles);
+			pOutStreamingDesc->mipUploadSizes.emplace_back(m_gpuResourceManager.getTextureUploadSize(resourceDesc, i, 1));
+		}
+
+		// The packed mips are mapped together, from the first of them
+		updateTextureTileMappings(pDXResource, numStandardMips, packedMipInfo.NumTilesForPackedMips, pOutStreamedTexture->tailTiles.data());
+
+		if (numPackedMips)
+		{
+			CommandContext& uploadContext = m_frames[0].commandContext;
+
+			uint64_t tailUploadSize = m_gpuResourceManager.getTextureUploadSize(resourceDesc, numStandardMips, numPackedMips);
+			if (alignAddress64(uploadBuffer.getOffset(), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) + tailUploadSize > uploadBuffer.getSize())
+			{
+				uploadContext.flush();
+				uploadBuffer.jumpToStart();
+			}
+
+			const TextureMipChain& mipChain = texture.getMipChain();
+			m_gpuResourceManager.uploadTextureMips(pDXResource, numStandardMips, numPackedMips, mipChain.data.data() + mipChain.levels[numStandardMips].offset, uploadBuffer, uploadContext);
+		}
+
+		// Unmapped standard mips can be transitioned too, they're just never sampled before they're mapped
+		m_frames[0].commandContext.transitionResource(pDXResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+		return true;
+	}
+
+	bool Renderer::canBeVirtualTexture(const Texture& texture) const
+	{
+		const TextureMipChain& mipChain = texture.getMipChain();
+		if (!texture.isSRGB() || mipChain.levels.empty())
+		{
+			return false;
+		}
+
+		uint32_t width = mipChain.levels[0].width;
+		uint32_t height = mipChain.levels[0].height;
+
+		// Power of two sizes keep the pages of every mip lined up with the pages of the mips after it
+		bool isPowerOfTwo = (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+		if (!isPowerOfTwo || glm::max(width, height) < VIRTUAL_TEXTURE_MIN_SIZE)
+		{
+			return false;
+		}
+
+		if (getNumVirtualPages(width, 0) > MAX_VIRTUAL_PAGES || getNumVirtualPages(height, 0) > MAX_VIRTUAL_PAGES)
+		{
+			return false;
+		}
+
+		// Every virtual mip is copied out of the chain
+		uint32_t numVirtualMips = getNumVirtualMips(width, height);
+		if (mipChain.getNumLevels() < numVirtualMips)
+		{
+			return false;
+		}
+
+		// The formats copyVirtualPage can copy into the RGBA8 cache. Block compressed pages are copied block by block,
+		// so the least detailed page can't be smaller than a block
+		switch (mipChain.format)
+		{
+		case OKAY_TEXTURE_FORMAT_RGBA8:
+			return true;
+
+		case OKAY_TEXTURE_FORMAT_BC1:
+		case OKAY_TEXTURE_FORMAT_BC3:
+			return mipChain.levels[numVirtualMips - 1].width % 4 == 0 && mipChain.levels[numVirtualMips - 1].height % 4 == 0;
+
+		default:
+			return false;
+		}
+	}
+
+	void Renderer::createVirtualTexture(const Texture& texture, uint32_t textureIdx)
+	{
+		CommandContext& uploadContext = m_frames[0].commandContext;
+
+		// Created with the first virtual texture
+		if (!m_pVirtualPageCache)
+		{
+			uint32_t cacheSize = VIRTUAL_CACHE_SLOTS * VIRTUAL_PAGE_STRIDE;
+
+			TextureDescription cacheDesc(cacheSize, cacheSize, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, OKAY_TEXTURE_FLAG_SHADER_READ);
+			Allocation cacheAlloc = m_gpuResourceManager.createTexture(cacheDesc, nullptr, nullptr);
+			m_pVirtualPageCache = cacheAlloc.pDXResource;
+
+			uploadContext.transitionResource(m_pVirtualPageCache, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+			DescriptorDesc desc = m_gpuResourceManager.createDescriptorDesc(cacheAlloc, OKAY_DESCRIPTOR_TYPE_SRV, true);
+			m_descriptorHeapStore.allocateDescriptors(m_materialTexturesDHH, VIRTUAL_DESCRIPTORS_OFFSET, &desc, 1);
+
+			m_virtualTextureSystem.initialize(VIRTUAL_CACHE_SLOTS, VIRTUAL_CACHE_SLOTS);
+		}
+
+		const TextureMipChain& mipChain = texture.getMipChain();
+		uint32_t width = mipChain.levels[0].width;
+		uint32_t height = mipChain.levels[0].height;
+
+		uint32_t virtualIdx = m_virtualTextureSystem.addTexture(width, height);
+		uint32_t numMips = m_virtualTextureSystem.getNumMips(virtualIdx);
+
+		VirtualTexture& virtualTexture = m_virtualTextures.emplace_back();
+		virtualTexture.mipChain = mipChain;
+
+		// A texel per page, the mips of the power of two sizes have as many pages as the virtual mips
+		glm::uvec2 numPages = m_virtualTextureSystem.getNumPages(virtualIdx, 0);
+		TextureDescription indirectionDesc(numPages.x, numPages.y, (uint16_t)numMips, 1, DXGI_FORMAT_R32_UINT, OKAY_TEXTURE_FLAG_SHADER_READ);
+
+		Allocation indirectionAlloc = m_gpuResourceManager.createTexture(indirectionDesc, nullptr, nullptr);
+		virtualTexture.pIndirectionTexture = indirectionAlloc.pDXResource;
+
+		uploadContext.transitionResource(virtualTexture.pIndirectionTexture, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+		DescriptorDesc desc = m_gpuResourceManager.createDescriptorDesc(indirectionAlloc, OKAY_DESCRIPTOR_TYPE_SRV, true);
+		m_descriptorHeapStore.allocateDescriptors(m_materialTexturesDHH, VIRTUAL_DESCRIPTORS_OFFSET + 1 + virtualIdx, &desc, 1);
+
+		GPUVirtualTexture& gpuVirtualTexture = m_gpuVirtualTextures[textureIdx];
+		gpuVirtualTexture.virtualIdx = virtualIdx;
+		gpuVirtualTexture.size = glm::uvec2(width, height);
+		gpuVirtualTexture.numMips = numMips;
+	}
+
+	void Renderer::createVirtualFeedback(bool hasVirtualTextures)
+	{
+		m_virtualFeedbackWidth = ((uint32_t)m_viewport.Width + VIRTUAL_FEEDBACK_SCALE - 1) / VIRTUAL_FEEDBACK_SCALE;
+		m_virtualFeedbackHeight = ((uint32_t)m_viewport.Height + VIRTUAL_FEEDBACK_SCALE - 1) / VIRTUAL_FEEDBACK_SCALE;
+
+		uint32_t numEntries = m_virtualFeedbackWidth * m_virtualFeedbackHeight;
+		uint64_t feedbackSize = (uint64_t)numEntries * sizeof(uint32_t);
+
+		// Bound even without virtual textures, nothing writes to it then
+		m_pVirtualFeedback = createCommittedBuffer(m_pDevice, D3D12_HEAP_TYPE_DEFAULT, feedbackSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+		if (!hasVirtualTextures)
+		{
+			return;
+		}
+
+		for (FrameResources& frame : m_frames)
+		{
+			frame.pVirtualFeedbackReadback = createCommittedBuffer(m_pDevice, D3D12_HEAP_TYPE_READBACK, feedbackSize, D3D12_RESOURCE_FLAG_NONE);
+		}
+
+		// Every entry empty
+		std::vector<uint32_t> emptyFeedback(numEntries, INVALID_UINT32);
+
+		RingBuffer clearUploadBuffer;
+		clearUploadBuffer.initialize(m_pDevice, alignAddress64(feedbackSize, BUFFER_DATA_ALIGNMENT));
+		clearUploadBuffer.map();
+
+		Resource clearR = m_gpuResourceManager.createResource(D3D12_HEAP_TYPE_DEFAULT, alignAddress64(feedbackSize, BUFFER_DATA_ALIGNMENT));
+		m_virtualFeedbackClear = m_gpuResourceManager.allocateInto(clearR, OKAY_RESOURCE_APPEND, sizeof(uint32_t), numEntries, emptyFeedback.data(), &clearUploadBuffer, &m_frames[0].commandContext);
+
+		// The clear buffer decays back to common after the flush, so it can be copied from in the next command list
+		m_frames[0].commandContext.flush();
+		clearUploadBuffer.shutdown();
+
+		m_frames[0].commandContext.getCommandList()->CopyBufferRegion(m_pVirtualFeedback, 0, m_virtualFeedbackClear.pDXResource, m_virtualFeedbackClear.resourceOffset, feedbackSize);
+	}
+
+	void Renderer::uploadVirtualTextureChanges(CommandContext& commandContext, RingBuffer& uploadBuffer)
+	{
+		ID3D12GraphicsCommandList* pCommandList = commandContext.getCommandList();
+		const std::vector<VirtualTextureSystem::PageLoad>& pageLoads = m_virtualTextureSystem.getPageLoads();
+
+		if (!pageLoads.empty())
+		{
+			// copyVirtualPage writes tightly packed rows, the footprint needs them pitch aligned
+			std::vector<uint8_t> pageTexels((size_t)VIRTUAL_PAGE_STRIDE * VIRTUAL_PAGE_STRIDE * 4);
+
+			D3D12_TEXTURE_COPY_LOCATION copyDst{};
+			copyDst.pResource = m_pVirtualPageCache;
+			copyDst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			copyDst.SubresourceIndex = 0;
+
+			D3D12_TEXTURE_COPY_LOCATION copySrc{};
+			copySrc.pResource = uploadBuffer.getDXResource();
+			copySrc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			copySrc.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			copySrc.PlacedFootprint.Footprint.Width = VIRTUAL_PAGE_STRIDE;
+			copySrc.PlacedFootprint.Footprint.Height = VIRTUAL_PAGE_STRIDE;
+			copySrc.PlacedFootprint.Footprint.Depth = 1;
+			copySrc.PlacedFootprint.Footprint.RowPitch = VIRTUAL_PAGE_ROW_PITCH;
+
+			commandContext.transitionResource(m_pVirtualPageCache, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+
+			for (const VirtualTextureSystem::PageLoad& pageLoad : pageLoads)
+			{
+				VirtualPage page = unpackVirtualPage(pageLoad.pageID);
+				copyVirtualPage(m_virtualTextures[page.textureIdx].mipChain, page.mip, page.pageX, page.pageY, pageTexels.data());
+
+				uploadBuffer.alignOffset(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+				copySrc.PlacedFootprint.Offset = uploadBuffer.getOffset();
+
+				uint8_t* pMappedData = uploadBuffer.getMappedPtr();
+				for (uint32_t row = 0; row < VIRTUAL_PAGE_STRIDE; row++)
+				{
+					memcpy(pMappedData + (size_t)row * VIRTUAL_PAGE_ROW_PITCH, pageTexels.data() + (size_t)row * VIRTUAL_PAGE_STRIDE * 4, VIRTUAL_PAGE_STRIDE * 4);
+				}
+				uploadBuffer.offsetMappedPtr((uint64_t)VIRTUAL_PAGE_ROW_PITCH * VIRTUAL_PAGE_STRIDE);
+
+				glm::uvec2 slotPosition = m_virtualTextureSystem.getSlotPosition(pageLoad.slot) * VIRTUAL_PAGE_STRIDE;
+				pCommandList->CopyTextureRegion(&copyDst, slotPosition.x, slotPosition.y, 0, &copySrc, nullptr);
+			}
+
+			commandContext.transitionResource(m_pVirtualPageCache, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		}
+
+		for (const VirtualTextureSystem::IndirectionUpdate& update : m_virtualTextureSystem.getIndirectionUpdates())
+		{
+			ID3D12Resource* pIndirectionTexture = m_virtualTextures[update.textureIdx].pIndirectionTexture;
+			const std::vector<uint32_t>& entries = m_virtualTextureSystem.getIndirectionMip(update.textureIdx, update.mip);
+
+			commandContext.transitionSubresource(pIndirectionTexture, update.mip, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+			m_gpuResourceManager.uploadTextureMips(pIndirectionTexture, update.mip, 1, (const uint8_t*)entries.data(), uploadBuffer, commandContext);
+			commandContext.transitionSubresource(pIndirectionTexture, update.mip, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		}
+	}
+
+	uint64_t Renderer::getVirtualTextureUploadSize() const
+	{
+		if (m_virtualTextures.empty())
+		{
+			return 0;
+		}
+
+		// The most one update can upload, every page load & every indirection mip
+		uint64_t pageUploadSize = alignAddress64((uint64_t)VIRTUAL_PAGE_ROW_PITCH * VIRTUAL_PAGE_STRIDE, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		uint64_t uploadSize = pageUploadSize * VIRTUAL_PAGE_LOADS;
+
+		for (const VirtualTexture& virtualTexture : m_virtualTextures)
+		{
+			D3D12_RESOURCE_DESC indirectionDesc = virtualTexture.pIndirectionTexture->GetDesc();
+			for (uint32_t mip = 0; mip < indirectionDesc.MipLevels; mip++)
+			{
+				uploadSize += m_gpuResourceManager.getTextureUploadSize(indirectionDesc, mip, 1);
+			}
+		}
+
+		return uploadSize;
+	}
+
+	void Renderer::updateTextureTileMappings(ID3D12Resource* pDXResource, uint32_t subresource, uint32_t numTiles, const uint32_t* pPoolTiles)
+	{
+		D3D12_TILED_RESOURCE_COORDINATE coordinate = {};
+		coordinate.Subresource = subresource;
+
+		D3D12_TILE_REGION_SIZE regionSize = {};
+		regionSize.NumTiles = numTiles;
+		regionSize.UseBox = FALSE;
+
+		if (!pPoolTiles)
+		{
+			D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NULL;
+			m_pCommandQueue->UpdateTileMappings(pDXResource, 1, &coordinate, &regionSize, nullptr, 1, &rangeFlags, nullptr, &numTiles, D3D12_TILE_MAPPING_FLAG_NONE);
+			return;
+		}
+
+		// One range per tile, a mip's tiles can be anywhere in the pool
+		std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags(numTiles, D3D12_TILE_RANGE_FLAG_NONE);
+		std::vector<uint32_t> rangeTileCounts(numTiles, 1);
+
+		m_pCommandQueue->UpdateTileMappings(pDXResource, 1, &coordinate, &regionSize, m_pTexturePool, numTiles, rangeFlags.data(), pPoolTiles, rangeTileCounts.data(), D3D12_TILE_MAPPING_FLAG_NONE);
 	}
 
 	void Renderer::enableDebugLayer()
@@ -5,6 +5,10 @@
 #include "RenderPass.h"
 #include "RingBuffer.h"
 #include "Handlers/LightHandler.h"
+#include "Handlers/TextureStreaming.h"
+#include "Handlers/VirtualTexturing.h"
+#include "Engine/Baking/IrradianceBaker.h"
+#include "Engine/Resources/TextureMips.h"
 
 #include <array>
 
@@ -18,7 +22,26 @@ namespace Okay
 	{
 	public:
 		static const uint8_t MAX_FRAMES_IN_FLIGHT = 3;
-		static const uint8_t MAX_MIP_LEVELS = 16;
+
+		// Merge verticies with the same position in the depth only stream
+		static const bool DEDUPLICATE_DEPTH_POSITIONS = true;
+
+		// Instances use the least detailed mesh LOD whose error is at most this many pixels on screen
+		static constexpr float LOD_MAX_PIXEL_ERROR = 1.f;
+
+		// Only the mips visible instances need stay resident, in a pool of TEXTURE_POOL_SIZE. See TextureStreaming.h
+		static const bool STREAM_TEXTURES = true;
+		static const uint64_t TEXTURE_POOL_SIZE = 256ull * 1024 * 1024;
+		static const uint64_t TEXTURE_STREAMING_UPLOAD_SIZE = 16ull * 1024 * 1024; // Per frame
+
+		// Colour textures at least this big (power of two sizes only) are virtual textures instead, only the pages on screen are
+		// resident, in a cache of VIRTUAL_CACHE_SLOTS x VIRTUAL_CACHE_SLOTS pages. See VirtualTexturing.h
+		static const bool VIRTUAL_TEXTURES = true;
+		static const uint32_t VIRTUAL_TEXTURE_MIN_SIZE = 4096;
+		static const uint32_t MAX_GPU_VIRTUAL_TEXTURES = 32;
+		static const uint32_t VIRTUAL_CACHE_SLOTS = 16;
+		static const uint32_t VIRTUAL_PAGE_LOADS = 32; // Per frame
+		static const uint32_t VIRTUAL_FEEDBACK_SCALE = 8; // One feedback entry per 8x8 pixels
 
 		struct FrameResources
 		{
@@ -27,7 +50,6 @@ namespace Okay
 			// Draw
 			ID3D12Resource* backBuffer = nullptr;
 			D3D12_GPU_VIRTUAL_ADDRESS renderDataGVA = INVALID_UINT64;
-			D3D12_CPU_DESCRIPTOR_HANDLE dsvCpuHandle;
 
 			// Technically doesn't need 1 per frame but it's okay for now :3
 			RingBuffer ringBuffer;
@@ -35,9 +57,52 @@ namespace Okay
 			// Use ActiveVector cuz we don't wanna call the desctructors of DrawGroup cuz they deallocate the vectors inside them
 			ActiveVector<DrawGroup> drawGroups;
 
+			// One draw per draw group, see IndirectDrawBuilder.h
+			IndirectDrawBuilder drawBuilder;
+			D3D12_GPU_VIRTUAL_ADDRESS objectDatasGVA = INVALID_UINT64;
+			D3D12_GPU_VIRTUAL_ADDRESS drawDatasGVA = INVALID_UINT64;
+
 			D3D12_GPU_VIRTUAL_ADDRESS pointLightsGVA = INVALID_UINT64;
 			D3D12_GPU_VIRTUAL_ADDRESS directionalLightsGVA = INVALID_UINT64;
 			D3D12_GPU_VIRTUAL_ADDRESS spotLightsGVA = INVALID_UINT64;
+
+			// Streamed in mips, at least TEXTURE_STREAMING_UPLOAD_SIZE or the biggest mip
+			RingBuffer textureUploadBuffer;
+			D3D12_GPU_VIRTUAL_ADDRESS textureMinLODsGVA = INVALID_UINT64;
+
+			// Virtual texture pages this frame wanted, read when the frame comes around again
+			ID3D12Resource* pVirtualFeedbackReadback = nullptr;
+			bool hasVirtualFeedback = false;
+			D3D12_GPU_VIRTUAL_ADDRESS virtualTexturesGVA = INVALID_UINT64;
+		};
+
+		// Per texture, pDXResource is nullptr for textures that aren't streamed. Indices are the same in TextureStreamer
+		struct StreamedTexture
+		{
+			ID3D12Resource* pDXResource = nullptr; // Reserved resource
+			uint32_t width = 0;
+			uint32_t height = 0;
+
+			std::vector<std::vector<uint32_t>> mipTiles; // Pool tiles mapped to each standard mip
+			std::vector<uint32_t> tailTiles;
+
+			// The CPU copy of the texture is unloaded after preProcessResources, mips are streamed in from here
+			TextureMipChain mipChain;
+		};
+
+		// Indices are the same in VirtualTextureSystem, pages are copied out of the CPU copy
+		struct VirtualTexture
+		{
+			ID3D12Resource* pIndirectionTexture = nullptr;
+			TextureMipChain mipChain;
+		};
+
+		// Per texture, virtualIdx is INVALID_UINT32 for textures that aren't virtual
+		struct GPUVirtualTexture
+		{
+			uint32_t virtualIdx = INVALID_UINT32;
+			glm::uvec2 size = glm::uvec2(0);
+			uint32_t numMips = 0;
 		};
 
 	public:
@@ -51,8 +116,15 @@ namespace Okay
 
 		void preProcessResources(const ResourceManager& resourceManager);
 
+		// Dedicated video memory of the adapter, for picking the texture quality (selectTextureQuality)
+		inline uint64_t getVideoMemorySize() const { return m_videoMemorySize; }
+
+		// Replaces the probes used for ambient light, call before run() or the frames in flight may still read the old ones
+		void setIrradianceVolume(const IrradianceVolume& volume);
+
 	private:
 		void drawDrawGroups(ID3D12GraphicsCommandList* pCommandList);
+		void drawStatsWindow();
 
 	private:
 		void updateBuffers(const Scene& scene);
@@ -61,6 +133,9 @@ namespace Okay
 		void postRender();
 
 		void assignObjectDrawGroups(const Scene& scene);
+		void updateTextureStreaming();
+		void updateVirtualTextures();
+		void copyVirtualFeedback();
 
 		void createDevice(IDXGIFactory* pFactory);
 		void createCommandQueue();
@@ -73,6 +148,21 @@ namespace Okay
 		void preProcessMeshes(const std::vector<Mesh>& meshes);
 		void preProcessTextures(const std::vector<Texture>& textures);
 
+		// Returns false if the texture is only a mip tail or the tail doesn't fit in the pool, it's then created fully resident
+		bool createStreamedTexture(const Texture& texture, const TextureDescription& textureDesc, RingBuffer& uploadBuffer,
+			StreamedTexture* pOutStreamedTexture, StreamedTextureDesc* pOutStreamingDesc);
+
+		bool canBeVirtualTexture(const Texture& texture) const;
+		void createVirtualTexture(const Texture& texture, uint32_t textureIdx);
+		void createVirtualFeedback(bool hasVirtualTextures);
+
+		// Copies the page loads & the changed indirection mips of the last VirtualTextureSystem update
+		void uploadVirtualTextureChanges(CommandContext& commandContext, RingBuffer& uploadBuffer);
+		uint64_t getVirtualTextureUploadSize() const;
+
+		// pPoolTiles nullptr unmaps the tiles. Runs on m_pCommandQueue, in order with the frames around it
+		void updateTextureTileMappings(ID3D12Resource* pDXResource, uint32_t subresource, uint32_t numTiles, const uint32_t* pPoolTiles);
+
 		void enableDebugLayer();
 		void enableGPUBasedValidation();
 
@@ -80,6 +170,7 @@ namespace Okay
 		ID3D12Device* m_pDevice = nullptr;
 		IDXGISwapChain1* m_pSwapChain = nullptr;
 		ID3D12CommandQueue* m_pCommandQueue = nullptr;
+		uint64_t m_videoMemorySize = 0;
 
 		uint8_t m_currentBackBuffer = MAX_FRAMES_IN_FLIGHT - 1;
 		D3D12_CPU_DESCRIPTOR_HANDLE m_rtvBackBufferCPUHandle;
@@ -87,6 +178,11 @@ namespace Okay
 		D3D12_VIEWPORT m_viewport = {};
 		D3D12_RECT m_scissorRect = {};
 
+		// Shared by all frames, they run in order on m_pCommandQueue so one depth buffer is enough
+		D3D12_CPU_DESCRIPTOR_HANDLE m_dsvCpuHandle = {};
+		uint64_t m_depthBufferBytes = 0;
+		uint64_t m_perFrameDepthBuffersBytes = 0; // If every frame in flight had its own, for the memory report
+
 		FrameResources m_frames[MAX_FRAMES_IN_FLIGHT] = {};
 
 	private: // Abstractions + increment size
@@ -102,6 +198,38 @@ namespace Okay
 		RenderPass m_mainRenderPass;
 
 		std::vector<DXMesh> m_dxMeshes;
+		DXMeshBuffers m_dxMeshBuffers;
+		IndirectCommandList m_mainCommandList;
+
+		// Last frame, for the stats window
+		uint32_t m_lodInstanceCounts[MAX_MESH_LODS] = {};
+		uint32_t m_numMainDraws = 0;
+		uint32_t m_numMainExecuteIndirects = 0;
+
+		std::vector<StreamedTexture> m_streamedTextures;
+		std::vector<float> m_textureMinLODs;
+
+		ID3D12Heap* m_pTexturePool = nullptr;
+		TextureTilePool m_textureTilePool;
+		TextureStreamer m_textureStreamer;
+		uint32_t m_numTailTiles = 0;
+		bool m_streamTextures = false; // STREAM_TEXTURES & tiled resources tier 2, which the min LOD clamp sampling needs
+
+		std::vector<VirtualTexture> m_virtualTextures;
+		std::vector<GPUVirtualTexture> m_gpuVirtualTextures;
+		VirtualTextureSystem m_virtualTextureSystem;
+
+		ID3D12Resource* m_pVirtualPageCache = nullptr; // Owned by m_gpuResourceManager, like the indirection textures
+		ID3D12Resource* m_pVirtualFeedback = nullptr; // Copied from m_virtualFeedbackClear after every readback copy
+		Allocation m_virtualFeedbackClear = {};
+		uint32_t m_virtualFeedbackWidth = 0;
+		uint32_t m_virtualFeedbackHeight = 0;
+		uint32_t m_virtualFeedbackFrame = 0; // Picks the pixel of every block that writes the feedback
+
+		D3D12_GPU_VIRTUAL_ADDRESS m_irradianceProbesGVA = INVALID_UINT64;
+		glm::vec3 m_probeGridMin = glm::vec3(0.f);
+		float m_probeSpacing = 1.f;
+		glm::uvec3 m_probeGridSize = glm::uvec3(0);
 
 	private: // Misc
 		ID3D12DescriptorHeap* m_pImguiDescriptorHeap = nullptr;
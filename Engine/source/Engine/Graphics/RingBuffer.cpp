@@ -44,6 +44,11 @@ namespace Okay
 		return m_bufferOffset;
 	}
 
+	uint64_t RingBuffer::getSize() const
+	{
+		return m_maxSize;
+	}
+
 	void RingBuffer::alignOffset(uint32_t alignment)
 	{
 		m_bufferOffset = alignAddress64(m_bufferOffset, alignment);
@@ -23,6 +23,7 @@ namespace Okay
 
 		void offsetMappedPtr(uint64_t offset);
 		uint64_t getOffset() const;
+		uint64_t getSize() const;
 
 		void alignOffset(uint32_t alignment = BUFFER_DATA_ALIGNMENT);
 
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+namespace Okay
+{
+	/*
+		Frustum planes extracted from a (non-transposed) D3D style view projection matrix, meaning clip space z is in [0, w].
+		Plane normals point inwards, a point is inside if dot(plane.xyz, point) + plane.w >= 0 for all planes.
+
+		https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+	*/
+	struct Frustum
+	{
+		glm::vec4 planes[6] = {};
+	};
+
+	inline Frustum extractFrustum(const glm::mat4& viewProjMatrix)
+	{
+		glm::vec4 row0 = glm::vec4(viewProjMatrix[0][0], viewProjMatrix[1][0], viewProjMatrix[2][0], viewProjMatrix[3][0]);
+		glm::vec4 row1 = glm::vec4(viewProjMatrix[0][1], viewProjMatrix[1][1], viewProjMatrix[2][1], viewProjMatrix[3][1]);
+		glm::vec4 row2 = glm::vec4(viewProjMatrix[0][2], viewProjMatrix[1][2], viewProjMatrix[2][2], viewProjMatrix[3][2]);
+		glm::vec4 row3 = glm::vec4(viewProjMatrix[0][3], viewProjMatrix[1][3], viewProjMatrix[2][3], viewProjMatrix[3][3]);
+
+		Frustum frustum;
+		frustum.planes[0] = row3 + row0; // Left
+		frustum.planes[1] = row3 - row0; // Right
+		frustum.planes[2] = row3 + row1; // Bottom
+		frustum.planes[3] = row3 - row1; // Top
+		frustum.planes[4] = row2;		 // Near
+		frustum.planes[5] = row3 - row2; // Far
+
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return frustum;
+	}
+
+	inline bool sphereInFrustum(const Frustum& frustum, glm::vec3 center, float radius)
+	{
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	inline bool sphereIntersectsSphere(glm::vec3 centerA, float radiusA, glm::vec3 centerB, float radiusB)
+	{
+		glm::vec3 delta = centerA - centerB;
+		float radiusSum = radiusA + radiusB;
+
+		return glm::dot(delta, delta) <= radiusSum * radiusSum;
+	}
+
+	// Sphere is stored as xyz = center, w = radius
+	inline glm::vec4 transformSphere(const glm::vec4& sphere, const glm::mat4& matrix)
+	{
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(glm::vec3(sphere), 1.f));
+
+		float maxScale = glm::max(glm::length(glm::vec3(matrix[0])), glm::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+
+		return glm::vec4(center, sphere.w * maxScale);
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <cstring>
+
+namespace Okay
+{
+	// 64-bit FNV-1a, used to build cheap change-detection keys from small values (matrices, ids, etc.)
+	class Hasher
+	{
+	public:
+		Hasher() = default;
+
+		inline void add(const void* pData, size_t byteSize)
+		{
+			const uint8_t* pBytes = (const uint8_t*)pData;
+			for (size_t i = 0; i < byteSize; i++)
+			{
+				m_hash ^= pBytes[i];
+				m_hash *= FNV_PRIME;
+			}
+		}
+
+		template<typename T>
+		inline void addValue(const T& value)
+		{
+			add(&value, sizeof(T));
+		}
+
+		inline uint64_t get() const
+		{
+			return m_hash;
+		}
+
+	private:
+		static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+		static const uint64_t FNV_PRIME = 1099511628211ull;
+
+		uint64_t m_hash = FNV_OFFSET_BASIS;
+	};
+
+	// XXH64 (Yann Collet), for hashing whole assets. Reads 32 bytes per round, so it's far faster than Hasher on big data
+	class ContentHasher
+	{
+	public:
+		static inline uint64_t hash(const void* pData, size_t byteSize, uint64_t seed = 0)
+		{
+			const uint8_t* pBytes = (const uint8_t*)pData;
+			const uint8_t* pEnd = pBytes + byteSize;
+
+			uint64_t hash = 0;
+
+			if (byteSize >= 32)
+			{
+				uint64_t accs[4] = { seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1 };
+
+				for (; pEnd - pBytes >= 32; pBytes += 32)
+				{
+					for (uint32_t i = 0; i < 4; i++)
+					{
+						accs[i] = round(accs[i], read64(pBytes + i * 8));
+					}
+				}
+
+				hash = rotl(accs[0], 1) + rotl(accs[1], 7) + rotl(accs[2], 12) + rotl(accs[3], 18);
+				for (uint64_t acc : accs)
+				{
+					hash = (hash ^ round(0, acc)) * PRIME_1 + PRIME_4;
+				}
+			}
+			else
+			{
+				hash = seed + PRIME_5;
+			}
+
+			hash += (uint64_t)byteSize;
+
+			for (; pEnd - pBytes >= 8; pBytes += 8)
+			{
+				hash = rotl(hash ^ round(0, read64(pBytes)), 27) * PRIME_1 + PRIME_4;
+			}
+
+			if (pEnd - pBytes >= 4)
+			{
+				uint32_t value = 0;
+				memcpy(&value, pBytes, sizeof(uint32_t));
+
+				hash = rotl(hash ^ (value * PRIME_1), 23) * PRIME_2 + PRIME_3;
+				pBytes += 4;
+			}
+
+			for (; pBytes < pEnd; pBytes++)
+			{
+				hash = rotl(hash ^ (*pBytes * PRIME_5), 11) * PRIME_1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= PRIME_2;
+			hash ^= hash >> 29;
+			hash *= PRIME_3;
+			hash ^= hash >> 32;
+
+			return hash;
+		}
+
+	private:
+		static inline uint64_t rotl(uint64_t value, uint32_t bits)
+		{
+			return (value << bits) | (value >> (64 - bits));
+		}
+
+		static inline uint64_t read64(const uint8_t* pBytes)
+		{
+			uint64_t value = 0;
+			memcpy(&value, pBytes, sizeof(uint64_t));
+			return value;
+		}
+
+		static inline uint64_t round(uint64_t acc, uint64_t input)
+		{
+			return rotl(acc + input * PRIME_2, 31) * PRIME_1;
+		}
+
+	private:
+		static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+		static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+		static const uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+		static const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+		static const uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+	};
+}
@@ -8,13 +8,20 @@
 #include <filesystem>
 #include <fstream>
 
+// The CPU side of the engine & the tests also build with GCC/Clang (see CMakeLists.txt)
+#ifdef _MSC_VER
+#define OKAY_DEBUG_BREAK() __debugbreak()
+#else
+#define OKAY_DEBUG_BREAK() __builtin_trap()
+#endif
+
 // Will be defined to not check in dist builds
 #define OKAY_ASSERT(condition)																	\
 	{																							\
 		if (!(condition))																		\
 		{																						\
 			printf("ASSERT FAILED: %s\nFile: %s\nLine: %d\n", #condition, __FILE__, __LINE__);	\
-			__debugbreak();																		\
+			OKAY_DEBUG_BREAK();																	\
 		}																						\
 	}0
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Okay.h"
+#include "Engine/Resources/VertexQuantization.h"
+#include "Engine/Resources/MeshSimplifier.h"
+#include "Engine/Graphics/Handlers/IndirectDrawBuilder.h"
 #include "entt/entt.hpp"
 
 #include <d3d12.h>
@@ -15,7 +18,7 @@
 		if (!(condition))																		\
 		{																						\
 			printf("ASSERT FAILED: %s\nFile: %s\nLine: %d\n", #condition, __FILE__, __LINE__);	\
-			__debugbreak();																		\
+			OKAY_DEBUG_BREAK();																	\
 		}																						\
 	}0
 
@@ -66,33 +69,86 @@ namespace Okay
 		uint64_t nextAppendOffset = INVALID_UINT64;
 	};
 
+	struct DXMeshLOD
+	{
+		uint32_t firstIndex = 0;
+		uint32_t numIndicies = 0;
+		float error = 0.f; // Mesh local units, see MeshSimplifier.h
+	};
+
 	struct DXMesh
 	{
 		DXMesh() = default;
 
-		D3D12_GPU_VIRTUAL_ADDRESS gpuVerticiesGVA = {};
-		D3D12_INDEX_BUFFER_VIEW indiciesView = {};
-		uint32_t numIndicies = INVALID_UINT32;
+		// Ranges in the shared buffers of DXMeshBuffers, verticies & indicies are relative to the mesh
+		uint32_t baseVertex = 0;
+		IndexPool indexPool = OKAY_INDEX_POOL_32;
+		uint32_t firstIndex = 0;
+
+		// Index ranges of the full mesh (LOD 0) & its LODs, relative to firstIndex, the same in both index streams
+		DXMeshLOD lods[MAX_MESH_LODS] = {};
+		uint32_t numLODs = 0;
+
+		// Position only stream for the depth passes, the indicies are a copy of the main ones unless positions were merged
+		uint32_t basePosition = 0;
+		IndexPool positionIndexPool = OKAY_INDEX_POOL_32;
+		uint32_t firstPositionIndex = 0;
+
+		// Dequantization of both vertex streams, passed to the shaders with the draw (IndirectDrawData)
+		VertexQuantization quantization;
+
+		// Meshlets for cluster culling (Meshlet in Mesh.h), vertex indicies are relative to baseVertex
+		D3D12_GPU_VIRTUAL_ADDRESS gpuMeshletsGVA = {};
+		D3D12_GPU_VIRTUAL_ADDRESS gpuMeshletVerticiesGVA = {};
+		D3D12_GPU_VIRTUAL_ADDRESS gpuMeshletTrianglesGVA = {};
+		uint32_t numMeshlets = 0;
+
+		glm::vec4 boundingSphere = glm::vec4(0.f); // Local space, xyz = center, w = radius
+		float uvDensity = 0.f; // World units per UV unit, for texture streaming (computeMeshUVDensity)
+	};
+
+	// The vertex & index buffers shared by every DXMesh, one index buffer per IndexPool
+	struct DXMeshBuffers
+	{
+		D3D12_GPU_VIRTUAL_ADDRESS verticiesGVA = {};
+		D3D12_INDEX_BUFFER_VIEW indiciesViews[OKAY_INDEX_POOL_COUNT] = {};
+
+		D3D12_GPU_VIRTUAL_ADDRESS positionsGVA = {};
+		D3D12_INDEX_BUFFER_VIEW positionIndiciesViews[OKAY_INDEX_POOL_COUNT] = {};
 	};
 
+	static_assert(sizeof(IndirectDrawCommand) == sizeof(uint32_t) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), "IndirectDrawCommand must match the command signature");
+
 	struct DrawGroup
 	{
 		DrawGroup() = default;
 
 		uint32_t dxMeshId = INVALID_UINT32;
+		uint32_t lodIdx = 0;
 		std::vector<entt::entity> entities;
 
-		D3D12_GPU_VIRTUAL_ADDRESS objectDatasVA = INVALID_UINT64;
+		uint32_t firstObject = INVALID_UINT32; // Object datas of the frame are in draw group order
 	};
 
 	struct ShadowMap
 	{
 		Allocation textureAllocation = {};
 		D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = {};
+		D3D12_CPU_DESCRIPTOR_HANDLE faceDsvHandles[6] = {}; // Shadow cubes only, for clearing single faces
 		D3D12_GPU_DESCRIPTOR_HANDLE srvHandle = {};
 
 		glm::mat4 viewProjMatrices[6] = {};
 		glm::vec3 lightPos = glm::vec3(0.f);
+		float farPlane = 0.f;
+
+		uint32_t resolution = INVALID_UINT32; // Size of the rendered region in the top left corner, the texture can be bigger
+		uint32_t textureResolution = INVALID_UINT32;
+
+		uint64_t cacheKey = INVALID_UINT64; // See ShadowCache.h
+		bool needsRender = true;
+
+		// Draw groups with at least one caster inside the light volume, the rest are skipped when rendering
+		std::vector<uint32_t> casterDrawGroups;
 	};
 
 	enum DescriptorType : uint32_t
@@ -173,7 +229,8 @@ namespace Okay
 		std::string m_includeBuffer;
 	};
 
-	inline D3D12_SHADER_BYTECODE compileShader(FilePath path, std::string_view version, ID3DBlob** pShaderBlob)
+	// pDefines is null terminated like D3DCompile wants it
+	inline D3D12_SHADER_BYTECODE compileShader(FilePath path, std::string_view version, ID3DBlob** pShaderBlob, const D3D_SHADER_MACRO* pDefines = nullptr)
 	{
 		ID3DBlob* pErrorBlob = nullptr;
 
@@ -185,7 +242,7 @@ namespace Okay
 
 		IncludeReader includer;
 
-		HRESULT hr = D3DCompileFromFile(path.c_str(), nullptr, &includer, "main", version.data(), flags1, 0, pShaderBlob, &pErrorBlob);
+		HRESULT hr = D3DCompileFromFile(path.c_str(), pDefines, &includer, "main", version.data(), flags1, 0, pShaderBlob, &pErrorBlob);
 
 		if (FAILED(hr))
 		{
@@ -295,7 +352,7 @@ namespace Okay
 	constexpr D3D12_ROOT_PARAMETER createRootParamConstants(D3D12_SHADER_VISIBILITY visibility, uint32_t shaderRegister, uint32_t registerSpace, uint32_t numValues)
 	{
 		D3D12_ROOT_PARAMETER param = {};
-		param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+		param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 		param.ShaderVisibility = visibility;
 		param.Constants.Num32BitValues = numValues;
 		param.Constants.ShaderRegister = shaderRegister;
@@ -381,6 +438,25 @@ namespace Okay
 		return rect;
 	}
 
+	// Real size of a resource in its heap, used for memory reports
+	inline uint64_t getAllocationSize(ID3D12Device* pDevice, ID3D12Resource* pDXResource)
+	{
+		D3D12_RESOURCE_DESC resourceDesc = pDXResource->GetDesc();
+		return pDevice->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+	}
+
+	// Same for resources that aren't created, each placed on its own like committed resources
+	inline uint64_t getAllocationSize(ID3D12Device* pDevice, const D3D12_RESOURCE_DESC* pResourceDescs, uint32_t numResources)
+	{
+		uint64_t size = 0;
+		for (uint32_t i = 0; i < numResources; i++)
+		{
+			size += pDevice->GetResourceAllocationInfo(0, 1, &pResourceDescs[i]).SizeInBytes;
+		}
+
+		return size;
+	}
+
 	constexpr D3D12_BLEND_DESC createDefaultBlendDesc()
 	{
 		D3D12_BLEND_DESC desc = {};
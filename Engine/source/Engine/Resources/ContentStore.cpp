@@ -0,0 +1,32 @@
+#include "ContentStore.h"
+#include "Engine/Misc/Hash.h"
+
+#include <cstring>
+
+namespace Okay
+{
+	uint64_t hashMeshContent(const MeshData& meshData)
+	{
+		// The vertex hash seeds the index hash, so moving bytes between the two streams changes the result
+		uint64_t hash = ContentHasher::hash(meshData.verticies.data(), sizeof(Vertex) * meshData.verticies.size());
+		return ContentHasher::hash(meshData.indicies.data(), sizeof(uint32_t) * meshData.indicies.size(), hash);
+	}
+
+	bool isSameMeshContent(const MeshData& meshData, const MeshData& otherMeshData)
+	{
+		if (meshData.verticies.size() != otherMeshData.verticies.size() || meshData.indicies.size() != otherMeshData.indicies.size())
+		{
+			return false;
+		}
+
+		// Empty vectors can have null data, which memcmp doesn't allow
+		return (meshData.verticies.empty() || !memcmp(meshData.verticies.data(), otherMeshData.verticies.data(), sizeof(Vertex) * meshData.verticies.size())) &&
+			(meshData.indicies.empty() || !memcmp(meshData.indicies.data(), otherMeshData.indicies.data(), sizeof(uint32_t) * meshData.indicies.size()));
+	}
+
+	uint64_t hashTextureContent(const uint8_t* pTextureData, TextureFormat format, uint32_t width, uint32_t height, bool isSRGB)
+	{
+		uint64_t seed = ((uint64_t)width << 32 | height) ^ ((uint64_t)format << 60) ^ ((uint64_t)isSRGB << 59);
+		return ContentHasher::hash(pTextureData, getTextureLevelSize(format, width, height), seed);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Mesh.h"
+#include "TextureFormat.h"
+
+#include <unordered_map>
+
+/*
+	Content addressed assets, so identical meshes & textures are only loaded once no matter which file or name they come from.
+
+	Assets are keyed by an XXH64 hash of their content (ContentHasher in Hash.h). A matching hash is only a candidate,
+	the content is compared before an AssetID is shared, so a hash collision gives two assets instead of a wrong one.
+	Assets whose CPU data has been unloaded can't be compared and aren't shared anymore.
+*/
+
+namespace Okay
+{
+	// Loads that returned an existing asset, bytes are what the duplicate would've used on the GPU (packed meshes, mip chains)
+	struct AssetDedupReport
+	{
+		uint32_t numMeshLoads = 0;
+		uint32_t numSharedMeshes = 0;
+		uint64_t meshBytesSaved = 0;
+
+		uint32_t numTextureLoads = 0;
+		uint32_t numSharedTextures = 0;
+		uint64_t textureBytesSaved = 0;
+	};
+
+	// Verticies & indicies, the meshlets & LODs are built from them
+	uint64_t hashMeshContent(const MeshData& meshData);
+	bool isSameMeshContent(const MeshData& meshData, const MeshData& otherMeshData);
+
+	// One level in any TextureFormat, the format & colour space are part of the hash since they change how the same bytes are sampled
+	uint64_t hashTextureContent(const uint8_t* pTextureData, TextureFormat format, uint32_t width, uint32_t height, bool isSRGB);
+
+	class ContentStore
+	{
+	public:
+		ContentStore() = default;
+		~ContentStore() = default;
+
+		// isSameContent(AssetID) is called for every asset with the same hash, returns INVALID_ASSET_ID if none match
+		template<typename IsSameContentFunc>
+		inline AssetID find(uint64_t contentHash, IsSameContentFunc isSameContent) const;
+
+		inline void add(uint64_t contentHash, AssetID id)
+		{
+			m_assets.emplace(contentHash, id);
+		}
+
+		inline uint32_t getNumAssets() const
+		{
+			return (uint32_t)m_assets.size();
+		}
+
+	private:
+		std::unordered_multimap<uint64_t, AssetID> m_assets;
+	};
+
+	template<typename IsSameContentFunc>
+	inline AssetID ContentStore::find(uint64_t contentHash, IsSameContentFunc isSameContent) const
+	{
+		auto candidates = m_assets.equal_range(contentHash);
+		for (auto it = candidates.first; it != candidates.second; ++it)
+		{
+			if (isSameContent(it->second))
+			{
+				return it->second;
+			}
+		}
+
+		return INVALID_ASSET_ID;
+	}
+}
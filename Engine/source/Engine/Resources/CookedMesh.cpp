@@ -0,0 +1,337 @@
+#include "CookedMesh.h"
+#include "GeometryCodec.h"
+#include "ContentStore.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "Engine/Misc/Hash.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace Okay
+{
+	static const uint32_t COOKED_MESH_MAGIC = 0x434D4B4F; // "OKMC"
+	static const uint32_t COOKED_MESH_VERSION = 1; // Bump when the processing changes, old files are cooked again
+
+	// Encoded streams of a mesh, in file order
+	enum CookedMeshSection : uint32_t
+	{
+		OKAY_COOKED_SECTION_VERTICIES = 0,
+		OKAY_COOKED_SECTION_INDICIES = 1,
+		OKAY_COOKED_SECTION_MESHLETS = 2,
+		OKAY_COOKED_SECTION_MESHLET_VERTICIES = 3,
+		OKAY_COOKED_SECTION_MESHLET_TRIANGLES = 4,
+		OKAY_COOKED_SECTION_LOD_0 = 5, // LOD 1, the first simplified one
+		OKAY_COOKED_SECTION_COUNT = OKAY_COOKED_SECTION_LOD_0 + MAX_MESH_LODS - 1,
+	};
+
+	struct CookedMeshFileHeader
+	{
+		uint32_t magic = COOKED_MESH_MAGIC;
+		uint32_t version = COOKED_MESH_VERSION;
+		uint64_t sourceKey = 0;
+		uint32_t numMeshes = 0;
+		uint32_t padding = 0;
+	};
+
+	struct CookedMeshHeader
+	{
+		uint32_t numVerticies = 0;
+		uint32_t numIndicies = 0;
+		uint32_t numMeshlets = 0;
+		uint32_t numMeshletVerticies = 0;
+		uint32_t numMeshletTriangles = 0;
+
+		uint32_t numLODs = 0;
+		uint32_t lodNumIndicies[MAX_MESH_LODS - 1] = {};
+		float lodErrors[MAX_MESH_LODS - 1] = {};
+
+		MeshOptimizationStats stats;
+
+		uint32_t sectionSizes[OKAY_COOKED_SECTION_COUNT] = {};
+	};
+
+	static uint64_t getRawMeshSize(const CookedMesh& mesh)
+	{
+		uint64_t size = sizeof(Vertex) * mesh.meshData.verticies.size() + sizeof(uint32_t) * mesh.meshData.indicies.size();
+		size += sizeof(Meshlet) * mesh.meshletData.meshlets.size();
+		size += sizeof(uint32_t) * (mesh.meshletData.vertexIndicies.size() + mesh.meshletData.triangles.size());
+
+		for (const MeshLOD& lod : mesh.lods)
+		{
+			size += sizeof(uint32_t) * lod.indicies.size();
+		}
+
+		return size;
+	}
+
+	uint64_t getCookedMeshSourceKey(const std::vector<CookedMesh>& meshes)
+	{
+		Hasher hasher;
+		hasher.addValue(COOKED_MESH_VERSION);
+		hasher.addValue(VERTEX_CACHE_SIZE);
+		hasher.addValue(MeshLODSettings());
+		hasher.addValue((uint32_t)meshes.size());
+
+		// The mesh content goes through the faster ContentHasher (ContentStore.h)
+		for (const CookedMesh& mesh : meshes)
+		{
+			hasher.addValue((uint32_t)mesh.meshData.verticies.size());
+			hasher.addValue((uint32_t)mesh.meshData.indicies.size());
+			hasher.addValue(hashMeshContent(mesh.meshData));
+		}
+
+		return hasher.get();
+	}
+
+	bool writeCookedMeshes(const FilePath& path, uint64_t sourceKey, const std::vector<CookedMesh>& meshes, CookedMeshFileStats* pOutStats)
+	{
+		std::ofstream writer(path, std::ios::binary);
+		if (!writer)
+		{
+			return false;
+		}
+
+		CookedMeshFileHeader fileHeader;
+		fileHeader.sourceKey = sourceKey;
+		fileHeader.numMeshes = (uint32_t)meshes.size();
+
+		writer.write((const char*)&fileHeader, sizeof(CookedMeshFileHeader));
+
+		CookedMeshFileStats stats;
+		stats.fileSize = sizeof(CookedMeshFileHeader);
+
+		std::vector<uint8_t> sections[OKAY_COOKED_SECTION_COUNT];
+
+		for (const CookedMesh& mesh : meshes)
+		{
+			OKAY_ASSERT(mesh.lods.size() < MAX_MESH_LODS);
+
+			const MeshData& meshData = mesh.meshData;
+			const MeshletData& meshletData = mesh.meshletData;
+
+			CookedMeshHeader header;
+			header.numVerticies = (uint32_t)meshData.verticies.size();
+			header.numIndicies = (uint32_t)meshData.indicies.size();
+			header.numMeshlets = (uint32_t)meshletData.meshlets.size();
+			header.numMeshletVerticies = (uint32_t)meshletData.vertexIndicies.size();
+			header.numMeshletTriangles = (uint32_t)meshletData.triangles.size();
+			header.numLODs = (uint32_t)mesh.lods.size();
+			header.stats = mesh.stats;
+
+			for (std::vector<uint8_t>& section : sections)
+			{
+				section.clear();
+			}
+
+			encodeVertexStream(meshData.verticies.data(), header.numVerticies, sizeof(Vertex), sections[OKAY_COOKED_SECTION_VERTICIES]);
+			encodeIndexStream(meshData.indicies.data(), header.numIndicies, sections[OKAY_COOKED_SECTION_INDICIES]);
+
+			// Meshlets, their vertex indicies & packed triangles are plain structs, the byte lanes still compress them well
+			encodeVertexStream(meshletData.meshlets.data(), header.numMeshlets, sizeof(Meshlet), sections[OKAY_COOKED_SECTION_MESHLETS]);
+			encodeVertexStream(meshletData.vertexIndicies.data(), header.numMeshletVerticies, sizeof(uint32_t), sections[OKAY_COOKED_SECTION_MESHLET_VERTICIES]);
+			encodeVertexStream(meshletData.triangles.data(), header.numMeshletTriangles, sizeof(uint32_t), sections[OKAY_COOKED_SECTION_MESHLET_TRIANGLES]);
+
+			for (uint32_t i = 0; i < header.numLODs; i++)
+			{
+				header.lodNumIndicies[i] = (uint32_t)mesh.lods[i].indicies.size();
+				header.lodErrors[i] = mesh.lods[i].error;
+
+				encodeIndexStream(mesh.lods[i].indicies.data(), header.lodNumIndicies[i], sections[OKAY_COOKED_SECTION_LOD_0 + i]);
+			}
+
+			for (uint32_t i = 0; i < OKAY_COOKED_SECTION_COUNT; i++)
+			{
+				header.sectionSizes[i] = (uint32_t)sections[i].size();
+			}
+
+			writer.write((const char*)&header, sizeof(CookedMeshHeader));
+			stats.fileSize += sizeof(CookedMeshHeader);
+
+			for (const std::vector<uint8_t>& section : sections)
+			{
+				writer.write((const char*)section.data(), section.size());
+				stats.fileSize += section.size();
+			}
+
+			stats.rawSize += getRawMeshSize(mesh);
+		}
+
+		if (pOutStats)
+		{
+			*pOutStats = stats;
+		}
+
+		return (bool)writer;
+	}
+
+	template<typename T>
+	static bool decodeVertexSection(const uint8_t*& pData, uint32_t sectionSize, uint32_t numElements, std::vector<T>& outElements)
+	{
+		const uint8_t* pSection = pData;
+		pData += sectionSize;
+
+		// A corrupt count could otherwise allocate gigabytes before the decode fails
+		if (numElements > getMaxEncodedVerticies(sectionSize, sizeof(T)))
+		{
+			return false;
+		}
+
+		outElements.resize(numElements);
+		return decodeVertexStream(pSection, sectionSize, numElements, sizeof(T), outElements.data());
+	}
+
+	// Every index has to be in [0, numVerticies)
+	static bool decodeIndexSection(const uint8_t*& pData, uint32_t sectionSize, uint32_t numIndicies, uint32_t numVerticies, std::vector<uint32_t>& outIndicies)
+	{
+		const uint8_t* pSection = pData;
+		pData += sectionSize;
+
+		if (numIndicies % 3 != 0 || numIndicies > getMaxEncodedIndicies(sectionSize))
+		{
+			return false;
+		}
+
+		outIndicies.resize(numIndicies);
+		if (!decodeIndexStream(pSection, sectionSize, numIndicies, outIndicies.data()))
+		{
+			return false;
+		}
+
+		for (uint32_t index : outIndicies)
+		{
+			if (index >= numVerticies)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// The meshlets are read straight by the culling & the GPU, every offset & local index has to stay inside its array
+	static bool validateMeshlets(const MeshletData& meshletData, uint32_t numVerticies)
+	{
+		for (uint32_t vertex : meshletData.vertexIndicies)
+		{
+			if (vertex >= numVerticies)
+			{
+				return false;
+			}
+		}
+
+		for (const Meshlet& meshlet : meshletData.meshlets)
+		{
+			if (meshlet.numVerticies > MESHLET_MAX_VERTICIES || meshlet.numTriangles > MESHLET_MAX_TRIANGLES ||
+				(uint64_t)meshlet.vertexOffset + meshlet.numVerticies > meshletData.vertexIndicies.size() ||
+				(uint64_t)meshlet.triangleOffset + meshlet.numTriangles > meshletData.triangles.size())
+			{
+				return false;
+			}
+
+			for (uint32_t i = 0; i < meshlet.numTriangles; i++)
+			{
+				uint32_t triangle = meshletData.triangles[meshlet.triangleOffset + i];
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					if (unpackMeshletVertex(triangle, corner) >= meshlet.numVerticies)
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool readCookedMeshes(const FilePath& path, uint64_t sourceKey, std::vector<CookedMesh>& meshes, CookedMeshFileStats* pOutStats)
+	{
+		std::string fileData;
+		if (!readBinary(path, fileData) || fileData.size() < sizeof(CookedMeshFileHeader))
+		{
+			return false;
+		}
+
+		CookedMeshFileHeader fileHeader;
+		memcpy(&fileHeader, fileData.data(), sizeof(CookedMeshFileHeader));
+
+		if (fileHeader.magic != COOKED_MESH_MAGIC || fileHeader.version != COOKED_MESH_VERSION ||
+			fileHeader.sourceKey != sourceKey || fileHeader.numMeshes != (uint32_t)meshes.size())
+		{
+			return false;
+		}
+
+		const uint8_t* pData = (const uint8_t*)fileData.data() + sizeof(CookedMeshFileHeader);
+		const uint8_t* pDataEnd = (const uint8_t*)fileData.data() + fileData.size();
+
+		CookedMeshFileStats stats;
+		stats.fileSize = fileData.size();
+
+		for (CookedMesh& mesh : meshes)
+		{
+			if ((size_t)(pDataEnd - pData) < sizeof(CookedMeshHeader))
+			{
+				return false;
+			}
+
+			CookedMeshHeader header;
+			memcpy(&header, pData, sizeof(CookedMeshHeader));
+			pData += sizeof(CookedMeshHeader);
+
+			uint64_t sectionsSize = 0;
+			for (uint32_t sectionSize : header.sectionSizes)
+			{
+				sectionsSize += sectionSize;
+			}
+
+			if (header.numLODs >= MAX_MESH_LODS || sectionsSize > (uint64_t)(pDataEnd - pData))
+			{
+				return false;
+			}
+
+			MeshletData& meshletData = mesh.meshletData;
+
+			bool decoded = true;
+			decoded &= decodeVertexSection(pData, header.sectionSizes[OKAY_COOKED_SECTION_VERTICIES], header.numVerticies, mesh.meshData.verticies);
+			decoded &= decodeIndexSection(pData, header.sectionSizes[OKAY_COOKED_SECTION_INDICIES], header.numIndicies, header.numVerticies, mesh.meshData.indicies);
+			decoded &= decodeVertexSection(pData, header.sectionSizes[OKAY_COOKED_SECTION_MESHLETS], header.numMeshlets, meshletData.meshlets);
+			decoded &= decodeVertexSection(pData, header.sectionSizes[OKAY_COOKED_SECTION_MESHLET_VERTICIES], header.numMeshletVerticies, meshletData.vertexIndicies);
+			decoded &= decodeVertexSection(pData, header.sectionSizes[OKAY_COOKED_SECTION_MESHLET_TRIANGLES], header.numMeshletTriangles, meshletData.triangles);
+
+			mesh.lods.resize(header.numLODs);
+			for (uint32_t i = 0; i < MAX_MESH_LODS - 1; i++)
+			{
+				if (i < header.numLODs)
+				{
+					mesh.lods[i].error = header.lodErrors[i];
+					decoded &= decodeIndexSection(pData, header.sectionSizes[OKAY_COOKED_SECTION_LOD_0 + i], header.lodNumIndicies[i], header.numVerticies, mesh.lods[i].indicies);
+				}
+				else
+				{
+					pData += header.sectionSizes[OKAY_COOKED_SECTION_LOD_0 + i];
+				}
+			}
+
+			if (!decoded || !validateMeshlets(meshletData, header.numVerticies))
+			{
+				return false;
+			}
+
+			mesh.stats = header.stats;
+			stats.rawSize += getRawMeshSize(mesh);
+		}
+
+		if (pData != pDataEnd)
+		{
+			return false;
+		}
+
+		if (pOutStats)
+		{
+			*pOutStats = stats;
+		}
+
+		return true;
+	}
+}
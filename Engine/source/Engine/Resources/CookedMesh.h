@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+#include <vector>
+
+/*
+	Cooked mesh files, a cache of everything done to the meshes of a model at import (optimization, meshlets & LODs)
+	so the next load only has to decode them. Written next to the model as "<model>.okaymesh".
+
+	The file is keyed by a hash of the meshes before processing (getCookedMeshSourceKey), a changed model, changed
+	merge settings or a new COOKED_MESH_VERSION makes the read fail and the meshes are processed & written again.
+	Every stream is compressed with GeometryCodec.h.
+*/
+
+namespace Okay
+{
+	// Everything done to a mesh between import & the ResourceManager
+	struct CookedMesh
+	{
+		MeshData meshData;
+		MeshletData meshletData;
+		std::vector<MeshLOD> lods;
+		MeshOptimizationStats stats;
+	};
+
+	struct CookedMeshFileStats
+	{
+		uint64_t rawSize = 0; // Of the streams as they are in memory
+		uint64_t fileSize = 0;
+	};
+
+	// Hashes the meshes as they come from the importer, together with the processing settings & the cook version
+	uint64_t getCookedMeshSourceKey(const std::vector<CookedMesh>& meshes);
+
+	inline FilePath getCookedMeshPath(const FilePath& modelPath)
+	{
+		return FilePath(modelPath.string() + ".okaymesh");
+	}
+
+	bool writeCookedMeshes(const FilePath& path, uint64_t sourceKey, const std::vector<CookedMesh>& meshes, CookedMeshFileStats* pOutStats = nullptr);
+
+	// meshes has to be sized to the number of meshes in the file, returns false if the file is missing, stale or corrupt
+	bool readCookedMeshes(const FilePath& path, uint64_t sourceKey, std::vector<CookedMesh>& meshes, CookedMeshFileStats* pOutStats = nullptr);
+}
@@ -0,0 +1,622 @@
+#include "GeometryCodec.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define OKAY_GEOMETRY_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Okay
+{
+	static const uint32_t VERTEX_BLOCK_SIZE = 256; // Verticies, a multiple of VERTEX_GROUP_SIZE
+	static const uint32_t VERTEX_GROUP_SIZE = 16;
+	static const uint32_t MAX_VERTEX_SIZE = 256;
+
+	// Bits per delta for each of the 2 bit group modes
+	static const uint32_t GROUP_BITS[4] = { 0, 2, 4, 8 };
+
+	// The top code nibble 15 means no edge, the bottom nibble 0 is the next new vertex & 15 an explicit vertex
+	static const uint32_t EDGE_FIFO_SIZE = 15;
+	static const uint32_t VERTEX_FIFO_SIZE = 14;
+
+	static inline uint8_t zigzag8(uint8_t delta)
+	{
+		return (uint8_t)((delta << 1) ^ (uint8_t)((int8_t)delta >> 7));
+	}
+
+	static inline uint8_t unzigzag8(uint8_t value)
+	{
+		return (uint8_t)((value >> 1) ^ (uint8_t)(0 - (value & 1)));
+	}
+
+	static inline uint32_t zigzag32(int32_t value)
+	{
+		return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+	}
+
+	static inline int32_t unzigzag32(uint32_t value)
+	{
+		return (int32_t)((value >> 1) ^ (0 - (value & 1)));
+	}
+
+	static void encodeGroup(const uint8_t* pDeltas, uint32_t mode, std::vector<uint8_t>& outData)
+	{
+		switch (mode)
+		{
+		case 1: // byte j holds deltas j, j + 4, j + 8 & j + 12
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				outData.emplace_back((uint8_t)(pDeltas[j] | pDeltas[j + 4] << 2 | pDeltas[j + 8] << 4 | pDeltas[j + 12] << 6));
+			}
+			break;
+
+		case 2: // byte j holds deltas j & j + 8
+			for (uint32_t j = 0; j < 8; j++)
+			{
+				outData.emplace_back((uint8_t)(pDeltas[j] | pDeltas[j + 8] << 4));
+			}
+			break;
+
+		case 3:
+			outData.insert(outData.end(), pDeltas, pDeltas + VERTEX_GROUP_SIZE);
+			break;
+		}
+	}
+
+	// Unpacks 16 deltas & prefix sums them onto lastValue
+	static inline void decodeGroup(const uint8_t* pData, uint32_t mode, uint8_t& lastValue, uint8_t* pOutValues)
+	{
+#ifdef OKAY_GEOMETRY_CODEC_SSE2
+		// Lanes that don't change are common (flat normals, constant tangents), they skip the prefix sum
+		if (mode == 0)
+		{
+			_mm_storeu_si128((__m128i*)pOutValues, _mm_set1_epi8((char)lastValue));
+			return;
+		}
+
+		__m128i deltas = _mm_setzero_si128();
+
+		if (mode == 1)
+		{
+			int32_t packed = 0;
+			memcpy(&packed, pData, sizeof(int32_t));
+
+			__m128i bits = _mm_cvtsi32_si128(packed);
+			__m128i mask = _mm_set1_epi8(0x03);
+
+			__m128i deltas0 = _mm_and_si128(bits, mask);
+			__m128i deltas4 = _mm_and_si128(_mm_srli_epi16(bits, 2), mask);
+			__m128i deltas8 = _mm_and_si128(_mm_srli_epi16(bits, 4), mask);
+			__m128i deltas12 = _mm_and_si128(_mm_srli_epi16(bits, 6), mask);
+
+			deltas = _mm_unpacklo_epi64(_mm_unpacklo_epi32(deltas0, deltas4), _mm_unpacklo_epi32(deltas8, deltas12));
+		}
+		else if (mode == 2)
+		{
+			__m128i bits = _mm_loadl_epi64((const __m128i*)pData);
+			__m128i mask = _mm_set1_epi8(0x0F);
+
+			deltas = _mm_unpacklo_epi64(_mm_and_si128(bits, mask), _mm_and_si128(_mm_srli_epi16(bits, 4), mask));
+		}
+		else if (mode == 3)
+		{
+			deltas = _mm_loadu_si128((const __m128i*)pData);
+		}
+
+		// Unzigzag, SSE2 has no 8 bit shifts so the 16 bit shift is masked
+		__m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(deltas, _mm_set1_epi8(0x01)));
+		__m128i values = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(deltas, 1), _mm_set1_epi8(0x7F)), sign);
+
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 1));
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 2));
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 4));
+		values = _mm_add_epi8(values, _mm_slli_si128(values, 8));
+		values = _mm_add_epi8(values, _mm_set1_epi8((char)lastValue));
+
+		_mm_storeu_si128((__m128i*)pOutValues, values);
+		lastValue = pOutValues[VERTEX_GROUP_SIZE - 1];
+#else
+		uint8_t deltas[VERTEX_GROUP_SIZE] = {};
+
+		for (uint32_t j = 0; j < VERTEX_GROUP_SIZE && mode == 1; j++)
+		{
+			deltas[j] = (pData[j % 4] >> (j / 4 * 2)) & 0x03;
+		}
+
+		for (uint32_t j = 0; j < VERTEX_GROUP_SIZE && mode == 2; j++)
+		{
+			deltas[j] = (pData[j % 8] >> (j / 8 * 4)) & 0x0F;
+		}
+
+		if (mode == 3)
+		{
+			memcpy(deltas, pData, VERTEX_GROUP_SIZE);
+		}
+
+		for (uint32_t j = 0; j < VERTEX_GROUP_SIZE; j++)
+		{
+			lastValue += unzigzag8(deltas[j]);
+			pOutValues[j] = lastValue;
+		}
+#endif
+	}
+
+#ifdef OKAY_GEOMETRY_CODEC_SSE2
+	// rows[k] = byte k of 16 verticies -> rows[j] = 16 bytes of vertex j
+	static inline void transpose16x16(__m128i* pRows)
+	{
+		__m128i pairs[16]; // 2 bytes of 8 verticies
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			pairs[i] = _mm_unpacklo_epi8(pRows[i * 2], pRows[i * 2 + 1]);
+			pairs[i + 8] = _mm_unpackhi_epi8(pRows[i * 2], pRows[i * 2 + 1]);
+		}
+
+		__m128i quads[16]; // quads[g * 4 + q] = bytes 4q to 4q + 3 of verticies 4g to 4g + 3
+		for (uint32_t half = 0; half < 2; half++)
+		{
+			for (uint32_t q = 0; q < 4; q++)
+			{
+				quads[half * 8 + q] = _mm_unpacklo_epi16(pairs[half * 8 + q * 2], pairs[half * 8 + q * 2 + 1]);
+				quads[half * 8 + 4 + q] = _mm_unpackhi_epi16(pairs[half * 8 + q * 2], pairs[half * 8 + q * 2 + 1]);
+			}
+		}
+
+		for (uint32_t g = 0; g < 4; g++)
+		{
+			__m128i octets[4]; // octets[pair * 2 + s] = bytes 8s to 8s + 7 of verticies 4g + pair * 2 & the one after
+			for (uint32_t s = 0; s < 2; s++)
+			{
+				octets[s] = _mm_unpacklo_epi32(quads[g * 4 + s * 2], quads[g * 4 + s * 2 + 1]);
+				octets[2 + s] = _mm_unpackhi_epi32(quads[g * 4 + s * 2], quads[g * 4 + s * 2 + 1]);
+			}
+
+			for (uint32_t pair = 0; pair < 2; pair++)
+			{
+				pRows[g * 4 + pair * 2] = _mm_unpacklo_epi64(octets[pair * 2], octets[pair * 2 + 1]);
+				pRows[g * 4 + pair * 2 + 1] = _mm_unpackhi_epi64(octets[pair * 2], octets[pair * 2 + 1]);
+			}
+		}
+	}
+#endif
+
+	// Lanes are stored VERTEX_BLOCK_SIZE apart, verticies 0 to numVerticies of the block are written
+	static void transposeBlock(const uint8_t* pLanes, uint32_t numVerticies, uint32_t vertexSize, uint8_t* pOutVerticies)
+	{
+		uint32_t lane = 0;
+
+#ifdef OKAY_GEOMETRY_CODEC_SSE2
+		// 16 lanes of 16 verticies at a time
+		for (; lane + 16 <= vertexSize; lane += 16)
+		{
+			const uint8_t* pLane = pLanes + lane * VERTEX_BLOCK_SIZE;
+
+			for (uint32_t i = 0; i < numVerticies; i += VERTEX_GROUP_SIZE)
+			{
+				__m128i rows[16];
+				for (uint32_t k = 0; k < 16; k++)
+				{
+					rows[k] = _mm_loadu_si128((const __m128i*)(pLane + k * VERTEX_BLOCK_SIZE + i));
+				}
+
+				transpose16x16(rows);
+
+				uint32_t numGroupVerticies = glm::min(numVerticies - i, VERTEX_GROUP_SIZE);
+				for (uint32_t j = 0; j < numGroupVerticies; j++)
+				{
+					_mm_storeu_si128((__m128i*)(pOutVerticies + (i + j) * vertexSize + lane), rows[j]);
+				}
+			}
+		}
+
+		// Then 4 lanes, interleaved into 4 bytes per vertex
+		for (; lane + 4 <= vertexSize; lane += 4)
+		{
+			const uint8_t* pLane = pLanes + lane * VERTEX_BLOCK_SIZE;
+
+			for (uint32_t i = 0; i < numVerticies; i += VERTEX_GROUP_SIZE)
+			{
+				__m128i lane0 = _mm_loadu_si128((const __m128i*)(pLane + i));
+				__m128i lane1 = _mm_loadu_si128((const __m128i*)(pLane + VERTEX_BLOCK_SIZE + i));
+				__m128i lane2 = _mm_loadu_si128((const __m128i*)(pLane + VERTEX_BLOCK_SIZE * 2 + i));
+				__m128i lane3 = _mm_loadu_si128((const __m128i*)(pLane + VERTEX_BLOCK_SIZE * 3 + i));
+
+				__m128i lanes01Lo = _mm_unpacklo_epi8(lane0, lane1);
+				__m128i lanes01Hi = _mm_unpackhi_epi8(lane0, lane1);
+				__m128i lanes23Lo = _mm_unpacklo_epi8(lane2, lane3);
+				__m128i lanes23Hi = _mm_unpackhi_epi8(lane2, lane3);
+
+				uint32_t interleaved[VERTEX_GROUP_SIZE];
+				_mm_storeu_si128((__m128i*)interleaved, _mm_unpacklo_epi16(lanes01Lo, lanes23Lo));
+				_mm_storeu_si128((__m128i*)(interleaved + 4), _mm_unpackhi_epi16(lanes01Lo, lanes23Lo));
+				_mm_storeu_si128((__m128i*)(interleaved + 8), _mm_unpacklo_epi16(lanes01Hi, lanes23Hi));
+				_mm_storeu_si128((__m128i*)(interleaved + 12), _mm_unpackhi_epi16(lanes01Hi, lanes23Hi));
+
+				uint32_t numGroupVerticies = glm::min(numVerticies - i, VERTEX_GROUP_SIZE);
+				for (uint32_t j = 0; j < numGroupVerticies; j++)
+				{
+					memcpy(pOutVerticies + (i + j) * vertexSize + lane, &interleaved[j], sizeof(uint32_t));
+				}
+			}
+		}
+#endif
+
+		for (; lane < vertexSize; lane++)
+		{
+			const uint8_t* pLane = pLanes + lane * VERTEX_BLOCK_SIZE;
+			for (uint32_t i = 0; i < numVerticies; i++)
+			{
+				pOutVerticies[i * vertexSize + lane] = pLane[i];
+			}
+		}
+	}
+
+	void encodeVertexStream(const void* pVerticies, uint32_t numVerticies, uint32_t vertexSize, std::vector<uint8_t>& outData)
+	{
+		OKAY_ASSERT(vertexSize > 0 && vertexSize <= MAX_VERTEX_SIZE);
+
+		const uint8_t* pBytes = (const uint8_t*)pVerticies;
+
+		std::vector<uint8_t> lastValues(vertexSize, 0);
+		uint8_t deltas[VERTEX_BLOCK_SIZE] = {};
+
+		outData.clear();
+
+		for (uint32_t blockStart = 0; blockStart < numVerticies; blockStart += VERTEX_BLOCK_SIZE)
+		{
+			uint32_t numBlockVerticies = glm::min(numVerticies - blockStart, VERTEX_BLOCK_SIZE);
+			uint32_t numGroups = (numBlockVerticies + VERTEX_GROUP_SIZE - 1) / VERTEX_GROUP_SIZE;
+
+			for (uint32_t lane = 0; lane < vertexSize; lane++)
+			{
+				// The last group is padded with zero deltas
+				memset(deltas, 0, sizeof(deltas));
+				for (uint32_t i = 0; i < numBlockVerticies; i++)
+				{
+					uint8_t value = pBytes[(blockStart + i) * (size_t)vertexSize + lane];
+					deltas[i] = zigzag8((uint8_t)(value - lastValues[lane]));
+					lastValues[lane] = value;
+				}
+
+				size_t headerOffset = outData.size();
+				outData.resize(outData.size() + (numGroups + 3) / 4, 0);
+
+				for (uint32_t group = 0; group < numGroups; group++)
+				{
+					const uint8_t* pGroupDeltas = deltas + group * VERTEX_GROUP_SIZE;
+
+					uint8_t maxDelta = 0;
+					for (uint32_t j = 0; j < VERTEX_GROUP_SIZE; j++)
+					{
+						maxDelta = glm::max(maxDelta, pGroupDeltas[j]);
+					}
+
+					uint32_t mode = maxDelta == 0 ? 0 : maxDelta < 4 ? 1 : maxDelta < 16 ? 2 : 3;
+
+					outData[headerOffset + group / 4] |= (uint8_t)(mode << (group % 4 * 2));
+					encodeGroup(pGroupDeltas, mode, outData);
+				}
+			}
+		}
+	}
+
+	bool decodeVertexStream(const uint8_t* pData, size_t dataSize, uint32_t numVerticies, uint32_t vertexSize, void* pOutVerticies)
+	{
+		if (vertexSize == 0 || vertexSize > MAX_VERTEX_SIZE)
+		{
+			return false;
+		}
+
+		const uint8_t* pEnd = pData + dataSize;
+		uint8_t* pOutBytes = (uint8_t*)pOutVerticies;
+
+		uint8_t lastValues[MAX_VERTEX_SIZE] = {};
+		std::vector<uint8_t> lanes((size_t)vertexSize * VERTEX_BLOCK_SIZE);
+
+		for (uint32_t blockStart = 0; blockStart < numVerticies; blockStart += VERTEX_BLOCK_SIZE)
+		{
+			uint32_t numBlockVerticies = glm::min(numVerticies - blockStart, VERTEX_BLOCK_SIZE);
+			uint32_t numGroups = (numBlockVerticies + VERTEX_GROUP_SIZE - 1) / VERTEX_GROUP_SIZE;
+			uint32_t headerSize = (numGroups + 3) / 4;
+
+			for (uint32_t lane = 0; lane < vertexSize; lane++)
+			{
+				if ((size_t)(pEnd - pData) < headerSize)
+				{
+					return false;
+				}
+
+				const uint8_t* pHeader = pData;
+				pData += headerSize;
+
+				uint8_t* pLane = lanes.data() + lane * VERTEX_BLOCK_SIZE;
+				for (uint32_t group = 0; group < numGroups; group++)
+				{
+					uint32_t mode = (pHeader[group / 4] >> (group % 4 * 2)) & 0x03;
+					uint32_t payloadSize = GROUP_BITS[mode] * VERTEX_GROUP_SIZE / 8;
+
+					if ((size_t)(pEnd - pData) < payloadSize)
+					{
+						return false;
+					}
+
+					decodeGroup(pData, mode, lastValues[lane], pLane + group * VERTEX_GROUP_SIZE);
+					pData += payloadSize;
+				}
+			}
+
+			transposeBlock(lanes.data(), numBlockVerticies, vertexSize, pOutBytes + blockStart * (size_t)vertexSize);
+		}
+
+		return pData == pEnd;
+	}
+
+	struct IndexCodecState
+	{
+		uint32_t edgeFifo[16][2] = {};
+		uint32_t vertexFifo[16] = {};
+		uint32_t edgeOffset = 0;
+		uint32_t vertexOffset = 0;
+
+		uint32_t nextVertex = 0;
+		uint32_t lastVertex = 0;
+
+		inline void pushEdge(uint32_t a, uint32_t b)
+		{
+			edgeFifo[edgeOffset & 15][0] = a;
+			edgeFifo[edgeOffset & 15][1] = b;
+			edgeOffset++;
+		}
+
+		inline void pushVertex(uint32_t vertex)
+		{
+			vertexFifo[vertexOffset & 15] = vertex;
+			vertexOffset++;
+		}
+
+		// Edges are stored the way the triangle on the other side of them sees them
+		inline void pushTriangleEdges(uint32_t a, uint32_t b, uint32_t c)
+		{
+			pushEdge(b, a);
+			pushEdge(c, b);
+			pushEdge(a, c);
+		}
+
+		// Idx 0 is the most recent
+		inline const uint32_t* getEdge(uint32_t fifoIdx) const { return edgeFifo[(edgeOffset - 1 - fifoIdx) & 15]; }
+		inline uint32_t getVertex(uint32_t fifoIdx) const { return vertexFifo[(vertexOffset - 1 - fifoIdx) & 15]; }
+	};
+
+	static void writeVarint(uint32_t value, std::vector<uint8_t>& outData)
+	{
+		while (value >= 0x80)
+		{
+			outData.emplace_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+
+		outData.emplace_back((uint8_t)value);
+	}
+
+	static bool readVarint(const uint8_t*& pData, const uint8_t* pEnd, uint32_t& outValue)
+	{
+		outValue = 0;
+		for (uint32_t shift = 0; shift < 35; shift += 7)
+		{
+			if (pData == pEnd)
+			{
+				return false;
+			}
+
+			uint8_t byte = *pData++;
+			outValue |= (uint32_t)(byte & 0x7F) << shift;
+
+			if (!(byte & 0x80))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Returns the 4 bit vertex code, explicit verticies are written to outExplicitData
+	static uint32_t encodeVertex(uint32_t vertex, IndexCodecState& state, std::vector<uint8_t>& outExplicitData)
+	{
+		if (vertex == state.nextVertex)
+		{
+			state.nextVertex++;
+			state.pushVertex(vertex);
+			return 0;
+		}
+
+		for (uint32_t i = 0; i < VERTEX_FIFO_SIZE; i++)
+		{
+			if (state.getVertex(i) == vertex)
+			{
+				return i + 1;
+			}
+		}
+
+		writeVarint(zigzag32((int32_t)(vertex - state.lastVertex)), outExplicitData);
+		state.lastVertex = vertex;
+		state.pushVertex(vertex);
+
+		return 15;
+	}
+
+	static inline bool decodeVertex(uint32_t code, IndexCodecState& state, const uint8_t*& pData, const uint8_t* pEnd, uint32_t& outVertex)
+	{
+		if (code == 0)
+		{
+			outVertex = state.nextVertex++;
+			state.pushVertex(outVertex);
+			return true;
+		}
+
+		if (code <= VERTEX_FIFO_SIZE)
+		{
+			outVertex = state.getVertex(code - 1);
+			return true;
+		}
+
+		// Most explicit verticies are close to the last one & fit in a single byte
+		uint32_t delta = 0;
+		if (pData < pEnd && *pData < 0x80)
+		{
+			delta = *pData++;
+		}
+		else if (!readVarint(pData, pEnd, delta))
+		{
+			return false;
+		}
+
+		outVertex = state.lastVertex + (uint32_t)unzigzag32(delta);
+		state.lastVertex = outVertex;
+		state.pushVertex(outVertex);
+
+		return true;
+	}
+
+	void encodeIndexStream(const uint32_t* pIndicies, uint32_t numIndicies, std::vector<uint8_t>& outData)
+	{
+		OKAY_ASSERT(numIndicies % 3 == 0);
+
+		IndexCodecState state;
+		std::vector<uint8_t> explicitData;
+
+		outData.clear();
+		outData.reserve(numIndicies / 3 + numIndicies / 8);
+
+		for (uint32_t i = 0; i < numIndicies; i += 3)
+		{
+			uint32_t a = pIndicies[i], b = pIndicies[i + 1], c = pIndicies[i + 2];
+			explicitData.clear();
+
+			// Any rotation of the triangle can continue from a recent edge
+			uint32_t edgeIdx = INVALID_UINT32;
+			for (uint32_t j = 0; j < EDGE_FIFO_SIZE && edgeIdx == INVALID_UINT32; j++)
+			{
+				const uint32_t* pEdge = state.getEdge(j);
+
+				if (pEdge[0] == b && pEdge[1] == c)
+				{
+					uint32_t first = a;
+					a = b, b = c, c = first;
+				}
+				else if (pEdge[0] == c && pEdge[1] == a)
+				{
+					uint32_t last = c;
+					c = b, b = a, a = last;
+				}
+				else if (pEdge[0] != a || pEdge[1] != b)
+				{
+					continue;
+				}
+
+				edgeIdx = j;
+			}
+
+			if (edgeIdx != INVALID_UINT32)
+			{
+				uint32_t code = encodeVertex(c, state, explicitData);
+				outData.emplace_back((uint8_t)(edgeIdx << 4 | code));
+
+				state.pushEdge(c, b);
+				state.pushEdge(a, c);
+			}
+			else
+			{
+				uint32_t codeA = encodeVertex(a, state, explicitData);
+				uint32_t codeB = encodeVertex(b, state, explicitData);
+				uint32_t codeC = encodeVertex(c, state, explicitData);
+
+				outData.emplace_back((uint8_t)(0xF0 | codeA));
+				outData.emplace_back((uint8_t)(codeB << 4 | codeC));
+
+				state.pushTriangleEdges(a, b, c);
+			}
+
+			outData.insert(outData.end(), explicitData.begin(), explicitData.end());
+		}
+	}
+
+	bool decodeIndexStream(const uint8_t* pData, size_t dataSize, uint32_t numIndicies, uint32_t* pOutIndicies)
+	{
+		if (numIndicies % 3 != 0)
+		{
+			return false;
+		}
+
+		const uint8_t* pEnd = pData + dataSize;
+		IndexCodecState state;
+
+		for (uint32_t i = 0; i < numIndicies; i += 3)
+		{
+			if (pData == pEnd)
+			{
+				return false;
+			}
+
+			uint8_t code = *pData++;
+			uint32_t edgeIdx = code >> 4;
+
+			uint32_t a = 0, b = 0, c = 0;
+			if (edgeIdx < EDGE_FIFO_SIZE)
+			{
+				const uint32_t* pEdge = state.getEdge(edgeIdx);
+				a = pEdge[0];
+				b = pEdge[1];
+
+				if (!decodeVertex(code & 0x0F, state, pData, pEnd, c))
+				{
+					return false;
+				}
+
+				state.pushEdge(c, b);
+				state.pushEdge(a, c);
+			}
+			else
+			{
+				if (pData == pEnd)
+				{
+					return false;
+				}
+
+				uint8_t codeBC = *pData++;
+				if (!decodeVertex(code & 0x0F, state, pData, pEnd, a) ||
+					!decodeVertex(codeBC >> 4, state, pData, pEnd, b) ||
+					!decodeVertex(codeBC & 0x0F, state, pData, pEnd, c))
+				{
+					return false;
+				}
+
+				state.pushTriangleEdges(a, b, c);
+			}
+
+			pOutIndicies[i] = a;
+			pOutIndicies[i + 1] = b;
+			pOutIndicies[i + 2] = c;
+		}
+
+		return pData == pEnd;
+	}
+
+	uint64_t getMaxEncodedVerticies(size_t dataSize, uint32_t vertexSize)
+	{
+		if (vertexSize == 0)
+		{
+			return 0;
+		}
+
+		// Every lane has at least one header byte per 4 groups, even when all the deltas are 0
+		return (uint64_t)(dataSize / vertexSize) * VERTEX_GROUP_SIZE * 4;
+	}
+
+	uint64_t getMaxEncodedIndicies(size_t dataSize)
+	{
+		// At least the code byte per triangle
+		return (uint64_t)dataSize * 3;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+/*
+	Lossless compression of the vertex & index streams in cooked mesh files (CookedMesh.h).
+
+	Vertex streams work on any fixed size element. The verticies are split into byte lanes (byte k of every vertex),
+	every lane is delta encoded against the previous vertex and the zigzagged deltas are bit packed in groups of 16
+	with 0, 2, 4 or 8 bits each. Neighbouring verticies are similar after optimizeMesh, so most lanes end up with tiny deltas.
+	The decoder unpacks and prefix sums 16 deltas at a time with SSE2, with a scalar fallback that gives the same result.
+
+	Index streams are coded per triangle against a FIFO of recent edges & verticies, like strips without restarts.
+	Triangles that share an edge with a recent one cost a byte, verticies that are used for the first time in
+	order (optimizeMesh orders them like that) are free. Triangles can come back rotated, the winding & order are kept.
+*/
+
+namespace Okay
+{
+	void encodeVertexStream(const void* pVerticies, uint32_t numVerticies, uint32_t vertexSize, std::vector<uint8_t>& outData);
+
+	// dataSize has to be the exact size of the encoded stream, returns false for corrupt or truncated data
+	bool decodeVertexStream(const uint8_t* pData, size_t dataSize, uint32_t numVerticies, uint32_t vertexSize, void* pOutVerticies);
+
+	// numIndicies has to be a multiple of 3
+	void encodeIndexStream(const uint32_t* pIndicies, uint32_t numIndicies, std::vector<uint8_t>& outData);
+	bool decodeIndexStream(const uint8_t* pData, size_t dataSize, uint32_t numIndicies, uint32_t* pOutIndicies);
+
+	// The most elements dataSize encoded bytes can hold, bigger counts are corrupt & can be rejected before allocating
+	uint64_t getMaxEncodedVerticies(size_t dataSize, uint32_t vertexSize);
+	uint64_t getMaxEncodedIndicies(size_t dataSize);
+}
@@ -12,6 +12,66 @@ namespace Okay
 		std::vector<uint32_t> indicies;
 	};
 
+	// Same layout on the GPU, see DXMesh::gpuMeshletsGVA
+	struct Meshlet
+	{
+		uint32_t vertexOffset = 0; // Into MeshletData::vertexIndicies
+		uint32_t triangleOffset = 0; // Into MeshletData::triangles
+		uint32_t numVerticies = 0;
+		uint32_t numTriangles = 0;
+
+		glm::vec3 center = glm::vec3(0.f);
+		float radius = 0.f;
+
+		// Every triangle faces away from cameras where dot(normalize(coneApex - camera), coneAxis) >= coneCutoff
+		glm::vec3 coneApex = glm::vec3(0.f);
+		float coneCutoff = 1.f; // 1 = can't be backface culled
+		glm::vec3 coneAxis = glm::vec3(0.f, 0.f, 1.f);
+		float padding = 0.f;
+	};
+
+	struct MeshletData
+	{
+		std::vector<Meshlet> meshlets;
+		std::vector<uint32_t> vertexIndicies; // Meshlet local vertex -> mesh vertex
+		std::vector<uint32_t> triangles; // 3x 8 bit meshlet local verticies per triangle
+	};
+
+	// Simplified index buffer into the same verticies as the full mesh, see MeshSimplifier.h
+	struct MeshLOD
+	{
+		std::vector<uint32_t> indicies;
+		float error = 0.f; // Geometric error in mesh local units
+	};
+
+	// xyz = center of the bounds, w = distance to the furthest vertex
+	inline glm::vec4 computeBoundingSphere(const std::vector<Vertex>& verticies)
+	{
+		if (verticies.empty())
+		{
+			return glm::vec4(0.f);
+		}
+
+		glm::vec3 minPos = verticies[0].position;
+		glm::vec3 maxPos = verticies[0].position;
+		for (const Vertex& vertex : verticies)
+		{
+			minPos = glm::min(minPos, vertex.position);
+			maxPos = glm::max(maxPos, vertex.position);
+		}
+
+		glm::vec3 center = (minPos + maxPos) * 0.5f;
+
+		float maxDistSqrd = 0.f;
+		for (const Vertex& vertex : verticies)
+		{
+			glm::vec3 toVertex = vertex.position - center;
+			maxDistSqrd = glm::max(maxDistSqrd, glm::dot(toVertex, toVertex));
+		}
+
+		return glm::vec4(center, glm::sqrt(maxDistSqrd));
+	}
+
 	class Mesh
 	{
 	public:
@@ -19,6 +79,13 @@ namespace Okay
 		Mesh(const MeshData& meshData)
 			:m_meshData(meshData)
 		{
+			calculateBoundingSphere();
+		}
+
+		Mesh(const MeshData& meshData, const MeshletData& meshletData, const std::vector<MeshLOD>& lods = {})
+			:m_meshData(meshData), m_meshletData(meshletData), m_lods(lods)
+		{
+			calculateBoundingSphere();
 		}
 
 		virtual ~Mesh() = default;
@@ -28,6 +95,24 @@ namespace Okay
 			return m_meshData;
 		}
 
+		// Built at import, see MeshletBuilder.h
+		inline const MeshletData& getMeshletData() const
+		{
+			return m_meshletData;
+		}
+
+		// LOD 1 and up, the full mesh (LOD 0) is getMeshData(). Ordered from most to least detailed
+		inline const std::vector<MeshLOD>& getLODs() const
+		{
+			return m_lods;
+		}
+
+		// xyz = center, w = radius. Kept after clearData() since it's needed for culling
+		inline glm::vec4 getBoundingSphere() const
+		{
+			return m_boundingSphere;
+		}
+
 		inline void clearData()
 		{
 			m_meshData.verticies.clear();
@@ -35,10 +120,23 @@ namespace Okay
 
 			m_meshData.verticies.shrink_to_fit();
 			m_meshData.indicies.shrink_to_fit();
+
+			m_meshletData = MeshletData();
+			m_lods.clear();
+			m_lods.shrink_to_fit();
+		}
+
+	private:
+		inline void calculateBoundingSphere()
+		{
+			m_boundingSphere = computeBoundingSphere(m_meshData.verticies);
 		}
 
 	private:
 		MeshData m_meshData;
+		MeshletData m_meshletData;
+		std::vector<MeshLOD> m_lods;
+		glm::vec4 m_boundingSphere = glm::vec4(0.f);
 
 	};
 }
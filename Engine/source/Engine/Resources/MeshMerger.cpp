@@ -0,0 +1,117 @@
+#include "MeshMerger.h"
+
+#include <map>
+#include <tuple>
+
+namespace Okay
+{
+	// Ordered so the batches don't depend on hashing
+	struct MergeGroupKey
+	{
+		AssetID diffuseTextureID = 0;
+		AssetID normalMapID = 0;
+		glm::ivec3 cell = glm::ivec3(0);
+
+		inline bool operator<(const MergeGroupKey& other) const
+		{
+			return std::tie(diffuseTextureID, normalMapID, cell.x, cell.y, cell.z) <
+				std::tie(other.diffuseTextureID, other.normalMapID, other.cell.x, other.cell.y, other.cell.z);
+		}
+	};
+
+	void findMeshMergeBatches(const std::vector<MeshMergeObject>& objects, const std::vector<glm::vec4>& meshBoundingSpheres,
+		const std::vector<uint32_t>& meshVertexCounts, const MeshMergeSettings& settings, std::vector<MeshMergeBatch>& outBatches)
+	{
+		outBatches.clear();
+
+		std::vector<uint32_t> meshUseCounts(meshVertexCounts.size(), 0);
+		for (const MeshMergeObject& object : objects)
+		{
+			meshUseCounts[object.meshIdx]++;
+		}
+
+		std::map<MergeGroupKey, std::vector<uint32_t>> groups;
+		for (uint32_t i = 0; i < (uint32_t)objects.size(); i++)
+		{
+			const MeshMergeObject& object = objects[i];
+			if (meshUseCounts[object.meshIdx] != 1 || meshVertexCounts[object.meshIdx] > settings.maxVerticies)
+			{
+				continue;
+			}
+
+			glm::vec3 worldCenter = object.transformMatrix * glm::vec4(glm::vec3(meshBoundingSpheres[object.meshIdx]), 1.f);
+
+			MergeGroupKey key;
+			key.diffuseTextureID = object.diffuseTextureID;
+			key.normalMapID = object.normalMapID;
+			key.cell = glm::ivec3(glm::floor(worldCenter / settings.cellSize));
+
+			groups[key].emplace_back(i);
+		}
+
+		for (const auto& [key, objectIndicies] : groups)
+		{
+			// Filled in object order, a new batch starts when the next mesh doesn't fit
+			MeshMergeBatch batch;
+			for (uint32_t objectIdx : objectIndicies)
+			{
+				uint32_t numVerticies = meshVertexCounts[objects[objectIdx].meshIdx];
+
+				if (batch.numVerticies + numVerticies > settings.maxVerticies)
+				{
+					if (batch.objectIndicies.size() > 1)
+					{
+						outBatches.emplace_back(batch);
+					}
+
+					batch = MeshMergeBatch();
+				}
+
+				batch.objectIndicies.emplace_back(objectIdx);
+				batch.numVerticies += numVerticies;
+			}
+
+			if (batch.objectIndicies.size() > 1)
+			{
+				outBatches.emplace_back(batch);
+			}
+		}
+	}
+
+	void appendTransformedMesh(const MeshData& meshData, const glm::mat4& transformMatrix, MeshData& outMergedData)
+	{
+		glm::mat3 directionMatrix = glm::mat3(transformMatrix);
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(directionMatrix));
+
+		auto transformDirection = [](const glm::mat3& matrix, glm::vec3 direction)
+		{
+			glm::vec3 transformed = matrix * direction;
+			float length = glm::length(transformed);
+
+			return length > 0.f ? transformed / length : direction;
+		};
+
+		uint32_t firstVertex = (uint32_t)outMergedData.verticies.size();
+
+		outMergedData.verticies.reserve(outMergedData.verticies.size() + meshData.verticies.size());
+		for (const Vertex& vertex : meshData.verticies)
+		{
+			Vertex& merged = outMergedData.verticies.emplace_back(vertex);
+			merged.position = transformMatrix * glm::vec4(vertex.position, 1.f);
+			merged.normal = transformDirection(normalMatrix, vertex.normal);
+			merged.tangent = transformDirection(directionMatrix, vertex.tangent);
+			merged.biTangent = transformDirection(directionMatrix, vertex.biTangent);
+		}
+
+		// Mirroring turns the triangles inside out
+		bool flipWinding = glm::determinant(directionMatrix) < 0.f;
+
+		outMergedData.indicies.reserve(outMergedData.indicies.size() + meshData.indicies.size());
+		for (uint32_t i = 0; i + 2 < (uint32_t)meshData.indicies.size(); i += 3)
+		{
+			outMergedData.indicies.emplace_back(firstVertex + meshData.indicies[i]);
+			outMergedData.indicies.emplace_back(firstVertex + meshData.indicies[flipWinding ? i + 2 : i + 1]);
+			outMergedData.indicies.emplace_back(firstVertex + meshData.indicies[flipWinding ? i + 1 : i + 2]);
+		}
+	}
+}
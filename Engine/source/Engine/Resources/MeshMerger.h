@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*
+	Import time merging of static meshes into bigger batches, so scenes made of many small single use meshes (Sponza)
+	don't end up with one draw call per mesh.
+
+	Only meshes used by a single object are merged, instanced meshes are already drawn with one call per mesh.
+	Objects are grouped by their texture pair and by a world space grid cell, the cells keep every batch spatially compact
+	so its bounding sphere (and its meshlets) still cull well. Merged verticies are in world space, the batch gets an identity transform.
+*/
+
+namespace Okay
+{
+	struct MeshMergeSettings
+	{
+		float cellSize = 1000.f; // World units
+		uint32_t maxVerticies = 65536; // Per batch, the default keeps 16 bit indicies (VertexQuantization.h)
+	};
+
+	struct MeshMergeObject
+	{
+		uint32_t meshIdx = INVALID_UINT32;
+		AssetID diffuseTextureID = 0;
+		AssetID normalMapID = 0;
+
+		glm::mat4 transformMatrix = glm::mat4(1.f);
+	};
+
+	struct MeshMergeBatch
+	{
+		std::vector<uint32_t> objectIndicies; // Into the objects given to findMeshMergeBatches, 2 or more
+		uint32_t numVerticies = 0;
+	};
+
+	// Draw calls are counted as the renderer does, one per used mesh
+	struct MeshMergeReport
+	{
+		uint32_t numObjects = 0;
+		uint32_t numMergedObjects = 0;
+		uint32_t numBatches = 0;
+
+		uint32_t numDrawsBefore = 0;
+		uint32_t numDrawsAfter = 0;
+
+		inline void add(const MeshMergeReport& other)
+		{
+			numObjects += other.numObjects;
+			numMergedObjects += other.numMergedObjects;
+			numBatches += other.numBatches;
+			numDrawsBefore += other.numDrawsBefore;
+			numDrawsAfter += other.numDrawsAfter;
+		}
+	};
+
+	// Bounding spheres (see computeBoundingSphere) & vertex counts are indexed by meshIdx. Batches come out in a fixed order
+	void findMeshMergeBatches(const std::vector<MeshMergeObject>& objects, const std::vector<glm::vec4>& meshBoundingSpheres,
+		const std::vector<uint32_t>& meshVertexCounts, const MeshMergeSettings& settings, std::vector<MeshMergeBatch>& outBatches);
+
+	// Appends the mesh transformed by transformMatrix, flips the winding for mirroring transforms
+	void appendTransformedMesh(const MeshData& meshData, const glm::mat4& transformMatrix, MeshData& outMergedData);
+}
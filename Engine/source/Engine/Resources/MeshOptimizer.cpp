@@ -0,0 +1,304 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+namespace Okay
+{
+	struct Cluster
+	{
+		uint32_t firstIndex = 0;
+		uint32_t numIndicies = 0;
+		float sortKey = 0.f;
+	};
+
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indicies, uint32_t numVerticies, uint32_t cacheSize)
+	{
+		VertexCacheStats stats;
+		stats.numTriangles = (uint32_t)indicies.size() / 3;
+
+		// A vertex is in the cache if it was added less than cacheSize misses ago
+		std::vector<uint32_t> cacheTimestamps(numVerticies, 0);
+		std::vector<uint8_t> usedVerticies(numVerticies, false);
+		uint32_t timestamp = cacheSize + 1;
+
+		for (uint32_t index : indicies)
+		{
+			if (!usedVerticies[index])
+			{
+				usedVerticies[index] = true;
+				stats.numVerticies++;
+			}
+
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				stats.numTransformed++;
+			}
+		}
+
+		return stats;
+	}
+
+	void optimizeVertexCache(std::vector<uint32_t>& indicies, uint32_t numVerticies, uint32_t cacheSize, std::vector<uint32_t>* pOutClusterOffsets)
+	{
+		uint32_t numTriangles = (uint32_t)indicies.size() / 3;
+
+		if (pOutClusterOffsets)
+		{
+			pOutClusterOffsets->clear();
+		}
+
+		if (!numTriangles)
+		{
+			return;
+		}
+
+		// Vertex -> triangle adjacency, packed
+		std::vector<uint32_t> liveTriangles(numVerticies, 0);
+		for (uint32_t index : indicies)
+		{
+			liveTriangles[index]++;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(numVerticies + 1ull, 0);
+		for (uint32_t i = 0; i < numVerticies; i++)
+		{
+			adjacencyOffsets[i + 1ull] = adjacencyOffsets[i] + liveTriangles[i];
+		}
+
+		std::vector<uint32_t> adjacency(indicies.size());
+		std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < (uint32_t)indicies.size(); i++)
+		{
+			adjacency[adjacencyFill[indicies[i]]++] = i / 3;
+		}
+
+		std::vector<uint32_t> cacheTimestamps(numVerticies, 0);
+		std::vector<uint8_t> emittedTriangles(numTriangles, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+
+		std::vector<uint32_t> outIndicies;
+		outIndicies.reserve(indicies.size());
+
+		uint32_t timestamp = cacheSize + 1;
+		uint32_t nextSequentialVertex = 0;
+		uint32_t fanningVertex = indicies[0];
+
+		// Picks the next vertex when none of the candidates are still in the cache
+		auto skipDeadEnd = [&]()
+		{
+			while (!deadEndStack.empty())
+			{
+				uint32_t vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+
+				if (liveTriangles[vertex])
+				{
+					return vertex;
+				}
+			}
+
+			while (nextSequentialVertex < numVerticies)
+			{
+				if (liveTriangles[nextSequentialVertex])
+				{
+					return nextSequentialVertex;
+				}
+
+				nextSequentialVertex++;
+			}
+
+			return INVALID_UINT32;
+		};
+
+		if (pOutClusterOffsets)
+		{
+			pOutClusterOffsets->emplace_back(0);
+		}
+
+		while (fanningVertex != INVALID_UINT32)
+		{
+			candidates.clear();
+
+			for (uint32_t i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1ull]; i++)
+			{
+				uint32_t triangleIdx = adjacency[i];
+				if (emittedTriangles[triangleIdx])
+				{
+					continue;
+				}
+
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					uint32_t vertex = indicies[triangleIdx * 3ull + j];
+
+					outIndicies.emplace_back(vertex);
+					deadEndStack.emplace_back(vertex);
+					candidates.emplace_back(vertex);
+
+					liveTriangles[vertex]--;
+
+					if (timestamp - cacheTimestamps[vertex] > cacheSize)
+					{
+						cacheTimestamps[vertex] = timestamp++;
+					}
+				}
+
+				emittedTriangles[triangleIdx] = true;
+			}
+
+			// The candidate that stays in the cache longest while its remaining triangles are emitted,
+			// one that would fall out first still gets priority 0, which beats going to the dead end stack
+			uint32_t bestVertex = INVALID_UINT32;
+			int32_t bestPriority = -1;
+
+			for (uint32_t vertex : candidates)
+			{
+				if (!liveTriangles[vertex])
+				{
+					continue;
+				}
+
+				int32_t priority = 0;
+				uint32_t age = timestamp - cacheTimestamps[vertex];
+				if (age + 2 * liveTriangles[vertex] <= cacheSize)
+				{
+					priority = (int32_t)age;
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					bestVertex = vertex;
+				}
+			}
+
+			fanningVertex = bestVertex;
+			if (fanningVertex == INVALID_UINT32)
+			{
+				fanningVertex = skipDeadEnd();
+			}
+
+			// Cache is effectively flushed, a new cluster starts here
+			if (bestPriority <= 0 && pOutClusterOffsets && fanningVertex != INVALID_UINT32 && outIndicies.size() != pOutClusterOffsets->back())
+			{
+				pOutClusterOffsets->emplace_back((uint32_t)outIndicies.size());
+			}
+		}
+
+		OKAY_ASSERT(outIndicies.size() == indicies.size());
+		indicies.swap(outIndicies);
+	}
+
+	void optimizeOverdraw(std::vector<uint32_t>& indicies, const std::vector<Vertex>& verticies, const std::vector<uint32_t>& clusterOffsets)
+	{
+		if (clusterOffsets.size() < 2)
+		{
+			return;
+		}
+
+		std::vector<Cluster> clusters(clusterOffsets.size());
+
+		glm::vec3 meshCentroid = glm::vec3(0.f);
+		float meshArea = 0.f;
+
+		std::vector<glm::vec3> clusterCentroids(clusters.size(), glm::vec3(0.f));
+		std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.f));
+
+		for (uint32_t i = 0; i < (uint32_t)clusters.size(); i++)
+		{
+			Cluster& cluster = clusters[i];
+			cluster.firstIndex = clusterOffsets[i];
+			cluster.numIndicies = (i + 1 < (uint32_t)clusters.size() ? clusterOffsets[i + 1ull] : (uint32_t)indicies.size()) - cluster.firstIndex;
+
+			float clusterArea = 0.f;
+			for (uint32_t j = cluster.firstIndex; j < cluster.firstIndex + cluster.numIndicies; j += 3)
+			{
+				glm::vec3 p0 = verticies[indicies[j]].position;
+				glm::vec3 p1 = verticies[indicies[j + 1ull]].position;
+				glm::vec3 p2 = verticies[indicies[j + 2ull]].position;
+
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // Length = 2 * area
+				float area = glm::length(normal) * 0.5f;
+				glm::vec3 centroid = (p0 + p1 + p2) / 3.f;
+
+				clusterNormals[i] += normal;
+				clusterCentroids[i] += centroid * area;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroids[i];
+			meshArea += clusterArea;
+
+			clusterCentroids[i] = clusterArea > 0.f ? clusterCentroids[i] / clusterArea : verticies[indicies[cluster.firstIndex]].position;
+		}
+
+		meshCentroid = meshArea > 0.f ? meshCentroid / meshArea : glm::vec3(0.f);
+
+		// How far the cluster points out of the mesh, these are the most likely to be in front of the rest from any view
+		for (uint32_t i = 0; i < (uint32_t)clusters.size(); i++)
+		{
+			float normalLength = glm::length(clusterNormals[i]);
+			glm::vec3 normal = normalLength > 0.f ? clusterNormals[i] / normalLength : glm::vec3(0.f);
+
+			clusters[i].sortKey = glm::dot(clusterCentroids[i] - meshCentroid, normal);
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+		{
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<uint32_t> outIndicies;
+		outIndicies.reserve(indicies.size());
+
+		for (const Cluster& cluster : clusters)
+		{
+			outIndicies.insert(outIndicies.end(), indicies.begin() + cluster.firstIndex, indicies.begin() + cluster.firstIndex + cluster.numIndicies);
+		}
+
+		indicies.swap(outIndicies);
+	}
+
+	void optimizeVertexFetch(MeshData& meshData)
+	{
+		std::vector<uint32_t> remap(meshData.verticies.size(), INVALID_UINT32);
+
+		std::vector<Vertex> outVerticies;
+		outVerticies.reserve(meshData.verticies.size());
+
+		for (uint32_t& index : meshData.indicies)
+		{
+			if (remap[index] == INVALID_UINT32)
+			{
+				remap[index] = (uint32_t)outVerticies.size();
+				outVerticies.emplace_back(meshData.verticies[index]);
+			}
+
+			index = remap[index];
+		}
+
+		meshData.verticies.swap(outVerticies);
+	}
+
+	void optimizeMesh(MeshData& meshData, MeshOptimizationStats* pOutStats)
+	{
+		uint32_t numVerticies = (uint32_t)meshData.verticies.size();
+
+		if (pOutStats)
+		{
+			pOutStats->before = analyzeVertexCache(meshData.indicies, numVerticies);
+		}
+
+		std::vector<uint32_t> clusterOffsets;
+		optimizeVertexCache(meshData.indicies, numVerticies, VERTEX_CACHE_SIZE, &clusterOffsets);
+		optimizeOverdraw(meshData.indicies, meshData.verticies, clusterOffsets);
+		optimizeVertexFetch(meshData);
+
+		if (pOutStats)
+		{
+			pOutStats->after = analyzeVertexCache(meshData.indicies, (uint32_t)meshData.verticies.size());
+		}
+	}
+}
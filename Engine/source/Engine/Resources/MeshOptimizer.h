@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*
+	Import time mesh optimization, run on every mesh before it's added to the ResourceManager:
+	1. Vertex cache: triangles are reordered with Tipsify (Sander et al. 2007) so recently transformed verticies get reused.
+	2. Overdraw: the clusters Tipsify produces between cache flushes are sorted so outward facing parts of the mesh come first.
+	3. Vertex fetch: verticies are reordered in the order the index buffer first uses them, unused verticies are dropped.
+
+	The triangles (and their winding) are unchanged, only their order and the vertex order are.
+*/
+
+namespace Okay
+{
+	// ACMR = transformed verticies per triangle, ATVR = transformed verticies per unique vertex (1 is perfect)
+	struct VertexCacheStats
+	{
+		uint32_t numTriangles = 0;
+		uint32_t numVerticies = 0;
+		uint32_t numTransformed = 0;
+
+		inline float getACMR() const { return numTriangles ? numTransformed / (float)numTriangles : 0.f; }
+		inline float getATVR() const { return numVerticies ? numTransformed / (float)numVerticies : 0.f; }
+
+		inline void add(const VertexCacheStats& other)
+		{
+			numTriangles += other.numTriangles;
+			numVerticies += other.numVerticies;
+			numTransformed += other.numTransformed;
+		}
+	};
+
+	struct MeshOptimizationStats
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	static const uint32_t VERTEX_CACHE_SIZE = 16;
+
+	// Simulates a FIFO post transform cache
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indicies, uint32_t numVerticies, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+	// Reorders the triangles, pOutClusterOffsets receives the first index of every cluster (cache flush points)
+	void optimizeVertexCache(std::vector<uint32_t>& indicies, uint32_t numVerticies, uint32_t cacheSize = VERTEX_CACHE_SIZE, std::vector<uint32_t>* pOutClusterOffsets = nullptr);
+
+	// Reorders the clusters from optimizeVertexCache so the outward facing ones, which likely hide the rest, are drawn first
+	void optimizeOverdraw(std::vector<uint32_t>& indicies, const std::vector<Vertex>& verticies, const std::vector<uint32_t>& clusterOffsets);
+
+	void optimizeVertexFetch(MeshData& meshData);
+
+	// All of the above
+	void optimizeMesh(MeshData& meshData, MeshOptimizationStats* pOutStats = nullptr);
+}
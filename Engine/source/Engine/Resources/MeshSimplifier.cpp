@@ -0,0 +1,1025 @@
+#include "MeshSimplifier.h"
+#include "MeshStreams.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <unordered_map>
+
+namespace Okay
+{
+	// Border & seam edges get a plane perpendicular to the triangle so they resist moving sideways
+	static const double BOUNDARY_WEIGHT = 10.0;
+
+	// A level has to drop at least this many of the triangles of the level before it to be kept
+	static const float MIN_LOD_REDUCTION = 0.15f;
+
+	enum SimplifyVertexKind : uint8_t
+	{
+		OKAY_SIMPLIFY_VERTEX_MANIFOLD = 0, // Interior, one set of attributes, can collapse along any edge
+		OKAY_SIMPLIFY_VERTEX_BORDER = 1, // On an open border, only along the border
+		OKAY_SIMPLIFY_VERTEX_SEAM = 2, // On an attribute seam, only along the seam
+		OKAY_SIMPLIFY_VERTEX_LOCKED = 3, // Corners & anything non-manifold, never moves
+	};
+
+	enum SimplifyEdgeKind : uint8_t
+	{
+		OKAY_SIMPLIFY_EDGE_INTERIOR = 0,
+		OKAY_SIMPLIFY_EDGE_BORDER = 1,
+		OKAY_SIMPLIFY_EDGE_SEAM = 2,
+	};
+
+	// Doubles since the constant term is the squared plane distance, which loses everything in floats for big meshes
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+		double a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		inline void addPlane(glm::dvec3 normal, double distance, double planeWeight)
+		{
+			a00 += normal.x * normal.x * planeWeight;
+			a11 += normal.y * normal.y * planeWeight;
+			a22 += normal.z * normal.z * planeWeight;
+			a01 += normal.x * normal.y * planeWeight;
+			a02 += normal.x * normal.z * planeWeight;
+			a12 += normal.y * normal.z * planeWeight;
+			b0 += normal.x * distance * planeWeight;
+			b1 += normal.y * distance * planeWeight;
+			b2 += normal.z * distance * planeWeight;
+			c += distance * distance * planeWeight;
+			weight += planeWeight;
+		}
+
+		inline void add(const Quadric& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// Weighted mean squared distance to the planes
+		inline double evaluate(glm::dvec3 p) const
+		{
+			if (weight <= 0.0)
+			{
+				return 0.0;
+			}
+
+			double error =
+				a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+				2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+				2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+
+			return glm::max(error, 0.0) / weight;
+		}
+	};
+
+	struct EdgeCollapse
+	{
+		uint32_t from = INVALID_UINT32; // Position indicies
+		uint32_t to = INVALID_UINT32;
+		double cost = 0.0;
+	};
+
+	static inline uint64_t makeEdgeKey(uint32_t a, uint32_t b)
+	{
+		return ((uint64_t)a << 32) | b;
+	}
+
+	// Closest point on a triangle, Real-Time Collision Detection 5.1.5
+	static double getPointTriangleDistanceSqrd(glm::dvec3 p, glm::dvec3 a, glm::dvec3 b, glm::dvec3 c)
+	{
+		auto distanceSqrd = [&](glm::dvec3 closest)
+		{
+			glm::dvec3 toClosest = closest - p;
+			return glm::dot(toClosest, toClosest);
+		};
+
+		glm::dvec3 ab = b - a;
+		glm::dvec3 ac = c - a;
+		glm::dvec3 ap = p - a;
+
+		double d1 = glm::dot(ab, ap);
+		double d2 = glm::dot(ac, ap);
+		if (d1 <= 0.0 && d2 <= 0.0)
+		{
+			return distanceSqrd(a);
+		}
+
+		glm::dvec3 bp = p - b;
+		double d3 = glm::dot(ab, bp);
+		double d4 = glm::dot(ac, bp);
+		if (d3 >= 0.0 && d4 <= d3)
+		{
+			return distanceSqrd(b);
+		}
+
+		double vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+		{
+			return distanceSqrd(a + ab * (d1 / (d1 - d3)));
+		}
+
+		glm::dvec3 cp = p - c;
+		double d5 = glm::dot(ab, cp);
+		double d6 = glm::dot(ac, cp);
+		if (d6 >= 0.0 && d5 <= d6)
+		{
+			return distanceSqrd(c);
+		}
+
+		double vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+		{
+			return distanceSqrd(a + ac * (d2 / (d2 - d6)));
+		}
+
+		double va = d3 * d6 - d5 * d4;
+		if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+		{
+			return distanceSqrd(b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+		}
+
+		double denominator = 1.0 / (va + vb + vc);
+		return distanceSqrd(a + ab * (vb * denominator) + ac * (vc * denominator));
+	}
+
+	class MeshSimplifier
+	{
+	public:
+		MeshSimplifier(const MeshData& meshData);
+
+		// Collapses until there are at most targetNumTriangles left or the next collapse would go over maxError
+		void simplify(uint32_t targetNumTriangles, float maxError);
+
+		void writeIndicies(std::vector<uint32_t>& outIndicies) const;
+
+		// Largest distance from a removed vertex to the simplified mesh
+		float measureError() const;
+
+		inline uint32_t getNumTriangles() const { return m_numLiveTriangles; }
+
+	private:
+		void classifyVerticies();
+		void computeQuadrics();
+
+		bool canCollapse(uint32_t from, uint32_t to) const;
+		bool performCollapse(const EdgeCollapse& collapse);
+
+		inline glm::dvec3 getPosition(uint32_t positionIdx) const { return m_positions[positionIdx]; }
+		inline bool triangleHasVertex(uint32_t triangleIdx, uint32_t vertexIdx) const;
+
+		// Live triangles using any vertex at the position
+		void gatherTriangles(uint32_t positionIdx, std::vector<uint32_t>& outTriangles) const;
+
+	private:
+		std::vector<uint32_t> m_indicies;
+		std::vector<uint8_t> m_liveTriangles;
+		uint32_t m_numLiveTriangles = 0;
+
+		std::vector<uint32_t> m_vertexToPosition;
+		std::vector<uint32_t> m_firstWedge; // Per position
+		std::vector<uint32_t> m_nextWedge; // Circular list of the verticies at the same position
+		std::vector<glm::dvec3> m_positions;
+
+		std::vector<std::vector<uint32_t>> m_vertexTriangles; // Can contain triangles the vertex has left, checked on use
+
+		std::vector<uint8_t> m_vertexKinds; // Per position
+		std::unordered_map<uint64_t, SimplifyEdgeKind> m_boundaryEdges; // Undirected position edges, smallest index first
+		std::vector<Quadric> m_quadrics; // Per position
+
+		std::vector<uint8_t> m_collapseLocked; // Per position, reset every pass
+		std::vector<uint32_t> m_collapsedInto; // Per position, itself until it's collapsed away
+
+		// Scratch
+		std::vector<uint32_t> m_trianglesA;
+		std::vector<uint32_t> m_trianglesB;
+		std::vector<uint32_t> m_neighboursA;
+		std::vector<uint32_t> m_neighboursB;
+	};
+
+	MeshSimplifier::MeshSimplifier(const MeshData& meshData)
+		:m_indicies(meshData.indicies)
+	{
+		uint32_t numVerticies = (uint32_t)meshData.verticies.size();
+		uint32_t numTriangles = (uint32_t)m_indicies.size() / 3;
+
+		uint32_t numPositions = createPositionRemap(meshData.verticies, m_vertexToPosition);
+
+		m_positions.resize(numPositions);
+		for (uint32_t i = 0; i < numVerticies; i++)
+		{
+			m_positions[m_vertexToPosition[i]] = meshData.verticies[i].position;
+		}
+
+		m_firstWedge.resize(numPositions, INVALID_UINT32);
+		m_nextWedge.resize(numVerticies);
+		for (uint32_t i = 0; i < numVerticies; i++)
+		{
+			uint32_t& first = m_firstWedge[m_vertexToPosition[i]];
+			if (first == INVALID_UINT32)
+			{
+				first = i;
+				m_nextWedge[i] = i;
+				continue;
+			}
+
+			m_nextWedge[i] = m_nextWedge[first];
+			m_nextWedge[first] = i;
+		}
+
+		// Triangles that are already degenerate in position would confuse the topology checks
+		m_liveTriangles.resize(numTriangles, false);
+		m_vertexTriangles.resize(numVerticies);
+		for (uint32_t i = 0; i < numTriangles; i++)
+		{
+			uint32_t p0 = m_vertexToPosition[m_indicies[i * 3ull]];
+			uint32_t p1 = m_vertexToPosition[m_indicies[i * 3ull + 1]];
+			uint32_t p2 = m_vertexToPosition[m_indicies[i * 3ull + 2]];
+
+			if (p0 == p1 || p1 == p2 || p2 == p0)
+			{
+				continue;
+			}
+
+			m_liveTriangles[i] = true;
+			m_numLiveTriangles++;
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				m_vertexTriangles[m_indicies[i * 3ull + j]].emplace_back(i);
+			}
+		}
+
+		m_collapseLocked.resize(numPositions, false);
+
+		m_collapsedInto.resize(numPositions);
+		for (uint32_t i = 0; i < numPositions; i++)
+		{
+			m_collapsedInto[i] = i;
+		}
+
+		classifyVerticies();
+		computeQuadrics();
+	}
+
+	void MeshSimplifier::classifyVerticies()
+	{
+		uint32_t numPositions = (uint32_t)m_positions.size();
+		uint32_t numTriangles = (uint32_t)m_liveTriangles.size();
+
+		struct HalfEdge
+		{
+			uint32_t fromVertex = INVALID_UINT32;
+			uint32_t toVertex = INVALID_UINT32;
+			uint32_t count = 0;
+		};
+
+		// Directed position edge -> the verticies of the first triangle using it
+		std::unordered_map<uint64_t, HalfEdge> halfEdges;
+		halfEdges.reserve(m_numLiveTriangles * 3ull);
+
+		for (uint32_t i = 0; i < numTriangles; i++)
+		{
+			if (!m_liveTriangles[i])
+			{
+				continue;
+			}
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t vertexA = m_indicies[i * 3ull + j];
+				uint32_t vertexB = m_indicies[i * 3ull + (j + 1) % 3];
+
+				HalfEdge& halfEdge = halfEdges[makeEdgeKey(m_vertexToPosition[vertexA], m_vertexToPosition[vertexB])];
+				if (!halfEdge.count++)
+				{
+					halfEdge.fromVertex = vertexA;
+					halfEdge.toVertex = vertexB;
+				}
+			}
+		}
+
+		struct EdgeCounts
+		{
+			uint32_t borderOut = 0, borderIn = 0;
+			uint32_t seamOut = 0, seamIn = 0;
+			bool nonManifold = false;
+		};
+
+		std::vector<EdgeCounts> edgeCounts(numPositions);
+
+		// Iterating the triangles rather than the map keeps this independent of the hash map order
+		for (uint32_t i = 0; i < numTriangles; i++)
+		{
+			if (!m_liveTriangles[i])
+			{
+				continue;
+			}
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t positionA = m_vertexToPosition[m_indicies[i * 3ull + j]];
+				uint32_t positionB = m_vertexToPosition[m_indicies[i * 3ull + (j + 1) % 3]];
+
+				const HalfEdge& halfEdge = halfEdges[makeEdgeKey(positionA, positionB)];
+
+				auto reverseIt = halfEdges.find(makeEdgeKey(positionB, positionA));
+				if (halfEdge.count > 1 || (reverseIt != halfEdges.end() && reverseIt->second.count > 1))
+				{
+					edgeCounts[positionA].nonManifold = true;
+					edgeCounts[positionB].nonManifold = true;
+					continue;
+				}
+
+				SimplifyEdgeKind edgeKind = OKAY_SIMPLIFY_EDGE_INTERIOR;
+				if (reverseIt == halfEdges.end())
+				{
+					edgeKind = OKAY_SIMPLIFY_EDGE_BORDER;
+					edgeCounts[positionA].borderOut++;
+					edgeCounts[positionB].borderIn++;
+				}
+				else if (reverseIt->second.fromVertex != halfEdge.toVertex || reverseIt->second.toVertex != halfEdge.fromVertex)
+				{
+					edgeKind = OKAY_SIMPLIFY_EDGE_SEAM;
+					edgeCounts[positionA].seamOut++;
+					edgeCounts[positionB].seamIn++;
+				}
+
+				if (edgeKind != OKAY_SIMPLIFY_EDGE_INTERIOR)
+				{
+					m_boundaryEdges[makeEdgeKey(glm::min(positionA, positionB), glm::max(positionA, positionB))] = edgeKind;
+				}
+			}
+		}
+
+		m_vertexKinds.resize(numPositions);
+		for (uint32_t i = 0; i < numPositions; i++)
+		{
+			const EdgeCounts& counts = edgeCounts[i];
+
+			uint32_t numWedges = 0;
+			uint32_t wedge = m_firstWedge[i];
+			do
+			{
+				numWedges += !m_vertexTriangles[wedge].empty();
+				wedge = m_nextWedge[wedge];
+			} while (wedge != m_firstWedge[i]);
+
+			bool hasBorder = counts.borderOut || counts.borderIn;
+			bool hasSeam = counts.seamOut || counts.seamIn;
+
+			SimplifyVertexKind kind = OKAY_SIMPLIFY_VERTEX_LOCKED;
+			if (counts.nonManifold)
+			{
+				kind = OKAY_SIMPLIFY_VERTEX_LOCKED;
+			}
+			else if (!hasBorder && !hasSeam && numWedges == 1)
+			{
+				kind = OKAY_SIMPLIFY_VERTEX_MANIFOLD;
+			}
+			else if (!hasSeam && numWedges == 1 && counts.borderOut == 1 && counts.borderIn == 1)
+			{
+				kind = OKAY_SIMPLIFY_VERTEX_BORDER;
+			}
+			else if (!hasBorder && numWedges == 2 && counts.seamOut == 2 && counts.seamIn == 2)
+			{
+				// A seam passing straight through, one side per wedge
+				kind = OKAY_SIMPLIFY_VERTEX_SEAM;
+			}
+
+			m_vertexKinds[i] = kind;
+		}
+	}
+
+	void MeshSimplifier::computeQuadrics()
+	{
+		m_quadrics.resize(m_positions.size());
+
+		uint32_t numTriangles = (uint32_t)m_liveTriangles.size();
+		for (uint32_t i = 0; i < numTriangles; i++)
+		{
+			if (!m_liveTriangles[i])
+			{
+				continue;
+			}
+
+			uint32_t positionIdx[3] = {};
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				positionIdx[j] = m_vertexToPosition[m_indicies[i * 3ull + j]];
+			}
+
+			glm::dvec3 p0 = getPosition(positionIdx[0]);
+			glm::dvec3 p1 = getPosition(positionIdx[1]);
+			glm::dvec3 p2 = getPosition(positionIdx[2]);
+
+			glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+			double doubleArea = glm::length(normal);
+			if (doubleArea <= 0.0)
+			{
+				continue;
+			}
+
+			normal /= doubleArea;
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				m_quadrics[positionIdx[j]].addPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5);
+			}
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t positionA = positionIdx[j];
+				uint32_t positionB = positionIdx[(j + 1) % 3];
+
+				if (!m_boundaryEdges.contains(makeEdgeKey(glm::min(positionA, positionB), glm::max(positionA, positionB))))
+				{
+					continue;
+				}
+
+				glm::dvec3 edge = getPosition(positionB) - getPosition(positionA);
+				double edgeLengthSqrd = glm::dot(edge, edge);
+
+				glm::dvec3 edgeNormal = glm::cross(edge, normal);
+				double edgeNormalLength = glm::length(edgeNormal);
+				if (edgeNormalLength <= 0.0)
+				{
+					continue;
+				}
+
+				edgeNormal /= edgeNormalLength;
+
+				double distance = -glm::dot(edgeNormal, getPosition(positionA));
+				m_quadrics[positionA].addPlane(edgeNormal, distance, edgeLengthSqrd * BOUNDARY_WEIGHT);
+				m_quadrics[positionB].addPlane(edgeNormal, distance, edgeLengthSqrd * BOUNDARY_WEIGHT);
+			}
+		}
+	}
+
+	void MeshSimplifier::simplify(uint32_t targetNumTriangles, float maxError)
+	{
+		double maxCost = (double)maxError * (double)maxError;
+
+		std::vector<uint64_t> edges;
+		std::vector<EdgeCollapse> collapses;
+
+		while (m_numLiveTriangles > targetNumTriangles)
+		{
+			edges.clear();
+			for (uint32_t i = 0; i < (uint32_t)m_liveTriangles.size(); i++)
+			{
+				if (!m_liveTriangles[i])
+				{
+					continue;
+				}
+
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					uint32_t positionA = m_vertexToPosition[m_indicies[i * 3ull + j]];
+					uint32_t positionB = m_vertexToPosition[m_indicies[i * 3ull + (j + 1) % 3]];
+					edges.emplace_back(makeEdgeKey(glm::min(positionA, positionB), glm::max(positionA, positionB)));
+				}
+			}
+
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			// Cheapest allowed direction of every edge
+			collapses.clear();
+			for (uint64_t edge : edges)
+			{
+				uint32_t positionA = (uint32_t)(edge >> 32);
+				uint32_t positionB = (uint32_t)edge;
+
+				EdgeCollapse collapse;
+				collapse.cost = DBL_MAX;
+
+				if (canCollapse(positionA, positionB))
+				{
+					collapse.from = positionA;
+					collapse.to = positionB;
+					collapse.cost = m_quadrics[positionA].evaluate(getPosition(positionB));
+				}
+
+				if (canCollapse(positionB, positionA))
+				{
+					double cost = m_quadrics[positionB].evaluate(getPosition(positionA));
+					if (cost < collapse.cost)
+					{
+						collapse.from = positionB;
+						collapse.to = positionA;
+						collapse.cost = cost;
+					}
+				}
+
+				if (collapse.from != INVALID_UINT32 && collapse.cost <= maxCost)
+				{
+					collapses.emplace_back(collapse);
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b)
+			{
+				if (a.cost != b.cost)
+				{
+					return a.cost < b.cost;
+				}
+
+				return a.from != b.from ? a.from < b.from : a.to < b.to;
+			});
+
+			// Both ends of a collapse are left alone for the rest of the pass, so the costs of the remaining collapses stay valid
+			std::fill(m_collapseLocked.begin(), m_collapseLocked.end(), false);
+
+			uint32_t numCollapsed = 0;
+			for (const EdgeCollapse& collapse : collapses)
+			{
+				if (m_numLiveTriangles <= targetNumTriangles)
+				{
+					break;
+				}
+
+				if (m_collapseLocked[collapse.from] || m_collapseLocked[collapse.to])
+				{
+					continue;
+				}
+
+				numCollapsed += performCollapse(collapse);
+			}
+
+			if (!numCollapsed)
+			{
+				break;
+			}
+		}
+	}
+
+	void MeshSimplifier::writeIndicies(std::vector<uint32_t>& outIndicies) const
+	{
+		outIndicies.clear();
+		outIndicies.reserve(m_numLiveTriangles * 3ull);
+
+		for (uint32_t i = 0; i < (uint32_t)m_liveTriangles.size(); i++)
+		{
+			if (m_liveTriangles[i])
+			{
+				outIndicies.insert(outIndicies.end(), m_indicies.begin() + i * 3ull, m_indicies.begin() + i * 3ull + 3);
+			}
+		}
+	}
+
+	bool MeshSimplifier::canCollapse(uint32_t from, uint32_t to) const
+	{
+		auto getEdgeKind = [&]()
+		{
+			auto it = m_boundaryEdges.find(makeEdgeKey(glm::min(from, to), glm::max(from, to)));
+			return it != m_boundaryEdges.end() ? it->second : OKAY_SIMPLIFY_EDGE_INTERIOR;
+		};
+
+		switch (m_vertexKinds[from])
+		{
+		case OKAY_SIMPLIFY_VERTEX_MANIFOLD:
+			return true;
+
+		case OKAY_SIMPLIFY_VERTEX_BORDER:
+			return getEdgeKind() == OKAY_SIMPLIFY_EDGE_BORDER;
+
+		case OKAY_SIMPLIFY_VERTEX_SEAM:
+			return getEdgeKind() == OKAY_SIMPLIFY_EDGE_SEAM;
+
+		default:
+			return false;
+		}
+	}
+
+	float MeshSimplifier::measureError() const
+	{
+		// Uniform grid over the live triangles with cells about the size of a triangle. Sized by the triangles rather than
+		// the bounds since most meshes are surfaces, a grid with a fixed number of cells per axis would be mostly empty
+		glm::dvec3 boundsMin = glm::dvec3(DBL_MAX);
+		glm::dvec3 boundsMax = glm::dvec3(-DBL_MAX);
+		for (glm::dvec3 position : m_positions)
+		{
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+
+		double triangleSizeSum = 0.0;
+		for (uint32_t i = 0; i < (uint32_t)m_liveTriangles.size(); i++)
+		{
+			if (!m_liveTriangles[i])
+			{
+				continue;
+			}
+
+			glm::dvec3 p0 = getPosition(m_vertexToPosition[m_indicies[i * 3ull]]);
+			glm::dvec3 p1 = getPosition(m_vertexToPosition[m_indicies[i * 3ull + 1]]);
+			glm::dvec3 p2 = getPosition(m_vertexToPosition[m_indicies[i * 3ull + 2]]);
+
+			glm::dvec3 triangleExtent = glm::max(glm::max(p0, p1), p2) - glm::min(glm::min(p0, p1), p2);
+			triangleSizeSum += glm::max(glm::max(triangleExtent.x, triangleExtent.y), triangleExtent.z);
+		}
+
+		glm::dvec3 extent = glm::max(boundsMax - boundsMin, glm::dvec3(1e-9));
+		double maxExtent = glm::max(glm::max(extent.x, extent.y), extent.z);
+
+		// At most a few cells per triangle
+		double minCellSize = glm::pow(extent.x * extent.y * extent.z / (4.0 * glm::max(m_numLiveTriangles, 1u)), 1.0 / 3.0);
+		double cellSize = glm::max(triangleSizeSum / glm::max(m_numLiveTriangles, 1u), minCellSize);
+		cellSize = glm::clamp(cellSize, maxExtent / 1024.0, maxExtent);
+
+		glm::ivec3 gridSize = glm::max(glm::ivec3(glm::ceil(extent / cellSize)), glm::ivec3(1));
+
+		auto getCell = [&](glm::dvec3 position)
+		{
+			return glm::clamp(glm::ivec3((position - boundsMin) / cellSize), glm::ivec3(0), gridSize - 1);
+		};
+
+		auto getCellIdx = [&](glm::ivec3 cell)
+		{
+			return ((uint64_t)cell.z * gridSize.y + cell.y) * gridSize.x + cell.x;
+		};
+
+		std::vector<uint32_t> cellOffsets((uint64_t)gridSize.x * gridSize.y * gridSize.z + 1, 0);
+		std::vector<uint32_t> cellTriangles;
+
+		// Counted first, then filled, like the vertex triangle adjacency in MeshOptimizer
+		for (uint32_t pass = 0; pass < 2; pass++)
+		{
+			for (uint32_t i = 0; i < (uint32_t)m_liveTriangles.size(); i++)
+			{
+				if (!m_liveTriangles[i])
+				{
+					continue;
+				}
+
+				glm::dvec3 triangleMin = glm::dvec3(DBL_MAX);
+				glm::dvec3 triangleMax = glm::dvec3(-DBL_MAX);
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					glm::dvec3 position = getPosition(m_vertexToPosition[m_indicies[i * 3ull + corner]]);
+					triangleMin = glm::min(triangleMin, position);
+					triangleMax = glm::max(triangleMax, position);
+				}
+
+				glm::ivec3 cellMin = getCell(triangleMin);
+				glm::ivec3 cellMax = getCell(triangleMax);
+
+				for (int z = cellMin.z; z <= cellMax.z; z++)
+				{
+					for (int y = cellMin.y; y <= cellMax.y; y++)
+					{
+						for (int x = cellMin.x; x <= cellMax.x; x++)
+						{
+							uint64_t cellIdx = getCellIdx(glm::ivec3(x, y, z));
+							if (pass == 0)
+							{
+								cellOffsets[cellIdx + 1]++;
+							}
+							else
+							{
+								cellTriangles[cellOffsets[cellIdx]++] = i;
+							}
+						}
+					}
+				}
+			}
+
+			if (pass == 0)
+			{
+				for (uint64_t i = 1; i < cellOffsets.size(); i++)
+				{
+					cellOffsets[i] += cellOffsets[i - 1];
+				}
+
+				cellTriangles.resize(cellOffsets.back());
+			}
+			else
+			{
+				// Filling moved every offset to the start of the next cell
+				for (uint64_t i = cellOffsets.size() - 1; i > 0; i--)
+				{
+					cellOffsets[i] = cellOffsets[i - 1];
+				}
+
+				cellOffsets[0] = 0;
+			}
+		}
+
+		double maxDistanceSqrd = 0.0;
+
+		for (uint32_t i = 0; i < (uint32_t)m_positions.size(); i++)
+		{
+			// Verticies that are still used are on the mesh
+			if (m_collapsedInto[i] == i)
+			{
+				continue;
+			}
+
+			glm::dvec3 position = getPosition(i);
+			glm::ivec3 center = getCell(position);
+
+			double distanceSqrd = DBL_MAX;
+			int maxRing = glm::max(glm::max(gridSize.x, gridSize.y), gridSize.z);
+
+			// Rings of cells around the vertex until no unvisited cell can be closer than the best triangle
+			for (int ring = 0; ring <= maxRing; ring++)
+			{
+				glm::ivec3 ringMin = glm::max(center - ring, glm::ivec3(0));
+				glm::ivec3 ringMax = glm::min(center + ring, gridSize - 1);
+
+				for (int z = ringMin.z; z <= ringMax.z; z++)
+				{
+					for (int y = ringMin.y; y <= ringMax.y; y++)
+					{
+						for (int x = ringMin.x; x <= ringMax.x; x++)
+						{
+							glm::ivec3 offset = glm::abs(glm::ivec3(x, y, z) - center);
+							if (glm::max(glm::max(offset.x, offset.y), offset.z) != ring)
+							{
+								continue;
+							}
+
+							uint64_t cellIdx = getCellIdx(glm::ivec3(x, y, z));
+							for (uint32_t j = cellOffsets[cellIdx]; j < cellOffsets[cellIdx + 1]; j++)
+							{
+								const uint32_t* pTriangle = m_indicies.data() + cellTriangles[j] * 3ull;
+
+								distanceSqrd = glm::min(distanceSqrd, getPointTriangleDistanceSqrd(position,
+									getPosition(m_vertexToPosition[pTriangle[0]]),
+									getPosition(m_vertexToPosition[pTriangle[1]]),
+									getPosition(m_vertexToPosition[pTriangle[2]])));
+							}
+						}
+					}
+				}
+
+				double ringDistance = ring * cellSize;
+				if (distanceSqrd <= ringDistance * ringDistance)
+				{
+					break;
+				}
+			}
+
+			maxDistanceSqrd = glm::max(maxDistanceSqrd, distanceSqrd == DBL_MAX ? 0.0 : distanceSqrd);
+		}
+
+		return (float)glm::sqrt(maxDistanceSqrd);
+	}
+
+	bool MeshSimplifier::triangleHasVertex(uint32_t triangleIdx, uint32_t vertexIdx) const
+	{
+		const uint32_t* pTriangle = m_indicies.data() + triangleIdx * 3ull;
+		return pTriangle[0] == vertexIdx || pTriangle[1] == vertexIdx || pTriangle[2] == vertexIdx;
+	}
+
+	void MeshSimplifier::gatherTriangles(uint32_t positionIdx, std::vector<uint32_t>& outTriangles) const
+	{
+		outTriangles.clear();
+
+		uint32_t firstWedge = m_firstWedge[positionIdx];
+		uint32_t wedge = firstWedge;
+		do
+		{
+			for (uint32_t triangleIdx : m_vertexTriangles[wedge])
+			{
+				if (m_liveTriangles[triangleIdx] && triangleHasVertex(triangleIdx, wedge))
+				{
+					outTriangles.emplace_back(triangleIdx);
+				}
+			}
+
+			wedge = m_nextWedge[wedge];
+		} while (wedge != firstWedge);
+
+		// A triangle can be in the list of a vertex more than once after collapses
+		std::sort(outTriangles.begin(), outTriangles.end());
+		outTriangles.erase(std::unique(outTriangles.begin(), outTriangles.end()), outTriangles.end());
+	}
+
+	bool MeshSimplifier::performCollapse(const EdgeCollapse& collapse)
+	{
+		gatherTriangles(collapse.from, m_trianglesA);
+		gatherTriangles(collapse.to, m_trianglesB);
+
+		auto getTrianglePosition = [&](uint32_t triangleIdx, uint32_t corner)
+		{
+			return m_vertexToPosition[m_indicies[triangleIdx * 3ull + corner]];
+		};
+
+		// Every vertex at 'from' moves to the vertex at 'to' it shares a triangle with, which keeps the attributes on each side of a seam
+		std::unordered_map<uint32_t, uint32_t> wedgeTargets;
+		uint32_t numSharedTriangles = 0;
+
+		for (uint32_t triangleIdx : m_trianglesA)
+		{
+			uint32_t fromVertex = INVALID_UINT32;
+			uint32_t toVertex = INVALID_UINT32;
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t positionIdx = getTrianglePosition(triangleIdx, corner);
+				if (positionIdx == collapse.from)
+				{
+					fromVertex = m_indicies[triangleIdx * 3ull + corner];
+				}
+				else if (positionIdx == collapse.to)
+				{
+					toVertex = m_indicies[triangleIdx * 3ull + corner];
+				}
+			}
+
+			if (toVertex == INVALID_UINT32)
+			{
+				continue;
+			}
+
+			numSharedTriangles++;
+
+			auto [it, inserted] = wedgeTargets.try_emplace(fromVertex, toVertex);
+			if (!inserted && it->second != toVertex)
+			{
+				return false;
+			}
+		}
+
+		// Link condition, the only neighbours the two positions can have in common are the third corners of the triangles between them
+		auto gatherNeighbours = [&](const std::vector<uint32_t>& triangles, uint32_t positionIdx, uint32_t otherPositionIdx, std::vector<uint32_t>& outNeighbours)
+		{
+			outNeighbours.clear();
+			for (uint32_t triangleIdx : triangles)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t neighbour = getTrianglePosition(triangleIdx, corner);
+					if (neighbour != positionIdx && neighbour != otherPositionIdx)
+					{
+						outNeighbours.emplace_back(neighbour);
+					}
+				}
+			}
+
+			std::sort(outNeighbours.begin(), outNeighbours.end());
+			outNeighbours.erase(std::unique(outNeighbours.begin(), outNeighbours.end()), outNeighbours.end());
+		};
+
+		gatherNeighbours(m_trianglesA, collapse.from, collapse.to, m_neighboursA);
+		gatherNeighbours(m_trianglesB, collapse.to, collapse.from, m_neighboursB);
+
+		uint32_t numCommonNeighbours = 0;
+		for (uint32_t i = 0, j = 0; i < (uint32_t)m_neighboursA.size() && j < (uint32_t)m_neighboursB.size();)
+		{
+			if (m_neighboursA[i] == m_neighboursB[j])
+			{
+				numCommonNeighbours++;
+				i++;
+				j++;
+			}
+			else if (m_neighboursA[i] < m_neighboursB[j])
+			{
+				i++;
+			}
+			else
+			{
+				j++;
+			}
+		}
+
+		if (numCommonNeighbours != numSharedTriangles)
+		{
+			return false;
+		}
+
+		// Every triangle that survives has to keep facing the same way
+		glm::dvec3 targetPosition = getPosition(collapse.to);
+		for (uint32_t triangleIdx : m_trianglesA)
+		{
+			uint32_t fromVertex = INVALID_UINT32;
+			glm::dvec3 corners[3] = {};
+			uint32_t fromCorner = INVALID_UINT32;
+
+			bool isShared = false;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t positionIdx = getTrianglePosition(triangleIdx, corner);
+				corners[corner] = getPosition(positionIdx);
+
+				isShared |= positionIdx == collapse.to;
+				if (positionIdx == collapse.from)
+				{
+					fromCorner = corner;
+					fromVertex = m_indicies[triangleIdx * 3ull + corner];
+				}
+			}
+
+			if (isShared)
+			{
+				continue;
+			}
+
+			// Surviving triangles need a vertex to move to as well, verticies without a triangle across the edge have nowhere to go
+			if (!wedgeTargets.contains(fromVertex))
+			{
+				return false;
+			}
+
+			glm::dvec3 oldNormal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			corners[fromCorner] = targetPosition;
+			glm::dvec3 newNormal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+			if (glm::dot(oldNormal, newNormal) <= 0.0)
+			{
+				return false;
+			}
+		}
+
+		for (uint32_t triangleIdx : m_trianglesA)
+		{
+			bool isShared = false;
+			uint32_t fromCorner = INVALID_UINT32;
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t positionIdx = getTrianglePosition(triangleIdx, corner);
+				isShared |= positionIdx == collapse.to;
+				fromCorner = positionIdx == collapse.from ? corner : fromCorner;
+			}
+
+			if (isShared)
+			{
+				m_liveTriangles[triangleIdx] = false;
+				m_numLiveTriangles--;
+				continue;
+			}
+
+			uint32_t& vertexIdx = m_indicies[triangleIdx * 3ull + fromCorner];
+			vertexIdx = wedgeTargets[vertexIdx];
+			m_vertexTriangles[vertexIdx].emplace_back(triangleIdx);
+		}
+
+		m_quadrics[collapse.to].add(m_quadrics[collapse.from]);
+
+		m_collapseLocked[collapse.from] = true;
+		m_collapseLocked[collapse.to] = true;
+
+		m_collapsedInto[collapse.from] = collapse.to;
+
+		return true;
+	}
+
+	float simplifyMesh(const MeshData& meshData, uint32_t targetNumIndicies, float maxError, std::vector<uint32_t>& outIndicies)
+	{
+		MeshSimplifier simplifier(meshData);
+		simplifier.simplify(targetNumIndicies / 3, maxError);
+		simplifier.writeIndicies(outIndicies);
+
+		return simplifier.measureError();
+	}
+
+	void generateMeshLODs(const MeshData& meshData, const MeshLODSettings& settings, std::vector<MeshLOD>& outLODs)
+	{
+		outLODs.clear();
+
+		uint32_t numTriangles = (uint32_t)meshData.indicies.size() / 3;
+		if (numTriangles < settings.minTriangles || meshData.verticies.empty())
+		{
+			return;
+		}
+
+		float maxError = settings.maxError * computeBoundingSphere(meshData.verticies).w;
+
+		MeshSimplifier simplifier(meshData);
+		uint32_t previousNumTriangles = numTriangles;
+
+		for (float triangleRatio : settings.triangleRatios)
+		{
+			simplifier.simplify((uint32_t)(numTriangles * triangleRatio), maxError);
+
+			if (simplifier.getNumTriangles() > previousNumTriangles * (1.f - MIN_LOD_REDUCTION))
+			{
+				break;
+			}
+
+			// The quadrics only estimate the error, the measured one decides
+			float error = simplifier.measureError();
+			if (error > maxError)
+			{
+				break;
+			}
+
+			MeshLOD& lod = outLODs.emplace_back();
+			simplifier.writeIndicies(lod.indicies);
+			lod.error = outLODs.size() > 1 ? glm::max(error, outLODs[outLODs.size() - 2].error) : error;
+
+			optimizeVertexCache(lod.indicies, (uint32_t)meshData.verticies.size());
+
+			previousNumTriangles = simplifier.getNumTriangles();
+		}
+	}
+}
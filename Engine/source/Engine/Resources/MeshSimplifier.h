@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*
+	Automatic LODs with quadric error metric edge collapses (Garland & Heckbert 1997).
+	Verticies are only ever collapsed onto other existing verticies, so every LOD is just another index buffer into the mesh verticies.
+
+	Verticies that share a position but not the rest of the attributes (UV seams, hard edges) are collapsed together and only along the seam,
+	open borders only along the border. Corners where seams or borders meet are never moved.
+	Collapses that would flip a triangle or change the topology (link condition) are skipped, so closed meshes stay closed.
+
+	Collapses are picked by their quadric error, but the error of a level is measured: the largest distance from a removed vertex
+	to the simplified mesh, in mesh local units. Deterministic, the collapse order only depends on the mesh.
+*/
+
+namespace Okay
+{
+	static const uint32_t MAX_MESH_LODS = 4; // Including the full mesh
+
+	struct MeshLODSettings
+	{
+		float triangleRatios[MAX_MESH_LODS - 1] = { 0.5f, 0.25f, 0.125f }; // Of the full mesh
+		float maxError = 0.05f; // Relative to the bounding radius, the chain stops early when a level can't get under it
+		uint32_t minTriangles = 32; // Smaller meshes don't get LODs
+	};
+
+	// Simplifies towards targetNumIndicies, stops at collapses with a quadric error over maxError (mesh units). Returns the measured error
+	float simplifyMesh(const MeshData& meshData, uint32_t targetNumIndicies, float maxError, std::vector<uint32_t>& outIndicies);
+
+	// LOD 1 and up (MeshLOD is in Mesh.h), every level continues from the one before so the errors only grow.
+	// Levels with a measured error over settings.maxError are dropped
+	void generateMeshLODs(const MeshData& meshData, const MeshLODSettings& settings, std::vector<MeshLOD>& outLODs);
+
+	// Pixels per mesh unit at distance 1, projectionScale * error * objectScale / distance = error in pixels
+	inline float getLODProjectionScale(float fovY, float screenHeight)
+	{
+		return screenHeight / (2.f * glm::tan(fovY * 0.5f));
+	}
+
+	// pLODErrors[0] is the full mesh (0). Returns the least detailed level that's within maxPixelError
+	inline uint32_t selectMeshLOD(const float* pLODErrors, uint32_t numLODs, float distance, float objectScale, float projectionScale, float maxPixelError)
+	{
+		float maxError = maxPixelError * glm::max(distance, 0.f) / (objectScale * projectionScale);
+
+		uint32_t lodIdx = 0;
+		while (lodIdx + 1 < numLODs && pLODErrors[lodIdx + 1] <= maxError)
+		{
+			lodIdx++;
+		}
+
+		return lodIdx;
+	}
+}
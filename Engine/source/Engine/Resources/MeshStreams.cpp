@@ -0,0 +1,87 @@
+#include "MeshStreams.h"
+#include "Engine/Misc/Hash.h"
+
+#include <unordered_map>
+#include <cstring>
+
+namespace Okay
+{
+	// Compared bitwise, positions that are only nearly equal are kept apart
+	struct PositionKey
+	{
+		uint32_t bits[3] = {};
+
+		inline bool operator==(const PositionKey& other) const
+		{
+			return memcmp(bits, other.bits, sizeof(bits)) == 0;
+		}
+	};
+
+	struct PositionKeyHasher
+	{
+		inline size_t operator()(const PositionKey& key) const
+		{
+			Hasher hasher;
+			hasher.addValue(key.bits);
+			return (size_t)hasher.get();
+		}
+	};
+
+	uint32_t createPositionRemap(const std::vector<Vertex>& verticies, std::vector<uint32_t>& outVertexToPosition)
+	{
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHasher> positionIndicies;
+		positionIndicies.reserve(verticies.size());
+
+		outVertexToPosition.resize(verticies.size());
+
+		// Positions keep the order they're first seen in, so the result doesn't depend on the hash map
+		for (uint32_t i = 0; i < (uint32_t)verticies.size(); i++)
+		{
+			PositionKey key;
+			memcpy(key.bits, &verticies[i].position, sizeof(key.bits));
+
+			auto [it, inserted] = positionIndicies.try_emplace(key, (uint32_t)positionIndicies.size());
+			outVertexToPosition[i] = it->second;
+		}
+
+		return (uint32_t)positionIndicies.size();
+	}
+
+	void createPositionStream(const MeshData& meshData, bool deduplicate, PositionStream& outStream)
+	{
+		outStream.positions.clear();
+		outStream.indicies.clear();
+
+		if (!deduplicate)
+		{
+			outStream.positions.reserve(meshData.verticies.size());
+			for (const Vertex& vertex : meshData.verticies)
+			{
+				outStream.positions.emplace_back(vertex.position);
+			}
+
+			return;
+		}
+
+		std::vector<uint32_t> vertexToPosition;
+		uint32_t numPositions = createPositionRemap(meshData.verticies, vertexToPosition);
+
+		outStream.positions.resize(numPositions);
+		for (uint32_t i = 0; i < (uint32_t)meshData.verticies.size(); i++)
+		{
+			outStream.positions[vertexToPosition[i]] = meshData.verticies[i].position;
+		}
+
+		// Nothing merged, the mesh indicies work for the position stream too
+		if (outStream.positions.size() == meshData.verticies.size())
+		{
+			return;
+		}
+
+		outStream.indicies.resize(meshData.indicies.size());
+		for (uint32_t i = 0; i < (uint32_t)meshData.indicies.size(); i++)
+		{
+			outStream.indicies[i] = vertexToPosition[meshData.indicies[i]];
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*
+	Splits the interleaved mesh verticies into the streams the GPU passes need.
+	Depth only passes (shadow maps) only read the position, so they get their own tightly packed stream.
+*/
+
+namespace Okay
+{
+	struct PositionStream
+	{
+		std::vector<glm::vec3> positions;
+
+		// Empty if every vertex kept its index, then the mesh index buffer can be used as is
+		std::vector<uint32_t> indicies;
+	};
+
+	// Verticies with bitwise equal positions get the same position index, in the order they're first seen. Returns the number of positions
+	uint32_t createPositionRemap(const std::vector<Vertex>& verticies, std::vector<uint32_t>& outVertexToPosition);
+
+	// With deduplicate, verticies that only differ in normal/uv/etc. share one position and get a remapped index buffer
+	void createPositionStream(const MeshData& meshData, bool deduplicate, PositionStream& outStream);
+}
@@ -0,0 +1,166 @@
+#include "MeshletBuilder.h"
+
+namespace Okay
+{
+	// Cones wider than this can't cull anything useful
+	static const float MIN_CONE_NORMAL_DOT = 0.1f;
+
+	static void computeMeshletBounds(const MeshData& meshData, const MeshletData& meshletData, Meshlet& meshlet)
+	{
+		const uint32_t* pVertexIndicies = meshletData.vertexIndicies.data() + meshlet.vertexOffset;
+		const uint32_t* pTriangles = meshletData.triangles.data() + meshlet.triangleOffset;
+
+		// Same sphere as Mesh::calculateBoundingSphere
+		glm::vec3 minPos = meshData.verticies[pVertexIndicies[0]].position;
+		glm::vec3 maxPos = minPos;
+		for (uint32_t i = 0; i < meshlet.numVerticies; i++)
+		{
+			minPos = glm::min(minPos, meshData.verticies[pVertexIndicies[i]].position);
+			maxPos = glm::max(maxPos, meshData.verticies[pVertexIndicies[i]].position);
+		}
+
+		meshlet.center = (minPos + maxPos) * 0.5f;
+
+		float maxDistSqrd = 0.f;
+		for (uint32_t i = 0; i < meshlet.numVerticies; i++)
+		{
+			glm::vec3 toVertex = meshData.verticies[pVertexIndicies[i]].position - meshlet.center;
+			maxDistSqrd = glm::max(maxDistSqrd, glm::dot(toVertex, toVertex));
+		}
+
+		meshlet.radius = glm::sqrt(maxDistSqrd);
+
+
+		// Normal cone, cross(p1 - p0, p2 - p0) points out of front faces
+		glm::vec3 triangleNormals[MESHLET_MAX_TRIANGLES] = {};
+		glm::vec3 trianglePositions[MESHLET_MAX_TRIANGLES] = {};
+		uint32_t numNormals = 0;
+		glm::vec3 normalSum = glm::vec3(0.f);
+
+		for (uint32_t i = 0; i < meshlet.numTriangles; i++)
+		{
+			glm::vec3 p0 = meshData.verticies[pVertexIndicies[unpackMeshletVertex(pTriangles[i], 0)]].position;
+			glm::vec3 p1 = meshData.verticies[pVertexIndicies[unpackMeshletVertex(pTriangles[i], 1)]].position;
+			glm::vec3 p2 = meshData.verticies[pVertexIndicies[unpackMeshletVertex(pTriangles[i], 2)]].position;
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float normalLength = glm::length(normal);
+
+			if (normalLength <= 0.f) // Degenerate triangles are never visible
+			{
+				continue;
+			}
+
+			triangleNormals[numNormals] = normal / normalLength;
+			trianglePositions[numNormals] = p0;
+			normalSum += triangleNormals[numNormals];
+			numNormals++;
+		}
+
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneCutoff = 1.f;
+
+		float normalSumLength = glm::length(normalSum);
+		if (!numNormals || normalSumLength <= 0.f)
+		{
+			return;
+		}
+
+		meshlet.coneAxis = normalSum / normalSumLength;
+
+		float minNormalDot = 1.f;
+		for (uint32_t i = 0; i < numNormals; i++)
+		{
+			minNormalDot = glm::min(minNormalDot, glm::dot(triangleNormals[i], meshlet.coneAxis));
+		}
+
+		if (minNormalDot <= MIN_CONE_NORMAL_DOT)
+		{
+			return;
+		}
+
+		// Move the apex back along the axis until every triangle plane is in front of it
+		float maxApexDistance = 0.f;
+		for (uint32_t i = 0; i < numNormals; i++)
+		{
+			float apexDistance = glm::dot(meshlet.center - trianglePositions[i], triangleNormals[i]) / glm::dot(meshlet.coneAxis, triangleNormals[i]);
+			maxApexDistance = glm::max(maxApexDistance, apexDistance);
+		}
+
+		meshlet.coneApex = meshlet.center - meshlet.coneAxis * maxApexDistance;
+		meshlet.coneCutoff = glm::sqrt(1.f - minNormalDot * minNormalDot);
+	}
+
+	void buildMeshlets(const MeshData& meshData, MeshletData& outMeshletData)
+	{
+		outMeshletData.meshlets.clear();
+		outMeshletData.vertexIndicies.clear();
+		outMeshletData.triangles.clear();
+
+		// Meshlet local index of every mesh vertex, only valid for the current meshlet
+		std::vector<uint8_t> localIndicies(meshData.verticies.size(), 0);
+		std::vector<uint32_t> localIndexOwners(meshData.verticies.size(), INVALID_UINT32);
+
+		Meshlet meshlet;
+
+		auto finishMeshlet = [&]()
+		{
+			if (!meshlet.numTriangles)
+			{
+				return;
+			}
+
+			computeMeshletBounds(meshData, outMeshletData, meshlet);
+			outMeshletData.meshlets.emplace_back(meshlet);
+
+			meshlet = Meshlet();
+			meshlet.vertexOffset = (uint32_t)outMeshletData.vertexIndicies.size();
+			meshlet.triangleOffset = (uint32_t)outMeshletData.triangles.size();
+		};
+
+		for (uint32_t i = 0; i + 2 < (uint32_t)meshData.indicies.size(); i += 3)
+		{
+			uint32_t meshletIdx = (uint32_t)outMeshletData.meshlets.size();
+
+			uint32_t numNewVerticies = 0;
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t vertex = meshData.indicies[i + j];
+				bool counted = false;
+
+				for (uint32_t k = 0; k < j; k++)
+				{
+					counted |= meshData.indicies[i + k] == vertex;
+				}
+
+				numNewVerticies += localIndexOwners[vertex] != meshletIdx && !counted;
+			}
+
+			if (meshlet.numVerticies + numNewVerticies > MESHLET_MAX_VERTICIES || meshlet.numTriangles + 1 > MESHLET_MAX_TRIANGLES)
+			{
+				finishMeshlet();
+				meshletIdx++;
+			}
+
+			uint32_t triangleVerticies[3] = {};
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uint32_t vertex = meshData.indicies[i + j];
+
+				if (localIndexOwners[vertex] != meshletIdx)
+				{
+					localIndexOwners[vertex] = meshletIdx;
+					localIndicies[vertex] = (uint8_t)meshlet.numVerticies++;
+					outMeshletData.vertexIndicies.emplace_back(vertex);
+				}
+
+				triangleVerticies[j] = localIndicies[vertex];
+			}
+
+			outMeshletData.triangles.emplace_back(packMeshletTriangle(triangleVerticies[0], triangleVerticies[1], triangleVerticies[2]));
+			meshlet.numTriangles++;
+		}
+
+		finishMeshlet();
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*
+	Splits meshes into small clusters (meshlets) for culling finer than whole instances.
+	Triangles are taken in index buffer order, which is already cache optimized (MeshOptimizer.h), so neighbouring triangles end up together.
+
+	Every meshlet has a bounding sphere for frustum culling and a normal cone for backface culling.
+	Both are in mesh local space, the culling functions below take positions in the same space.
+*/
+
+namespace Okay
+{
+	static const uint32_t MESHLET_MAX_VERTICIES = 64;
+	static const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// Meshlet & MeshletData are in Mesh.h
+
+	void buildMeshlets(const MeshData& meshData, MeshletData& outMeshletData);
+
+	inline uint32_t packMeshletTriangle(uint32_t v0, uint32_t v1, uint32_t v2)
+	{
+		return v0 | (v1 << 8) | (v2 << 16);
+	}
+
+	inline uint32_t unpackMeshletVertex(uint32_t packedTriangle, uint32_t corner)
+	{
+		return (packedTriangle >> (corner * 8)) & 0xFF;
+	}
+
+	inline bool isMeshletBackfacing(const Meshlet& meshlet, glm::vec3 cameraPosition)
+	{
+		glm::vec3 toApex = meshlet.coneApex - cameraPosition;
+		float distance = glm::length(toApex);
+
+		return distance > 0.f && glm::dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * distance;
+	}
+}
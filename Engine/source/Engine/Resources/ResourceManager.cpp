@@ -1,6 +1,17 @@
 #include "ResourceManager.h"
-
-#include "assimp/importer.hpp"
+#include "VertexQuantization.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "MeshMerger.h"
+#include "CookedMesh.h"
+#include "ContentStore.h"
+#include "TextureContainer.h"
+#include "TextureQuality.h"
+#include "TgaDecoder.h"
+
+#include "Engine/Application/Time.h"
+
+#include "assimp/Importer.hpp"
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
 
@@ -8,6 +19,9 @@
 #include "stb/stb_image.h"
 
 #include <stack>
+#include <cstring>
+#include <atomic>
+#include <thread>
 
 namespace Okay
 {
@@ -60,7 +74,7 @@ namespace Okay
 	{
 		Assimp::Importer aiImporter;
 
-		const aiScene* pAiScene = aiImporter.ReadFile(path.string(), aiProcess_Triangulate | aiProcess_ConvertToLeftHanded);
+		const aiScene* pAiScene = aiImporter.ReadFile(path.string(), aiProcess_Triangulate | aiProcess_ConvertToLeftHanded | aiProcess_JoinIdenticalVertices);
 		// aiProcess_OptimizeMeshes 
 
 		OKAY_ASSERT(pAiScene);
@@ -69,56 +83,376 @@ namespace Okay
 		convertMeshData(pAiScene->mMeshes[0], outData, 1.f);
 	}
 
-	static void findOrLoadTexture(aiMaterial* pAiMaterial, aiTextureType textureType, std::unordered_map<std::string, AssetID>& loadedTextures, FilePath folderPath, ResourceManager* pResourceManager, AssetID& outAssetID)
+	static void processMeshData(CookedMesh& mesh)
 	{
-		aiString texturePath;
+		optimizeMesh(mesh.meshData, &mesh.stats);
+		buildMeshlets(mesh.meshData, mesh.meshletData);
+		generateMeshLODs(mesh.meshData, MeshLODSettings(), mesh.lods);
+	}
 
-		if (pAiMaterial->GetTexture(textureType, 0u, &texturePath) == aiReturn_SUCCESS)
+	// Runs func(idx) for [0, count) spread over all cores. Every call should only write its own slot, so the result doesn't depend on the threads
+	template<typename Func>
+	static void parallelFor(uint32_t count, Func func)
+	{
+		std::atomic<uint32_t> nextIdx = 0;
+		auto processNext = [&]()
 		{
-			if (loadedTextures.contains(texturePath.C_Str()))
+			uint32_t idx = 0;
+			while ((idx = nextIdx++) < count)
 			{
-				outAssetID = loadedTextures[texturePath.C_Str()];
+				func(idx);
 			}
-			else
+		};
+
+		uint32_t numThreads = glm::min(glm::max(std::thread::hardware_concurrency(), 1u), count);
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
+		for (uint32_t i = 1; i < numThreads; i++)
+		{
+			threads.emplace_back(processNext);
+		}
+
+		processNext();
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// Meshes don't depend on each other, so they're spread over all cores
+	static void processMeshes(std::vector<CookedMesh>& meshes)
+	{
+		parallelFor((uint32_t)meshes.size(), [&](uint32_t meshIdx)
+		{
+			processMeshData(meshes[meshIdx]);
+		});
+	}
+
+	// Formats are picked per texture by selectTextureFormat, false only drops the unused channels (R8, RG8 & RGBA8)
+	static const bool COMPRESS_TEXTURES = true;
+
+	// A texture decoded, mipped & compressed off the main thread (or read from a DDS / KTX2), added to the ResourceManager afterwards
+	struct ImportedTexture
+	{
+		FilePath path;
+		bool isSRGB = true;
+
+		AssetID id = INVALID_ASSET_ID; // Set up front when the path was already loaded, it's not imported again
+		TextureMipChain mipChain;
+
+		TextureQualitySettings qualitySettings;
+		uint64_t skippedSize = 0; // Of the mips the quality skipped, in mipChain.format
+	};
+
+	static bool decodeTgaMipChain(const FilePath& path, const TextureMipSettings& mipSettings, TextureMipChain& outChain, int& outNumChannels)
+	{
+		std::string fileData;
+		TgaInfo info;
+
+		if (!readBinary(path, fileData) || !readTgaInfo((const uint8_t*)fileData.data(), fileData.size(), info))
+		{
+			return false;
+		}
+
+		allocateMipChain(info.width, info.height, mipSettings, outChain);
+		if (!decodeTga((const uint8_t*)fileData.data(), fileData.size(), outChain.data.data()))
+		{
+			return false;
+		}
+
+		generateMipLevels(mipSettings, outChain);
+		outNumChannels = (int)info.numChannels;
+
+		return true;
+	}
+
+	static void importTexture(ImportedTexture& texture)
+	{
+		// Already mipped & compressed offline, used as is
+		if (isTextureContainerPath(texture.path))
+		{
+			const char* pError = nullptr;
+			bool loaded = loadTextureContainer(texture.path, texture.mipChain, &pError);
+			if (!loaded)
 			{
-				outAssetID = pResourceManager->loadTexture(folderPath / texturePath.C_Str());
-				loadedTextures[texturePath.C_Str()] = outAssetID;
+				printf("Failed to load %s: %s\n", texture.path.string().c_str(), pError);
 			}
+
+			OKAY_ASSERT(loaded);
+
+			TextureMipLevel fullLevel = texture.mipChain.levels[0];
+			uint32_t numSkippedMips = applyTextureQuality(texture.mipChain, texture.isSRGB, texture.qualitySettings, false);
+			texture.skippedSize = getSkippedMipsSize(texture.mipChain.format, fullLevel.width, fullLevel.height, numSkippedMips);
+
+			// Only the full size in the file, the mips are built like for any other image & encoded in the file's format.
+			// Skipping mips above already built them when it had to
+			const TextureMipLevel& keptLevel = texture.mipChain.levels[0];
+			if (texture.mipChain.getNumLevels() == 1 && getNumMipLevels(keptLevel.width, keptLevel.height) > 1)
+			{
+				TextureMipChain rgba8Chain;
+				decodeAndGenerateMips(texture.mipChain, texture.isSRGB, rgba8Chain);
+				compressMipChain(rgba8Chain, texture.mipChain.format, texture.mipChain);
+			}
+			return;
+		}
+
+		TextureMipSettings mipSettings;
+		mipSettings.isSRGB = texture.isSRGB;
+
+		// Always expanded to RGBA for the mips & the encoder, numChannels is what the file actually has
+		int width = 0, height = 0, numChannels = 0;
+
+		// TGA is decoded straight into the full size level, anything it can't handle goes through stb
+		if (isTgaPath(texture.path) && !decodeTgaMipChain(texture.path, mipSettings, texture.mipChain, numChannels))
+		{
+			texture.mipChain = TextureMipChain();
+		}
+
+		if (texture.mipChain.getNumLevels())
+		{
+			width = (int)texture.mipChain.levels[0].width;
+			height = (int)texture.mipChain.levels[0].height;
 		}
 		else
 		{
-			outAssetID = 0; // Should use some default texture, but just picking one is fine for now :] (this will be funky for normalMaps :eyes:)
+			uint8_t* pData = stbi_load(texture.path.string().c_str(), &width, &height, &numChannels, STBI_rgb_alpha);
+
+			OKAY_ASSERT(pData);
+
+			generateMipChain(pData, (uint32_t)width, (uint32_t)height, mipSettings, texture.mipChain);
+
+			stbi_image_free(pData);
+		}
+
+		// Skipped before compressing so the skipped levels aren't encoded, a BC texture has to stay a multiple of 4
+		bool canBlockCompress = COMPRESS_TEXTURES && width % 4 == 0 && height % 4 == 0;
+		uint32_t numSkippedMips = applyTextureQuality(texture.mipChain, texture.isSRGB, texture.qualitySettings, canBlockCompress);
+
+		const TextureMipLevel& fullLevel = texture.mipChain.levels[0];
+		TextureFormat format = selectTextureFormat(texture.mipChain.data.data(), fullLevel.width, fullLevel.height, (uint32_t)numChannels, texture.isSRGB, COMPRESS_TEXTURES);
+
+		texture.skippedSize = getSkippedMipsSize(format, (uint32_t)width, (uint32_t)height, numSkippedMips);
+
+		if (format != OKAY_TEXTURE_FORMAT_RGBA8)
+		{
+			TextureMipChain compressedChain;
+			compressMipChain(texture.mipChain, format, compressedChain);
+			texture.mipChain = std::move(compressedChain);
 		}
 	}
 
-	AssetID ResourceManager::loadMesh(FilePath path)
+	// The same file loaded as colour & as data gets different mips, so they're kept apart. Same for another quality tier
+	static std::string getTexturePathKey(const FilePath& path, bool isSRGB, TextureQuality quality)
 	{
-		AssetID id = (AssetID)m_meshes.size();
+		return path.lexically_normal().string() + (isSRGB ? "" : "|linear") + "|" + getTextureQualityName(quality);
+	}
 
-		MeshData meshData;
-		importMeshData(path, meshData);
+	// Loads the processed meshes from the cooked file next to the model, or processes them & writes it
+	static void cookMeshes(FilePath path, std::vector<CookedMesh>& meshes)
+	{
+		static const double BYTES_TO_KB = 1.0 / 1024.0;
 
-		m_meshes.emplace_back(meshData);
+		uint64_t sourceKey = getCookedMeshSourceKey(meshes);
+		FilePath cookedPath = getCookedMeshPath(path);
 
-		return id;
+		Timer timer;
+		CookedMeshFileStats fileStats;
+
+		// Read into separate meshes so a corrupt file doesn't leave the imported ones half overwritten
+		std::vector<CookedMesh> cookedMeshes(meshes.size());
+		if (readCookedMeshes(cookedPath, sourceKey, cookedMeshes, &fileStats))
+		{
+			meshes = std::move(cookedMeshes);
+
+			printf("Loaded cooked %s: %.1f KB -> %.1f KB in %.2f ms\n", cookedPath.filename().string().c_str(),
+				fileStats.fileSize * BYTES_TO_KB, fileStats.rawSize * BYTES_TO_KB, timer.measure() * 1000.f);
+			return;
+		}
+
+		processMeshes(meshes);
+
+		if (writeCookedMeshes(cookedPath, sourceKey, meshes, &fileStats))
+		{
+			printf("Cooked %s: %.1f KB -> %.1f KB\n", cookedPath.filename().string().c_str(),
+				fileStats.rawSize * BYTES_TO_KB, fileStats.fileSize * BYTES_TO_KB);
+		}
 	}
 
-	AssetID ResourceManager::loadTexture(FilePath path)
+	static void printMeshOptimizationStats(FilePath path, const MeshOptimizationStats& stats)
 	{
-		AssetID id = (AssetID)m_textures.size();
+		printf("Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", path.filename().string().c_str(),
+			stats.before.getACMR(), stats.after.getACMR(), stats.before.getATVR(), stats.after.getATVR());
+	}
 
-		int width = 0, height = 0;
-		uint8_t* pData = stbi_load(path.string().c_str(), &width, &height, nullptr, STBI_rgb_alpha);
+	// GPU memory of the mesh with the packed vertex format & 16 bit indicies (VertexQuantization.h) vs plain floats
+	static void printMeshMemory(uint32_t meshIdx, const MeshData& meshData)
+	{
+		static const double BYTES_TO_KB = 1.0 / 1024.0;
 
-		OKAY_ASSERT(pData);
+		uint64_t unpackedSize = getUnpackedMeshSize(meshData);
+		uint64_t packedSize = getPackedMeshSize(meshData);
 
-		Texture& texture = m_textures.emplace_back();
-		texture.setTextureData(pData, (uint32_t)width, (uint32_t)height);
+		printf("Mesh %u: %u verticies, %.1f KB -> %.1f KB (%.1f KB saved)\n", meshIdx, (uint32_t)meshData.verticies.size(),
+			unpackedSize * BYTES_TO_KB, packedSize * BYTES_TO_KB, (unpackedSize - packedSize) * BYTES_TO_KB);
+	}
 
-		return id;
+	static uint32_t countDrawnMeshes(const std::vector<LoadedObject>& objects, uint32_t numMeshes)
+	{
+		std::vector<uint8_t> drawnMeshes(numMeshes, false);
+		uint32_t numDrawnMeshes = 0;
+
+		for (const LoadedObject& object : objects)
+		{
+			numDrawnMeshes += !drawnMeshes[object.meshID];
+			drawnMeshes[object.meshID] = true;
+		}
+
+		return numDrawnMeshes;
+	}
+
+	// Replaces the merged objects with one object per batch, whose mesh is added to the end of meshes. meshID indexes meshes
+	static MeshMergeReport mergeStaticMeshes(std::vector<CookedMesh>& meshes, std::vector<LoadedObject>& objects, const MeshMergeSettings& settings)
+	{
+		std::vector<MeshMergeObject> mergeObjects(objects.size());
+		for (uint32_t i = 0; i < (uint32_t)objects.size(); i++)
+		{
+			mergeObjects[i].meshIdx = objects[i].meshID;
+			mergeObjects[i].diffuseTextureID = objects[i].diffuseTextureID;
+			mergeObjects[i].normalMapID = objects[i].normalMapID;
+			mergeObjects[i].transformMatrix = objects[i].transformMatrix;
+		}
+
+		std::vector<glm::vec4> meshBoundingSpheres(meshes.size());
+		std::vector<uint32_t> meshVertexCounts(meshes.size());
+		for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+		{
+			meshBoundingSpheres[i] = computeBoundingSphere(meshes[i].meshData.verticies);
+			meshVertexCounts[i] = (uint32_t)meshes[i].meshData.verticies.size();
+		}
+
+		std::vector<MeshMergeBatch> batches;
+		findMeshMergeBatches(mergeObjects, meshBoundingSpheres, meshVertexCounts, settings, batches);
+
+		MeshMergeReport report;
+		report.numObjects = (uint32_t)objects.size();
+		report.numBatches = (uint32_t)batches.size();
+		report.numDrawsBefore = countDrawnMeshes(objects, (uint32_t)meshes.size());
+
+		std::vector<uint8_t> mergedObjects(objects.size(), false);
+		std::vector<LoadedObject> batchObjects;
+
+		for (const MeshMergeBatch& batch : batches)
+		{
+			LoadedObject& batchObject = batchObjects.emplace_back();
+			batchObject.meshID = (uint32_t)meshes.size();
+			batchObject.diffuseTextureID = objects[batch.objectIndicies[0]].diffuseTextureID;
+			batchObject.normalMapID = objects[batch.objectIndicies[0]].normalMapID;
+
+			CookedMesh& batchMesh = meshes.emplace_back();
+			for (uint32_t objectIdx : batch.objectIndicies)
+			{
+				appendTransformedMesh(meshes[objects[objectIdx].meshID].meshData, objects[objectIdx].transformMatrix, batchMesh.meshData);
+				mergedObjects[objectIdx] = true;
+			}
+
+			report.numMergedObjects += (uint32_t)batch.objectIndicies.size();
+		}
+
+		uint32_t numKeptObjects = 0;
+		for (uint32_t i = 0; i < (uint32_t)objects.size(); i++)
+		{
+			if (!mergedObjects[i])
+			{
+				objects[numKeptObjects++] = objects[i];
+			}
+		}
+
+		objects.resize(numKeptObjects);
+		objects.insert(objects.end(), batchObjects.begin(), batchObjects.end());
+
+		report.numDrawsAfter = countDrawnMeshes(objects, (uint32_t)meshes.size());
+
+		return report;
+	}
+
+	static void printMeshMergeReport(FilePath path, const MeshMergeReport& report)
+	{
+		printf("Merged %s: %u / %u objects into %u batches, draw calls %u -> %u\n", path.filename().string().c_str(),
+			report.numMergedObjects, report.numObjects, report.numBatches, report.numDrawsBefore, report.numDrawsAfter);
+	}
+
+	static void printMeshLODs(uint32_t meshIdx, const CookedMesh& mesh)
+	{
+		printf("Mesh %u LODs: %u", meshIdx, (uint32_t)mesh.meshData.indicies.size() / 3);
+		for (const MeshLOD& lod : mesh.lods)
+		{
+			printf(" -> %u (%.3f)", (uint32_t)lod.indicies.size() / 3, lod.error);
+		}
+		printf(" triangles\n");
+	}
+
+	static void printAssetDedupReport(FilePath path, const AssetDedupReport& report)
+	{
+		static const double BYTES_TO_KB = 1.0 / 1024.0;
+
+		printf("Deduplicated %s: %u / %u meshes & %u / %u textures shared, %.1f KB saved\n", path.filename().string().c_str(),
+			report.numSharedMeshes, report.numMeshLoads, report.numSharedTextures, report.numTextureLoads,
+			(report.meshBytesSaved + report.textureBytesSaved) * BYTES_TO_KB);
+	}
+
+	static void printTextureMemoryReport(const TextureMemoryReport& report, TextureQuality quality)
+	{
+		static const double BYTES_TO_MB = 1.0 / (1024.0 * 1024.0);
+		static const char* FORMAT_NAMES[OKAY_TEXTURE_FORMAT_COUNT] = { "RGBA8", "BC1", "BC3", "BC4", "BC5", "R8", "RG8" };
+
+		printf("Texture memory: %.2f MB -> %.2f MB (", report.rgba8Size * BYTES_TO_MB, report.size * BYTES_TO_MB);
+		for (uint32_t i = 0; i < OKAY_TEXTURE_FORMAT_COUNT; i++)
+		{
+			if (report.numTextures[i])
+			{
+				printf(" %s: %u", FORMAT_NAMES[i], report.numTextures[i]);
+			}
+		}
+		printf(" ), %s quality skipped %.2f MB\n", getTextureQualityName(quality), report.skippedSize * BYTES_TO_MB);
+	}
+
+	AssetID ResourceManager::loadMesh(FilePath path)
+	{
+		std::vector<CookedMesh> importedMeshes(1);
+		importMeshData(path, importedMeshes[0].meshData);
+
+		cookMeshes(path, importedMeshes);
+
+		CookedMesh& mesh = importedMeshes[0];
+		printMeshOptimizationStats(path, mesh.stats);
+
+		m_meshOptimizationStats.before.add(mesh.stats.before);
+		m_meshOptimizationStats.after.add(mesh.stats.after);
+
+		return addMesh(mesh);
 	}
 
-	void ResourceManager::loadObjects(FilePath path, std::vector<LoadedObject>& loadedObjects, float scale)
+	AssetID ResourceManager::loadTexture(FilePath path, bool isSRGB)
+	{
+		AssetID id = findLoadedTexture(path, isSRGB);
+		if (id != INVALID_ASSET_ID)
+		{
+			return id;
+		}
+
+		ImportedTexture texture;
+		texture.path = path;
+		texture.isSRGB = isSRGB;
+		texture.qualitySettings = m_textureQualitySettings;
+
+		importTexture(texture);
+
+		return addTexture(texture);
+	}
+
+	void ResourceManager::loadObjects(FilePath path, std::vector<LoadedObject>& loadedObjects, float scale, const MeshMergeSettings* pMergeSettings)
 	{
 		Assimp::Importer aiImporter;
 
@@ -127,27 +461,53 @@ namespace Okay
 		
 		OKAY_ASSERT(pAiScene);
 
-		m_meshes.reserve(m_meshes.size() + pAiScene->mNumMeshes);
-		uint32_t startMeshIdx = (uint32_t)m_meshes.size();
+		AssetDedupReport dedupReportBefore = m_assetDedupReport;
 
-		MeshData meshData;
+		std::vector<CookedMesh> importedMeshes(pAiScene->mNumMeshes);
 		for (uint32_t i = 0; i < pAiScene->mNumMeshes; i++)
 		{
-			convertMeshData(pAiScene->mMeshes[i], meshData, scale);
+			convertMeshData(pAiScene->mMeshes[i], importedMeshes[i].meshData, scale);
+		}
 
-			m_meshes.emplace_back(meshData);
+		// meshID is an index into importedMeshes until the meshes are added at the end
+		std::vector<LoadedObject> objects;
 
-			meshData.verticies.clear();
-			meshData.indicies.clear();
-		}
+		// diffuseTextureID & normalMapID are indicies into importedTextures until they're added after the walk
+		std::vector<ImportedTexture> importedTextures;
+		std::unordered_map<std::string, uint32_t> texturePathToIdx;
+
+		FilePath folderPath = path.parent_path();
+
+		auto findTexture = [&](aiMaterial* pAiMaterial, aiTextureType textureType, bool isSRGB)
+		{
+			aiString texturePath;
+			if (pAiMaterial->GetTexture(textureType, 0u, &texturePath) != aiReturn_SUCCESS)
+			{
+				return INVALID_UINT32;
+			}
+
+			std::string pathKey = getTexturePathKey(texturePath.C_Str(), isSRGB, m_textureQuality);
+
+			auto pathIt = texturePathToIdx.find(pathKey);
+			if (pathIt != texturePathToIdx.end())
+			{
+				return pathIt->second;
+			}
+
+			uint32_t textureIdx = (uint32_t)importedTextures.size();
+			texturePathToIdx[pathKey] = textureIdx;
 
-		std::unordered_map<std::string, AssetID> texturePathToID;
+			ImportedTexture& texture = importedTextures.emplace_back();
+			texture.path = folderPath / texturePath.C_Str();
+			texture.isSRGB = isSRGB;
+			texture.id = findLoadedTexture(texture.path, isSRGB);
+
+			return textureIdx;
+		};
 
 		std::stack<aiNode*> aiNodeStack;
 		aiNodeStack.emplace() = pAiScene->mRootNode;
 
-		FilePath folderPath = path.parent_path();
-
 		while (!aiNodeStack.empty())
 		{
 			aiNode* pAiNode = aiNodeStack.top();
@@ -159,18 +519,18 @@ namespace Okay
 
 			for (uint32_t i = 0; i < pAiNode->mNumMeshes; i++)
 			{
-				LoadedObject& objectData = loadedObjects.emplace_back();
+				LoadedObject& objectData = objects.emplace_back();
 
 				objectData.transformMatrix = nodeTransform;
 
 				uint32_t aiMeshIdx = pAiNode->mMeshes[i];
-				objectData.meshID = startMeshIdx + aiMeshIdx;
+				objectData.meshID = aiMeshIdx;
 
 				aiMesh* pAiMesh = pAiScene->mMeshes[aiMeshIdx];
 				aiMaterial* pAiMaterial = pAiScene->mMaterials[pAiMesh->mMaterialIndex];
 
-				findOrLoadTexture(pAiMaterial, aiTextureType_DIFFUSE, texturePathToID, folderPath, this, objectData.diffuseTextureID);
-				findOrLoadTexture(pAiMaterial, aiTextureType_DISPLACEMENT, texturePathToID, folderPath, this, objectData.normalMapID);
+				objectData.diffuseTextureID = findTexture(pAiMaterial, aiTextureType_DIFFUSE, true);
+				objectData.normalMapID = findTexture(pAiMaterial, aiTextureType_DISPLACEMENT, false);
 			}
 
 			for (uint32_t i = 0; i < pAiNode->mNumChildren; i++)
@@ -178,6 +538,203 @@ namespace Okay
 				aiNodeStack.emplace(pAiNode->mChildren[i]);
 			}
 		}
+
+		uint32_t numImportedTextures = 0;
+		for (ImportedTexture& texture : importedTextures)
+		{
+			texture.qualitySettings = m_textureQualitySettings;
+			numImportedTextures += texture.id == INVALID_ASSET_ID;
+		}
+
+		// Decoded & mipped in parallel, then added in order so the AssetIDs don't depend on the threads
+		Timer importTimer;
+		parallelFor((uint32_t)importedTextures.size(), [&](uint32_t textureIdx)
+		{
+			if (importedTextures[textureIdx].id == INVALID_ASSET_ID)
+			{
+				importTexture(importedTextures[textureIdx]);
+			}
+		});
+
+		for (ImportedTexture& texture : importedTextures)
+		{
+			if (texture.id == INVALID_ASSET_ID)
+			{
+				texture.id = addTexture(texture);
+			}
+		}
+
+		printf("Imported %u textures in %.2f ms\n", numImportedTextures, importTimer.measure() * 1000.f);
+		printTextureMemoryReport(m_textureMemoryReport, m_textureQuality);
+
+		// Should use some default texture, but just picking one is fine for now :] (this will be funky for normalMaps :eyes:)
+		for (LoadedObject& object : objects)
+		{
+			object.diffuseTextureID = object.diffuseTextureID != INVALID_UINT32 ? importedTextures[object.diffuseTextureID].id : 0;
+			object.normalMapID = object.normalMapID != INVALID_UINT32 ? importedTextures[object.normalMapID].id : 0;
+		}
+
+		if (pMergeSettings)
+		{
+			MeshMergeReport report = mergeStaticMeshes(importedMeshes, objects, *pMergeSettings);
+			printMeshMergeReport(path, report);
+
+			m_meshMergeReport.add(report);
+		}
+
+		// Meshes that were only used by merged objects aren't needed anymore, the rest keep their order
+		std::vector<uint32_t> meshRemap(importedMeshes.size(), INVALID_UINT32);
+		for (const LoadedObject& object : objects)
+		{
+			meshRemap[object.meshID] = 0;
+		}
+
+		uint32_t numUsedMeshes = 0;
+		for (uint32_t i = 0; i < (uint32_t)importedMeshes.size(); i++)
+		{
+			if (meshRemap[i] == INVALID_UINT32)
+			{
+				continue;
+			}
+
+			meshRemap[i] = numUsedMeshes;
+			if (numUsedMeshes != i)
+			{
+				importedMeshes[numUsedMeshes] = std::move(importedMeshes[i]);
+			}
+
+			numUsedMeshes++;
+		}
+
+		importedMeshes.resize(numUsedMeshes);
+
+		cookMeshes(path, importedMeshes);
+
+		m_meshes.reserve(m_meshes.size() + importedMeshes.size());
+
+		// Printed & added in mesh order after the threads are done
+		MeshOptimizationStats stats;
+		std::vector<AssetID> meshIDs(importedMeshes.size());
+		for (uint32_t i = 0; i < (uint32_t)importedMeshes.size(); i++)
+		{
+			CookedMesh& mesh = importedMeshes[i];
+
+			stats.before.add(mesh.stats.before);
+			stats.after.add(mesh.stats.after);
+
+			meshIDs[i] = addMesh(mesh);
+		}
+
+		printMeshOptimizationStats(path, stats);
+
+		m_meshOptimizationStats.before.add(stats.before);
+		m_meshOptimizationStats.after.add(stats.after);
+
+		for (LoadedObject& object : objects)
+		{
+			object.meshID = meshIDs[meshRemap[object.meshID]];
+			loadedObjects.emplace_back(object);
+		}
+
+		AssetDedupReport dedupReport;
+		dedupReport.numMeshLoads = m_assetDedupReport.numMeshLoads - dedupReportBefore.numMeshLoads;
+		dedupReport.numSharedMeshes = m_assetDedupReport.numSharedMeshes - dedupReportBefore.numSharedMeshes;
+		dedupReport.meshBytesSaved = m_assetDedupReport.meshBytesSaved - dedupReportBefore.meshBytesSaved;
+		dedupReport.numTextureLoads = m_assetDedupReport.numTextureLoads - dedupReportBefore.numTextureLoads;
+		dedupReport.numSharedTextures = m_assetDedupReport.numSharedTextures - dedupReportBefore.numSharedTextures;
+		dedupReport.textureBytesSaved = m_assetDedupReport.textureBytesSaved - dedupReportBefore.textureBytesSaved;
+		printAssetDedupReport(path, dedupReport);
+	}
+
+	AssetID ResourceManager::addMesh(const CookedMesh& mesh)
+	{
+		uint64_t contentHash = hashMeshContent(mesh.meshData);
+
+		AssetID id = m_meshStore.find(contentHash, [&](AssetID candidateID)
+		{
+			return isSameMeshContent(m_meshes[candidateID].getMeshData(), mesh.meshData);
+		});
+
+		m_assetDedupReport.numMeshLoads++;
+
+		if (id != INVALID_ASSET_ID)
+		{
+			m_assetDedupReport.numSharedMeshes++;
+			m_assetDedupReport.meshBytesSaved += getPackedMeshSize(mesh.meshData);
+			return id;
+		}
+
+		id = (AssetID)m_meshes.size();
+		m_meshStore.add(contentHash, id);
+
+		printMeshMemory(id, mesh.meshData);
+		printMeshLODs(id, mesh);
+
+		m_meshes.emplace_back(mesh.meshData, mesh.meshletData, mesh.lods);
+
+		return id;
+	}
+
+	AssetID ResourceManager::findLoadedTexture(const FilePath& path, bool isSRGB)
+	{
+		// Same file, nothing to decode
+		auto pathIt = m_texturePathIDs.find(getTexturePathKey(path, isSRGB, m_textureQuality));
+		if (pathIt == m_texturePathIDs.end())
+		{
+			return INVALID_ASSET_ID;
+		}
+
+		const Texture& texture = m_textures[pathIt->second];
+
+		m_assetDedupReport.numTextureLoads++;
+		m_assetDedupReport.numSharedTextures++;
+		m_assetDedupReport.textureBytesSaved += texture.getMipChain().data.size();
+
+		return pathIt->second;
+	}
+
+	AssetID ResourceManager::addTexture(ImportedTexture& texture)
+	{
+		const TextureMipLevel& fullLevel = texture.mipChain.levels[0];
+		uint64_t fullLevelSize = texture.mipChain.getLevelSize(0);
+
+		uint64_t contentHash = hashTextureContent(texture.mipChain.data.data(), texture.mipChain.format, fullLevel.width, fullLevel.height, texture.isSRGB);
+
+		// Same pixels under another name
+		AssetID id = m_textureStore.find(contentHash, [&](AssetID candidateID)
+		{
+			const Texture& candidate = m_textures[candidateID];
+			return candidate.getTextureData() && candidate.isSRGB() == texture.isSRGB && candidate.getFormat() == texture.mipChain.format &&
+				candidate.getWidth() == fullLevel.width && candidate.getHeight() == fullLevel.height &&
+				!memcmp(candidate.getTextureData(), texture.mipChain.data.data(), fullLevelSize);
+		});
+
+		m_assetDedupReport.numTextureLoads++;
+
+		if (id != INVALID_ASSET_ID)
+		{
+			m_assetDedupReport.numSharedTextures++;
+			m_assetDedupReport.textureBytesSaved += texture.mipChain.data.size();
+		}
+		else
+		{
+			id = (AssetID)m_textures.size();
+			m_textureStore.add(contentHash, id);
+			m_textureMemoryReport.add(texture.mipChain);
+			m_textureMemoryReport.skippedSize += texture.skippedSize;
+
+			m_textures.emplace_back().setMipChain(std::move(texture.mipChain), texture.isSRGB);
+		}
+
+		m_texturePathIDs[getTexturePathKey(texture.path, texture.isSRGB, m_textureQuality)] = id;
+
+		return id;
+	}
+
+	void ResourceManager::setTextureQuality(TextureQuality quality)
+	{
+		m_textureQuality = quality;
+		m_textureQualitySettings = getTextureQualitySettings(quality);
 	}
 
 	void ResourceManager::unloadCPUData()
@@ -189,8 +746,7 @@ namespace Okay
 
 		for (Texture& texture : m_textures)
 		{
-			stbi_image_free(texture.getTextureData());
-			texture.setTextureData(nullptr, 0, 0);
+			texture.clearData();
 		}
 	}
 }
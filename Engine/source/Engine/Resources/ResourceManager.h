@@ -2,12 +2,21 @@
 
 #include "Mesh.h"
 #include "Texture.h"
+#include "MeshOptimizer.h"
+#include "MeshMerger.h"
+#include "ContentStore.h"
+#include "TextureCompression.h"
+#include "TextureQuality.h"
 
 #include <filesystem>
 #include <vector>
+#include <unordered_map>
 
 namespace Okay
 {
+	struct CookedMesh;
+	struct ImportedTexture;
+
 	struct LoadedObject
 	{
 		AssetID meshID = 0;
@@ -23,13 +32,31 @@ namespace Okay
 		ResourceManager() = default;
 		~ResourceManager() = default;
 
+		// Meshes & textures with the same content as a loaded one return its AssetID, from any file (ContentStore.h)
 		AssetID loadMesh(FilePath path);
-		AssetID loadTexture(FilePath path);
+		AssetID loadTexture(FilePath path, bool isSRGB = true); // isSRGB = false for normal maps & other data, see TextureMips.h
 
-		void loadObjects(FilePath path, std::vector<LoadedObject>& loadedObjects, float scale);
+		// With pMergeSettings, single use meshes are merged into batches by texture & location (MeshMerger.h)
+		void loadObjects(FilePath path, std::vector<LoadedObject>& loadedObjects, float scale, const MeshMergeSettings* pMergeSettings = nullptr);
 
 		void unloadCPUData();
 
+		// Lower qualities skip the most detailed texture mips, call before loading since loaded textures keep theirs (TextureQuality.h)
+		void setTextureQuality(TextureQuality quality);
+		inline TextureQuality getTextureQuality() const { return m_textureQuality; }
+
+		// Vertex cache stats of every loaded mesh, before & after optimizeMesh
+		inline const MeshOptimizationStats& getMeshOptimizationStats() const { return m_meshOptimizationStats; }
+
+		// Draw calls before & after merging, of every loadObjects call with merging
+		inline const MeshMergeReport& getMeshMergeReport() const { return m_meshMergeReport; }
+
+		// Loads that returned an existing mesh or texture, of every call
+		inline const AssetDedupReport& getAssetDedupReport() const { return m_assetDedupReport; }
+
+		// Formats & GPU size of every loaded texture, vs all of them as RGBA8
+		inline const TextureMemoryReport& getTextureMemoryReport() const { return m_textureMemoryReport; }
+
 		template<typename Asset>
 		inline Asset& getAsset(AssetID id);
 
@@ -43,6 +70,12 @@ namespace Okay
 		inline const std::vector<Asset>& getAll() const;
 
 	private:
+		AssetID addMesh(const CookedMesh& mesh);
+
+		// Returns INVALID_ASSET_ID if the file hasn't been loaded
+		AssetID findLoadedTexture(const FilePath& path, bool isSRGB);
+		AssetID addTexture(ImportedTexture& texture);
+
 		template<typename Asset>
 		inline std::vector<Asset>& getAssets();
 
@@ -53,6 +86,18 @@ namespace Okay
 		std::vector<Mesh> m_meshes;
 		std::vector<Texture> m_textures;
 
+		MeshOptimizationStats m_meshOptimizationStats;
+		MeshMergeReport m_meshMergeReport;
+
+		ContentStore m_meshStore;
+		ContentStore m_textureStore;
+		std::unordered_map<std::string, AssetID> m_texturePathIDs;
+		AssetDedupReport m_assetDedupReport;
+		TextureMemoryReport m_textureMemoryReport;
+
+		TextureQuality m_textureQuality = OKAY_TEXTURE_QUALITY_HIGH;
+		TextureQualitySettings m_textureQualitySettings;
+
 	};
 
 
@@ -1,8 +1,7 @@
 #pragma once
 
 #include "Engine/Okay.h"
-
-#include "stb/stb_image.h"
+#include "TextureMips.h"
 
 namespace Okay
 {
@@ -15,11 +14,20 @@ namespace Okay
 		inline uint32_t getWidth() const;
 		inline uint32_t getHeight() const;
 
-		inline void setTextureData(uint8_t* pData, uint32_t width, uint32_t height);
-		inline uint8_t* getTextureData() const;
+		// Generated at import, see TextureMips.h
+		inline void setMipChain(TextureMipChain&& mipChain, bool isSRGB);
+		inline const TextureMipChain& getMipChain() const;
+		inline bool isSRGB() const;
+		inline TextureFormat getFormat() const;
+
+		// The full size level in getFormat(), nullptr after clearData()
+		inline const uint8_t* getTextureData() const;
+
+		inline void clearData();
 
 	private:
-		uint8_t* m_pTextureData = nullptr;
+		TextureMipChain m_mipChain;
+		bool m_isSRGB = true;
 
 		uint32_t m_width = INVALID_UINT32;
 		uint32_t m_height = INVALID_UINT32;
@@ -30,21 +38,45 @@ namespace Okay
 	{
 		return m_width;
 	}
-	
+
 	inline uint32_t Texture::getHeight() const
 	{
 		return m_height;
 	}
-	
-	inline void Texture::setTextureData(uint8_t* pData, uint32_t width, uint32_t height)
+
+	inline void Texture::setMipChain(TextureMipChain&& mipChain, bool isSRGB)
+	{
+		OKAY_ASSERT(!mipChain.levels.empty());
+
+		m_mipChain = std::move(mipChain);
+		m_isSRGB = isSRGB;
+		m_width = m_mipChain.levels[0].width;
+		m_height = m_mipChain.levels[0].height;
+	}
+
+	inline const TextureMipChain& Texture::getMipChain() const
+	{
+		return m_mipChain;
+	}
+
+	inline bool Texture::isSRGB() const
+	{
+		return m_isSRGB;
+	}
+
+	inline TextureFormat Texture::getFormat() const
+	{
+		return m_mipChain.format;
+	}
+
+	inline const uint8_t* Texture::getTextureData() const
 	{
-		m_pTextureData = pData;
-		m_width = width;
-		m_height = height;
+		return m_mipChain.data.empty() ? nullptr : m_mipChain.data.data();
 	}
 
-	inline uint8_t* Texture::getTextureData() const
+	inline void Texture::clearData()
 	{
-		return m_pTextureData;
+		// Swapped out so the memory is actually freed, the level sizes are kept
+		std::vector<uint8_t>().swap(m_mipChain.data);
 	}
 }
@@ -0,0 +1,620 @@
+#include "TextureCompression.h"
+
+#include <cfloat>
+#include <cstring>
+
+namespace Okay
+{
+	static const uint32_t BLOCK_TEXELS = 16;
+
+	// Texels past the edge of the level repeat the edge, they're never sampled
+	static void loadBlock(const uint8_t* pTextureData, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t outBlock[BLOCK_TEXELS][4])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t texelY = glm::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t texelX = glm::min(blockX * 4 + x, width - 1);
+				memcpy(outBlock[y * 4 + x], pTextureData + ((size_t)texelY * width + texelX) * 4, 4);
+			}
+		}
+	}
+
+	static void storeBlock(const uint8_t block[BLOCK_TEXELS][4], uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* pOutTextureData)
+	{
+		for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+		{
+			for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+			{
+				memcpy(pOutTextureData + ((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * 4, block[y * 4 + x], 4);
+			}
+		}
+	}
+
+	static inline uint16_t packRGB565(const glm::vec3& colour)
+	{
+		glm::ivec3 quantized = glm::ivec3(glm::round(glm::clamp(colour, glm::vec3(0.f), glm::vec3(255.f)) * glm::vec3(31.f, 63.f, 31.f) / 255.f));
+		return (uint16_t)(quantized.r << 11 | quantized.g << 5 | quantized.b);
+	}
+
+	static inline glm::ivec3 unpackRGB565(uint16_t packed)
+	{
+		int32_t r = packed >> 11 & 31;
+		int32_t g = packed >> 5 & 63;
+		int32_t b = packed & 31;
+
+		return glm::ivec3(r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2);
+	}
+
+	// 4 colour mode, the only one the encoder writes
+	static void getBC1Palette(uint16_t colour0, uint16_t colour1, glm::ivec3 outPalette[4])
+	{
+		outPalette[0] = unpackRGB565(colour0);
+		outPalette[1] = unpackRGB565(colour1);
+		outPalette[2] = (outPalette[0] * 2 + outPalette[1]) / 3;
+		outPalette[3] = (outPalette[0] + outPalette[1] * 2) / 3;
+	}
+
+	// Picks the closest palette colour for every texel, returns the squared error
+	static uint32_t findBC1Indicies(const uint8_t block[BLOCK_TEXELS][4], uint16_t colour0, uint16_t colour1, uint8_t outIndicies[BLOCK_TEXELS])
+	{
+		glm::ivec3 palette[4];
+		getBC1Palette(colour0, colour1, palette);
+
+		uint32_t error = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			glm::ivec3 texel = glm::ivec3(block[i][0], block[i][1], block[i][2]);
+
+			uint32_t bestDistSqrd = UINT32_MAX;
+			for (uint8_t p = 0; p < 4; p++)
+			{
+				glm::ivec3 diff = texel - palette[p];
+				uint32_t distSqrd = (uint32_t)(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z);
+
+				if (distSqrd < bestDistSqrd)
+				{
+					bestDistSqrd = distSqrd;
+					outIndicies[i] = p;
+				}
+			}
+
+			error += bestDistSqrd;
+		}
+
+		return error;
+	}
+
+	static void writeBC1Block(uint16_t colour0, uint16_t colour1, uint8_t indicies[BLOCK_TEXELS], uint8_t* pOutBlock)
+	{
+		// colour0 > colour1 selects the 4 colour mode, equal endpoints would be the 3 colour mode so only index 0 is safe
+		if (colour0 < colour1)
+		{
+			std::swap(colour0, colour1);
+			for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+			{
+				indicies[i] ^= 1; // 0 <-> 1, 2 <-> 3
+			}
+		}
+		else if (colour0 == colour1)
+		{
+			memset(indicies, 0, BLOCK_TEXELS);
+		}
+
+		uint32_t packedIndicies = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			packedIndicies |= (uint32_t)indicies[i] << (i * 2);
+		}
+
+		memcpy(pOutBlock, &colour0, sizeof(uint16_t));
+		memcpy(pOutBlock + 2, &colour1, sizeof(uint16_t));
+		memcpy(pOutBlock + 4, &packedIndicies, sizeof(uint32_t));
+	}
+
+	static void encodeBC1Block(const uint8_t block[BLOCK_TEXELS][4], uint8_t* pOutBlock)
+	{
+		static const uint32_t NUM_AXIS_ITERATIONS = 4;
+		static const uint32_t NUM_REFINE_ITERATIONS = 2;
+
+		glm::vec3 colours[BLOCK_TEXELS];
+		glm::vec3 mean = glm::vec3(0.f);
+		glm::vec3 minColour = glm::vec3(255.f);
+		glm::vec3 maxColour = glm::vec3(0.f);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			colours[i] = glm::vec3(block[i][0], block[i][1], block[i][2]);
+			mean += colours[i];
+			minColour = glm::min(minColour, colours[i]);
+			maxColour = glm::max(maxColour, colours[i]);
+		}
+		mean /= (float)BLOCK_TEXELS;
+
+		uint8_t indicies[BLOCK_TEXELS] = {};
+
+		if (minColour == maxColour)
+		{
+			uint16_t colour = packRGB565(minColour);
+			writeBC1Block(colour, colour, indicies, pOutBlock);
+			return;
+		}
+
+		// Principal axis of the colours with power iteration, starting from the bounding box diagonal
+		glm::mat3 covariance = glm::mat3(0.f);
+		for (const glm::vec3& colour : colours)
+		{
+			glm::vec3 offset = colour - mean;
+			covariance += glm::outerProduct(offset, offset);
+		}
+
+		glm::vec3 axis = maxColour - minColour;
+		for (uint32_t i = 0; i < NUM_AXIS_ITERATIONS; i++)
+		{
+			glm::vec3 nextAxis = covariance * axis;
+			float length = glm::length(nextAxis);
+			if (length < 1e-6f)
+			{
+				break;
+			}
+
+			axis = nextAxis / length;
+		}
+
+		// The texels furthest along the axis are the starting endpoints
+		uint32_t minIdx = 0, maxIdx = 0;
+		float minProjection = FLT_MAX, maxProjection = -FLT_MAX;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			float projection = glm::dot(colours[i], axis);
+			if (projection < minProjection)
+			{
+				minProjection = projection;
+				minIdx = i;
+			}
+			if (projection > maxProjection)
+			{
+				maxProjection = projection;
+				maxIdx = i;
+			}
+		}
+
+		uint16_t colour0 = packRGB565(colours[maxIdx]);
+		uint16_t colour1 = packRGB565(colours[minIdx]);
+		uint32_t error = findBC1Indicies(block, colour0, colour1, indicies);
+
+		// Least squares endpoints for the picked indicies, kept while they lower the error
+		static const float COLOUR0_WEIGHTS[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+
+		for (uint32_t iteration = 0; iteration < NUM_REFINE_ITERATIONS && error; iteration++)
+		{
+			float aa = 0.f, ab = 0.f, bb = 0.f;
+			glm::vec3 ax = glm::vec3(0.f), bx = glm::vec3(0.f);
+
+			for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+			{
+				float a = COLOUR0_WEIGHTS[indicies[i]];
+				float b = 1.f - a;
+
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				ax += colours[i] * a;
+				bx += colours[i] * b;
+			}
+
+			float determinant = aa * bb - ab * ab;
+			if (glm::abs(determinant) < 1e-6f)
+			{
+				break;
+			}
+
+			glm::vec3 endpoint0 = (ax * bb - bx * ab) / determinant;
+			glm::vec3 endpoint1 = (bx * aa - ax * ab) / determinant;
+
+			uint16_t refinedColour0 = packRGB565(endpoint0);
+			uint16_t refinedColour1 = packRGB565(endpoint1);
+
+			uint8_t refinedIndicies[BLOCK_TEXELS] = {};
+			uint32_t refinedError = findBC1Indicies(block, refinedColour0, refinedColour1, refinedIndicies);
+
+			if (refinedError >= error)
+			{
+				break;
+			}
+
+			colour0 = refinedColour0;
+			colour1 = refinedColour1;
+			error = refinedError;
+			memcpy(indicies, refinedIndicies, BLOCK_TEXELS);
+		}
+
+		writeBC1Block(colour0, colour1, indicies, pOutBlock);
+	}
+
+	static void decodeBC1Block(const uint8_t* pBlock, uint8_t outBlock[BLOCK_TEXELS][4])
+	{
+		uint16_t colour0 = 0, colour1 = 0;
+		uint32_t packedIndicies = 0;
+		memcpy(&colour0, pBlock, sizeof(uint16_t));
+		memcpy(&colour1, pBlock + 2, sizeof(uint16_t));
+		memcpy(&packedIndicies, pBlock + 4, sizeof(uint32_t));
+
+		glm::ivec3 palette[4];
+		getBC1Palette(colour0, colour1, palette);
+
+		// 3 colour mode, only used by other encoders
+		if (colour0 <= colour1)
+		{
+			palette[2] = (palette[0] + palette[1]) / 2;
+			palette[3] = glm::ivec3(0);
+		}
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			const glm::ivec3& colour = palette[packedIndicies >> (i * 2) & 3];
+			outBlock[i][0] = (uint8_t)colour.r;
+			outBlock[i][1] = (uint8_t)colour.g;
+			outBlock[i][2] = (uint8_t)colour.b;
+			outBlock[i][3] = 255;
+		}
+	}
+
+	static void getBC4Palette(uint8_t endpoint0, uint8_t endpoint1, uint8_t outPalette[8])
+	{
+		outPalette[0] = endpoint0;
+		outPalette[1] = endpoint1;
+
+		if (endpoint0 > endpoint1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+			{
+				outPalette[i + 1] = (uint8_t)(((7 - i) * endpoint0 + i * endpoint1 + 3) / 7);
+			}
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+			{
+				outPalette[i + 1] = (uint8_t)(((5 - i) * endpoint0 + i * endpoint1 + 2) / 5);
+			}
+
+			outPalette[6] = 0;
+			outPalette[7] = 255;
+		}
+	}
+
+	static uint32_t findBC4Indicies(const uint8_t values[BLOCK_TEXELS], uint8_t endpoint0, uint8_t endpoint1, uint8_t outIndicies[BLOCK_TEXELS])
+	{
+		uint8_t palette[8];
+		getBC4Palette(endpoint0, endpoint1, palette);
+
+		uint32_t error = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			uint32_t bestDistSqrd = UINT32_MAX;
+			for (uint8_t p = 0; p < 8; p++)
+			{
+				int32_t diff = (int32_t)values[i] - palette[p];
+				uint32_t distSqrd = (uint32_t)(diff * diff);
+
+				if (distSqrd < bestDistSqrd)
+				{
+					bestDistSqrd = distSqrd;
+					outIndicies[i] = p;
+				}
+			}
+
+			error += bestDistSqrd;
+		}
+
+		return error;
+	}
+
+	static void encodeBC4Block(const uint8_t values[BLOCK_TEXELS], uint8_t* pOutBlock)
+	{
+		uint8_t minValue = 255, maxValue = 0;
+		uint8_t minInnerValue = 255, maxInnerValue = 0; // Without 0 & 255, which the 6 interpolant mode has for free
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			minValue = glm::min(minValue, values[i]);
+			maxValue = glm::max(maxValue, values[i]);
+
+			if (values[i] != 0 && values[i] != 255)
+			{
+				minInnerValue = glm::min(minInnerValue, values[i]);
+				maxInnerValue = glm::max(maxInnerValue, values[i]);
+			}
+		}
+
+		if (minInnerValue > maxInnerValue)
+		{
+			minInnerValue = maxInnerValue = 0;
+		}
+
+		// 8 interpolants when endpoint0 > endpoint1, otherwise 6 plus 0 & 255
+		uint8_t endpoint0 = maxValue;
+		uint8_t endpoint1 = minValue;
+		uint8_t indicies[BLOCK_TEXELS] = {};
+		uint32_t error = findBC4Indicies(values, endpoint0, endpoint1, indicies);
+
+		if (error && minValue != maxValue)
+		{
+			uint8_t innerIndicies[BLOCK_TEXELS] = {};
+			uint32_t innerError = findBC4Indicies(values, minInnerValue, maxInnerValue, innerIndicies);
+
+			if (innerError < error)
+			{
+				endpoint0 = minInnerValue;
+				endpoint1 = maxInnerValue;
+				memcpy(indicies, innerIndicies, BLOCK_TEXELS);
+			}
+		}
+
+		uint64_t packedIndicies = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			packedIndicies |= (uint64_t)indicies[i] << (i * 3);
+		}
+
+		pOutBlock[0] = endpoint0;
+		pOutBlock[1] = endpoint1;
+		memcpy(pOutBlock + 2, &packedIndicies, 6); // Little endian, the low 48 bits
+	}
+
+	static void decodeBC4Block(const uint8_t* pBlock, uint8_t outValues[BLOCK_TEXELS])
+	{
+		uint8_t palette[8];
+		getBC4Palette(pBlock[0], pBlock[1], palette);
+
+		uint64_t packedIndicies = 0;
+		memcpy(&packedIndicies, pBlock + 2, 6);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			outValues[i] = palette[packedIndicies >> (i * 3) & 7];
+		}
+	}
+
+	static void encodeChannel(const uint8_t block[BLOCK_TEXELS][4], uint32_t channel, uint8_t* pOutBlock)
+	{
+		uint8_t values[BLOCK_TEXELS];
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			values[i] = block[i][channel];
+		}
+
+		encodeBC4Block(values, pOutBlock);
+	}
+
+	static void decodeChannel(const uint8_t* pBlock, uint32_t channel, uint8_t outBlock[BLOCK_TEXELS][4])
+	{
+		uint8_t values[BLOCK_TEXELS];
+		decodeBC4Block(pBlock, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			outBlock[i][channel] = values[i];
+		}
+	}
+
+	TextureFormat selectTextureFormat(const uint8_t* pTextureData, uint32_t width, uint32_t height, uint32_t numSourceChannels,
+		bool isColour, bool allowBlockCompression)
+	{
+		bool compress = allowBlockCompression && width % 4 == 0 && height % 4 == 0;
+
+		// 1 is gray, 2 gray & alpha, 3 RGB & 4 RGBA. stb fills in the missing ones, so the texels are only checked for what the file has
+		bool hasAlpha = numSourceChannels == 2 || numSourceChannels == 4;
+		bool hasColour = numSourceChannels >= 3;
+
+		bool isOpaque = true;
+		bool isGrayscale = true;
+
+		uint64_t numTexels = (uint64_t)width * height;
+		for (uint64_t i = 0; i < numTexels && ((hasAlpha && isOpaque) || (hasColour && isGrayscale)); i++)
+		{
+			const uint8_t* pTexel = pTextureData + i * 4;
+
+			isOpaque &= pTexel[3] == 255;
+			isGrayscale &= pTexel[0] == pTexel[1] && pTexel[0] == pTexel[2];
+		}
+
+		if (isGrayscale && isOpaque)
+		{
+			return compress ? OKAY_TEXTURE_FORMAT_BC4 : OKAY_TEXTURE_FORMAT_R8;
+		}
+
+		if (!isColour) // Normal maps, only X & Y are kept
+		{
+			return compress ? OKAY_TEXTURE_FORMAT_BC5 : OKAY_TEXTURE_FORMAT_RG8;
+		}
+
+		if (!isOpaque)
+		{
+			return compress ? OKAY_TEXTURE_FORMAT_BC3 : OKAY_TEXTURE_FORMAT_RGBA8;
+		}
+
+		return compress ? OKAY_TEXTURE_FORMAT_BC1 : OKAY_TEXTURE_FORMAT_RGBA8;
+	}
+
+	void compressTextureLevel(const uint8_t* pTextureData, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pOutBlocks)
+	{
+		if (!isBlockCompressed(format))
+		{
+			uint32_t texelSize = getTextureFormatTexelSize(format);
+			uint64_t numTexels = (uint64_t)width * height;
+
+			for (uint64_t i = 0; i < numTexels; i++)
+			{
+				memcpy(pOutBlocks + i * texelSize, pTextureData + i * 4, texelSize);
+			}
+			return;
+		}
+
+		uint32_t blockSize = getTextureFormatBlockSize(format);
+		uint32_t numBlocksX = (width + 3) / 4;
+		uint32_t numBlocksY = (height + 3) / 4;
+
+		uint8_t block[BLOCK_TEXELS][4];
+
+		for (uint32_t blockY = 0; blockY < numBlocksY; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < numBlocksX; blockX++)
+			{
+				loadBlock(pTextureData, width, height, blockX, blockY, block);
+				uint8_t* pOutBlock = pOutBlocks + ((size_t)blockY * numBlocksX + blockX) * blockSize;
+
+				switch (format)
+				{
+				case OKAY_TEXTURE_FORMAT_BC1:
+					encodeBC1Block(block, pOutBlock);
+					break;
+
+				case OKAY_TEXTURE_FORMAT_BC3: // BC4 alpha, then BC1 colour
+					encodeChannel(block, 3, pOutBlock);
+					encodeBC1Block(block, pOutBlock + 8);
+					break;
+
+				case OKAY_TEXTURE_FORMAT_BC4:
+					encodeChannel(block, 0, pOutBlock);
+					break;
+
+				case OKAY_TEXTURE_FORMAT_BC5:
+					encodeChannel(block, 0, pOutBlock);
+					encodeChannel(block, 1, pOutBlock + 8);
+					break;
+
+				default:
+					OKAY_ASSERT(false);
+					break;
+				}
+			}
+		}
+	}
+
+	void decompressTextureLevel(const uint8_t* pBlocks, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pOutTextureData)
+	{
+		if (!isBlockCompressed(format))
+		{
+			uint32_t texelSize = getTextureFormatTexelSize(format);
+			uint64_t numTexels = (uint64_t)width * height;
+
+			for (uint64_t i = 0; i < numTexels; i++)
+			{
+				const uint8_t* pTexel = pBlocks + i * texelSize;
+				uint8_t* pOutTexel = pOutTextureData + i * 4;
+
+				switch (format)
+				{
+				case OKAY_TEXTURE_FORMAT_R8:
+					pOutTexel[0] = pOutTexel[1] = pOutTexel[2] = pTexel[0];
+					pOutTexel[3] = 255;
+					break;
+
+				case OKAY_TEXTURE_FORMAT_RG8:
+					pOutTexel[0] = pTexel[0];
+					pOutTexel[1] = pTexel[1];
+					pOutTexel[2] = 0;
+					pOutTexel[3] = 255;
+					break;
+
+				default:
+					memcpy(pOutTexel, pTexel, 4);
+					break;
+				}
+			}
+			return;
+		}
+
+		uint32_t blockSize = getTextureFormatBlockSize(format);
+		uint32_t numBlocksX = (width + 3) / 4;
+		uint32_t numBlocksY = (height + 3) / 4;
+
+		uint8_t block[BLOCK_TEXELS][4];
+
+		for (uint32_t blockY = 0; blockY < numBlocksY; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < numBlocksX; blockX++)
+			{
+				const uint8_t* pBlock = pBlocks + ((size_t)blockY * numBlocksX + blockX) * blockSize;
+
+				switch (format)
+				{
+				case OKAY_TEXTURE_FORMAT_BC1:
+					decodeBC1Block(pBlock, block);
+					break;
+
+				case OKAY_TEXTURE_FORMAT_BC3:
+					decodeBC1Block(pBlock + 8, block);
+					decodeChannel(pBlock, 3, block);
+					break;
+
+				case OKAY_TEXTURE_FORMAT_BC4:
+					decodeChannel(pBlock, 0, block);
+					for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+					{
+						block[i][1] = block[i][2] = block[i][0];
+						block[i][3] = 255;
+					}
+					break;
+
+				case OKAY_TEXTURE_FORMAT_BC5:
+					decodeChannel(pBlock, 0, block);
+					decodeChannel(pBlock + 8, 1, block);
+					for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+					{
+						block[i][2] = 0;
+						block[i][3] = 255;
+					}
+					break;
+
+				default:
+					OKAY_ASSERT(false);
+					break;
+				}
+
+				storeBlock(block, width, height, blockX, blockY, pOutTextureData);
+			}
+		}
+	}
+
+	void compressMipChain(const TextureMipChain& mipChain, TextureFormat format, TextureMipChain& outChain)
+	{
+		OKAY_ASSERT(mipChain.format == OKAY_TEXTURE_FORMAT_RGBA8);
+
+		outChain.format = format;
+		outChain.levels = mipChain.levels;
+
+		uint64_t chainSize = 0;
+		for (uint32_t i = 0; i < outChain.getNumLevels(); i++)
+		{
+			outChain.levels[i].offset = chainSize;
+			chainSize += outChain.getLevelSize(i);
+		}
+
+		outChain.data.resize(chainSize);
+
+		for (uint32_t i = 0; i < outChain.getNumLevels(); i++)
+		{
+			const TextureMipLevel& srcLevel = mipChain.levels[i];
+			const TextureMipLevel& dstLevel = outChain.levels[i];
+
+			compressTextureLevel(mipChain.data.data() + srcLevel.offset, srcLevel.width, srcLevel.height, format, outChain.data.data() + dstLevel.offset);
+		}
+	}
+
+	void decodeAndGenerateMips(const TextureMipChain& mipChain, bool isSRGB, TextureMipChain& outChain)
+	{
+		const TextureMipLevel& fullLevel = mipChain.levels[0];
+
+		std::vector<uint8_t> textureData(getTextureLevelSize(OKAY_TEXTURE_FORMAT_RGBA8, fullLevel.width, fullLevel.height));
+		decompressTextureLevel(mipChain.data.data() + fullLevel.offset, fullLevel.width, fullLevel.height, mipChain.format, textureData.data());
+
+		TextureMipSettings mipSettings;
+		mipSettings.isSRGB = isSRGB;
+
+		generateMipChain(textureData.data(), fullLevel.width, fullLevel.height, mipSettings, outChain);
+	}
+}
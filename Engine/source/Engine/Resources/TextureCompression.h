@@ -0,0 +1,57 @@
+#pragma once
+
+#include "TextureMips.h"
+
+/*
+	Import time block compression of mip chains, every 4x4 block becomes 8 or 16 bytes instead of 64.
+
+	The format is picked per texture (selectTextureFormat): BC1 for opaque colour, BC3 for colour with alpha,
+	BC4 for grayscale (the SRV swizzles it to RRR1) and BC5 for normal maps, whose Z is rebuilt in sampleNormalMap.
+	Grayscale & opacity come from the source channel count when it says so, otherwise from the texels.
+	Textures whose full size isn't a multiple of 4 (D3D12 requires it of BC textures) or that aren't compressed
+	still only keep the channels they use: R8 instead of BC4, RG8 instead of BC5 & RGBA8 for the rest.
+
+	BC1 endpoints come from the principal axis of the block's colours & are refined with least squares on the picked indicies.
+	BC4 tries both the 8 & the 6 interpolant modes between the block's min & max and keeps the one with less error.
+	The decoders are there to measure the error of the encoders.
+*/
+
+namespace Okay
+{
+	// pTextureData is RGBA8, numSourceChannels is how many the file had (stbi_load's channels_in_file)
+	TextureFormat selectTextureFormat(const uint8_t* pTextureData, uint32_t width, uint32_t height, uint32_t numSourceChannels,
+		bool isColour, bool allowBlockCompression);
+
+	// pTextureData is RGBA8, pOutBlocks receives getTextureLevelSize(format, width, height) bytes. R8 & RG8 keep the first channels
+	void compressTextureLevel(const uint8_t* pTextureData, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pOutBlocks);
+
+	// Writes RGBA8, BC4 & R8 decode to RRR1 and BC5 & RG8 to RG01 like the GPU does
+	void decompressTextureLevel(const uint8_t* pBlocks, uint32_t width, uint32_t height, TextureFormat format, uint8_t* pOutTextureData);
+
+	// Compresses every level of an RGBA8 chain, RGBA8 just copies it
+	void compressMipChain(const TextureMipChain& mipChain, TextureFormat format, TextureMipChain& outChain);
+
+	// Decodes the full size of mipChain (any format) & generates an RGBA8 chain from it, for rebuilding the mips of a file that
+	// doesn't have them. compressMipChain encodes it in the original format again
+	void decodeAndGenerateMips(const TextureMipChain& mipChain, bool isSRGB, TextureMipChain& outChain);
+
+	// GPU size of the loaded textures vs the same textures as RGBA8
+	struct TextureMemoryReport
+	{
+		uint32_t numTextures[OKAY_TEXTURE_FORMAT_COUNT] = {};
+		uint64_t size = 0;
+		uint64_t rgba8Size = 0;
+		uint64_t skippedSize = 0; // Mips skipped for the texture quality (TextureQuality.h), not in size
+
+		inline void add(const TextureMipChain& mipChain)
+		{
+			numTextures[mipChain.format]++;
+
+			for (uint32_t i = 0; i < mipChain.getNumLevels(); i++)
+			{
+				size += mipChain.getLevelSize(i);
+				rgba8Size += getTextureLevelSize(OKAY_TEXTURE_FORMAT_RGBA8, mipChain.levels[i].width, mipChain.levels[i].height);
+			}
+		}
+	};
+}
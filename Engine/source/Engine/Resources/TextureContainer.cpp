@@ -0,0 +1,420 @@
+#include "TextureContainer.h"
+
+#include <cstring>
+#include <cctype>
+
+namespace Okay
+{
+	// D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION, also keeps the size math far from overflowing
+	static const uint32_t MAX_CONTAINER_TEXTURE_SIZE = 16384;
+
+	static bool fail(const char* pError, const char** pOutError)
+	{
+		if (pOutError)
+		{
+			*pOutError = pError;
+		}
+
+		return false;
+	}
+
+	template<typename T>
+	static T readValue(const uint8_t* pData)
+	{
+		T value;
+		memcpy(&value, pData, sizeof(T));
+		return value;
+	}
+
+	// Fills the level sizes & offsets, the data is copied by the parsers
+	static bool initializeMipChain(TextureFormat format, uint32_t width, uint32_t height, uint32_t numLevels, TextureMipChain& outChain, const char** pOutError)
+	{
+		if (width == 0 || height == 0 || width > MAX_CONTAINER_TEXTURE_SIZE || height > MAX_CONTAINER_TEXTURE_SIZE)
+		{
+			return fail("unsupported size", pOutError);
+		}
+
+		if (isBlockCompressed(format) && (width % 4 || height % 4))
+		{
+			return fail("block compressed size isn't a multiple of 4", pOutError);
+		}
+
+		uint32_t maxLevels = 1;
+		while ((glm::max(width, height) >> maxLevels) > 0)
+		{
+			maxLevels++;
+		}
+
+		if (numLevels == 0 || numLevels > maxLevels)
+		{
+			return fail("invalid mip count", pOutError);
+		}
+
+		outChain.format = format;
+		outChain.levels.resize(numLevels);
+
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < numLevels; i++)
+		{
+			TextureMipLevel& level = outChain.levels[i];
+			level.width = glm::max(width >> i, 1u);
+			level.height = glm::max(height >> i, 1u);
+			level.offset = offset;
+
+			offset += outChain.getLevelSize(i);
+		}
+
+		outChain.data.clear();
+		outChain.data.resize(offset);
+
+		return true;
+	}
+
+	bool isTextureContainerPath(const FilePath& path)
+	{
+		std::string extension = path.extension().string();
+		for (char& c : extension)
+		{
+			c = (char)tolower(c);
+		}
+
+		return extension == ".dds" || extension == ".ktx2";
+	}
+
+	bool parseTextureContainer(const uint8_t* pFileData, uint64_t fileSize, TextureMipChain& outChain, const char** pOutError)
+	{
+		static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		if (fileSize >= 4 && !memcmp(pFileData, "DDS ", 4))
+		{
+			return parseDDS(pFileData, fileSize, outChain, pOutError);
+		}
+
+		if (fileSize >= sizeof(KTX2_IDENTIFIER) && !memcmp(pFileData, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)))
+		{
+			return parseKTX2(pFileData, fileSize, outChain, pOutError);
+		}
+
+		return fail("not a DDS or KTX2 file", pOutError);
+	}
+
+
+	// --- DDS, https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+
+	static const uint32_t DDS_HEADER_SIZE = 124;
+	static const uint32_t DDS_PIXEL_FORMAT_SIZE = 32;
+	static const uint32_t DDS_DX10_HEADER_SIZE = 20;
+
+	static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	static const uint32_t DDPF_ALPHAPIXELS = 0x1;
+	static const uint32_t DDPF_FOURCC = 0x4;
+	static const uint32_t DDPF_RGB = 0x40;
+	static const uint32_t DDPF_LUMINANCE = 0x20000;
+	static const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+	static const uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+	static const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+	static const uint32_t DDS_MISC_TEXTURECUBE = 0x4;
+
+	static constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+	}
+
+	// DXGI_FORMAT values, kept here so the parser doesn't need the D3D headers
+	static TextureFormat getDXGITextureFormat(uint32_t dxgiFormat)
+	{
+		switch (dxgiFormat)
+		{
+		case 28: // R8G8B8A8_UNORM
+		case 29: // R8G8B8A8_UNORM_SRGB
+			return OKAY_TEXTURE_FORMAT_RGBA8;
+
+		case 49: // R8G8_UNORM
+			return OKAY_TEXTURE_FORMAT_RG8;
+
+		case 61: // R8_UNORM
+			return OKAY_TEXTURE_FORMAT_R8;
+
+		case 71: // BC1_UNORM
+		case 72: // BC1_UNORM_SRGB
+			return OKAY_TEXTURE_FORMAT_BC1;
+
+		case 77: // BC3_UNORM
+		case 78: // BC3_UNORM_SRGB
+			return OKAY_TEXTURE_FORMAT_BC3;
+
+		case 80: // BC4_UNORM
+			return OKAY_TEXTURE_FORMAT_BC4;
+
+		case 83: // BC5_UNORM
+			return OKAY_TEXTURE_FORMAT_BC5;
+
+		default:
+			return OKAY_TEXTURE_FORMAT_COUNT;
+		}
+	}
+
+	// Older writers (D3DX, nvtt, texconv without -dx10) describe the format with a FourCC or with channel masks
+	static TextureFormat getDDSPixelFormat(const uint8_t* pPixelFormat)
+	{
+		uint32_t flags = readValue<uint32_t>(pPixelFormat + 4);
+		uint32_t fourCC = readValue<uint32_t>(pPixelFormat + 8);
+		uint32_t bitCount = readValue<uint32_t>(pPixelFormat + 12);
+		uint32_t rMask = readValue<uint32_t>(pPixelFormat + 16);
+		uint32_t gMask = readValue<uint32_t>(pPixelFormat + 20);
+		uint32_t bMask = readValue<uint32_t>(pPixelFormat + 24);
+		uint32_t aMask = readValue<uint32_t>(pPixelFormat + 28);
+
+		if (flags & DDPF_FOURCC)
+		{
+			switch (fourCC)
+			{
+			case makeFourCC('D', 'X', 'T', '1'):
+				return OKAY_TEXTURE_FORMAT_BC1;
+
+			case makeFourCC('D', 'X', 'T', '5'):
+				return OKAY_TEXTURE_FORMAT_BC3;
+
+			case makeFourCC('A', 'T', 'I', '1'):
+			case makeFourCC('B', 'C', '4', 'U'):
+				return OKAY_TEXTURE_FORMAT_BC4;
+
+			case makeFourCC('A', 'T', 'I', '2'):
+			case makeFourCC('B', 'C', '5', 'U'):
+				return OKAY_TEXTURE_FORMAT_BC5;
+
+			default:
+				return OKAY_TEXTURE_FORMAT_COUNT;
+			}
+		}
+
+		// Only layouts that are already in memory order, BGRA & friends would need swizzling
+		if ((flags & DDPF_RGB) && (flags & DDPF_ALPHAPIXELS) && bitCount == 32 &&
+			rMask == 0x000000FF && gMask == 0x0000FF00 && bMask == 0x00FF0000 && aMask == 0xFF000000)
+		{
+			return OKAY_TEXTURE_FORMAT_RGBA8;
+		}
+
+		if ((flags & DDPF_RGB) && !(flags & DDPF_ALPHAPIXELS) && bitCount == 16 && rMask == 0x00FF && gMask == 0xFF00 && bMask == 0)
+		{
+			return OKAY_TEXTURE_FORMAT_RG8;
+		}
+
+		if ((flags & (DDPF_LUMINANCE | DDPF_RGB)) && !(flags & DDPF_ALPHAPIXELS) && bitCount == 8 && rMask == 0xFF)
+		{
+			return OKAY_TEXTURE_FORMAT_R8;
+		}
+
+		return OKAY_TEXTURE_FORMAT_COUNT;
+	}
+
+	bool parseDDS(const uint8_t* pFileData, uint64_t fileSize, TextureMipChain& outChain, const char** pOutError)
+	{
+		if (fileSize < 4 + DDS_HEADER_SIZE || memcmp(pFileData, "DDS ", 4))
+		{
+			return fail("truncated DDS header", pOutError);
+		}
+
+		const uint8_t* pHeader = pFileData + 4;
+		const uint8_t* pPixelFormat = pHeader + 72;
+
+		if (readValue<uint32_t>(pHeader) != DDS_HEADER_SIZE || readValue<uint32_t>(pPixelFormat) != DDS_PIXEL_FORMAT_SIZE)
+		{
+			return fail("invalid DDS header size", pOutError);
+		}
+
+		uint32_t flags = readValue<uint32_t>(pHeader + 4);
+		uint32_t height = readValue<uint32_t>(pHeader + 8);
+		uint32_t width = readValue<uint32_t>(pHeader + 12);
+		uint32_t depth = readValue<uint32_t>(pHeader + 20);
+		uint32_t numMips = readValue<uint32_t>(pHeader + 24);
+		uint32_t caps2 = readValue<uint32_t>(pHeader + 108);
+
+		// The mip count is optional, without the flag there's only the full size & importTexture generates the rest
+		if (!(flags & DDSD_MIPMAPCOUNT) || numMips == 0)
+		{
+			numMips = 1;
+		}
+
+		if ((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) || depth > 1)
+		{
+			return fail("DDS cubes & volumes aren't supported", pOutError);
+		}
+
+		uint64_t dataOffset = 4 + DDS_HEADER_SIZE;
+		TextureFormat format = OKAY_TEXTURE_FORMAT_COUNT;
+
+		uint32_t pixelFormatFlags = readValue<uint32_t>(pPixelFormat + 4);
+		uint32_t fourCC = readValue<uint32_t>(pPixelFormat + 8);
+
+		if ((pixelFormatFlags & DDPF_FOURCC) && fourCC == makeFourCC('D', 'X', '1', '0'))
+		{
+			if (fileSize < dataOffset + DDS_DX10_HEADER_SIZE)
+			{
+				return fail("truncated DDS DX10 header", pOutError);
+			}
+
+			const uint8_t* pDX10Header = pFileData + dataOffset;
+			uint32_t dxgiFormat = readValue<uint32_t>(pDX10Header);
+			uint32_t dimension = readValue<uint32_t>(pDX10Header + 4);
+			uint32_t miscFlags = readValue<uint32_t>(pDX10Header + 8);
+			uint32_t arraySize = readValue<uint32_t>(pDX10Header + 12);
+
+			if (dimension != DDS_DIMENSION_TEXTURE2D || (miscFlags & DDS_MISC_TEXTURECUBE) || arraySize != 1)
+			{
+				return fail("DDS arrays, cubes & non 2D textures aren't supported", pOutError);
+			}
+
+			dataOffset += DDS_DX10_HEADER_SIZE;
+			format = getDXGITextureFormat(dxgiFormat);
+		}
+		else
+		{
+			format = getDDSPixelFormat(pPixelFormat);
+		}
+
+		if (format == OKAY_TEXTURE_FORMAT_COUNT)
+		{
+			return fail("unsupported DDS format", pOutError);
+		}
+
+		if (!initializeMipChain(format, width, height, numMips, outChain, pOutError))
+		{
+			return false;
+		}
+
+		// The mips are tightly packed after the header, same as TextureMipChain
+		if (fileSize - dataOffset < (uint64_t)outChain.data.size())
+		{
+			return fail("truncated DDS data", pOutError);
+		}
+
+		memcpy(outChain.data.data(), pFileData + dataOffset, outChain.data.size());
+
+		return true;
+	}
+
+
+	// --- KTX2, https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+
+	static const uint32_t KTX2_HEADER_SIZE = 80; // Identifier, header & index, the level index comes after
+	static const uint32_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+	// VkFormat values
+	static TextureFormat getVkTextureFormat(uint32_t vkFormat)
+	{
+		switch (vkFormat)
+		{
+		case 9: // R8_UNORM
+		case 15: // R8_SRGB
+			return OKAY_TEXTURE_FORMAT_R8;
+
+		case 16: // R8G8_UNORM
+		case 22: // R8G8_SRGB
+			return OKAY_TEXTURE_FORMAT_RG8;
+
+		case 37: // R8G8B8A8_UNORM
+		case 43: // R8G8B8A8_SRGB
+			return OKAY_TEXTURE_FORMAT_RGBA8;
+
+		case 131: // BC1_RGB_UNORM_BLOCK
+		case 132: // BC1_RGB_SRGB_BLOCK
+		case 133: // BC1_RGBA_UNORM_BLOCK
+		case 134: // BC1_RGBA_SRGB_BLOCK
+			return OKAY_TEXTURE_FORMAT_BC1;
+
+		case 137: // BC3_UNORM_BLOCK
+		case 138: // BC3_SRGB_BLOCK
+			return OKAY_TEXTURE_FORMAT_BC3;
+
+		case 139: // BC4_UNORM_BLOCK
+			return OKAY_TEXTURE_FORMAT_BC4;
+
+		case 141: // BC5_UNORM_BLOCK
+			return OKAY_TEXTURE_FORMAT_BC5;
+
+		default:
+			return OKAY_TEXTURE_FORMAT_COUNT;
+		}
+	}
+
+	bool parseKTX2(const uint8_t* pFileData, uint64_t fileSize, TextureMipChain& outChain, const char** pOutError)
+	{
+		if (fileSize < KTX2_HEADER_SIZE)
+		{
+			return fail("truncated KTX2 header", pOutError);
+		}
+
+		uint32_t vkFormat = readValue<uint32_t>(pFileData + 12);
+		uint32_t width = readValue<uint32_t>(pFileData + 20);
+		uint32_t height = readValue<uint32_t>(pFileData + 24);
+		uint32_t depth = readValue<uint32_t>(pFileData + 28);
+		uint32_t numLayers = readValue<uint32_t>(pFileData + 32);
+		uint32_t numFaces = readValue<uint32_t>(pFileData + 36);
+		uint32_t numLevels = readValue<uint32_t>(pFileData + 40);
+		uint32_t supercompressionScheme = readValue<uint32_t>(pFileData + 44);
+
+		if (supercompressionScheme != 0)
+		{
+			return fail("supercompressed KTX2 isn't supported", pOutError);
+		}
+
+		if (height == 0 || depth != 0 || numLayers != 0 || numFaces != 1)
+		{
+			return fail("KTX2 arrays, cubes & non 2D textures aren't supported", pOutError);
+		}
+
+		TextureFormat format = getVkTextureFormat(vkFormat);
+		if (format == OKAY_TEXTURE_FORMAT_COUNT)
+		{
+			return fail("unsupported KTX2 format", pOutError);
+		}
+
+		// 0 asks the loader to generate the mips, only the full size is in the file then (importTexture does)
+		numLevels = glm::max(numLevels, 1u);
+		if (numLevels > 32 || fileSize - KTX2_HEADER_SIZE < (uint64_t)numLevels * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+		{
+			return fail("truncated KTX2 level index", pOutError);
+		}
+
+		if (!initializeMipChain(format, width, height, numLevels, outChain, pOutError))
+		{
+			return false;
+		}
+
+		// The index is ordered from the full size down, the data in the file usually isn't
+		for (uint32_t i = 0; i < numLevels; i++)
+		{
+			const uint8_t* pLevelIndex = pFileData + KTX2_HEADER_SIZE + (uint64_t)i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+			uint64_t byteOffset = readValue<uint64_t>(pLevelIndex);
+			uint64_t byteLength = readValue<uint64_t>(pLevelIndex + 8);
+
+			uint64_t levelSize = outChain.getLevelSize(i);
+			if (byteLength != levelSize)
+			{
+				return fail("KTX2 level size doesn't match its format", pOutError);
+			}
+
+			if (byteOffset > fileSize || fileSize - byteOffset < byteLength)
+			{
+				return fail("truncated KTX2 data", pOutError);
+			}
+
+			memcpy(outChain.data.data() + outChain.levels[i].offset, pFileData + byteOffset, levelSize);
+		}
+
+		return true;
+	}
+
+	bool loadTextureContainer(const FilePath& path, TextureMipChain& outChain, const char** pOutError)
+	{
+		std::string fileData;
+		if (!readBinary(path, fileData))
+		{
+			return fail("couldn't open the file", pOutError);
+		}
+
+		return parseTextureContainer((const uint8_t*)fileData.data(), fileData.size(), outChain, pOutError);
+	}
+}
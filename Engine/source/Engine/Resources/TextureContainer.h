@@ -0,0 +1,32 @@
+#pragma once
+
+#include "TextureMips.h"
+
+/*
+	DDS & KTX2 textures, their mips & block compression were already done offline so the payload is used as is,
+	no stbi_load, generateMipChain or BC encoding. The levels are copied into a TextureMipChain like any other texture
+	& uploaded through the same GetCopyableFootprints path. Files with only the full size (a KTX2 levelCount of 0, a DDS without
+	a mip count) are parsed as one level, importTexture decodes it & generates the mips (decodeAndGenerateMips).
+
+	Only formats with a TextureFormat are accepted: BC1, BC3, BC4, BC5, R8, RG8 & RGBA8 (UNORM or SRGB, whether a texture
+	is colour still comes from loadTexture). DDS can use the legacy FourCC / pixel format header or the DX10 one,
+	KTX2 can't be supercompressed (Basis, zstd) since that would need transcoding. Only single 2D images, no arrays, cubes or volumes.
+	Block compressed textures need their full size to be a multiple of 4 like D3D12 wants.
+
+	Every size & offset in the header is checked against the file before anything is read, a malformed file returns false
+	& a short reason instead of asserting so bad files can be reported.
+*/
+
+namespace Okay
+{
+	// By extension, .dds & .ktx2
+	bool isTextureContainerPath(const FilePath& path);
+
+	// Picks the parser from the magic number, pOutError is set when it returns false
+	bool parseTextureContainer(const uint8_t* pFileData, uint64_t fileSize, TextureMipChain& outChain, const char** pOutError = nullptr);
+
+	bool parseDDS(const uint8_t* pFileData, uint64_t fileSize, TextureMipChain& outChain, const char** pOutError = nullptr);
+	bool parseKTX2(const uint8_t* pFileData, uint64_t fileSize, TextureMipChain& outChain, const char** pOutError = nullptr);
+
+	bool loadTextureContainer(const FilePath& path, TextureMipChain& outChain, const char** pOutError = nullptr);
+}
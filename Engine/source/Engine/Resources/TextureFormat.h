@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+namespace Okay
+{
+	// CPU side texture formats, mapped to DXGI formats by the Renderer. See TextureCompression.h for the BC ones
+	enum TextureFormat : uint32_t
+	{
+		OKAY_TEXTURE_FORMAT_RGBA8 = 0,
+		OKAY_TEXTURE_FORMAT_BC1 = 1, // Opaque colour
+		OKAY_TEXTURE_FORMAT_BC3 = 2, // Colour with alpha
+		OKAY_TEXTURE_FORMAT_BC4 = 3, // Grayscale, sampled as RRR1
+		OKAY_TEXTURE_FORMAT_BC5 = 4, // Normal maps, Z is rebuilt in the shader
+		OKAY_TEXTURE_FORMAT_R8 = 5, // Uncompressed BC4
+		OKAY_TEXTURE_FORMAT_RG8 = 6, // Uncompressed BC5
+
+		OKAY_TEXTURE_FORMAT_COUNT,
+	};
+
+	// Bytes per texel, 0 for block compressed formats
+	inline uint32_t getTextureFormatTexelSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case OKAY_TEXTURE_FORMAT_RGBA8:
+			return 4;
+
+		case OKAY_TEXTURE_FORMAT_R8:
+			return 1;
+
+		case OKAY_TEXTURE_FORMAT_RG8:
+			return 2;
+
+		default:
+			return 0;
+		}
+	}
+
+	// Bytes per 4x4 block, 0 for uncompressed formats
+	inline uint32_t getTextureFormatBlockSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case OKAY_TEXTURE_FORMAT_BC1:
+		case OKAY_TEXTURE_FORMAT_BC4:
+			return 8;
+
+		case OKAY_TEXTURE_FORMAT_BC3:
+		case OKAY_TEXTURE_FORMAT_BC5:
+			return 16;
+
+		default:
+			return 0;
+		}
+	}
+
+	inline bool isBlockCompressed(TextureFormat format)
+	{
+		return getTextureFormatBlockSize(format) != 0;
+	}
+
+	// Row size & number of rows as D3D12 copies them, blocks are rows of 4 texels
+	inline uint64_t getTextureRowSize(TextureFormat format, uint32_t width)
+	{
+		uint32_t blockSize = getTextureFormatBlockSize(format);
+		return blockSize ? (uint64_t)((width + 3) / 4) * blockSize : (uint64_t)width * getTextureFormatTexelSize(format);
+	}
+
+	inline uint32_t getTextureNumRows(TextureFormat format, uint32_t height)
+	{
+		return isBlockCompressed(format) ? (height + 3) / 4 : height;
+	}
+
+	inline uint64_t getTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+	{
+		return getTextureRowSize(format, width) * getTextureNumRows(format, height);
+	}
+}
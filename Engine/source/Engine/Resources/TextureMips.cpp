@@ -0,0 +1,301 @@
+#include "TextureMips.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define OKAY_TEXTURE_MIPS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Okay
+{
+	static const uint32_t SRGB_ENCODE_TABLE_SIZE = 65536; // Fine enough that the darkest sRGB steps still round right
+
+	struct SRGBTables
+	{
+		SRGBTables()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				float value = i / 255.f;
+				decode[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (uint32_t i = 0; i < SRGB_ENCODE_TABLE_SIZE; i++)
+			{
+				float linear = i / (float)(SRGB_ENCODE_TABLE_SIZE - 1);
+				float value = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.f / 2.4f) - 0.055f;
+				encode[i] = (uint8_t)lrintf(glm::clamp(value, 0.f, 1.f) * 255.f);
+			}
+		}
+
+		float decode[256] = {};
+		uint8_t encode[SRGB_ENCODE_TABLE_SIZE] = {};
+	};
+
+	static const SRGBTables& getSRGBTables()
+	{
+		static const SRGBTables tables;
+		return tables;
+	}
+
+	// Source texels [first, first + numTaps) of one output texel along one axis
+	struct FilterTaps
+	{
+		uint32_t first = 0;
+		uint32_t numTaps = 0;
+		float weights[3] = {};
+	};
+
+	static void computeFilterTaps(uint32_t srcSize, uint32_t dstSize, std::vector<FilterTaps>& outTaps)
+	{
+		outTaps.resize(dstSize);
+
+		for (uint32_t i = 0; i < dstSize; i++)
+		{
+			FilterTaps& taps = outTaps[i];
+
+			if (srcSize == 1)
+			{
+				taps.first = 0;
+				taps.numTaps = 1;
+				taps.weights[0] = 1.f;
+			}
+			else if (srcSize % 2 == 0)
+			{
+				taps.first = i * 2;
+				taps.numTaps = 2;
+				taps.weights[0] = 0.5f;
+				taps.weights[1] = 0.5f;
+			}
+			else
+			{
+				// Output texel i covers [i * n / m, (i + 1) * n / m) of the source, which cuts into texels 2i & 2i + 2
+				float invSrcSize = 1.f / srcSize;
+
+				taps.first = i * 2;
+				taps.numTaps = 3;
+				taps.weights[0] = (dstSize - i) * invSrcSize;
+				taps.weights[1] = dstSize * invSrcSize;
+				taps.weights[2] = (i + 1) * invSrcSize;
+			}
+		}
+	}
+
+	static void decodeRow(const uint8_t* pRow, uint32_t width, bool isSRGB, glm::vec4* pOutRow)
+	{
+		const float* pDecode = getSRGBTables().decode;
+		static const float BYTE_TO_FLOAT = 1.f / 255.f;
+
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const uint8_t* pTexel = pRow + x * 4;
+
+			if (isSRGB)
+			{
+				pOutRow[x] = glm::vec4(pDecode[pTexel[0]], pDecode[pTexel[1]], pDecode[pTexel[2]], pTexel[3] * BYTE_TO_FLOAT);
+			}
+			else
+			{
+				pOutRow[x] = glm::vec4(pTexel[0], pTexel[1], pTexel[2], pTexel[3]) * BYTE_TO_FLOAT;
+			}
+		}
+	}
+
+	static void encodeRow(const glm::vec4* pRow, uint32_t width, bool isSRGB, bool useSIMD, uint8_t* pOutRow)
+	{
+		const uint8_t* pEncode = getSRGBTables().encode;
+
+		// sRGB channels index the encode table, the rest are rounded to 8 bits
+		glm::vec4 scale = isSRGB ? glm::vec4((float)(SRGB_ENCODE_TABLE_SIZE - 1), (float)(SRGB_ENCODE_TABLE_SIZE - 1), (float)(SRGB_ENCODE_TABLE_SIZE - 1), 255.f) : glm::vec4(255.f);
+
+		for (uint32_t x = 0; x < width; x++)
+		{
+			int32_t values[4] = {};
+
+#ifdef OKAY_TEXTURE_MIPS_SSE2
+			if (useSIMD)
+			{
+				__m128 texel = _mm_loadu_ps(&pRow[x].x);
+				texel = _mm_min_ps(_mm_max_ps(texel, _mm_setzero_ps()), _mm_set1_ps(1.f));
+				_mm_storeu_si128((__m128i*)values, _mm_cvtps_epi32(_mm_mul_ps(texel, _mm_loadu_ps(&scale.x))));
+			}
+			else
+#endif
+			{
+				glm::vec4 texel = glm::clamp(pRow[x], glm::vec4(0.f), glm::vec4(1.f)) * scale;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					values[c] = (int32_t)lrintf(texel[c]); // Round to nearest even, like _mm_cvtps_epi32
+				}
+			}
+
+			uint8_t* pTexel = pOutRow + x * 4;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				pTexel[c] = isSRGB ? pEncode[values[c]] : (uint8_t)values[c];
+			}
+			pTexel[3] = (uint8_t)values[3];
+		}
+	}
+
+	// Vertical taps into pScratch (a full source row), then horizontal taps into pOutRow. pRows are the source rows of yTaps
+	static void filterRow(const glm::vec4* const* pRows, const FilterTaps& yTaps, const std::vector<FilterTaps>& xTaps,
+		uint32_t srcWidth, bool useSIMD, glm::vec4* pScratch, glm::vec4* pOutRow)
+	{
+		uint32_t dstWidth = (uint32_t)xTaps.size();
+
+#ifdef OKAY_TEXTURE_MIPS_SSE2
+		if (useSIMD)
+		{
+			__m128 yWeights[3] = { _mm_set1_ps(yTaps.weights[0]), _mm_set1_ps(yTaps.weights[1]), _mm_set1_ps(yTaps.weights[2]) };
+
+			for (uint32_t x = 0; x < srcWidth; x++)
+			{
+				__m128 sum = _mm_mul_ps(_mm_loadu_ps(&pRows[0][x].x), yWeights[0]);
+				for (uint32_t k = 1; k < yTaps.numTaps; k++)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&pRows[k][x].x), yWeights[k]));
+				}
+
+				_mm_storeu_ps(&pScratch[x].x, sum);
+			}
+
+			for (uint32_t x = 0; x < dstWidth; x++)
+			{
+				const FilterTaps& taps = xTaps[x];
+				const glm::vec4* pTexels = pScratch + taps.first;
+
+				__m128 sum = _mm_mul_ps(_mm_loadu_ps(&pTexels[0].x), _mm_set1_ps(taps.weights[0]));
+				for (uint32_t k = 1; k < taps.numTaps; k++)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&pTexels[k].x), _mm_set1_ps(taps.weights[k])));
+				}
+
+				_mm_storeu_ps(&pOutRow[x].x, sum);
+			}
+
+			return;
+		}
+#endif
+
+		for (uint32_t x = 0; x < srcWidth; x++)
+		{
+			glm::vec4 sum = pRows[0][x] * yTaps.weights[0];
+			for (uint32_t k = 1; k < yTaps.numTaps; k++)
+			{
+				sum = sum + pRows[k][x] * yTaps.weights[k];
+			}
+
+			pScratch[x] = sum;
+		}
+
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			const FilterTaps& taps = xTaps[x];
+			const glm::vec4* pTexels = pScratch + taps.first;
+
+			glm::vec4 sum = pTexels[0] * taps.weights[0];
+			for (uint32_t k = 1; k < taps.numTaps; k++)
+			{
+				sum = sum + pTexels[k] * taps.weights[k];
+			}
+
+			pOutRow[x] = sum;
+		}
+	}
+
+	void allocateMipChain(uint32_t width, uint32_t height, const TextureMipSettings& settings, TextureMipChain& outChain)
+	{
+		OKAY_ASSERT(width && height);
+
+		uint32_t numLevels = glm::min(getNumMipLevels(width, height), glm::max(settings.maxLevels, 1u));
+
+		outChain.format = OKAY_TEXTURE_FORMAT_RGBA8;
+		outChain.levels.resize(numLevels);
+
+		uint64_t chainSize = 0;
+		for (uint32_t i = 0; i < numLevels; i++)
+		{
+			TextureMipLevel& level = outChain.levels[i];
+			level.width = glm::max(width >> i, 1u);
+			level.height = glm::max(height >> i, 1u);
+			level.offset = chainSize;
+
+			chainSize += outChain.getLevelSize(i);
+		}
+
+		outChain.data.resize(chainSize);
+	}
+
+	void generateMipChain(const uint8_t* pTextureData, uint32_t width, uint32_t height, const TextureMipSettings& settings, TextureMipChain& outChain)
+	{
+		OKAY_ASSERT(pTextureData);
+
+		allocateMipChain(width, height, settings, outChain);
+		memcpy(outChain.data.data(), pTextureData, (size_t)width * height * 4);
+
+		generateMipLevels(settings, outChain);
+	}
+
+	void generateMipLevels(const TextureMipSettings& settings, TextureMipChain& mipChain)
+	{
+		OKAY_ASSERT(mipChain.format == OKAY_TEXTURE_FORMAT_RGBA8 && mipChain.getNumLevels());
+
+		const uint8_t* pTextureData = mipChain.data.data();
+		uint32_t width = mipChain.levels[0].width;
+		uint32_t numLevels = mipChain.getNumLevels();
+
+		bool useSIMD = !settings.forceScalar;
+
+		// Level 0 rows are decoded when they're needed, so only the float copy of level 1 & down is ever stored
+		std::vector<glm::vec4> srcTexels;
+		std::vector<glm::vec4> dstTexels;
+		std::vector<glm::vec4> decodedRows[3];
+		std::vector<glm::vec4> scratch(width);
+
+		std::vector<FilterTaps> xTaps;
+		std::vector<FilterTaps> yTaps;
+
+		for (uint32_t i = 1; i < numLevels; i++)
+		{
+			const TextureMipLevel& srcLevel = mipChain.levels[i - 1];
+			const TextureMipLevel& dstLevel = mipChain.levels[i];
+
+			computeFilterTaps(srcLevel.width, dstLevel.width, xTaps);
+			computeFilterTaps(srcLevel.height, dstLevel.height, yTaps);
+
+			dstTexels.resize((size_t)dstLevel.width * dstLevel.height);
+
+			for (uint32_t y = 0; y < dstLevel.height; y++)
+			{
+				const FilterTaps& rowTaps = yTaps[y];
+
+				const glm::vec4* pRows[3] = {};
+				for (uint32_t k = 0; k < rowTaps.numTaps; k++)
+				{
+					uint32_t srcY = rowTaps.first + k;
+
+					if (i == 1)
+					{
+						decodedRows[k].resize(srcLevel.width);
+						decodeRow(pTextureData + (size_t)srcY * srcLevel.width * 4, srcLevel.width, settings.isSRGB, decodedRows[k].data());
+						pRows[k] = decodedRows[k].data();
+					}
+					else
+					{
+						pRows[k] = srcTexels.data() + (size_t)srcY * srcLevel.width;
+					}
+				}
+
+				glm::vec4* pDstRow = dstTexels.data() + (size_t)y * dstLevel.width;
+				filterRow(pRows, rowTaps, xTaps, srcLevel.width, useSIMD, scratch.data(), pDstRow);
+
+				encodeRow(pDstRow, dstLevel.width, settings.isSRGB, useSIMD, mipChain.data.data() + dstLevel.offset + (size_t)y * dstLevel.width * 4);
+			}
+
+			srcTexels.swap(dstTexels);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "TextureFormat.h"
+
+#include <vector>
+
+/*
+	Import time mip chains for RGBA8 textures, so the full chain is uploaded in one go instead of being generated on the GPU.
+
+	Every level halves the size (rounded down, at least 1) with a box filter over the texels the pixel covers. Odd sizes
+	use 3 taps weighted by how much of each texel is covered, so non power of two textures don't shift or drop texels.
+	Colour textures are filtered in linear space and encoded back to sRGB, alpha & data textures (normal maps) are filtered as is.
+
+	Levels are filtered from the float version of the level before, not the 8 bit one, so rounding doesn't build up down the chain.
+	The filter runs on one float4 texel per SSE2 register, the scalar path gives the same result & is used to check it.
+*/
+
+namespace Okay
+{
+	struct TextureMipLevel
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint64_t offset = 0; // Into TextureMipChain::data
+	};
+
+	// The levels are tightly packed after each other from the full size down, generateMipChain gives RGBA8 (see TextureCompression.h for BC)
+	struct TextureMipChain
+	{
+		TextureFormat format = OKAY_TEXTURE_FORMAT_RGBA8;
+
+		std::vector<uint8_t> data;
+		std::vector<TextureMipLevel> levels;
+
+		inline uint32_t getNumLevels() const { return (uint32_t)levels.size(); }
+
+		inline uint64_t getLevelSize(uint32_t levelIdx) const
+		{
+			return getTextureLevelSize(format, levels[levelIdx].width, levels[levelIdx].height);
+		}
+	};
+
+	struct TextureMipSettings
+	{
+		bool isSRGB = true; // False for normal maps & other data
+		uint32_t maxLevels = UINT32_MAX;
+		bool forceScalar = false; // Skips SSE2, for checking it against the scalar path
+	};
+
+	// Down to 1x1
+	inline uint32_t getNumMipLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t numLevels = 1;
+		while (width > 1 || height > 1)
+		{
+			width = glm::max(width / 2, 1u);
+			height = glm::max(height / 2, 1u);
+			numLevels++;
+		}
+
+		return numLevels;
+	}
+
+	void generateMipChain(const uint8_t* pTextureData, uint32_t width, uint32_t height, const TextureMipSettings& settings, TextureMipChain& outChain);
+
+	// generateMipChain in two steps so the full size can be written straight into the chain (decodeTga) instead of copied:
+	// allocateMipChain sizes the levels & generateMipLevels fills everything after the full size from it
+	void allocateMipChain(uint32_t width, uint32_t height, const TextureMipSettings& settings, TextureMipChain& outChain);
+	void generateMipLevels(const TextureMipSettings& settings, TextureMipChain& mipChain);
+}
@@ -0,0 +1,137 @@
+#include "TextureQuality.h"
+#include "TextureCompression.h"
+
+namespace Okay
+{
+	TextureQualitySettings getTextureQualitySettings(TextureQuality quality)
+	{
+		TextureQualitySettings settings;
+
+		switch (quality)
+		{
+		case OKAY_TEXTURE_QUALITY_MEDIUM:
+			settings.numSkippedMips[OKAY_TEXTURE_CATEGORY_COLOUR] = 1;
+			settings.numSkippedMips[OKAY_TEXTURE_CATEGORY_DATA] = 1;
+			break;
+
+		case OKAY_TEXTURE_QUALITY_LOW:
+			settings.numSkippedMips[OKAY_TEXTURE_CATEGORY_COLOUR] = 2;
+			settings.numSkippedMips[OKAY_TEXTURE_CATEGORY_DATA] = 1;
+			break;
+
+		default:
+			break;
+		}
+
+		return settings;
+	}
+
+	const char* getTextureQualityName(TextureQuality quality)
+	{
+		static const char* QUALITY_NAMES[OKAY_TEXTURE_QUALITY_COUNT] = { "High", "Medium", "Low" };
+		return quality < OKAY_TEXTURE_QUALITY_COUNT ? QUALITY_NAMES[quality] : "Unknown";
+	}
+
+	TextureQuality selectTextureQuality(uint64_t videoMemorySize)
+	{
+		static const uint64_t GIGABYTE = 1024ull * 1024 * 1024;
+
+		// Integrated GPUs report little to no dedicated memory
+		if (videoMemorySize <= 2 * GIGABYTE)
+		{
+			return OKAY_TEXTURE_QUALITY_LOW;
+		}
+
+		if (videoMemorySize <= 4 * GIGABYTE)
+		{
+			return OKAY_TEXTURE_QUALITY_MEDIUM;
+		}
+
+		return OKAY_TEXTURE_QUALITY_HIGH;
+	}
+
+	uint32_t getNumSkippableMips(uint32_t width, uint32_t height, uint32_t numMips, uint32_t minSize, bool keepBlockAligned)
+	{
+		uint32_t numSkippable = 0;
+		while (numSkippable < numMips)
+		{
+			uint32_t nextWidth = glm::max(width >> (numSkippable + 1), 1u);
+			uint32_t nextHeight = glm::max(height >> (numSkippable + 1), 1u);
+
+			if (glm::max(nextWidth, nextHeight) < minSize || (keepBlockAligned && (nextWidth % 4 || nextHeight % 4)))
+			{
+				break;
+			}
+
+			numSkippable++;
+		}
+
+		return numSkippable;
+	}
+
+	void skipTextureMips(TextureMipChain& mipChain, uint32_t numMips)
+	{
+		OKAY_ASSERT(numMips < mipChain.getNumLevels());
+
+		if (numMips == 0)
+		{
+			return;
+		}
+
+		uint64_t skippedSize = mipChain.levels[numMips].offset;
+
+		mipChain.data.erase(mipChain.data.begin(), mipChain.data.begin() + skippedSize);
+		mipChain.levels.erase(mipChain.levels.begin(), mipChain.levels.begin() + numMips);
+
+		for (TextureMipLevel& level : mipChain.levels)
+		{
+			level.offset -= skippedSize;
+		}
+
+		// Frees the skipped levels, not just hides them
+		mipChain.data.shrink_to_fit();
+	}
+
+	uint64_t getSkippedMipsSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t numMips)
+	{
+		uint64_t skippedSize = 0;
+		for (uint32_t i = 0; i < numMips; i++)
+		{
+			skippedSize += getTextureLevelSize(format, glm::max(width >> i, 1u), glm::max(height >> i, 1u));
+		}
+
+		return skippedSize;
+	}
+
+	uint32_t applyTextureQuality(TextureMipChain& mipChain, bool isSRGB, const TextureQualitySettings& settings, bool keepBlockAligned)
+	{
+		TextureMipLevel fullLevel = mipChain.levels[0];
+		keepBlockAligned |= isBlockCompressed(mipChain.format);
+
+		uint32_t numMips = getNumSkippableMips(fullLevel.width, fullLevel.height, settings.numSkippedMips[getTextureCategory(isSRGB)], settings.minSize, keepBlockAligned);
+		if (numMips == 0)
+		{
+			return 0;
+		}
+
+		// Not enough mips in the file, build the chain from the full size
+		if (numMips >= mipChain.getNumLevels())
+		{
+			TextureMipChain rgba8Chain;
+			decodeAndGenerateMips(mipChain, isSRGB, rgba8Chain);
+
+			// Only the kept levels are compressed again
+			skipTextureMips(rgba8Chain, numMips);
+
+			TextureMipChain keptChain;
+			compressMipChain(rgba8Chain, mipChain.format, keptChain);
+			mipChain = std::move(keptChain);
+
+			return numMips;
+		}
+
+		skipTextureMips(mipChain, numMips);
+
+		return numMips;
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "TextureMips.h"
+
+/*
+	Texture quality tiers for machines with less video memory, lower tiers skip the most detailed mips of every texture
+	at import so they're never compressed, allocated or uploaded. Colour & data textures (normal maps) skip their own
+	number of mips per tier, since losing detail in one is more visible than in the other.
+
+	Skipping stops at TextureQualitySettings::minSize on the longest side, & for block compressed textures before a full size
+	that isn't a multiple of 4 (D3D12 wants that of BC textures). Files with fewer mips than are skipped (a DDS / KTX2 with
+	only the full size) are downsampled on the CPU first, BC ones are decoded to RGBA8 for it & compressed again.
+*/
+
+namespace Okay
+{
+	enum TextureQuality : uint32_t
+	{
+		OKAY_TEXTURE_QUALITY_HIGH = 0, // Full size
+		OKAY_TEXTURE_QUALITY_MEDIUM = 1,
+		OKAY_TEXTURE_QUALITY_LOW = 2,
+
+		OKAY_TEXTURE_QUALITY_COUNT,
+	};
+
+	enum TextureCategory : uint32_t
+	{
+		OKAY_TEXTURE_CATEGORY_COLOUR = 0,
+		OKAY_TEXTURE_CATEGORY_DATA = 1, // Normal maps & other linear textures
+
+		OKAY_TEXTURE_CATEGORY_COUNT,
+	};
+
+	struct TextureQualitySettings
+	{
+		uint32_t numSkippedMips[OKAY_TEXTURE_CATEGORY_COUNT] = {};
+		uint32_t minSize = 64; // Textures smaller than this already are left alone
+	};
+
+	// Same split as TextureMipSettings::isSRGB
+	inline TextureCategory getTextureCategory(bool isSRGB)
+	{
+		return isSRGB ? OKAY_TEXTURE_CATEGORY_COLOUR : OKAY_TEXTURE_CATEGORY_DATA;
+	}
+
+	TextureQualitySettings getTextureQualitySettings(TextureQuality quality);
+	const char* getTextureQualityName(TextureQuality quality);
+
+	// Picks the tier from the adapter's dedicated video memory
+	TextureQuality selectTextureQuality(uint64_t videoMemorySize);
+
+	// How many levels can be skipped from a texture of this size, at most numMips
+	uint32_t getNumSkippableMips(uint32_t width, uint32_t height, uint32_t numMips, uint32_t minSize, bool keepBlockAligned);
+
+	// Removes the numMips most detailed levels, the chain needs more levels than that
+	void skipTextureMips(TextureMipChain& mipChain, uint32_t numMips);
+
+	// Skips the mips settings asks for, keepBlockAligned is for RGBA8 chains that will be block compressed afterwards.
+	// Returns the number of skipped mips
+	uint32_t applyTextureQuality(TextureMipChain& mipChain, bool isSRGB, const TextureQualitySettings& settings, bool keepBlockAligned);
+
+	// Size the numMips most detailed levels of a width x height texture would have had
+	uint64_t getSkippedMipsSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t numMips);
+}
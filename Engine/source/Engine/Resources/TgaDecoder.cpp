@@ -0,0 +1,327 @@
+#include "TgaDecoder.h"
+
+#include <cstring>
+#include <cctype>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define OKAY_TGA_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Okay
+{
+	static const uint32_t TGA_HEADER_SIZE = 18;
+
+	static const uint8_t TGA_TYPE_TRUE_COLOUR = 2;
+	static const uint8_t TGA_TYPE_GRAYSCALE = 3;
+	static const uint8_t TGA_TYPE_RLE_TRUE_COLOUR = 10;
+	static const uint8_t TGA_TYPE_RLE_GRAYSCALE = 11;
+
+	static const uint8_t TGA_DESCRIPTOR_RIGHT_TO_LEFT = 0x10;
+	static const uint8_t TGA_DESCRIPTOR_TOP_ORIGIN = 0x20;
+
+	// Way past anything we load, keeps width * height * 4 far from overflowing
+	static const uint32_t MAX_TGA_SIZE = 32768;
+
+	struct TgaHeader
+	{
+		TgaInfo info;
+		uint32_t bytesPerTexel = 0;
+		bool isRLE = false;
+		bool isTopOrigin = false;
+		uint64_t dataOffset = 0;
+	};
+
+	static uint16_t readUint16(const uint8_t* pData)
+	{
+		return (uint16_t)(pData[0] | (pData[1] << 8));
+	}
+
+	static bool readTgaHeader(const uint8_t* pFileData, uint64_t fileSize, TgaHeader& outHeader)
+	{
+		if (fileSize < TGA_HEADER_SIZE)
+		{
+			return false;
+		}
+
+		uint8_t idLength = pFileData[0];
+		uint8_t colourMapType = pFileData[1];
+		uint8_t imageType = pFileData[2];
+		uint16_t colourMapLength = readUint16(pFileData + 5);
+		uint8_t colourMapEntrySize = pFileData[7];
+		uint32_t width = readUint16(pFileData + 12);
+		uint32_t height = readUint16(pFileData + 14);
+		uint8_t bitsPerTexel = pFileData[16];
+		uint8_t descriptor = pFileData[17];
+
+		bool isGrayscale = imageType == TGA_TYPE_GRAYSCALE || imageType == TGA_TYPE_RLE_GRAYSCALE;
+		bool isTrueColour = imageType == TGA_TYPE_TRUE_COLOUR || imageType == TGA_TYPE_RLE_TRUE_COLOUR;
+
+		// A colour map can be there without being used, it's skipped then
+		if (colourMapType > 1 || (!isGrayscale && !isTrueColour) || (descriptor & TGA_DESCRIPTOR_RIGHT_TO_LEFT))
+		{
+			return false;
+		}
+
+		if (isGrayscale ? bitsPerTexel != 8 : (bitsPerTexel != 24 && bitsPerTexel != 32))
+		{
+			return false;
+		}
+
+		if (width == 0 || height == 0 || width > MAX_TGA_SIZE || height > MAX_TGA_SIZE)
+		{
+			return false;
+		}
+
+		uint64_t colourMapSize = colourMapType ? (uint64_t)colourMapLength * ((colourMapEntrySize + 7) / 8) : 0;
+
+		outHeader.info.width = width;
+		outHeader.info.height = height;
+		outHeader.info.numChannels = bitsPerTexel / 8;
+		outHeader.bytesPerTexel = bitsPerTexel / 8;
+		outHeader.isRLE = imageType == TGA_TYPE_RLE_TRUE_COLOUR || imageType == TGA_TYPE_RLE_GRAYSCALE;
+		outHeader.isTopOrigin = descriptor & TGA_DESCRIPTOR_TOP_ORIGIN;
+		outHeader.dataOffset = TGA_HEADER_SIZE + idLength + colourMapSize;
+
+		return outHeader.dataOffset <= fileSize;
+	}
+
+	static uint32_t convertTexel(const uint8_t* pSrc, uint32_t bytesPerTexel)
+	{
+		switch (bytesPerTexel)
+		{
+		case 1:
+			return pSrc[0] * 0x00010101u | 0xFF000000u;
+
+		case 3:
+			return pSrc[2] | (pSrc[1] << 8) | (pSrc[0] << 16) | 0xFF000000u;
+
+		default:
+			return pSrc[2] | (pSrc[1] << 8) | (pSrc[0] << 16) | ((uint32_t)pSrc[3] << 24);
+		}
+	}
+
+	// numTexels of BGR(A) or gray, only reads the bytes of those texels
+	static void convertTexels(const uint8_t* pSrc, uint32_t numTexels, uint32_t bytesPerTexel, bool useSIMD, uint8_t* pDst)
+	{
+		uint32_t i = 0;
+
+#ifdef OKAY_TGA_DECODER_SSE2
+		if (useSIMD)
+		{
+			const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+			const __m128i greenAlphaMask = _mm_set1_epi32((int)0xFF00FF00);
+			const __m128i lowByteMask = _mm_set1_epi32(0xFF);
+
+			// Swaps bytes 0 & 2 of every texel, BGRA -> RGBA
+			auto swapRedBlue = [&](__m128i texels)
+			{
+				__m128i red = _mm_and_si128(_mm_srli_epi32(texels, 16), lowByteMask);
+				__m128i blue = _mm_slli_epi32(_mm_and_si128(texels, lowByteMask), 16);
+				return _mm_or_si128(_mm_and_si128(texels, greenAlphaMask), _mm_or_si128(red, blue));
+			};
+
+			if (bytesPerTexel == 4)
+			{
+				for (; i + 4 <= numTexels; i += 4)
+				{
+					__m128i texels = _mm_loadu_si128((const __m128i*)(pSrc + (size_t)i * 4));
+					_mm_storeu_si128((__m128i*)(pDst + (size_t)i * 4), swapRedBlue(texels));
+				}
+			}
+			else if (bytesPerTexel == 3)
+			{
+				// 4 byte loads at a 3 byte stride, the 4th byte is the next texel & is replaced by the alpha.
+				// Stops early enough that the last load stays inside the texels
+				for (; i + 5 <= numTexels; i += 4)
+				{
+					const uint8_t* pTexels = pSrc + (size_t)i * 3;
+
+					int32_t values[4];
+					memcpy(&values[0], pTexels + 0, 4);
+					memcpy(&values[1], pTexels + 3, 4);
+					memcpy(&values[2], pTexels + 6, 4);
+					memcpy(&values[3], pTexels + 9, 4);
+
+					__m128i texels = _mm_set_epi32(values[3], values[2], values[1], values[0]);
+					texels = _mm_or_si128(_mm_andnot_si128(opaque, texels), opaque);
+
+					_mm_storeu_si128((__m128i*)(pDst + (size_t)i * 4), swapRedBlue(texels));
+				}
+			}
+			else
+			{
+				for (; i + 16 <= numTexels; i += 16)
+				{
+					__m128i gray = _mm_loadu_si128((const __m128i*)(pSrc + i));
+					__m128i grayLow = _mm_unpacklo_epi8(gray, gray);
+					__m128i grayHigh = _mm_unpackhi_epi8(gray, gray);
+
+					// gg -> gggg, then the alpha replaces the 4th
+					__m128i texels[4] =
+					{
+						_mm_unpacklo_epi16(grayLow, grayLow),
+						_mm_unpackhi_epi16(grayLow, grayLow),
+						_mm_unpacklo_epi16(grayHigh, grayHigh),
+						_mm_unpackhi_epi16(grayHigh, grayHigh),
+					};
+
+					for (uint32_t k = 0; k < 4; k++)
+					{
+						_mm_storeu_si128((__m128i*)(pDst + (size_t)(i + k * 4) * 4), _mm_or_si128(texels[k], opaque));
+					}
+				}
+			}
+		}
+#endif
+
+		for (; i < numTexels; i++)
+		{
+			uint32_t texel = convertTexel(pSrc + (size_t)i * bytesPerTexel, bytesPerTexel);
+			memcpy(pDst + (size_t)i * 4, &texel, 4);
+		}
+	}
+
+	static void fillTexels(uint32_t texel, uint32_t numTexels, bool useSIMD, uint8_t* pDst)
+	{
+		uint32_t i = 0;
+
+#ifdef OKAY_TGA_DECODER_SSE2
+		if (useSIMD)
+		{
+			__m128i texels = _mm_set1_epi32((int)texel);
+			for (; i + 4 <= numTexels; i += 4)
+			{
+				_mm_storeu_si128((__m128i*)(pDst + (size_t)i * 4), texels);
+			}
+		}
+#endif
+
+		for (; i < numTexels; i++)
+		{
+			memcpy(pDst + (size_t)i * 4, &texel, 4);
+		}
+	}
+
+	bool isTgaPath(const FilePath& path)
+	{
+		std::string extension = path.extension().string();
+		for (char& c : extension)
+		{
+			c = (char)tolower(c);
+		}
+
+		return extension == ".tga";
+	}
+
+	bool readTgaInfo(const uint8_t* pFileData, uint64_t fileSize, TgaInfo& outInfo)
+	{
+		TgaHeader header;
+		if (!readTgaHeader(pFileData, fileSize, header))
+		{
+			return false;
+		}
+
+		outInfo = header.info;
+		return true;
+	}
+
+	bool decodeTga(const uint8_t* pFileData, uint64_t fileSize, uint8_t* pOutTexels, bool forceScalar)
+	{
+		TgaHeader header;
+		if (!readTgaHeader(pFileData, fileSize, header))
+		{
+			return false;
+		}
+
+		uint32_t width = header.info.width;
+		uint32_t height = header.info.height;
+		uint32_t bytesPerTexel = header.bytesPerTexel;
+		bool useSIMD = !forceScalar;
+
+		const uint8_t* pData = pFileData + header.dataOffset;
+		const uint8_t* pDataEnd = pFileData + fileSize;
+
+		// Rows are stored bottom up unless the origin is at the top
+		auto getOutRow = [&](uint32_t fileRow)
+		{
+			uint32_t row = header.isTopOrigin ? fileRow : height - 1 - fileRow;
+			return pOutTexels + (size_t)row * width * 4;
+		};
+
+		if (!header.isRLE)
+		{
+			uint64_t rowSize = (uint64_t)width * bytesPerTexel;
+			if ((uint64_t)(pDataEnd - pData) < rowSize * height)
+			{
+				return false;
+			}
+
+			for (uint32_t y = 0; y < height; y++)
+			{
+				convertTexels(pData + y * rowSize, width, bytesPerTexel, useSIMD, getOutRow(y));
+			}
+
+			return true;
+		}
+
+		// Packets are split where they cross a row, since the rows aren't next to each other in the output
+		uint32_t x = 0;
+		uint32_t y = 0;
+
+		while (y < height)
+		{
+			if (pData >= pDataEnd)
+			{
+				return false;
+			}
+
+			uint8_t packetHeader = *pData++;
+			uint32_t numTexels = (packetHeader & 0x7F) + 1;
+			bool isRepeat = packetHeader & 0x80;
+
+			uint64_t packetSize = isRepeat ? bytesPerTexel : (uint64_t)numTexels * bytesPerTexel;
+			if ((uint64_t)(pDataEnd - pData) < packetSize)
+			{
+				return false;
+			}
+
+			uint32_t texel = isRepeat ? convertTexel(pData, bytesPerTexel) : 0;
+			const uint8_t* pPacketTexels = pData;
+
+			while (numTexels)
+			{
+				if (y >= height)
+				{
+					return false;
+				}
+
+				uint32_t numRowTexels = glm::min(numTexels, width - x);
+				uint8_t* pOut = getOutRow(y) + (size_t)x * 4;
+
+				if (isRepeat)
+				{
+					fillTexels(texel, numRowTexels, useSIMD, pOut);
+				}
+				else
+				{
+					convertTexels(pPacketTexels, numRowTexels, bytesPerTexel, useSIMD, pOut);
+					pPacketTexels += (size_t)numRowTexels * bytesPerTexel;
+				}
+
+				numTexels -= numRowTexels;
+				x += numRowTexels;
+
+				if (x == width)
+				{
+					x = 0;
+					y++;
+				}
+			}
+
+			pData += packetSize;
+		}
+
+		return true;
+	}
+}
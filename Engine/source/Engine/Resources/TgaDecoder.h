@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+/*
+	TGA decoder for the texture import, Sponza is almost all TGA. Handles uncompressed & RLE true colour (24 & 32 bit) and
+	grayscale (8 bit) with the origin at the bottom or the top left, anything else (colour maps, 16 bit, right to left)
+	returns false so stbi_load can take it.
+
+	Writes RGBA8 straight into memory from the caller, like the full size level of a mip chain (allocateMipChain), with the
+	rows flipped while writing instead of afterwards. The BGR(A) -> RGBA swizzle & the expansion to 4 channels run on 4 texels
+	per SSE2 register (16 for grayscale), the scalar path gives the same result & is used to check it.
+
+	Every read is checked against the file size, RLE packets can cross rows like the spec allows but not the end of the image.
+*/
+
+namespace Okay
+{
+	struct TgaInfo
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t numChannels = 0; // In the file, 1, 3 or 4, the decoded texels are always RGBA8
+	};
+
+	// By extension, .tga
+	bool isTgaPath(const FilePath& path);
+
+	// Reads the header, false if it's not a TGA decodeTga can handle
+	bool readTgaInfo(const uint8_t* pFileData, uint64_t fileSize, TgaInfo& outInfo);
+
+	// pOutTexels receives width * height RGBA8 texels, top row first. False if the file is unsupported or malformed,
+	// pOutTexels can be partly written then
+	bool decodeTga(const uint8_t* pFileData, uint64_t fileSize, uint8_t* pOutTexels, bool forceScalar = false);
+}
@@ -0,0 +1,123 @@
+#include "VertexQuantization.h"
+
+#include "glm/gtc/packing.hpp"
+
+namespace Okay
+{
+	VertexQuantization computeVertexQuantization(const std::vector<Vertex>& verticies)
+	{
+		VertexQuantization quantization;
+		if (verticies.empty())
+		{
+			return quantization;
+		}
+
+		glm::vec3 minPos = verticies[0].position;
+		glm::vec3 maxPos = verticies[0].position;
+		for (const Vertex& vertex : verticies)
+		{
+			minPos = glm::min(minPos, vertex.position);
+			maxPos = glm::max(maxPos, vertex.position);
+		}
+
+		quantization.positionMin = minPos;
+		quantization.positionScale = (maxPos - minPos) / (float)UINT16_MAX;
+
+		return quantization;
+	}
+
+	void quantizePosition(glm::vec3 position, const VertexQuantization& quantization, uint16_t* pOutQuantized)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			float scale = quantization.positionScale[i];
+			float quantized = scale > 0.f ? (position[i] - quantization.positionMin[i]) / scale : 0.f;
+
+			pOutQuantized[i] = (uint16_t)glm::clamp(glm::round(quantized), 0.f, (float)UINT16_MAX);
+		}
+	}
+
+	glm::vec3 dequantizePosition(const uint16_t* pQuantized, const VertexQuantization& quantization)
+	{
+		return quantization.positionMin + glm::vec3(pQuantized[0], pQuantized[1], pQuantized[2]) * quantization.positionScale;
+	}
+
+	// Octahedral mapping from "A Survey of Efficient Representations for Independent Unit Vectors" (Cigolle et al. 2014)
+	uint32_t encodeOctahedral(glm::vec3 direction)
+	{
+		direction /= glm::max(glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z), 1e-20f);
+
+		glm::vec2 encoded = glm::vec2(direction.x, direction.y);
+		if (direction.z < 0.f)
+		{
+			glm::vec2 signs = glm::vec2(encoded.x >= 0.f ? 1.f : -1.f, encoded.y >= 0.f ? 1.f : -1.f);
+			encoded = (1.f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signs;
+		}
+
+		return glm::packSnorm2x16(encoded);
+	}
+
+	glm::vec3 decodeOctahedral(uint32_t encoded)
+	{
+		glm::vec2 octahedral = glm::unpackSnorm2x16(encoded);
+
+		glm::vec3 direction = glm::vec3(octahedral.x, octahedral.y, 1.f - glm::abs(octahedral.x) - glm::abs(octahedral.y));
+		float fold = glm::max(-direction.z, 0.f);
+		direction.x += direction.x >= 0.f ? -fold : fold;
+		direction.y += direction.y >= 0.f ? -fold : fold;
+
+		return glm::normalize(direction);
+	}
+
+	PackedVertex encodeVertex(const Vertex& vertex, const VertexQuantization& quantization)
+	{
+		PackedVertex packedVertex;
+
+		quantizePosition(vertex.position, quantization, packedVertex.position);
+		packedVertex.normal = encodeOctahedral(vertex.normal);
+		packedVertex.tangent = encodeOctahedral(vertex.tangent);
+		packedVertex.uv = glm::packHalf2x16(vertex.uv);
+
+		if (glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.biTangent) < 0.f)
+		{
+			packedVertex.flags |= PACKED_VERTEX_FLAG_FLIP_BITANGENT;
+		}
+
+		return packedVertex;
+	}
+
+	Vertex decodeVertex(const PackedVertex& packedVertex, const VertexQuantization& quantization)
+	{
+		Vertex vertex;
+
+		vertex.position = dequantizePosition(packedVertex.position, quantization);
+		vertex.normal = decodeOctahedral(packedVertex.normal);
+		vertex.tangent = decodeOctahedral(packedVertex.tangent);
+		vertex.uv = glm::unpackHalf2x16(packedVertex.uv);
+
+		float bitangentSign = packedVertex.flags & PACKED_VERTEX_FLAG_FLIP_BITANGENT ? -1.f : 1.f;
+		vertex.biTangent = glm::cross(vertex.normal, vertex.tangent) * bitangentSign;
+
+		return vertex;
+	}
+
+	void encodeVerticies(const std::vector<Vertex>& verticies, const VertexQuantization& quantization, std::vector<PackedVertex>& outPackedVerticies)
+	{
+		outPackedVerticies.resize(verticies.size());
+		for (uint32_t i = 0; i < (uint32_t)verticies.size(); i++)
+		{
+			outPackedVerticies[i] = encodeVertex(verticies[i], quantization);
+		}
+	}
+
+	uint64_t getUnpackedMeshSize(const MeshData& meshData)
+	{
+		return meshData.verticies.size() * sizeof(Vertex) + meshData.indicies.size() * sizeof(uint32_t);
+	}
+
+	uint64_t getPackedMeshSize(const MeshData& meshData)
+	{
+		uint64_t indexSize = canUse16BitIndicies((uint32_t)meshData.verticies.size()) ? sizeof(uint16_t) : sizeof(uint32_t);
+		return meshData.verticies.size() * sizeof(PackedVertex) + meshData.indicies.size() * indexSize;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Mesh.h"
+
+/*
+	Compressed GPU vertex layout, 20 bytes instead of the 56 byte Vertex:
+	- Position: 3x unorm16 relative to the mesh bounds (VertexQuantization)
+	- Normal & tangent: octahedral encoded, 2x snorm16 each
+	- Bitangent: only its sign is kept, it's rebuilt from cross(normal, tangent)
+	- UV: 2x half float
+
+	The CPU side keeps using Vertex, verticies are only packed when uploaded.
+	Decoded in the vertex shaders with Utilities/VertexDecoding.hlsli, keep the two in sync.
+*/
+
+namespace Okay
+{
+	struct PackedVertex
+	{
+		uint16_t position[3] = {};
+		uint16_t flags = 0; // Bit 0: bitangent is -cross(normal, tangent)
+
+		uint32_t normal = 0;
+		uint32_t tangent = 0;
+		uint32_t uv = 0;
+	};
+
+	static_assert(sizeof(PackedVertex) == 20, "PackedVertex must match the layout in VertexDecoding.hlsli");
+
+	// Position only stream of the depth passes
+	struct PackedPosition
+	{
+		uint16_t position[3] = {};
+		uint16_t padding = 0;
+	};
+
+	static const uint16_t PACKED_VERTEX_FLAG_FLIP_BITANGENT = 1;
+
+	// position = positionMin + quantized * positionScale, passed to the shaders with every draw (IndirectDrawData)
+	struct VertexQuantization
+	{
+		glm::vec3 positionMin = glm::vec3(0.f);
+		glm::vec3 positionScale = glm::vec3(0.f);
+	};
+
+	VertexQuantization computeVertexQuantization(const std::vector<Vertex>& verticies);
+
+	void quantizePosition(glm::vec3 position, const VertexQuantization& quantization, uint16_t* pOutQuantized);
+	glm::vec3 dequantizePosition(const uint16_t* pQuantized, const VertexQuantization& quantization);
+
+	uint32_t encodeOctahedral(glm::vec3 direction);
+	glm::vec3 decodeOctahedral(uint32_t encoded);
+
+	PackedVertex encodeVertex(const Vertex& vertex, const VertexQuantization& quantization);
+	Vertex decodeVertex(const PackedVertex& packedVertex, const VertexQuantization& quantization);
+
+	void encodeVerticies(const std::vector<Vertex>& verticies, const VertexQuantization& quantization, std::vector<PackedVertex>& outPackedVerticies);
+
+	// Bytes of the GPU vertex & index buffers of a mesh, as floats + 32 bit indicies vs packed
+	uint64_t getUnpackedMeshSize(const MeshData& meshData);
+	uint64_t getPackedMeshSize(const MeshData& meshData);
+
+	// Index buffers use 16 bits when every index fits
+	inline bool canUse16BitIndicies(uint32_t numVerticies)
+	{
+		return numVerticies <= UINT16_MAX + 1u;
+	}
+}
@@ -86,4 +86,14 @@ namespace Okay
 		glm::vec2 attenuation = glm::vec2(0.f, 1.f);
 		float spreadAngle = 90.f;
 	};
+
+	// Tag for lights that never move, the irradiance bake (see IrradianceBaker.h) only takes these & BakedLights
+	struct StaticLight
+	{
+	};
+
+	// Tag for lights that only exist in the irradiance bake (see IrradianceBaker.h), they're skipped when rendering
+	struct BakedLight
+	{
+	};
 }
@@ -23,8 +23,9 @@ namespace Okay
 		{
 		}
 
+		// Returns void for empty tag components (entt doesn't store them)
 		template<typename T, typename... Args>
-		inline T& addComponent(Args&&... args)
+		inline decltype(auto) addComponent(Args&&... args)
 		{
 			ASSERT_ENTITY();
 
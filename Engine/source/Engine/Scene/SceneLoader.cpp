@@ -0,0 +1,22 @@
+#include "SceneLoader.h"
+
+namespace Okay
+{
+	void createEntitiesFromFile(Scene& scene, ResourceManager& resourceManager, FilePath path, float scale, const MeshMergeSettings* pMergeSettings)
+	{
+		std::vector<LoadedObject> objects;
+		resourceManager.loadObjects(path, objects, scale, pMergeSettings);
+
+		for (LoadedObject& objectData : objects)
+		{
+			Entity entity = scene.createEntity();
+
+			entity.getComponent<Transform>().setFromMatrix(objectData.transformMatrix);
+
+			MeshRenderer& meshRenderer = entity.addComponent<MeshRenderer>();
+			meshRenderer.meshID = objectData.meshID;
+			meshRenderer.diffuseTextureID = objectData.diffuseTextureID;
+			meshRenderer.normalMapID = objectData.normalMapID;
+		}
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Scene.h"
+#include "Engine/Resources/ResourceManager.h"
+
+namespace Okay
+{
+	// Loads the objects in path & creates an entity with a MeshRenderer for each. Doesn't need the renderer, so headless tools can build the same scene
+	void createEntitiesFromFile(Scene& scene, ResourceManager& resourceManager, FilePath path, float scale, const MeshMergeSettings* pMergeSettings = nullptr);
+}
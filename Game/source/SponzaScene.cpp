@@ -0,0 +1,71 @@
+#include "SponzaScene.h"
+
+#include "Engine/Scene/SceneLoader.h"
+
+using namespace Okay;
+
+Entity createSponzaScene(Scene& scene, ResourceManager& resourceManager)
+{
+	MeshMergeSettings mergeSettings;
+	createEntitiesFromFile(scene, resourceManager, FilePath("resources") / "sponza" / "sponza.obj", 1.f, &mergeSettings);
+	//createEntitiesFromFile(scene, resourceManager, FilePath("resources") / "meshes" / "sphere.fbx", 1.f);
+	//resourceManager.loadTexture(FilePath("resources") / "textures" / "sus.PNG");
+
+	Entity camEntity = scene.createEntity();
+	camEntity.addComponent<Camera>();
+	scene.setActiveCamera(camEntity);
+
+	PointLight& pointLight = camEntity.addComponent<PointLight>();
+	pointLight.colour = glm::vec3(0.9f, 0.2f, 0.4f);
+	pointLight.intensity = 10.f;
+	pointLight.shadowSource = false;
+
+
+	Entity bulbEntity = scene.createEntity();
+	bulbEntity.getComponent<Transform>().position = glm::vec3(487.f, 145.f, 217.f);
+	PointLight& bulbLight = bulbEntity.addComponent<PointLight>();
+	bulbEntity.addComponent<StaticLight>();
+	bulbLight.colour = glm::vec3(1.f, 0.3f, 0.4f);
+	bulbLight.intensity = 1.f;
+	bulbLight.attenuation = glm::vec2(0.f, 0.000001f);
+
+
+	Entity sun = scene.createEntity();
+	sun.getComponent<Transform>().rotation = glm::vec3(45.f, 45.f, 0.f);
+
+	DirectionalLight& dirLight = sun.addComponent<DirectionalLight>();
+	sun.addComponent<StaticLight>();
+	dirLight.colour = glm::vec3(246.f, 163.f, 22.f) / 255.f;
+	dirLight.intensity = 1.f;
+
+
+	Entity spotLightEntity = scene.createEntity();
+	spotLightEntity.getComponent<Transform>().position = glm::vec3(-960.f, 443.f, 221.f);
+	spotLightEntity.getComponent<Transform>().rotation = glm::vec3(29.f, -248.f, 0.f);
+	
+	SpotLight& spotLight = spotLightEntity.addComponent<SpotLight>();
+	spotLightEntity.addComponent<StaticLight>();
+	spotLight.colour = glm::vec3(0.3f, 0.5f, 0.9f);
+	spotLight.intensity = 0.5f;
+	spotLight.attenuation = glm::vec2(0.f, 0.00000001f);
+	spotLight.spreadAngle = 60.f;
+
+	
+	Entity spotLightEntity2 = scene.createEntity();
+	spotLightEntity2.getComponent<Transform>().position = glm::vec3(-973.f, 343.f, -142.f);
+	spotLightEntity2.getComponent<Transform>().rotation = glm::vec3(26.f, -284.f, 0.f);
+
+	SpotLight& spotLight2 = spotLightEntity2.addComponent<SpotLight>();
+	spotLightEntity2.addComponent<StaticLight>();
+	spotLight2.colour = glm::vec3(0.9f, 0.5f, 0.3f);
+	spotLight2.intensity = 0.7f;
+	spotLight2.attenuation = glm::vec2(0.f, 0.00000001f);
+	spotLight2.spreadAngle = 90.f;
+
+	return camEntity;
+}
+
+IrradianceBakeSettings getSponzaBakeSettings()
+{
+	return IrradianceBakeSettings();
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Engine/Scene/Scene.h"
+#include "Engine/Resources/ResourceManager.h"
+#include "Engine/Baking/IrradianceBaker.h"
+
+/*
+	The scene App renders, without anything from the renderer so Baker can build the exact same scene headless.
+	Anything changed here changes the bake key, so App rebakes sponza.probes on its next start unless Baker already did.
+*/
+
+inline const Okay::FilePath SPONZA_PROBES_PATH = Okay::FilePath("resources") / "sponza" / "sponza.probes";
+
+// Loads sponza & creates the lights, returns the camera entity
+Okay::Entity createSponzaScene(Okay::Scene& scene, Okay::ResourceManager& resourceManager);
+
+Okay::IrradianceBakeSettings getSponzaBakeSettings();
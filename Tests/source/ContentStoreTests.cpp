@@ -0,0 +1,188 @@
+#include "Tests.h"
+
+#include "Engine/Misc/Hash.h"
+#include "Engine/Resources/ContentStore.h"
+
+#include <cstring>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static MeshData createRandomMesh(uint32_t numVerticies, uint32_t numTriangles, uint32_t seed)
+{
+	TestRandom random(seed);
+
+	MeshData meshData;
+	meshData.verticies.resize(numVerticies);
+	for (Vertex& vertex : meshData.verticies)
+	{
+		vertex.position = glm::vec3(random.nextFloat(-10.f, 10.f), random.nextFloat(-10.f, 10.f), random.nextFloat(-10.f, 10.f));
+		vertex.normal = glm::vec3(0.f, 1.f, 0.f);
+		vertex.uv = glm::vec2(random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f));
+	}
+
+	for (uint32_t i = 0; i < numTriangles * 3; i++)
+	{
+		meshData.indicies.emplace_back(random.next(numVerticies));
+	}
+
+	return meshData;
+}
+
+static std::vector<uint8_t> createRandomPixels(uint32_t size, uint32_t seed)
+{
+	TestRandom random(seed);
+
+	std::vector<uint8_t> pixels(size);
+	for (uint8_t& pixel : pixels)
+	{
+		pixel = (uint8_t)random.next(256);
+	}
+
+	return pixels;
+}
+
+// Published XXH64 values, the 43 byte string goes through the 32 byte stripes & the tail
+OKAY_TEST(contentHasherReferenceVectors)
+{
+	static const char* QUICK_FOX = "The quick brown fox jumps over the lazy dog";
+
+	OKAY_CHECK(ContentHasher::hash("", 0) == 0xef46db3751d8e999ull);
+	OKAY_CHECK(ContentHasher::hash("abc", 3) == 0x44bc2cf5ad770999ull);
+	OKAY_CHECK(ContentHasher::hash("abc", 3, 1) == 0xbea9ca8199328908ull);
+	OKAY_CHECK(ContentHasher::hash(QUICK_FOX, strlen(QUICK_FOX)) == 0x0b242d361fda71bcull);
+}
+
+OKAY_TEST(identicalMeshesShareAnAsset)
+{
+	std::vector<MeshData> meshes;
+	meshes.emplace_back(createRandomMesh(300, 500, 1));
+	meshes.emplace_back(createRandomMesh(300, 500, 2));
+	meshes.emplace_back(createRandomMesh(300, 500, 1)); // Same as the first one, from another file or under another name
+
+	OKAY_CHECK(hashMeshContent(meshes[0]) == hashMeshContent(meshes[2]));
+	OKAY_CHECK(isSameMeshContent(meshes[0], meshes[2]));
+	OKAY_CHECK(hashMeshContent(meshes[0]) != hashMeshContent(meshes[1]));
+	OKAY_CHECK(!isSameMeshContent(meshes[0], meshes[1]));
+
+	// Same as ResourceManager::addMesh
+	ContentStore store;
+	std::vector<AssetID> ids;
+	for (const MeshData& meshData : meshes)
+	{
+		uint64_t contentHash = hashMeshContent(meshData);
+		AssetID id = store.find(contentHash, [&](AssetID candidateID)
+		{
+			return isSameMeshContent(meshes[candidateID], meshData);
+		});
+
+		if (id == INVALID_ASSET_ID)
+		{
+			id = (AssetID)ids.size();
+			store.add(contentHash, id);
+		}
+
+		ids.emplace_back(id);
+	}
+
+	OKAY_CHECK(ids[0] == 0);
+	OKAY_CHECK(ids[1] == 1);
+	OKAY_CHECK(ids[2] == 0);
+	OKAY_CHECK(store.getNumAssets() == 2);
+}
+
+OKAY_TEST(meshHashCoversEveryByte)
+{
+	MeshData meshData = createRandomMesh(100, 200, 3);
+	uint64_t hash = hashMeshContent(meshData);
+
+	MeshData changedVertex = meshData;
+	changedVertex.verticies[57].uv.x += 1e-3f;
+	OKAY_CHECK(hashMeshContent(changedVertex) != hash);
+	OKAY_CHECK(!isSameMeshContent(changedVertex, meshData));
+
+	MeshData changedIndex = meshData;
+	changedIndex.indicies[301] = (changedIndex.indicies[301] + 1) % 100;
+	OKAY_CHECK(hashMeshContent(changedIndex) != hash);
+	OKAY_CHECK(!isSameMeshContent(changedIndex, meshData));
+
+	// Same bytes split differently between the two streams
+	MeshData movedIndicies = meshData;
+	movedIndicies.indicies.resize(movedIndicies.indicies.size() - 3);
+	OKAY_CHECK(hashMeshContent(movedIndicies) != hash);
+	OKAY_CHECK(!isSameMeshContent(movedIndicies, meshData));
+
+	MeshData empty;
+	OKAY_CHECK(hashMeshContent(empty) == hashMeshContent(MeshData()));
+	OKAY_CHECK(isSameMeshContent(empty, MeshData()));
+	OKAY_CHECK(hashMeshContent(empty) != hash);
+}
+
+OKAY_TEST(textureHashIncludesImportSettings)
+{
+	std::vector<uint8_t> pixels = createRandomPixels(64 * 64 * 4, 4);
+	std::vector<uint8_t> samePixels = pixels;
+
+	uint64_t hash = hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_RGBA8, 64, 64, true);
+	OKAY_CHECK(hashTextureContent(samePixels.data(), OKAY_TEXTURE_FORMAT_RGBA8, 64, 64, true) == hash);
+
+	samePixels[1000] ^= 1;
+	OKAY_CHECK(hashTextureContent(samePixels.data(), OKAY_TEXTURE_FORMAT_RGBA8, 64, 64, true) != hash);
+
+	// The same bytes read as colour & as data, or in another layout, aren't the same texture
+	OKAY_CHECK(hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_RGBA8, 64, 64, false) != hash);
+	OKAY_CHECK(hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_RGBA8, 32, 128, true) != hash);
+	OKAY_CHECK(hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_RGBA8, 128, 32, true) != hash);
+
+	// 64x64 of BC3 is 4096 bytes, 64x128 of BC1 & RG8 is 4096 & 16384 bytes, all within the same pixels
+	uint64_t bc3Hash = hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_BC3, 64, 64, true);
+	OKAY_CHECK(bc3Hash != hash);
+	OKAY_CHECK(hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_BC1, 64, 128, true) != bc3Hash);
+	OKAY_CHECK(hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_RG8, 64, 128, false) != hash);
+	OKAY_CHECK(hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_BC5, 64, 64, false) != hashTextureContent(pixels.data(), OKAY_TEXTURE_FORMAT_BC3, 64, 64, false));
+}
+
+// A hash is only a candidate, colliding content has to give two assets
+OKAY_TEST(contentStoreHashCollision)
+{
+	MeshData meshes[2] = { createRandomMesh(50, 50, 5), createRandomMesh(50, 50, 6) };
+	static const uint64_t COLLIDING_HASH = 0x1234;
+
+	ContentStore store;
+	store.add(COLLIDING_HASH, 0);
+
+	uint32_t numCompared = 0;
+	AssetID id = store.find(COLLIDING_HASH, [&](AssetID candidateID)
+	{
+		numCompared++;
+		return isSameMeshContent(meshes[candidateID], meshes[1]);
+	});
+
+	OKAY_CHECK(id == INVALID_ASSET_ID);
+	OKAY_CHECK(numCompared == 1);
+
+	store.add(COLLIDING_HASH, 1);
+	OKAY_CHECK(store.getNumAssets() == 2);
+
+	// Both candidates are still found under the one hash
+	for (AssetID expectedID : { 0u, 1u })
+	{
+		id = store.find(COLLIDING_HASH, [&](AssetID candidateID)
+		{
+			return isSameMeshContent(meshes[candidateID], meshes[expectedID]);
+		});
+
+		OKAY_CHECK(id == expectedID);
+	}
+
+	// Other hashes never reach the compare
+	numCompared = 0;
+	id = store.find(COLLIDING_HASH + 1, [&](AssetID)
+	{
+		numCompared++;
+		return true;
+	});
+
+	OKAY_CHECK(id == INVALID_ASSET_ID);
+	OKAY_CHECK(numCompared == 0);
+}
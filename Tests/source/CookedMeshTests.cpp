@@ -0,0 +1,378 @@
+#include "Tests.h"
+
+#include "Engine/Resources/CookedMesh.h"
+#include "Engine/Resources/GeometryCodec.h"
+#include "Engine/Resources/MeshletBuilder.h"
+#include "Engine/Resources/MeshSimplifier.h"
+
+#include <cstring>
+#include <fstream>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// Offsets into the file, CookedMeshFileHeader is followed by the CookedMeshHeader of the first mesh
+static const size_t FIRST_MESH_HEADER_OFFSET = 24;
+static const size_t NUM_VERTICIES_OFFSET = FIRST_MESH_HEADER_OFFSET;
+static const size_t NUM_INDICIES_OFFSET = FIRST_MESH_HEADER_OFFSET + 4;
+static const size_t NUM_MESHLETS_OFFSET = FIRST_MESH_HEADER_OFFSET + 8;
+
+static FilePath getTestPath(const char* pName)
+{
+	return std::filesystem::temp_directory_path() / pName;
+}
+
+// A wavy grid, processed like ResourceManager does at import
+static CookedMesh createCookedMesh(uint32_t resolution)
+{
+	CookedMesh mesh;
+	MeshData& meshData = mesh.meshData;
+
+	for (uint32_t y = 0; y <= resolution; y++)
+	{
+		for (uint32_t x = 0; x <= resolution; x++)
+		{
+			Vertex vertex;
+			vertex.position = glm::vec3((float)x, glm::sin(x * 0.3f + y * 0.2f), (float)y);
+			vertex.normal = glm::vec3(0.f, 1.f, 0.f);
+			vertex.tangent = glm::vec3(1.f, 0.f, 0.f);
+			vertex.biTangent = glm::vec3(0.f, 0.f, 1.f);
+			vertex.uv = glm::vec2((float)x / resolution, (float)y / resolution);
+			meshData.verticies.emplace_back(vertex);
+		}
+	}
+
+	for (uint32_t y = 0; y < resolution; y++)
+	{
+		for (uint32_t x = 0; x < resolution; x++)
+		{
+			uint32_t a = y * (resolution + 1) + x;
+			meshData.indicies.insert(meshData.indicies.end(), { a, a + resolution + 1, a + 1, a + 1, a + resolution + 1, a + resolution + 2 });
+		}
+	}
+
+	optimizeMesh(meshData, &mesh.stats);
+	buildMeshlets(meshData, mesh.meshletData);
+	generateMeshLODs(meshData, MeshLODSettings(), mesh.lods);
+
+	return mesh;
+}
+
+// The index codec can rotate triangles, the winding & order are kept
+static bool equalTriangles(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i + 2 < (uint32_t)a.size(); i += 3)
+	{
+		bool rotated = false;
+		for (uint32_t rotation = 0; rotation < 3; rotation++)
+		{
+			rotated |= a[i] == b[i + rotation] && a[i + 1] == b[i + (rotation + 1) % 3] && a[i + 2] == b[i + (rotation + 2) % 3];
+		}
+
+		if (!rotated)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename T>
+static bool equalBytes(const std::vector<T>& a, const std::vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+static bool equalMeshes(const CookedMesh& a, const CookedMesh& b)
+{
+	if (a.lods.size() != b.lods.size())
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)a.lods.size(); i++)
+	{
+		if (!equalTriangles(a.lods[i].indicies, b.lods[i].indicies) || a.lods[i].error != b.lods[i].error)
+		{
+			return false;
+		}
+	}
+
+	return equalBytes(a.meshData.verticies, b.meshData.verticies) &&
+		equalTriangles(a.meshData.indicies, b.meshData.indicies) &&
+		equalBytes(a.meshletData.meshlets, b.meshletData.meshlets) &&
+		a.meshletData.vertexIndicies == b.meshletData.vertexIndicies &&
+		a.meshletData.triangles == b.meshletData.triangles &&
+		a.stats.after.numTransformed == b.stats.after.numTransformed;
+}
+
+static std::string readFile(const FilePath& path)
+{
+	std::string fileData;
+	readBinary(path, fileData);
+	return fileData;
+}
+
+static void writeFile(const FilePath& path, const std::string& fileData)
+{
+	std::ofstream writer(path, std::ios::binary);
+	writer.write(fileData.data(), fileData.size());
+}
+
+static void patchUint32(std::string& fileData, size_t offset, uint32_t value)
+{
+	memcpy(fileData.data() + offset, &value, sizeof(uint32_t));
+}
+
+OKAY_TEST(cookedMeshRoundTrip)
+{
+	std::vector<CookedMesh> meshes = { createCookedMesh(20), createCookedMesh(50), CookedMesh() };
+	uint64_t sourceKey = 1234;
+
+	FilePath path = getTestPath("okayRoundTrip.okaymesh");
+
+	CookedMeshFileStats writeStats;
+	OKAY_CHECK(writeCookedMeshes(path, sourceKey, meshes, &writeStats));
+	OKAY_CHECK(writeStats.fileSize < writeStats.rawSize);
+
+	std::vector<CookedMesh> readMeshes(meshes.size());
+	CookedMeshFileStats readStats;
+	OKAY_CHECK(readCookedMeshes(path, sourceKey, readMeshes, &readStats));
+	OKAY_CHECK(readStats.rawSize == writeStats.rawSize);
+	OKAY_CHECK(readStats.fileSize == writeStats.fileSize);
+
+	OKAY_CHECK(!meshes[1].lods.empty());
+	for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+	{
+		OKAY_CHECK(equalMeshes(meshes[i], readMeshes[i]));
+	}
+
+	// Stale key & a different number of meshes
+	OKAY_CHECK(!readCookedMeshes(path, sourceKey + 1, readMeshes));
+	readMeshes.resize(2);
+	OKAY_CHECK(!readCookedMeshes(path, sourceKey, readMeshes));
+
+	std::filesystem::remove(path);
+}
+
+OKAY_TEST(cookedMeshRejectsTruncatedFiles)
+{
+	std::vector<CookedMesh> meshes = { createCookedMesh(10) };
+	FilePath path = getTestPath("okayTruncated.okaymesh");
+	OKAY_CHECK(writeCookedMeshes(path, 1, meshes));
+
+	std::string fileData = readFile(path);
+	bool anyAccepted = false;
+
+	for (size_t size = 0; size < fileData.size(); size += 7)
+	{
+		writeFile(path, fileData.substr(0, size));
+
+		std::vector<CookedMesh> readMeshes(1);
+		anyAccepted |= readCookedMeshes(path, 1, readMeshes);
+	}
+
+	OKAY_CHECK(!anyAccepted);
+	std::filesystem::remove(path);
+}
+
+OKAY_TEST(cookedMeshRejectsHugeCounts)
+{
+	std::vector<CookedMesh> meshes = { createCookedMesh(10) };
+	FilePath path = getTestPath("okayHugeCounts.okaymesh");
+	OKAY_CHECK(writeCookedMeshes(path, 1, meshes));
+
+	std::string fileData = readFile(path);
+
+	// Without the bounds these would resize to gigabytes before the decoder notices
+	for (size_t offset : { NUM_VERTICIES_OFFSET, NUM_INDICIES_OFFSET, NUM_MESHLETS_OFFSET })
+	{
+		std::string corruptData = fileData;
+		patchUint32(corruptData, offset, 0xFFFFFFF0);
+		writeFile(path, corruptData);
+
+		std::vector<CookedMesh> readMeshes(1);
+		OKAY_CHECK(!readCookedMeshes(path, 1, readMeshes));
+	}
+
+	std::filesystem::remove(path);
+}
+
+OKAY_TEST(cookedMeshRejectsOutOfRangeIndicies)
+{
+	FilePath path = getTestPath("okayBadIndicies.okaymesh");
+
+	// Written as is, the writer trusts the meshes it's given
+	std::vector<CookedMesh> meshes = { createCookedMesh(10) };
+	meshes[0].meshData.indicies[4] = (uint32_t)meshes[0].meshData.verticies.size();
+	OKAY_CHECK(writeCookedMeshes(path, 1, meshes));
+
+	std::vector<CookedMesh> readMeshes(1);
+	OKAY_CHECK(!readCookedMeshes(path, 1, readMeshes));
+
+	// Same for the LODs
+	meshes = { createCookedMesh(10) };
+	OKAY_CHECK(!meshes[0].lods.empty());
+	meshes[0].lods[0].indicies.back() = 0xFFFFFF;
+	OKAY_CHECK(writeCookedMeshes(path, 1, meshes));
+	OKAY_CHECK(!readCookedMeshes(path, 1, readMeshes));
+
+	std::filesystem::remove(path);
+}
+
+OKAY_TEST(cookedMeshRejectsCorruptMeshlets)
+{
+	FilePath path = getTestPath("okayBadMeshlets.okaymesh");
+	std::vector<CookedMesh> readMeshes(1);
+
+	auto writeAndRead = [&](const CookedMesh& mesh)
+	{
+		OKAY_CHECK(writeCookedMeshes(path, 1, { mesh }));
+		return readCookedMeshes(path, 1, readMeshes);
+	};
+
+	CookedMesh validMesh = createCookedMesh(10);
+	OKAY_CHECK(writeAndRead(validMesh));
+
+	CookedMesh mesh = validMesh;
+	mesh.meshletData.vertexIndicies[3] = (uint32_t)mesh.meshData.verticies.size();
+	OKAY_CHECK(!writeAndRead(mesh));
+
+	// Local vertex past the meshlet's verticies
+	mesh = validMesh;
+	mesh.meshletData.triangles[0] = packMeshletTriangle(0, 1, mesh.meshletData.meshlets[0].numVerticies);
+	OKAY_CHECK(!writeAndRead(mesh));
+
+	mesh = validMesh;
+	mesh.meshletData.meshlets.back().triangleOffset = (uint32_t)mesh.meshletData.triangles.size();
+	OKAY_CHECK(!writeAndRead(mesh));
+
+	mesh = validMesh;
+	mesh.meshletData.meshlets.back().vertexOffset = 0xFFFFFFF0;
+	OKAY_CHECK(!writeAndRead(mesh));
+
+	mesh = validMesh;
+	mesh.meshletData.meshlets[0].numTriangles = MESHLET_MAX_TRIANGLES + 1;
+	OKAY_CHECK(!writeAndRead(mesh));
+
+	std::filesystem::remove(path);
+}
+
+// Random byte flips, reading has to fail or give meshes that are safe to use, never crash
+OKAY_TEST(cookedMeshCorruptBytes)
+{
+	std::vector<CookedMesh> meshes = { createCookedMesh(12) };
+	FilePath path = getTestPath("okayCorrupt.okaymesh");
+	OKAY_CHECK(writeCookedMeshes(path, 1, meshes));
+
+	std::string fileData = readFile(path);
+	TestRandom random(6);
+
+	bool allSafe = true;
+	for (uint32_t i = 0; i < 300; i++)
+	{
+		std::string corruptData = fileData;
+		for (uint32_t j = 0; j < 1 + random.next(4); j++)
+		{
+			// Past the file header, that part is only compared
+			size_t offset = FIRST_MESH_HEADER_OFFSET + random.next((uint32_t)(fileData.size() - FIRST_MESH_HEADER_OFFSET));
+			corruptData[offset] = (char)random.next(256);
+		}
+		writeFile(path, corruptData);
+
+		std::vector<CookedMesh> readMeshes(1);
+		if (!readCookedMeshes(path, 1, readMeshes))
+		{
+			continue;
+		}
+
+		const CookedMesh& mesh = readMeshes[0];
+		for (uint32_t index : mesh.meshData.indicies)
+		{
+			allSafe &= index < mesh.meshData.verticies.size();
+		}
+
+		for (const Meshlet& meshlet : mesh.meshletData.meshlets)
+		{
+			allSafe &= (uint64_t)meshlet.vertexOffset + meshlet.numVerticies <= mesh.meshletData.vertexIndicies.size();
+			allSafe &= (uint64_t)meshlet.triangleOffset + meshlet.numTriangles <= mesh.meshletData.triangles.size();
+		}
+	}
+
+	OKAY_CHECK(allSafe);
+	std::filesystem::remove(path);
+}
+
+OKAY_BENCHMARK(cookedMeshDecodeThroughput)
+{
+	static const uint32_t NUM_ITERATIONS = 20;
+
+	std::vector<CookedMesh> meshes = { createCookedMesh(400) };
+	FilePath path = getTestPath("okayBenchmark.okaymesh");
+
+	CookedMeshFileStats stats;
+	OKAY_CHECK(writeCookedMeshes(path, 1, meshes, &stats));
+
+	std::vector<CookedMesh> readMeshes(1);
+	bool allRead = true;
+
+	double readMs = measureMs(NUM_ITERATIONS, [&]()
+	{
+		allRead &= readCookedMeshes(path, 1, readMeshes);
+	});
+
+	OKAY_CHECK(allRead);
+	OKAY_CHECK(equalMeshes(meshes[0], readMeshes[0]));
+
+	printf("    %u verticies, %u triangles, %.2f MB raw, %.2f MB file\n", (uint32_t)meshes[0].meshData.verticies.size(),
+		(uint32_t)meshes[0].meshData.indicies.size() / 3, stats.rawSize / 1e6, stats.fileSize / 1e6);
+	printf("    Read & decode: %.2f ms, %.0f MB/s of decoded data\n", readMs, stats.rawSize / 1e3 / readMs);
+
+	std::filesystem::remove(path);
+}
+
+// Only the codec, on streams already in memory, so the disk & file parsing don't hide its speed
+OKAY_BENCHMARK(cookedMeshStreamDecodeThroughput)
+{
+	static const uint32_t NUM_ITERATIONS = 50;
+
+	CookedMesh mesh = createCookedMesh(400);
+	const MeshData& meshData = mesh.meshData;
+
+	uint32_t numVerticies = (uint32_t)meshData.verticies.size();
+	uint32_t numIndicies = (uint32_t)meshData.indicies.size();
+
+	std::vector<uint8_t> vertexData, indexData;
+	encodeVertexStream(meshData.verticies.data(), numVerticies, sizeof(Vertex), vertexData);
+	encodeIndexStream(meshData.indicies.data(), numIndicies, indexData);
+
+	std::vector<Vertex> verticies(numVerticies);
+	std::vector<uint32_t> indicies(numIndicies);
+	bool allDecoded = true;
+
+	double vertexMs = measureMs(NUM_ITERATIONS, [&]()
+	{
+		allDecoded &= decodeVertexStream(vertexData.data(), vertexData.size(), numVerticies, sizeof(Vertex), verticies.data());
+	});
+
+	double indexMs = measureMs(NUM_ITERATIONS, [&]()
+	{
+		allDecoded &= decodeIndexStream(indexData.data(), indexData.size(), numIndicies, indicies.data());
+	});
+
+	OKAY_CHECK(allDecoded);
+	OKAY_CHECK(equalBytes(meshData.verticies, verticies));
+	OKAY_CHECK(equalTriangles(meshData.indicies, indicies));
+
+	size_t vertexSize = meshData.verticies.size() * sizeof(Vertex);
+	size_t indexSize = meshData.indicies.size() * sizeof(uint32_t);
+
+	printf("    Verticies: %.2f MB -> %.2f MB, %.3f ms, %.2f GB/s decoded\n", vertexSize / 1e6, vertexData.size() / 1e6, vertexMs, vertexSize / 1e6 / vertexMs);
+	printf("    Indicies:  %.2f MB -> %.2f MB, %.3f ms, %.2f GB/s decoded\n", indexSize / 1e6, indexData.size() / 1e6, indexMs, indexSize / 1e6 / indexMs);
+}
@@ -0,0 +1,193 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/IndirectDrawBuilder.h"
+
+#include <cstddef>
+#include <cstring>
+
+using namespace Okay;
+
+// What Renderer::assignObjectDrawGroups adds for a known scene, one draw per draw group
+struct TestDrawGroup
+{
+	IndexPool indexPool = OKAY_INDEX_POOL_32;
+	uint32_t firstIndex = 0;
+	uint32_t numIndicies = 0;
+	uint32_t baseVertex = 0;
+	uint32_t numInstances = 0;
+};
+
+static const TestDrawGroup TEST_SCENE[] =
+{
+	{ OKAY_INDEX_POOL_16, 0, 36, 0, 3 },		// Cube
+	{ OKAY_INDEX_POOL_32, 0, 300000, 0, 1 },	// Big mesh, too many verticies for 16 bit indicies
+	{ OKAY_INDEX_POOL_16, 36, 960, 24, 2 },		// Sphere LOD 0
+	{ OKAY_INDEX_POOL_16, 996, 240, 24, 5 },	// Sphere LOD 2, same verticies
+	{ OKAY_INDEX_POOL_16, 1236, 12, 400, 0 },	// Mesh without instances this frame
+};
+
+static const uint32_t NUM_TEST_DRAWS = sizeof(TEST_SCENE) / sizeof(TEST_SCENE[0]);
+
+static void addTestScene(IndirectDrawBuilder& builder)
+{
+	builder.reset();
+
+	uint32_t firstObject = 0;
+	for (uint32_t i = 0; i < NUM_TEST_DRAWS; i++)
+	{
+		IndirectDrawDesc drawDesc;
+		drawDesc.indexPool = TEST_SCENE[i].indexPool;
+		drawDesc.firstIndex = TEST_SCENE[i].firstIndex;
+		drawDesc.numIndicies = TEST_SCENE[i].numIndicies;
+		drawDesc.baseVertex = TEST_SCENE[i].baseVertex;
+		drawDesc.firstObject = firstObject;
+		drawDesc.numInstances = TEST_SCENE[i].numInstances;
+		drawDesc.quantization.positionMin = glm::vec3((float)i);
+		drawDesc.quantization.positionScale = glm::vec3(1.f / (i + 1));
+
+		OKAY_CHECK(builder.addDraw(drawDesc) == i);
+		firstObject += drawDesc.numInstances;
+	}
+}
+
+OKAY_TEST(indirectCommandLayout)
+{
+	// The command signature is a root constant followed by D3D12_DRAW_INDEXED_ARGUMENTS
+	OKAY_CHECK(offsetof(IndirectDrawCommand, drawIdx) == 0);
+	OKAY_CHECK(offsetof(IndirectDrawCommand, numIndicies) == 4);
+	OKAY_CHECK(offsetof(IndirectDrawCommand, numInstances) == 8);
+	OKAY_CHECK(offsetof(IndirectDrawCommand, firstIndex) == 12);
+	OKAY_CHECK(offsetof(IndirectDrawCommand, baseVertex) == 16);
+	OKAY_CHECK(offsetof(IndirectDrawCommand, firstInstance) == 20);
+
+	// DrawData in VertexDecoding.hlsli, float3 + float3 then the two uints
+	OKAY_CHECK(offsetof(IndirectDrawData, quantization) == 0);
+	OKAY_CHECK(offsetof(IndirectDrawData, baseVertex) == 24);
+	OKAY_CHECK(offsetof(IndirectDrawData, firstObject) == 28);
+}
+
+OKAY_TEST(indirectCommandsForKnownScene)
+{
+	IndirectDrawBuilder builder;
+	addTestScene(builder);
+
+	IndirectCommandList commandList;
+	builder.buildCommands(commandList);
+
+	// The argument buffers as the GPU reads them
+	static const uint32_t EXPECTED_16[] =
+	{
+		0, 36, 3, 0, 0, 0,
+		2, 960, 2, 36, 0, 0,
+		3, 240, 5, 996, 0, 0,
+	};
+
+	static const uint32_t EXPECTED_32[] =
+	{
+		1, 300000, 1, 0, 0, 0,
+	};
+
+	const std::vector<IndirectDrawCommand>& commands16 = commandList.commands[OKAY_INDEX_POOL_16];
+	const std::vector<IndirectDrawCommand>& commands32 = commandList.commands[OKAY_INDEX_POOL_32];
+
+	OKAY_CHECK(commandList.getNumCommands() == 4);
+	OKAY_CHECK(commands16.size() * sizeof(IndirectDrawCommand) == sizeof(EXPECTED_16));
+	OKAY_CHECK(commands32.size() * sizeof(IndirectDrawCommand) == sizeof(EXPECTED_32));
+
+	if (commands16.size() == 3 && commands32.size() == 1)
+	{
+		OKAY_CHECK(memcmp(commands16.data(), EXPECTED_16, sizeof(EXPECTED_16)) == 0);
+		OKAY_CHECK(memcmp(commands32.data(), EXPECTED_32, sizeof(EXPECTED_32)) == 0);
+	}
+
+	// The per draw data the drawIdx root constant points at
+	const std::vector<IndirectDrawData>& drawDatas = builder.getDrawDatas();
+	OKAY_CHECK(drawDatas.size() == NUM_TEST_DRAWS);
+
+	static const uint32_t EXPECTED_FIRST_OBJECTS[NUM_TEST_DRAWS] = { 0, 3, 4, 6, 11 };
+	for (uint32_t i = 0; i < NUM_TEST_DRAWS; i++)
+	{
+		OKAY_CHECK(drawDatas[i].baseVertex == TEST_SCENE[i].baseVertex);
+		OKAY_CHECK(drawDatas[i].firstObject == EXPECTED_FIRST_OBJECTS[i]);
+		OKAY_CHECK(drawDatas[i].quantization.positionMin == glm::vec3((float)i));
+	}
+}
+
+// Runs the commands like the vertex shaders would, every object has to be drawn exactly once with its own draw's data
+OKAY_TEST(indirectCommandsDrawEveryObjectOnce)
+{
+	IndirectDrawBuilder builder;
+	addTestScene(builder);
+
+	IndirectCommandList commandList;
+	builder.buildCommands(commandList);
+
+	const std::vector<IndirectDrawData>& drawDatas = builder.getDrawDatas();
+
+	std::vector<uint32_t> objectDrawIndicies(11, INVALID_UINT32);
+	bool objectDrawnTwice = false;
+
+	for (const std::vector<IndirectDrawCommand>& poolCommands : commandList.commands)
+	{
+		for (const IndirectDrawCommand& command : poolCommands)
+		{
+			// SV_InstanceID starts at 0, the first object comes from the draw data
+			for (uint32_t instanceID = 0; instanceID < command.numInstances; instanceID++)
+			{
+				uint32_t objectIdx = drawDatas[command.drawIdx].firstObject + instanceID;
+				if (objectIdx >= objectDrawIndicies.size())
+				{
+					objectDrawnTwice = true;
+					continue;
+				}
+
+				objectDrawnTwice |= objectDrawIndicies[objectIdx] != INVALID_UINT32;
+				objectDrawIndicies[objectIdx] = command.drawIdx;
+			}
+		}
+	}
+
+	OKAY_CHECK(!objectDrawnTwice);
+
+	uint32_t objectIdx = 0;
+	for (uint32_t i = 0; i < NUM_TEST_DRAWS; i++)
+	{
+		for (uint32_t j = 0; j < TEST_SCENE[i].numInstances; j++)
+		{
+			OKAY_CHECK(objectDrawIndicies[objectIdx++] == i);
+		}
+	}
+}
+
+OKAY_TEST(indirectCommandsForSubset)
+{
+	IndirectDrawBuilder builder;
+	addTestScene(builder);
+
+	// Shadow casters of one light, in any order. Draw 4 has no instances
+	static const uint32_t CASTER_DRAWS[] = { 3, 1, 4 };
+
+	IndirectCommandList commandList;
+	builder.buildCommands(CASTER_DRAWS, 3, commandList);
+
+	OKAY_CHECK(commandList.getNumCommands() == 2);
+	OKAY_CHECK(commandList.commands[OKAY_INDEX_POOL_16].size() == 1);
+	OKAY_CHECK(commandList.commands[OKAY_INDEX_POOL_32].size() == 1);
+
+	if (commandList.getNumCommands() == 2)
+	{
+		// The draw index still refers to the full draw list
+		OKAY_CHECK(commandList.commands[OKAY_INDEX_POOL_16][0].drawIdx == 3);
+		OKAY_CHECK(commandList.commands[OKAY_INDEX_POOL_16][0].firstIndex == 996);
+		OKAY_CHECK(commandList.commands[OKAY_INDEX_POOL_32][0].drawIdx == 1);
+	}
+
+	// Rebuilding clears the old commands
+	builder.buildCommands(CASTER_DRAWS + 2, 1, commandList);
+	OKAY_CHECK(commandList.getNumCommands() == 0);
+
+	builder.reset();
+	OKAY_CHECK(builder.getNumDraws() == 0);
+	builder.buildCommands(commandList);
+	OKAY_CHECK(commandList.getNumCommands() == 0);
+}
@@ -0,0 +1,317 @@
+#include "Tests.h"
+
+#include "Engine/Baking/IrradianceBaker.h"
+#include "Engine/Baking/BVH.h"
+#include "Engine/Scene/Scene.h"
+#include "Engine/Resources/ResourceManager.h"
+
+#include <fstream>
+#include <cstring>
+#include <iterator>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static void addQuad(BakeScene& bakeScene, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d)
+{
+	bakeScene.trianglePositions.insert(bakeScene.trianglePositions.end(), { a, b, c, a, c, d });
+}
+
+static void addBox(BakeScene& bakeScene, glm::vec3 min, glm::vec3 max)
+{
+	glm::vec3 p[8];
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		p[i] = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+	}
+
+	addQuad(bakeScene, p[0], p[2], p[3], p[1]);
+	addQuad(bakeScene, p[4], p[5], p[7], p[6]);
+	addQuad(bakeScene, p[0], p[1], p[5], p[4]);
+	addQuad(bakeScene, p[2], p[6], p[7], p[3]);
+	addQuad(bakeScene, p[0], p[4], p[6], p[2]);
+	addQuad(bakeScene, p[1], p[3], p[7], p[5]);
+}
+
+// A room with an open roof, a pillar & one light of every type
+static BakeScene createTestScene()
+{
+	BakeScene bakeScene;
+	addQuad(bakeScene, glm::vec3(-300.f, 0.f, -300.f), glm::vec3(-300.f, 0.f, 300.f), glm::vec3(300.f, 0.f, 300.f), glm::vec3(300.f, 0.f, -300.f));
+	addQuad(bakeScene, glm::vec3(-300.f, 0.f, 300.f), glm::vec3(-300.f, 300.f, 300.f), glm::vec3(300.f, 300.f, 300.f), glm::vec3(300.f, 0.f, 300.f));
+	addQuad(bakeScene, glm::vec3(-300.f, 0.f, -300.f), glm::vec3(-300.f, 300.f, -300.f), glm::vec3(-300.f, 300.f, 300.f), glm::vec3(-300.f, 0.f, 300.f));
+	addBox(bakeScene, glm::vec3(-50.f, 0.f, -50.f), glm::vec3(50.f, 250.f, 50.f));
+
+	BakeLight pointLight;
+	pointLight.type = OKAY_BAKE_LIGHT_POINT;
+	pointLight.position = glm::vec3(150.f, 100.f, 150.f);
+	pointLight.colour = glm::vec3(1.f, 0.8f, 0.6f);
+	pointLight.intensity = 50.f;
+	pointLight.attenuation = glm::vec2(0.f, 0.01f);
+	bakeScene.lights.emplace_back(pointLight);
+
+	BakeLight spotLight;
+	spotLight.type = OKAY_BAKE_LIGHT_SPOT;
+	spotLight.position = glm::vec3(-150.f, 250.f, -150.f);
+	spotLight.direction = glm::vec3(0.f, -1.f, 0.f);
+	spotLight.intensity = 80.f;
+	spotLight.attenuation = glm::vec2(0.f, 0.01f);
+	spotLight.spreadCosAngle = 0.7f;
+	spotLight.bakedOnly = true;
+	bakeScene.lights.emplace_back(spotLight);
+
+	BakeLight sun;
+	sun.type = OKAY_BAKE_LIGHT_DIRECTIONAL;
+	sun.direction = glm::normalize(glm::vec3(0.3f, 1.f, 0.2f));
+	sun.intensity = 2.f;
+	bakeScene.lights.emplace_back(sun);
+
+	return bakeScene;
+}
+
+static IrradianceBakeSettings createTestSettings()
+{
+	IrradianceBakeSettings settings;
+	settings.probeSpacing = 100.f;
+	settings.numSamples = 64;
+	settings.numBounces = 2;
+	settings.seed = 7;
+
+	return settings;
+}
+
+static bool equalVolumes(const IrradianceVolume& a, const IrradianceVolume& b)
+{
+	return a.gridMin == b.gridMin && a.probeSpacing == b.probeSpacing && a.gridSize == b.gridSize && a.sourceKey == b.sourceKey && a.probes.size() == b.probes.size() &&
+		memcmp(a.probes.data(), b.probes.data(), a.probes.size() * sizeof(IrradianceProbe)) == 0;
+}
+
+static std::vector<char> readFileBytes(const FilePath& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+OKAY_TEST(irradianceBakeIsDeterministic)
+{
+	BakeScene bakeScene = createTestScene();
+	IrradianceBakeSettings settings = createTestSettings();
+
+	IrradianceVolume volumeA;
+	IrradianceVolume volumeB;
+	bakeIrradianceVolume(bakeScene, settings, volumeA);
+	bakeIrradianceVolume(bakeScene, settings, volumeB);
+
+	OKAY_CHECK(volumeA.probes.size() > 1);
+	OKAY_CHECK(equalVolumes(volumeA, volumeB));
+
+	// The written files are byte identical too
+	FilePath pathA = std::filesystem::temp_directory_path() / "okayBakeA.probes";
+	FilePath pathB = std::filesystem::temp_directory_path() / "okayBakeB.probes";
+	OKAY_CHECK(writeIrradianceVolume(pathA, volumeA));
+	OKAY_CHECK(writeIrradianceVolume(pathB, volumeB));
+
+	std::vector<char> bytesA = readFileBytes(pathA);
+	OKAY_CHECK(!bytesA.empty());
+	OKAY_CHECK(bytesA == readFileBytes(pathB));
+
+	IrradianceVolume readVolume;
+	OKAY_CHECK(readIrradianceVolume(pathA, volumeA.sourceKey, readVolume));
+	OKAY_CHECK(equalVolumes(volumeA, readVolume));
+
+	std::filesystem::remove(pathA);
+	std::filesystem::remove(pathB);
+}
+
+OKAY_TEST(irradianceBakeIndependentOfThreadCount)
+{
+	BakeScene bakeScene = createTestScene();
+	IrradianceBakeSettings settings = createTestSettings();
+
+	settings.numThreads = 1;
+	IrradianceVolume singleThreaded;
+	bakeIrradianceVolume(bakeScene, settings, singleThreaded);
+
+	for (uint32_t numThreads : { 2u, 3u, 8u })
+	{
+		settings.numThreads = numThreads;
+		IrradianceVolume multiThreaded;
+		bakeIrradianceVolume(bakeScene, settings, multiThreaded);
+
+		OKAY_CHECK(equalVolumes(singleThreaded, multiThreaded));
+	}
+}
+
+OKAY_TEST(irradianceBakeChangesWithSeed)
+{
+	BakeScene bakeScene = createTestScene();
+	IrradianceBakeSettings settings = createTestSettings();
+
+	IrradianceVolume volumeA;
+	bakeIrradianceVolume(bakeScene, settings, volumeA);
+
+	settings.seed++;
+	IrradianceVolume volumeB;
+	bakeIrradianceVolume(bakeScene, settings, volumeB);
+
+	OKAY_CHECK(volumeA.gridSize == volumeB.gridSize);
+	OKAY_CHECK(!equalVolumes(volumeA, volumeB));
+}
+
+OKAY_TEST(irradianceBakeKeyRejectsStaleFiles)
+{
+	BakeScene bakeScene = createTestScene();
+	IrradianceBakeSettings settings = createTestSettings();
+	settings.numSamples = 4;
+
+	IrradianceVolume volume;
+	bakeIrradianceVolume(bakeScene, settings, volume);
+
+	uint64_t sourceKey = getBakeSourceKey(bakeScene, settings);
+	OKAY_CHECK(volume.sourceKey == sourceKey);
+
+	FilePath path = std::filesystem::temp_directory_path() / "okayBakeKey.probes";
+	OKAY_CHECK(writeIrradianceVolume(path, volume));
+
+	IrradianceVolume readVolume;
+	OKAY_CHECK(readIrradianceVolume(path, sourceKey, readVolume));
+	OKAY_CHECK(equalVolumes(volume, readVolume));
+
+	// The thread count doesn't change the result, so it doesn't change the key
+	IrradianceBakeSettings otherThreads = settings;
+	otherThreads.numThreads = 3;
+	OKAY_CHECK(getBakeSourceKey(bakeScene, otherThreads) == sourceKey);
+
+	// Every other change has to rebake
+	std::vector<uint64_t> staleKeys;
+
+	BakeScene movedLight = bakeScene;
+	movedLight.lights[0].position.x += 1.f;
+	staleKeys.emplace_back(getBakeSourceKey(movedLight, settings));
+
+	BakeScene retunedLight = bakeScene;
+	retunedLight.lights[1].intensity *= 2.f;
+	staleKeys.emplace_back(getBakeSourceKey(retunedLight, settings));
+
+	BakeScene notBakedOnly = bakeScene;
+	notBakedOnly.lights[1].bakedOnly = false;
+	staleKeys.emplace_back(getBakeSourceKey(notBakedOnly, settings));
+
+	BakeScene addedLight = bakeScene;
+	addedLight.lights.emplace_back(bakeScene.lights[0]);
+	staleKeys.emplace_back(getBakeSourceKey(addedLight, settings));
+
+	BakeScene removedLight = bakeScene;
+	removedLight.lights.pop_back();
+	staleKeys.emplace_back(getBakeSourceKey(removedLight, settings));
+
+	BakeScene movedTriangle = bakeScene;
+	movedTriangle.trianglePositions[5].y += 0.5f;
+	staleKeys.emplace_back(getBakeSourceKey(movedTriangle, settings));
+
+	IrradianceBakeSettings moreBounces = settings;
+	moreBounces.numBounces++;
+	staleKeys.emplace_back(getBakeSourceKey(bakeScene, moreBounces));
+
+	IrradianceBakeSettings otherSky = settings;
+	otherSky.skyColour.b += 0.01f;
+	staleKeys.emplace_back(getBakeSourceKey(bakeScene, otherSky));
+
+	IrradianceBakeSettings otherSeed = settings;
+	otherSeed.seed++;
+	staleKeys.emplace_back(getBakeSourceKey(bakeScene, otherSeed));
+
+	for (uint64_t staleKey : staleKeys)
+	{
+		OKAY_CHECK(staleKey != sourceKey);
+		OKAY_CHECK(!readIrradianceVolume(path, staleKey, readVolume));
+	}
+
+	std::filesystem::remove(path);
+}
+
+OKAY_TEST(irradianceBakeSkipsDynamicLights)
+{
+	Scene scene;
+	ResourceManager resourceManager;
+
+	Entity bulb = scene.createEntity();
+	bulb.getComponent<Transform>().position = glm::vec3(150.f, 100.f, 150.f);
+	bulb.addComponent<PointLight>().intensity = 50.f;
+	bulb.addComponent<StaticLight>();
+
+	Entity sun = scene.createEntity();
+	sun.getComponent<Transform>().rotation.x = 60.f;
+	sun.addComponent<DirectionalLight>().intensity = 2.f;
+	sun.addComponent<StaticLight>();
+
+	// Follows the camera, so it isn't baked
+	Entity camera = scene.createEntity();
+	camera.getComponent<Transform>().position = glm::vec3(0.f, 150.f, -200.f);
+	camera.addComponent<PointLight>().intensity = 100.f;
+
+	IrradianceBakeSettings settings = createTestSettings();
+	settings.numSamples = 4;
+
+	BakeScene bakeScene;
+	createBakeScene(scene, resourceManager, bakeScene);
+	OKAY_CHECK(bakeScene.lights.size() == 2);
+
+	uint64_t sourceKey = getBakeSourceKey(bakeScene, settings);
+
+	camera.getComponent<Transform>().position = glm::vec3(-100.f, 50.f, 200.f);
+	camera.getComponent<PointLight>().intensity = 10.f;
+
+	BakeScene movedCameraScene;
+	createBakeScene(scene, resourceManager, movedCameraScene);
+	OKAY_CHECK(getBakeSourceKey(movedCameraScene, settings) == sourceKey);
+
+	BakeScene roomScene = createTestScene();
+	bakeScene.trianglePositions = roomScene.trianglePositions;
+	movedCameraScene.trianglePositions = roomScene.trianglePositions;
+
+	IrradianceVolume volume;
+	IrradianceVolume movedCameraVolume;
+	bakeIrradianceVolume(bakeScene, settings, volume);
+	bakeIrradianceVolume(movedCameraScene, settings, movedCameraVolume);
+	OKAY_CHECK(equalVolumes(volume, movedCameraVolume));
+
+	// Marking the camera light static makes it part of the bake
+	camera.addComponent<StaticLight>();
+
+	BakeScene staticCameraScene;
+	createBakeScene(scene, resourceManager, staticCameraScene);
+	OKAY_CHECK(staticCameraScene.lights.size() == 3);
+	OKAY_CHECK(getBakeSourceKey(staticCameraScene, settings) != sourceKey);
+}
+
+OKAY_TEST(bvhBuildIsDeterministic)
+{
+	BakeScene bakeScene = createTestScene();
+
+	BVH bvhA;
+	BVH bvhB;
+	bvhA.build(bakeScene.trianglePositions);
+	bvhB.build(bakeScene.trianglePositions);
+
+	OKAY_CHECK(bvhA.getNumTriangles() == bakeScene.trianglePositions.size() / 3);
+	OKAY_CHECK(bvhA.getNumNodes() == bvhB.getNumNodes());
+
+	// Both trees give the same hits
+	TestRandom random(3);
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		glm::vec3 origin = glm::vec3(random.nextFloat(-250.f, 250.f), random.nextFloat(10.f, 290.f), random.nextFloat(-250.f, 250.f));
+		glm::vec3 direction = glm::normalize(glm::vec3(random.nextFloat(-1.f, 1.f), random.nextFloat(-1.f, 1.f), random.nextFloat(-1.f, 1.f)));
+
+		BVHHit hitA;
+		BVHHit hitB;
+		bool hasHitA = bvhA.intersect(origin, direction, 10000.f, &hitA);
+		bool hasHitB = bvhB.intersect(origin, direction, 10000.f, &hitB);
+
+		OKAY_CHECK(hasHitA == hasHitB);
+		OKAY_CHECK(hitA.triangleIdx == hitB.triangleIdx);
+		OKAY_CHECK(hitA.distance == hitB.distance);
+		OKAY_CHECK(hasHitA == bvhA.occluded(origin, direction, 10000.f));
+	}
+}
@@ -0,0 +1,366 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/LightRecordCache.h"
+#include "Engine/Graphics/Handlers/LightRecords.h"
+
+#include <cstring>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// Same as LightHandler, POINT_LIGHT_RANGE & SPOT_LIGHT_RANGE, DIR_LIGHT_NUM_CASCADES & DIR_LIGHT_CASCADE_SPLIT_LAMBDA
+static const float LIGHT_RANGE = 3000.f;
+static const uint32_t NUM_CASCADES = 3;
+static const float CASCADE_SPLIT_LAMBDA = 0.75f;
+static const uint32_t SHADOW_RESOLUTION = 1024;
+
+typedef LightRecordCache<PointLightInputs, GPUPointLight, PointLightShadowData> PointLightCache;
+typedef LightRecordCache<SpotLightInputs, GPUSpotLight, LightShadowData> SpotLightCache;
+typedef LightRecordCache<DirLightInputs, GPUDirectionalLight, LightShadowData> DirLightCache;
+
+// The components of a light entity, like the scene has them
+template<typename LightT>
+struct TestLight
+{
+	LightT light;
+	Transform transform;
+	bool castsShadow = false;
+};
+
+static Transform createTransform(TestRandom& random)
+{
+	Transform transform;
+	transform.position = glm::vec3(random.nextFloat(-500.f, 500.f), random.nextFloat(0.f, 50.f), random.nextFloat(-500.f, 500.f));
+	transform.rotation = glm::vec3(random.nextFloat(-60.f, 60.f), random.nextFloat(-180.f, 180.f), 0.f);
+
+	return transform;
+}
+
+static std::vector<TestLight<PointLight>> createPointLights(uint32_t numLights, TestRandom& random)
+{
+	std::vector<TestLight<PointLight>> lights(numLights);
+	for (TestLight<PointLight>& light : lights)
+	{
+		light.light.colour = glm::vec3(random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f));
+		light.light.intensity = random.nextFloat(1.f, 10.f);
+		light.light.attenuation = glm::vec2(0.f, 0.01f);
+		light.transform = createTransform(random);
+		light.castsShadow = random.next(2);
+	}
+
+	return lights;
+}
+
+static std::vector<TestLight<SpotLight>> createSpotLights(uint32_t numLights, TestRandom& random)
+{
+	std::vector<TestLight<SpotLight>> lights(numLights);
+	for (TestLight<SpotLight>& light : lights)
+	{
+		light.light.colour = glm::vec3(random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f));
+		light.light.intensity = random.nextFloat(1.f, 10.f);
+		light.light.attenuation = glm::vec2(0.f, 0.01f);
+		light.light.spreadAngle = random.nextFloat(20.f, 90.f);
+		light.transform = createTransform(random);
+		light.castsShadow = random.next(2);
+	}
+
+	return lights;
+}
+
+static std::vector<TestLight<DirectionalLight>> createDirLights(uint32_t numLights, TestRandom& random)
+{
+	std::vector<TestLight<DirectionalLight>> lights(numLights);
+	for (TestLight<DirectionalLight>& light : lights)
+	{
+		light.light.colour = glm::vec3(random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f));
+		light.light.intensity = random.nextFloat(1.f, 10.f);
+		light.transform.rotation = glm::vec3(random.nextFloat(20.f, 80.f), random.nextFloat(-180.f, 180.f), 0.f);
+		light.castsShadow = true;
+	}
+
+	return lights;
+}
+
+static CascadeCamera createCascadeCamera(glm::vec3 position)
+{
+	CascadeCamera camera;
+	camera.position = position;
+	camera.forward = glm::normalize(glm::vec3(0.3f, -0.2f, 1.f));
+	camera.fovY = glm::radians(70.f);
+	camera.aspectRatio = 16.f / 9.f;
+	camera.nearZ = 1.f;
+	camera.farZ = 4000.f;
+
+	return camera;
+}
+
+// What writePointLightGPUData, writeSpotLightGPUData & writeDirLightGPUData do every frame, returns the number of regenerated records
+static uint32_t updatePointLights(PointLightCache& cache, const std::vector<TestLight<PointLight>>& lights)
+{
+	cache.beginFrame((uint32_t)lights.size());
+
+	for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+	{
+		PointLightInputs inputs = createPointLightInputs(i, lights[i].light, lights[i].transform, lights[i].castsShadow);
+		if (cache.update(i, inputs))
+		{
+			generatePointLightRecord(inputs, LIGHT_RANGE, cache.getRecord(i), cache.getShadowData(i));
+		}
+	}
+
+	return cache.getNumRegenerated();
+}
+
+static uint32_t updateSpotLights(SpotLightCache& cache, const std::vector<TestLight<SpotLight>>& lights)
+{
+	cache.beginFrame((uint32_t)lights.size());
+
+	for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+	{
+		SpotLightInputs inputs = createSpotLightInputs(i, lights[i].light, lights[i].transform, lights[i].castsShadow, SHADOW_RESOLUTION);
+		if (cache.update(i, inputs))
+		{
+			generateSpotLightRecord(inputs, LIGHT_RANGE, cache.getRecord(i), cache.getShadowData(i));
+		}
+	}
+
+	return cache.getNumRegenerated();
+}
+
+static uint32_t updateDirLights(DirLightCache& cache, const std::vector<TestLight<DirectionalLight>>& lights, const CascadeCamera& camera)
+{
+	float cascadeSplitFars[MAX_SHADOW_CASCADES] = {};
+	computeCascadeSplits(camera.nearZ, camera.farZ, NUM_CASCADES, CASCADE_SPLIT_LAMBDA, cascadeSplitFars);
+
+	glm::vec3 sceneBoundsMin = glm::vec3(-1000.f, -10.f, -1000.f);
+	glm::vec3 sceneBoundsMax = glm::vec3(1000.f, 200.f, 1000.f);
+
+	cache.beginFrame((uint32_t)lights.size());
+
+	for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+	{
+		DirLightInputs inputs = createDirLightInputs(i, lights[i].light, lights[i].transform, lights[i].castsShadow, SHADOW_RESOLUTION, camera, sceneBoundsMin, sceneBoundsMax);
+		if (cache.update(i, inputs))
+		{
+			generateDirLightRecord(inputs, NUM_CASCADES, cascadeSplitFars, cache.getRecord(i), cache.getShadowData(i));
+		}
+	}
+
+	return cache.getNumRegenerated();
+}
+
+// The cached records & shadow data are exactly what regenerating every light gives
+template<typename CacheT>
+static bool isSameAsRegenerated(CacheT& cache, CacheT& regeneratedCache)
+{
+	bool same = cache.getNumRecords() == regeneratedCache.getNumRecords();
+	for (uint32_t i = 0; same && i < cache.getNumRecords(); i++)
+	{
+		same &= !memcmp(&cache.getRecord(i), &regeneratedCache.getRecord(i), sizeof(cache.getRecord(i)));
+		same &= !memcmp(&cache.getShadowData(i), &regeneratedCache.getShadowData(i), sizeof(cache.getShadowData(i)));
+	}
+
+	return same;
+}
+
+OKAY_TEST(lightRecordCacheSpotLights)
+{
+	TestRandom random(1);
+	std::vector<TestLight<SpotLight>> lights = createSpotLights(100, random);
+
+	SpotLightCache cache;
+	OKAY_CHECK(updateSpotLights(cache, lights) == 100);
+	OKAY_CHECK(updateSpotLights(cache, lights) == 0);
+
+	lights[10].transform.position.x += 1.f;
+	lights[50].light.intensity *= 2.f;
+	lights[60].transform.rotation.y += 5.f;
+	OKAY_CHECK(updateSpotLights(cache, lights) == 3);
+	OKAY_CHECK(cache.getRecord(10).position == lights[10].transform.position);
+	OKAY_CHECK(cache.getRecord(50).intensity == lights[50].light.intensity);
+	OKAY_CHECK(glm::all(glm::epsilonEqual(cache.getRecord(60).direction, lights[60].transform.forwardVec(), 1e-6f)));
+
+	// Two lights trading places in the view order
+	std::swap(lights[20], lights[21]);
+	OKAY_CHECK(updateSpotLights(cache, lights) == 2);
+
+	// Losing the shadow map regenerates the record too
+	lights[30].castsShadow = !lights[30].castsShadow;
+	OKAY_CHECK(updateSpotLights(cache, lights) == 1);
+
+	SpotLightCache regeneratedCache;
+	updateSpotLights(regeneratedCache, lights);
+	OKAY_CHECK(isSameAsRegenerated(cache, regeneratedCache));
+}
+
+OKAY_TEST(lightRecordCachePointLightShadowMatrices)
+{
+	TestRandom random(2);
+	std::vector<TestLight<PointLight>> lights = createPointLights(100, random);
+
+	PointLightCache cache;
+	OKAY_CHECK(updatePointLights(cache, lights) == 100);
+	OKAY_CHECK(updatePointLights(cache, lights) == 0);
+
+	// Only rotating or scaling a point light changes nothing
+	lights[5].transform.rotation.y += 90.f;
+	lights[6].transform.scale = glm::vec3(2.f);
+	OKAY_CHECK(updatePointLights(cache, lights) == 0);
+
+	for (uint32_t frame = 0; frame < 10; frame++)
+	{
+		lights[frame * 7].transform.position.y += 1.f;
+		lights[frame * 7 + 1].castsShadow = !lights[frame * 7 + 1].castsShadow;
+		OKAY_CHECK(updatePointLights(cache, lights) == 2);
+	}
+
+	// Every face sees the point straight down its axis from the light in the middle of the face, in the D3D cube face order
+	static const glm::vec3 FACE_DIRECTIONS[6] =
+	{
+		glm::vec3(1.f, 0.f, 0.f), glm::vec3(-1.f, 0.f, 0.f),
+		glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, -1.f, 0.f),
+		glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, -1.f),
+	};
+
+	bool facesCorrect = true;
+	uint32_t numShadowLights = 0;
+	for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+	{
+		const PointLightShadowData& shadowData = cache.getShadowData(i);
+		if (!shadowData.castsShadow)
+		{
+			continue;
+		}
+
+		numShadowLights++;
+		facesCorrect &= cache.getRecord(i).farPlane == LIGHT_RANGE;
+
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			// Stored transposed for the GPU
+			glm::vec4 clipPosition = glm::transpose(shadowData.viewProjMatrices[face]) * glm::vec4(lights[i].transform.position + FACE_DIRECTIONS[face] * 100.f, 1.f);
+			glm::vec3 ndc = glm::vec3(clipPosition) / clipPosition.w;
+
+			facesCorrect &= clipPosition.w > 0.f && glm::abs(ndc.x) < 1e-4f && glm::abs(ndc.y) < 1e-4f && ndc.z > 0.f && ndc.z < 1.f;
+		}
+	}
+
+	OKAY_CHECK(facesCorrect);
+	OKAY_CHECK(numShadowLights > 0);
+
+	PointLightCache regeneratedCache;
+	updatePointLights(regeneratedCache, lights);
+	OKAY_CHECK(isSameAsRegenerated(cache, regeneratedCache));
+}
+
+OKAY_TEST(lightRecordCacheDirectionalLights)
+{
+	TestRandom random(3);
+	std::vector<TestLight<DirectionalLight>> lights = createDirLights(4, random);
+	lights[3].castsShadow = false;
+
+	CascadeCamera camera = createCascadeCamera(glm::vec3(0.f, 20.f, 0.f));
+
+	DirLightCache cache;
+	OKAY_CHECK(updateDirLights(cache, lights, camera) == 4);
+	OKAY_CHECK(updateDirLights(cache, lights, camera) == 0);
+
+	OKAY_CHECK(cache.getRecord(0).numCascades == NUM_CASCADES);
+	OKAY_CHECK(cache.getRecord(3).numCascades == 0);
+
+	// The cascades follow the camera, every light changes
+	camera.position.x += 10.f;
+	OKAY_CHECK(updateDirLights(cache, lights, camera) == 4);
+
+	lights[1].transform.rotation.x += 1.f;
+	OKAY_CHECK(updateDirLights(cache, lights, camera) == 1);
+
+	DirLightCache regeneratedCache;
+	updateDirLights(regeneratedCache, lights, camera);
+	OKAY_CHECK(isSameAsRegenerated(cache, regeneratedCache));
+}
+
+OKAY_TEST(lightRecordCacheRestartsOnCountChange)
+{
+	TestRandom random(4);
+	std::vector<TestLight<SpotLight>> lights = createSpotLights(10, random);
+
+	SpotLightCache cache;
+	updateSpotLights(cache, lights);
+
+	lights.emplace_back(createSpotLights(1, random)[0]);
+	OKAY_CHECK(updateSpotLights(cache, lights) == 11);
+
+	lights.erase(lights.begin() + 3);
+	OKAY_CHECK(updateSpotLights(cache, lights) == 10);
+	OKAY_CHECK(updateSpotLights(cache, lights) == 0);
+}
+
+// Regenerating every record every frame (what the write*GPUData functions did before the cache) against the cache with a share of
+// the lights moving. Point lights all cast shadows here, their 6 face matrices are the expensive part
+template<typename LightT, typename CacheT, typename UpdateFunc>
+static void benchmarkLightRecords(const char* pName, std::vector<TestLight<LightT>> lights, UpdateFunc update)
+{
+	static const uint32_t NUM_FRAMES = 200;
+	uint32_t numLights = (uint32_t)lights.size();
+
+	double fullMs = measureMs(NUM_FRAMES, [&]()
+	{
+		CacheT cache;
+		update(cache, lights);
+	});
+
+	printf("    %s, regenerating every record: %.4f ms / frame\n", pName, fullMs);
+
+	for (uint32_t percentMoving : { 0u, 1u, 10u, 100u })
+	{
+		CacheT cache;
+		update(cache, lights);
+
+		uint32_t numMoving = numLights * percentMoving / 100;
+		uint32_t numRegenerated = 0;
+
+		double cachedMs = measureMs(NUM_FRAMES, [&]()
+		{
+			for (uint32_t i = 0; i < numMoving; i++)
+			{
+				lights[i].transform.position.y += 0.01f;
+				lights[i].transform.rotation.x += 0.01f;
+			}
+
+			numRegenerated += update(cache, lights);
+		});
+
+		printf("    %s, cached, %3u%% moving:     %.4f ms / frame (%u regenerated / frame)\n", pName, percentMoving, cachedMs, numRegenerated / NUM_FRAMES);
+		OKAY_CHECK(numRegenerated == numMoving * NUM_FRAMES);
+	}
+}
+
+OKAY_BENCHMARK(lightRecordCache1000Lights)
+{
+	static const uint32_t NUM_LIGHTS = 1000;
+
+	TestRandom random(5);
+
+	std::vector<TestLight<PointLight>> pointLights = createPointLights(NUM_LIGHTS, random);
+	for (TestLight<PointLight>& light : pointLights)
+	{
+		light.castsShadow = true;
+	}
+
+	std::vector<TestLight<SpotLight>> spotLights = createSpotLights(NUM_LIGHTS, random);
+	for (TestLight<SpotLight>& light : spotLights)
+	{
+		light.castsShadow = true;
+	}
+
+	benchmarkLightRecords<PointLight, PointLightCache>("Point", pointLights, updatePointLights);
+	benchmarkLightRecords<SpotLight, SpotLightCache>("Spot ", spotLights, updateSpotLights);
+
+	// A handful of directional lights is all a scene has, their cascades depend on the camera so a static camera is what's cached
+	CascadeCamera camera = createCascadeCamera(glm::vec3(0.f, 20.f, 0.f));
+	benchmarkLightRecords<DirectionalLight, DirLightCache>("Dir  ", createDirLights(4, random), [&](DirLightCache& cache, const std::vector<TestLight<DirectionalLight>>& lights)
+	{
+		return updateDirLights(cache, lights, camera);
+	});
+}
@@ -0,0 +1,210 @@
+#include "Tests.h"
+
+#include "Engine/Resources/MeshMerger.h"
+
+#include "glm/gtc/epsilon.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static MeshMergeObject createObject(uint32_t meshIdx, AssetID diffuseTextureID, AssetID normalMapID, glm::vec3 position)
+{
+	MeshMergeObject object;
+	object.meshIdx = meshIdx;
+	object.diffuseTextureID = diffuseTextureID;
+	object.normalMapID = normalMapID;
+	object.transformMatrix = glm::translate(glm::mat4(1.f), position);
+
+	return object;
+}
+
+// One triangle facing +Z, with its normal & tangents
+static MeshData createTriangleMesh()
+{
+	MeshData meshData;
+	meshData.verticies.resize(3);
+	meshData.verticies[0].position = glm::vec3(0.f, 0.f, 0.f);
+	meshData.verticies[1].position = glm::vec3(1.f, 0.f, 0.f);
+	meshData.verticies[2].position = glm::vec3(0.f, 1.f, 0.f);
+
+	for (Vertex& vertex : meshData.verticies)
+	{
+		vertex.normal = glm::vec3(0.f, 0.f, 1.f);
+		vertex.tangent = glm::vec3(1.f, 0.f, 0.f);
+		vertex.biTangent = glm::vec3(0.f, 1.f, 0.f);
+	}
+
+	meshData.indicies = { 0, 1, 2 };
+	return meshData;
+}
+
+static glm::vec3 getTriangleNormal(const MeshData& meshData, uint32_t firstIndex)
+{
+	glm::vec3 p0 = meshData.verticies[meshData.indicies[firstIndex]].position;
+	glm::vec3 p1 = meshData.verticies[meshData.indicies[firstIndex + 1ull]].position;
+	glm::vec3 p2 = meshData.verticies[meshData.indicies[firstIndex + 2ull]].position;
+
+	return glm::normalize(glm::cross(p1 - p0, p2 - p0));
+}
+
+static bool nearlyEqual(glm::vec3 a, glm::vec3 b)
+{
+	return glm::all(glm::epsilonEqual(a, b, 1e-5f));
+}
+
+OKAY_TEST(meshMergeGroupsByTexturesAndCell)
+{
+	std::vector<glm::vec4> boundingSpheres(6, glm::vec4(0.f, 0.f, 0.f, 1.f));
+	std::vector<uint32_t> vertexCounts(6, 10);
+
+	std::vector<MeshMergeObject> objects;
+	objects.emplace_back(createObject(0, 1, 2, glm::vec3(10.f, 0.f, 0.f)));
+	objects.emplace_back(createObject(1, 1, 2, glm::vec3(20.f, 0.f, 0.f)));
+	objects.emplace_back(createObject(2, 1, 2, glm::vec3(1500.f, 0.f, 0.f))); // Next cell
+	objects.emplace_back(createObject(3, 1, 3, glm::vec3(30.f, 0.f, 0.f))); // Other normal map, alone
+	objects.emplace_back(createObject(4, 1, 2, glm::vec3(40.f, 0.f, 0.f)));
+	objects.emplace_back(createObject(5, 1, 2, glm::vec3(1600.f, 0.f, 0.f)));
+
+	std::vector<MeshMergeBatch> batches;
+	findMeshMergeBatches(objects, boundingSpheres, vertexCounts, MeshMergeSettings(), batches);
+
+	OKAY_CHECK(batches.size() == 2);
+	if (batches.size() == 2)
+	{
+		OKAY_CHECK(batches[0].objectIndicies == std::vector<uint32_t>({ 0, 1, 4 }));
+		OKAY_CHECK(batches[0].numVerticies == 30);
+		OKAY_CHECK(batches[1].objectIndicies == std::vector<uint32_t>({ 2, 5 }));
+		OKAY_CHECK(batches[1].numVerticies == 20);
+	}
+
+	// The cell comes from the transformed bounding sphere center, not the object origin
+	boundingSpheres[3] = glm::vec4(-1000.f, 0.f, 0.f, 1.f);
+	objects[3] = createObject(3, 1, 2, glm::vec3(1500.f, 0.f, 0.f));
+
+	findMeshMergeBatches(objects, boundingSpheres, vertexCounts, MeshMergeSettings(), batches);
+
+	OKAY_CHECK(batches.size() == 2);
+	if (batches.size() == 2)
+	{
+		OKAY_CHECK(batches[0].objectIndicies == std::vector<uint32_t>({ 0, 1, 3, 4 }));
+	}
+}
+
+OKAY_TEST(meshMergeSkipsSharedMeshes)
+{
+	std::vector<glm::vec4> boundingSpheres(4, glm::vec4(0.f, 0.f, 0.f, 1.f));
+	std::vector<uint32_t> vertexCounts(4, 10);
+
+	// Mesh 0 is instanced, already one draw for both objects
+	std::vector<MeshMergeObject> objects;
+	objects.emplace_back(createObject(0, 1, 2, glm::vec3(0.f)));
+	objects.emplace_back(createObject(0, 1, 2, glm::vec3(50.f, 0.f, 0.f)));
+	objects.emplace_back(createObject(1, 1, 2, glm::vec3(100.f, 0.f, 0.f)));
+	objects.emplace_back(createObject(2, 1, 2, glm::vec3(150.f, 0.f, 0.f)));
+
+	std::vector<MeshMergeBatch> batches;
+	findMeshMergeBatches(objects, boundingSpheres, vertexCounts, MeshMergeSettings(), batches);
+
+	OKAY_CHECK(batches.size() == 1);
+	if (batches.size() == 1)
+	{
+		OKAY_CHECK(batches[0].objectIndicies == std::vector<uint32_t>({ 2, 3 }));
+	}
+
+	// Sharing the last single use mesh leaves nothing to merge
+	objects[3].meshIdx = 1;
+	findMeshMergeBatches(objects, boundingSpheres, vertexCounts, MeshMergeSettings(), batches);
+	OKAY_CHECK(batches.empty());
+}
+
+OKAY_TEST(meshMergeSplitsAtMaxVerticies)
+{
+	MeshMergeSettings settings;
+	settings.maxVerticies = 100;
+
+	std::vector<glm::vec4> boundingSpheres(7, glm::vec4(0.f, 0.f, 0.f, 1.f));
+	std::vector<uint32_t> vertexCounts = { 40, 40, 40, 40, 40, 20, 101 };
+
+	std::vector<MeshMergeObject> objects;
+	for (uint32_t i = 0; i < (uint32_t)vertexCounts.size(); i++)
+	{
+		objects.emplace_back(createObject(i, 1, 2, glm::vec3(i * 10.f, 0.f, 0.f)));
+	}
+
+	std::vector<MeshMergeBatch> batches;
+	findMeshMergeBatches(objects, boundingSpheres, vertexCounts, settings, batches);
+
+	// Filled in order, the mesh over the limit is never merged
+	OKAY_CHECK(batches.size() == 3);
+	if (batches.size() == 3)
+	{
+		OKAY_CHECK(batches[0].objectIndicies == std::vector<uint32_t>({ 0, 1 }));
+		OKAY_CHECK(batches[1].objectIndicies == std::vector<uint32_t>({ 2, 3 }));
+		OKAY_CHECK(batches[2].objectIndicies == std::vector<uint32_t>({ 4, 5 }));
+		OKAY_CHECK(batches[2].numVerticies == 60);
+	}
+
+	for (const MeshMergeBatch& batch : batches)
+	{
+		OKAY_CHECK(batch.numVerticies <= settings.maxVerticies);
+	}
+
+	// A batch that would end up with a single object is dropped
+	vertexCounts[5] = 70;
+	findMeshMergeBatches(objects, boundingSpheres, vertexCounts, settings, batches);
+	OKAY_CHECK(batches.size() == 2);
+}
+
+OKAY_TEST(meshMergeFlipsMirroredWinding)
+{
+	MeshData triangle = createTriangleMesh();
+
+	MeshData mergedData;
+	appendTransformedMesh(triangle, glm::translate(glm::mat4(1.f), glm::vec3(5.f, 0.f, 0.f)), mergedData);
+	appendTransformedMesh(triangle, glm::scale(glm::mat4(1.f), glm::vec3(-1.f, 1.f, 1.f)), mergedData);
+
+	OKAY_CHECK(mergedData.verticies.size() == 6);
+	OKAY_CHECK(mergedData.indicies == std::vector<uint32_t>({ 0, 1, 2, 3, 5, 4 }));
+	OKAY_CHECK(mergedData.verticies[1].position == glm::vec3(6.f, 0.f, 0.f));
+	OKAY_CHECK(mergedData.verticies[4].position == glm::vec3(-1.f, 0.f, 0.f));
+
+	// The triangles still face the way their normals point
+	for (uint32_t i = 0; i < (uint32_t)mergedData.indicies.size(); i += 3)
+	{
+		glm::vec3 vertexNormal = mergedData.verticies[mergedData.indicies[i]].normal;
+		OKAY_CHECK(glm::dot(getTriangleNormal(mergedData, i), vertexNormal) > 0.99f);
+	}
+}
+
+OKAY_TEST(meshMergeTransformsNormalsAndTangents)
+{
+	MeshData meshData = createTriangleMesh();
+	meshData.verticies[0].normal = glm::normalize(glm::vec3(1.f, 1.f, 0.f));
+	meshData.verticies[0].tangent = glm::normalize(glm::vec3(1.f, -1.f, 0.f));
+	meshData.verticies[0].biTangent = glm::vec3(0.f, 0.f, 1.f);
+
+	// Non uniform scale, a rotation & a translation that mustn't touch the directions
+	glm::mat4 transformMatrix = glm::translate(glm::mat4(1.f), glm::vec3(100.f, 200.f, 300.f));
+	transformMatrix = glm::rotate(transformMatrix, glm::radians(90.f), glm::vec3(0.f, 0.f, 1.f));
+	transformMatrix = glm::scale(transformMatrix, glm::vec3(2.f, 1.f, 1.f));
+
+	MeshData mergedData;
+	appendTransformedMesh(meshData, transformMatrix, mergedData);
+
+	const Vertex& vertex = mergedData.verticies[0];
+	OKAY_CHECK(nearlyEqual(vertex.position, glm::vec3(100.f, 200.f, 300.f)));
+
+	// Scaled (0.5, 1, 0) by the inverse transpose then rotated, tangents scaled (2, -1, 0) directly then rotated
+	OKAY_CHECK(nearlyEqual(vertex.normal, glm::normalize(glm::vec3(-1.f, 0.5f, 0.f))));
+	OKAY_CHECK(nearlyEqual(vertex.tangent, glm::normalize(glm::vec3(1.f, 2.f, 0.f))));
+	OKAY_CHECK(nearlyEqual(vertex.biTangent, glm::vec3(0.f, 0.f, 1.f)));
+
+	// Still perpendicular & unit length
+	OKAY_CHECK(glm::abs(glm::dot(vertex.normal, vertex.tangent)) < 1e-5f);
+	OKAY_CHECK(glm::abs(glm::length(vertex.normal) - 1.f) < 1e-5f);
+	OKAY_CHECK(glm::abs(glm::length(vertex.tangent) - 1.f) < 1e-5f);
+
+	// UVs are copied as they are
+	OKAY_CHECK(mergedData.verticies[2].uv == meshData.verticies[2].uv);
+}
@@ -0,0 +1,196 @@
+#include "Tests.h"
+
+#include "Engine/Resources/MeshOptimizer.h"
+
+#include "glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// A UV sphere with its triangles shuffled, like a mesh from an exporter that doesn't care about order
+static MeshData createShuffledSphere(uint32_t resolution, uint32_t seed)
+{
+	MeshData meshData;
+	for (uint32_t y = 0; y <= resolution; y++)
+	{
+		for (uint32_t x = 0; x <= resolution; x++)
+		{
+			float theta = glm::pi<float>() * y / resolution;
+			float phi = glm::two_pi<float>() * x / resolution;
+
+			Vertex vertex;
+			vertex.position = glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+			vertex.normal = vertex.position;
+			vertex.uv = glm::vec2((float)x / resolution, (float)y / resolution);
+			meshData.verticies.emplace_back(vertex);
+		}
+	}
+
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (uint32_t y = 0; y < resolution; y++)
+	{
+		for (uint32_t x = 0; x < resolution; x++)
+		{
+			uint32_t a = y * (resolution + 1) + x;
+			uint32_t b = a + 1;
+			uint32_t c = a + resolution + 1;
+			uint32_t d = c + 1;
+
+			triangles.push_back({ a, c, b });
+			triangles.push_back({ b, c, d });
+		}
+	}
+
+	TestRandom random(seed);
+	for (uint32_t i = (uint32_t)triangles.size() - 1; i > 0; i--)
+	{
+		std::swap(triangles[i], triangles[random.next(i + 1)]);
+	}
+
+	for (const std::array<uint32_t, 3>& triangle : triangles)
+	{
+		meshData.indicies.insert(meshData.indicies.end(), triangle.begin(), triangle.end());
+	}
+
+	return meshData;
+}
+
+// Every triangle as positions rotated to start at the smallest one, so the winding is kept. Sorted
+static std::vector<std::array<float, 9>> getSortedTriangles(const MeshData& meshData)
+{
+	std::vector<std::array<float, 9>> triangles;
+	for (uint32_t i = 0; i + 2 < (uint32_t)meshData.indicies.size(); i += 3)
+	{
+		glm::vec3 positions[3];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			positions[j] = meshData.verticies[meshData.indicies[i + j]].position;
+		}
+
+		uint32_t first = 0;
+		for (uint32_t j = 1; j < 3; j++)
+		{
+			if (std::tie(positions[j].x, positions[j].y, positions[j].z) < std::tie(positions[first].x, positions[first].y, positions[first].z))
+			{
+				first = j;
+			}
+		}
+
+		std::array<float, 9> triangle;
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			glm::vec3 position = positions[(first + j) % 3];
+			triangle[j * 3 + 0] = position.x;
+			triangle[j * 3 + 1] = position.y;
+			triangle[j * 3 + 2] = position.z;
+		}
+
+		triangles.emplace_back(triangle);
+	}
+
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+OKAY_TEST(vertexCacheAnalysis)
+{
+	// Two triangles sharing an edge, 4 verticies transformed
+	std::vector<uint32_t> indicies = { 0, 1, 2, 2, 1, 3 };
+	VertexCacheStats stats = analyzeVertexCache(indicies, 4);
+	OKAY_CHECK(stats.numTriangles == 2);
+	OKAY_CHECK(stats.numTransformed == 4);
+	OKAY_CHECK(stats.getACMR() == 2.f);
+	OKAY_CHECK(stats.getATVR() == 1.f);
+
+	// Vertex 0 is pushed out of a 3 entry FIFO before it's used again
+	indicies = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+	OKAY_CHECK(analyzeVertexCache(indicies, 6, 3).numTransformed == 9);
+	OKAY_CHECK(analyzeVertexCache(indicies, 6, 6).numTransformed == 6);
+}
+
+OKAY_TEST(vertexCacheOptimizationImprovesACMR)
+{
+	MeshData meshData = createShuffledSphere(100, 1);
+	uint32_t numVerticies = (uint32_t)meshData.verticies.size();
+
+	VertexCacheStats before = analyzeVertexCache(meshData.indicies, numVerticies);
+
+	std::vector<uint32_t> clusterOffsets;
+	optimizeVertexCache(meshData.indicies, numVerticies, VERTEX_CACHE_SIZE, &clusterOffsets);
+	VertexCacheStats after = analyzeVertexCache(meshData.indicies, numVerticies);
+
+	printf("    ACMR %.3f -> %.3f\n", before.getACMR(), after.getACMR());
+
+	// A shuffled grid is close to 3, Tipsify on a regular grid gets well under 1
+	OKAY_CHECK(before.getACMR() > 2.f);
+	OKAY_CHECK(after.getACMR() < 0.9f);
+
+	OKAY_CHECK(!clusterOffsets.empty());
+	OKAY_CHECK(clusterOffsets[0] == 0);
+	for (uint32_t i = 0; i < (uint32_t)clusterOffsets.size(); i++)
+	{
+		OKAY_CHECK(clusterOffsets[i] % 3 == 0);
+		OKAY_CHECK(clusterOffsets[i] < meshData.indicies.size());
+		OKAY_CHECK(i == 0 || clusterOffsets[i] > clusterOffsets[i - 1]);
+	}
+}
+
+OKAY_TEST(vertexCacheOptimizationFansOutOfCacheCandidates)
+{
+	// Verticies 1 & 2 both have 2 triangles left after the first one, too many to stay in a 3 entry cache (priority 0).
+	// 1 should still be fanned next instead of jumping to the dead end stack, which would pick 2
+	std::vector<uint32_t> indicies = { 0, 1, 2, 1, 3, 4, 1, 5, 6, 2, 7, 8, 2, 9, 10 };
+
+	std::vector<uint32_t> clusterOffsets;
+	optimizeVertexCache(indicies, 11, 3, &clusterOffsets);
+
+	std::vector<uint32_t> expected = { 0, 1, 2, 1, 3, 4, 1, 5, 6, 2, 7, 8, 2, 9, 10 };
+	OKAY_CHECK(indicies == expected);
+
+	// Both fans start out of the cache
+	OKAY_CHECK(clusterOffsets == std::vector<uint32_t>({ 0, 3, 9 }));
+}
+
+OKAY_TEST(meshOptimizationKeepsTriangles)
+{
+	MeshData meshData = createShuffledSphere(40, 2);
+
+	// Never referenced, should be dropped
+	Vertex unusedVertex;
+	unusedVertex.position = glm::vec3(10.f);
+	meshData.verticies.emplace_back(unusedVertex);
+
+	std::vector<std::array<float, 9>> trianglesBefore = getSortedTriangles(meshData);
+
+	MeshOptimizationStats stats;
+	optimizeMesh(meshData, &stats);
+
+	OKAY_CHECK(getSortedTriangles(meshData) == trianglesBefore);
+	OKAY_CHECK(meshData.verticies.size() == 41 * 41);
+	OKAY_CHECK(stats.after.getACMR() < stats.before.getACMR());
+
+	// Vertex fetch order, every index is at most one past the biggest one before it
+	uint32_t nextNewVertex = 0;
+	bool inFetchOrder = true;
+	for (uint32_t index : meshData.indicies)
+	{
+		inFetchOrder &= index <= nextNewVertex;
+		nextNewVertex = glm::max(nextNewVertex, index + 1);
+	}
+	OKAY_CHECK(inFetchOrder);
+}
+
+OKAY_TEST(meshOptimizationEmptyMesh)
+{
+	MeshData meshData;
+	MeshOptimizationStats stats;
+	optimizeMesh(meshData, &stats);
+
+	OKAY_CHECK(meshData.verticies.empty());
+	OKAY_CHECK(meshData.indicies.empty());
+	OKAY_CHECK(stats.after.getACMR() == 0.f);
+}
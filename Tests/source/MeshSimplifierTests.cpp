@@ -0,0 +1,395 @@
+#include "Tests.h"
+
+#include "Engine/Resources/MeshSimplifier.h"
+#include "Engine/Resources/MeshStreams.h"
+
+#include "glm/gtc/constants.hpp"
+
+#include <cfloat>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static float getBump(glm::vec3 direction, uint32_t seed)
+{
+	return 1.f + 0.04f * glm::sin(direction.x * 7.f + seed) * glm::sin(direction.y * 5.f + direction.z * 3.f);
+}
+
+// A bumpy UV sphere, the verticies at u = 0 & u = 1 share positions so there's a UV seam down one side. Closed, the pole triangles are degenerate
+static MeshData createUVSphere(uint32_t resolution, uint32_t seed)
+{
+	MeshData meshData;
+	for (uint32_t y = 0; y <= resolution; y++)
+	{
+		for (uint32_t x = 0; x <= resolution; x++)
+		{
+			float theta = glm::pi<float>() * y / resolution;
+			float phi = glm::two_pi<float>() * (x % resolution) / resolution;
+
+			// Exact poles & an exact seam, otherwise they'd only be close
+			glm::vec3 direction = glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+			if (y == 0 || y == resolution)
+			{
+				direction = glm::vec3(0.f, y == 0 ? 1.f : -1.f, 0.f);
+			}
+
+			Vertex vertex;
+			vertex.position = direction * getBump(direction, seed);
+			vertex.normal = direction;
+			vertex.uv = glm::vec2((float)x / resolution, (float)y / resolution);
+			meshData.verticies.emplace_back(vertex);
+		}
+	}
+
+	for (uint32_t y = 0; y < resolution; y++)
+	{
+		for (uint32_t x = 0; x < resolution; x++)
+		{
+			uint32_t a = y * (resolution + 1) + x;
+			uint32_t b = a + 1;
+			uint32_t c = a + resolution + 1;
+			uint32_t d = c + 1;
+
+			meshData.indicies.insert(meshData.indicies.end(), { a, c, b, b, c, d });
+		}
+	}
+
+	return meshData;
+}
+
+// A bumpy cube sphere with its own verticies per face, so every cube edge is a hard edge. Corners are computed from integer
+// cube coordinates, so the faces meet at bitwise equal positions
+static MeshData createCubeSphere(uint32_t resolution, uint32_t seed)
+{
+	MeshData meshData;
+
+	for (uint32_t face = 0; face < 6; face++)
+	{
+		uint32_t axis = face / 2;
+		int sign = face % 2 ? -1 : 1;
+
+		uint32_t uAxis = (axis + 1) % 3;
+		uint32_t vAxis = (axis + 2) % 3;
+		uint32_t firstVertex = (uint32_t)meshData.verticies.size();
+
+		for (uint32_t v = 0; v <= resolution; v++)
+		{
+			for (uint32_t u = 0; u <= resolution; u++)
+			{
+				glm::ivec3 cubePosition = glm::ivec3(0);
+				cubePosition[axis] = sign * (int)resolution;
+				cubePosition[uAxis] = 2 * (int)u - (int)resolution;
+				cubePosition[vAxis] = 2 * (int)v - (int)resolution;
+
+				glm::vec3 direction = glm::normalize(glm::vec3(cubePosition));
+
+				Vertex vertex;
+				vertex.position = direction * getBump(direction, seed);
+				vertex.normal = glm::vec3(0.f);
+				vertex.normal[axis] = (float)sign;
+				vertex.uv = glm::vec2((float)u / resolution, (float)v / resolution);
+				meshData.verticies.emplace_back(vertex);
+			}
+		}
+
+		for (uint32_t v = 0; v < resolution; v++)
+		{
+			for (uint32_t u = 0; u < resolution; u++)
+			{
+				uint32_t a = firstVertex + v * (resolution + 1) + u;
+				uint32_t b = a + 1;
+				uint32_t c = a + resolution + 1;
+				uint32_t d = c + 1;
+
+				// Outwards on both the positive & the negative faces
+				if (sign > 0)
+				{
+					meshData.indicies.insert(meshData.indicies.end(), { a, b, c, b, d, c });
+				}
+				else
+				{
+					meshData.indicies.insert(meshData.indicies.end(), { a, c, b, b, c, d });
+				}
+			}
+		}
+	}
+
+	return meshData;
+}
+
+// Every position edge is used once in each direction, so there's no border & nothing non-manifold. Degenerate triangles are skipped
+static bool isClosed(const std::vector<uint32_t>& vertexToPosition, const std::vector<uint32_t>& indicies)
+{
+	std::unordered_map<uint64_t, uint32_t> edgeCounts;
+	for (uint32_t i = 0; i + 2 < (uint32_t)indicies.size(); i += 3)
+	{
+		uint32_t positions[3] = {};
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			positions[j] = vertexToPosition[indicies[i + j]];
+		}
+
+		if (positions[0] == positions[1] || positions[1] == positions[2] || positions[2] == positions[0])
+		{
+			continue;
+		}
+
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			edgeCounts[((uint64_t)positions[j] << 32) | positions[(j + 1) % 3]]++;
+		}
+	}
+
+	for (const auto& [edge, count] : edgeCounts)
+	{
+		auto reverseIt = edgeCounts.find((edge << 32) | (edge >> 32));
+		if (count != 1 || reverseIt == edgeCounts.end() || reverseIt->second != 1)
+		{
+			return false;
+		}
+	}
+
+	return !edgeCounts.empty();
+}
+
+static double getSegmentDistanceSqrd(glm::dvec3 p, glm::dvec3 a, glm::dvec3 b)
+{
+	glm::dvec3 ab = b - a;
+	double t = glm::clamp(glm::dot(p - a, ab) / glm::max(glm::dot(ab, ab), 1e-30), 0.0, 1.0);
+
+	glm::dvec3 toClosest = a + ab * t - p;
+	return glm::dot(toClosest, toClosest);
+}
+
+// Brute force, the plane if the projection is inside the triangle, otherwise the closest edge
+static double getTriangleDistance(glm::dvec3 p, glm::dvec3 a, glm::dvec3 b, glm::dvec3 c)
+{
+	glm::dvec3 normal = glm::cross(b - a, c - a);
+	double normalLengthSqrd = glm::dot(normal, normal);
+
+	if (normalLengthSqrd > 0.0)
+	{
+		double planeDistance = glm::dot(p - a, normal) / glm::sqrt(normalLengthSqrd);
+		glm::dvec3 projected = p - normal * (glm::dot(p - a, normal) / normalLengthSqrd);
+
+		bool inside =
+			glm::dot(glm::cross(b - a, projected - a), normal) >= 0.0 &&
+			glm::dot(glm::cross(c - b, projected - b), normal) >= 0.0 &&
+			glm::dot(glm::cross(a - c, projected - c), normal) >= 0.0;
+
+		if (inside)
+		{
+			return glm::abs(planeDistance);
+		}
+	}
+
+	double distanceSqrd = glm::min(glm::min(getSegmentDistanceSqrd(p, a, b), getSegmentDistanceSqrd(p, b, c)), getSegmentDistanceSqrd(p, c, a));
+	return glm::sqrt(distanceSqrd);
+}
+
+// Largest distance from a vertex of the full mesh to the LOD
+static double measureLODDistance(const MeshData& meshData, const std::vector<uint32_t>& lodIndicies)
+{
+	double maxDistance = 0.0;
+	for (const Vertex& vertex : meshData.verticies)
+	{
+		double distance = DBL_MAX;
+		for (uint32_t i = 0; i + 2 < (uint32_t)lodIndicies.size(); i += 3)
+		{
+			distance = glm::min(distance, getTriangleDistance(vertex.position,
+				meshData.verticies[lodIndicies[i]].position,
+				meshData.verticies[lodIndicies[i + 1]].position,
+				meshData.verticies[lodIndicies[i + 2]].position));
+		}
+
+		maxDistance = glm::max(maxDistance, distance);
+	}
+
+	return maxDistance;
+}
+
+static bool isSameLODs(const std::vector<MeshLOD>& a, const std::vector<MeshLOD>& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)a.size(); i++)
+	{
+		if (a[i].indicies != b[i].indicies || memcmp(&a[i].error, &b[i].error, sizeof(float)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+OKAY_TEST(meshLODsStayClosed)
+{
+	for (const MeshData& meshData : { createUVSphere(32, 1), createCubeSphere(12, 2) })
+	{
+		std::vector<uint32_t> vertexToPosition;
+		createPositionRemap(meshData.verticies, vertexToPosition);
+		OKAY_CHECK(isClosed(vertexToPosition, meshData.indicies));
+
+		std::vector<MeshLOD> lods;
+		generateMeshLODs(meshData, MeshLODSettings(), lods);
+		OKAY_CHECK(lods.size() >= 2);
+
+		uint32_t previousNumIndicies = (uint32_t)meshData.indicies.size();
+		for (const MeshLOD& lod : lods)
+		{
+			OKAY_CHECK(isClosed(vertexToPosition, lod.indicies));
+			OKAY_CHECK(lod.indicies.size() % 3 == 0 && lod.indicies.size() < previousNumIndicies);
+			previousNumIndicies = (uint32_t)lod.indicies.size();
+		}
+	}
+}
+
+OKAY_TEST(meshLODErrorBounds)
+{
+	MeshLODSettings settings;
+
+	for (const MeshData& meshData : { createUVSphere(32, 3), createCubeSphere(12, 4) })
+	{
+		std::vector<MeshLOD> lods;
+		generateMeshLODs(meshData, settings, lods);
+		OKAY_CHECK(lods.size() >= 2);
+
+		float maxError = settings.maxError * computeBoundingSphere(meshData.verticies).w;
+
+		float previousError = 0.f;
+		for (uint32_t i = 0; i < (uint32_t)lods.size(); i++)
+		{
+			// Checked from every vertex of the full mesh, not only the ones the simplifier removed
+			double distance = measureLODDistance(meshData, lods[i].indicies);
+			printf("    LOD %u: %u triangles, error %.5f, measured %.5f\n", i + 1, (uint32_t)lods[i].indicies.size() / 3, lods[i].error, distance);
+
+			OKAY_CHECK(distance <= lods[i].error * 1.0001 + 1e-6);
+			OKAY_CHECK(lods[i].error >= previousError);
+			OKAY_CHECK(lods[i].error <= maxError);
+			previousError = lods[i].error;
+		}
+
+		// The bumps can't be kept exactly
+		OKAY_CHECK(lods.back().error > 0.f);
+	}
+
+	// simplifyMesh returns the same kind of measured error
+	MeshData meshData = createUVSphere(24, 5);
+	std::vector<uint32_t> indicies;
+	float error = simplifyMesh(meshData, (uint32_t)meshData.indicies.size() / 4, FLT_MAX, indicies);
+	OKAY_CHECK(!indicies.empty() && indicies.size() <= meshData.indicies.size() / 4);
+	OKAY_CHECK(measureLODDistance(meshData, indicies) <= error * 1.0001 + 1e-6);
+
+	// Too small for LODs
+	MeshData smallMesh = createUVSphere(3, 6);
+	std::vector<MeshLOD> lods;
+	generateMeshLODs(smallMesh, settings, lods);
+	OKAY_CHECK(lods.empty());
+}
+
+OKAY_TEST(meshLODsKeepUVSeams)
+{
+	MeshData meshData = createUVSphere(32, 7);
+	uint32_t resolution = 32;
+
+	std::vector<uint32_t> vertexToPosition;
+	uint32_t numPositions = createPositionRemap(meshData.verticies, vertexToPosition);
+
+	std::vector<MeshLOD> lods;
+	generateMeshLODs(meshData, MeshLODSettings(), lods);
+	OKAY_CHECK(lods.size() >= 2);
+
+	for (const MeshLOD& lod : lods)
+	{
+		// A triangle pulled across the seam would span most of the texture
+		bool trianglesInChart = true;
+		for (uint32_t i = 0; i + 2 < (uint32_t)lod.indicies.size(); i += 3)
+		{
+			glm::vec2 uvs[3] = {};
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				uvs[j] = meshData.verticies[lod.indicies[i + j]].uv;
+			}
+
+			glm::vec2 uvExtent = glm::max(glm::max(uvs[0], uvs[1]), uvs[2]) - glm::min(glm::min(uvs[0], uvs[1]), uvs[2]);
+			trianglesInChart &= uvExtent.x < 0.5f;
+		}
+
+		OKAY_CHECK(trianglesInChart);
+
+		// Both sides of the seam collapse together, every seam position the LOD uses is used from both sides
+		std::vector<uint8_t> seamSides(numPositions, 0);
+		for (uint32_t index : lod.indicies)
+		{
+			uint32_t x = index % (resolution + 1);
+			uint32_t y = index / (resolution + 1);
+
+			if (y != 0 && y != resolution && (x == 0 || x == resolution))
+			{
+				seamSides[vertexToPosition[index]] |= x == 0 ? 1 : 2;
+			}
+		}
+
+		uint32_t numSeamPositions = 0;
+		bool seamStitched = true;
+		for (uint8_t sides : seamSides)
+		{
+			numSeamPositions += sides != 0;
+			seamStitched &= sides == 0 || sides == 3;
+		}
+
+		OKAY_CHECK(seamStitched);
+		OKAY_CHECK(numSeamPositions > 0);
+	}
+}
+
+// processMeshes runs the simplifier for all meshes at once on every core, the LODs can't depend on that or on the run
+OKAY_TEST(meshLODsDeterministic)
+{
+	std::vector<MeshData> meshes;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		meshes.emplace_back(i % 2 ? createCubeSphere(8 + i, i) : createUVSphere(20 + i * 2, i));
+	}
+
+	std::vector<std::vector<MeshLOD>> sequentialLODs(meshes.size());
+	for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+	{
+		generateMeshLODs(meshes[i], MeshLODSettings(), sequentialLODs[i]);
+		OKAY_CHECK(!sequentialLODs[i].empty());
+	}
+
+	for (uint32_t run = 0; run < 2; run++)
+	{
+		std::vector<std::vector<MeshLOD>> parallelLODs(meshes.size());
+
+		std::vector<std::thread> threads;
+		for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+		{
+			threads.emplace_back([&, i]()
+			{
+				generateMeshLODs(meshes[i], MeshLODSettings(), parallelLODs[i]);
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		bool identical = true;
+		for (uint32_t i = 0; i < (uint32_t)meshes.size(); i++)
+		{
+			identical &= isSameLODs(sequentialLODs[i], parallelLODs[i]);
+		}
+
+		OKAY_CHECK(identical);
+	}
+}
@@ -0,0 +1,128 @@
+#include "Tests.h"
+
+#include "Engine/Resources/MeshStreams.h"
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// A quad split along the diagonal with the shared corners duplicated, like a flat shaded import
+static MeshData createSplitQuad()
+{
+	static const glm::vec3 POSITIONS[6] =
+	{
+		glm::vec3(0.f, 0.f, 0.f), glm::vec3(1.f, 0.f, 0.f), glm::vec3(1.f, 1.f, 0.f),
+		glm::vec3(0.f, 0.f, 0.f), glm::vec3(1.f, 1.f, 0.f), glm::vec3(0.f, 1.f, 0.f),
+	};
+
+	MeshData meshData;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		Vertex vertex;
+		vertex.position = POSITIONS[i];
+		vertex.normal = glm::vec3(0.f, 0.f, (float)i);
+
+		meshData.verticies.emplace_back(vertex);
+		meshData.indicies.emplace_back(i);
+	}
+
+	return meshData;
+}
+
+// The position stream has to draw the exact same triangles as the full verticies
+static bool drawsSameTriangles(const MeshData& meshData, const PositionStream& stream)
+{
+	for (uint32_t i = 0; i < (uint32_t)meshData.indicies.size(); i++)
+	{
+		uint32_t positionIdx = stream.indicies.empty() ? meshData.indicies[i] : stream.indicies[i];
+		if (stream.positions[positionIdx] != meshData.verticies[meshData.indicies[i]].position)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+OKAY_TEST(positionStreamDeduplicates)
+{
+	MeshData meshData = createSplitQuad();
+
+	PositionStream stream;
+	createPositionStream(meshData, true, stream);
+
+	OKAY_CHECK(stream.positions.size() == 4);
+	OKAY_CHECK(stream.indicies.size() == meshData.indicies.size());
+	OKAY_CHECK(drawsSameTriangles(meshData, stream));
+
+	// First seen order
+	OKAY_CHECK(stream.positions[0] == glm::vec3(0.f, 0.f, 0.f));
+	OKAY_CHECK(stream.positions[3] == glm::vec3(0.f, 1.f, 0.f));
+}
+
+OKAY_TEST(positionStreamWithoutDeduplication)
+{
+	MeshData meshData = createSplitQuad();
+
+	PositionStream stream;
+	createPositionStream(meshData, false, stream);
+
+	OKAY_CHECK(stream.positions.size() == meshData.verticies.size());
+	OKAY_CHECK(stream.indicies.empty());
+	OKAY_CHECK(drawsSameTriangles(meshData, stream));
+}
+
+OKAY_TEST(positionStreamKeepsIndiciesWhenNothingMerges)
+{
+	MeshData meshData = createSplitQuad();
+	meshData.verticies.resize(3);
+	meshData.indicies.resize(3);
+
+	PositionStream stream;
+	createPositionStream(meshData, true, stream);
+
+	OKAY_CHECK(stream.positions.size() == 3);
+	OKAY_CHECK(stream.indicies.empty());
+}
+
+OKAY_TEST(positionRemapIsBitwise)
+{
+	std::vector<Vertex> verticies(4);
+	verticies[0].position = glm::vec3(1.f, 2.f, 3.f);
+	verticies[1].position = glm::vec3(1.f, 2.f, 3.f + 1e-6f);
+	verticies[2].position = glm::vec3(1.f, 2.f, 3.f);
+	verticies[3].position = glm::vec3(0.f, 0.f, 0.f);
+
+	std::vector<uint32_t> vertexToPosition;
+	OKAY_CHECK(createPositionRemap(verticies, vertexToPosition) == 3);
+	OKAY_CHECK(vertexToPosition[0] == 0);
+	OKAY_CHECK(vertexToPosition[1] == 1);
+	OKAY_CHECK(vertexToPosition[2] == 0);
+	OKAY_CHECK(vertexToPosition[3] == 2);
+}
+
+OKAY_TEST(positionStreamRandomMesh)
+{
+	TestRandom random(4);
+
+	// Verticies picked from a small set of positions, so many of them share one
+	MeshData meshData;
+	for (uint32_t i = 0; i < 3000; i++)
+	{
+		Vertex vertex;
+		vertex.position = glm::vec3((float)random.next(10), (float)random.next(10), (float)random.next(10));
+		vertex.uv = glm::vec2(random.nextFloat(0.f, 1.f), random.nextFloat(0.f, 1.f));
+		meshData.verticies.emplace_back(vertex);
+	}
+
+	for (uint32_t i = 0; i < 9000; i++)
+	{
+		meshData.indicies.emplace_back(random.next(3000));
+	}
+
+	PositionStream stream;
+	createPositionStream(meshData, true, stream);
+
+	OKAY_CHECK(stream.positions.size() <= 1000);
+	OKAY_CHECK(stream.positions.size() < meshData.verticies.size());
+	OKAY_CHECK(drawsSameTriangles(meshData, stream));
+}
@@ -0,0 +1,204 @@
+#include "Tests.h"
+
+#include "Engine/Resources/MeshletBuilder.h"
+
+#include "glm/gtc/constants.hpp"
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// Grid on a sphere, or a flat grid in the XY plane facing -Z
+static MeshData createGrid(uint32_t resolution, bool sphere)
+{
+	MeshData meshData;
+	for (uint32_t y = 0; y <= resolution; y++)
+	{
+		for (uint32_t x = 0; x <= resolution; x++)
+		{
+			float u = (float)x / resolution;
+			float v = (float)y / resolution;
+
+			Vertex vertex;
+			if (sphere)
+			{
+				float theta = glm::pi<float>() * v;
+				float phi = glm::two_pi<float>() * u;
+				vertex.position = glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi)) * 10.f;
+			}
+			else
+			{
+				vertex.position = glm::vec3(u * 10.f, v * 10.f, 0.f);
+			}
+
+			meshData.verticies.emplace_back(vertex);
+		}
+	}
+
+	for (uint32_t y = 0; y < resolution; y++)
+	{
+		for (uint32_t x = 0; x < resolution; x++)
+		{
+			uint32_t a = y * (resolution + 1) + x;
+			uint32_t b = a + 1;
+			uint32_t c = a + resolution + 1;
+			uint32_t d = c + 1;
+
+			meshData.indicies.insert(meshData.indicies.end(), { a, c, b, b, c, d });
+		}
+	}
+
+	return meshData;
+}
+
+static glm::vec3 getMeshletPosition(const MeshData& meshData, const MeshletData& meshletData, const Meshlet& meshlet, uint32_t triangleIdx, uint32_t corner)
+{
+	uint32_t localVertex = unpackMeshletVertex(meshletData.triangles[meshlet.triangleOffset + triangleIdx], corner);
+	return meshData.verticies[meshletData.vertexIndicies[meshlet.vertexOffset + localVertex]].position;
+}
+
+OKAY_TEST(meshletLimits)
+{
+	MeshData meshData = createGrid(50, true);
+
+	MeshletData meshletData;
+	buildMeshlets(meshData, meshletData);
+
+	OKAY_CHECK(!meshletData.meshlets.empty());
+
+	uint32_t numTriangles = 0;
+	bool withinLimits = true;
+	bool localIndiciesValid = true;
+
+	for (const Meshlet& meshlet : meshletData.meshlets)
+	{
+		withinLimits &= meshlet.numVerticies > 0 && meshlet.numVerticies <= MESHLET_MAX_VERTICIES;
+		withinLimits &= meshlet.numTriangles > 0 && meshlet.numTriangles <= MESHLET_MAX_TRIANGLES;
+		withinLimits &= meshlet.vertexOffset + meshlet.numVerticies <= meshletData.vertexIndicies.size();
+		withinLimits &= meshlet.triangleOffset + meshlet.numTriangles <= meshletData.triangles.size();
+
+		for (uint32_t i = 0; i < meshlet.numTriangles; i++)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				localIndiciesValid &= unpackMeshletVertex(meshletData.triangles[meshlet.triangleOffset + i], corner) < meshlet.numVerticies;
+			}
+		}
+
+		numTriangles += meshlet.numTriangles;
+	}
+
+	OKAY_CHECK(withinLimits);
+	OKAY_CHECK(localIndiciesValid);
+	OKAY_CHECK(numTriangles == meshData.indicies.size() / 3);
+	OKAY_CHECK(meshletData.triangles.size() == numTriangles);
+
+	// A meshlet is only closed when the next triangle doesn't fit, so they can't be mostly empty
+	float averageTriangles = numTriangles / (float)meshletData.meshlets.size();
+	printf("    %u meshlets, %.1f triangles on average\n", (uint32_t)meshletData.meshlets.size(), averageTriangles);
+	OKAY_CHECK(averageTriangles > 40.f);
+}
+
+OKAY_TEST(meshletsCoverEveryTriangleInOrder)
+{
+	MeshData meshData = createGrid(50, true);
+
+	MeshletData meshletData;
+	buildMeshlets(meshData, meshletData);
+
+	// The meshlets concatenated give back the index buffer, same triangles, same order & winding
+	std::vector<uint32_t> indicies;
+	for (const Meshlet& meshlet : meshletData.meshlets)
+	{
+		for (uint32_t i = 0; i < meshlet.numTriangles; i++)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t localVertex = unpackMeshletVertex(meshletData.triangles[meshlet.triangleOffset + i], corner);
+				indicies.emplace_back(meshletData.vertexIndicies[meshlet.vertexOffset + localVertex]);
+			}
+		}
+	}
+
+	OKAY_CHECK(indicies == meshData.indicies);
+}
+
+OKAY_TEST(meshletBoundingSpheres)
+{
+	MeshData meshData = createGrid(50, true);
+
+	MeshletData meshletData;
+	buildMeshlets(meshData, meshletData);
+
+	bool containsVerticies = true;
+	for (const Meshlet& meshlet : meshletData.meshlets)
+	{
+		for (uint32_t i = 0; i < meshlet.numVerticies; i++)
+		{
+			glm::vec3 position = meshData.verticies[meshletData.vertexIndicies[meshlet.vertexOffset + i]].position;
+			containsVerticies &= glm::length(position - meshlet.center) <= meshlet.radius * 1.0001f;
+		}
+	}
+
+	OKAY_CHECK(containsVerticies);
+}
+
+// Backface culling has to be conservative, a culled meshlet can't have a single triangle facing the camera
+OKAY_TEST(meshletNormalConesAreConservative)
+{
+	TestRandom random(5);
+
+	for (bool sphere : { true, false })
+	{
+		MeshData meshData = createGrid(50, sphere);
+
+		MeshletData meshletData;
+		buildMeshlets(meshData, meshletData);
+
+		uint32_t numCulled = 0;
+		uint32_t numWrongfullyCulled = 0;
+
+		for (uint32_t i = 0; i < 500; i++)
+		{
+			glm::vec3 cameraPosition = glm::vec3(random.nextFloat(-40.f, 40.f), random.nextFloat(-40.f, 40.f), random.nextFloat(-40.f, 40.f));
+
+			for (const Meshlet& meshlet : meshletData.meshlets)
+			{
+				if (!isMeshletBackfacing(meshlet, cameraPosition))
+				{
+					continue;
+				}
+
+				numCulled++;
+
+				for (uint32_t j = 0; j < meshlet.numTriangles; j++)
+				{
+					glm::vec3 p0 = getMeshletPosition(meshData, meshletData, meshlet, j, 0);
+					glm::vec3 p1 = getMeshletPosition(meshData, meshletData, meshlet, j, 1);
+					glm::vec3 p2 = getMeshletPosition(meshData, meshletData, meshlet, j, 2);
+
+					glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+					if (glm::dot(cameraPosition - p0, normal) > 1e-4f)
+					{
+						numWrongfullyCulled++;
+						break;
+					}
+				}
+			}
+		}
+
+		OKAY_CHECK(numCulled > 0);
+		OKAY_CHECK(numWrongfullyCulled == 0);
+	}
+}
+
+OKAY_TEST(meshletsOfEmptyMesh)
+{
+	MeshData meshData;
+
+	MeshletData meshletData;
+	buildMeshlets(meshData, meshletData);
+
+	OKAY_CHECK(meshletData.meshlets.empty());
+	OKAY_CHECK(meshletData.vertexIndicies.empty());
+	OKAY_CHECK(meshletData.triangles.empty());
+}
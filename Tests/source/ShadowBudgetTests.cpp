@@ -0,0 +1,262 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/ShadowBudget.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+using namespace Okay;
+
+static ShadowImportanceCamera createCamera()
+{
+	glm::vec3 position = glm::vec3(0.f);
+	glm::vec3 forward = glm::vec3(0.f, 0.f, 1.f);
+	float fovY = glm::radians(60.f);
+
+	glm::mat4 viewProj = glm::perspectiveFovLH_ZO(fovY, 16.f, 9.f, 0.1f, 1000.f) * glm::lookAtLH(position, position + forward, glm::vec3(0.f, 1.f, 0.f));
+	return createShadowImportanceCamera(position, forward, fovY, viewProj);
+}
+
+static ShadowBudgetSettings createSettings(uint32_t maxShadowMaps, uint32_t maxShadowCubes, uint64_t maxTexels)
+{
+	ShadowBudgetSettings settings;
+	settings.maxShadowMaps = maxShadowMaps;
+	settings.maxShadowCubes = maxShadowCubes;
+	settings.maxTexels = maxTexels;
+
+	return settings;
+}
+
+OKAY_TEST(shadowImportanceFollowsScreenCoverage)
+{
+	ShadowImportanceCamera camera = createCamera();
+	ShadowBudgetSettings settings = createSettings(0, 0, 0);
+
+	float nearImportance = computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, 20.f), 5.f, 1.f);
+	float farImportance = computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, 200.f), 5.f, 1.f);
+	float sideImportance = computeLocalLightImportance(camera, settings, glm::vec3(12.f, 0.f, 20.f), 5.f, 1.f);
+	float brightImportance = computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, 200.f), 5.f, 4.f);
+
+	OKAY_CHECK(nearImportance > farImportance);
+	OKAY_CHECK(nearImportance > sideImportance);
+	OKAY_CHECK(brightImportance > farImportance);
+
+	// Behind the camera
+	OKAY_CHECK(computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, -20.f), 5.f, 1.f) == 0.f);
+
+	// Camera inside the light
+	OKAY_CHECK(computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, 2.f), 5.f, 3.f) == 3.f);
+
+	OKAY_CHECK(computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, 20.f), 0.f, 1.f) == 0.f);
+	OKAY_CHECK(computeLocalLightImportance(camera, settings, glm::vec3(0.f, 0.f, 20.f), 5.f, 0.f) == 0.f);
+}
+
+OKAY_TEST(shadowInfluenceRadiusMatchesAttenuation)
+{
+	glm::vec2 attenuation = glm::vec2(0.1f, 0.02f);
+	float radius = computeLightInfluenceRadius(10.f, attenuation, 0.05f, 1000.f);
+
+	float contribution = 10.f / (1.f + attenuation.x * radius + attenuation.y * radius * radius);
+	OKAY_CHECK(glm::abs(contribution - 0.05f) < 0.001f);
+
+	OKAY_CHECK(computeLightInfluenceRadius(10.f, attenuation, 0.05f, 50.f) == 50.f);
+	OKAY_CHECK(computeLightInfluenceRadius(0.01f, attenuation, 0.05f, 1000.f) == 0.f);
+}
+
+OKAY_TEST(shadowBudgetGrantsMostImportantFirst)
+{
+	ShadowBudget budget;
+	budget.beginFrame();
+
+	// Added in reverse importance order
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		budget.addRequest(i, 1.f + i, 1, 0, 1024 * 1024);
+	}
+
+	budget.allocate(createSettings(3, 0, UINT64_MAX));
+
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		OKAY_CHECK(budget.isGranted(i) == (i >= 5));
+	}
+
+	OKAY_CHECK(budget.getStats().numRequests == 8);
+	OKAY_CHECK(budget.getStats().numGranted == 3);
+	OKAY_CHECK(budget.getStats().numShadowMapsGranted == 3);
+}
+
+OKAY_TEST(shadowBudgetRespectsEveryLimit)
+{
+	ShadowBudget budget;
+
+	// Cubes
+	budget.beginFrame();
+	budget.addRequest(0, 3.f, 0, 1, 6 * 512 * 512);
+	budget.addRequest(1, 2.f, 0, 1, 6 * 512 * 512);
+	budget.addRequest(2, 1.f, 1, 0, 512 * 512);
+	budget.allocate(createSettings(1, 1, UINT64_MAX));
+
+	OKAY_CHECK(budget.isGranted(0));
+	OKAY_CHECK(!budget.isGranted(1));
+	OKAY_CHECK(budget.isGranted(2));
+	OKAY_CHECK(budget.getStats().numShadowCubesGranted == 1);
+
+	// Texels, a smaller request further down still fits after a big one is skipped
+	budget.beginFrame();
+	budget.addRequest(10, 3.f, 1, 0, 2048 * 2048);
+	budget.addRequest(11, 2.f, 1, 0, 4096 * 4096);
+	budget.addRequest(12, 1.f, 1, 0, 1024 * 1024);
+	budget.allocate(createSettings(8, 0, 2048 * 2048 + 1024 * 1024));
+
+	OKAY_CHECK(budget.isGranted(10));
+	OKAY_CHECK(!budget.isGranted(11));
+	OKAY_CHECK(budget.isGranted(12));
+	OKAY_CHECK(budget.getStats().numTexelsGranted == 2048 * 2048 + 1024 * 1024);
+
+	// Lights that don't contribute are never granted
+	budget.beginFrame();
+	budget.addRequest(20, 0.f, 1, 0, 256 * 256);
+	budget.allocate(createSettings(8, 8, UINT64_MAX));
+
+	OKAY_CHECK(!budget.isGranted(20));
+	OKAY_CHECK(budget.getStats().numGranted == 0);
+}
+
+OKAY_TEST(shadowBudgetIgnoresRequestOrder)
+{
+	ShadowBudget forwardBudget;
+	ShadowBudget reverseBudget;
+
+	forwardBudget.beginFrame();
+	reverseBudget.beginFrame();
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		forwardBudget.addRequest(i, 1.f, 1, 0, 1);
+		reverseBudget.addRequest(5 - i, 1.f, 1, 0, 1);
+	}
+
+	forwardBudget.allocate(createSettings(3, 0, UINT64_MAX));
+	reverseBudget.allocate(createSettings(3, 0, UINT64_MAX));
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(forwardBudget.isGranted(i) == reverseBudget.isGranted(i));
+	}
+}
+
+OKAY_TEST(shadowBudgetHysteresisPreventsFlipping)
+{
+	ShadowBudget budget;
+	ShadowBudgetSettings settings = createSettings(1, 0, UINT64_MAX);
+	settings.hysteresisBonus = 0.25f;
+
+	budget.beginFrame();
+	budget.addRequest(0, 1.f, 1, 0, 1);
+	budget.addRequest(1, 0.9f, 1, 0, 1);
+	budget.allocate(settings);
+	OKAY_CHECK(budget.isGranted(0));
+
+	// The two lights alternate being slightly more important, the granted one keeps its shadow
+	for (uint32_t frame = 0; frame < 10; frame++)
+	{
+		float importanceA = frame % 2 ? 1.f : 1.1f;
+		float importanceB = frame % 2 ? 1.1f : 1.f;
+
+		budget.beginFrame();
+		budget.addRequest(0, importanceA, 1, 0, 1);
+		budget.addRequest(1, importanceB, 1, 0, 1);
+		budget.allocate(settings);
+
+		OKAY_CHECK(budget.isGranted(0));
+		OKAY_CHECK(!budget.isGranted(1));
+	}
+
+	// Once the other light is clearly more important it takes over, and then keeps it
+	budget.beginFrame();
+	budget.addRequest(0, 1.f, 1, 0, 1);
+	budget.addRequest(1, 1.3f, 1, 0, 1);
+	budget.allocate(settings);
+	OKAY_CHECK(!budget.isGranted(0));
+	OKAY_CHECK(budget.isGranted(1));
+
+	budget.beginFrame();
+	budget.addRequest(0, 1.1f, 1, 0, 1);
+	budget.addRequest(1, 1.f, 1, 0, 1);
+	budget.allocate(settings);
+	OKAY_CHECK(!budget.isGranted(0));
+	OKAY_CHECK(budget.isGranted(1));
+
+	// Without the bonus it flips right away
+	settings.hysteresisBonus = 0.f;
+	budget.beginFrame();
+	budget.addRequest(0, 1.1f, 1, 0, 1);
+	budget.addRequest(1, 1.f, 1, 0, 1);
+	budget.allocate(settings);
+	OKAY_CHECK(budget.isGranted(0));
+}
+
+OKAY_TEST(shadowResolutionFollowsProjectedSize)
+{
+	ShadowQualityPreset preset = getShadowQualityPreset(OKAY_SHADOW_QUALITY_MEDIUM);
+
+	OKAY_CHECK(selectShadowMapResolution(0.f, preset, INVALID_UINT32) == MIN_SHADOW_MAP_RESOLUTION);
+	OKAY_CHECK(selectShadowMapResolution(200.f, preset, INVALID_UINT32) == 256);
+	OKAY_CHECK(selectShadowMapResolution(300.f, preset, INVALID_UINT32) == 512);
+	OKAY_CHECK(selectShadowMapResolution(1000.f, preset, INVALID_UINT32) == 1024);
+	OKAY_CHECK(selectShadowMapResolution(1500.f, preset, INVALID_UINT32) == 2048);
+
+	// Clamped to the preset
+	OKAY_CHECK(selectShadowMapResolution(100000.f, preset, INVALID_UINT32) == preset.maxResolution);
+
+	// The scale of the preset applies to the projected size
+	ShadowQualityPreset lowPreset = getShadowQualityPreset(OKAY_SHADOW_QUALITY_LOW);
+	OKAY_CHECK(selectShadowMapResolution(1000.f, lowPreset, INVALID_UINT32) == 512);
+
+	for (uint32_t quality = OKAY_SHADOW_QUALITY_LOW; quality <= OKAY_SHADOW_QUALITY_ULTRA; quality++)
+	{
+		ShadowQualityPreset qualityPreset = getShadowQualityPreset((ShadowQuality)quality);
+		for (float size = 1.f; size < 10000.f; size *= 1.3f)
+		{
+			uint32_t resolution = selectShadowMapResolution(size, qualityPreset, INVALID_UINT32);
+
+			OKAY_CHECK((resolution & (resolution - 1)) == 0);
+			OKAY_CHECK(resolution >= MIN_SHADOW_MAP_RESOLUTION && resolution <= qualityPreset.maxResolution);
+		}
+	}
+}
+
+OKAY_TEST(shadowResolutionHysteresis)
+{
+	ShadowQualityPreset preset = getShadowQualityPreset(OKAY_SHADOW_QUALITY_MEDIUM);
+
+	// Just past a power of two keeps the previous resolution until it's clearly past it
+	OKAY_CHECK(selectShadowMapResolution(1030.f, preset, 1024) == 1024);
+	OKAY_CHECK(selectShadowMapResolution(1100.f, preset, 1024) == 1024);
+	OKAY_CHECK(selectShadowMapResolution(1200.f, preset, 1024) == 2048);
+
+	// Same on the way down
+	OKAY_CHECK(selectShadowMapResolution(500.f, preset, 1024) == 1024);
+	OKAY_CHECK(selectShadowMapResolution(450.f, preset, 1024) == 1024);
+	OKAY_CHECK(selectShadowMapResolution(400.f, preset, 1024) == 512);
+
+	// Big jumps aren't held back
+	OKAY_CHECK(selectShadowMapResolution(100.f, preset, 2048) == 256);
+
+	// A size oscillating around a power of two doesn't flip the resolution
+	uint32_t resolution = INVALID_UINT32;
+	uint32_t numChanges = 0;
+	for (uint32_t frame = 0; frame < 100; frame++)
+	{
+		float size = frame % 2 ? 1000.f : 1050.f;
+		uint32_t newResolution = selectShadowMapResolution(size, preset, resolution);
+
+		numChanges += resolution != INVALID_UINT32 && newResolution != resolution;
+		resolution = newResolution;
+	}
+	OKAY_CHECK(numChanges == 0);
+
+	// A lower preset than last time overrides the hysteresis
+	ShadowQualityPreset lowPreset = getShadowQualityPreset(OKAY_SHADOW_QUALITY_LOW);
+	OKAY_CHECK(selectShadowMapResolution(4000.f, lowPreset, 2048) == lowPreset.maxResolution);
+}
@@ -0,0 +1,322 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/ShadowCache.h"
+#include "Engine/Resources/MeshSimplifier.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
+
+using namespace Okay;
+
+static glm::mat4 createSpotViewProj(glm::vec3 position, glm::vec3 direction)
+{
+	return glm::perspectiveFovLH_ZO(glm::radians(60.f), 1.f, 1.f, 0.1f, 100.f) * glm::lookAtLH(position, position + direction, glm::vec3(0.f, 1.f, 0.f));
+}
+
+static ShadowCaster createCaster(uint32_t meshID, uint32_t drawGroupIdx, glm::vec3 position)
+{
+	ShadowCaster caster;
+	caster.meshID = meshID;
+	caster.drawGroupIdx = drawGroupIdx;
+	caster.worldMatrix = glm::translate(glm::mat4(1.f), position);
+	caster.worldSphere = glm::vec4(position, 1.f);
+
+	return caster;
+}
+
+// A few casters in front of a spot light at the origin looking down +z, one behind it
+static std::vector<ShadowCaster> createScene()
+{
+	std::vector<ShadowCaster> casters;
+	casters.emplace_back(createCaster(0, 0, glm::vec3(0.f, 0.f, 10.f)));
+	casters.emplace_back(createCaster(0, 0, glm::vec3(2.f, 0.f, 20.f)));
+	casters.emplace_back(createCaster(1, 1, glm::vec3(-3.f, 1.f, 15.f)));
+	casters.emplace_back(createCaster(2, 2, glm::vec3(0.f, 0.f, -10.f)));
+
+	return casters;
+}
+
+static void createCubeViewProjs(glm::vec3 lightPos, glm::mat4* pOutViewProjs)
+{
+	static const glm::vec3 DIRECTIONS[6] = { { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f } };
+	static const glm::vec3 UP_VECTORS[6] = { { 0.f, 1.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, -1.f }, { 0.f, 0.f, 1.f }, { 0.f, 1.f, 0.f }, { 0.f, 1.f, 0.f } };
+
+	glm::mat4 projMatrix = glm::perspectiveFovLH_ZO(glm::half_pi<float>(), 1.f, 1.f, 0.1f, 50.f);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		pOutViewProjs[i] = projMatrix * glm::lookAtLH(lightPos, lightPos + DIRECTIONS[i], UP_VECTORS[i]);
+	}
+}
+
+OKAY_TEST(shadowMapKeyHitsForUnchangedScene)
+{
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+
+	uint64_t storedKey = INVALID_UINT64;
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		OKAY_CHECK(!updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+	}
+}
+
+OKAY_TEST(shadowMapKeyInvalidatedByMovingCaster)
+{
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+
+	uint64_t storedKey = computeShadowMapKey(viewProj, casters);
+
+	casters[1] = createCaster(0, 0, glm::vec3(2.f, 0.01f, 20.f));
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+
+	// Rotating in place changes the key even though the sphere stays the same
+	casters[1].worldMatrix = glm::rotate(casters[1].worldMatrix, 0.1f, glm::vec3(0.f, 1.f, 0.f));
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+
+	OKAY_CHECK(!updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+}
+
+OKAY_TEST(shadowMapKeyIgnoresCastersOutsideLight)
+{
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+
+	uint64_t storedKey = computeShadowMapKey(viewProj, casters);
+
+	// The caster behind the light can't affect its shadow map
+	casters[3] = createCaster(2, 2, glm::vec3(5.f, 0.f, -12.f));
+	OKAY_CHECK(!updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+}
+
+OKAY_TEST(shadowMapKeyInvalidatedByMovingLight)
+{
+	std::vector<ShadowCaster> casters = createScene();
+
+	uint64_t storedKey = computeShadowMapKey(createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f)), casters);
+
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(createSpotViewProj(glm::vec3(0.f, 0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f)), casters)));
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(createSpotViewProj(glm::vec3(0.f, 0.5f, 0.f), glm::vec3(0.1f, 0.f, 1.f)), casters)));
+}
+
+OKAY_TEST(shadowMapKeyInvalidatedByAddingAndRemovingCasters)
+{
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+
+	uint64_t originalKey = computeShadowMapKey(viewProj, casters);
+	uint64_t storedKey = originalKey;
+
+	casters.emplace_back(createCaster(3, 3, glm::vec3(1.f, 1.f, 30.f)));
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+
+	casters.pop_back();
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+	OKAY_CHECK(storedKey == originalKey);
+
+	casters.erase(casters.begin());
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+
+	casters.clear();
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+}
+
+OKAY_TEST(shadowMapKeyCollectsDrawGroups)
+{
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+
+	std::vector<uint32_t> drawGroups;
+	computeShadowMapKey(viewProj, casters, &drawGroups);
+
+	OKAY_CHECK(drawGroups.size() == 2);
+	OKAY_CHECK(drawGroups[0] == 0);
+	OKAY_CHECK(drawGroups[1] == 1);
+}
+
+OKAY_TEST(shadowCubeKeysOnlyInvalidateAffectedFaces)
+{
+	glm::vec3 lightPos = glm::vec3(0.f);
+	glm::mat4 viewProjs[6] = {};
+	createCubeViewProjs(lightPos, viewProjs);
+
+	std::vector<ShadowCaster> casters;
+	casters.emplace_back(createCaster(0, 0, glm::vec3(10.f, 0.f, 0.f)));  // +x
+	casters.emplace_back(createCaster(1, 1, glm::vec3(0.f, 0.f, -10.f))); // -z
+
+	uint64_t storedKeys[6] = {};
+	uint64_t faceKeys[6] = {};
+	computeShadowCubeFaceKeys(viewProjs, lightPos, 50.f, casters, storedKeys);
+
+	computeShadowCubeFaceKeys(viewProjs, lightPos, 50.f, casters, faceKeys);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(!updateShadowCacheKey(storedKeys[i], faceKeys[i]));
+	}
+
+	// Moving the caster on +x only touches that face
+	casters[0] = createCaster(0, 0, glm::vec3(10.f, 0.5f, 0.f));
+	computeShadowCubeFaceKeys(viewProjs, lightPos, 50.f, casters, faceKeys);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(updateShadowCacheKey(storedKeys[i], faceKeys[i]) == (i == 0));
+	}
+
+	// Adding a caster on +y, then removing the one on -z
+	casters.emplace_back(createCaster(2, 2, glm::vec3(0.f, 10.f, 0.f)));
+	computeShadowCubeFaceKeys(viewProjs, lightPos, 50.f, casters, faceKeys);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(updateShadowCacheKey(storedKeys[i], faceKeys[i]) == (i == 2));
+	}
+
+	casters.erase(casters.begin() + 1);
+	computeShadowCubeFaceKeys(viewProjs, lightPos, 50.f, casters, faceKeys);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(updateShadowCacheKey(storedKeys[i], faceKeys[i]) == (i == 5));
+	}
+
+	// Out of range casters don't affect any face
+	casters.emplace_back(createCaster(3, 3, glm::vec3(100.f, 0.f, 0.f)));
+	computeShadowCubeFaceKeys(viewProjs, lightPos, 50.f, casters, faceKeys);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(!updateShadowCacheKey(storedKeys[i], faceKeys[i]));
+	}
+}
+
+OKAY_TEST(shadowCubeKeysInvalidatedByMovingLight)
+{
+	std::vector<ShadowCaster> casters;
+	casters.emplace_back(createCaster(0, 0, glm::vec3(10.f, 0.f, 0.f)));
+
+	glm::mat4 viewProjs[6] = {};
+	uint64_t storedKeys[6] = {};
+	uint64_t faceKeys[6] = {};
+
+	createCubeViewProjs(glm::vec3(0.f), viewProjs);
+	computeShadowCubeFaceKeys(viewProjs, glm::vec3(0.f), 50.f, casters, storedKeys);
+
+	createCubeViewProjs(glm::vec3(0.f, 0.1f, 0.f), viewProjs);
+	computeShadowCubeFaceKeys(viewProjs, glm::vec3(0.f, 0.1f, 0.f), 50.f, casters, faceKeys);
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK(updateShadowCacheKey(storedKeys[i], faceKeys[i]));
+	}
+}
+
+OKAY_TEST(shadowMapKeyInvalidatedByCasterLOD)
+{
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+
+	uint64_t storedKey = computeShadowMapKey(viewProj, casters);
+
+	// A different index range is drawn
+	casters[1].lodIdx = SHADOW_CASTER_LOD + 1;
+	OKAY_CHECK(updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+
+	glm::mat4 faceViewProjs[6];
+	createCubeViewProjs(glm::vec3(0.f), faceViewProjs);
+
+	uint64_t faceKeys[6] = {};
+	uint64_t newFaceKeys[6] = {};
+	computeShadowCubeFaceKeys(faceViewProjs, glm::vec3(0.f), 50.f, casters, faceKeys);
+
+	casters[3].lodIdx = SHADOW_CASTER_LOD + 1;
+	computeShadowCubeFaceKeys(faceViewProjs, glm::vec3(0.f), 50.f, casters, newFaceKeys);
+
+	// Only the -Z face sees that caster
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		OKAY_CHECK((faceKeys[i] != newFaceKeys[i]) == (i == 5));
+	}
+}
+
+// The camera picks the LODs of the main pass & regroups the draws, the shadows of a static scene must stay cached
+OKAY_TEST(shadowMapKeyIndependentOfCameraLOD)
+{
+	static const float LOD_ERRORS[MAX_MESH_LODS] = { 0.f, 0.01f, 0.05f, 0.2f };
+	static const float MAX_PIXEL_ERROR = 1.f;
+
+	glm::mat4 viewProj = createSpotViewProj(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+	std::vector<ShadowCaster> casters = createScene();
+	float projectionScale = getLODProjectionScale(glm::radians(70.f), 1080.f);
+
+	uint64_t storedKey = computeShadowMapKey(viewProj, casters);
+
+	uint32_t numCameraLODChanges = 0;
+	uint32_t prevCameraLOD = INVALID_UINT32;
+
+	// The camera flies away from the casters & back, oscillating over the LOD switch distances on the way
+	for (uint32_t frame = 0; frame < 400; frame++)
+	{
+		float cameraDistance = 5.f + (frame < 200 ? frame : 400 - frame) * 2.f + (frame % 2 ? 0.5f : -0.5f);
+
+		// Like gatherShadowCasters, draw groups are (mesh, camera LOD) in first seen order
+		std::vector<std::pair<uint32_t, uint32_t>> drawGroups;
+		for (ShadowCaster& caster : casters)
+		{
+			float distance = glm::max(cameraDistance + glm::vec3(caster.worldSphere).z - caster.worldSphere.w, 0.f);
+			uint32_t cameraLOD = selectMeshLOD(LOD_ERRORS, MAX_MESH_LODS, distance, 1.f, projectionScale, MAX_PIXEL_ERROR);
+
+			if (&caster == &casters[0])
+			{
+				numCameraLODChanges += prevCameraLOD != INVALID_UINT32 && prevCameraLOD != cameraLOD;
+				prevCameraLOD = cameraLOD;
+			}
+
+			std::pair<uint32_t, uint32_t> drawGroup = { caster.meshID, cameraLOD };
+			auto it = std::find(drawGroups.begin(), drawGroups.end(), drawGroup);
+
+			caster.drawGroupIdx = (uint32_t)(it - drawGroups.begin());
+			caster.lodIdx = SHADOW_CASTER_LOD;
+
+			if (it == drawGroups.end())
+			{
+				drawGroups.emplace_back(drawGroup);
+			}
+		}
+
+		OKAY_CHECK(!updateShadowCacheKey(storedKey, computeShadowMapKey(viewProj, casters)));
+	}
+
+	// Make sure the camera LODs actually changed, at least two switches on the way out & back
+	OKAY_CHECK(numCameraLODChanges >= 4);
+}
+
+OKAY_TEST(meshLODSelection)
+{
+	static const float LOD_ERRORS[MAX_MESH_LODS] = { 0.f, 0.01f, 0.05f, 0.2f };
+	static const float MAX_PIXEL_ERROR = 1.f;
+
+	float projectionScale = getLODProjectionScale(glm::radians(70.f), 1080.f);
+
+	OKAY_CHECK(selectMeshLOD(LOD_ERRORS, MAX_MESH_LODS, 0.f, 1.f, projectionScale, MAX_PIXEL_ERROR) == 0);
+	OKAY_CHECK(selectMeshLOD(LOD_ERRORS, MAX_MESH_LODS, 100000.f, 1.f, projectionScale, MAX_PIXEL_ERROR) == MAX_MESH_LODS - 1);
+	OKAY_CHECK(selectMeshLOD(LOD_ERRORS, 1, 100000.f, 1.f, projectionScale, MAX_PIXEL_ERROR) == 0);
+
+	// Never coarser further in & never over the pixel error
+	uint32_t prevLOD = 0;
+	bool monotonic = true;
+	bool withinPixelError = true;
+
+	for (float distance = 0.f; distance < 500.f; distance += 0.25f)
+	{
+		uint32_t lodIdx = selectMeshLOD(LOD_ERRORS, MAX_MESH_LODS, distance, 2.f, projectionScale, MAX_PIXEL_ERROR);
+
+		monotonic &= lodIdx >= prevLOD;
+		withinPixelError &= distance == 0.f || projectionScale * LOD_ERRORS[lodIdx] * 2.f / distance <= MAX_PIXEL_ERROR * 1.0001f;
+		prevLOD = lodIdx;
+	}
+
+	OKAY_CHECK(monotonic);
+	OKAY_CHECK(withinPixelError);
+
+	// A bigger object keeps its detail longer
+	OKAY_CHECK(selectMeshLOD(LOD_ERRORS, MAX_MESH_LODS, 50.f, 4.f, projectionScale, MAX_PIXEL_ERROR) <
+		selectMeshLOD(LOD_ERRORS, MAX_MESH_LODS, 50.f, 1.f, projectionScale, MAX_PIXEL_ERROR));
+}
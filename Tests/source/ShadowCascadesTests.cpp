@@ -0,0 +1,140 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/ShadowCascades.h"
+
+using namespace Okay;
+
+static const uint32_t RESOLUTION = 2048;
+static const glm::vec3 LIGHT_FORWARD = glm::normalize(glm::vec3(0.3f, -1.f, 0.4f));
+static const glm::vec3 SCENE_MIN = glm::vec3(-500.f);
+static const glm::vec3 SCENE_MAX = glm::vec3(500.f);
+
+// Texel position of a world point in the cascade's shadow map
+static glm::vec2 worldToTexel(const ShadowCascade& cascade, glm::vec3 worldPos)
+{
+	glm::vec4 clipPos = cascade.viewProjMatrix * glm::vec4(worldPos, 1.f);
+	glm::vec2 ndc = glm::vec2(clipPos) / clipPos.w;
+
+	return (ndc * 0.5f + 0.5f) * (float)RESOLUTION;
+}
+
+// Distance to the closest whole number
+static float distanceToWhole(float value)
+{
+	return glm::abs(value - glm::round(value));
+}
+
+OKAY_TEST(cascadeSplitsCoverRange)
+{
+	float splitFars[MAX_SHADOW_CASCADES] = {};
+	computeCascadeSplits(1.f, 1000.f, 4, 0.75f, splitFars);
+
+	OKAY_CHECK(splitFars[3] == 1000.f);
+	for (uint32_t i = 1; i < 4; i++)
+	{
+		OKAY_CHECK(splitFars[i] > splitFars[i - 1]);
+	}
+
+	computeCascadeSplits(1.f, 1001.f, 4, 0.f, splitFars);
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		OKAY_CHECK(glm::abs(splitFars[i] - (1.f + 250.f * (i + 1))) < 0.01f);
+	}
+}
+
+OKAY_TEST(cascadeSphereContainsSliceCorners)
+{
+	CascadeCamera camera;
+	camera.position = glm::vec3(10.f, 5.f, -3.f);
+	camera.forward = glm::vec3(0.f, 0.f, 1.f);
+	camera.fovY = glm::radians(70.f);
+	camera.aspectRatio = 16.f / 9.f;
+
+	float tanHalfFovY = glm::tan(camera.fovY * 0.5f);
+	float tanHalfFovX = tanHalfFovY * camera.aspectRatio;
+
+	float splits[] = { 1.f, 20.f, 80.f, 300.f };
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		glm::vec4 sphere = computeFrustumSliceSphere(camera, splits[i], splits[i + 1]);
+
+		for (uint32_t c = 0; c < 8; c++)
+		{
+			float depth = c & 4 ? splits[i + 1] : splits[i];
+			glm::vec3 corner = camera.position + glm::vec3(
+				(c & 1 ? 1.f : -1.f) * tanHalfFovX * depth,
+				(c & 2 ? 1.f : -1.f) * tanHalfFovY * depth,
+				depth);
+
+			OKAY_CHECK(glm::length(corner - glm::vec3(sphere)) <= sphere.w * 1.0001f);
+		}
+	}
+}
+
+OKAY_TEST(cascadeOriginStableUnderSubTexelMotion)
+{
+	CascadeCamera camera;
+	camera.position = glm::vec3(12.f, 3.f, -40.f);
+	camera.forward = glm::normalize(glm::vec3(0.2f, -0.1f, 1.f));
+	camera.fovY = glm::radians(60.f);
+	camera.aspectRatio = 16.f / 9.f;
+
+	ShadowCascade firstCascade = computeShadowCascade(camera, LIGHT_FORWARD, 1.f, 60.f, RESOLUTION, SCENE_MIN, SCENE_MAX);
+	glm::vec3 probePoint = glm::vec3(15.f, 0.f, -10.f);
+	glm::vec2 firstProbeTexel = worldToTexel(firstCascade, probePoint);
+
+	// Move the camera a fraction of a texel at a time, across a few texels in total
+	uint32_t numOriginMoves = 0;
+	glm::vec2 lastOriginTexel = glm::vec2(firstCascade.viewMatrix * glm::vec4(firstCascade.sphereCenter, 1.f)) / firstCascade.texelWorldSize;
+
+	for (uint32_t i = 1; i <= 50; i++)
+	{
+		camera.position += glm::vec3(0.13f, 0.05f, 0.07f) * firstCascade.texelWorldSize;
+
+		ShadowCascade cascade = computeShadowCascade(camera, LIGHT_FORWARD, 1.f, 60.f, RESOLUTION, SCENE_MIN, SCENE_MAX);
+
+		// The texel size never changes, so the snapping grid is fixed
+		OKAY_CHECK(cascade.texelWorldSize == firstCascade.texelWorldSize);
+		OKAY_CHECK(cascade.sphereRadius == firstCascade.sphereRadius);
+
+		// The cascade origin sits on a whole texel in the fixed light space
+		glm::vec2 originTexel = glm::vec2(cascade.viewMatrix * glm::vec4(cascade.sphereCenter, 1.f)) / cascade.texelWorldSize;
+		OKAY_CHECK(distanceToWhole(originTexel.x) < 0.01f);
+		OKAY_CHECK(distanceToWhole(originTexel.y) < 0.01f);
+
+		// A static world point only ever moves by whole texels, the sub texel offset stays the same
+		glm::vec2 texelDelta = worldToTexel(cascade, probePoint) - firstProbeTexel;
+		OKAY_CHECK(distanceToWhole(texelDelta.x) < 0.01f);
+		OKAY_CHECK(distanceToWhole(texelDelta.y) < 0.01f);
+
+		if (glm::round(originTexel) != glm::round(lastOriginTexel))
+		{
+			numOriginMoves++;
+			lastOriginTexel = originTexel;
+		}
+	}
+
+	// Most of the steps are below a texel and shouldn't move the origin
+	OKAY_CHECK(numOriginMoves > 0);
+	OKAY_CHECK(numOriginMoves < 25);
+}
+
+OKAY_TEST(cascadeTexelSizeStableUnderRotation)
+{
+	CascadeCamera camera;
+	camera.position = glm::vec3(0.f, 2.f, 0.f);
+	camera.fovY = glm::radians(60.f);
+	camera.aspectRatio = 16.f / 9.f;
+
+	ShadowCascade firstCascade = computeShadowCascade(camera, LIGHT_FORWARD, 20.f, 100.f, RESOLUTION, SCENE_MIN, SCENE_MAX);
+
+	for (uint32_t i = 1; i < 36; i++)
+	{
+		float angle = glm::radians(10.f * i);
+		camera.forward = glm::vec3(glm::sin(angle), -0.2f, glm::cos(angle));
+
+		ShadowCascade cascade = computeShadowCascade(camera, LIGHT_FORWARD, 20.f, 100.f, RESOLUTION, SCENE_MIN, SCENE_MAX);
+		OKAY_CHECK(cascade.sphereRadius == firstCascade.sphereRadius);
+		OKAY_CHECK(cascade.texelWorldSize == firstCascade.texelWorldSize);
+	}
+}
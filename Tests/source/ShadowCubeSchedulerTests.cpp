@@ -0,0 +1,317 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/ShadowCubeScheduler.h"
+
+using namespace Okay;
+
+static const uint32_t ALL_FACES = 0b111111;
+
+static ShadowCubeSchedulerSettings createSettings()
+{
+	ShadowCubeSchedulerSettings settings;
+	settings.maxFacesPerFrame = 24;
+	settings.fullRateDistance = 100.f;
+	settings.slicedRateDistance = 200.f;
+	settings.updateInterval = 4;
+
+	return settings;
+}
+
+static ShadowCubeRequest createRequest(uint32_t slot, float cameraDistance, uint64_t faceKeyBase)
+{
+	ShadowCubeRequest request;
+	request.slot = slot;
+	request.priority.importance = 1.f;
+	request.priority.cameraDistance = cameraDistance;
+	request.lightKey = 1000 + slot;
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		request.faceKeys[i] = faceKeyBase + i;
+	}
+
+	return request;
+}
+
+// Runs one frame with the given requests, returns the face mask of every request
+static std::vector<uint32_t> runFrame(ShadowCubeScheduler& scheduler, const ShadowCubeSchedulerSettings& settings, const std::vector<ShadowCubeRequest>& requests)
+{
+	scheduler.beginFrame();
+	for (const ShadowCubeRequest& request : requests)
+	{
+		scheduler.addRequest(request);
+	}
+	scheduler.schedule(settings);
+
+	std::vector<uint32_t> faceMasks;
+	for (const ShadowCubeRequest& request : requests)
+	{
+		faceMasks.emplace_back(scheduler.getFaceMask(request.slot));
+	}
+
+	return faceMasks;
+}
+
+OKAY_TEST(shadowCubeNewLightGetsFullUpdate)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+
+	// Even far away lights, the old depths are relative to something else
+	std::vector<ShadowCubeRequest> requests = { createRequest(0, 50.f, 0), createRequest(1, 1000.f, 0) };
+
+	std::vector<uint32_t> faceMasks = runFrame(scheduler, settings, requests);
+	OKAY_CHECK(faceMasks[0] == ALL_FACES);
+	OKAY_CHECK(faceMasks[1] == ALL_FACES);
+	OKAY_CHECK(scheduler.getStats().numFullUpdates == 2);
+
+	// Nothing changed
+	faceMasks = runFrame(scheduler, settings, requests);
+	OKAY_CHECK(faceMasks[0] == 0);
+	OKAY_CHECK(faceMasks[1] == 0);
+
+	// The light moved
+	requests[1].lightKey++;
+	faceMasks = runFrame(scheduler, settings, requests);
+	OKAY_CHECK(faceMasks[0] == 0);
+	OKAY_CHECK(faceMasks[1] == ALL_FACES);
+}
+
+OKAY_TEST(shadowCubeFullRateRendersDirtyFaces)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+
+	std::vector<ShadowCubeRequest> requests = { createRequest(0, 50.f, 0) };
+	runFrame(scheduler, settings, requests);
+
+	requests[0].faceKeys[1] = 100;
+	requests[0].faceKeys[4] = 100;
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == ((1 << 1) | (1 << 4)));
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 0);
+}
+
+OKAY_TEST(shadowCubeSlicedRoundRobin)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+
+	std::vector<ShadowCubeRequest> requests = { createRequest(0, 150.f, 0) };
+	runFrame(scheduler, settings, requests);
+
+	// Every face changed on a frame without budget, they catch up one per frame in order
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		requests[0].faceKeys[i] = 100 + i;
+	}
+
+	settings.maxFacesPerFrame = 0;
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 0);
+	OKAY_CHECK(scheduler.getStats().numFacesDeferred == 6);
+	settings.maxFacesPerFrame = 24;
+
+	for (uint32_t frame = 0; frame < 6; frame++)
+	{
+		OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 1u << frame);
+		OKAY_CHECK(scheduler.getStats().numFacesDeferred == 5 - frame);
+	}
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 0);
+
+	// Continues after the last rendered face instead of restarting at 0
+	requests[0].faceKeys[0] = 200;
+	requests[0].faceKeys[2] = 200;
+	requests[0].faceKeys[5] = 200;
+
+	settings.maxFacesPerFrame = 0;
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 0);
+	settings.maxFacesPerFrame = 24;
+
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 1u << 0);
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 1u << 2);
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 1u << 5);
+	OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 0);
+}
+
+OKAY_TEST(shadowCubeIntervalUpdates)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+
+	std::vector<ShadowCubeRequest> requests = { createRequest(0, 1000.f, 0) };
+	runFrame(scheduler, settings, requests);
+
+	// Faces deferred by the budget wait for the cube's frame & are then rendered in full, always on the same frames of the interval
+	uint32_t frame = 1;
+	uint32_t firstUpdateFrame = INVALID_UINT32;
+
+	for (uint32_t cycle = 0; cycle < 4; cycle++)
+	{
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			requests[0].faceKeys[i] = 100 + cycle;
+		}
+
+		settings.maxFacesPerFrame = 0;
+		OKAY_CHECK(runFrame(scheduler, settings, requests)[0] == 0);
+		settings.maxFacesPerFrame = 24;
+		frame++;
+
+		uint32_t updateFrame = INVALID_UINT32;
+		for (uint32_t i = 0; i < settings.updateInterval; i++, frame++)
+		{
+			uint32_t faceMask = runFrame(scheduler, settings, requests)[0];
+			OKAY_CHECK(faceMask == 0 || (faceMask == ALL_FACES && updateFrame == INVALID_UINT32));
+
+			updateFrame = faceMask ? frame : updateFrame;
+		}
+
+		OKAY_CHECK(updateFrame != INVALID_UINT32);
+		if (firstUpdateFrame == INVALID_UINT32)
+		{
+			firstUpdateFrame = updateFrame;
+		}
+
+		OKAY_CHECK((updateFrame - firstUpdateFrame) % settings.updateInterval == 0);
+	}
+}
+
+// A caster moving around a distant light, every face it's in or left is rendered the frame it happens, whatever the rate
+OKAY_TEST(shadowCubeCasterMoveRendersImmediately)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+
+	std::vector<ShadowCubeRequest> requests = { createRequest(0, 150.f, 0), createRequest(1, 1000.f, 0), createRequest(2, 50.f, 0) };
+	runFrame(scheduler, settings, requests);
+
+	for (uint32_t frame = 1; frame <= 24; frame++)
+	{
+		// The caster crosses from one face into the next every few frames, moving inside the face the other frames
+		uint32_t face = (frame / 3) % 6;
+		uint32_t previousFace = ((frame - 1) / 3) % 6;
+
+		uint32_t expectedMask = (1u << face) | (1u << previousFace);
+		for (ShadowCubeRequest& request : requests)
+		{
+			request.faceKeys[face] = frame * 100 + face;
+			request.faceKeys[previousFace] = frame * 100 + previousFace;
+		}
+
+		std::vector<uint32_t> faceMasks = runFrame(scheduler, settings, requests);
+		OKAY_CHECK(faceMasks[0] == expectedMask);
+		OKAY_CHECK(faceMasks[1] == expectedMask);
+		OKAY_CHECK(faceMasks[2] == expectedMask);
+		OKAY_CHECK(scheduler.getStats().numFacesDeferred == 0);
+	}
+
+	// It stopped, nothing left to render
+	std::vector<uint32_t> faceMasks = runFrame(scheduler, settings, requests);
+	OKAY_CHECK(faceMasks[0] == 0 && faceMasks[1] == 0 && faceMasks[2] == 0);
+}
+
+OKAY_TEST(shadowCubeFaceBudget)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+	settings.maxFacesPerFrame = 6;
+
+	std::vector<ShadowCubeRequest> requests;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		requests.emplace_back(createRequest(i, 50.f, 0));
+		requests.back().priority.importance = 1.f + i;
+	}
+
+	// Full updates of new lights go over the budget
+	runFrame(scheduler, settings, requests);
+	OKAY_CHECK(scheduler.getStats().numFacesRendered == 24);
+
+	// The most important cube goes first
+	for (ShadowCubeRequest& request : requests)
+	{
+		request.faceKeys[0] = 100;
+		request.faceKeys[1] = 100;
+		request.faceKeys[2] = 100;
+	}
+
+	std::vector<uint32_t> faceMasks = runFrame(scheduler, settings, requests);
+	OKAY_CHECK(scheduler.getStats().numFacesRendered == 6);
+	OKAY_CHECK(scheduler.getStats().numFacesDeferred == 6);
+	OKAY_CHECK(faceMasks[3] == 0b111);
+	OKAY_CHECK(faceMasks[2] == 0b111);
+	OKAY_CHECK(faceMasks[1] == 0);
+	OKAY_CHECK(faceMasks[0] == 0);
+
+	faceMasks = runFrame(scheduler, settings, requests);
+	OKAY_CHECK(faceMasks[1] == 0b111);
+	OKAY_CHECK(faceMasks[0] == 0b111);
+}
+
+// Every cube changes every frame with far more dirty faces than the budget, no face may be starved
+OKAY_TEST(shadowCubeEveryFaceRefreshedWithinBound)
+{
+	ShadowCubeScheduler scheduler;
+	ShadowCubeSchedulerSettings settings = createSettings();
+	settings.maxFacesPerFrame = 12;
+
+	static const uint32_t NUM_CUBES = 8;
+	static const uint32_t NUM_FRAMES = 200;
+
+	std::vector<ShadowCubeRequest> requests;
+	for (uint32_t i = 0; i < NUM_CUBES; i++)
+	{
+		// A mix of every rate and very different importances
+		float cameraDistance = i % 3 == 0 ? 50.f : (i % 3 == 1 ? 150.f : 1000.f);
+		requests.emplace_back(createRequest(i, cameraDistance, 0));
+		requests.back().priority.importance = (float)(1 << i);
+	}
+
+	runFrame(scheduler, settings, requests);
+
+	// Frame each face was last rendered on
+	std::vector<uint32_t> lastRendered(NUM_CUBES * 6, 0);
+	uint32_t maxWait = 0;
+
+	for (uint32_t frame = 1; frame <= NUM_FRAMES; frame++)
+	{
+		for (ShadowCubeRequest& request : requests)
+		{
+			for (uint32_t i = 0; i < 6; i++)
+			{
+				request.faceKeys[i] = frame * 100 + i;
+			}
+		}
+
+		std::vector<uint32_t> faceMasks = runFrame(scheduler, settings, requests);
+		OKAY_CHECK(scheduler.getStats().numFacesRendered <= settings.maxFacesPerFrame);
+
+		for (uint32_t cube = 0; cube < NUM_CUBES; cube++)
+		{
+			for (uint32_t face = 0; face < 6; face++)
+			{
+				uint32_t& faceLastRendered = lastRendered[cube * 6 + face];
+				if (faceMasks[cube] & (1 << face))
+				{
+					faceLastRendered = frame;
+				}
+
+				maxWait = glm::max(maxWait, frame - faceLastRendered);
+			}
+		}
+	}
+
+	// 48 faces at 12 per frame, sliced cubes need 6 frames to go around & interval cubes wait for their frame
+	static const uint32_t MAX_FRAMES_BETWEEN_UPDATES = 16;
+	printf("    Longest wait: %u frames\n", maxWait);
+	OKAY_CHECK(maxWait <= MAX_FRAMES_BETWEEN_UPDATES);
+}
+
+OKAY_TEST(shadowCubeUpdateRateByDistance)
+{
+	ShadowCubeSchedulerSettings settings = createSettings();
+
+	OKAY_CHECK(selectShadowCubeUpdateRate(0.f, settings) == OKAY_SHADOW_CUBE_UPDATE_FULL);
+	OKAY_CHECK(selectShadowCubeUpdateRate(100.f, settings) == OKAY_SHADOW_CUBE_UPDATE_FULL);
+	OKAY_CHECK(selectShadowCubeUpdateRate(150.f, settings) == OKAY_SHADOW_CUBE_UPDATE_SLICED);
+	OKAY_CHECK(selectShadowCubeUpdateRate(250.f, settings) == OKAY_SHADOW_CUBE_UPDATE_INTERVAL);
+}
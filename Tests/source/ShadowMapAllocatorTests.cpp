@@ -0,0 +1,140 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/ShadowMapAllocator.h"
+
+using namespace Okay;
+
+static const uint32_t FRAMES_IN_FLIGHT = 3;
+
+OKAY_TEST(shadowMapSlotsCreatedAtRequestedResolution)
+{
+	ShadowMapAllocator allocator;
+	allocator.initialize(4, FRAMES_IN_FLIGHT);
+	allocator.beginFrame();
+
+	bool needsTexture = false;
+	uint32_t smallSlot = allocator.allocate(256, &needsTexture);
+	OKAY_CHECK(smallSlot != INVALID_UINT32);
+	OKAY_CHECK(needsTexture);
+	OKAY_CHECK(allocator.getTextureResolution(smallSlot) == 256);
+
+	uint32_t bigSlot = allocator.allocate(2048, &needsTexture);
+	OKAY_CHECK(bigSlot != smallSlot);
+	OKAY_CHECK(needsTexture);
+	OKAY_CHECK(allocator.getTextureResolution(bigSlot) == 2048);
+
+	// A 256 map only costs 256x256 texels
+	OKAY_CHECK(allocator.getNumTextureTexels() == 256ull * 256 + 2048ull * 2048);
+
+	OKAY_CHECK(allocator.isActive(smallSlot));
+	OKAY_CHECK(allocator.isActive(bigSlot));
+	OKAY_CHECK(!allocator.isActive(2));
+}
+
+OKAY_TEST(shadowMapSlotsReusedAcrossFrames)
+{
+	ShadowMapAllocator allocator;
+	allocator.initialize(4, FRAMES_IN_FLIGHT);
+
+	bool needsTexture = false;
+	allocator.beginFrame();
+	uint32_t slotA = allocator.allocate(512, &needsTexture);
+	uint32_t slotB = allocator.allocate(1024, &needsTexture);
+
+	// Same requests, same slots & no new textures
+	for (uint32_t frame = 0; frame < 10; frame++)
+	{
+		allocator.beginFrame();
+		OKAY_CHECK(!allocator.isActive(slotA));
+
+		OKAY_CHECK(allocator.allocate(512, &needsTexture) == slotA);
+		OKAY_CHECK(!needsTexture);
+		OKAY_CHECK(allocator.allocate(1024, &needsTexture) == slotB);
+		OKAY_CHECK(!needsTexture);
+	}
+}
+
+OKAY_TEST(shadowMapSlotsFallBackToBiggerTextures)
+{
+	ShadowMapAllocator allocator;
+	allocator.initialize(2, FRAMES_IN_FLIGHT);
+
+	bool needsTexture = false;
+	allocator.beginFrame();
+	uint32_t bigSlot = allocator.allocate(2048, &needsTexture);
+	uint32_t mediumSlot = allocator.allocate(1024, &needsTexture);
+
+	// Every slot has a texture that was used last frame, so nothing can be recreated yet
+	allocator.beginFrame();
+	OKAY_CHECK(allocator.allocate(512, &needsTexture) == mediumSlot);
+	OKAY_CHECK(!needsTexture);
+	OKAY_CHECK(allocator.getTextureResolution(mediumSlot) == 1024);
+
+	OKAY_CHECK(allocator.allocate(256, &needsTexture) == bigSlot);
+	OKAY_CHECK(!needsTexture);
+
+	OKAY_CHECK(allocator.allocate(256, &needsTexture) == INVALID_UINT32);
+
+	// Nothing free is big enough
+	allocator.beginFrame();
+	allocator.allocate(2048, &needsTexture);
+	OKAY_CHECK(allocator.allocate(2048, &needsTexture) == INVALID_UINT32);
+}
+
+OKAY_TEST(shadowMapSlotsRecreatedOnlyWhenOutOfFlight)
+{
+	ShadowMapAllocator allocator;
+	allocator.initialize(1, FRAMES_IN_FLIGHT);
+
+	bool needsTexture = false;
+	allocator.beginFrame();
+	uint32_t slot = allocator.allocate(2048, &needsTexture);
+
+	// Used by the bigger fallback, the slot stays referenced
+	for (uint32_t frame = 0; frame < 5; frame++)
+	{
+		allocator.beginFrame();
+		OKAY_CHECK(allocator.allocate(256, &needsTexture) == slot);
+		OKAY_CHECK(!needsTexture);
+	}
+
+	// Unused for fewer frames than are in flight, the texture can still be sampled
+	for (uint32_t frame = 1; frame < FRAMES_IN_FLIGHT; frame++)
+	{
+		allocator.beginFrame();
+		OKAY_CHECK(allocator.allocate(4096, &needsTexture) == INVALID_UINT32);
+	}
+
+	// The last use is now FRAMES_IN_FLIGHT frames old
+	allocator.beginFrame();
+	OKAY_CHECK(allocator.allocate(256, &needsTexture) == slot);
+	OKAY_CHECK(needsTexture);
+	OKAY_CHECK(allocator.getTextureResolution(slot) == 256);
+	OKAY_CHECK(allocator.getNumTextureTexels() == 256ull * 256);
+}
+
+OKAY_TEST(shadowMapSlotsRecreateLongestUnused)
+{
+	ShadowMapAllocator allocator;
+	allocator.initialize(2, FRAMES_IN_FLIGHT);
+
+	bool needsTexture = false;
+	allocator.beginFrame();
+	uint32_t oldSlot = allocator.allocate(1024, &needsTexture);
+	uint32_t newerSlot = allocator.allocate(2048, &needsTexture);
+
+	allocator.beginFrame();
+	allocator.allocate(2048, &needsTexture);
+
+	for (uint32_t frame = 0; frame < FRAMES_IN_FLIGHT + 1; frame++)
+	{
+		allocator.beginFrame();
+	}
+
+	OKAY_CHECK(allocator.allocate(512, &needsTexture) == oldSlot);
+	OKAY_CHECK(needsTexture);
+
+	// An exact match is still preferred over recreating
+	OKAY_CHECK(allocator.allocate(2048, &needsTexture) == newerSlot);
+	OKAY_CHECK(!needsTexture);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+#include <chrono>
+
+/*
+	Tests of the engine code that's kept free of D3D12, run with the working directory in Tests/ (the default in Visual Studio).
+	Every file registers its tests with OKAY_TEST, the ones that only print timings with OKAY_BENCHMARK.
+
+	Tests.exe				Runs every test
+	Tests.exe <filter>		Runs the tests with filter in their name
+	Tests.exe --bench		Runs the benchmarks too
+
+	Returns the number of failed tests.
+*/
+
+namespace Okay::Tests
+{
+	typedef void (*TestFunction)();
+
+	struct TestCase
+	{
+		const char* name = nullptr;
+		TestFunction function = nullptr;
+		bool isBenchmark = false;
+	};
+
+	std::vector<TestCase>& getTestCases();
+
+	// Marks the running test as failed, it keeps running so every failed check is printed
+	void reportFailure(const char* file, int line, const char* expression);
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, TestFunction function, bool isBenchmark)
+		{
+			getTestCases().push_back({ name, function, isBenchmark });
+		}
+	};
+
+	inline const FilePath RESOURCE_PATH = FilePath("resources");
+
+	// Average milliseconds per call
+	template<typename Function>
+	double measureMs(uint32_t iterations, Function function)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			function();
+		}
+
+		std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+		return duration.count() / iterations;
+	}
+
+	// Deterministic across platforms, unlike the std distributions
+	class TestRandom
+	{
+	public:
+		TestRandom(uint32_t seed)
+			:m_state(seed * 747796405u + 2891336453u)
+		{
+		}
+
+		inline uint32_t next()
+		{
+			m_state ^= m_state << 13;
+			m_state ^= m_state >> 17;
+			m_state ^= m_state << 5;
+			return m_state;
+		}
+
+		// [0, max)
+		inline uint32_t next(uint32_t max) { return next() % max; }
+
+		// [min, max]
+		inline float nextFloat(float min, float max) { return min + (max - min) * (next() >> 8) * (1.f / 16777215.f); }
+
+	private:
+		uint32_t m_state = 0;
+	};
+}
+
+#define OKAY_TEST_CASE(name, isBenchmark)																\
+	static void name();																					\
+	static Okay::Tests::TestRegistrar name##Registrar(#name, name, isBenchmark);						\
+	static void name()
+
+#define OKAY_TEST(name) OKAY_TEST_CASE(name, false)
+#define OKAY_BENCHMARK(name) OKAY_TEST_CASE(name, true)
+
+#define OKAY_CHECK(condition)																			\
+	{																									\
+		if (!(condition))																				\
+		{																								\
+			Okay::Tests::reportFailure(__FILE__, __LINE__, #condition);									\
+		}																								\
+	}0
@@ -0,0 +1,326 @@
+#include "Tests.h"
+
+#include "Engine/Resources/TextureCompression.h"
+
+#include <cmath>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+enum TestImage : uint8_t
+{
+	TEST_IMAGE_COLOUR = 0,
+	TEST_IMAGE_COLOUR_ALPHA = 1,
+	TEST_IMAGE_GRAYSCALE = 2,
+	TEST_IMAGE_NORMAL_MAP = 3,
+};
+
+static const char* FORMAT_NAMES[OKAY_TEXTURE_FORMAT_COUNT] = { "RGBA8", "BC1", "BC3", "BC4", "BC5", "R8", "RG8" };
+
+static uint8_t toByte(float value)
+{
+	return (uint8_t)glm::clamp((int)lrintf(value), 0, 255);
+}
+
+// Fixed synthetic images like what the importer sees: smooth gradients, a little noise & hard edges
+static std::vector<uint8_t> createTestImage(uint32_t size, TestImage image)
+{
+	TestRandom random(image + 1);
+
+	std::vector<uint8_t> textureData(size * size * 4);
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			uint8_t* pTexel = textureData.data() + (y * size + x) * 4;
+
+			float u = (float)x / size;
+			float v = (float)y / size;
+			float noise = random.nextFloat(-4.f, 4.f);
+
+			float red = 128.f + 100.f * sinf(u * 7.f + v * 3.f) + noise;
+			float green = 128.f + 90.f * cosf(u * 5.f - v * 4.f) + noise;
+			float blue = 128.f + 80.f * sinf(u * v * 11.f + 1.f) + noise;
+
+			// Blocky patches with an inverted red channel
+			if ((x / 37 + y / 53) % 5 == 0)
+			{
+				red = 255.f - red;
+			}
+
+			pTexel[3] = 255;
+
+			switch (image)
+			{
+			case TEST_IMAGE_COLOUR_ALPHA:
+				pTexel[3] = toByte(128.f + 127.f * sinf(u * 9.f));
+				[[fallthrough]];
+
+			case TEST_IMAGE_COLOUR:
+				pTexel[0] = toByte(red);
+				pTexel[1] = toByte(green);
+				pTexel[2] = toByte(blue);
+				break;
+
+			case TEST_IMAGE_GRAYSCALE:
+				pTexel[0] = pTexel[1] = pTexel[2] = toByte(red);
+				break;
+
+			case TEST_IMAGE_NORMAL_MAP:
+			{
+				glm::vec3 normal;
+				normal.x = 0.4f * sinf(u * 13.f + v * 2.f) + noise * 0.01f;
+				normal.y = 0.4f * cosf(v * 9.f);
+				normal.z = sqrtf(glm::max(0.f, 1.f - normal.x * normal.x - normal.y * normal.y));
+
+				pTexel[0] = toByte((normal.x * 0.5f + 0.5f) * 255.f);
+				pTexel[1] = toByte((normal.y * 0.5f + 0.5f) * 255.f);
+				pTexel[2] = toByte((normal.z * 0.5f + 0.5f) * 255.f);
+				break;
+			}
+			}
+		}
+	}
+
+	return textureData;
+}
+
+// Over the channels the format keeps, channelMask bit i is channel i
+static double computePSNR(const std::vector<uint8_t>& textureData, const std::vector<uint8_t>& decoded, uint32_t channelMask)
+{
+	double squaredError = 0.0;
+	uint64_t numValues = 0;
+
+	for (uint64_t i = 0; i < textureData.size(); i++)
+	{
+		if (channelMask & (1 << (i % 4)))
+		{
+			double difference = (double)textureData[i] - decoded[i];
+			squaredError += difference * difference;
+			numValues++;
+		}
+	}
+
+	double meanSquaredError = squaredError / numValues;
+	return meanSquaredError > 0.0 ? 10.0 * log10(255.0 * 255.0 / meanSquaredError) : 99.0;
+}
+
+static uint32_t getChannelMask(TextureFormat format)
+{
+	switch (format)
+	{
+	case OKAY_TEXTURE_FORMAT_BC1:
+		return 0b0111;
+
+	case OKAY_TEXTURE_FORMAT_BC4:
+		return 0b0001;
+
+	case OKAY_TEXTURE_FORMAT_BC5:
+		return 0b0011;
+
+	default:
+		return 0b1111;
+	}
+}
+
+static double compressAndMeasure(const std::vector<uint8_t>& textureData, uint32_t size, TextureFormat format, uint32_t channelMask)
+{
+	std::vector<uint8_t> blocks(getTextureLevelSize(format, size, size));
+	compressTextureLevel(textureData.data(), size, size, format, blocks.data());
+
+	std::vector<uint8_t> decoded(textureData.size());
+	decompressTextureLevel(blocks.data(), size, size, format, decoded.data());
+
+	return computePSNR(textureData, decoded, channelMask);
+}
+
+OKAY_TEST(blockCompressionFormatSelection)
+{
+	static const uint32_t SIZE = 64;
+
+	// Picked from the texels when the channel count doesn't say, the file had 4
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_COLOUR).data(), SIZE, SIZE, 4, true, true) == OKAY_TEXTURE_FORMAT_BC1);
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_COLOUR_ALPHA).data(), SIZE, SIZE, 4, true, true) == OKAY_TEXTURE_FORMAT_BC3);
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_GRAYSCALE).data(), SIZE, SIZE, 4, true, true) == OKAY_TEXTURE_FORMAT_BC4);
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_NORMAL_MAP).data(), SIZE, SIZE, 4, false, true) == OKAY_TEXTURE_FORMAT_BC5);
+
+	// Uncompressed still drops the unused channels
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_GRAYSCALE).data(), SIZE, SIZE, 4, true, false) == OKAY_TEXTURE_FORMAT_R8);
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_NORMAL_MAP).data(), SIZE, SIZE, 4, false, false) == OKAY_TEXTURE_FORMAT_RG8);
+	OKAY_CHECK(selectTextureFormat(createTestImage(SIZE, TEST_IMAGE_COLOUR).data(), SIZE, SIZE, 4, true, false) == OKAY_TEXTURE_FORMAT_RGBA8);
+}
+
+OKAY_TEST(blockCompressionMinimumPSNR)
+{
+	static const uint32_t SIZE = 256;
+
+	struct QualityCase
+	{
+		TestImage image;
+		TextureFormat format;
+		uint32_t channelMask;
+		double minPSNR;
+	};
+
+	// A few dB under what the encoders give (39, 39, 58, 47.8 & 56), so a worse endpoint or index search shows up
+	static const QualityCase QUALITY_CASES[] =
+	{
+		{ TEST_IMAGE_COLOUR, OKAY_TEXTURE_FORMAT_BC1, 0b0111, 36.0 },
+		{ TEST_IMAGE_COLOUR_ALPHA, OKAY_TEXTURE_FORMAT_BC3, 0b0111, 36.0 },
+		{ TEST_IMAGE_COLOUR_ALPHA, OKAY_TEXTURE_FORMAT_BC3, 0b1000, 52.0 },
+		{ TEST_IMAGE_GRAYSCALE, OKAY_TEXTURE_FORMAT_BC4, 0b0001, 44.0 },
+		{ TEST_IMAGE_NORMAL_MAP, OKAY_TEXTURE_FORMAT_BC5, 0b0011, 50.0 },
+	};
+
+	for (const QualityCase& qualityCase : QUALITY_CASES)
+	{
+		std::vector<uint8_t> textureData = createTestImage(SIZE, qualityCase.image);
+		double psnr = compressAndMeasure(textureData, SIZE, qualityCase.format, qualityCase.channelMask);
+
+		printf("    %s channels 0x%x: %.2f dB\n", FORMAT_NAMES[qualityCase.format], qualityCase.channelMask, psnr);
+		OKAY_CHECK(psnr >= qualityCase.minPSNR);
+	}
+}
+
+// Blocks a BC format can store exactly have to come back exactly
+OKAY_TEST(blockCompressionExactBlocks)
+{
+	TestRandom random(10);
+
+	for (uint32_t i = 0; i < 500; i++)
+	{
+		uint8_t colours[2][4] = {};
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			colours[0][c] = (uint8_t)random.next(256);
+			colours[1][c] = (uint8_t)random.next(256);
+		}
+
+		// A flat block, one with only the two colours & one with only black & white
+		std::vector<uint8_t> textureData[3];
+		for (std::vector<uint8_t>& data : textureData)
+		{
+			data.resize(16 * 4);
+		}
+
+		for (uint32_t j = 0; j < 16; j++)
+		{
+			bool second = random.next(2);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				textureData[0][j * 4 + c] = colours[0][c];
+				textureData[1][j * 4 + c] = colours[second][c];
+				textureData[2][j * 4 + c] = second ? 255 : 0;
+			}
+
+			textureData[0][j * 4 + 3] = textureData[1][j * 4 + 3] = textureData[2][j * 4 + 3] = 255;
+		}
+
+		// Single channel endpoints are stored as is
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			OKAY_CHECK(compressAndMeasure(textureData[j], 4, OKAY_TEXTURE_FORMAT_BC4, 0b0001) == 99.0);
+			OKAY_CHECK(compressAndMeasure(textureData[j], 4, OKAY_TEXTURE_FORMAT_BC5, 0b0011) == 99.0);
+		}
+
+		// 565 endpoints can't hit every colour, but black & white they can
+		OKAY_CHECK(compressAndMeasure(textureData[2], 4, OKAY_TEXTURE_FORMAT_BC1, 0b0111) == 99.0);
+		OKAY_CHECK(compressAndMeasure(textureData[0], 4, OKAY_TEXTURE_FORMAT_BC1, 0b0111) > 36.0);
+	}
+}
+
+OKAY_TEST(blockCompressedMipChain)
+{
+	std::vector<uint8_t> textureData = createTestImage(64, TEST_IMAGE_COLOUR);
+
+	TextureMipChain mipChain;
+	generateMipChain(textureData.data(), 64, 64, TextureMipSettings(), mipChain);
+
+	TextureMipChain compressedChain;
+	compressMipChain(mipChain, OKAY_TEXTURE_FORMAT_BC1, compressedChain);
+
+	OKAY_CHECK(compressedChain.format == OKAY_TEXTURE_FORMAT_BC1);
+	OKAY_CHECK(compressedChain.getNumLevels() == mipChain.getNumLevels());
+
+	// The 2x2 & 1x1 levels still take a full block
+	uint64_t offset = 0;
+	for (uint32_t i = 0; i < compressedChain.getNumLevels(); i++)
+	{
+		OKAY_CHECK(compressedChain.levels[i].offset == offset);
+		offset += compressedChain.getLevelSize(i);
+	}
+
+	OKAY_CHECK(offset == compressedChain.data.size());
+	OKAY_CHECK(compressedChain.getLevelSize(compressedChain.getNumLevels() - 1) == 8);
+}
+
+// A DDS / KTX2 with only the full size, its mips are rebuilt from the decoded level & encoded in the same format again
+OKAY_TEST(blockCompressedMipsFromFullSize)
+{
+	std::vector<uint8_t> textureData = createTestImage(64, TEST_IMAGE_COLOUR);
+
+	TextureMipChain fullSizeChain;
+	fullSizeChain.format = OKAY_TEXTURE_FORMAT_BC1;
+	fullSizeChain.levels.push_back({ 64, 64, 0 });
+	fullSizeChain.data.resize(getTextureLevelSize(OKAY_TEXTURE_FORMAT_BC1, 64, 64));
+	compressTextureLevel(textureData.data(), 64, 64, OKAY_TEXTURE_FORMAT_BC1, fullSizeChain.data.data());
+
+	TextureMipChain rgba8Chain;
+	decodeAndGenerateMips(fullSizeChain, true, rgba8Chain);
+
+	OKAY_CHECK(rgba8Chain.format == OKAY_TEXTURE_FORMAT_RGBA8);
+	OKAY_CHECK(rgba8Chain.getNumLevels() == getNumMipLevels(64, 64));
+
+	// Same as mipping the decoded texture like an imported image
+	std::vector<uint8_t> decoded(textureData.size());
+	decompressTextureLevel(fullSizeChain.data.data(), 64, 64, OKAY_TEXTURE_FORMAT_BC1, decoded.data());
+
+	TextureMipSettings mipSettings;
+	mipSettings.isSRGB = true;
+
+	TextureMipChain expectedChain;
+	generateMipChain(decoded.data(), 64, 64, mipSettings, expectedChain);
+	OKAY_CHECK(rgba8Chain.data == expectedChain.data);
+
+	TextureMipChain mipChain;
+	compressMipChain(rgba8Chain, fullSizeChain.format, mipChain);
+
+	OKAY_CHECK(mipChain.format == OKAY_TEXTURE_FORMAT_BC1);
+	OKAY_CHECK(mipChain.getNumLevels() == 7);
+	OKAY_CHECK(mipChain.levels[6].width == 1 && mipChain.levels[6].height == 1);
+
+	// Encoding the decoded full size again loses next to nothing
+	std::vector<uint8_t> reencoded(textureData.size());
+	decompressTextureLevel(mipChain.data.data(), 64, 64, OKAY_TEXTURE_FORMAT_BC1, reencoded.data());
+
+	double psnr = computePSNR(textureData, decoded, 0b0111);
+	double reencodedPSNR = computePSNR(textureData, reencoded, 0b0111);
+	printf("    %.2f dB -> %.2f dB\n", psnr, reencodedPSNR);
+	OKAY_CHECK(reencodedPSNR >= psnr - 1.0);
+}
+
+OKAY_BENCHMARK(blockCompressionThroughput)
+{
+	static const uint32_t SIZE = 1024;
+	static const uint32_t NUM_ITERATIONS = 3;
+
+	static const TestImage IMAGES[] = { TEST_IMAGE_COLOUR, TEST_IMAGE_COLOUR_ALPHA, TEST_IMAGE_GRAYSCALE, TEST_IMAGE_NORMAL_MAP };
+	static const TextureFormat FORMATS[] = { OKAY_TEXTURE_FORMAT_BC1, OKAY_TEXTURE_FORMAT_BC3, OKAY_TEXTURE_FORMAT_BC4, OKAY_TEXTURE_FORMAT_BC5 };
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		std::vector<uint8_t> textureData = createTestImage(SIZE, IMAGES[i]);
+		std::vector<uint8_t> blocks(getTextureLevelSize(FORMATS[i], SIZE, SIZE));
+
+		double ms = measureMs(NUM_ITERATIONS, [&]()
+		{
+			compressTextureLevel(textureData.data(), SIZE, SIZE, FORMATS[i], blocks.data());
+		});
+
+		std::vector<uint8_t> decoded(textureData.size());
+		decompressTextureLevel(blocks.data(), SIZE, SIZE, FORMATS[i], decoded.data());
+
+		printf("    %s %ux%u: %.1f ms, %.1f Mtexels/s, %.2f dB\n", FORMAT_NAMES[FORMATS[i]], SIZE, SIZE, ms,
+			SIZE * SIZE / ms / 1e3, computePSNR(textureData, decoded, getChannelMask(FORMATS[i])));
+	}
+}
@@ -0,0 +1,224 @@
+#include "Tests.h"
+
+#include "Engine/Resources/TextureContainer.h"
+
+#include <cstring>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// The corpus in resources/textureContainers, every payload byte i of a valid file is (i * 131 + 7) & 255 in mip chain order
+static const FilePath CONTAINER_PATH = RESOURCE_PATH / "textureContainers";
+
+struct ValidContainer
+{
+	const char* pFileName = nullptr;
+	TextureFormat format = OKAY_TEXTURE_FORMAT_COUNT;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t numLevels = 0;
+};
+
+static const ValidContainer VALID_CONTAINERS[] =
+{
+	// Legacy DDS, FourCC & channel masks
+	{ "legacy_dxt1_64x32.dds", OKAY_TEXTURE_FORMAT_BC1, 64, 32, 7 },
+	{ "legacy_dxt5_16x8.dds", OKAY_TEXTURE_FORMAT_BC3, 16, 8, 5 },
+	{ "legacy_ati2_32x32.dds", OKAY_TEXTURE_FORMAT_BC5, 32, 32, 6 },
+	{ "legacy_bc4u_8x8_nomips.dds", OKAY_TEXTURE_FORMAT_BC4, 8, 8, 1 },
+	{ "legacy_rgba8_5x3.dds", OKAY_TEXTURE_FORMAT_RGBA8, 5, 3, 3 },
+	{ "legacy_l8_7x9.dds", OKAY_TEXTURE_FORMAT_R8, 7, 9, 4 },
+
+	// DDS with the DX10 header
+	{ "dx10_bc5_64x64.dds", OKAY_TEXTURE_FORMAT_BC5, 64, 64, 7 },
+	{ "dx10_bc1srgb_32x16.dds", OKAY_TEXTURE_FORMAT_BC1, 32, 16, 6 },
+	{ "dx10_rg8_12x4.dds", OKAY_TEXTURE_FORMAT_RG8, 12, 4, 2 },
+
+	// KTX2, levels stored smallest first & 16 byte aligned like the spec has them
+	{ "bc3_32x16.ktx2", OKAY_TEXTURE_FORMAT_BC3, 32, 16, 6 },
+	{ "bc1srgb_16x16.ktx2", OKAY_TEXTURE_FORMAT_BC1, 16, 16, 5 },
+	{ "rgba8_13x6.ktx2", OKAY_TEXTURE_FORMAT_RGBA8, 13, 6, 4 },
+	{ "r8_9x9_levels0.ktx2", OKAY_TEXTURE_FORMAT_R8, 9, 9, 1 },
+};
+
+struct MalformedContainer
+{
+	const char* pFileName = nullptr;
+	const char* pError = nullptr;
+};
+
+static const MalformedContainer MALFORMED_CONTAINERS[] =
+{
+	{ "bad_magic.dds", "not a DDS or KTX2 file" },
+	{ "bad_truncated_header.dds", "truncated DDS header" },
+	{ "bad_truncated_dx10_header.dds", "truncated DDS DX10 header" },
+	{ "bad_truncated_data.dds", "truncated DDS data" },
+	{ "bad_header_size.dds", "invalid DDS header size" },
+	{ "bad_pixel_format_size.dds", "invalid DDS header size" },
+	{ "bad_too_many_mips.dds", "invalid mip count" },
+	{ "bad_zero_width.dds", "unsupported size" },
+	{ "bad_huge_size.dds", "unsupported size" },
+	{ "bad_bc_not_multiple_of_4.dds", "block compressed size isn't a multiple of 4" },
+	{ "bad_cubemap.dds", "DDS cubes & volumes aren't supported" },
+	{ "bad_volume.dds", "DDS cubes & volumes aren't supported" },
+	{ "bad_dx10_array.dds", "DDS arrays, cubes & non 2D textures aren't supported" },
+	{ "bad_dx10_texture3d.dds", "DDS arrays, cubes & non 2D textures aren't supported" },
+	{ "bad_dx10_unsupported_format.dds", "unsupported DDS format" },
+	{ "bad_unsupported_fourcc.dds", "unsupported DDS format" },
+	{ "bad_bgra8.dds", "unsupported DDS format" },
+
+	{ "bad_identifier.ktx2", "not a DDS or KTX2 file" },
+	{ "bad_truncated_header.ktx2", "truncated KTX2 header" },
+	{ "bad_truncated_level_index.ktx2", "truncated KTX2 level index" },
+	{ "bad_truncated_data.ktx2", "truncated KTX2 data" },
+	{ "bad_supercompressed.ktx2", "supercompressed KTX2 isn't supported" },
+	{ "bad_cubemap.ktx2", "KTX2 arrays, cubes & non 2D textures aren't supported" },
+	{ "bad_array.ktx2", "KTX2 arrays, cubes & non 2D textures aren't supported" },
+	{ "bad_volume.ktx2", "KTX2 arrays, cubes & non 2D textures aren't supported" },
+	{ "bad_1d.ktx2", "KTX2 arrays, cubes & non 2D textures aren't supported" },
+	{ "bad_unsupported_format.ktx2", "unsupported KTX2 format" },
+	{ "bad_too_many_levels.ktx2", "invalid mip count" },
+	{ "bad_huge_level_count.ktx2", "truncated KTX2 level index" },
+	{ "bad_level_length.ktx2", "KTX2 level size doesn't match its format" },
+	{ "bad_level_offset_past_end.ktx2", "truncated KTX2 data" },
+	{ "bad_level_offset_overflow.ktx2", "truncated KTX2 data" },
+};
+
+static bool readContainer(const char* pFileName, std::string& outFileData)
+{
+	return readBinary(CONTAINER_PATH / pFileName, outFileData);
+}
+
+OKAY_TEST(textureContainerValidCorpus)
+{
+	for (const ValidContainer& container : VALID_CONTAINERS)
+	{
+		TextureMipChain mipChain;
+		const char* pError = nullptr;
+
+		bool loaded = loadTextureContainer(CONTAINER_PATH / container.pFileName, mipChain, &pError);
+		if (!loaded)
+		{
+			printf("    %s: %s\n", container.pFileName, pError);
+		}
+
+		OKAY_CHECK(loaded);
+		if (!loaded)
+		{
+			continue;
+		}
+
+		OKAY_CHECK(mipChain.format == container.format);
+		OKAY_CHECK(mipChain.getNumLevels() == container.numLevels);
+		OKAY_CHECK(mipChain.levels[0].width == container.width && mipChain.levels[0].height == container.height);
+
+		// Same layout as a generated chain, halved & rounded down, tightly packed
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < mipChain.getNumLevels(); i++)
+		{
+			OKAY_CHECK(mipChain.levels[i].width == glm::max(container.width >> i, 1u));
+			OKAY_CHECK(mipChain.levels[i].height == glm::max(container.height >> i, 1u));
+			OKAY_CHECK(mipChain.levels[i].offset == offset);
+			offset += mipChain.getLevelSize(i);
+		}
+
+		OKAY_CHECK(offset == mipChain.data.size());
+
+		// The payload as is, KTX2 levels put back in order
+		bool payloadMatches = true;
+		for (uint64_t i = 0; i < mipChain.data.size(); i++)
+		{
+			payloadMatches &= mipChain.data[i] == (uint8_t)(i * 131 + 7);
+		}
+
+		OKAY_CHECK(payloadMatches);
+	}
+}
+
+OKAY_TEST(textureContainerMalformedCorpus)
+{
+	for (const MalformedContainer& container : MALFORMED_CONTAINERS)
+	{
+		std::string fileData;
+		OKAY_CHECK(readContainer(container.pFileName, fileData));
+
+		TextureMipChain mipChain;
+		const char* pError = nullptr;
+
+		bool parsed = parseTextureContainer((const uint8_t*)fileData.data(), fileData.size(), mipChain, &pError);
+		OKAY_CHECK(!parsed);
+
+		// Rejected for the reason the file was made for, not an earlier check
+		bool expectedError = pError && !strcmp(pError, container.pError);
+		if (!expectedError)
+		{
+			printf("    %s: expected \"%s\", got \"%s\"\n", container.pFileName, container.pError, pError ? pError : "nothing");
+		}
+
+		OKAY_CHECK(expectedError);
+	}
+
+	// Every malformed file in the folder has to be listed above
+	uint32_t numMalformedFiles = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(CONTAINER_PATH))
+	{
+		numMalformedFiles += entry.path().filename().string().rfind("bad_", 0) == 0;
+	}
+
+	OKAY_CHECK(numMalformedFiles == sizeof(MALFORMED_CONTAINERS) / sizeof(MALFORMED_CONTAINERS[0]));
+
+	TextureMipChain mipChain;
+	const char* pError = nullptr;
+	OKAY_CHECK(!loadTextureContainer(CONTAINER_PATH / "missing.dds", mipChain, &pError));
+	OKAY_CHECK(pError != nullptr);
+}
+
+// Every file in the valid corpus cut short anywhere, or with any header byte changed, mustn't read out of bounds
+OKAY_TEST(textureContainerTruncatedAndCorrupted)
+{
+	for (const ValidContainer& container : VALID_CONTAINERS)
+	{
+		std::string fileData;
+		OKAY_CHECK(readContainer(container.pFileName, fileData));
+
+		uint32_t numTruncatedParsed = 0;
+		for (uint64_t size = 0; size < fileData.size(); size++)
+		{
+			// A copy of exactly that size, so reading past it is caught by the address sanitizer
+			std::vector<uint8_t> truncated(fileData.begin(), fileData.begin() + size);
+
+			TextureMipChain mipChain;
+			const char* pError = nullptr;
+			numTruncatedParsed += parseTextureContainer(truncated.data(), truncated.size(), mipChain, &pError);
+		}
+
+		OKAY_CHECK(numTruncatedParsed == 0);
+
+		// The header & the KTX2 level index, the payload bytes can be anything
+		uint32_t headerSize = glm::min((uint32_t)fileData.size(), 80u + 24u * container.numLevels + 68u);
+		TestRandom random(headerSize);
+
+		for (uint32_t i = 0; i < headerSize; i++)
+		{
+			std::vector<uint8_t> corrupted(fileData.begin(), fileData.end());
+			corrupted[i] ^= (uint8_t)(1 + random.next(255));
+
+			TextureMipChain mipChain;
+			const char* pError = nullptr;
+			if (!parseTextureContainer(corrupted.data(), corrupted.size(), mipChain, &pError))
+			{
+				OKAY_CHECK(pError != nullptr);
+			}
+		}
+	}
+}
+
+OKAY_TEST(textureContainerPaths)
+{
+	OKAY_CHECK(isTextureContainerPath("textures/brick.dds"));
+	OKAY_CHECK(isTextureContainerPath("textures/brick.DDS"));
+	OKAY_CHECK(isTextureContainerPath("textures/brick.ktx2"));
+	OKAY_CHECK(!isTextureContainerPath("textures/brick.ktx"));
+	OKAY_CHECK(!isTextureContainerPath("textures/brick.tga"));
+	OKAY_CHECK(!isTextureContainerPath("textures/dds"));
+}
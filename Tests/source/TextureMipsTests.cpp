@@ -0,0 +1,243 @@
+#include "Tests.h"
+
+#include "Engine/Resources/TextureMips.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// Power of two, odd & mixed sizes, including the 1 texel wide & tall ones where only one axis is filtered
+static const uint32_t TEST_SIZES[][2] =
+{
+	{ 1, 1 }, { 2, 2 }, { 3, 3 }, { 5, 7 }, { 7, 5 }, { 64, 64 }, { 100, 37 },
+	{ 129, 257 }, { 1, 9 }, { 9, 1 }, { 256, 1 }, { 333, 333 },
+};
+
+static std::vector<uint8_t> createRandomTexture(uint32_t width, uint32_t height, uint32_t seed)
+{
+	TestRandom random(seed);
+
+	std::vector<uint8_t> textureData(width * height * 4);
+	for (uint8_t& value : textureData)
+	{
+		value = (uint8_t)random.next(256);
+	}
+
+	return textureData;
+}
+
+static double srgbToLinear(uint8_t value)
+{
+	double normalized = value / 255.0;
+	return normalized <= 0.04045 ? normalized / 12.92 : pow((normalized + 0.055) / 1.055, 2.4);
+}
+
+static double linearToSRGB(double linear)
+{
+	linear = glm::clamp(linear, 0.0, 1.0);
+	return (linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow(linear, 1.0 / 2.4) - 0.055) * 255.0;
+}
+
+// Exact area weighted box filter in doubles over the texels each output texel covers, written without the tap tables
+static std::vector<uint8_t> referenceDownsample(const uint8_t* pTextureData, uint32_t width, uint32_t height, uint32_t dstWidth, uint32_t dstHeight, bool isSRGB)
+{
+	std::vector<uint8_t> result(dstWidth * dstHeight * 4);
+
+	for (uint32_t y = 0; y < dstHeight; y++)
+	{
+		double y0 = (double)y * height / dstHeight;
+		double y1 = (double)(y + 1) * height / dstHeight;
+
+		for (uint32_t x = 0; x < dstWidth; x++)
+		{
+			double x0 = (double)x * width / dstWidth;
+			double x1 = (double)(x + 1) * width / dstWidth;
+
+			double sum[4] = {};
+			for (uint32_t srcY = (uint32_t)y0; srcY < height && srcY < y1; srcY++)
+			{
+				double weightY = glm::min(y1, srcY + 1.0) - glm::max(y0, (double)srcY);
+
+				for (uint32_t srcX = (uint32_t)x0; srcX < width && srcX < x1; srcX++)
+				{
+					double weight = (glm::min(x1, srcX + 1.0) - glm::max(x0, (double)srcX)) * weightY;
+
+					const uint8_t* pTexel = pTextureData + (srcY * width + srcX) * 4;
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						sum[c] += (isSRGB && c < 3 ? srgbToLinear(pTexel[c]) : pTexel[c] / 255.0) * weight;
+					}
+				}
+			}
+
+			double area = (x1 - x0) * (y1 - y0);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				double value = sum[c] / area;
+				result[(y * dstWidth + x) * 4 + c] = (uint8_t)lrint(isSRGB && c < 3 ? linearToSRGB(value) : value * 255.0);
+			}
+		}
+	}
+
+	return result;
+}
+
+OKAY_TEST(mipChainSIMDMatchesScalar)
+{
+	uint32_t seed = 1;
+	for (const uint32_t* pSize : TEST_SIZES)
+	{
+		std::vector<uint8_t> textureData = createRandomTexture(pSize[0], pSize[1], seed++);
+
+		for (bool isSRGB : { true, false })
+		{
+			TextureMipSettings settings;
+			settings.isSRGB = isSRGB;
+
+			TextureMipChain simdChain;
+			generateMipChain(textureData.data(), pSize[0], pSize[1], settings, simdChain);
+
+			settings.forceScalar = true;
+			TextureMipChain scalarChain;
+			generateMipChain(textureData.data(), pSize[0], pSize[1], settings, scalarChain);
+
+			// Bit exact, every level
+			OKAY_CHECK(simdChain.data == scalarChain.data);
+			OKAY_CHECK(simdChain.getNumLevels() == getNumMipLevels(pSize[0], pSize[1]));
+			OKAY_CHECK(scalarChain.getNumLevels() == simdChain.getNumLevels());
+		}
+	}
+}
+
+OKAY_TEST(mipLevelMatchesReferenceFilter)
+{
+	uint32_t seed = 100;
+	for (const uint32_t* pSize : TEST_SIZES)
+	{
+		uint32_t width = pSize[0], height = pSize[1];
+		if (width == 1 && height == 1)
+		{
+			continue;
+		}
+
+		std::vector<uint8_t> textureData = createRandomTexture(width, height, seed++);
+
+		for (bool isSRGB : { true, false })
+		{
+			for (bool forceScalar : { false, true })
+			{
+				TextureMipSettings settings;
+				settings.isSRGB = isSRGB;
+				settings.forceScalar = forceScalar;
+
+				TextureMipChain mipChain;
+				generateMipChain(textureData.data(), width, height, settings, mipChain);
+
+				const TextureMipLevel& level = mipChain.levels[1];
+				std::vector<uint8_t> reference = referenceDownsample(textureData.data(), width, height, level.width, level.height, isSRGB);
+
+				// The float filter & the encode table can land on the other side of a rounding step
+				uint32_t maxDifference = 0;
+				for (uint32_t i = 0; i < (uint32_t)reference.size(); i++)
+				{
+					maxDifference = glm::max(maxDifference, (uint32_t)abs(mipChain.data[level.offset + i] - reference[i]));
+				}
+
+				OKAY_CHECK(maxDifference <= 1);
+			}
+		}
+	}
+}
+
+OKAY_TEST(mipChainLayout)
+{
+	for (const uint32_t* pSize : TEST_SIZES)
+	{
+		std::vector<uint8_t> textureData = createRandomTexture(pSize[0], pSize[1], 7);
+
+		TextureMipChain mipChain;
+		generateMipChain(textureData.data(), pSize[0], pSize[1], TextureMipSettings(), mipChain);
+
+		// Tightly packed, halved & rounded down, ending at 1x1. The full size is a copy of the input
+		uint64_t offset = 0;
+		uint32_t width = pSize[0], height = pSize[1];
+		for (const TextureMipLevel& level : mipChain.levels)
+		{
+			OKAY_CHECK(level.width == width && level.height == height);
+			OKAY_CHECK(level.offset == offset);
+
+			offset += (uint64_t)width * height * 4;
+			width = glm::max(width / 2, 1u);
+			height = glm::max(height / 2, 1u);
+		}
+
+		OKAY_CHECK(offset == mipChain.data.size());
+		OKAY_CHECK(!memcmp(mipChain.data.data(), textureData.data(), textureData.size()));
+	}
+
+	std::vector<uint8_t> textureData = createRandomTexture(64, 64, 8);
+
+	TextureMipSettings settings;
+	settings.maxLevels = 3;
+
+	TextureMipChain mipChain;
+	generateMipChain(textureData.data(), 64, 64, settings, mipChain);
+	OKAY_CHECK(mipChain.getNumLevels() == 3);
+	OKAY_CHECK(mipChain.levels.back().width == 16);
+}
+
+// Odd sizes weigh 3 texels, the weights have to sum to 1 or flat colours drift down the chain
+OKAY_TEST(mipChainKeepsFlatColour)
+{
+	static const uint8_t COLOUR[4] = { 200, 17, 90, 128 };
+
+	for (bool isSRGB : { true, false })
+	{
+		for (const uint32_t* pSize : TEST_SIZES)
+		{
+			std::vector<uint8_t> textureData(pSize[0] * pSize[1] * 4);
+			for (uint32_t i = 0; i < (uint32_t)textureData.size(); i++)
+			{
+				textureData[i] = COLOUR[i % 4];
+			}
+
+			TextureMipSettings settings;
+			settings.isSRGB = isSRGB;
+
+			TextureMipChain mipChain;
+			generateMipChain(textureData.data(), pSize[0], pSize[1], settings, mipChain);
+
+			bool keptColour = true;
+			for (uint32_t i = 0; i < (uint32_t)mipChain.data.size(); i++)
+			{
+				keptColour &= mipChain.data[i] == COLOUR[i % 4];
+			}
+
+			OKAY_CHECK(keptColour);
+		}
+	}
+}
+
+OKAY_BENCHMARK(mipChainThroughput)
+{
+	static const uint32_t SIZE = 2048;
+	static const uint32_t NUM_ITERATIONS = 3;
+
+	std::vector<uint8_t> textureData = createRandomTexture(SIZE, SIZE, 9);
+
+	for (bool forceScalar : { false, true })
+	{
+		TextureMipSettings settings;
+		settings.forceScalar = forceScalar;
+
+		TextureMipChain mipChain;
+		double ms = measureMs(NUM_ITERATIONS, [&]()
+		{
+			generateMipChain(textureData.data(), SIZE, SIZE, settings, mipChain);
+		});
+
+		printf("    %s %ux%u sRGB chain: %.1f ms, %.0f Mtexels/s\n", forceScalar ? "Scalar" : "SSE2", SIZE, SIZE, ms, SIZE * SIZE / ms / 1e3);
+	}
+}
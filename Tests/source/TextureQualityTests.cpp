@@ -0,0 +1,193 @@
+#include "Tests.h"
+
+#include "Engine/Resources/TextureQuality.h"
+#include "Engine/Resources/TextureCompression.h"
+
+#include <algorithm>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static std::vector<uint8_t> createGradient(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> textureData((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			uint8_t* pTexel = textureData.data() + ((size_t)y * width + x) * 4;
+			pTexel[0] = (uint8_t)(x * 255 / width);
+			pTexel[1] = (uint8_t)(y * 255 / height);
+			pTexel[2] = 128;
+			pTexel[3] = 255;
+		}
+	}
+
+	return textureData;
+}
+
+static bool isTightlyPacked(const TextureMipChain& mipChain)
+{
+	uint64_t offset = 0;
+	for (uint32_t i = 0; i < mipChain.getNumLevels(); i++)
+	{
+		if (mipChain.levels[i].offset != offset)
+		{
+			return false;
+		}
+
+		offset += mipChain.getLevelSize(i);
+	}
+
+	return offset == mipChain.data.size();
+}
+
+OKAY_TEST(textureQualityTiers)
+{
+	TextureQualitySettings high = getTextureQualitySettings(OKAY_TEXTURE_QUALITY_HIGH);
+	TextureQualitySettings medium = getTextureQualitySettings(OKAY_TEXTURE_QUALITY_MEDIUM);
+	TextureQualitySettings low = getTextureQualitySettings(OKAY_TEXTURE_QUALITY_LOW);
+
+	OKAY_CHECK(high.numSkippedMips[OKAY_TEXTURE_CATEGORY_COLOUR] == 0 && high.numSkippedMips[OKAY_TEXTURE_CATEGORY_DATA] == 0);
+	OKAY_CHECK(medium.numSkippedMips[OKAY_TEXTURE_CATEGORY_COLOUR] == 1 && medium.numSkippedMips[OKAY_TEXTURE_CATEGORY_DATA] == 1);
+	OKAY_CHECK(low.numSkippedMips[OKAY_TEXTURE_CATEGORY_COLOUR] == 2 && low.numSkippedMips[OKAY_TEXTURE_CATEGORY_DATA] == 1);
+
+	OKAY_CHECK(getTextureCategory(true) == OKAY_TEXTURE_CATEGORY_COLOUR);
+	OKAY_CHECK(getTextureCategory(false) == OKAY_TEXTURE_CATEGORY_DATA);
+
+	static const uint64_t GIGABYTE = 1024ull * 1024 * 1024;
+	OKAY_CHECK(selectTextureQuality(0) == OKAY_TEXTURE_QUALITY_LOW);
+	OKAY_CHECK(selectTextureQuality(2 * GIGABYTE) == OKAY_TEXTURE_QUALITY_LOW);
+	OKAY_CHECK(selectTextureQuality(2 * GIGABYTE + 1) == OKAY_TEXTURE_QUALITY_MEDIUM);
+	OKAY_CHECK(selectTextureQuality(4 * GIGABYTE) == OKAY_TEXTURE_QUALITY_MEDIUM);
+	OKAY_CHECK(selectTextureQuality(8 * GIGABYTE) == OKAY_TEXTURE_QUALITY_HIGH);
+}
+
+OKAY_TEST(textureQualitySkippableMips)
+{
+	OKAY_CHECK(getNumSkippableMips(1024, 1024, 2, 64, false) == 2);
+	OKAY_CHECK(getNumSkippableMips(1024, 1024, 0, 64, false) == 0);
+
+	// Stops at 64 on the longest side
+	OKAY_CHECK(getNumSkippableMips(128, 128, 3, 64, false) == 1);
+	OKAY_CHECK(getNumSkippableMips(64, 64, 3, 64, false) == 0);
+	OKAY_CHECK(getNumSkippableMips(32, 32, 3, 64, false) == 0);
+	OKAY_CHECK(getNumSkippableMips(256, 16, 3, 64, false) == 2);
+
+	// A block compressed next level has to stay a multiple of 4
+	OKAY_CHECK(getNumSkippableMips(1024, 12, 3, 64, false) == 3);
+	OKAY_CHECK(getNumSkippableMips(1024, 12, 3, 64, true) == 0);
+	OKAY_CHECK(getNumSkippableMips(1024, 24, 3, 64, true) == 1);
+	OKAY_CHECK(getNumSkippableMips(1000, 1000, 3, 64, true) == 1);
+}
+
+OKAY_TEST(textureQualitySkipsLevels)
+{
+	std::vector<uint8_t> textureData = createGradient(256, 128);
+
+	TextureMipChain mipChain;
+	generateMipChain(textureData.data(), 256, 128, TextureMipSettings(), mipChain);
+	TextureMipChain fullChain = mipChain;
+
+	skipTextureMips(mipChain, 2);
+
+	OKAY_CHECK(mipChain.getNumLevels() == fullChain.getNumLevels() - 2);
+	OKAY_CHECK(mipChain.levels[0].width == 64 && mipChain.levels[0].height == 32);
+	OKAY_CHECK(isTightlyPacked(mipChain));
+
+	// The kept levels are untouched
+	bool levelsMatch = true;
+	for (uint32_t i = 0; i < mipChain.getNumLevels(); i++)
+	{
+		const TextureMipLevel& level = mipChain.levels[i];
+		const TextureMipLevel& fullLevel = fullChain.levels[i + 2];
+
+		levelsMatch &= level.width == fullLevel.width && level.height == fullLevel.height;
+		levelsMatch &= std::equal(mipChain.data.begin() + level.offset, mipChain.data.begin() + level.offset + mipChain.getLevelSize(i),
+			fullChain.data.begin() + fullLevel.offset);
+	}
+
+	OKAY_CHECK(levelsMatch);
+
+	// What the skipped levels would have taken
+	OKAY_CHECK(getSkippedMipsSize(OKAY_TEXTURE_FORMAT_RGBA8, 256, 128, 2) == fullChain.data.size() - mipChain.data.size());
+	OKAY_CHECK(getSkippedMipsSize(OKAY_TEXTURE_FORMAT_BC1, 256, 128, 2) == (256 * 128 + 128 * 64) / 2);
+
+	TextureMipChain unchanged = fullChain;
+	skipTextureMips(unchanged, 0);
+	OKAY_CHECK(unchanged.data == fullChain.data && unchanged.getNumLevels() == fullChain.getNumLevels());
+}
+
+OKAY_TEST(textureQualityPerCategory)
+{
+	std::vector<uint8_t> textureData = createGradient(512, 512);
+
+	TextureMipChain fullChain;
+	generateMipChain(textureData.data(), 512, 512, TextureMipSettings(), fullChain);
+
+	static const uint32_t EXPECTED_SKIPS[OKAY_TEXTURE_QUALITY_COUNT][OKAY_TEXTURE_CATEGORY_COUNT] = { { 0, 0 }, { 1, 1 }, { 2, 1 } };
+
+	for (uint32_t quality = 0; quality < OKAY_TEXTURE_QUALITY_COUNT; quality++)
+	{
+		TextureQualitySettings settings = getTextureQualitySettings((TextureQuality)quality);
+
+		for (uint32_t category = 0; category < OKAY_TEXTURE_CATEGORY_COUNT; category++)
+		{
+			TextureMipChain mipChain = fullChain;
+			uint32_t numSkipped = applyTextureQuality(mipChain, category == OKAY_TEXTURE_CATEGORY_COLOUR, settings, false);
+
+			uint32_t expectedSkips = EXPECTED_SKIPS[quality][category];
+			OKAY_CHECK(numSkipped == expectedSkips);
+			OKAY_CHECK(mipChain.getNumLevels() == fullChain.getNumLevels() - expectedSkips);
+			OKAY_CHECK(mipChain.levels[0].width == 512u >> expectedSkips);
+			OKAY_CHECK(isTightlyPacked(mipChain));
+		}
+	}
+
+	// Small textures are left alone on every tier
+	TextureMipChain smallChain;
+	generateMipChain(textureData.data(), 64, 64, TextureMipSettings(), smallChain);
+	OKAY_CHECK(applyTextureQuality(smallChain, true, getTextureQualitySettings(OKAY_TEXTURE_QUALITY_LOW), false) == 0);
+	OKAY_CHECK(smallChain.levels[0].width == 64);
+}
+
+// A BC1 DDS with only the full size, skipping needs the levels below it so they're built from the decoded full size
+OKAY_TEST(textureQualityRebuildsSingleLevel)
+{
+	std::vector<uint8_t> textureData = createGradient(256, 256);
+
+	TextureMipChain mipChain;
+	mipChain.format = OKAY_TEXTURE_FORMAT_BC1;
+	mipChain.levels.push_back({ 256, 256, 0 });
+	mipChain.data.resize(getTextureLevelSize(OKAY_TEXTURE_FORMAT_BC1, 256, 256));
+	compressTextureLevel(textureData.data(), 256, 256, OKAY_TEXTURE_FORMAT_BC1, mipChain.data.data());
+
+	TextureMipChain singleLevel = mipChain;
+
+	uint32_t numSkipped = applyTextureQuality(mipChain, true, getTextureQualitySettings(OKAY_TEXTURE_QUALITY_LOW), false);
+	OKAY_CHECK(numSkipped == 2);
+
+	// Encoded in the original format again, from 64x64 down to 1x1
+	OKAY_CHECK(mipChain.format == OKAY_TEXTURE_FORMAT_BC1);
+	OKAY_CHECK(mipChain.getNumLevels() == getNumMipLevels(64, 64));
+	OKAY_CHECK(mipChain.levels[0].width == 64 && mipChain.levels[0].height == 64);
+	OKAY_CHECK(isTightlyPacked(mipChain));
+
+	// Same as building the whole chain & skipping afterwards
+	TextureMipChain rgba8Chain;
+	decodeAndGenerateMips(singleLevel, true, rgba8Chain);
+	skipTextureMips(rgba8Chain, 2);
+
+	TextureMipChain expectedChain;
+	compressMipChain(rgba8Chain, OKAY_TEXTURE_FORMAT_BC1, expectedChain);
+	OKAY_CHECK(mipChain.data == expectedChain.data);
+
+	// A single 64x64 level can't be skipped, nothing is rebuilt
+	TextureMipChain smallChain;
+	smallChain.format = OKAY_TEXTURE_FORMAT_BC1;
+	smallChain.levels.push_back({ 64, 64, 0 });
+	smallChain.data.resize(getTextureLevelSize(OKAY_TEXTURE_FORMAT_BC1, 64, 64));
+
+	OKAY_CHECK(applyTextureQuality(smallChain, true, getTextureQualitySettings(OKAY_TEXTURE_QUALITY_LOW), false) == 0);
+	OKAY_CHECK(smallChain.getNumLevels() == 1);
+}
@@ -0,0 +1,301 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/TextureStreaming.h"
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static const uint64_t TILE_SIZE = 65536;
+static const uint32_t UNLIMITED_TILES = UINT32_MAX;
+
+// Standard mips of 16, 4 & 1 tiles (a 1024x1024 BC3 texture), the mip tail after them
+static StreamedTextureDesc createTextureDesc()
+{
+	StreamedTextureDesc desc;
+	desc.mipTiles = { 16, 4, 1 };
+	desc.mipUploadSizes = { 16 * TILE_SIZE, 4 * TILE_SIZE, TILE_SIZE };
+	return desc;
+}
+
+static TextureStreamingSettings createSettings(uint64_t budgetTiles, uint64_t maxUploadBytes = UINT64_MAX)
+{
+	TextureStreamingSettings settings;
+	settings.budgetTiles = budgetTiles;
+	settings.maxUploadBytes = maxUploadBytes;
+	return settings;
+}
+
+// One frame, every texture in requests with its mip, negative ones aren't requested
+static void runFrame(TextureStreamer& streamer, const std::vector<float>& requests, const TextureStreamingSettings& settings)
+{
+	streamer.beginFrame();
+
+	for (uint32_t i = 0; i < (uint32_t)requests.size(); i++)
+	{
+		if (requests[i] >= 0.f)
+		{
+			streamer.requestMip(i, requests[i]);
+		}
+	}
+
+	streamer.update(settings, UNLIMITED_TILES);
+}
+
+OKAY_TEST(meshUVDensity)
+{
+	// A 10x10 quad in world units
+	MeshData meshData;
+	meshData.verticies.resize(4);
+	meshData.verticies[0].position = glm::vec3(0.f, 0.f, 0.f);
+	meshData.verticies[1].position = glm::vec3(10.f, 0.f, 0.f);
+	meshData.verticies[2].position = glm::vec3(0.f, 10.f, 0.f);
+	meshData.verticies[3].position = glm::vec3(10.f, 10.f, 0.f);
+	meshData.indicies = { 0, 2, 1, 1, 2, 3 };
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		meshData.verticies[i].uv = glm::vec2(meshData.verticies[i].position) * 0.1f;
+	}
+
+	OKAY_CHECK(glm::abs(computeMeshUVDensity(meshData) - 10.f) < 1e-4f);
+
+	// The texture repeats twice, half the world units per UV
+	for (Vertex& vertex : meshData.verticies)
+	{
+		vertex.uv *= 2.f;
+	}
+	OKAY_CHECK(glm::abs(computeMeshUVDensity(meshData) - 5.f) < 1e-4f);
+
+	for (Vertex& vertex : meshData.verticies)
+	{
+		vertex.uv = glm::vec2(0.5f);
+	}
+	OKAY_CHECK(computeMeshUVDensity(meshData) == 0.f);
+	OKAY_CHECK(computeMeshUVDensity(MeshData()) == 0.f);
+}
+
+OKAY_TEST(requiredTextureMipEstimation)
+{
+	// 1024 pixels per world unit at distance 1, a 1024 texel texture over one world unit needs the full size there
+	static const float PROJECTION_SCALE = 1024.f;
+
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 1.f, PROJECTION_SCALE) - 0.f) < 1e-4f);
+
+	// Every doubling of the distance is one mip
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 2.f, PROJECTION_SCALE) - 1.f) < 1e-4f);
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 8.f, PROJECTION_SCALE) - 3.f) < 1e-4f);
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 3.f, PROJECTION_SCALE) - glm::log2(3.f)) < 1e-4f);
+
+	// Bigger objects & denser UVs cover more pixels, half the texture size needs one mip less
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(1024, 1024, 1.f, 2.f, 8.f, PROJECTION_SCALE) - 2.f) < 1e-4f);
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(1024, 1024, 4.f, 1.f, 8.f, PROJECTION_SCALE) - 1.f) < 1e-4f);
+	OKAY_CHECK(glm::abs(computeRequiredTextureMip(512, 512, 1.f, 1.f, 8.f, PROJECTION_SCALE) - 2.f) < 1e-4f);
+
+	// The bigger side decides
+	OKAY_CHECK(computeRequiredTextureMip(1024, 16, 1.f, 1.f, 8.f, PROJECTION_SCALE) == computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 8.f, PROJECTION_SCALE));
+
+	// Closer than one texel per pixel is still the full size, and unknown UV mappings need everything
+	OKAY_CHECK(computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 0.1f, PROJECTION_SCALE) == 0.f);
+	OKAY_CHECK(computeRequiredTextureMip(1024, 1024, 1.f, 1.f, 0.f, PROJECTION_SCALE) == 0.f);
+	OKAY_CHECK(computeRequiredTextureMip(1024, 1024, 0.f, 1.f, 100.f, PROJECTION_SCALE) == 0.f);
+
+	// The streamer rounds the fraction down to the more detailed mip
+	TextureStreamer streamer;
+	streamer.addTexture(createTextureDesc());
+	runFrame(streamer, { 1.9f }, createSettings(100));
+	OKAY_CHECK(streamer.getResidentMip(0) == 1);
+
+	runFrame(streamer, { 17.f }, createSettings(100));
+	OKAY_CHECK(streamer.getResidentMip(0) == 1); // Under the budget, extra detail is kept
+}
+
+OKAY_TEST(textureStreamingLoadsFromTheTailUp)
+{
+	TextureStreamer streamer;
+	uint32_t textureIdx = streamer.addTexture(createTextureDesc());
+
+	OKAY_CHECK(streamer.getNumStandardMips(textureIdx) == 3);
+	OKAY_CHECK(streamer.getResidentMip(textureIdx) == 3);
+
+	runFrame(streamer, { 0.f }, createSettings(100));
+	OKAY_CHECK(streamer.getResidentMip(textureIdx) == 0);
+
+	const std::vector<TextureStreamer::MipChange>& changes = streamer.getMipChanges();
+	OKAY_CHECK(changes.size() == 3);
+	for (uint32_t i = 0; i < (uint32_t)changes.size(); i++)
+	{
+		OKAY_CHECK(changes[i].textureIdx == textureIdx);
+		OKAY_CHECK(changes[i].mip == 2 - i);
+		OKAY_CHECK(changes[i].isLoad);
+	}
+
+	OKAY_CHECK(streamer.getStats().residentTiles == 21);
+	OKAY_CHECK(streamer.getStats().uploadedBytes == 21 * TILE_SIZE);
+}
+
+OKAY_TEST(textureStreamingUploadLimit)
+{
+	TextureStreamer streamer;
+	streamer.addTexture(createTextureDesc());
+	streamer.addTexture(createTextureDesc());
+
+	// 2 tiles a frame, the 4 & 16 tile mips still go one per frame on their own
+	TextureStreamingSettings settings = createSettings(100, 2 * TILE_SIZE);
+
+	runFrame(streamer, { 0.f, 0.f }, settings);
+	OKAY_CHECK(streamer.getStats().numMipsLoaded == 2);
+	OKAY_CHECK(streamer.getResidentMip(0) == 2 && streamer.getResidentMip(1) == 2);
+
+	runFrame(streamer, { 0.f, 0.f }, settings);
+	OKAY_CHECK(streamer.getStats().numMipsLoaded == 1);
+	OKAY_CHECK(streamer.getStats().uploadedBytes == 4 * TILE_SIZE);
+
+	uint32_t numFrames = 2;
+	while (streamer.getResidentMip(0) || streamer.getResidentMip(1))
+	{
+		runFrame(streamer, { 0.f, 0.f }, settings);
+		OKAY_CHECK(streamer.getStats().numMipsLoaded == 1);
+		numFrames++;
+	}
+
+	OKAY_CHECK(numFrames == 5);
+
+	// Mips that don't fit in the free tiles wait
+	TextureStreamer tileLimited;
+	tileLimited.addTexture(createTextureDesc());
+	tileLimited.beginFrame();
+	tileLimited.requestMip(0, 0.f);
+	tileLimited.update(createSettings(100), 5);
+	OKAY_CHECK(tileLimited.getResidentMip(0) == 1);
+}
+
+OKAY_TEST(textureStreamingStaysInBudget)
+{
+	TextureStreamer streamer;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		streamer.addTexture(createTextureDesc());
+	}
+
+	// 63 tiles requested, one mip less each is 15
+	runFrame(streamer, { 0.f, 0.f, 0.f }, createSettings(30));
+
+	const TextureStreamer::Stats& stats = streamer.getStats();
+	OKAY_CHECK(stats.requestedTiles == 63);
+	OKAY_CHECK(stats.residentTiles == 15);
+	OKAY_CHECK(stats.budgetBias == 1);
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		OKAY_CHECK(streamer.getResidentMip(i) == 1);
+	}
+
+	// Any budget, any requests, never over it once the evictions are done
+	TestRandom random(3);
+	bool overBudget = false;
+
+	for (uint32_t frame = 0; frame < 200; frame++)
+	{
+		uint64_t budgetTiles = random.next(70);
+
+		std::vector<float> requests(3);
+		for (float& request : requests)
+		{
+			request = random.nextFloat(-2.f, 4.f);
+		}
+
+		runFrame(streamer, requests, createSettings(budgetTiles));
+		overBudget |= streamer.getStats().residentTiles > budgetTiles;
+	}
+
+	OKAY_CHECK(!overBudget);
+}
+
+OKAY_TEST(textureStreamingEvictionOrder)
+{
+	TextureStreamer streamer;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		streamer.addTexture(createTextureDesc());
+	}
+
+	// Every texture fully resident, then they stop being requested one after the other
+	runFrame(streamer, { 0.f, 0.f, 0.f, 0.f }, createSettings(100));
+	runFrame(streamer, { -1.f, 0.f, 0.f, 0.f }, createSettings(100));
+	runFrame(streamer, { -1.f, -1.f, 0.f, 0.f }, createSettings(100));
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		OKAY_CHECK(streamer.getResidentMip(i) == 0);
+	}
+
+	// Texture 2 only needs mip 2 now. Room for 3 full textures, the least recently requested goes
+	runFrame(streamer, { -1.f, -1.f, 2.f, 0.f }, createSettings(63));
+	OKAY_CHECK(streamer.getResidentMip(0) == 3);
+	OKAY_CHECK(streamer.getResidentMip(1) == 0);
+	OKAY_CHECK(streamer.getResidentMip(2) == 0);
+	OKAY_CHECK(streamer.getResidentMip(3) == 0);
+
+	// Evicted from the full size down
+	const std::vector<TextureStreamer::MipChange>& changes = streamer.getMipChanges();
+	OKAY_CHECK(changes.size() == 3);
+	for (uint32_t i = 0; i < (uint32_t)changes.size(); i++)
+	{
+		OKAY_CHECK(changes[i].textureIdx == 0);
+		OKAY_CHECK(changes[i].mip == i);
+		OKAY_CHECK(!changes[i].isLoad);
+	}
+
+	// The other unrequested texture goes next, then the extra detail texture 2 kept
+	runFrame(streamer, { -1.f, -1.f, 2.f, 0.f }, createSettings(22));
+	OKAY_CHECK(streamer.getResidentMip(1) == 3);
+	OKAY_CHECK(streamer.getResidentMip(2) == 2);
+	OKAY_CHECK(streamer.getResidentMip(3) == 0);
+	OKAY_CHECK(streamer.getStats().budgetBias == 0);
+	OKAY_CHECK(streamer.getStats().numMipsEvicted == 5);
+
+	// Last, every requested texture drops a mip
+	runFrame(streamer, { -1.f, -1.f, 2.f, 0.f }, createSettings(10));
+	OKAY_CHECK(streamer.getResidentMip(2) == 3);
+	OKAY_CHECK(streamer.getResidentMip(3) == 1);
+	OKAY_CHECK(streamer.getStats().budgetBias == 1);
+	OKAY_CHECK(streamer.getStats().residentTiles == 5);
+}
+
+OKAY_TEST(textureTilePool)
+{
+	TextureTilePool pool;
+	pool.initialize(10);
+	OKAY_CHECK(pool.getNumFreeTiles() == 10);
+
+	std::vector<uint32_t> tiles;
+	OKAY_CHECK(pool.allocate(4, tiles));
+	OKAY_CHECK(tiles.size() == 4);
+	OKAY_CHECK(pool.getNumFreeTiles() == 6);
+
+	// All or nothing
+	std::vector<uint32_t> tooManyTiles;
+	OKAY_CHECK(!pool.allocate(7, tooManyTiles));
+	OKAY_CHECK(tooManyTiles.empty());
+	OKAY_CHECK(pool.getNumFreeTiles() == 6);
+
+	std::vector<uint32_t> otherTiles;
+	OKAY_CHECK(pool.allocate(6, otherTiles));
+
+	// Every tile handed out once
+	std::vector<bool> used(10, false);
+	bool uniqueTiles = true;
+	for (const std::vector<uint32_t>* pTiles : { &tiles, &otherTiles })
+	{
+		for (uint32_t tile : *pTiles)
+		{
+			uniqueTiles &= tile < 10 && !used[tile];
+			used[tile] = true;
+		}
+	}
+	OKAY_CHECK(uniqueTiles);
+
+	pool.free(tiles);
+	pool.free(otherTiles);
+	OKAY_CHECK(pool.getNumFreeTiles() == 10);
+}
@@ -0,0 +1,285 @@
+#include "Tests.h"
+
+#include "Engine/Resources/TgaDecoder.h"
+
+// Our own copy of stb_image as the reference, static so it doesn't clash with the one in the engine
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_TGA
+#include "stb/stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// Seeds for the fuzz test & the stb comparison. Files starting with bad_ are malformed or unsupported & must be rejected
+static const FilePath TGA_CORPUS_PATH = RESOURCE_PATH / "tga";
+static const FilePath SPONZA_TEXTURE_PATH = FilePath("..") / "Game" / "resources" / "sponza" / "textures";
+
+// Mutated files can claim up to 32768x32768, the fuzz test doesn't need to allocate that
+static const uint64_t MAX_FUZZ_TEXELS = 1 << 20;
+
+struct TgaFile
+{
+	std::string name;
+	std::vector<uint8_t> data;
+};
+
+static std::vector<TgaFile> readTgaFiles(const FilePath& folderPath)
+{
+	std::vector<TgaFile> files;
+	if (!std::filesystem::is_directory(folderPath))
+	{
+		return files;
+	}
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(folderPath))
+	{
+		std::string fileData;
+		if (!isTgaPath(entry.path()) || !readBinary(entry.path(), fileData))
+		{
+			continue;
+		}
+
+		TgaFile& file = files.emplace_back();
+		file.name = entry.path().filename().string();
+		file.data.assign(fileData.begin(), fileData.end());
+	}
+
+	// Directory order isn't defined
+	std::sort(files.begin(), files.end(), [](const TgaFile& a, const TgaFile& b) { return a.name < b.name; });
+	return files;
+}
+
+static bool isMalformedName(const std::string& name)
+{
+	return name.rfind("bad_", 0) == 0;
+}
+
+// stb refuses true colour files that have a colour map, even though it isn't used. The reference gets the file without it
+static std::vector<uint8_t> removeColourMap(const std::vector<uint8_t>& fileData)
+{
+	std::vector<uint8_t> result = fileData;
+
+	uint64_t colourMapOffset = 18 + (uint64_t)fileData[0];
+	uint64_t colourMapSize = (uint64_t)(fileData[5] | fileData[6] << 8) * ((fileData[7] + 7) / 8);
+	result.erase(result.begin() + colourMapOffset, result.begin() + colourMapOffset + colourMapSize);
+
+	result[1] = 0;
+	memset(result.data() + 3, 0, 5);
+
+	return result;
+}
+
+// Decodes into a buffer of exactly the right size, so any write past it is caught by the address sanitizer
+static bool decodeTgaFile(const std::vector<uint8_t>& fileData, bool forceScalar, std::vector<uint8_t>& outTexels)
+{
+	TgaInfo info;
+	if (!readTgaInfo(fileData.data(), fileData.size(), info) || (uint64_t)info.width * info.height > MAX_FUZZ_TEXELS)
+	{
+		return false;
+	}
+
+	outTexels.assign((uint64_t)info.width * info.height * 4, 0xCD);
+	return decodeTga(fileData.data(), fileData.size(), outTexels.data(), forceScalar);
+}
+
+OKAY_TEST(tgaCorpusMatchesStb)
+{
+	std::vector<TgaFile> files = readTgaFiles(TGA_CORPUS_PATH);
+	OKAY_CHECK(!files.empty());
+
+	uint32_t numCompared = 0;
+	for (const TgaFile& file : files)
+	{
+		if (isMalformedName(file.name))
+		{
+			continue;
+		}
+
+		std::vector<uint8_t> referenceData = file.name.rfind("unused_colour_map", 0) == 0 ? removeColourMap(file.data) : file.data;
+
+		int width = 0, height = 0, numChannels = 0;
+		uint8_t* pReference = stbi_load_from_memory(referenceData.data(), (int)referenceData.size(), &width, &height, &numChannels, STBI_rgb_alpha);
+		OKAY_CHECK(pReference);
+		if (!pReference)
+		{
+			continue;
+		}
+
+		TgaInfo info;
+		OKAY_CHECK(readTgaInfo(file.data.data(), file.data.size(), info));
+		OKAY_CHECK(info.width == (uint32_t)width && info.height == (uint32_t)height && info.numChannels == (uint32_t)numChannels);
+
+		// Pixel exact, both paths
+		for (bool forceScalar : { false, true })
+		{
+			std::vector<uint8_t> texels;
+			bool decoded = decodeTgaFile(file.data, forceScalar, texels);
+			bool matches = decoded && texels.size() == (uint64_t)width * height * 4 && !memcmp(texels.data(), pReference, texels.size());
+
+			if (!matches)
+			{
+				printf("    %s %s doesn't match stb\n", file.name.c_str(), forceScalar ? "scalar" : "SSE2");
+			}
+
+			OKAY_CHECK(matches);
+		}
+
+		stbi_image_free(pReference);
+		numCompared++;
+	}
+
+	// 24 & 32 bit, RLE, bottom & top origins & grayscale are all in there
+	OKAY_CHECK(numCompared >= 13);
+}
+
+OKAY_TEST(tgaCorpusRejectsMalformed)
+{
+	uint32_t numMalformed = 0;
+	for (const TgaFile& file : readTgaFiles(TGA_CORPUS_PATH))
+	{
+		if (!isMalformedName(file.name))
+		{
+			continue;
+		}
+
+		// Either the header is refused or the decode fails
+		for (bool forceScalar : { false, true })
+		{
+			std::vector<uint8_t> texels;
+			bool decoded = decodeTgaFile(file.data, forceScalar, texels);
+			if (decoded)
+			{
+				printf("    %s was decoded\n", file.name.c_str());
+			}
+
+			OKAY_CHECK(!decoded);
+		}
+
+		numMalformed++;
+	}
+
+	OKAY_CHECK(numMalformed >= 14);
+}
+
+// Mutated corpus files, nothing can be read or written out of bounds & both paths have to agree on what they accept
+OKAY_TEST(tgaDecoderFuzz)
+{
+	static const uint32_t NUM_MUTATIONS = 3000;
+
+	std::vector<TgaFile> files = readTgaFiles(TGA_CORPUS_PATH);
+	OKAY_CHECK(!files.empty());
+
+	TestRandom random(49);
+	uint32_t numDecoded = 0;
+	uint32_t numMismatches = 0;
+
+	for (const TgaFile& file : files)
+	{
+		for (uint32_t i = 0; i < NUM_MUTATIONS; i++)
+		{
+			std::vector<uint8_t> fileData = file.data;
+
+			// Mostly the header & the first packets, that's where the sizes & counts are
+			uint32_t numFlips = 1 + random.next(4);
+			for (uint32_t j = 0; j < numFlips && !fileData.empty(); j++)
+			{
+				uint32_t maxOffset = random.next(4) ? glm::min((uint32_t)fileData.size(), 40u) : (uint32_t)fileData.size();
+				fileData[random.next(maxOffset)] ^= (uint8_t)(1 + random.next(255));
+			}
+
+			switch (random.next(4))
+			{
+			case 0:
+				fileData.resize(random.next((uint32_t)fileData.size() + 1));
+				break;
+
+			case 1:
+				fileData.resize(fileData.size() + random.next(64), (uint8_t)random.next(256));
+				break;
+
+			default:
+				break;
+			}
+
+			std::vector<uint8_t> simdTexels, scalarTexels;
+			bool simdDecoded = decodeTgaFile(fileData, false, simdTexels);
+			bool scalarDecoded = decodeTgaFile(fileData, true, scalarTexels);
+
+			numMismatches += simdDecoded != scalarDecoded || (simdDecoded && simdTexels != scalarTexels);
+			numDecoded += simdDecoded;
+		}
+	}
+
+	printf("    %u of %u mutations decoded\n", numDecoded, (uint32_t)files.size() * NUM_MUTATIONS);
+	OKAY_CHECK(numMismatches == 0);
+	OKAY_CHECK(numDecoded > 0);
+}
+
+OKAY_BENCHMARK(tgaDecoderVsStb)
+{
+	std::vector<TgaFile> files = readTgaFiles(SPONZA_TEXTURE_PATH);
+	if (files.empty())
+	{
+		printf("    No TGAs in %s\n", SPONZA_TEXTURE_PATH.string().c_str());
+		return;
+	}
+
+	static const uint32_t NUM_ITERATIONS = 3;
+
+	uint64_t numTexels = 0;
+	uint64_t maxTexels = 0;
+	bool allMatch = true;
+
+	for (const TgaFile& file : files)
+	{
+		TgaInfo info;
+		OKAY_CHECK(readTgaInfo(file.data.data(), file.data.size(), info));
+
+		numTexels += (uint64_t)info.width * info.height;
+		maxTexels = glm::max(maxTexels, (uint64_t)info.width * info.height);
+	}
+
+	std::vector<uint8_t> texels(maxTexels * 4);
+
+	double stbMs = measureMs(NUM_ITERATIONS, [&]()
+	{
+		for (const TgaFile& file : files)
+		{
+			int width = 0, height = 0, numChannels = 0;
+			stbi_image_free(stbi_load_from_memory(file.data.data(), (int)file.data.size(), &width, &height, &numChannels, STBI_rgb_alpha));
+		}
+	});
+
+	double decoderMs[2] = {};
+	for (bool forceScalar : { false, true })
+	{
+		decoderMs[forceScalar] = measureMs(NUM_ITERATIONS, [&]()
+		{
+			for (const TgaFile& file : files)
+			{
+				allMatch &= decodeTga(file.data.data(), file.data.size(), texels.data(), forceScalar);
+			}
+		});
+	}
+
+	// Same pixels as stb on the real textures too
+	for (const TgaFile& file : files)
+	{
+		int width = 0, height = 0, numChannels = 0;
+		uint8_t* pReference = stbi_load_from_memory(file.data.data(), (int)file.data.size(), &width, &height, &numChannels, STBI_rgb_alpha);
+
+		allMatch &= pReference && decodeTga(file.data.data(), file.data.size(), texels.data());
+		allMatch &= pReference && !memcmp(texels.data(), pReference, (uint64_t)width * height * 4);
+
+		stbi_image_free(pReference);
+	}
+
+	OKAY_CHECK(allMatch);
+
+	printf("    %u Sponza TGAs, %.1f Mtexels\n", (uint32_t)files.size(), numTexels / 1e6);
+	printf("    stb: %.1f ms, SSE2: %.1f ms (%.1fx), scalar: %.1f ms\n", stbMs, decoderMs[0], stbMs / decoderMs[0], decoderMs[1]);
+}
@@ -0,0 +1,156 @@
+#include "Tests.h"
+
+#include "Engine/Resources/VertexQuantization.h"
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+static glm::vec3 randomDirection(TestRandom& random)
+{
+	glm::vec3 direction;
+	do
+	{
+		direction = glm::vec3(random.nextFloat(-1.f, 1.f), random.nextFloat(-1.f, 1.f), random.nextFloat(-1.f, 1.f));
+	} while (glm::length(direction) < 0.1f);
+
+	return glm::normalize(direction);
+}
+
+// Random verticies with an orthonormal tangent frame, half of them mirrored
+static std::vector<Vertex> createRandomVerticies(uint32_t numVerticies, uint32_t seed)
+{
+	TestRandom random(seed);
+
+	std::vector<Vertex> verticies(numVerticies);
+	for (Vertex& vertex : verticies)
+	{
+		vertex.position = glm::vec3(random.nextFloat(-1500.f, 1500.f), random.nextFloat(-600.f, 600.f), random.nextFloat(-800.f, 800.f));
+		vertex.normal = randomDirection(random);
+		vertex.tangent = glm::normalize(glm::cross(vertex.normal, randomDirection(random)));
+		vertex.biTangent = glm::cross(vertex.normal, vertex.tangent) * (random.next(2) ? -1.f : 1.f);
+		vertex.uv = glm::vec2(random.nextFloat(-4.f, 4.f), random.nextFloat(-4.f, 4.f));
+	}
+
+	return verticies;
+}
+
+OKAY_TEST(packedPositionErrorWithinHalfStep)
+{
+	std::vector<Vertex> verticies = createRandomVerticies(20000, 1);
+	VertexQuantization quantization = computeVertexQuantization(verticies);
+
+	glm::vec3 maxError = glm::vec3(0.f);
+	for (const Vertex& vertex : verticies)
+	{
+		uint16_t quantized[3] = {};
+		quantizePosition(vertex.position, quantization, quantized);
+		maxError = glm::max(maxError, glm::abs(dequantizePosition(quantized, quantization) - vertex.position));
+	}
+
+	// Rounded to the nearest step, plus a few float ulps at these magnitudes
+	OKAY_CHECK(glm::all(glm::lessThanEqual(maxError, quantization.positionScale * 0.5f + 1e-3f)));
+
+	// Every axis spans a range, none collapsed to a single value
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		OKAY_CHECK(quantization.positionScale[i] > 0.f);
+	}
+}
+
+OKAY_TEST(octahedralNormalRoundTrip)
+{
+	TestRandom random(2);
+
+	float maxAngle = 0.f;
+	for (uint32_t i = 0; i < 100000; i++)
+	{
+		glm::vec3 direction = randomDirection(random);
+		glm::vec3 decoded = decodeOctahedral(encodeOctahedral(direction));
+
+		// Chord length, same as the angle in radians at these sizes
+		maxAngle = glm::max(maxAngle, glm::length(decoded - direction));
+	}
+
+	// The axes & the folded -Z hemisphere edges
+	static const glm::vec3 EDGE_CASES[] =
+	{
+		glm::vec3(1.f, 0.f, 0.f), glm::vec3(-1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f),
+		glm::vec3(0.f, -1.f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, -1.f),
+		glm::normalize(glm::vec3(1.f, 1.f, -1.f)), glm::normalize(glm::vec3(-1.f, 1.f, -1e-4f)),
+	};
+
+	for (glm::vec3 direction : EDGE_CASES)
+	{
+		maxAngle = glm::max(maxAngle, glm::length(decodeOctahedral(encodeOctahedral(direction)) - direction));
+	}
+
+	printf("    Max octahedral error: %.5f degrees\n", glm::degrees(maxAngle));
+	OKAY_CHECK(glm::degrees(maxAngle) < 0.01f);
+}
+
+OKAY_TEST(packedVertexRoundTrip)
+{
+	std::vector<Vertex> verticies = createRandomVerticies(20000, 3);
+	VertexQuantization quantization = computeVertexQuantization(verticies);
+
+	std::vector<PackedVertex> packedVerticies;
+	encodeVerticies(verticies, quantization, packedVerticies);
+	OKAY_CHECK(packedVerticies.size() == verticies.size());
+
+	float maxTangentAngle = 0.f;
+	bool bitangentSignsMatch = true;
+	bool uvsWithinHalfPrecision = true;
+
+	for (uint32_t i = 0; i < (uint32_t)verticies.size(); i++)
+	{
+		const Vertex& vertex = verticies[i];
+		Vertex decoded = decodeVertex(packedVerticies[i], quantization);
+
+		maxTangentAngle = glm::max(maxTangentAngle, glm::length(decoded.normal - vertex.normal));
+		maxTangentAngle = glm::max(maxTangentAngle, glm::length(decoded.tangent - vertex.tangent));
+
+		// Rebuilt from the cross product, only the handedness is stored
+		bitangentSignsMatch &= glm::dot(glm::normalize(decoded.biTangent), vertex.biTangent) > 0.9999f;
+
+		// 10 bit mantissa, round to nearest
+		glm::vec2 maxUVError = glm::abs(vertex.uv) * (1.f / 2048.f) + 1e-7f;
+		uvsWithinHalfPrecision &= glm::all(glm::lessThanEqual(glm::abs(decoded.uv - vertex.uv), maxUVError));
+	}
+
+	OKAY_CHECK(glm::degrees(maxTangentAngle) < 0.01f);
+	OKAY_CHECK(bitangentSignsMatch);
+	OKAY_CHECK(uvsWithinHalfPrecision);
+}
+
+OKAY_TEST(packedVertexZeroVectors)
+{
+	// Degenerate imports without normals or tangents mustn't turn into NaNs on the GPU
+	std::vector<Vertex> verticies(2);
+	verticies[1].position = glm::vec3(1.f);
+	VertexQuantization quantization = computeVertexQuantization(verticies);
+
+	Vertex decoded = decodeVertex(encodeVertex(verticies[0], quantization), quantization);
+	OKAY_CHECK(!glm::any(glm::isnan(decoded.normal)));
+	OKAY_CHECK(!glm::any(glm::isnan(decoded.tangent)));
+	OKAY_CHECK(!glm::any(glm::isnan(decoded.biTangent)));
+}
+
+OKAY_TEST(indexSizeSelection)
+{
+	OKAY_CHECK(canUse16BitIndicies(0));
+	OKAY_CHECK(canUse16BitIndicies(3));
+	OKAY_CHECK(canUse16BitIndicies(UINT16_MAX));
+
+	// The last index is 65535, still fits
+	OKAY_CHECK(canUse16BitIndicies(UINT16_MAX + 1u));
+	OKAY_CHECK(!canUse16BitIndicies(UINT16_MAX + 2u));
+
+	MeshData meshData;
+	meshData.verticies.resize(UINT16_MAX + 1u);
+	meshData.indicies.resize(300);
+	OKAY_CHECK(getPackedMeshSize(meshData) == meshData.verticies.size() * sizeof(PackedVertex) + 300 * sizeof(uint16_t));
+	OKAY_CHECK(getUnpackedMeshSize(meshData) == meshData.verticies.size() * sizeof(Vertex) + 300 * sizeof(uint32_t));
+
+	meshData.verticies.resize(UINT16_MAX + 2u);
+	OKAY_CHECK(getPackedMeshSize(meshData) == meshData.verticies.size() * sizeof(PackedVertex) + 300 * sizeof(uint32_t));
+}
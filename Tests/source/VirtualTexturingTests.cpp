@@ -0,0 +1,400 @@
+#include "Tests.h"
+
+#include "Engine/Graphics/Handlers/VirtualTexturing.h"
+#include "Engine/Resources/TextureCompression.h"
+
+#include <cstring>
+
+using namespace Okay;
+using namespace Okay::Tests;
+
+// What the indirection tables should hold: every page points to itself if it's resident, otherwise to its closest resident parent
+static bool isIndirectionConsistent(const VirtualTextureSystem& system)
+{
+	for (uint32_t textureIdx = 0; textureIdx < system.getNumTextures(); textureIdx++)
+	{
+		uint32_t numMips = system.getNumMips(textureIdx);
+
+		for (uint32_t mip = 0; mip < numMips; mip++)
+		{
+			glm::uvec2 numPages = system.getNumPages(textureIdx, mip);
+			const std::vector<uint32_t>& entries = system.getIndirectionMip(textureIdx, mip);
+
+			for (uint32_t pageY = 0; pageY < numPages.y; pageY++)
+			{
+				for (uint32_t pageX = 0; pageX < numPages.x; pageX++)
+				{
+					uint32_t residentMip = mip;
+					uint32_t slot = system.findPage(packVirtualPage(textureIdx, mip, pageX, pageY));
+
+					while (slot == INVALID_UINT32 && residentMip + 1 < numMips)
+					{
+						residentMip++;
+						slot = system.findPage(packVirtualPage(textureIdx, residentMip, pageX >> (residentMip - mip), pageY >> (residentMip - mip)));
+					}
+
+					if (slot == INVALID_UINT32)
+					{
+						return false;
+					}
+
+					glm::uvec2 slotPosition = system.getSlotPosition(slot);
+					if (entries[pageY * numPages.x + pageX] != packIndirectionEntry(slotPosition.x, slotPosition.y, residentMip))
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+static void runFrame(VirtualTextureSystem& system, const std::vector<uint32_t>& feedback, uint32_t maxPageLoads = 32)
+{
+	VirtualTextureSettings settings;
+	settings.maxPageLoads = maxPageLoads;
+
+	system.beginFrame();
+	system.processFeedback(feedback.data(), feedback.size());
+	system.update(settings);
+}
+
+OKAY_TEST(virtualPagePacking)
+{
+	TestRandom random(1);
+
+	for (uint32_t i = 0; i < 10000; i++)
+	{
+		uint32_t textureIdx = random.next(MAX_VIRTUAL_TEXTURES);
+		uint32_t mip = random.next(MAX_VIRTUAL_MIPS);
+		uint32_t pageX = random.next(MAX_VIRTUAL_PAGES);
+		uint32_t pageY = random.next(MAX_VIRTUAL_PAGES);
+
+		VirtualPage page = unpackVirtualPage(packVirtualPage(textureIdx, mip, pageX, pageY));
+		OKAY_CHECK(page.textureIdx == textureIdx && page.mip == mip && page.pageX == pageX && page.pageY == pageY);
+	}
+
+	// The biggest page still isn't the empty entry, the empty entry isn't a valid texture
+	uint32_t lastPage = packVirtualPage(MAX_VIRTUAL_TEXTURES - 1, MAX_VIRTUAL_MIPS - 1, MAX_VIRTUAL_PAGES - 1, MAX_VIRTUAL_PAGES - 1);
+	OKAY_CHECK(lastPage != INVALID_UINT32);
+	OKAY_CHECK(unpackVirtualPage(INVALID_UINT32).textureIdx == MAX_VIRTUAL_TEXTURES);
+
+	uint32_t entry = packIndirectionEntry(MAX_VIRTUAL_CACHE_SLOTS - 1, MAX_VIRTUAL_CACHE_SLOTS - 1, MAX_VIRTUAL_MIPS - 1);
+	OKAY_CHECK(getIndirectionEntryMip(entry) == MAX_VIRTUAL_MIPS - 1);
+	OKAY_CHECK((entry & 0xFFF) == MAX_VIRTUAL_CACHE_SLOTS - 1 && ((entry >> 12) & 0xFFF) == MAX_VIRTUAL_CACHE_SLOTS - 1);
+
+	OKAY_CHECK(getNumVirtualPages(VIRTUAL_PAGE_SIZE, 0) == 1);
+	OKAY_CHECK(getNumVirtualPages(VIRTUAL_PAGE_SIZE + 1, 0) == 2);
+	OKAY_CHECK(getNumVirtualPages(1000, 3) == 1);
+
+	OKAY_CHECK(getNumVirtualMips(VIRTUAL_PAGE_SIZE, VIRTUAL_PAGE_SIZE) == 1);
+	OKAY_CHECK(getNumVirtualMips(VIRTUAL_PAGE_SIZE + 1, 16) == 2);
+	OKAY_CHECK(getNumVirtualMips(MAX_VIRTUAL_PAGES * VIRTUAL_PAGE_SIZE, 256) == 10);
+}
+
+OKAY_TEST(virtualPageCacheLRU)
+{
+	VirtualPageCache cache;
+	cache.initialize(4);
+
+	uint32_t evictedPage = INVALID_UINT32;
+
+	// Free slots first, in order
+	for (uint32_t pageID = 0; pageID < 4; pageID++)
+	{
+		OKAY_CHECK(cache.allocate(pageID, 1, false, &evictedPage) == pageID);
+		OKAY_CHECK(evictedPage == INVALID_UINT32);
+	}
+
+	OKAY_CHECK(cache.getNumResidentPages() == 4);
+
+	// Page 0 is used again, 1 is the least recently used now
+	cache.touch(cache.findPage(0), 2);
+
+	OKAY_CHECK(cache.allocate(10, 2, false, &evictedPage) == 1);
+	OKAY_CHECK(evictedPage == 1);
+	OKAY_CHECK(cache.findPage(1) == INVALID_UINT32);
+	OKAY_CHECK(cache.findPage(10) == 1);
+
+	OKAY_CHECK(cache.allocate(11, 2, false, &evictedPage) == 2);
+	OKAY_CHECK(evictedPage == 2);
+	OKAY_CHECK(cache.allocate(12, 2, false, &evictedPage) == 3);
+	OKAY_CHECK(evictedPage == 3);
+
+	// Everything left was used this frame
+	OKAY_CHECK(cache.allocate(13, 2, false, &evictedPage) == INVALID_UINT32);
+	OKAY_CHECK(evictedPage == INVALID_UINT32);
+	OKAY_CHECK(cache.findPage(0) == 0);
+	OKAY_CHECK(cache.getNumResidentPages() == 4);
+
+	// Next frame page 0 is the oldest again
+	OKAY_CHECK(cache.allocate(13, 3, false, &evictedPage) == 0);
+	OKAY_CHECK(evictedPage == 0);
+	OKAY_CHECK(cache.getSlotPage(0) == 13);
+}
+
+OKAY_TEST(virtualPageCacheLocking)
+{
+	VirtualPageCache cache;
+	cache.initialize(3);
+
+	uint32_t evictedPage = INVALID_UINT32;
+	OKAY_CHECK(cache.allocate(100, 0, true, &evictedPage) == 0);
+
+	// Locked pages are never evicted, however old & however often others are allocated
+	bool lockedPageKept = true;
+	for (uint32_t frame = 1; frame < 200; frame++)
+	{
+		uint32_t slot = cache.allocate(1000 + frame, frame, false, &evictedPage);
+
+		lockedPageKept &= slot != 0 && slot != INVALID_UINT32;
+		lockedPageKept &= evictedPage != 100;
+		lockedPageKept &= cache.findPage(100) == 0;
+
+		// Touching a locked slot doesn't put it in the eviction order
+		cache.touch(0, frame);
+	}
+
+	OKAY_CHECK(lockedPageKept);
+	OKAY_CHECK(cache.getNumResidentPages() == 3);
+
+	// Only locked slots left
+	VirtualPageCache lockedCache;
+	lockedCache.initialize(2);
+	OKAY_CHECK(lockedCache.allocate(1, 0, true, &evictedPage) == 0);
+	OKAY_CHECK(lockedCache.allocate(2, 0, true, &evictedPage) == 1);
+	OKAY_CHECK(lockedCache.allocate(3, 5, false, &evictedPage) == INVALID_UINT32);
+	OKAY_CHECK(lockedCache.findPage(1) == 0 && lockedCache.findPage(2) == 1);
+}
+
+OKAY_TEST(virtualTextureParentFallback)
+{
+	// 4 slots, a 512x512 texture has 4x4, 2x2 & 1x1 pages
+	VirtualTextureSystem system;
+	system.initialize(2, 2);
+
+	uint32_t textureIdx = system.addTexture(4 * VIRTUAL_PAGE_SIZE, 4 * VIRTUAL_PAGE_SIZE);
+	OKAY_CHECK(system.getNumMips(textureIdx) == 3);
+
+	// Only the least detailed page, everything points to it
+	uint32_t rootSlot = system.findPage(packVirtualPage(textureIdx, 2, 0, 0));
+	OKAY_CHECK(rootSlot == 0);
+	OKAY_CHECK(isIndirectionConsistent(system));
+
+	// The page is missing & so is its parent, the parent is loaded first
+	runFrame(system, { packVirtualPage(textureIdx, 0, 1, 1), INVALID_UINT32, packVirtualPage(textureIdx, 0, 1, 1) });
+
+	const std::vector<VirtualTextureSystem::PageLoad>& loads = system.getPageLoads();
+	OKAY_CHECK(loads.size() == 2);
+	if (loads.size() == 2)
+	{
+		OKAY_CHECK(loads[0].pageID == packVirtualPage(textureIdx, 1, 0, 0));
+		OKAY_CHECK(loads[1].pageID == packVirtualPage(textureIdx, 0, 1, 1));
+	}
+
+	OKAY_CHECK(system.getStats().numFeedbackEntries == 2);
+	OKAY_CHECK(system.getStats().numRequestedPages == 1);
+	OKAY_CHECK(isIndirectionConsistent(system));
+
+	// Its siblings use the parent, the rest of the texture the root
+	uint32_t parentSlot = system.findPage(packVirtualPage(textureIdx, 1, 0, 0));
+	glm::uvec2 parentPosition = system.getSlotPosition(parentSlot);
+	OKAY_CHECK(system.getIndirectionMip(textureIdx, 0)[0] == packIndirectionEntry(parentPosition.x, parentPosition.y, 1));
+	OKAY_CHECK(system.getIndirectionMip(textureIdx, 0)[15] == packIndirectionEntry(0, 0, 2));
+
+	// Every changed table mip is listed once
+	OKAY_CHECK(system.getIndirectionUpdates().size() == 2);
+
+	// Another corner, the cache is full so the now oldest parent page is evicted, its entries go back to the root while
+	// the page under it stays resident & keeps its own entry
+	runFrame(system, { packVirtualPage(textureIdx, 0, 3, 3) });
+
+	OKAY_CHECK(system.getStats().numPageLoads == 2);
+	OKAY_CHECK(system.getStats().numPageEvictions == 1);
+	OKAY_CHECK(system.findPage(packVirtualPage(textureIdx, 1, 0, 0)) == INVALID_UINT32);
+	OKAY_CHECK(system.findPage(packVirtualPage(textureIdx, 0, 1, 1)) != INVALID_UINT32);
+	OKAY_CHECK(system.getIndirectionMip(textureIdx, 0)[0] == packIndirectionEntry(0, 0, 2));
+	OKAY_CHECK(getIndirectionEntryMip(system.getIndirectionMip(textureIdx, 0)[1 * 4 + 1]) == 0);
+	OKAY_CHECK(isIndirectionConsistent(system));
+
+	// The root is still there & locked
+	OKAY_CHECK(system.findPage(packVirtualPage(textureIdx, 2, 0, 0)) == rootSlot);
+}
+
+// Random feedback over several textures with a small cache, the tables have to stay consistent through every eviction
+OKAY_TEST(virtualTextureIndirectionAfterEvictions)
+{
+	VirtualTextureSystem system;
+	system.initialize(4, 4);
+
+	system.addTexture(8 * VIRTUAL_PAGE_SIZE, 8 * VIRTUAL_PAGE_SIZE);
+	system.addTexture(5 * VIRTUAL_PAGE_SIZE, 3 * VIRTUAL_PAGE_SIZE + 7);
+	system.addTexture(VIRTUAL_PAGE_SIZE, VIRTUAL_PAGE_SIZE);
+
+	TestRandom random(50);
+	uint32_t numEvictions = 0;
+	bool consistent = true;
+
+	for (uint32_t frame = 0; frame < 300; frame++)
+	{
+		std::vector<uint32_t> feedback;
+		for (uint32_t i = 0; i < 1 + random.next(12); i++)
+		{
+			uint32_t textureIdx = random.next(system.getNumTextures());
+			uint32_t mip = random.next(system.getNumMips(textureIdx));
+			glm::uvec2 numPages = system.getNumPages(textureIdx, mip);
+
+			feedback.emplace_back(packVirtualPage(textureIdx, mip, random.next(numPages.x), random.next(numPages.y)));
+		}
+
+		// Entries outside the texture are ignored
+		feedback.emplace_back(packVirtualPage(0, 0, 9, 0));
+		feedback.emplace_back(packVirtualPage(7, 0, 0, 0));
+
+		runFrame(system, feedback, 1 + random.next(4));
+
+		numEvictions += system.getStats().numPageEvictions;
+		consistent &= isIndirectionConsistent(system);
+		consistent &= system.getStats().numResidentPages <= 16;
+	}
+
+	OKAY_CHECK(consistent);
+	OKAY_CHECK(numEvictions > 100);
+}
+
+OKAY_TEST(virtualPageBorderWrapping)
+{
+	// Not square, so the wrapping on each axis uses its own size
+	static const uint32_t WIDTH = 2 * VIRTUAL_PAGE_SIZE;
+	static const uint32_t HEIGHT = VIRTUAL_PAGE_SIZE;
+
+	TestRandom random(3);
+	std::vector<uint8_t> textureData(WIDTH * HEIGHT * 4);
+	for (uint8_t& value : textureData)
+	{
+		value = (uint8_t)random.next(256);
+	}
+
+	TextureMipChain mipChain;
+	generateMipChain(textureData.data(), WIDTH, HEIGHT, TextureMipSettings(), mipChain);
+
+	TextureMipChain compressedChain;
+	compressMipChain(mipChain, OKAY_TEXTURE_FORMAT_BC1, compressedChain);
+
+	std::vector<uint8_t> page(VIRTUAL_PAGE_STRIDE * VIRTUAL_PAGE_STRIDE * 4);
+
+	for (const TextureMipChain* pChain : { &mipChain, &compressedChain })
+	{
+		for (uint32_t mip = 0; mip < getNumVirtualMips(WIDTH, HEIGHT); mip++)
+		{
+			const TextureMipLevel& level = pChain->levels[mip];
+
+			// What the page should be texel for texel, BC levels are compared against the whole level decoded
+			std::vector<uint8_t> levelTexels(level.width * level.height * 4);
+			if (pChain->format == OKAY_TEXTURE_FORMAT_RGBA8)
+			{
+				memcpy(levelTexels.data(), pChain->data.data() + level.offset, levelTexels.size());
+			}
+			else
+			{
+				decompressTextureLevel(pChain->data.data() + level.offset, level.width, level.height, pChain->format, levelTexels.data());
+			}
+
+			for (uint32_t pageY = 0; pageY < getNumVirtualPages(HEIGHT, mip); pageY++)
+			{
+				for (uint32_t pageX = 0; pageX < getNumVirtualPages(WIDTH, mip); pageX++)
+				{
+					copyVirtualPage(*pChain, mip, pageX, pageY, page.data());
+
+					bool wrapped = true;
+					for (uint32_t y = 0; y < VIRTUAL_PAGE_STRIDE; y++)
+					{
+						int32_t srcY = (int32_t)(pageY * VIRTUAL_PAGE_SIZE + y) - (int32_t)VIRTUAL_PAGE_BORDER;
+						srcY = (srcY % (int32_t)level.height + level.height) % level.height;
+
+						for (uint32_t x = 0; x < VIRTUAL_PAGE_STRIDE; x++)
+						{
+							int32_t srcX = (int32_t)(pageX * VIRTUAL_PAGE_SIZE + x) - (int32_t)VIRTUAL_PAGE_BORDER;
+							srcX = (srcX % (int32_t)level.width + level.width) % level.width;
+
+							wrapped &= !memcmp(page.data() + (y * VIRTUAL_PAGE_STRIDE + x) * 4, levelTexels.data() + (srcY * level.width + srcX) * 4, 4);
+						}
+					}
+
+					if (!wrapped)
+					{
+						printf("    Format %u mip %u page %u, %u\n", (uint32_t)pChain->format, mip, pageX, pageY);
+					}
+
+					OKAY_CHECK(wrapped);
+				}
+			}
+		}
+	}
+}
+
+OKAY_BENCHMARK(virtualTexturePageUpdates)
+{
+	static const uint32_t NUM_FRAMES = 200;
+	static const uint32_t FEEDBACK_SIZE = (1920 / 8) * (1080 / 8);
+
+	// 4K slots & 16 textures of 16K, 128x128 pages each in the full size
+	VirtualTextureSystem system;
+	system.initialize(64, 64);
+
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		system.addTexture(128 * VIRTUAL_PAGE_SIZE, 128 * VIRTUAL_PAGE_SIZE);
+	}
+
+	// A camera panning over the textures, nearby pages in detail & the rest further down the chain
+	TestRandom random(4);
+	std::vector<std::vector<uint32_t>> frames(NUM_FRAMES);
+	for (uint32_t frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		frames[frame].resize(FEEDBACK_SIZE);
+		for (uint32_t& entry : frames[frame])
+		{
+			uint32_t textureIdx = random.next(16);
+			uint32_t mip = glm::min(random.next(4) * random.next(3), system.getNumMips(textureIdx) - 1);
+			glm::uvec2 numPages = system.getNumPages(textureIdx, mip);
+
+			uint32_t centerX = (frame / 2 + textureIdx * 7) >> mip;
+			entry = random.next(8) ? packVirtualPage(textureIdx, mip, (centerX + random.next(6)) % numPages.x, random.next(numPages.y / 4 + 1)) : INVALID_UINT32;
+		}
+	}
+
+	VirtualTextureSettings settings;
+	uint64_t numPageLoads = 0;
+
+	uint32_t frameIdx = 0;
+	double ms = measureMs(NUM_FRAMES, [&]()
+	{
+		system.beginFrame();
+		system.processFeedback(frames[frameIdx].data(), frames[frameIdx].size());
+		system.update(settings);
+
+		numPageLoads += system.getStats().numPageLoads;
+		frameIdx++;
+	});
+
+	OKAY_CHECK(isIndirectionConsistent(system));
+
+	printf("    %u feedback entries, %.3f ms per frame, %.1f page loads per frame, %u resident pages\n",
+		FEEDBACK_SIZE, ms, numPageLoads / (double)NUM_FRAMES, system.getStats().numResidentPages);
+
+	// The page copies the loads turn into
+	TextureMipChain mipChain;
+	std::vector<uint8_t> textureData(1024 * 1024 * 4, 0x80);
+	generateMipChain(textureData.data(), 1024, 1024, TextureMipSettings(), mipChain);
+
+	std::vector<uint8_t> page(VIRTUAL_PAGE_STRIDE * VIRTUAL_PAGE_STRIDE * 4);
+	double copyMs = measureMs(1000, [&]()
+	{
+		copyVirtualPage(mipChain, 0, 7, 7, page.data());
+	});
+
+	printf("    RGBA8 page copy with wrapping border: %.2f us\n", copyMs * 1000.0);
+}
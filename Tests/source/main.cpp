@@ -0,0 +1,71 @@
+#include "Tests.h"
+
+#include <cstring>
+
+namespace Okay::Tests
+{
+	static uint32_t s_numFailedChecks = 0;
+
+	std::vector<TestCase>& getTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	void reportFailure(const char* file, int line, const char* expression)
+	{
+		printf("    CHECK FAILED: %s\n    File: %s\n    Line: %d\n", expression, file, line);
+		s_numFailedChecks++;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace Okay::Tests;
+
+	bool runBenchmarks = false;
+	const char* pFilter = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bench") == 0)
+		{
+			runBenchmarks = true;
+		}
+		else
+		{
+			pFilter = argv[i];
+		}
+	}
+
+	uint32_t numRun = 0;
+	uint32_t numFailed = 0;
+
+	for (const TestCase& testCase : getTestCases())
+	{
+		if ((testCase.isBenchmark && !runBenchmarks) || (pFilter && !strstr(testCase.name, pFilter)))
+		{
+			continue;
+		}
+
+		printf("%s %s\n", testCase.isBenchmark ? "[BENCH]" : "[TEST] ", testCase.name);
+
+		uint32_t numFailedChecks = s_numFailedChecks;
+		double durationMs = measureMs(1, testCase.function);
+
+		numRun++;
+		if (s_numFailedChecks != numFailedChecks)
+		{
+			numFailed++;
+			printf("    FAILED (%.1f ms)\n", durationMs);
+		}
+		else if (!testCase.isBenchmark)
+		{
+			printf("    passed (%.1f ms)\n", durationMs);
+		}
+	}
+
+	printf("\n%u / %u passed\n", numRun - numFailed, numRun);
+
+	return (int)numFailed;
+}